@@ -0,0 +1,486 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/aio_context_linux.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/lazy_instance.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop_proxy.h"
+#include "base/stl_util.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Operations a thread may have queued or in flight at once; also the size
+// of each kernel AIO context.  Past this, operations fall back to tasks.
+const int kMaxOperations = 256;
+
+// Completions are read from the kernel up to this many at a time.
+const int kEventsPerReap = 64;
+
+// glibc has no wrappers for the AIO system calls, and libaio is not a
+// dependency.
+int IoSetup(unsigned nr_events, aio_context_t* context) {
+  return syscall(__NR_io_setup, nr_events, context);
+}
+
+int IoDestroy(aio_context_t context) {
+  return syscall(__NR_io_destroy, context);
+}
+
+long IoSubmit(aio_context_t context, long nr, iocb** iocbs) {
+  return syscall(__NR_io_submit, context, nr, iocbs);
+}
+
+long IoGetEvents(aio_context_t context, long min_nr, long nr,
+                 io_event* events, timespec* timeout) {
+  return syscall(__NR_io_getevents, context, min_nr, nr, events, timeout);
+}
+
+LazyInstance<ThreadLocalPointer<AioContext> >::Leaky g_current_context =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Set once io_setup() has failed, so that later operations go straight to
+// tasks.
+subtle::Atomic32 g_aio_unavailable = 0;
+
+// Does the read or write in |cb| the way a FileUtilProxy task does, for an
+// operation that io_submit() rejected.  Returns what a completion would.
+int64 RunSynchronously(const iocb& cb) {
+  char* buffer = reinterpret_cast<char*>(cb.aio_buf);
+  int size = static_cast<int>(cb.aio_nbytes);
+  int result;
+  if (cb.aio_lio_opcode == IOCB_CMD_PREAD)
+    result = ReadPlatformFile(cb.aio_fildes, cb.aio_offset, buffer, size);
+  else
+    result = WritePlatformFile(cb.aio_fildes, cb.aio_offset, buffer, size);
+  return result < 0 ? -errno : result;
+}
+
+}  // namespace
+
+// The state an issuing thread shares with the file threads that submit its
+// batches.  It outlives the AioContext if tasks still refer to it, but after
+// ShutDown() it submits nothing.
+class AioContext::Ring : public RefCountedThreadSafe<AioContext::Ring> {
+ public:
+  // Returns NULL if the kernel context can't be created.
+  static Ring* Create() {
+    aio_context_t id = 0;
+    if (IoSetup(kMaxOperations, &id) != 0) {
+      DPLOG(WARNING) << "io_setup";
+      return NULL;
+    }
+    return new Ring(id);
+  }
+
+  // Adds |cb| to the open batch if it goes to |message_loop_proxy|.
+  bool AppendToOpenBatch(MessageLoopProxy* message_loop_proxy, iocb* cb);
+
+  // Makes |batch| the one that operations are added to.
+  void SetOpenBatch(Batch* batch) {
+    AutoLock auto_lock(lock_);
+    open_batch_ = batch;
+  }
+
+  // Stops adding operations to |batch|.
+  void CloseBatch(Batch* batch) {
+    AutoLock auto_lock(lock_);
+    if (open_batch_ == batch)
+      open_batch_ = NULL;
+  }
+
+  // Runs on the file thread; submits every operation in |batch|, waits for
+  // them to finish, and posts their results back to the issuing thread.
+  void Submit(Batch* batch);
+
+  // Waits for any submission in progress, then destroys the kernel context.
+  void ShutDown();
+
+ private:
+  friend class RefCountedThreadSafe<Ring>;
+
+  explicit Ring(aio_context_t id)
+      : id_(id),
+        submission_done_(&lock_),
+        submitting_(0),
+        shut_down_(false),
+        open_batch_(NULL) {
+  }
+
+  ~Ring() {
+    DCHECK(shut_down_);
+  }
+
+  // Waits until the operations in |pending|, which the calling thread
+  // submitted, have finished, and appends their results to |completions|.
+  // Batches sent to different file threads share the kernel context, so
+  // those threads take turns reading it and hand each other the results
+  // that aren't theirs.
+  void WaitForCompletions(std::set<int64>* pending,
+                          std::vector<Completion>* completions);
+
+  const aio_context_t id_;
+
+  // Held by the file thread that is reading completions from the kernel.
+  Lock reap_lock_;
+
+  // Guards everything below.
+  Lock lock_;
+
+  // Signaled when |submitting_| drops to zero.
+  ConditionVariable submission_done_;
+
+  // Number of file threads inside Submit() with a batch.
+  int submitting_;
+
+  bool shut_down_;
+  Batch* open_batch_;
+
+  // Results read by one file thread for operations another one submitted.
+  std::map<int64, int64> reaped_;
+
+  DISALLOW_COPY_AND_ASSIGN(Ring);
+};
+
+// The operations that one task submits.  Owned by that task.
+class AioContext::Batch {
+ public:
+  Batch(Ring* ring,
+        MessageLoopProxy* message_loop_proxy,
+        MessageLoopProxy* reply_message_loop_proxy)
+      : ring_(ring),
+        message_loop_proxy_(message_loop_proxy),
+        reply_message_loop_proxy_(reply_message_loop_proxy) {
+  }
+
+  // The task may be deleted without running, if the file thread is gone.
+  ~Batch() {
+    ring_->CloseBatch(this);
+  }
+
+  MessageLoopProxy* message_loop_proxy() const {
+    return message_loop_proxy_.get();
+  }
+  MessageLoopProxy* reply_message_loop_proxy() const {
+    return reply_message_loop_proxy_.get();
+  }
+  std::vector<iocb*>* iocbs() { return &iocbs_; }
+
+ private:
+  scoped_refptr<Ring> ring_;
+  scoped_refptr<MessageLoopProxy> message_loop_proxy_;
+  scoped_refptr<MessageLoopProxy> reply_message_loop_proxy_;
+  std::vector<iocb*> iocbs_;
+
+  DISALLOW_COPY_AND_ASSIGN(Batch);
+};
+
+struct AioContext::Operation {
+  Operation() : buffer_size(0) {
+    memset(&cb, 0, sizeof(cb));
+  }
+
+  iocb cb;
+  scoped_array<char> buffer;
+  int buffer_size;
+
+  // Exactly one is set, depending on |cb.aio_lio_opcode|.
+  FileUtilProxy::ReadCallback read_callback;
+  FileUtilProxy::WriteCallback write_callback;
+};
+
+bool AioContext::Ring::AppendToOpenBatch(MessageLoopProxy* message_loop_proxy,
+                                         iocb* cb) {
+  AutoLock auto_lock(lock_);
+  if (!open_batch_ || open_batch_->message_loop_proxy() != message_loop_proxy)
+    return false;
+  open_batch_->iocbs()->push_back(cb);
+  return true;
+}
+
+void AioContext::Ring::Submit(Batch* batch) {
+  {
+    AutoLock auto_lock(lock_);
+    if (open_batch_ == batch)
+      open_batch_ = NULL;
+    if (shut_down_)
+      return;
+    ++submitting_;
+  }
+
+  // Buffered I/O happens inside io_submit(), so this is where the batch
+  // blocks.  It holds no lock meanwhile, so the issuing thread can go on
+  // queuing operations.
+  std::vector<iocb*>& iocbs = *batch->iocbs();
+  std::vector<Completion> completions;
+  std::set<int64> pending;
+  size_t done = 0;
+  while (done < iocbs.size()) {
+    long submitted = IoSubmit(id_, iocbs.size() - done, &iocbs[done]);
+    if (submitted > 0) {
+      for (long i = 0; i < submitted; ++i)
+        pending.insert(iocbs[done + i]->aio_data);
+      done += submitted;
+      continue;
+    }
+    // The first remaining operation was rejected, say because its file
+    // doesn't support AIO or the kernel is out of events.  Do it without AIO,
+    // and carry on with the rest.
+    completions.push_back(
+        Completion(iocbs[done]->aio_data, RunSynchronously(*iocbs[done])));
+    ++done;
+  }
+  WaitForCompletions(&pending, &completions);
+
+  // The reply is posted after the batch has run, like the reply of any other
+  // FileUtilProxy task, so the callbacks stay in order with those replies.
+  std::sort(completions.begin(), completions.end());
+  batch->reply_message_loop_proxy()->PostTask(
+      FROM_HERE,
+      Bind(&AioContext::OnBatchDone, make_scoped_refptr(this), completions));
+
+  AutoLock auto_lock(lock_);
+  if (--submitting_ == 0)
+    submission_done_.Broadcast();
+}
+
+void AioContext::Ring::ShutDown() {
+  {
+    AutoLock auto_lock(lock_);
+    shut_down_ = true;
+    open_batch_ = NULL;
+    while (submitting_)
+      submission_done_.Wait();
+  }
+  if (IoDestroy(id_) != 0)
+    DPLOG(ERROR) << "io_destroy";
+}
+
+void AioContext::Ring::WaitForCompletions(
+    std::set<int64>* pending,
+    std::vector<Completion>* completions) {
+  while (!pending->empty()) {
+    AutoLock reap_lock(reap_lock_);
+    {
+      // Another file thread may have read some of these results already.
+      AutoLock auto_lock(lock_);
+      for (std::set<int64>::iterator it = pending->begin();
+           it != pending->end();) {
+        std::map<int64, int64>::iterator reaped = reaped_.find(*it);
+        if (reaped == reaped_.end()) {
+          ++it;
+          continue;
+        }
+        completions->push_back(*reaped);
+        reaped_.erase(reaped);
+        pending->erase(it++);
+      }
+    }
+    if (pending->empty())
+      break;
+
+    io_event events[kEventsPerReap];
+    long count = IoGetEvents(id_, 1, kEventsPerReap, events, NULL);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      // Without the results, report the operations as failed.
+      int error = errno;
+      DPLOG(ERROR) << "io_getevents";
+      for (std::set<int64>::iterator it = pending->begin();
+           it != pending->end(); ++it) {
+        completions->push_back(Completion(*it, -error));
+      }
+      pending->clear();
+      break;
+    }
+
+    AutoLock auto_lock(lock_);
+    for (long i = 0; i < count; ++i) {
+      int64 sequence = events[i].data;
+      if (pending->erase(sequence))
+        completions->push_back(Completion(sequence, events[i].res));
+      else
+        reaped_[sequence] = events[i].res;
+    }
+  }
+}
+
+AioContext::AioContext(Ring* ring, MessageLoop* message_loop)
+    : ring_(ring),
+      message_loop_(message_loop),
+      next_sequence_(0),
+      last_batched_sequence_(-1) {
+}
+
+AioContext::~AioContext() {
+  STLDeleteValues(&operations_);
+}
+
+// static
+AioContext* AioContext::GetForCurrentThread() {
+  AioContext* context = g_current_context.Get().Get();
+  if (context)
+    return context;
+  if (subtle::NoBarrier_Load(&g_aio_unavailable))
+    return NULL;
+
+  MessageLoop* loop = MessageLoop::current();
+  if (!loop)
+    return NULL;
+
+  Ring* ring = Ring::Create();
+  if (!ring) {
+    subtle::NoBarrier_Store(&g_aio_unavailable, 1);
+    return NULL;
+  }
+  context = new AioContext(ring, loop);
+  loop->AddDestructionObserver(context);
+  g_current_context.Get().Set(context);
+  return context;
+}
+
+// static
+void AioContext::EndBatch() {
+  // Taking a sequence number keeps the next read or write out of the batch.
+  AioContext* context = g_current_context.Get().Get();
+  if (context)
+    context->next_sequence_++;
+}
+
+bool AioContext::Read(
+    const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+    PlatformFile file,
+    int64 offset,
+    int bytes_to_read,
+    const FileUtilProxy::ReadCallback& callback) {
+  if (operations_.size() >= static_cast<size_t>(kMaxOperations))
+    return false;
+
+  Operation* operation = new Operation;
+  operation->buffer.reset(new char[bytes_to_read]);
+  operation->buffer_size = bytes_to_read;
+  operation->read_callback = callback;
+  operation->cb.aio_lio_opcode = IOCB_CMD_PREAD;
+  operation->cb.aio_fildes = file;
+  operation->cb.aio_offset = offset;
+  return Queue(message_loop_proxy, operation);
+}
+
+bool AioContext::Write(
+    const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+    PlatformFile file,
+    int64 offset,
+    const char* buffer,
+    int bytes_to_write,
+    const FileUtilProxy::WriteCallback& callback) {
+  if (operations_.size() >= static_cast<size_t>(kMaxOperations))
+    return false;
+
+  Operation* operation = new Operation;
+  operation->buffer.reset(new char[bytes_to_write]);
+  operation->buffer_size = bytes_to_write;
+  memcpy(operation->buffer.get(), buffer, bytes_to_write);
+  operation->write_callback = callback;
+  operation->cb.aio_lio_opcode = IOCB_CMD_PWRITE;
+  operation->cb.aio_fildes = file;
+  operation->cb.aio_offset = offset;
+  return Queue(message_loop_proxy, operation);
+}
+
+bool AioContext::Queue(
+    const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+    Operation* operation) {
+  int64 sequence = next_sequence_++;
+  iocb* cb = &operation->cb;
+  cb->aio_data = sequence;
+  cb->aio_buf = reinterpret_cast<uintptr_t>(operation->buffer.get());
+  cb->aio_nbytes = operation->buffer_size;
+
+  operations_[sequence] = operation;
+  // If another operation came in between, appending to the open batch would
+  // run this one ahead of it.
+  if (last_batched_sequence_ == sequence - 1 &&
+      ring_->AppendToOpenBatch(message_loop_proxy.get(), cb)) {
+    last_batched_sequence_ = sequence;
+    return true;
+  }
+
+  // The batch is opened before the task is posted, since the task may run,
+  // and delete it, right away.  If posting fails, the batch is deleted with
+  // the task and closes itself.
+  Batch* batch = new Batch(ring_, message_loop_proxy.get(),
+                           message_loop_->message_loop_proxy());
+  batch->iocbs()->push_back(cb);
+  ring_->SetOpenBatch(batch);
+  if (!message_loop_proxy->PostTask(
+          FROM_HERE, Bind(&Ring::Submit, ring_, Owned(batch)))) {
+    operations_.erase(sequence);
+    delete operation;
+    return false;
+  }
+  last_batched_sequence_ = sequence;
+  return true;
+}
+
+void AioContext::WillDestroyCurrentMessageLoop() {
+  // The callbacks of operations still in flight are dropped, like the replies
+  // of tasks posted with PostTaskAndReply() from a thread that has exited.
+  ring_->ShutDown();
+  g_current_context.Get().Set(NULL);
+  delete this;
+}
+
+// static
+void AioContext::OnBatchDone(const scoped_refptr<Ring>& ring,
+                             const std::vector<Completion>& completions) {
+  // The loop may have been replaced since, along with the context.
+  AioContext* context = g_current_context.Get().Get();
+  if (!context || context->ring_ != ring)
+    return;
+
+  OperationMap& operations = context->operations_;
+  for (size_t i = 0; i < completions.size(); ++i) {
+    OperationMap::iterator it = operations.find(completions[i].first);
+    if (it == operations.end()) {
+      NOTREACHED();
+      continue;
+    }
+    scoped_ptr<Operation> operation(it->second);
+    operations.erase(it);
+
+    int64 result = completions[i].second;
+    PlatformFileError error =
+        result < 0 ? PLATFORM_FILE_ERROR_FAILED : PLATFORM_FILE_OK;
+    int bytes = result < 0 ? -1 : static_cast<int>(result);
+    if (operation->cb.aio_lio_opcode == IOCB_CMD_PREAD) {
+      if (!operation->read_callback.is_null())
+        operation->read_callback.Run(error, operation->buffer.get(), bytes);
+    } else {
+      if (!operation->write_callback.is_null())
+        operation->write_callback.Run(error, bytes);
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace base
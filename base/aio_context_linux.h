@@ -0,0 +1,130 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_AIO_CONTEXT_LINUX_H_
+#define BASE_AIO_CONTEXT_LINUX_H_
+#pragma once
+
+#include <linux/aio_abi.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/file_util_proxy.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "base/platform_file.h"
+
+namespace base {
+
+class MessageLoopProxy;
+
+namespace internal {
+
+// AioContext runs FileUtilProxy reads and writes through Linux native AIO,
+// in batches.
+//
+// Reads and writes issued on a thread are queued, and the first one of a
+// batch posts a single task to the file thread.  That task submits the whole
+// batch with one io_submit() call.  For ordinary buffered files the kernel
+// does the I/O inside io_submit(), which is why it still happens on the file
+// thread.  The task then waits for the batch to complete and posts one reply
+// back, which runs the callbacks in the order the operations were issued.  A
+// batch of N operations thus costs one task, one system call and one reply
+// instead of N of each.
+//
+// Every FileUtilProxy operation issued on a thread takes a sequence number
+// from its context, and a read or write only joins the open batch if the
+// operation right before it is in that batch.  So the operations run in order
+// with the other FileUtilProxy operations, as they did when each one was its
+// own task.  Since the reply is posted by the file thread after the batch has
+// run, the callbacks are also in order with the other replies.  Tasks posted
+// to the file thread without FileUtilProxy are not ordered with the reads and
+// writes of a batch posted before them; call EndBatch() first if they touch
+// the same files.
+//
+// An operation that the kernel rejects, say because the file doesn't support
+// AIO, is done with a plain pread() or pwrite() instead, as the task would
+// have.
+//
+// There is one AioContext per thread, used only on that thread.  Threads
+// without a MessageLoop keep the task-per-operation path, as do all threads
+// if the kernel has no AIO.
+class BASE_EXPORT AioContext : public MessageLoop::DestructionObserver {
+ public:
+  // Returns the current thread's context, creating it on first use.  Returns
+  // NULL if the thread doesn't run a MessageLoop or AIO is unavailable.
+  static AioContext* GetForCurrentThread();
+
+  // Ends the current thread's open batch, if any: reads and writes issued
+  // afterwards run after anything posted to the file thread before them.
+  // FileUtilProxy calls it for the operations that don't use AIO.  Cheap when
+  // the thread has no context.
+  static void EndBatch();
+
+  // Queue a read or write of |file| on |message_loop_proxy|'s thread, with
+  // the arguments and results of FileUtilProxy::Read() and Write().  Return
+  // false, without queuing anything, if too many operations are pending.
+  // The caller should then fall back to posting a task.
+  bool Read(const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+            PlatformFile file,
+            int64 offset,
+            int bytes_to_read,
+            const FileUtilProxy::ReadCallback& callback);
+  bool Write(const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+             PlatformFile file,
+             int64 offset,
+             const char* buffer,
+             int bytes_to_write,
+             const FileUtilProxy::WriteCallback& callback);
+
+  // MessageLoop::DestructionObserver implementation.
+  virtual void WillDestroyCurrentMessageLoop() OVERRIDE;
+
+ private:
+  class Batch;
+  class Ring;
+  struct Operation;
+
+  // A (sequence number, result) pair for an operation that has finished.
+  typedef std::pair<int64, int64> Completion;
+  typedef std::map<int64, Operation*> OperationMap;
+
+  AioContext(Ring* ring, MessageLoop* message_loop);
+  virtual ~AioContext();
+
+  // Adds |operation| to the open batch for |message_loop_proxy|, starting a
+  // new batch if needed.  Takes ownership of |operation|.
+  bool Queue(const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+             Operation* operation);
+
+  // The reply of a batch submitted through |ring|.  Runs the callbacks of its
+  // operations, in order, unless the thread's context has gone away since.
+  static void OnBatchDone(const scoped_refptr<Ring>& ring,
+                          const std::vector<Completion>& completions);
+
+  // The part shared with the file threads.
+  scoped_refptr<Ring> ring_;
+
+  MessageLoop* message_loop_;
+
+  // Operations queued or in flight, by sequence number.
+  OperationMap operations_;
+
+  // The sequence number of the next operation, counting the ones that
+  // EndBatch() stands for, and of the last one added to a batch.
+  int64 next_sequence_;
+  int64 last_batched_sequence_;
+
+  DISALLOW_COPY_AND_ASSIGN(AioContext);
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_AIO_CONTEXT_LINUX_H_
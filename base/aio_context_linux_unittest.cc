@@ -0,0 +1,269 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/aio_context_linux.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/file_util_proxy.h"
+#include "base/message_loop.h"
+#include "base/message_loop_proxy.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+void GetContext(AioContext** context) {
+  *context = AioContext::GetForCurrentThread();
+}
+
+class GetContextDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  GetContextDelegate() : context_(reinterpret_cast<AioContext*>(1)) {}
+
+  virtual void Run() OVERRIDE {
+    GetContext(&context_);
+  }
+
+  AioContext* context() const { return context_; }
+
+ private:
+  AioContext* context_;
+};
+
+void TruncateFile(PlatformFile file) {
+  TruncatePlatformFile(file, 0);
+}
+
+class AioContextTest : public testing::Test {
+ public:
+  AioContextTest()
+      : message_loop_(MessageLoop::TYPE_IO),
+        file_thread_("FileThread"),
+        file_(kInvalidPlatformFileValue),
+        pending_(0) {
+  }
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    ASSERT_TRUE(file_thread_.Start());
+    path_ = temp_dir_.path().AppendASCII("test");
+    file_ = CreatePlatformFile(
+        path_,
+        PLATFORM_FILE_CREATE_ALWAYS | PLATFORM_FILE_READ |
+            PLATFORM_FILE_WRITE,
+        NULL, NULL);
+    ASSERT_NE(kInvalidPlatformFileValue, file_);
+  }
+
+  virtual void TearDown() OVERRIDE {
+    ClosePlatformFile(file_);
+  }
+
+  scoped_refptr<MessageLoopProxy> file_proxy() {
+    return file_thread_.message_loop_proxy();
+  }
+
+  // Runs the loop until every callback issued with Expect() has run.
+  void Expect() { ++pending_; }
+  void WaitForCallbacks() {
+    if (pending_)
+      MessageLoop::current()->Run();
+  }
+  void Done() {
+    if (--pending_ == 0)
+      MessageLoop::current()->Quit();
+  }
+
+  void DidRead(int index, PlatformFileError error, const char* data,
+               int bytes) {
+    order_.push_back(index);
+    errors_.push_back(error);
+    reads_.push_back(bytes >= 0 ? std::string(data, bytes) : std::string());
+    Done();
+  }
+
+  void DidWrite(int index, PlatformFileError error, int bytes) {
+    order_.push_back(index);
+    errors_.push_back(error);
+    Done();
+  }
+
+  void DidTruncate(int index, PlatformFileError error) {
+    order_.push_back(index);
+    errors_.push_back(error);
+    Done();
+  }
+
+  bool Write(int index, int64 offset, const std::string& data) {
+    Expect();
+    return FileUtilProxy::Write(
+        file_proxy(), file_, offset, data.data(), data.size(),
+        Bind(&AioContextTest::DidWrite, Unretained(this), index));
+  }
+
+  bool Read(int index, PlatformFile file, int64 offset, int bytes) {
+    Expect();
+    return FileUtilProxy::Read(
+        file_proxy(), file, offset, bytes,
+        Bind(&AioContextTest::DidRead, Unretained(this), index));
+  }
+
+ protected:
+  MessageLoop message_loop_;
+  Thread file_thread_;
+  ScopedTempDir temp_dir_;
+  FilePath path_;
+  PlatformFile file_;
+
+  int pending_;
+  std::vector<int> order_;
+  std::vector<PlatformFileError> errors_;
+  std::vector<std::string> reads_;
+};
+
+}  // namespace
+
+TEST_F(AioContextTest, OnlyOnMessageLoopThreads) {
+  EXPECT_TRUE(AioContext::GetForCurrentThread());
+
+  Thread thread("DefaultThread");
+  ASSERT_TRUE(thread.Start());
+  AioContext* context = NULL;
+  thread.message_loop()->PostTask(FROM_HERE, Bind(&GetContext, &context));
+  thread.Stop();
+  EXPECT_TRUE(context);
+
+  GetContextDelegate delegate;
+  DelegateSimpleThread simple_thread(&delegate, "NoMessageLoop");
+  simple_thread.Start();
+  simple_thread.Join();
+  EXPECT_EQ(NULL, delegate.context());
+}
+
+// Writes and reads issued in one go run, and call back, in order.
+TEST_F(AioContextTest, WriteThenRead) {
+  const int kPieces = 50;
+  for (int i = 0; i < kPieces; ++i)
+    ASSERT_TRUE(Write(i, i * 4, StringPrintf("%04d", i)));
+  for (int i = 0; i < kPieces; ++i)
+    ASSERT_TRUE(Read(kPieces + i, file_, i * 4, 4));
+  WaitForCallbacks();
+
+  ASSERT_EQ(2u * kPieces, order_.size());
+  for (int i = 0; i < 2 * kPieces; ++i) {
+    EXPECT_EQ(i, order_[i]);
+    EXPECT_EQ(PLATFORM_FILE_OK, errors_[i]);
+  }
+  for (int i = 0; i < kPieces; ++i)
+    EXPECT_EQ(StringPrintf("%04d", i), reads_[i]);
+}
+
+// A write issued after another FileUtilProxy operation runs after it, and
+// the callbacks come back in the same order.
+TEST_F(AioContextTest, OrderedWithOtherOperations) {
+  ASSERT_TRUE(Write(0, 0, "first"));
+  Expect();
+  ASSERT_TRUE(FileUtilProxy::Truncate(
+      file_proxy(), file_, 0,
+      Bind(&AioContextTest::DidTruncate, Unretained(this), 1)));
+  ASSERT_TRUE(Write(2, 0, "second"));
+  WaitForCallbacks();
+
+  std::string contents;
+  ASSERT_TRUE(file_util::ReadFileToString(path_, &contents));
+  EXPECT_EQ("second", contents);
+  ASSERT_EQ(3u, order_.size());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(i, order_[i]);
+}
+
+// A write issued after a plain task posted to the file thread runs after it,
+// if the batch was ended before posting the task.
+TEST_F(AioContextTest, OrderedWithPostedTasks) {
+  ASSERT_TRUE(Write(0, 0, "first"));
+  AioContext::EndBatch();
+  file_proxy()->PostTask(FROM_HERE, Bind(&TruncateFile, file_));
+  ASSERT_TRUE(Write(1, 0, "second"));
+  WaitForCallbacks();
+
+  std::string contents;
+  ASSERT_TRUE(file_util::ReadFileToString(path_, &contents));
+  EXPECT_EQ("second", contents);
+}
+
+// Reads at the end of the file return nothing; reads of bad files fail.
+TEST_F(AioContextTest, ShortReadsAndErrors) {
+  ASSERT_TRUE(Write(0, 0, "data"));
+  ASSERT_TRUE(Read(1, file_, 2, 100));
+  ASSERT_TRUE(Read(2, file_, 100, 10));
+  ASSERT_TRUE(Read(3, kInvalidPlatformFileValue, 0, 10));
+  WaitForCallbacks();
+
+  ASSERT_EQ(4u, errors_.size());
+  EXPECT_EQ("ta", reads_[0]);
+  EXPECT_EQ("", reads_[1]);
+  EXPECT_EQ(PLATFORM_FILE_ERROR_FAILED, errors_[3]);
+}
+
+// Reads of files without AIO support, like most of /proc, are done without
+// it and succeed.
+TEST_F(AioContextTest, FileWithoutAio) {
+  PlatformFile file = CreatePlatformFile(
+      FilePath("/proc/self/cmdline"),
+      PLATFORM_FILE_OPEN | PLATFORM_FILE_READ, NULL, NULL);
+  ASSERT_NE(kInvalidPlatformFileValue, file);
+  ASSERT_TRUE(Write(0, 0, "data"));
+  ASSERT_TRUE(Read(1, file, 0, 10));
+  ASSERT_TRUE(Read(2, file_, 0, 4));
+  WaitForCallbacks();
+  ClosePlatformFile(file);
+
+  ASSERT_EQ(3u, order_.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, order_[i]);
+    EXPECT_EQ(PLATFORM_FILE_OK, errors_[i]);
+  }
+  EXPECT_FALSE(reads_[0].empty());
+  EXPECT_EQ("data", reads_[1]);
+}
+
+// More operations than the kernel context holds still complete.
+TEST_F(AioContextTest, ManyOperations) {
+  ASSERT_TRUE(Write(0, 0, std::string(1000, 'x')));
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_TRUE(Read(i + 1, file_, i, 1));
+  WaitForCallbacks();
+
+  ASSERT_EQ(1000u, reads_.size());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ("x", reads_[i]);
+}
+
+// Operations in flight when the thread's loop goes away are dropped safely.
+TEST_F(AioContextTest, LoopDestroyedWithOperationsPending) {
+  const std::string data(4096, 'y');
+  Thread io_thread("IOThread");
+  Thread::Options options(MessageLoop::TYPE_IO, 0);
+  ASSERT_TRUE(io_thread.StartWithOptions(options));
+  for (int i = 0; i < 100; ++i) {
+    io_thread.message_loop()->PostTask(FROM_HERE, Bind(
+        base::IgnoreResult(&FileUtilProxy::Write), file_proxy(), file_,
+        static_cast<int64>(i * 4096), data.data(),
+        static_cast<int>(data.size()), FileUtilProxy::WriteCallback()));
+  }
+  io_thread.Stop();
+}
+
+}  // namespace internal
+}  // namespace base
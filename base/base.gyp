@@ -122,6 +122,7 @@
         'test/run_all_unittests.cc',
 
         # Tests.
+        'aio_context_linux_unittest.cc',
         'android/jni_android_unittest.cc',
         'android/scoped_java_ref_unittest.cc',
         'at_exit_unittest.cc',
@@ -145,8 +146,10 @@
         'environment_unittest.cc',
         'file_descriptor_shuffle_unittest.cc',
         'file_path_unittest.cc',
+        'file_read_recorder_unittest.cc',
         'file_util_unittest.cc',
         'file_version_info_unittest.cc',
+        'flat_hash_tables_unittest.cc',
         'gmock_unittest.cc',
         'id_map_unittest.cc',
         'i18n/break_iterator_unittest.cc',
@@ -158,6 +161,8 @@
         'i18n/rtl_unittest.cc',
         'i18n/string_search_unittest.cc',
         'i18n/time_formatting_unittest.cc',
+        'incoming_task_queue_unittest.cc',
+        'interned_string_unittest.cc',
         'json/json_reader_unittest.cc',
         'json/json_value_converter_unittest.cc',
         'json/json_value_serializer_unittest.cc',
@@ -171,6 +176,7 @@
         'mac/objc_property_releaser_unittest.mm',
         'mac/scoped_sending_event_unittest.mm',
         'md5_unittest.cc',
+        'memory/fixed_size_pool_unittest.cc',
         'memory/linked_ptr_unittest.cc',
         'memory/mru_cache_unittest.cc',
         'memory/ref_counted_memory_unittest.cc',
@@ -187,9 +193,12 @@
         'message_pump_libevent_unittest.cc',
         'metrics/field_trial_unittest.cc',
         'metrics/histogram_unittest.cc',
+        'metrics/shared_histogram_arena_unittest.cc',
         'metrics/stats_table_unittest.cc',
         'observer_list_unittest.cc',
+        'once_closure_unittest.cc',
         'path_service_unittest.cc',
+        'pending_task_unittest.cc',
         'pickle_unittest.cc',
         'platform_file_unittest.cc',
         'pr_time_unittest.cc',
@@ -293,6 +302,11 @@
             'debug/stack_trace_unittest.cc',
           ],
         }],
+        ['os_bsd==1', {
+          'sources!': [
+            'aio_context_linux_unittest.cc',
+          ],
+        }],
         ['use_glib==1', {
           'sources!': [
             'file_version_info_unittest.cc',
@@ -350,6 +364,43 @@
         }],
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'debug/trace_event_perftest.cc',
+        'file_util_proxy_perftest.cc',
+        'flat_hash_tables_perftest.cc',
+        'interned_string_perftest.cc',
+        'json/json_reader_perftest.cc',
+        'json/json_writer_perftest.cc',
+        'memory/fixed_size_pool_perftest.cc',
+        'message_loop_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'observer_list_threadsafe_perftest.cc',
+        'pickle_perftest.cc',
+        'threading/sequenced_worker_pool_perftest.cc',
+        'timer_perftest.cc',
+        'tracked_objects_perftest.cc',
+        'utf_string_conversions_perftest.cc',
+      ],
+      'conditions': [
+        # This is needed to trigger the dll copy step on windows.
+        # TODO(mark): Specifying this here shouldn't be necessary.
+        [ 'OS == "win"', {
+            'dependencies': [
+              '../third_party/icu/icu.gyp:icudata',
+            ],
+          },
+        ],
+      ],
+    },
     {
       'target_name': 'check_example',
       'type': 'executable',
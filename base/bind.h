@@ -11,8 +11,11 @@
 #define BASE_BIND_H_
 #pragma once
 
+#include <new>
+
 #include "base/bind_internal.h"
 #include "base/callback_internal.h"
+#include "base/once_closure.h"
 
 // See base/callback.h for how to use these functions. If reading the
 // implementation, before proceeding further, you should read the top
@@ -502,6 +505,272 @@ Bind(Functor functor, const P1& p1, const P2& p2, const P3& p3, const P4& p4,
           p7));
 }
 
+// BindOnce() binds like Bind(), but returns a OnceClosure, so every argument
+// of the functor must be bound and its result must be void.  The bind state
+// is stored inside the OnceClosure when it fits and all its members can be
+// moved with memcpy; otherwise BindOnce() falls back on Bind().
+
+template <typename Functor>
+OnceClosure BindOnce(Functor functor) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void()>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value) {
+    return OnceClosure(Bind(functor));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor)));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1>
+OnceClosure BindOnce(Functor functor, const P1& p1) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2, typename P3>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2,
+                     const P3& p3) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType,
+          typename internal::CallbackParamTraits<P3>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P3>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2, p3));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2, p3));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2, typename P3, typename P4>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2, const P3& p3,
+                     const P4& p4) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType,
+          typename internal::CallbackParamTraits<P3>::StorageType,
+          typename internal::CallbackParamTraits<P4>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P3>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P4>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2, p3, p4));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2, p3, p4));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2, typename P3, typename P4,
+          typename P5>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2, const P3& p3,
+                     const P4& p4, const P5& p5) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType,
+          typename internal::CallbackParamTraits<P3>::StorageType,
+          typename internal::CallbackParamTraits<P4>::StorageType,
+          typename internal::CallbackParamTraits<P5>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P3>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P4>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P5>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2, p3, p4, p5));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2, p3, p4, p5));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2, typename P3, typename P4,
+          typename P5, typename P6>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2, const P3& p3,
+                     const P4& p4, const P5& p5, const P6& p6) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType,
+          typename internal::CallbackParamTraits<P3>::StorageType,
+          typename internal::CallbackParamTraits<P4>::StorageType,
+          typename internal::CallbackParamTraits<P5>::StorageType,
+          typename internal::CallbackParamTraits<P6>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P3>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P4>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P5>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P6>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2, p3, p4, p5, p6));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2, p3, p4, p5, p6));
+  return closure.Pass();
+}
+
+template <typename Functor, typename P1, typename P2, typename P3, typename P4,
+          typename P5, typename P6, typename P7>
+OnceClosure BindOnce(Functor functor, const P1& p1, const P2& p2, const P3& p3,
+                     const P4& p4, const P5& p5, const P6& p6, const P7& p7) {
+  typedef internal::BindState<
+      typename internal::FunctorTraits<Functor>::RunnableType,
+      typename internal::FunctorTraits<Functor>::RunType,
+      void(typename internal::CallbackParamTraits<P1>::StorageType,
+          typename internal::CallbackParamTraits<P2>::StorageType,
+          typename internal::CallbackParamTraits<P3>::StorageType,
+          typename internal::CallbackParamTraits<P4>::StorageType,
+          typename internal::CallbackParamTraits<P5>::StorageType,
+          typename internal::CallbackParamTraits<P6>::StorageType,
+          typename internal::CallbackParamTraits<P7>::StorageType)>
+      BindState;
+
+  if (sizeof(BindState) > OnceClosure::kInlineStorageSize ||
+      !internal::IsMemcpyMovable<typename BindState::RunnableType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P1>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P2>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P3>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P4>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P5>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P6>::StorageType>::value ||
+      !internal::IsMemcpyMovable<
+          typename internal::CallbackParamTraits<P7>::StorageType>::value) {
+    return OnceClosure(Bind(functor, p1, p2, p3, p4, p5, p6, p7));
+  }
+
+  // Bind() above also checks the arguments, whichever branch is taken.
+  OnceClosure closure;
+  internal::OnceClosureBuilder::SetInlineState(
+      &closure,
+      new (internal::OnceClosureBuilder::GetStorage(&closure)) BindState(
+          internal::MakeRunnable(functor), p1, p2, p3, p4, p5, p6, p7));
+  return closure.Pass();
+}
+
 }  // namespace base
 
 #endif  // BASE_BIND_H_
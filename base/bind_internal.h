@@ -75,6 +75,9 @@ namespace internal {
 //  BindState<> -- Stores the curried parameters, and is the main entry point
 //                 into the Bind() system, doing most of the type resolution.
 //                 There are ARITY BindState types.
+//  IsMemcpyMovable<> -- Type traits that tell BindOnce() whether a BindState
+//                       can be stored inside a OnceClosure.
+//                       There are |O(1)| IsMemcpyMovable types.
 
 // RunnableAdapter<>
 //
@@ -2517,6 +2520,38 @@ struct Invoker<7, StorageType, R(X1, X2, X3, X4, X5, X6, X7)> {
 };
 
 
+// IsMemcpyMovable<>
+//
+// Tells whether a runnable or a bound argument stays valid when its bytes
+// are copied to a new address and the original is dropped without running
+// its destructor.  OnceClosure moves the bind states it stores inline this
+// way, so BindOnce() only stores a BindState inline if all of its members
+// qualify.  Anything that is not a class does: pointers, numbers and enums.
+// So do the classes below, which hold nothing but pointers, and whose
+// references simply move along with them.  Other classes, std::string for
+// instance, might point into themselves and are kept on the heap.
+template <typename T>
+struct IsMemcpyMovable : integral_constant<bool, !is_class<T>::value> {
+};
+
+template <typename T>
+struct IsMemcpyMovable<RunnableAdapter<T> > : true_type {};
+
+template <typename T>
+struct IsMemcpyMovable<UnretainedWrapper<T> > : true_type {};
+
+template <typename T>
+struct IsMemcpyMovable<ConstRefWrapper<T> > : true_type {};
+
+template <typename T>
+struct IsMemcpyMovable<OwnedWrapper<T> > : true_type {};
+
+template <typename T>
+struct IsMemcpyMovable<scoped_refptr<T> > : true_type {};
+
+template <typename T>
+struct IsMemcpyMovable<WeakPtr<T> > : true_type {};
+
 // BindState<>
 //
 // This stores all the state passed into Bind() and is also where most
@@ -37,7 +37,9 @@
 // and thus do not need to be deleted.
 //
 // The reason to pass via a const-reference is to avoid unnecessary
-// AddRef/Release pairs to the internal state.
+// AddRef/Release pairs to the internal state.  For the same reason, code that
+// hands a callback on and no longer needs its own copy (such as a task queue)
+// can Swap() it into place instead of copying it.
 //
 //
 // EXAMPLE USAGE:
@@ -265,6 +267,13 @@ class Callback<R(void)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run() const {
     PolymorphicInvoke f =
         reinterpret_cast<PolymorphicInvoke>(polymorphic_invoke_);
@@ -304,6 +313,13 @@ class Callback<R(A1)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1) const {
     PolymorphicInvoke f =
         reinterpret_cast<PolymorphicInvoke>(polymorphic_invoke_);
@@ -344,6 +360,13 @@ class Callback<R(A1, A2)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2) const {
     PolymorphicInvoke f =
@@ -387,6 +410,13 @@ class Callback<R(A1, A2, A3)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2,
         typename internal::CallbackParamTraits<A3>::ForwardType a3) const {
@@ -433,6 +463,13 @@ class Callback<R(A1, A2, A3, A4)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2,
         typename internal::CallbackParamTraits<A3>::ForwardType a3,
@@ -483,6 +520,13 @@ class Callback<R(A1, A2, A3, A4, A5)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2,
         typename internal::CallbackParamTraits<A3>::ForwardType a3,
@@ -536,6 +580,13 @@ class Callback<R(A1, A2, A3, A4, A5, A6)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2,
         typename internal::CallbackParamTraits<A3>::ForwardType a3,
@@ -592,6 +643,13 @@ class Callback<R(A1, A2, A3, A4, A5, A6, A7)> : public internal::CallbackBase {
     return CallbackBase::Equals(other);
   }
 
+  // Exchanges state with |other|.  Unlike a copy, this does not touch the
+  // reference count of the bound state, so it is the cheap way to move a
+  // callback from one place to another.
+  void Swap(Callback* other) {
+    CallbackBase::Swap(other);
+  }
+
   R Run(typename internal::CallbackParamTraits<A1>::ForwardType a1,
         typename internal::CallbackParamTraits<A2>::ForwardType a2,
         typename internal::CallbackParamTraits<A3>::ForwardType a3,
@@ -4,11 +4,24 @@
 
 #include "base/callback_internal.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 
 namespace base {
 namespace internal {
 
+void BindStateBase::DestroyInPlace() {
+#ifndef NDEBUG
+  // RefCountedThreadSafeBase checks that it is only destroyed by the Release()
+  // of its last reference.  Take and drop one to satisfy it.
+  AddRef();
+  bool last_reference = subtle::RefCountedThreadSafeBase::Release();
+  DCHECK(last_reference);
+#endif
+  this->~BindStateBase();
+}
+
 bool CallbackBase::is_null() const {
   return bind_state_.get() == NULL;
 }
@@ -23,6 +36,11 @@ bool CallbackBase::Equals(const CallbackBase& other) const {
          polymorphic_invoke_ == other.polymorphic_invoke_;
 }
 
+void CallbackBase::Swap(CallbackBase* other) {
+  bind_state_.swap(other->bind_state_);
+  std::swap(polymorphic_invoke_, other->polymorphic_invoke_);
+}
+
 CallbackBase::CallbackBase(BindStateBase* bind_state)
     : bind_state_(bind_state),
       polymorphic_invoke_(NULL) {
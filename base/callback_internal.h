@@ -25,6 +25,12 @@ namespace internal {
 // us to shield the Callback class from the types of the bound argument via
 // "type erasure."
 class BindStateBase : public RefCountedThreadSafe<BindStateBase> {
+ public:
+  // Destroys a bind state that was constructed with placement new in storage
+  // owned by someone else, and never referenced.  Used by OnceClosure for the
+  // bind states it stores inline.
+  void DestroyInPlace();
+
  protected:
   friend class RefCountedThreadSafe<BindStateBase>;
   virtual ~BindStateBase() {}
@@ -50,6 +56,9 @@ class BASE_EXPORT CallbackBase {
   // Returns true if this callback equals |other|. |other| may be null.
   bool Equals(const CallbackBase& other) const;
 
+  // Exchanges the bind state and invoke function with |other|.
+  void Swap(CallbackBase* other);
+
   // Allow initializing of |bind_state_| via the constructor to avoid default
   // initialization of the scoped_refptr.  We do not also initialize
   // |polymorphic_invoke_| here because doing a normal assignment in the
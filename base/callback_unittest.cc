@@ -130,5 +130,20 @@ TEST_F(CallbackTest, Reset) {
   EXPECT_TRUE(callback_a_.Equals(null_callback_));
 }
 
+TEST_F(CallbackTest, Swap) {
+  Callback<void(void)> callback_a2 = callback_a_;
+  Callback<void(void)> callback_b2 = callback_b_;
+
+  callback_a2.Swap(&callback_b2);
+  EXPECT_TRUE(callback_a2.Equals(callback_b_));
+  EXPECT_TRUE(callback_b2.Equals(callback_a_));
+
+  // Swapping with a null callback moves the state out.
+  Callback<void(void)> moved;
+  moved.Swap(&callback_a2);
+  EXPECT_TRUE(callback_a2.is_null());
+  EXPECT_TRUE(moved.Equals(callback_b_));
+}
+
 }  // namespace
 }  // namespace base
@@ -6,12 +6,15 @@
 
 #include <algorithm>
 
+#include "base/atomicops.h"
 #include "base/bind.h"
 #include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "base/format_macros.h"
 #include "base/lazy_instance.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
+#include "base/pickle.h"
 #include "base/process_util.h"
 #include "base/stringprintf.h"
 #include "base/string_tokenizer.h"
@@ -41,6 +44,16 @@ namespace debug {
 // before throwing them away.
 const size_t kTraceEventBufferSize = 500000;
 const size_t kTraceEventBatchSize = 1000;
+// Each thread records into a chunk of this many events, and only synchronizes
+// with other threads when it needs a new chunk.
+const size_t kTraceEventChunkSize = 64;
+
+// Identifies a batch in the OUTPUT_BINARY format, and its version.
+const uint32 kTraceBinaryMagic = 0x54524342;  // "TRCB"
+const int kTraceBinaryVersion = 1;
+
+// Event ids handed out by AddTraceEvent() wrap around within this mask.
+const uint32 kTraceEventIdMask = 0x7fffffff;
 
 #define TRACE_EVENT_MAX_CATEGORIES 100
 
@@ -67,6 +80,14 @@ int g_category_index = 3; // skip initial 3 categories
 LazyInstance<ThreadLocalPointer<const char> >::Leaky
     g_current_thread_name = LAZY_INSTANCE_INITIALIZER;
 
+// Each thread's ThreadLocalEventBuffer. The slot is shared by every TraceLog,
+// since tests delete and resurrect it, and slots are scarce on some platforms.
+ThreadLocalStorage::StaticSlot g_thread_local_event_buffer = TLS_INITIALIZER;
+
+// Bumped when a TraceLog is created or deleted. A buffer belongs to the live
+// TraceLog only if it was made in the current generation.
+subtle::Atomic32 g_trace_log_generation = 0;
+
 void AppendValueAsJSON(unsigned char type,
                        TraceEvent::TraceValue value,
                        std::string* out) {
@@ -111,6 +132,50 @@ void AppendValueAsJSON(unsigned char type,
   }
 }
 
+// Shared by TraceEvent::AppendAsJSON() and the binary format converter, so
+// that both produce identical output.
+void AppendEventAsJSON(const char* category_name,
+                       int process_id,
+                       int thread_id,
+                       int64 timestamp,
+                       char phase,
+                       const char* name,
+                       const char* const* arg_names,
+                       const unsigned char* arg_types,
+                       const TraceEvent::TraceValue* arg_values,
+                       unsigned char flags,
+                       unsigned long long id,
+                       std::string* out) {
+  // Category name checked at category creation time.
+  DCHECK(!strchr(name, '"'));
+  StringAppendF(out,
+      "{\"cat\":\"%s\",\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64 ","
+      "\"ph\":\"%c\",\"name\":\"%s\",\"args\":{",
+      category_name,
+      process_id,
+      thread_id,
+      timestamp,
+      phase,
+      name);
+
+  // Output argument names and values, stop at first NULL argument name.
+  for (int i = 0; i < kTraceMaxNumArgs && arg_names[i]; ++i) {
+    if (i > 0)
+      *out += ",";
+    *out += "\"";
+    *out += arg_names[i];
+    *out += "\":";
+    AppendValueAsJSON(arg_types[i], arg_values[i], out);
+  }
+  *out += "}";
+
+  // If id is set, print it out as a hex string so we don't loose any
+  // bits (it might be a 64-bit pointer).
+  if (flags & TRACE_EVENT_FLAG_HAS_ID)
+    StringAppendF(out, ",\"id\":\"%" PRIx64 "\"", static_cast<uint64>(id));
+  *out += "}";
+}
+
 }  // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -233,36 +298,216 @@ void TraceEvent::AppendEventsAsJSON(const std::vector<TraceEvent>& events,
 }
 
 void TraceEvent::AppendAsJSON(std::string* out) const {
-  int64 time_int64 = timestamp_.ToInternalValue();
-  int process_id = TraceLog::GetInstance()->process_id();
-  // Category name checked at category creation time.
-  DCHECK(!strchr(name_, '"'));
-  StringAppendF(out,
-      "{\"cat\":\"%s\",\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64 ","
-      "\"ph\":\"%c\",\"name\":\"%s\",\"args\":{",
-      TraceLog::GetCategoryName(category_enabled_),
-      process_id,
-      thread_id_,
-      time_int64,
-      phase_,
-      name_);
+  AppendEventAsJSON(TraceLog::GetCategoryName(category_enabled_),
+                    TraceLog::GetInstance()->process_id(),
+                    thread_id_,
+                    timestamp_.ToInternalValue(),
+                    phase_,
+                    name_,
+                    arg_names_,
+                    arg_types_,
+                    arg_values_,
+                    flags_,
+                    id_,
+                    out);
+}
 
-  // Output argument names and values, stop at first NULL argument name.
-  for (int i = 0; i < kTraceMaxNumArgs && arg_names_[i]; ++i) {
-    if (i > 0)
-      *out += ",";
-    *out += "\"";
-    *out += arg_names_[i];
-    *out += "\":";
-    AppendValueAsJSON(arg_types_[i], arg_values_[i], out);
+////////////////////////////////////////////////////////////////////////////////
+//
+// TraceBinaryWriter
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Serializes events into the OUTPUT_BINARY format. A batch is a Pickle holding
+// a header (magic, version, process id) followed by the events, each laid out
+// as:
+//   category, name     string refs
+//   thread id          int
+//   timestamp          int64
+//   phase | flags << 8 | num_args << 16
+//                      int
+//   id                 uint64, only if TRACE_EVENT_FLAG_HAS_ID is set
+//   per argument:      name (string ref), type (int), and either a string ref
+//                      for string types or the raw value as a uint64.
+// A string ref is the index of the string within the batch; the first time a
+// string is referred to, its index is followed by its contents. Nearly all
+// strings are literals, so they are recognized by address and the writer
+// never has to hash or compare their contents.
+class TraceBinaryWriter {
+ public:
+  explicit TraceBinaryWriter(int process_id) {
+    pickle_.WriteUInt32(kTraceBinaryMagic);
+    pickle_.WriteInt(kTraceBinaryVersion);
+    pickle_.WriteInt(process_id);
   }
-  *out += "}";
 
-  // If id_ is set, print it out as a hex string so we don't loose any
-  // bits (it might be a 64-bit pointer).
-  if (flags_ & TRACE_EVENT_FLAG_HAS_ID)
-    StringAppendF(out, ",\"id\":\"%" PRIx64 "\"", static_cast<uint64>(id_));
-  *out += "}";
+  void AppendEvent(const TraceEvent& event) {
+    WriteStringRef(TraceLog::GetCategoryName(event.category_enabled_));
+    WriteStringRef(event.name_);
+    pickle_.WriteInt(event.thread_id_);
+    pickle_.WriteInt64(event.timestamp_.ToInternalValue());
+
+    // Like the JSON output, stop at the first NULL argument name.
+    int num_args = 0;
+    while (num_args < kTraceMaxNumArgs && event.arg_names_[num_args])
+      ++num_args;
+    pickle_.WriteInt(static_cast<unsigned char>(event.phase_) |
+                     event.flags_ << 8 |
+                     num_args << 16);
+    if (event.flags_ & TRACE_EVENT_FLAG_HAS_ID)
+      pickle_.WriteUInt64(event.id_);
+
+    for (int i = 0; i < num_args; ++i) {
+      WriteStringRef(event.arg_names_[i]);
+      pickle_.WriteInt(event.arg_types_[i]);
+      if (event.arg_types_[i] == TRACE_VALUE_TYPE_STRING ||
+          event.arg_types_[i] == TRACE_VALUE_TYPE_COPY_STRING) {
+        const char* str = event.arg_values_[i].as_string;
+        WriteStringRef(str ? str : "NULL");
+      } else {
+        pickle_.WriteUInt64(event.arg_values_[i].as_uint);
+      }
+    }
+  }
+
+  void Finish(std::string* out) {
+    pickle_.Flatten();
+    out->assign(static_cast<const char*>(pickle_.data()), pickle_.size());
+  }
+
+ private:
+  void WriteStringRef(const char* str) {
+    std::pair<base::hash_map<uintptr_t, int>::iterator, bool> result =
+        string_ids_.insert(std::make_pair(reinterpret_cast<uintptr_t>(str),
+                                          static_cast<int>(
+                                              string_ids_.size())));
+    pickle_.WriteInt(result.first->second);
+    if (result.second)
+      pickle_.WriteString(str);
+  }
+
+  Pickle pickle_;
+  base::hash_map<uintptr_t, int> string_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryWriter);
+};
+
+namespace {
+
+// Resolves string ref |index|, which has just been read from |pickle|, reading
+// the string itself if this is its first use. The returned pointer stays
+// valid as long as |strings| does.
+bool ResolveStringRef(const Pickle& pickle,
+                      void** iter,
+                      int index,
+                      std::deque<std::string>* strings,
+                      const char** result) {
+  if (index < 0 || static_cast<size_t>(index) > strings->size())
+    return false;
+  if (static_cast<size_t>(index) == strings->size()) {
+    strings->push_back(std::string());
+    if (!pickle.ReadString(iter, &strings->back()))
+      return false;
+  }
+  *result = (*strings)[index].c_str();
+  return true;
+}
+
+// Reads a string ref written by TraceBinaryWriter::WriteStringRef.
+bool ReadStringRef(const Pickle& pickle,
+                   void** iter,
+                   std::deque<std::string>* strings,
+                   const char** result) {
+  int index;
+  return pickle.ReadInt(iter, &index) &&
+         ResolveStringRef(pickle, iter, index, strings, result);
+}
+
+}  // namespace
+
+// static
+bool TraceLog::ConvertBinaryToJSON(const std::string& binary,
+                                   std::string* json_out) {
+  Pickle pickle(binary.data(), static_cast<int>(binary.size()));
+  if (!pickle.data())
+    return false;
+
+  // The events are converted into |json| and only appended to |json_out| once
+  // the whole batch has been read, so malformed input adds nothing.
+  std::string json;
+  void* iter = NULL;
+  uint32 magic;
+  int version;
+  int process_id;
+  if (!pickle.ReadUInt32(&iter, &magic) || magic != kTraceBinaryMagic ||
+      !pickle.ReadInt(&iter, &version) || version != kTraceBinaryVersion ||
+      !pickle.ReadInt(&iter, &process_id))
+    return false;
+
+  // A deque, so that growing it does not move the strings already read.
+  std::deque<std::string> strings;
+  bool first_event = true;
+  for (;;) {
+    // Running out of data at an event boundary is the normal way to finish.
+    int category_index;
+    if (!pickle.ReadInt(&iter, &category_index)) {
+      json_out->append(json);
+      return true;
+    }
+
+    const char* category_name;
+    const char* name;
+    int thread_id;
+    int64 timestamp;
+    int packed;
+    if (!ResolveStringRef(pickle, &iter, category_index, &strings,
+                          &category_name) ||
+        !ReadStringRef(pickle, &iter, &strings, &name) ||
+        !pickle.ReadInt(&iter, &thread_id) ||
+        !pickle.ReadInt64(&iter, &timestamp) ||
+        !pickle.ReadInt(&iter, &packed))
+      return false;
+    char phase = static_cast<char>(packed & 0xff);
+    unsigned char flags = static_cast<unsigned char>((packed >> 8) & 0xff);
+    int num_args = packed >> 16;
+    if (num_args > kTraceMaxNumArgs || strchr(category_name, '"') ||
+        strchr(name, '"'))
+      return false;
+
+    uint64 id = 0;
+    if ((flags & TRACE_EVENT_FLAG_HAS_ID) && !pickle.ReadUInt64(&iter, &id))
+      return false;
+
+    const char* arg_names[kTraceMaxNumArgs] = { NULL };
+    unsigned char arg_types[kTraceMaxNumArgs] = { 0 };
+    TraceEvent::TraceValue arg_values[kTraceMaxNumArgs];
+    for (int i = 0; i < num_args; ++i) {
+      int type;
+      if (!ReadStringRef(pickle, &iter, &strings, &arg_names[i]) ||
+          !pickle.ReadInt(&iter, &type))
+        return false;
+      if (type < TRACE_VALUE_TYPE_BOOL || type > TRACE_VALUE_TYPE_COPY_STRING)
+        return false;
+      arg_types[i] = static_cast<unsigned char>(type);
+      if (type == TRACE_VALUE_TYPE_STRING ||
+          type == TRACE_VALUE_TYPE_COPY_STRING) {
+        if (!ReadStringRef(pickle, &iter, &strings, &arg_values[i].as_string))
+          return false;
+      } else {
+        uint64 value;
+        if (!pickle.ReadUInt64(&iter, &value))
+          return false;
+        arg_values[i].as_uint = value;
+      }
+    }
+
+    if (!first_event)
+      json += ",";
+    first_event = false;
+    AppendEventAsJSON(category_name, process_id, thread_id, timestamp, phase,
+                      name, arg_names, arg_types, arg_values, flags, id,
+                      &json);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -314,17 +559,156 @@ void TraceResultBuffer::Finish() {
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+struct TraceLog::TraceBufferChunk {
+  TraceBufferChunk() {
+    events.reserve(kTraceEventChunkSize);
+  }
+
+  bool IsFull() const { return events.size() >= kTraceEventChunkSize; }
+
+  std::vector<TraceEvent> events;
+};
+
+class TraceLog::ThreadLocalEventBuffer {
+ public:
+  ThreadLocalEventBuffer(TraceLog* trace_log, int generation, int thread_id)
+      : trace_log_(trace_log),
+        generation_(generation),
+        thread_id_(thread_id),
+        chunk_(NULL),
+        next_event_id_(0),
+        first_unflushed_event_id_(0) {
+  }
+
+  ~ThreadLocalEventBuffer() {
+    delete chunk_;
+  }
+
+  TraceLog* trace_log() const { return trace_log_; }
+  int generation() const { return generation_; }
+  int thread_id() const { return thread_id_; }
+
+  // Only the owning thread records into the buffer, so this lock is
+  // uncontended except while TraceLog is collecting the chunk.
+  Lock* lock() { return &lock_; }
+
+  bool HasRoom() const {
+    lock_.AssertAcquired();
+    return chunk_ && !chunk_->IsFull();
+  }
+
+  // The chunk being filled, or NULL.
+  const TraceBufferChunk* chunk() const {
+    lock_.AssertAcquired();
+    return chunk_;
+  }
+
+  // Appends |event| to the current chunk, which must have room, and returns
+  // the id it was assigned.
+  int AddEvent(const TraceEvent& event) {
+    DCHECK(HasRoom());
+    chunk_->events.push_back(event);
+    int id = static_cast<int>(next_event_id_);
+    next_event_id_ = (next_event_id_ + 1) & kTraceEventIdMask;
+    return id;
+  }
+
+  // Replaces the current chunk with |chunk| and returns the old one. Either
+  // may be NULL.
+  TraceBufferChunk* SwapChunk(TraceBufferChunk* chunk) {
+    lock_.AssertAcquired();
+    std::swap(chunk, chunk_);
+    return chunk;
+  }
+
+  // Records that every event added so far has been flushed.
+  void MarkFlushed() {
+    lock_.AssertAcquired();
+    first_unflushed_event_id_ = next_event_id_;
+  }
+
+  // Decides whether to record the end event of a pair whose begin event was
+  // given |begin_id|. If the pair lasted less than |threshold| microseconds
+  // the begin event is removed, but only while it is still in this thread's
+  // chunk; once handed back to the TraceLog it is too expensive to find, and
+  // the pair is kept.
+  bool ShouldAddThresholdedEndEvent(int begin_id,
+                                    TimeTicks now,
+                                    long long threshold) {
+    lock_.AssertAcquired();
+    // How many events ago, on this thread, the begin event was added.
+    uint32 age = (next_event_id_ - static_cast<uint32>(begin_id)) &
+        kTraceEventIdMask;
+    uint32 unflushed = (next_event_id_ - first_unflushed_event_id_) &
+        kTraceEventIdMask;
+    // Drop the end event if there has been a flush since the begin event was
+    // posted.
+    if (age > unflushed)
+      return false;
+    size_t chunk_size = chunk_ ? chunk_->events.size() : 0;
+    if (age == 0 || age > chunk_size)
+      return true;
+    size_t begin_index = chunk_size - age;
+    TimeDelta elapsed = now - chunk_->events[begin_index].timestamp();
+    if (elapsed >= TimeDelta::FromMicroseconds(threshold))
+      return true;
+
+    // Remove begin event and do not add end event. Events after it keep their
+    // ids, so unless it is the last one it is blanked out rather than erased;
+    // Flush() skips blank events.
+    if (age == 1) {
+      chunk_->events.pop_back();
+      next_event_id_ = (next_event_id_ - 1) & kTraceEventIdMask;
+    } else {
+      chunk_->events[begin_index] = TraceEvent();
+    }
+    return false;
+  }
+
+ private:
+  TraceLog* const trace_log_;
+  const int generation_;
+  const int thread_id_;
+  Lock lock_;
+  TraceBufferChunk* chunk_;
+  // Ids are consecutive per thread, so the events in |chunk_| are the last
+  // |chunk_->events.size()| ids before |next_event_id_|.
+  uint32 next_event_id_;
+  uint32 first_unflushed_event_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocalEventBuffer);
+};
+
 // static
 TraceLog* TraceLog::GetInstance() {
   return Singleton<TraceLog, StaticMemorySingletonTraits<TraceLog> >::get();
 }
 
 TraceLog::TraceLog()
-    : enabled_(false) {
+    : enabled_(false),
+      recording_mode_(RECORD_UNTIL_FULL),
+      output_format_(OUTPUT_JSON),
+      chunks_in_use_(0),
+      max_chunks_(kTraceEventBufferSize / kTraceEventChunkSize),
+      generation_(subtle::NoBarrier_AtomicIncrement(&g_trace_log_generation,
+                                                    1)) {
+  // The singleton makes sure that only one thread gets here.
+  if (!g_thread_local_event_buffer.initialized())
+    g_thread_local_event_buffer.Initialize(&TraceLog::OnThreadExit);
   SetProcessID(static_cast<int>(base::GetCurrentProcId()));
 }
 
 TraceLog::~TraceLog() {
+  // The threads' buffers outlive this TraceLog. From now on they don't call
+  // back into it, and they are deleted when their thread next traces or
+  // exits.
+  AutoLock lock(lock_);
+  subtle::NoBarrier_AtomicIncrement(&g_trace_log_generation, 1);
+  for (size_t i = 0; i < thread_local_event_buffers_.size(); ++i) {
+    AutoLock thread_lock(*thread_local_event_buffers_[i]->lock());
+    delete thread_local_event_buffers_[i]->SwapChunk(NULL);
+  }
+  STLDeleteElements(&logged_chunks_);
 }
 
 const unsigned char* TraceLog::GetCategoryEnabled(const char* name) {
@@ -421,8 +805,7 @@ void TraceLog::SetEnabled(const std::vector<std::string>& included_categories,
   AutoLock lock(lock_);
   if (enabled_)
     return;
-  logged_events_.reserve(1024);
-  enabled_ = true;
+  SetEnabledFlagLocked(true);
   included_categories_ = included_categories;
   excluded_categories_ = excluded_categories;
   // Note that if both included and excluded_categories are empty, the else
@@ -470,7 +853,7 @@ void TraceLog::SetDisabled() {
     if (!enabled_)
       return;
 
-    enabled_ = false;
+    SetEnabledFlagLocked(false);
     included_categories_.clear();
     excluded_categories_.clear();
     for (int i = 0; i < g_category_index; i++)
@@ -489,7 +872,25 @@ void TraceLog::SetEnabled(bool enabled) {
 }
 
 float TraceLog::GetBufferPercentFull() const {
-  return (float)((double)logged_events_.size()/(double)kTraceEventBufferSize);
+  return (float)((double)chunks_in_use_/(double)max_chunks_);
+}
+
+void TraceLog::SetRecordingMode(RecordingMode mode,
+                                size_t buffer_size_in_bytes) {
+  AutoLock lock(lock_);
+  DCHECK(!enabled_);
+  recording_mode_ = mode;
+  if (mode == RECORD_CONTINUOUSLY) {
+    max_chunks_ = std::max<size_t>(
+        1, buffer_size_in_bytes / (kTraceEventChunkSize * sizeof(TraceEvent)));
+  } else {
+    max_chunks_ = kTraceEventBufferSize / kTraceEventChunkSize;
+  }
+}
+
+void TraceLog::SetOutputFormat(OutputFormat format) {
+  AutoLock lock(lock_);
+  output_format_ = format;
 }
 
 void TraceLog::SetOutputCallback(const TraceLog::OutputCallback& cb) {
@@ -503,28 +904,61 @@ void TraceLog::SetBufferFullCallback(const TraceLog::BufferFullCallback& cb) {
 }
 
 void TraceLog::Flush() {
-  std::vector<TraceEvent> previous_logged_events;
+  std::deque<TraceBufferChunk*> previous_logged_chunks;
   OutputCallback output_callback_copy;
+  OutputFormat output_format;
   {
     AutoLock lock(lock_);
-    previous_logged_events.swap(logged_events_);
+    DetachThreadLocalChunksLocked();
+    previous_logged_chunks.swap(logged_chunks_);
+    chunks_in_use_ -= previous_logged_chunks.size();
     output_callback_copy = output_callback_;
+    output_format = output_format_;
   }  // release lock
 
-  if (output_callback_copy.is_null())
-    return;
-
-  for (size_t i = 0;
-       i < previous_logged_events.size();
-       i += kTraceEventBatchSize) {
-    scoped_refptr<RefCountedString> json_events_str_ptr =
-        new RefCountedString();
-    TraceEvent::AppendEventsAsJSON(previous_logged_events,
-                                   i,
-                                   kTraceEventBatchSize,
-                                   &(json_events_str_ptr->data));
-    output_callback_copy.Run(json_events_str_ptr);
+  // Serialize in batches of kTraceEventBatchSize events, without holding any
+  // locks.
+  scoped_refptr<RefCountedString> batch;
+  scoped_ptr<TraceBinaryWriter> binary_writer;
+  size_t batch_count = 0;
+  for (std::deque<TraceBufferChunk*>::const_iterator it =
+           previous_logged_chunks.begin();
+       it != previous_logged_chunks.end() && !output_callback_copy.is_null();
+       ++it) {
+    const std::vector<TraceEvent>& events = (*it)->events;
+    for (size_t i = 0; i < events.size(); ++i) {
+      // Skip events blanked out by a threshold.
+      if (!events[i].name())
+        continue;
+      if (!batch) {
+        batch = new RefCountedString();
+        if (output_format == OUTPUT_BINARY)
+          binary_writer.reset(new TraceBinaryWriter(process_id_));
+      }
+      if (output_format == OUTPUT_BINARY) {
+        binary_writer->AppendEvent(events[i]);
+      } else {
+        if (batch_count > 0)
+          batch->data += ",";
+        events[i].AppendAsJSON(&batch->data);
+      }
+      if (++batch_count == kTraceEventBatchSize) {
+        if (binary_writer.get())
+          binary_writer->Finish(&batch->data);
+        output_callback_copy.Run(batch);
+        batch = NULL;
+        binary_writer.reset();
+        batch_count = 0;
+      }
+    }
+  }
+  if (batch) {
+    if (binary_writer.get())
+      binary_writer->Finish(&batch->data);
+    output_callback_copy.Run(batch);
   }
+
+  STLDeleteElements(&previous_logged_chunks);
 }
 
 int TraceLog::AddTraceEvent(char phase,
@@ -539,77 +973,72 @@ int TraceLog::AddTraceEvent(char phase,
                             long long threshold,
                             unsigned char flags) {
   DCHECK(name);
+  if (!*category_enabled)
+    return -1;
   TimeTicks now = TimeTicks::HighResNow();
-  BufferFullCallback buffer_full_callback_copy;
-  int ret_begin_id = -1;
+
+  ThreadLocalEventBuffer* buffer = GetThreadLocalEventBuffer();
+  int thread_id = buffer->thread_id();
+
+  const char* new_name = PlatformThread::GetName();
+  // Check if the thread name has been set or changed since the previous
+  // call (if any), but don't bother if the new name is empty. Note this will
+  // not detect a thread name change within the same char* buffer address: we
+  // favor common case performance over corner case correctness.
+  if (new_name != g_current_thread_name.Get().Get() &&
+      new_name && *new_name) {
+    g_current_thread_name.Get().Set(new_name);
+    UpdateThreadName(thread_id, new_name);
+  }
+
+  if (flags & TRACE_EVENT_FLAG_MANGLE_ID)
+    id ^= process_id_hash_;
+
+  // Build the event, including any string copies, before taking a lock.
+  TraceEvent event(thread_id,
+                   now, phase, category_enabled, name, id,
+                   num_args, arg_names, arg_types, arg_values,
+                   flags);
+
   {
-    AutoLock lock(lock_);
-    if (!*category_enabled)
-      return -1;
-    if (logged_events_.size() >= kTraceEventBufferSize)
+    AutoLock thread_lock(*buffer->lock());
+    if (!enabled_)
       return -1;
 
-    int thread_id = static_cast<int>(PlatformThread::CurrentId());
-
-    const char* new_name = PlatformThread::GetName();
-    // Check if the thread name has been set or changed since the previous
-    // call (if any), but don't bother if the new name is empty. Note this will
-    // not detect a thread name change within the same char* buffer address: we
-    // favor common case performance over corner case correctness.
-    if (new_name != g_current_thread_name.Get().Get() &&
-        new_name && *new_name) {
-      g_current_thread_name.Get().Set(new_name);
-      base::hash_map<int, std::string>::iterator existing_name =
-          thread_names_.find(thread_id);
-      if (existing_name == thread_names_.end()) {
-        // This is a new thread id, and a new name.
-        thread_names_[thread_id] = new_name;
-      } else {
-        // This is a thread id that we've seen before, but potentially with a
-        // new name.
-        std::vector<base::StringPiece> existing_names;
-        Tokenize(existing_name->second, ",", &existing_names);
-        bool found = std::find(existing_names.begin(),
-                               existing_names.end(),
-                               new_name) != existing_names.end();
-        if (!found) {
-          existing_name->second.push_back(',');
-          existing_name->second.append(new_name);
-        }
-      }
-    }
-
     if (threshold_begin_id > -1) {
       DCHECK(phase == TRACE_EVENT_PHASE_END);
-      size_t begin_i = static_cast<size_t>(threshold_begin_id);
-      // Return now if there has been a flush since the begin event was posted.
-      if (begin_i >= logged_events_.size())
-        return -1;
-      // Determine whether to drop the begin/end pair.
-      TimeDelta elapsed = now - logged_events_[begin_i].timestamp();
-      if (elapsed < TimeDelta::FromMicroseconds(threshold)) {
-        // Remove begin event and do not add end event.
-        // This will be expensive if there have been other events in the
-        // mean time (should be rare).
-        logged_events_.erase(logged_events_.begin() + begin_i);
+      if (!buffer->ShouldAddThresholdedEndEvent(threshold_begin_id, now,
+                                                threshold))
         return -1;
-      }
     }
 
-    if (flags & TRACE_EVENT_FLAG_MANGLE_ID)
-      id ^= process_id_hash_;
+    // This is the common case: the thread's own chunk has room.
+    if (buffer->HasRoom())
+      return buffer->AddEvent(event);
+  }  // release thread lock
 
-    ret_begin_id = static_cast<int>(logged_events_.size());
-    logged_events_.push_back(
-        TraceEvent(thread_id,
-                   now, phase, category_enabled, name, id,
-                   num_args, arg_names, arg_types, arg_values,
-                   flags));
+  // The thread's chunk is full, or it does not have one yet. Hand it back and
+  // get a new one. |lock_| must be taken before the thread's lock.
+  BufferFullCallback buffer_full_callback_copy;
+  int ret_begin_id = -1;
+  {
+    AutoLock lock(lock_);
+    AutoLock thread_lock(*buffer->lock());
+    if (!enabled_)
+      return -1;
 
-    if (logged_events_.size() == kTraceEventBufferSize) {
-      buffer_full_callback_copy = buffer_full_callback_;
+    if (!buffer->HasRoom()) {
+      TraceBufferChunk* full_chunk = buffer->SwapChunk(NULL);
+      if (full_chunk)
+        logged_chunks_.push_back(full_chunk);
+      bool buffer_became_full = false;
+      buffer->SwapChunk(GetNewChunkLocked(&buffer_became_full));
+      if (buffer_became_full)
+        buffer_full_callback_copy = buffer_full_callback_;
     }
-  }  // release lock
+    if (buffer->HasRoom())
+      ret_begin_id = buffer->AddEvent(event);
+  }  // release locks
 
   if (!buffer_full_callback_copy.is_null())
     buffer_full_callback_copy.Run();
@@ -617,6 +1046,114 @@ int TraceLog::AddTraceEvent(char phase,
   return ret_begin_id;
 }
 
+TraceLog::ThreadLocalEventBuffer* TraceLog::GetThreadLocalEventBuffer() {
+  ThreadLocalEventBuffer* buffer =
+      static_cast<ThreadLocalEventBuffer*>(g_thread_local_event_buffer.Get());
+  if (buffer && buffer->generation() != generation_) {
+    // Left over from a TraceLog that was deleted; its chunk is gone.
+    delete buffer;
+    buffer = NULL;
+  }
+  if (!buffer) {
+    buffer = new ThreadLocalEventBuffer(
+        this, generation_, static_cast<int>(PlatformThread::CurrentId()));
+    g_thread_local_event_buffer.Set(buffer);
+    AutoLock lock(lock_);
+    thread_local_event_buffers_.push_back(buffer);
+  }
+  return buffer;
+}
+
+// static
+void TraceLog::OnThreadExit(void* value) {
+  scoped_ptr<ThreadLocalEventBuffer> buffer(
+      static_cast<ThreadLocalEventBuffer*>(value));
+  if (buffer->generation() !=
+      subtle::NoBarrier_Load(&g_trace_log_generation)) {
+    return;
+  }
+  TraceLog* trace_log = buffer->trace_log();
+  AutoLock lock(trace_log->lock_);
+  {
+    AutoLock thread_lock(*buffer->lock());
+    TraceBufferChunk* chunk = buffer->SwapChunk(NULL);
+    if (chunk)
+      trace_log->logged_chunks_.push_back(chunk);
+  }
+  std::vector<ThreadLocalEventBuffer*>& buffers =
+      trace_log->thread_local_event_buffers_;
+  buffers.erase(std::find(buffers.begin(), buffers.end(), buffer.get()));
+}
+
+void TraceLog::SetEnabledFlagLocked(bool enabled) {
+  lock_.AssertAcquired();
+  for (size_t i = 0; i < thread_local_event_buffers_.size(); ++i)
+    thread_local_event_buffers_[i]->lock()->Acquire();
+  enabled_ = enabled;
+  for (size_t i = 0; i < thread_local_event_buffers_.size(); ++i)
+    thread_local_event_buffers_[i]->lock()->Release();
+}
+
+void TraceLog::UpdateThreadName(int thread_id, const char* new_name) {
+  AutoLock lock(lock_);
+  base::hash_map<int, std::string>::iterator existing_name =
+      thread_names_.find(thread_id);
+  if (existing_name == thread_names_.end()) {
+    // This is a new thread id, and a new name.
+    thread_names_[thread_id] = new_name;
+  } else {
+    // This is a thread id that we've seen before, but potentially with a
+    // new name.
+    std::vector<base::StringPiece> existing_names;
+    Tokenize(existing_name->second, ",", &existing_names);
+    bool found = std::find(existing_names.begin(),
+                           existing_names.end(),
+                           new_name) != existing_names.end();
+    if (!found) {
+      existing_name->second.push_back(',');
+      existing_name->second.append(new_name);
+    }
+  }
+}
+
+TraceLog::TraceBufferChunk* TraceLog::GetNewChunkLocked(
+    bool* buffer_became_full) {
+  lock_.AssertAcquired();
+  if (chunks_in_use_ < max_chunks_) {
+    ++chunks_in_use_;
+    if (chunks_in_use_ == max_chunks_ &&
+        recording_mode_ == RECORD_UNTIL_FULL)
+      *buffer_became_full = true;
+    return new TraceBufferChunk;
+  }
+  if (recording_mode_ == RECORD_UNTIL_FULL)
+    return NULL;
+
+  // Recycle the oldest logged chunk. If there is none, every chunk is being
+  // filled by some thread; go over the limit rather than stall a thread.
+  if (logged_chunks_.empty()) {
+    ++chunks_in_use_;
+    return new TraceBufferChunk;
+  }
+  TraceBufferChunk* chunk = logged_chunks_.front();
+  logged_chunks_.pop_front();
+  chunk->events.clear();
+  return chunk;
+}
+
+void TraceLog::DetachThreadLocalChunksLocked() {
+  lock_.AssertAcquired();
+  for (std::vector<ThreadLocalEventBuffer*>::iterator it =
+           thread_local_event_buffers_.begin();
+       it != thread_local_event_buffers_.end(); ++it) {
+    AutoLock thread_lock(*(*it)->lock());
+    TraceBufferChunk* chunk = (*it)->SwapChunk(NULL);
+    if (chunk)
+      logged_chunks_.push_back(chunk);
+    (*it)->MarkFlushed();
+  }
+}
+
 void TraceLog::AddTraceEventEtw(char phase,
                                 const char* name,
                                 const void* id,
@@ -681,6 +1218,7 @@ void TraceLog::AddClockSyncMetadataEvents() {
 
 void TraceLog::AddThreadNameMetadataEvents() {
   lock_.AssertAcquired();
+  TraceBufferChunk* chunk = NULL;
   for(base::hash_map<int, std::string>::iterator it = thread_names_.begin();
       it != thread_names_.end();
       it++) {
@@ -690,7 +1228,13 @@ void TraceLog::AddThreadNameMetadataEvents() {
       unsigned char arg_type;
       unsigned long long arg_value;
       trace_event_internal::SetTraceValue(it->second, &arg_type, &arg_value);
-      logged_events_.push_back(
+      // Metadata is recorded even if the buffer is full.
+      if (!chunk || chunk->IsFull()) {
+        chunk = new TraceBufferChunk;
+        ++chunks_in_use_;
+        logged_chunks_.push_back(chunk);
+      }
+      chunk->events.push_back(
           TraceEvent(it->first,
                      TimeTicks(), TRACE_EVENT_PHASE_METADATA,
                      &g_category_enabled[g_category_metadata],
@@ -701,6 +1245,50 @@ void TraceLog::AddThreadNameMetadataEvents() {
   }
 }
 
+// The events are counted as Flush() would output them: the logged chunks
+// first, then each thread's current chunk.
+size_t TraceLog::GetEventsSize() {
+  AutoLock lock(lock_);
+  size_t size = 0;
+  for (std::deque<TraceBufferChunk*>::const_iterator it =
+           logged_chunks_.begin();
+       it != logged_chunks_.end(); ++it) {
+    size += (*it)->events.size();
+  }
+  for (size_t i = 0; i < thread_local_event_buffers_.size(); ++i) {
+    ThreadLocalEventBuffer* buffer = thread_local_event_buffers_[i];
+    AutoLock thread_lock(*buffer->lock());
+    if (buffer->chunk())
+      size += buffer->chunk()->events.size();
+  }
+  return size;
+}
+
+const TraceEvent& TraceLog::GetEventAt(size_t index) {
+  AutoLock lock(lock_);
+  for (std::deque<TraceBufferChunk*>::const_iterator it =
+           logged_chunks_.begin();
+       it != logged_chunks_.end(); ++it) {
+    if (index < (*it)->events.size())
+      return (*it)->events[index];
+    index -= (*it)->events.size();
+  }
+  // A thread's chunk never reallocates, so the event stays where it is after
+  // the lock is released.
+  for (size_t i = 0; i < thread_local_event_buffers_.size(); ++i) {
+    ThreadLocalEventBuffer* buffer = thread_local_event_buffers_[i];
+    AutoLock thread_lock(*buffer->lock());
+    const TraceBufferChunk* chunk = buffer->chunk();
+    if (!chunk)
+      continue;
+    if (index < chunk->events.size())
+      return chunk->events[index];
+    index -= chunk->events.size();
+  }
+  NOTREACHED();
+  return logged_chunks_.back()->events.back();
+}
+
 void TraceLog::DeleteForTesting() {
   DeleteTraceLogForTesting::Delete();
 }
@@ -9,6 +9,7 @@
 
 #include "build/build_config.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -18,6 +19,7 @@
 #include "base/string_util.h"
 #include "base/synchronization/lock.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
+#include "base/threading/thread_local_storage.h"
 #include "base/timer.h"
 
 // Older style trace macros with explicit id and extra data
@@ -48,6 +50,8 @@ namespace debug {
 
 const int kTraceMaxNumArgs = 2;
 
+class TraceBinaryWriter;
+
 // Output records are "Events" and can be obtained via the
 // OutputCallback whenever the tracing system decides to flush. This
 // can happen at any time, on any thread, or you can programatically
@@ -95,6 +99,8 @@ class BASE_EXPORT TraceEvent {
   const char* name() const { return name_; }
 
  private:
+  friend class TraceBinaryWriter;
+
   // Note: these are ordered by size (largest first) for optimal packing.
   TimeTicks timestamp_;
   // id_ can be used to store phase-specific data.
@@ -157,6 +163,24 @@ class BASE_EXPORT TraceResultBuffer {
 
 class BASE_EXPORT TraceLog {
  public:
+  // What to do once the trace buffer has filled up.
+  enum RecordingMode {
+    // Drop new events and run the buffer-full callback. This is the default.
+    RECORD_UNTIL_FULL,
+    // Overwrite the oldest events, so that the buffer always holds the most
+    // recent ones ("flight recorder" mode).
+    RECORD_CONTINUOUSLY
+  };
+
+  // The format of the strings handed to the OutputCallback.
+  enum OutputFormat {
+    // Comma-separated JSON events, ready for TraceResultBuffer. The default.
+    OUTPUT_JSON,
+    // A compact binary encoding that is much cheaper to produce. Convert it
+    // with ConvertBinaryToJSON(), which does not need the traced process.
+    OUTPUT_BINARY
+  };
+
   static TraceLog* GetInstance();
 
   // Get set of known categories. This can change as new code paths are reached.
@@ -197,6 +221,21 @@ class BASE_EXPORT TraceLog {
 
   float GetBufferPercentFull() const;
 
+  // Sets the recording mode. In RECORD_CONTINUOUSLY mode the buffer is capped
+  // at roughly |buffer_size_in_bytes| of events (not counting copied strings);
+  // the size is ignored in RECORD_UNTIL_FULL mode. Must not be called while
+  // tracing is enabled.
+  void SetRecordingMode(RecordingMode mode, size_t buffer_size_in_bytes);
+
+  // Sets the format used by subsequent flushes.
+  void SetOutputFormat(OutputFormat format);
+
+  // Converts one string produced in OUTPUT_BINARY format into the JSON
+  // fragment that OUTPUT_JSON would have produced for the same events, and
+  // appends it to |json_out|. Returns false if |binary| is malformed.
+  static bool ConvertBinaryToJSON(const std::string& binary,
+                                  std::string* json_out);
+
   // When enough events are collected, they are handed (in bulk) to
   // the output callback. If no callback is set, the output will be
   // silently dropped. The callback must be thread safe. The string format is
@@ -221,8 +260,8 @@ class BASE_EXPORT TraceLog {
   static const char* GetCategoryName(const unsigned char* category_enabled);
 
   // Called by TRACE_EVENT* macros, don't call this directly.
-  // Returns the index in the internal vector of the event if it was added, or
-  //         -1 if the event was not added.
+  // Returns a non-negative id for the event if it was added, or -1 if the
+  // event was not added.
   // On end events, the return value of the begin event can be specified along
   // with a threshold in microseconds. If the elapsed time between begin and end
   // is less than the threshold, the begin/end event pair is dropped.
@@ -258,12 +297,10 @@ class BASE_EXPORT TraceLog {
   // Allows resurrecting our singleton instance post-AtExit processing.
   static void Resurrect();
 
-  // Allow tests to inspect TraceEvents.
-  size_t GetEventsSize() const { return logged_events_.size(); }
-  const TraceEvent& GetEventAt(size_t index) const {
-    DCHECK(index < logged_events_.size());
-    return logged_events_[index];
-  }
+  // Allow tests to inspect TraceEvents. These also see the events still held
+  // by each thread, without taking them from the threads, so they are slow.
+  size_t GetEventsSize();
+  const TraceEvent& GetEventAt(size_t index);
 
   void SetProcessID(int process_id);
 
@@ -272,19 +309,54 @@ class BASE_EXPORT TraceLog {
   // by the Singleton class.
   friend struct StaticMemorySingletonTraits<TraceLog>;
 
+  // A fixed-capacity run of events recorded by a single thread.
+  struct TraceBufferChunk;
+  // The chunk a thread is currently filling, plus the bookkeeping needed to
+  // resolve threshold begin ids.
+  class ThreadLocalEventBuffer;
+
   TraceLog();
   ~TraceLog();
   const unsigned char* GetCategoryEnabledInternal(const char* name);
+  ThreadLocalEventBuffer* GetThreadLocalEventBuffer();
+  // Destructor of the threads' buffers in TLS; logs the exiting thread's
+  // chunk, if the buffer belongs to the current TraceLog, and deletes it.
+  static void OnThreadExit(void* buffer);
+  // Sets |enabled_|. Must be called with |lock_| held.
+  void SetEnabledFlagLocked(bool enabled);
+  void UpdateThreadName(int thread_id, const char* new_name);
+  // Returns a chunk for a thread to fill, or NULL if the buffer is full.
+  // Sets |*buffer_became_full| if this call used up the last free chunk.
+  TraceBufferChunk* GetNewChunkLocked(bool* buffer_became_full);
+  // Moves every thread's partially filled chunk into |logged_chunks_|, and
+  // tells the threads that their earlier events are gone.
+  void DetachThreadLocalChunksLocked();
   void AddThreadNameMetadataEvents();
   void AddClockSyncMetadataEvents();
 
-  // TODO(nduca): switch to per-thread trace buffers to reduce thread
-  // synchronization.
+  // Protects everything below, except that each ThreadLocalEventBuffer has
+  // its own lock for the chunk it is filling. When both are needed, |lock_|
+  // must be taken first.
   Lock lock_;
+  // Written with |lock_| and every thread's lock held, so that AddTraceEvent
+  // can read it with just its own thread's lock.
   bool enabled_;
   OutputCallback output_callback_;
   BufferFullCallback buffer_full_callback_;
-  std::vector<TraceEvent> logged_events_;
+  RecordingMode recording_mode_;
+  OutputFormat output_format_;
+  // Chunks handed back by threads (full ones, or partial ones detached by a
+  // flush), oldest first.
+  std::deque<TraceBufferChunk*> logged_chunks_;
+  // The number of chunks allocated, whether logged or being filled, and the
+  // most that may be.
+  size_t chunks_in_use_;
+  size_t max_chunks_;
+  // One per live thread that has traced, owned by the thread. When a thread
+  // exits, its chunk is logged and its buffer deleted.
+  std::vector<ThreadLocalEventBuffer*> thread_local_event_buffers_;
+  // Tells this TraceLog's buffers from those of one that tests deleted.
+  int generation_;
   std::vector<std::string> included_categories_;
   std::vector<std::string> excluded_categories_;
 
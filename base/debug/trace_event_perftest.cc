@@ -0,0 +1,109 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/debug/trace_event.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+const int kTotalEvents = 400000;
+
+// Waits for |start| and then records |count| trace events.
+class Tracer : public DelegateSimpleThread::Delegate {
+ public:
+  Tracer(int count, WaitableEvent* start) : count_(count), start_(start) {
+  }
+
+  virtual void Run() OVERRIDE {
+    start_->Wait();
+    for (int i = 0; i < count_; ++i) {
+      TRACE_EVENT_INSTANT1("perftest", "event", "i", i);
+    }
+  }
+
+ private:
+  int count_;
+  WaitableEvent* start_;
+};
+
+// Discards flushed trace data, counting how much there was.
+void CountBytes(size_t* total,
+                const scoped_refptr<TraceLog::RefCountedString>& data) {
+  *total += data->data.size();
+}
+
+// Records kTotalEvents events, split evenly across |num_threads| threads, and
+// logs the rate at which they were recorded. Then flushes them in |format| and
+// logs how long that took.
+void RunTraceTest(int num_threads, TraceLog::OutputFormat format,
+                  const char* format_name) {
+  TraceLog* trace_log = TraceLog::GetInstance();
+  size_t flushed_bytes = 0;
+  trace_log->SetOutputCallback(base::Bind(&CountBytes, &flushed_bytes));
+  trace_log->SetOutputFormat(format);
+  trace_log->SetEnabled(true);
+
+  const int events_per_thread = kTotalEvents / num_threads;
+  WaitableEvent start(true, false);
+  ScopedVector<Tracer> tracers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    tracers.push_back(new Tracer(events_per_thread, &start));
+    threads.push_back(new DelegateSimpleThread(tracers[i],
+                                               "TraceEventPerfTest"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  for (int i = 0; i < num_threads; ++i)
+    threads[i]->Join();
+  TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = StringPrintf("TraceEvent_%d_threads", num_threads);
+  LogPerfResult(name.c_str(),
+                events_per_thread * num_threads / elapsed.InSecondsF(),
+                "events/s");
+
+  PerfTimer flush_timer;
+  trace_log->SetEnabled(false);
+  TimeDelta flush_elapsed = flush_timer.Elapsed();
+
+  name = StringPrintf("TraceEvent_Flush_%s", format_name);
+  LogPerfResult(name.c_str(), flush_elapsed.InMillisecondsF(), "ms");
+  name = StringPrintf("TraceEvent_Flush_%s_bytes", format_name);
+  LogPerfResult(name.c_str(),
+                static_cast<double>(flushed_bytes) /
+                    (events_per_thread * num_threads),
+                "bytes/event");
+
+  trace_log->SetOutputCallback(TraceLog::OutputCallback());
+  trace_log->SetOutputFormat(TraceLog::OUTPUT_JSON);
+}
+
+const int kThreadCounts[] = { 1, 2, 4, 8 };
+
+}  // namespace
+
+TEST(TraceEventPerfTest, AddTraceEventJSON) {
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i)
+    RunTraceTest(kThreadCounts[i], TraceLog::OUTPUT_JSON, "JSON");
+}
+
+TEST(TraceEventPerfTest, AddTraceEventBinary) {
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i)
+    RunTraceTest(kThreadCounts[i], TraceLog::OUTPUT_BINARY, "Binary");
+}
+
+}  // namespace debug
+}  // namespace base
@@ -4,6 +4,8 @@
 
 #include "base/debug/trace_event.h"
 
+#include <set>
+
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/json/json_reader.h"
@@ -11,6 +13,7 @@
 #include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
+#include "base/pickle.h"
 #include "base/process_util.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/waitable_event.h"
@@ -43,6 +46,8 @@ class TraceEventTestFixture : public testing::Test {
   void ManualTestSetUp();
   void OnTraceDataCollected(
       const scoped_refptr<TraceLog::RefCountedString>& events_str);
+  void OnBinaryTraceDataCollected(
+      const scoped_refptr<TraceLog::RefCountedString>& events_str);
   DictionaryValue* FindMatchingTraceEntry(const JsonKeyValue* key_values);
   DictionaryValue* FindNamePhase(const char* name, const char* phase);
   DictionaryValue* FindNamePhaseKeyValue(const char* name,
@@ -115,6 +120,15 @@ void TraceEventTestFixture::OnTraceDataCollected(
   }
 }
 
+void TraceEventTestFixture::OnBinaryTraceDataCollected(
+    const scoped_refptr<TraceLog::RefCountedString>& events_str) {
+  scoped_refptr<TraceLog::RefCountedString> json_str =
+      new TraceLog::RefCountedString();
+  ASSERT_TRUE(TraceLog::ConvertBinaryToJSON(events_str->data,
+                                            &json_str->data));
+  OnTraceDataCollected(json_str);
+}
+
 static bool CompareJsonValues(const std::string& lhs,
                               const std::string& rhs,
                               CompareOp op) {
@@ -903,6 +917,19 @@ TEST_F(TraceEventTestFixture, StartFinishPointerMangling) {
   EXPECT_STRNE(start_id_str.c_str(), finish_id_str.c_str());
 }
 
+// Test that looking at the events does not take them from their thread, so
+// that a short thresholded pair is still dropped.
+TEST_F(TraceEventTestFixture, GetEventsLeavesThreadChunk) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetEnabled(true);
+  {
+    TRACE_EVENT_IF_LONGER_THAN0(100000000, "time", "threshold long");
+    EXPECT_GT(TraceLog::GetInstance()->GetEventsSize(), 0u);
+  }
+  TraceLog::GetInstance()->SetEnabled(false);
+  EXPECT_FALSE(FindTraceEntry(trace_parsed_, "threshold long"));
+}
+
 // Test that static strings are not copied.
 TEST_F(TraceEventTestFixture, StaticStringVsString) {
   ManualTestSetUp();
@@ -1115,6 +1142,197 @@ TEST_F(TraceEventTestFixture, ThreadNameChanges) {
   EXPECT_EQ(expected_name, tmp);
 }
 
+// Test that events are gathered from threads whose chunks are partly full,
+// and that events added after tracing is disabled are not recorded.
+TEST_F(TraceEventTestFixture, DataCapturedAcrossChunks) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetEnabled(true);
+
+  // Enough events to fill several chunks, and part of another.
+  const int num_events = 1000;
+  Thread thread("1");
+  WaitableEvent task_complete_event(false, false);
+  thread.Start();
+  thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                            1, num_events, &task_complete_event));
+  task_complete_event.Wait();
+  TraceManyInstantEvents(0, num_events, NULL);
+
+  TraceLog::GetInstance()->SetEnabled(false);
+  TRACE_EVENT_INSTANT0("all", "not recorded; tracing disabled");
+  thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                            1, num_events, &task_complete_event));
+  task_complete_event.Wait();
+  thread.Stop();
+
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_, 2, num_events);
+  EXPECT_FALSE(FindTraceEntry(trace_parsed_, "not recorded"));
+  // Nothing should be left over for the next session.
+  TraceLog::GetInstance()->SetEnabled(true);
+  EXPECT_EQ(0u, TraceLog::GetInstance()->GetEventsSize());
+  TraceLog::GetInstance()->SetEnabled(false);
+}
+
+// Test that threads keep tracing, and exit cleanly, when the TraceLog they
+// traced into is deleted and another one is created.
+TEST_F(TraceEventTestFixture, ThreadsOutliveTraceLog) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetEnabled(true);
+  const int num_events = 10;
+  Thread thread("1");
+  WaitableEvent task_complete_event(false, false);
+  thread.Start();
+  thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                            1, num_events, &task_complete_event));
+  task_complete_event.Wait();
+  TraceManyInstantEvents(0, num_events, NULL);
+
+  // The threads' buffers now belong to a deleted TraceLog.
+  ManualTestSetUp();
+  Clear();
+  TraceLog::GetInstance()->SetEnabled(true);
+  thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                            1, num_events, &task_complete_event));
+  task_complete_event.Wait();
+  TraceManyInstantEvents(0, num_events, NULL);
+  thread.Stop();
+  TraceLog::GetInstance()->SetEnabled(false);
+
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_, 2, num_events);
+  size_t num_found = 0;
+  for (size_t i = 0; i < trace_parsed_.GetSize(); i++) {
+    DictionaryValue* dict = NULL;
+    std::string name;
+    if (trace_parsed_.GetDictionary(i, &dict) &&
+        dict->GetString("name", &name) && name == "multi thread event") {
+      num_found++;
+    }
+  }
+  EXPECT_EQ(2u * num_events, num_found);
+}
+
+// Test that in continuous mode only the most recent events are kept.
+TEST_F(TraceEventTestFixture, RecordContinuously) {
+  ManualTestSetUp();
+  // Room for a few thousand events.
+  TraceLog::GetInstance()->SetRecordingMode(TraceLog::RECORD_CONTINUOUSLY,
+                                            256 * 1024);
+  TraceLog::GetInstance()->SetEnabled(true);
+
+  const int num_events = 100000;
+  TraceManyInstantEvents(0, num_events, NULL);
+
+  TraceLog::GetInstance()->SetEnabled(false);
+
+  std::set<int> events;
+  for (size_t i = 0; i < trace_parsed_.GetSize(); i++) {
+    DictionaryValue* dict = NULL;
+    std::string name;
+    int event = 0;
+    if (trace_parsed_.GetDictionary(i, &dict) &&
+        dict->GetString("name", &name) && name == "multi thread event" &&
+        dict->GetInteger("args.event", &event))
+      events.insert(event);
+  }
+  ASSERT_FALSE(events.empty());
+  EXPECT_LT(events.size(), static_cast<size_t>(num_events));
+  // The newest events must all have been kept.
+  EXPECT_EQ(num_events - 1, *events.rbegin());
+  EXPECT_EQ(events.size() - 1,
+            static_cast<size_t>(*events.rbegin() - *events.begin()));
+}
+
+// Test that the binary output format converts to the same JSON.
+TEST_F(TraceEventTestFixture, BinaryOutput) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetOutputCallback(
+      base::Bind(&TraceEventTestFixture::OnBinaryTraceDataCollected,
+                 base::Unretained(this)));
+  TraceLog::GetInstance()->SetOutputFormat(TraceLog::OUTPUT_BINARY);
+  TraceLog::GetInstance()->SetEnabled(true);
+
+  TraceWithAllMacroVariants(NULL);
+  // More than one batch.
+  const int num_events = 2500;
+  TraceManyInstantEvents(0, num_events, NULL);
+  std::string name("copied name");
+  TRACE_EVENT_COPY_INSTANT1("category", name.c_str(),
+                            "arg", std::string("quoted \"value\""));
+  name[0] = '@';
+
+  TraceLog::GetInstance()->SetEnabled(false);
+
+  ValidateAllTraceMacrosCreatedData(trace_parsed_);
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_, 1, num_events);
+  DictionaryValue* entry = FindTraceEntry(trace_parsed_, "copied name");
+  ASSERT_TRUE(entry);
+  std::string s;
+  EXPECT_TRUE(entry->GetString("args.arg", &s));
+  EXPECT_EQ("quoted \"value\"", s);
+
+  std::string json;
+  EXPECT_FALSE(TraceLog::ConvertBinaryToJSON("not a trace", &json));
+}
+
+// Test that malformed binary output is rejected without emitting any JSON.
+TEST_F(TraceEventTestFixture, BinaryOutputMalformed) {
+  // A batch header, and an event without arguments.
+  Pickle pickle;
+  pickle.WriteUInt32(0x54524342);
+  pickle.WriteInt(1);
+  pickle.WriteInt(1);
+  pickle.WriteInt(0);
+  pickle.WriteString("category");
+  pickle.WriteInt(1);
+  pickle.WriteString("name");
+  pickle.WriteInt(1);
+  pickle.WriteInt64(0);
+  pickle.WriteInt(TRACE_EVENT_PHASE_INSTANT);
+
+  std::string json;
+  EXPECT_TRUE(TraceLog::ConvertBinaryToJSON(
+      std::string(static_cast<const char*>(pickle.data()), pickle.size()),
+      &json));
+  EXPECT_FALSE(json.empty());
+
+  // The same event followed by one that is cut short.
+  Pickle truncated(pickle);
+  truncated.WriteInt(0);
+  truncated.WriteInt(1);
+  json.clear();
+  EXPECT_FALSE(TraceLog::ConvertBinaryToJSON(
+      std::string(static_cast<const char*>(truncated.data()),
+                  truncated.size()),
+      &json));
+  EXPECT_TRUE(json.empty());
+
+  // The same event followed by one with an unknown argument type.
+  Pickle bad_type(pickle);
+  bad_type.WriteInt(0);
+  bad_type.WriteInt(1);
+  bad_type.WriteInt(1);
+  bad_type.WriteInt64(0);
+  bad_type.WriteInt(TRACE_EVENT_PHASE_INSTANT | 1 << 16);
+  bad_type.WriteInt(2);
+  bad_type.WriteString("arg");
+  bad_type.WriteInt(99);
+  bad_type.WriteUInt64(0);
+  EXPECT_FALSE(TraceLog::ConvertBinaryToJSON(
+      std::string(static_cast<const char*>(bad_type.data()), bad_type.size()),
+      &json));
+  EXPECT_TRUE(json.empty());
+
+  // A truncated batch.
+  std::string binary(static_cast<const char*>(pickle.data()), pickle.size());
+  EXPECT_FALSE(TraceLog::ConvertBinaryToJSON(
+      binary.substr(0, binary.size() - 4), &json));
+  EXPECT_TRUE(json.empty());
+}
+
 // Test trace calls made after tracing singleton shut down.
 //
 // The singleton is destroyed by our base::AtExitManager, but there can be
@@ -0,0 +1,103 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/file_read_recorder.h"
+
+#include <algorithm>
+#include <map>
+
+#include "base/atomicops.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+namespace {
+
+// Non-zero while recording.  Checked without the lock, so that reads cost
+// next to nothing when nobody records them.
+subtle::Atomic32 g_recording = 0;
+
+struct RecorderState {
+  Lock lock;
+  FileReadRecorder::Extents extents;
+
+  // The index in |extents| of the last extent of each file.
+  std::map<FilePath, size_t> last_extent;
+};
+
+LazyInstance<RecorderState>::Leaky g_state = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+FileReadRecorder::Extent::Extent() : offset(0), length(0) {
+}
+
+FileReadRecorder::Extent::Extent(const FilePath& path,
+                                 int64 offset,
+                                 int64 length)
+    : path(path),
+      offset(offset),
+      length(length) {
+}
+
+FileReadRecorder::Extent::~Extent() {
+}
+
+// static
+void FileReadRecorder::Start() {
+  RecorderState& state = g_state.Get();
+  AutoLock lock(state.lock);
+  state.extents.clear();
+  state.last_extent.clear();
+  subtle::Release_Store(&g_recording, 1);
+}
+
+// static
+void FileReadRecorder::Stop(Extents* extents) {
+  RecorderState& state = g_state.Get();
+  AutoLock lock(state.lock);
+  subtle::Release_Store(&g_recording, 0);
+  extents->swap(state.extents);
+  state.extents.clear();
+  state.last_extent.clear();
+}
+
+// static
+bool FileReadRecorder::IsRecording() {
+  return subtle::Acquire_Load(&g_recording) != 0;
+}
+
+// static
+void FileReadRecorder::RecordRead(const FilePath& path,
+                                  int64 offset,
+                                  int64 length) {
+  if (!IsRecording() || length <= 0)
+    return;
+
+  RecorderState& state = g_state.Get();
+  AutoLock lock(state.lock);
+  // Recording may have stopped since the check above.
+  if (!subtle::NoBarrier_Load(&g_recording))
+    return;
+
+  std::map<FilePath, size_t>::iterator last = state.last_extent.find(path);
+  if (last != state.last_extent.end()) {
+    Extent& extent = state.extents[last->second];
+    const int64 end = offset + length;
+    const int64 extent_end = extent.offset + extent.length;
+    if (offset <= extent_end && end >= extent.offset) {
+      extent.offset = std::min(extent.offset, offset);
+      extent.length = std::max(extent_end, end) - extent.offset;
+      return;
+    }
+  }
+
+  if (state.extents.size() >= kMaxExtents)
+    return;
+  state.last_extent[path] = state.extents.size();
+  state.extents.push_back(Extent(path, offset, length));
+}
+
+}  // namespace base
@@ -0,0 +1,60 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_FILE_READ_RECORDER_H_
+#define BASE_FILE_READ_RECORDER_H_
+#pragma once
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/file_path.h"
+
+namespace base {
+
+// FileReadRecorder lists the parts of files read while it is recording, in
+// the order they were first read.  Chrome records its startup this way, and
+// prefetches the same parts in the same order on the next start; see
+// chrome/browser/startup_prefetch.h.
+//
+// file_util::ReadFile(), file_util::ReadFileToString(), MemoryMappedFile and
+// sql::Connection report what they read.  Reporting costs an atomic load
+// while nothing is recording.
+class BASE_EXPORT FileReadRecorder {
+ public:
+  // A range of bytes of a file.  Reads that touch or overlap the previous
+  // extent of the same file extend it.
+  struct BASE_EXPORT Extent {
+    Extent();
+    Extent(const FilePath& path, int64 offset, int64 length);
+    ~Extent();
+
+    FilePath path;
+    int64 offset;
+    int64 length;
+  };
+  typedef std::vector<Extent> Extents;
+
+  // Recording stops adding extents after this many, to bound its memory.
+  static const size_t kMaxExtents = 4096;
+
+  // Starts recording, discarding anything recorded before.
+  static void Start();
+
+  // Stops recording and returns the extents recorded, in order.
+  static void Stop(Extents* extents);
+
+  static bool IsRecording();
+
+  // Reports a read of |length| bytes at |offset| into |path|.
+  static void RecordRead(const FilePath& path, int64 offset, int64 length);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(FileReadRecorder);
+};
+
+}  // namespace base
+
+#endif  // BASE_FILE_READ_RECORDER_H_
@@ -0,0 +1,124 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/file_read_recorder.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class FileReadRecorderTest : public testing::Test {
+ protected:
+  virtual void TearDown() {
+    // Leave nothing recording for later tests.
+    FileReadRecorder::Extents unused;
+    FileReadRecorder::Stop(&unused);
+  }
+};
+
+}  // namespace
+
+TEST_F(FileReadRecorderTest, NotRecording) {
+  EXPECT_FALSE(FileReadRecorder::IsRecording());
+  FileReadRecorder::RecordRead(FilePath(FILE_PATH_LITERAL("a")), 0, 10);
+
+  FileReadRecorder::Start();
+  EXPECT_TRUE(FileReadRecorder::IsRecording());
+  FileReadRecorder::Extents extents;
+  FileReadRecorder::Stop(&extents);
+  EXPECT_FALSE(FileReadRecorder::IsRecording());
+  EXPECT_TRUE(extents.empty());
+
+  FileReadRecorder::RecordRead(FilePath(FILE_PATH_LITERAL("a")), 0, 10);
+  FileReadRecorder::Start();
+  FileReadRecorder::Stop(&extents);
+  EXPECT_TRUE(extents.empty());
+}
+
+TEST_F(FileReadRecorderTest, Merge) {
+  const FilePath a(FILE_PATH_LITERAL("a"));
+  const FilePath b(FILE_PATH_LITERAL("b"));
+  FileReadRecorder::Start();
+  FileReadRecorder::RecordRead(a, 0, 100);
+  FileReadRecorder::RecordRead(a, 100, 50);   // Adjacent: extends.
+  FileReadRecorder::RecordRead(a, 120, 10);   // Inside: no change.
+  FileReadRecorder::RecordRead(b, 0, 10);
+  FileReadRecorder::RecordRead(a, 140, 60);   // Overlaps: extends.
+  FileReadRecorder::RecordRead(a, 1000, 10);  // Gap: new extent.
+  FileReadRecorder::RecordRead(b, 5, 0);      // Empty: ignored.
+  FileReadRecorder::Extents extents;
+  FileReadRecorder::Stop(&extents);
+
+  ASSERT_EQ(3u, extents.size());
+  EXPECT_EQ(a.value(), extents[0].path.value());
+  EXPECT_EQ(0, extents[0].offset);
+  EXPECT_EQ(200, extents[0].length);
+  EXPECT_EQ(b.value(), extents[1].path.value());
+  EXPECT_EQ(0, extents[1].offset);
+  EXPECT_EQ(10, extents[1].length);
+  EXPECT_EQ(a.value(), extents[2].path.value());
+  EXPECT_EQ(1000, extents[2].offset);
+  EXPECT_EQ(10, extents[2].length);
+}
+
+TEST_F(FileReadRecorderTest, MaxExtents) {
+  const FilePath a(FILE_PATH_LITERAL("a"));
+  FileReadRecorder::Start();
+  for (size_t i = 0; i < FileReadRecorder::kMaxExtents + 10; ++i)
+    FileReadRecorder::RecordRead(a, i * 10, 5);
+  // The last extent still grows.
+  FileReadRecorder::RecordRead(
+      a, (FileReadRecorder::kMaxExtents - 1) * 10 + 5, 5);
+  FileReadRecorder::Extents extents;
+  FileReadRecorder::Stop(&extents);
+  ASSERT_EQ(FileReadRecorder::kMaxExtents, extents.size());
+  EXPECT_EQ(10, extents.back().length);
+}
+
+TEST_F(FileReadRecorderTest, FileUtilReads) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("file"));
+  const std::string data(1000, 'x');
+  ASSERT_EQ(static_cast<int>(data.size()),
+            file_util::WriteFile(path, data.data(), data.size()));
+
+  FileReadRecorder::Start();
+  char buffer[100];
+  EXPECT_EQ(100, file_util::ReadFile(path, buffer, sizeof(buffer)));
+  FileReadRecorder::Extents extents;
+  FileReadRecorder::Stop(&extents);
+  ASSERT_EQ(1u, extents.size());
+  EXPECT_EQ(path.value(), extents[0].path.value());
+  EXPECT_EQ(100, extents[0].length);
+
+  FileReadRecorder::Start();
+  std::string contents;
+  EXPECT_TRUE(file_util::ReadFileToString(path, &contents));
+  file_util::MemoryMappedFile mapped;
+  EXPECT_TRUE(mapped.Initialize(path));
+  FileReadRecorder::Stop(&extents);
+  ASSERT_EQ(1u, extents.size());
+  EXPECT_EQ(0, extents[0].offset);
+  EXPECT_EQ(1000, extents[0].length);
+
+  // Prefetching isn't a read the program asked for.
+  FileReadRecorder::Start();
+  EXPECT_TRUE(file_util::PrefetchFileRange(path, 0, 1000));
+  EXPECT_TRUE(file_util::PrefetchFileRange(path, 500, 10000));
+  EXPECT_TRUE(file_util::PrefetchFileRange(path, 5000, 10));
+  EXPECT_FALSE(file_util::PrefetchFileRange(
+      temp_dir.path().Append(FILE_PATH_LITERAL("missing")), 0, 10));
+  EXPECT_FALSE(file_util::PrefetchFileRange(temp_dir.path(), 0, 10));
+  FileReadRecorder::Stop(&extents);
+  EXPECT_TRUE(extents.empty());
+}
+
+}  // namespace base
@@ -12,6 +12,7 @@
 #include <fstream>
 
 #include "base/file_path.h"
+#include "base/file_read_recorder.h"
 #include "base/logging.h"
 #include "base/string_piece.h"
 #include "base/string_util.h"
@@ -149,11 +150,14 @@ bool ReadFileToString(const FilePath& path, std::string* contents) {
 
   char buf[1 << 16];
   size_t len;
+  int64 total = 0;
   while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
     if (contents)
       contents->append(buf, len);
+    total += len;
   }
   CloseFile(file);
+  base::FileReadRecorder::RecordRead(path, 0, total);
 
   return true;
 }
@@ -302,51 +306,74 @@ int64 ComputeFilesSize(const FilePath& directory,
 ///////////////////////////////////////////////
 // MemoryMappedFile
 
+// static
+const MemoryMappedFile::Region MemoryMappedFile::kWholeFile = { 0, -1 };
+
 MemoryMappedFile::~MemoryMappedFile() {
   CloseHandles();
 }
 
 bool MemoryMappedFile::Initialize(const FilePath& file_name) {
+  return Initialize(file_name, READ_ONLY);
+}
+
+bool MemoryMappedFile::Initialize(const FilePath& file_name, Access access) {
   if (IsValid())
     return false;
 
-  if (!MapFileToMemory(file_name)) {
+  if (!MapFileToMemory(file_name, access)) {
     CloseHandles();
     return false;
   }
 
+  access_ = access;
+  base::FileReadRecorder::RecordRead(file_name, 0, length_);
   return true;
 }
 
 bool MemoryMappedFile::Initialize(base::PlatformFile file) {
+  return Initialize(file, kWholeFile, READ_ONLY);
+}
+
+bool MemoryMappedFile::Initialize(base::PlatformFile file,
+                                  const Region& region,
+                                  Access access) {
   if (IsValid())
     return false;
 
   file_ = file;
 
-  if (!MapFileToMemoryInternal()) {
+  if (!MapFileToMemoryInternal(region, access)) {
     CloseHandles();
     return false;
   }
 
+  access_ = access;
   return true;
 }
 
+uint8* MemoryMappedFile::writable_data() {
+  DCHECK_EQ(READ_WRITE, access_);
+  return data_;
+}
+
 bool MemoryMappedFile::IsValid() const {
   return data_ != NULL;
 }
 
-bool MemoryMappedFile::MapFileToMemory(const FilePath& file_name) {
-  file_ = base::CreatePlatformFile(
-      file_name, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ,
-      NULL, NULL);
+bool MemoryMappedFile::MapFileToMemory(const FilePath& file_name,
+                                       Access access) {
+  int flags = base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ;
+  if (access == READ_WRITE)
+    flags |= base::PLATFORM_FILE_WRITE;
+  file_ = base::CreatePlatformFile(file_name, flags, NULL, NULL);
 
   if (file_ == base::kInvalidPlatformFileValue) {
     DLOG(ERROR) << "Couldn't open " << file_name.value();
     return false;
   }
 
-  return MapFileToMemoryInternal();
+  return MapFileToMemoryInternal(kWholeFile, access);
 }
 
 // Deprecated functions ----------------------------------------------------
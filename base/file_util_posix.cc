@@ -30,14 +30,18 @@
 #include <glib.h>
 #endif
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 #include "base/basictypes.h"
 #include "base/eintr_wrapper.h"
 #include "base/file_path.h"
+#include "base/file_read_recorder.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
@@ -634,6 +638,7 @@ int ReadFile(const FilePath& filename, char* data, int size) {
   ssize_t bytes_read = HANDLE_EINTR(read(fd, data, size));
   if (int ret = HANDLE_EINTR(close(fd)) < 0)
     return ret;
+  base::FileReadRecorder::RecordRead(filename, 0, bytes_read);
   return bytes_read;
 }
 
@@ -649,6 +654,48 @@ int WriteFile(const FilePath& filename, const char* data, int size) {
   return bytes_written;
 }
 
+bool PrefetchFileRange(const FilePath& path, int64 offset, int64 length) {
+  base::ThreadRestrictions::AssertIOAllowed();
+  // O_NONBLOCK so that a FIFO left where a file was doesn't block us.
+  int fd = HANDLE_EINTR(open(path.value().c_str(), O_RDONLY | O_NONBLOCK));
+  if (fd < 0)
+    return false;
+  file_util::ScopedFD fd_closer(&fd);
+
+  struct stat file_info;
+  if (fstat(fd, &file_info) != 0 || !S_ISREG(file_info.st_mode))
+    return false;
+  const int64 file_size = file_info.st_size;
+  if (offset >= file_size)
+    return true;
+  length = std::min(length, file_size - offset);
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Queues the read and returns.
+  return posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED) == 0;
+#elif defined(OS_MACOSX)
+  struct radvisory advice;
+  advice.ra_offset = offset;
+  advice.ra_count = static_cast<int>(
+      std::min(length, static_cast<int64>(std::numeric_limits<int>::max())));
+  return HANDLE_EINTR(fcntl(fd, F_RDADVISE, &advice)) != -1;
+#else
+  // No way to ask for the read, so do it.
+  const int64 kChunkSize = 64 * 1024;
+  scoped_array<char> buffer(new char[kChunkSize]);
+  while (length > 0) {
+    ssize_t bytes_read = HANDLE_EINTR(pread(fd, buffer.get(),
+                                            std::min(length, kChunkSize),
+                                            offset));
+    if (bytes_read <= 0)
+      return bytes_read == 0;
+    offset += bytes_read;
+    length -= bytes_read;
+  }
+  return true;
+#endif
+}
+
 int WriteFileDescriptor(const int fd, const char* data, int size) {
   // Allow for partial writes.
   ssize_t bytes_written_total = 0;
@@ -840,10 +887,13 @@ bool FileEnumerator::ReadDirectory(std::vector<DirectoryEntryInfo>* entries,
 MemoryMappedFile::MemoryMappedFile()
     : file_(base::kInvalidPlatformFileValue),
       data_(NULL),
-      length_(0) {
+      length_(0),
+      data_offset_(0),
+      access_(READ_ONLY) {
 }
 
-bool MemoryMappedFile::MapFileToMemoryInternal() {
+bool MemoryMappedFile::MapFileToMemoryInternal(const Region& region,
+                                               Access access) {
   base::ThreadRestrictions::AssertIOAllowed();
 
   struct stat file_stat;
@@ -851,29 +901,105 @@ bool MemoryMappedFile::MapFileToMemoryInternal() {
     DLOG(ERROR) << "Couldn't fstat " << file_ << ", errno " << errno;
     return false;
   }
-  length_ = file_stat.st_size;
 
-  data_ = static_cast<uint8*>(
-      mmap(NULL, length_, PROT_READ, MAP_SHARED, file_, 0));
-  if (data_ == MAP_FAILED)
+  int64 offset = 0;
+  int64 size = file_stat.st_size;
+  if (region.size != kWholeFile.size) {
+    if (region.offset < 0 || region.size <= 0 ||
+        region.offset > file_stat.st_size - region.size) {
+      DLOG(ERROR) << "Region " << region.offset << "+" << region.size
+                  << " is outside the file";
+      return false;
+    }
+    offset = region.offset;
+    size = region.size;
+  }
+  if (static_cast<uint64>(size) > std::numeric_limits<size_t>::max() / 2)
+    return false;
+
+  // mmap() needs a page-aligned offset; map from the page that holds
+  // |offset| and skip to it.
+  int64 page_size = getpagesize();
+  int64 aligned_offset = offset - offset % page_size;
+  data_offset_ = static_cast<size_t>(offset - aligned_offset);
+  length_ = static_cast<size_t>(size);
+
+  int prot = access == READ_WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* start = mmap(NULL, data_offset_ + length_, prot, MAP_SHARED, file_,
+                     aligned_offset);
+  if (start == MAP_FAILED) {
     DLOG(ERROR) << "Couldn't mmap " << file_ << ", errno " << errno;
+    length_ = 0;
+    data_offset_ = 0;
+    return false;
+  }
 
-  return data_ != MAP_FAILED;
+  data_ = static_cast<uint8*>(start) + data_offset_;
+  return true;
 }
 
 void MemoryMappedFile::CloseHandles() {
   base::ThreadRestrictions::AssertIOAllowed();
 
   if (data_ != NULL)
-    munmap(data_, length_);
+    munmap(data_ - data_offset_, data_offset_ + length_);
   if (file_ != base::kInvalidPlatformFileValue)
     ignore_result(HANDLE_EINTR(close(file_)));
 
   data_ = NULL;
   length_ = 0;
+  data_offset_ = 0;
+  access_ = READ_ONLY;
   file_ = base::kInvalidPlatformFileValue;
 }
 
+void MemoryMappedFile::SetAccessPattern(AccessPattern pattern) {
+  if (!IsValid())
+    return;
+
+  int advice = MADV_NORMAL;
+  if (pattern == ACCESS_SEQUENTIAL)
+    advice = MADV_SEQUENTIAL;
+  else if (pattern == ACCESS_RANDOM)
+    advice = MADV_RANDOM;
+  if (madvise(data_ - data_offset_, data_offset_ + length_, advice) != 0)
+    DPLOG(ERROR) << "madvise";
+}
+
+void MemoryMappedFile::Prefetch(size_t offset, size_t size) {
+  if (!IsValid() || offset >= length_ || size == 0)
+    return;
+  size = std::min(size, length_ - offset);
+
+  // Widen the range to whole pages.
+  size_t page_size = getpagesize();
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data_ + offset);
+  uintptr_t end = begin + size;
+  begin -= begin % page_size;
+  end += (page_size - end % page_size) % page_size;
+  void* start = reinterpret_cast<void*>(begin);
+  size_t pages = (end - begin) / page_size;
+
+#if defined(OS_MACOSX)
+  std::vector<char> resident(pages);
+#else
+  std::vector<unsigned char> resident(pages);
+#endif
+  if (mincore(start, end - begin, &resident[0]) == 0) {
+    size_t cold_pages = 0;
+    for (size_t i = 0; i < pages; ++i) {
+      if (!(resident[i] & 1))
+        ++cold_pages;
+    }
+    UMA_HISTOGRAM_COUNTS("MemoryMappedFile.PrefetchColdKB",
+                         static_cast<int>(cold_pages * page_size / 1024));
+  }
+
+  // The kernel starts reading the pages in and returns.
+  if (madvise(start, end - begin, MADV_WILLNEED) != 0)
+    DPLOG(ERROR) << "madvise";
+}
+
 bool HasFileBeenModifiedSince(const FileEnumerator::FindInfo& find_info,
                               const base::Time& cutoff_time) {
   return static_cast<time_t>(find_info.stat.st_mtime) >= cutoff_time.ToTimeT();
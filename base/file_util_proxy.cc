@@ -9,6 +9,10 @@
 #include "base/file_util.h"
 #include "base/message_loop_proxy.h"
 
+#if defined(OS_LINUX)
+#include "base/aio_context_linux.h"
+#endif
+
 namespace base {
 
 namespace {
@@ -84,6 +88,19 @@ Closure ReplyHelper(const Callback<void(R)>& callback, OWNED result) {
   return Bind(&ReplyAdapter<R>, callback, result);
 }
 
+// Posts a FileUtilProxy task.  Reads and writes issued afterwards on this
+// thread run after it, even when they are batched (see aio_context_linux.h).
+bool PostFileTaskAndReply(
+    const scoped_refptr<MessageLoopProxy>& message_loop_proxy,
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    const Closure& reply) {
+#if defined(OS_LINUX)
+  internal::AioContext::EndBatch();
+#endif
+  return message_loop_proxy->PostTaskAndReply(from_here, task, reply);
+}
+
 // Putting everything together.
 template <typename R1, typename R2>
 bool PostTaskAndReplyWithStatus(
@@ -92,7 +109,8 @@ bool PostTaskAndReplyWithStatus(
     const Callback<R1(void)>& file_util_work,
     const Callback<void(R2)>& callback,
     R2* result) {
-  return message_loop_proxy->PostTaskAndReply(
+  return PostFileTaskAndReply(
+      message_loop_proxy,
       from_here,
       ReturnAsParam<R1>(file_util_work, result),
       ReplyHelper(callback, Owned(result)));
@@ -318,8 +336,8 @@ bool FileUtilProxy::CreateTemporary(
     int additional_file_flags,
     const CreateTemporaryCallback& callback) {
   CreateTemporaryHelper* helper = new CreateTemporaryHelper(message_loop_proxy);
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&CreateTemporaryHelper::RunWork, Unretained(helper),
              additional_file_flags),
         Bind(&CreateTemporaryHelper::Reply, Owned(helper), callback));
@@ -343,8 +361,8 @@ bool FileUtilProxy::GetFileInfo(
     const FilePath& file_path,
     const GetFileInfoCallback& callback) {
   GetFileInfoHelper* helper = new GetFileInfoHelper;
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&GetFileInfoHelper::RunWorkForFilePath,
              Unretained(helper), file_path),
         Bind(&GetFileInfoHelper::Reply, Owned(helper), callback));
@@ -356,8 +374,8 @@ bool FileUtilProxy::GetFileInfoFromPlatformFile(
     PlatformFile file,
     const GetFileInfoCallback& callback) {
   GetFileInfoHelper* helper = new GetFileInfoHelper;
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&GetFileInfoHelper::RunWorkForPlatformFile,
              Unretained(helper), file),
         Bind(&GetFileInfoHelper::Reply, Owned(helper), callback));
@@ -395,9 +413,17 @@ bool FileUtilProxy::Read(
   if (bytes_to_read < 0) {
     return false;
   }
+#if defined(OS_LINUX)
+  internal::AioContext* aio_context =
+      internal::AioContext::GetForCurrentThread();
+  if (aio_context && aio_context->Read(message_loop_proxy, file, offset,
+                                       bytes_to_read, callback)) {
+    return true;
+  }
+#endif
   ReadHelper* helper = new ReadHelper(bytes_to_read);
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&ReadHelper::RunWork, Unretained(helper), file, offset),
         Bind(&ReadHelper::Reply, Owned(helper), callback));
 }
@@ -413,9 +439,17 @@ bool FileUtilProxy::Write(
   if (bytes_to_write <= 0 || buffer == NULL) {
     return false;
   }
+#if defined(OS_LINUX)
+  internal::AioContext* aio_context =
+      internal::AioContext::GetForCurrentThread();
+  if (aio_context && aio_context->Write(message_loop_proxy, file, offset,
+                                        buffer, bytes_to_write, callback)) {
+    return true;
+  }
+#endif
   WriteHelper* helper = new WriteHelper(buffer, bytes_to_write);
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&WriteHelper::RunWork, Unretained(helper), file, offset),
         Bind(&WriteHelper::Reply, Owned(helper), callback));
 }
@@ -479,8 +513,8 @@ bool FileUtilProxy::RelayFileTask(
     const FileTask& file_task,
     const StatusCallback& callback) {
   PlatformFileError* result = new PlatformFileError;
-  return message_loop_proxy->PostTaskAndReply(
-      from_here,
+  return PostFileTaskAndReply(
+      message_loop_proxy, from_here,
       ReturnAsParam(file_task, result),
       ReplyHelper(callback, Owned(result)));
 }
@@ -493,8 +527,8 @@ bool FileUtilProxy::RelayCreateOrOpen(
     const CreateOrOpenCallback& callback) {
   CreateOrOpenHelper* helper = new CreateOrOpenHelper(
       message_loop_proxy, close_task);
-  return message_loop_proxy->PostTaskAndReply(
-        FROM_HERE,
+  return PostFileTaskAndReply(
+        message_loop_proxy, FROM_HERE,
         Bind(&CreateOrOpenHelper::RunWork, Unretained(helper), open_task),
         Bind(&CreateOrOpenHelper::Reply, Owned(helper), callback));
 }
@@ -506,8 +540,8 @@ bool FileUtilProxy::RelayClose(
     PlatformFile file_handle,
     const StatusCallback& callback) {
   PlatformFileError* result = new PlatformFileError;
-  return message_loop_proxy->PostTaskAndReply(
-      FROM_HERE,
+  return PostFileTaskAndReply(
+      message_loop_proxy, FROM_HERE,
       ReturnAsParam(close_task, file_handle, result),
       ReplyHelper(callback, Owned(result)));
 }
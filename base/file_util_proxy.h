@@ -21,6 +21,11 @@ class MessageLoopProxy;
 class Time;
 
 // This class provides asynchronous access to common file routines.
+//
+// On Linux, reads and writes issued from a thread running a MessageLoop are
+// submitted in batches through native AIO; see aio_context_linux.h.  They
+// still run on |message_loop_proxy|'s thread, and call back, in order with
+// the other FileUtilProxy operations issued from the same thread.
 class BASE_EXPORT FileUtilProxy {
  public:
   // Holds metadata for file or directory entry.
@@ -0,0 +1,115 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/file_util_proxy.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kFiles = 500;
+const int kFileSize = 4096;
+
+// Reads each file kept open by the test this many at a time, like a cache
+// or the file system API serving many small files.
+const int kConcurrentReads = 32;
+
+class SmallFileReader {
+ public:
+  SmallFileReader(const std::vector<PlatformFile>& files,
+                  scoped_refptr<MessageLoopProxy> file_proxy)
+      : files_(files),
+        file_proxy_(file_proxy),
+        next_(0),
+        outstanding_(0),
+        bytes_read_(0) {
+  }
+
+  // Reads every file once and returns the bytes read.
+  int64 Run() {
+    for (int i = 0; i < kConcurrentReads; ++i)
+      ReadNext();
+    MessageLoop::current()->Run();
+    return bytes_read_;
+  }
+
+ private:
+  void ReadNext() {
+    if (next_ == files_.size())
+      return;
+    ++outstanding_;
+    FileUtilProxy::Read(
+        file_proxy_, files_[next_++], 0, kFileSize,
+        Bind(&SmallFileReader::DidRead, Unretained(this)));
+  }
+
+  void DidRead(PlatformFileError error, const char* data, int bytes) {
+    EXPECT_EQ(PLATFORM_FILE_OK, error);
+    bytes_read_ += bytes;
+    --outstanding_;
+    ReadNext();
+    if (!outstanding_)
+      MessageLoop::current()->Quit();
+  }
+
+  const std::vector<PlatformFile>& files_;
+  scoped_refptr<MessageLoopProxy> file_proxy_;
+  size_t next_;
+  int outstanding_;
+  int64 bytes_read_;
+};
+
+// Reads |files| from a thread running a |type| loop and logs the time per
+// file.  Only TYPE_IO threads batch reads through AIO.
+void RunReadTest(const std::vector<PlatformFile>& files,
+                 MessageLoop::Type type,
+                 const char* name) {
+  MessageLoop loop(type);
+  Thread file_thread("FileThread");
+  ASSERT_TRUE(file_thread.Start());
+
+  SmallFileReader reader(files, file_thread.message_loop_proxy());
+  PerfTimer timer;
+  EXPECT_EQ(static_cast<int64>(kFiles) * kFileSize, reader.Run());
+  LogPerfResult(name, timer.Elapsed().InMicroseconds() * 1.0 / kFiles,
+                "us/file");
+}
+
+}  // namespace
+
+TEST(FileUtilProxyPerfTest, ReadSmallFiles) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const std::string data(kFileSize, 'x');
+  std::vector<PlatformFile> files;
+  for (int i = 0; i < kFiles; ++i) {
+    FilePath path = temp_dir.path().AppendASCII(StringPrintf("file%d", i));
+    ASSERT_EQ(kFileSize,
+              file_util::WriteFile(path, data.data(), data.size()));
+    files.push_back(CreatePlatformFile(
+        path, PLATFORM_FILE_OPEN | PLATFORM_FILE_READ, NULL, NULL));
+    ASSERT_NE(kInvalidPlatformFileValue, files.back());
+  }
+
+  // Warm the page cache, so both runs read from memory.
+  RunReadTest(files, MessageLoop::TYPE_DEFAULT, "FileUtilProxy_Warmup");
+  RunReadTest(files, MessageLoop::TYPE_DEFAULT, "FileUtilProxy_Read_Tasks");
+  RunReadTest(files, MessageLoop::TYPE_IO, "FileUtilProxy_Read_Batched");
+
+  for (size_t i = 0; i < files.size(); ++i)
+    ClosePlatformFile(files[i]);
+}
+
+}  // namespace base
@@ -1922,6 +1922,76 @@ TEST_F(FileUtilTest, IsDirectoryEmpty) {
   EXPECT_FALSE(file_util::IsDirectoryEmpty(empty_dir));
 }
 
+// Writes a file of |size| bytes whose byte i is (i % 251).
+FilePath WritePatternFile(const FilePath& dir, int size) {
+  std::string data(size, 0);
+  for (int i = 0; i < size; ++i)
+    data[i] = static_cast<char>(i % 251);
+  FilePath path(dir.Append(FILE_PATH_LITERAL("pattern")));
+  EXPECT_EQ(size, file_util::WriteFile(path, data.data(), size));
+  return path;
+}
+
+TEST_F(FileUtilTest, MemoryMappedFileRegion) {
+  const int kSize = 3 * 65536 + 123;
+  FilePath path = WritePatternFile(temp_dir_.path(), kSize);
+
+  // A region that starts and ends off any page boundary.
+  const file_util::MemoryMappedFile::Region region = { 65536 + 4000, 70000 };
+  file_util::MemoryMappedFile map;
+  ASSERT_TRUE(map.Initialize(
+      base::CreatePlatformFile(
+          path, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ,
+          NULL, NULL),
+      region, file_util::MemoryMappedFile::READ_ONLY));
+  ASSERT_EQ(70000u, map.length());
+  for (int i = 0; i < 70000; ++i)
+    ASSERT_EQ((65536 + 4000 + i) % 251, map.data()[i]);
+
+  // Regions past the end of the file are rejected.
+  const file_util::MemoryMappedFile::Region past_end = { kSize - 10, 11 };
+  file_util::MemoryMappedFile bad_map;
+  EXPECT_FALSE(bad_map.Initialize(
+      base::CreatePlatformFile(
+          path, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ,
+          NULL, NULL),
+      past_end, file_util::MemoryMappedFile::READ_ONLY));
+  EXPECT_FALSE(bad_map.IsValid());
+}
+
+TEST_F(FileUtilTest, MemoryMappedFileReadWrite) {
+  FilePath path = WritePatternFile(temp_dir_.path(), 10000);
+  {
+    file_util::MemoryMappedFile map;
+    ASSERT_TRUE(map.Initialize(path,
+                               file_util::MemoryMappedFile::READ_WRITE));
+    ASSERT_EQ(10000u, map.length());
+    memcpy(map.writable_data() + 5000, "hello", 5);
+  }
+
+  std::string contents;
+  ASSERT_TRUE(file_util::ReadFileToString(path, &contents));
+  ASSERT_EQ(10000u, contents.size());
+  EXPECT_EQ("hello", contents.substr(5000, 5));
+  EXPECT_EQ(static_cast<char>(5005 % 251), contents[5005]);
+}
+
+TEST_F(FileUtilTest, MemoryMappedFileHints) {
+  const int kSize = 100000;
+  FilePath path = WritePatternFile(temp_dir_.path(), kSize);
+  file_util::MemoryMappedFile map;
+  ASSERT_TRUE(map.Initialize(path));
+
+  map.SetAccessPattern(file_util::MemoryMappedFile::ACCESS_SEQUENTIAL);
+  map.Prefetch(0, kSize);
+  map.Prefetch(kSize - 1, 1000);  // Clipped to the mapping.
+  map.Prefetch(kSize, 1000);  // Ignored.
+  map.Prefetch(0, 0);  // Ignored.
+  map.SetAccessPattern(file_util::MemoryMappedFile::ACCESS_RANDOM);
+  for (int i = 0; i < kSize; i += 997)
+    ASSERT_EQ(i % 251, map.data()[i]);
+}
+
 #if defined(OS_POSIX)
 
 // Testing VerifyPathControlledByAdmin() is hard, because there is no
@@ -11,11 +11,14 @@
 #include <shlobj.h>
 #include <time.h>
 
+#include <algorithm>
 #include <limits>
 #include <string>
 
 #include "base/file_path.h"
+#include "base/file_read_recorder.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
@@ -716,11 +719,46 @@ int ReadFile(const FilePath& filename, char* data, int size) {
 
   DWORD read;
   if (::ReadFile(file, data, size, &read, NULL) &&
-      static_cast<int>(read) == size)
+      static_cast<int>(read) == size) {
+    base::FileReadRecorder::RecordRead(filename, 0, read);
     return read;
+  }
   return -1;
 }
 
+bool PrefetchFileRange(const FilePath& path, int64 offset, int64 length) {
+  base::ThreadRestrictions::AssertIOAllowed();
+  base::win::ScopedHandle file(CreateFile(path.value().c_str(),
+                                          GENERIC_READ,
+                                          FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                          NULL,
+                                          OPEN_EXISTING,
+                                          FILE_FLAG_SEQUENTIAL_SCAN,
+                                          NULL));
+  if (!file || GetFileType(file) != FILE_TYPE_DISK)
+    return false;
+
+  LARGE_INTEGER position;
+  position.QuadPart = offset;
+  if (!SetFilePointerEx(file, position, NULL, FILE_BEGIN))
+    return false;
+
+  // Windows has no call that only asks for the read, so do it.
+  const DWORD kChunkSize = 64 * 1024;
+  scoped_array<char> buffer(new char[kChunkSize]);
+  while (length > 0) {
+    DWORD read;
+    DWORD to_read = static_cast<DWORD>(
+        std::min(length, static_cast<int64>(kChunkSize)));
+    if (!::ReadFile(file, buffer.get(), to_read, &read, NULL))
+      return false;
+    if (read == 0)
+      break;
+    length -= read;
+  }
+  return true;
+}
+
 int WriteFile(const FilePath& filename, const char* data, int size) {
   base::ThreadRestrictions::AssertIOAllowed();
   base::win::ScopedHandle file(CreateFile(filename.value().c_str(),
@@ -916,7 +954,9 @@ MemoryMappedFile::MemoryMappedFile()
     : file_(INVALID_HANDLE_VALUE),
       file_mapping_(INVALID_HANDLE_VALUE),
       data_(NULL),
-      length_(INVALID_FILE_SIZE) {
+      length_(INVALID_FILE_SIZE),
+      data_offset_(0),
+      access_(READ_ONLY) {
 }
 
 bool MemoryMappedFile::InitializeAsImageSection(const FilePath& file_name) {
@@ -931,7 +971,7 @@ bool MemoryMappedFile::InitializeAsImageSection(const FilePath& file_name) {
     return false;
   }
 
-  if (!MapFileToMemoryInternalEx(SEC_IMAGE)) {
+  if (!MapFileToMemoryInternalEx(kWholeFile, READ_ONLY, SEC_IMAGE)) {
     CloseHandles();
     return false;
   }
@@ -939,11 +979,14 @@ bool MemoryMappedFile::InitializeAsImageSection(const FilePath& file_name) {
   return true;
 }
 
-bool MemoryMappedFile::MapFileToMemoryInternal() {
-  return MapFileToMemoryInternalEx(0);
+bool MemoryMappedFile::MapFileToMemoryInternal(const Region& region,
+                                               Access access) {
+  return MapFileToMemoryInternalEx(region, access, 0);
 }
 
-bool MemoryMappedFile::MapFileToMemoryInternalEx(int flags) {
+bool MemoryMappedFile::MapFileToMemoryInternalEx(const Region& region,
+                                                 Access access,
+                                                 int flags) {
   base::ThreadRestrictions::AssertIOAllowed();
 
   if (file_ == INVALID_HANDLE_VALUE)
@@ -953,8 +996,21 @@ bool MemoryMappedFile::MapFileToMemoryInternalEx(int flags) {
   if (length_ == INVALID_FILE_SIZE)
     return false;
 
-  file_mapping_ = ::CreateFileMapping(file_, NULL, PAGE_READONLY | flags,
-                                      0, 0, NULL);
+  int64 offset = 0;
+  if (region.size != kWholeFile.size) {
+    DCHECK(!(flags & SEC_IMAGE));
+    if (region.offset < 0 || region.size <= 0 ||
+        region.offset > static_cast<int64>(length_) - region.size) {
+      return false;
+    }
+    offset = region.offset;
+    length_ = static_cast<size_t>(region.size);
+  }
+
+  file_mapping_ = ::CreateFileMapping(
+      file_, NULL,
+      (access == READ_WRITE ? PAGE_READWRITE : PAGE_READONLY) | flags,
+      0, 0, NULL);
   if (!file_mapping_) {
     // According to msdn, system error codes are only reserved up to 15999.
     // http://msdn.microsoft.com/en-us/library/ms681381(v=VS.85).aspx.
@@ -963,18 +1019,30 @@ bool MemoryMappedFile::MapFileToMemoryInternalEx(int flags) {
     return false;
   }
 
-  data_ = static_cast<uint8*>(
-      ::MapViewOfFile(file_mapping_, FILE_MAP_READ, 0, 0, 0));
-  if (!data_) {
+  // Views must start on an allocation granularity boundary.
+  SYSTEM_INFO system_info;
+  ::GetSystemInfo(&system_info);
+  int64 aligned_offset =
+      offset - offset % system_info.dwAllocationGranularity;
+  data_offset_ = static_cast<size_t>(offset - aligned_offset);
+
+  uint8* start = static_cast<uint8*>(::MapViewOfFile(
+      file_mapping_, access == READ_WRITE ? FILE_MAP_WRITE : FILE_MAP_READ,
+      static_cast<DWORD>(aligned_offset >> 32),
+      static_cast<DWORD>(aligned_offset),
+      region.size == kWholeFile.size ? 0 : data_offset_ + length_));
+  if (!start) {
     UMA_HISTOGRAM_ENUMERATION("MemoryMappedFile.MapViewOfFile",
                               logging::GetLastSystemErrorCode(), 16000);
+    return false;
   }
-  return data_ != NULL;
+  data_ = start + data_offset_;
+  return true;
 }
 
 void MemoryMappedFile::CloseHandles() {
   if (data_)
-    ::UnmapViewOfFile(data_);
+    ::UnmapViewOfFile(data_ - data_offset_);
   if (file_mapping_ != INVALID_HANDLE_VALUE)
     ::CloseHandle(file_mapping_);
   if (file_ != INVALID_HANDLE_VALUE)
@@ -983,6 +1051,16 @@ void MemoryMappedFile::CloseHandles() {
   data_ = NULL;
   file_mapping_ = file_ = INVALID_HANDLE_VALUE;
   length_ = INVALID_FILE_SIZE;
+  data_offset_ = 0;
+  access_ = READ_ONLY;
+}
+
+void MemoryMappedFile::SetAccessPattern(AccessPattern pattern) {
+  // Windows only takes access hints when the file is opened.
+}
+
+void MemoryMappedFile::Prefetch(size_t offset, size_t size) {
+  // PrefetchVirtualMemory() is not available before Windows 8.
 }
 
 bool HasFileBeenModifiedSince(const FileEnumerator::FindInfo& find_info,
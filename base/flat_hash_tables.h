@@ -0,0 +1,684 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// base::flat_hash_map and base::flat_hash_set are open-addressing hash
+// tables with the interface of base::hash_map and base::hash_set.  Elements
+// live in one array instead of one heap node each, so lookups touch one or
+// two cache lines instead of following a pointer per node, and inserting
+// doesn't allocate unless the table grows.
+//
+//   base::flat_hash_map<int32, RenderWidgetHost*> routes;
+//   routes[routing_id] = host;
+//
+// The layout follows the "Swiss table" design: next to the elements is an
+// array of control bytes, one per slot, which holds 7 bits of the slot's
+// hash, or marks it empty or erased.  A lookup compares 8 control bytes at a
+// time against the hash of its key, and only compares keys where those
+// match, which is almost always only the key it's looking for.
+//
+// Differences from base::hash_map:
+// - Inserting may move every element, invalidating all iterators, pointers
+//   and references into the table.  Keep keys, not pointers, across
+//   inserts.  Erasing invalidates only iterators to the erased element, so
+//   erasing while iterating works as with hash_map:
+//
+//     for (Map::iterator it = map.begin(); it != map.end();) {
+//       if (ShouldErase(*it))
+//         map.erase(it++);
+//       else
+//         ++it;
+//     }
+//
+// - Growing the table copies the elements, so keep large values behind a
+//   pointer.
+// - The default hash is passed through a multiplicative mix, so identity
+//   hashes, such as hash<int>, work well.
+
+#ifndef BASE_FLAT_HASH_TABLES_H_
+#define BASE_FLAT_HASH_TABLES_H_
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "base/logging.h"
+#include "build/build_config.h"
+
+namespace base {
+
+namespace internal {
+
+// A control byte.  Full slots hold the low 7 bits of the mixed hash of
+// their key, so they are never negative.
+typedef int8 FlatHashCtrl;
+const FlatHashCtrl kFlatHashEmpty = -128;  // 0b10000000
+const FlatHashCtrl kFlatHashDeleted = -2;  // 0b11111110
+
+const uint64 kFlatHashLsbs = GG_UINT64_C(0x0101010101010101);
+const uint64 kFlatHashMsbs = GG_UINT64_C(0x8080808080808080);
+
+// Eight control bytes, matched at once with bit tricks on a 64-bit word.
+// The results are masks with the high bit of each matching byte set.
+class FlatHashGroup {
+ public:
+  static const size_t kWidth = 8;
+
+  explicit FlatHashGroup(const FlatHashCtrl* ctrl) {
+    memcpy(&ctrl_, ctrl, sizeof(ctrl_));
+  }
+
+  // Matches the full slots whose control byte is |h2|.  May also report
+  // other full slots, but never empty or erased ones.
+  uint64 Match(uint8 h2) const {
+    const uint64 x = ctrl_ ^ (kFlatHashLsbs * h2);
+    return (x - kFlatHashLsbs) & ~x & kFlatHashMsbs;
+  }
+
+  uint64 MatchEmpty() const {
+    return (ctrl_ & (~ctrl_ << 6)) & kFlatHashMsbs;
+  }
+
+  uint64 MatchEmptyOrDeleted() const {
+    return (ctrl_ & (~ctrl_ << 7)) & kFlatHashMsbs;
+  }
+
+  // Returns the index of the lowest matching byte of |mask|, which must not
+  // be zero.  Byte i of the group is byte i of the word on the little-endian
+  // CPUs we build for.
+  static size_t LowestIndex(uint64 mask) {
+    DCHECK(mask);
+#if defined(COMPILER_GCC)
+    return static_cast<size_t>(__builtin_ctzll(mask)) >> 3;
+#else
+    size_t index = 0;
+    while (!(mask & 0x80)) {
+      mask >>= 8;
+      ++index;
+    }
+    return index;
+#endif
+  }
+
+ private:
+  uint64 ctrl_;
+};
+
+// Spreads the entropy of |hash| over all its bits.
+inline size_t FlatHashMix(size_t hash) {
+#if defined(ARCH_CPU_64_BITS)
+  uint64 mixed = static_cast<uint64>(hash) * GG_UINT64_C(0x9E3779B97F4A7C15);
+  return static_cast<size_t>(mixed ^ (mixed >> 32));
+#else
+  uint32 mixed = static_cast<uint32>(hash) * 0x9E3779B9u;
+  return static_cast<size_t>(mixed ^ (mixed >> 16));
+#endif
+}
+
+template <typename Key>
+struct FlatHashDefaultHasher {
+  size_t operator()(const Key& key) const {
+#if defined(COMPILER_MSVC)
+    using BASE_HASH_NAMESPACE::hash_value;
+    return hash_value(key);
+#else
+    return BASE_HASH_NAMESPACE::hash<Key>()(key);
+#endif
+  }
+};
+
+template <typename Pair>
+struct FlatHashSelectFirst {
+  const typename Pair::first_type& operator()(const Pair& pair) const {
+    return pair.first;
+  }
+};
+
+template <typename Value>
+struct FlatHashIdentity {
+  const Value& operator()(const Value& value) const { return value; }
+};
+
+// The table behind flat_hash_map and flat_hash_set.  |ExtractKey| returns
+// the key of a Value.
+template <typename Value, typename Key, typename ExtractKey,
+          typename Hash, typename KeyEqual>
+class FlatHashTable {
+ private:
+  class IteratorBase;
+
+ public:
+  class iterator;
+  class const_iterator;
+
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef Hash hasher;
+  typedef KeyEqual key_equal;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef value_type* pointer;
+  typedef const value_type* const_pointer;
+
+  explicit FlatHashTable(size_type size_hint = 0,
+                         const hasher& hash = hasher(),
+                         const key_equal& equal = key_equal())
+      : hash_(hash),
+        equal_(equal),
+        ctrl_(NULL),
+        slots_(NULL),
+        capacity_(0),
+        size_(0),
+        growth_left_(0) {
+    if (size_hint)
+      resize(size_hint);
+  }
+
+  FlatHashTable(const FlatHashTable& other)
+      : hash_(other.hash_),
+        equal_(other.equal_),
+        ctrl_(NULL),
+        slots_(NULL),
+        capacity_(0),
+        size_(0),
+        growth_left_(0) {
+    insert(other.begin(), other.end());
+  }
+
+  ~FlatHashTable() {
+    DestroySlots();
+    Deallocate();
+  }
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      FlatHashTable copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  iterator begin() { return iterator(ctrl_, slots_, ctrl_ + capacity_); }
+  iterator end() {
+    return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+  }
+  const_iterator begin() const {
+    return const_iterator(ctrl_, slots_, ctrl_ + capacity_);
+  }
+  const_iterator end() const {
+    return const_iterator(ctrl_ + capacity_, slots_ + capacity_,
+                          ctrl_ + capacity_);
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type bucket_count() const { return capacity_; }
+
+  hasher hash_funct() const { return hash_; }
+  key_equal key_eq() const { return equal_; }
+
+  iterator find(const key_type& key) {
+    size_t index;
+    if (!FindIndex(key, Mix(key), &index))
+      return end();
+    return IteratorAt(index);
+  }
+
+  const_iterator find(const key_type& key) const {
+    size_t index;
+    if (!FindIndex(key, Mix(key), &index))
+      return end();
+    return const_iterator(IteratorAt(index));
+  }
+
+  size_type count(const key_type& key) const {
+    size_t index;
+    return FindIndex(key, Mix(key), &index) ? 1 : 0;
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    iterator it = find(key);
+    if (it == end())
+      return std::make_pair(it, it);
+    iterator next = it;
+    return std::make_pair(it, ++next);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(
+      const key_type& key) const {
+    const_iterator it = find(key);
+    if (it == end())
+      return std::make_pair(it, it);
+    const_iterator next = it;
+    return std::make_pair(it, ++next);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    const key_type& key = ExtractKey()(value);
+    const size_t hash = Mix(key);
+    size_t index;
+    if (FindIndex(key, hash, &index))
+      return std::make_pair(IteratorAt(index), false);
+    index = PrepareInsert(hash);
+    new (slots_ + index) value_type(value);
+    SetCtrl(index, H2(hash));
+    ++size_;
+    return std::make_pair(IteratorAt(index), true);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  void erase(const_iterator it) {
+    DCHECK(it != end());
+    EraseIndex(it.slot_ - slots_);
+  }
+
+  void erase(const_iterator first, const_iterator last) {
+    while (first != last)
+      erase(first++);
+  }
+
+  size_type erase(const key_type& key) {
+    size_t index;
+    if (!FindIndex(key, Mix(key), &index))
+      return 0;
+    EraseIndex(index);
+    return 1;
+  }
+
+  // Keeps the capacity.
+  void clear() {
+    DestroySlots();
+    if (capacity_)
+      memset(ctrl_, kFlatHashEmpty, capacity_);
+    size_ = 0;
+    growth_left_ = MaxSize(capacity_);
+  }
+
+  // Makes room for |size_hint| elements without growing again.
+  void resize(size_type size_hint) {
+    size_t capacity = FlatHashGroup::kWidth;
+    while (MaxSize(capacity) < size_hint)
+      capacity *= 2;
+    if (capacity > capacity_)
+      Rehash(capacity);
+  }
+
+  void swap(FlatHashTable& other) {
+    std::swap(hash_, other.hash_);
+    std::swap(equal_, other.equal_);
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+  }
+
+ private:
+  // Iterators walk the control bytes from |ctrl_| to |ctrl_end_|, stopping
+  // at full slots.  |slot_| is the element at |ctrl_|.
+  class IteratorBase {
+   protected:
+    IteratorBase() : ctrl_(NULL), slot_(NULL), ctrl_end_(NULL) {}
+    IteratorBase(FlatHashCtrl* ctrl, value_type* slot, FlatHashCtrl* ctrl_end)
+        : ctrl_(ctrl), slot_(slot), ctrl_end_(ctrl_end) {
+      SkipFree();
+    }
+
+    void Advance() {
+      DCHECK(ctrl_ != ctrl_end_);
+      ++ctrl_;
+      ++slot_;
+      SkipFree();
+    }
+
+    bool Equals(const IteratorBase& other) const {
+      return ctrl_ == other.ctrl_;
+    }
+
+    FlatHashCtrl* ctrl_;
+    value_type* slot_;
+    FlatHashCtrl* ctrl_end_;
+
+   private:
+    friend class FlatHashTable;
+
+    void SkipFree() {
+      while (ctrl_ != ctrl_end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+  };
+
+ public:
+  class iterator : public IteratorBase {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename FlatHashTable::value_type value_type;
+    typedef typename FlatHashTable::difference_type difference_type;
+    typedef typename FlatHashTable::pointer pointer;
+    typedef typename FlatHashTable::reference reference;
+
+    iterator() {}
+
+    reference operator*() const { return *this->slot_; }
+    pointer operator->() const { return this->slot_; }
+
+    iterator& operator++() {
+      this->Advance();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      this->Advance();
+      return old;
+    }
+
+    bool operator==(const iterator& other) const {
+      return this->Equals(other);
+    }
+    bool operator!=(const iterator& other) const {
+      return !this->Equals(other);
+    }
+
+   private:
+    friend class FlatHashTable;
+
+    iterator(FlatHashCtrl* ctrl, value_type* slot, FlatHashCtrl* ctrl_end)
+        : IteratorBase(ctrl, slot, ctrl_end) {
+    }
+  };
+
+  class const_iterator : public IteratorBase {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename FlatHashTable::value_type value_type;
+    typedef typename FlatHashTable::difference_type difference_type;
+    typedef typename FlatHashTable::const_pointer pointer;
+    typedef typename FlatHashTable::const_reference reference;
+
+    const_iterator() {}
+    const_iterator(const iterator& it) : IteratorBase(it) {}
+
+    reference operator*() const { return *this->slot_; }
+    pointer operator->() const { return this->slot_; }
+
+    const_iterator& operator++() {
+      this->Advance();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      this->Advance();
+      return old;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return this->Equals(other);
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !this->Equals(other);
+    }
+
+   private:
+    friend class FlatHashTable;
+
+    const_iterator(FlatHashCtrl* ctrl, value_type* slot,
+                   FlatHashCtrl* ctrl_end)
+        : IteratorBase(ctrl, slot, ctrl_end) {
+    }
+  };
+
+ private:
+  // At most 7/8 of the slots are used, so every probe sequence ends in an
+  // empty slot.
+  static size_t MaxSize(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  // The low 7 bits of the mixed hash go into the control byte; the rest pick
+  // the first group to probe.
+  static uint8 H2(size_t hash) { return static_cast<uint8>(hash & 0x7f); }
+  static size_t H1(size_t hash) { return hash >> 7; }
+
+  size_t Mix(const key_type& key) const { return FlatHashMix(hash_(key)); }
+
+  iterator IteratorAt(size_t index) const {
+    return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+  }
+
+  void SetCtrl(size_t index, FlatHashCtrl ctrl) { ctrl_[index] = ctrl; }
+
+  // Probes whole groups, in the order H1, H1 + 1, H1 + 3, H1 + 6, ...  That
+  // visits every group when the number of groups is a power of two.
+  bool FindIndex(const key_type& key, size_t hash, size_t* index) const {
+    if (!capacity_)
+      return false;
+    const size_t group_mask = capacity_ / FlatHashGroup::kWidth - 1;
+    size_t group = H1(hash) & group_mask;
+    for (size_t step = 1; ; ++step) {
+      const size_t base = group * FlatHashGroup::kWidth;
+      FlatHashGroup ctrl(ctrl_ + base);
+      for (uint64 match = ctrl.Match(H2(hash)); match;
+           match &= match - 1) {
+        const size_t i = base + FlatHashGroup::LowestIndex(match);
+        if (equal_(ExtractKey()(slots_[i]), key)) {
+          *index = i;
+          return true;
+        }
+      }
+      // Had the key been inserted, it would have gone into this empty slot
+      // or an earlier one.
+      if (ctrl.MatchEmpty())
+        return false;
+      group = (group + step) & group_mask;
+    }
+  }
+
+  size_t FindFirstFree(size_t hash) const {
+    const size_t group_mask = capacity_ / FlatHashGroup::kWidth - 1;
+    size_t group = H1(hash) & group_mask;
+    for (size_t step = 1; ; ++step) {
+      const size_t base = group * FlatHashGroup::kWidth;
+      uint64 free = FlatHashGroup(ctrl_ + base).MatchEmptyOrDeleted();
+      if (free)
+        return base + FlatHashGroup::LowestIndex(free);
+      group = (group + step) & group_mask;
+    }
+  }
+
+  // Returns the slot a new element with |hash| goes in, growing the table if
+  // that would use up its last free slot.
+  size_t PrepareInsert(size_t hash) {
+    if (!capacity_)
+      Rehash(FlatHashGroup::kWidth);
+    size_t index = FindFirstFree(hash);
+    if (!growth_left_ && ctrl_[index] == kFlatHashEmpty) {
+      // Reusing erased slots doesn't use up empty ones, so if more than half
+      // the free slots are erased ones, clearing them is enough.
+      if (size_ <= MaxSize(capacity_) / 2)
+        Rehash(capacity_);
+      else
+        Rehash(capacity_ * 2);
+      index = FindFirstFree(hash);
+    }
+    if (ctrl_[index] == kFlatHashEmpty)
+      --growth_left_;
+    return index;
+  }
+
+  void EraseIndex(size_t index) {
+    slots_[index].~value_type();
+    --size_;
+    // A lookup stops at the first group with an empty slot, so if this
+    // slot's group already has one, no key was placed past it, and this slot
+    // can be empty too.  Otherwise it has to stay marked as erased.
+    const size_t base = index & ~(FlatHashGroup::kWidth - 1);
+    if (FlatHashGroup(ctrl_ + base).MatchEmpty()) {
+      SetCtrl(index, kFlatHashEmpty);
+      ++growth_left_;
+    } else {
+      SetCtrl(index, kFlatHashDeleted);
+    }
+  }
+
+  // Moves every element into a table of |capacity| slots, which also drops
+  // the erased markers.
+  void Rehash(size_t capacity) {
+    DCHECK_GE(MaxSize(capacity), size_);
+    FlatHashCtrl* old_ctrl = ctrl_;
+    value_type* old_slots = slots_;
+    const size_t old_capacity = capacity_;
+
+    ctrl_ = new FlatHashCtrl[capacity];
+    memset(ctrl_, kFlatHashEmpty, capacity);
+    slots_ = std::allocator<value_type>().allocate(capacity);
+    capacity_ = capacity;
+    growth_left_ = MaxSize(capacity) - size_;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0)
+        continue;
+      const size_t hash = Mix(ExtractKey()(old_slots[i]));
+      const size_t index = FindFirstFree(hash);
+      new (slots_ + index) value_type(old_slots[i]);
+      SetCtrl(index, H2(hash));
+      old_slots[i].~value_type();
+    }
+    if (old_capacity) {
+      delete[] old_ctrl;
+      std::allocator<value_type>().deallocate(old_slots, old_capacity);
+    }
+  }
+
+  void DestroySlots() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0)
+        slots_[i].~value_type();
+    }
+  }
+
+  void Deallocate() {
+    if (!capacity_)
+      return;
+    delete[] ctrl_;
+    std::allocator<value_type>().deallocate(slots_, capacity_);
+  }
+
+  hasher hash_;
+  key_equal equal_;
+
+  // |capacity_| control bytes and slots.  The capacity is zero or a power of
+  // two of at least one group.
+  FlatHashCtrl* ctrl_;
+  value_type* slots_;
+  size_t capacity_;
+
+  size_t size_;
+
+  // How many more empty slots can be filled before the table must grow.
+  size_t growth_left_;
+};
+
+}  // namespace internal
+
+template <typename Key, typename Value,
+          typename Hash = internal::FlatHashDefaultHasher<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class flat_hash_map
+    : public internal::FlatHashTable<
+          std::pair<const Key, Value>, Key,
+          internal::FlatHashSelectFirst<std::pair<const Key, Value> >,
+          Hash, KeyEqual> {
+ private:
+  typedef internal::FlatHashTable<
+      std::pair<const Key, Value>, Key,
+      internal::FlatHashSelectFirst<std::pair<const Key, Value> >,
+      Hash, KeyEqual> Table;
+
+ public:
+  typedef Value mapped_type;
+
+  explicit flat_hash_map(typename Table::size_type size_hint = 0,
+                         const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : Table(size_hint, hash, equal) {
+  }
+
+  template <typename InputIterator>
+  flat_hash_map(InputIterator first, InputIterator last) {
+    this->insert(first, last);
+  }
+
+  mapped_type& operator[](const Key& key) {
+    typename Table::iterator it = this->find(key);
+    if (it == this->end())
+      it = this->insert(typename Table::value_type(key, mapped_type())).first;
+    return it->second;
+  }
+};
+
+// Elements of a set can't be modified in place, so its iterator is a
+// const_iterator.
+template <typename Key,
+          typename Hash = internal::FlatHashDefaultHasher<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class flat_hash_set
+    : public internal::FlatHashTable<Key, Key, internal::FlatHashIdentity<Key>,
+                                     Hash, KeyEqual> {
+ private:
+  typedef internal::FlatHashTable<Key, Key, internal::FlatHashIdentity<Key>,
+                                  Hash, KeyEqual> Table;
+
+ public:
+  typedef typename Table::const_iterator iterator;
+  typedef typename Table::const_iterator const_iterator;
+
+  explicit flat_hash_set(typename Table::size_type size_hint = 0,
+                         const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : Table(size_hint, hash, equal) {
+  }
+
+  template <typename InputIterator>
+  flat_hash_set(InputIterator first, InputIterator last) {
+    Table::insert(first, last);
+  }
+
+  iterator begin() const { return Table::begin(); }
+  iterator end() const { return Table::end(); }
+  iterator find(const Key& key) const { return Table::find(key); }
+
+  std::pair<iterator, iterator> equal_range(const Key& key) const {
+    return Table::equal_range(key);
+  }
+
+  std::pair<iterator, bool> insert(const Key& key) {
+    std::pair<typename Table::iterator, bool> result = Table::insert(key);
+    return std::make_pair(iterator(result.first), result.second);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    Table::insert(first, last);
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_FLAT_HASH_TABLES_H_
@@ -0,0 +1,151 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/flat_hash_tables.h"
+#include "base/hash_tables.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kOperations = 1000000;
+
+void LogTime(const char* container, const char* test, const PerfTimer& timer) {
+  LogPerfResult(StringPrintf("FlatHashTables_%s_%s", test, container).c_str(),
+                timer.Elapsed().InMicroseconds() * 1000.0 / kOperations,
+                "ns/op");
+}
+
+// Looks up |lookups| in a container holding |keys|, cycling through them
+// until kOperations lookups are done.
+template <typename Map>
+void RunLookupTest(const char* container,
+                   const char* test,
+                   const std::vector<typename Map::key_type>& keys,
+                   const std::vector<typename Map::key_type>& lookups) {
+  Map map;
+  for (size_t i = 0; i < keys.size(); ++i)
+    map[keys[i]] = static_cast<int>(i);
+
+  int found = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kOperations; ++i)
+    found += map.count(lookups[i % lookups.size()]);
+  LogTime(container, test, timer);
+  EXPECT_LE(0, found);
+}
+
+// Adds each of |keys| and removes it again |window| insertions later, like
+// a cache index with a steady population.
+template <typename Map>
+void RunChurnTest(const char* container,
+                  const std::vector<typename Map::key_type>& keys,
+                  size_t window) {
+  Map map;
+  PerfTimer timer;
+  for (int i = 0; i < kOperations; ++i) {
+    map[keys[i % keys.size()]] = i;
+    if (static_cast<size_t>(i) >= window)
+      map.erase(keys[(i - window) % keys.size()]);
+  }
+  LogTime(container, "Churn", timer);
+  EXPECT_GE(window, map.size());
+}
+
+template <typename Map>
+void RunIterateTest(const char* container,
+                    const std::vector<typename Map::key_type>& keys) {
+  Map map;
+  for (size_t i = 0; i < keys.size(); ++i)
+    map[keys[i]] = static_cast<int>(i);
+
+  int64 sum = 0;
+  PerfTimer timer;
+  for (int pass = 0; pass < kOperations / static_cast<int>(keys.size());
+       ++pass) {
+    for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+      sum += it->second;
+  }
+  LogTime(container, "Iterate", timer);
+  EXPECT_LT(0, sum);
+}
+
+template <typename Key>
+void RunLookupTests(const char* test,
+                    const std::vector<Key>& keys,
+                    const std::vector<Key>& lookups) {
+  RunLookupTest<std::map<Key, int> >("map", test, keys, lookups);
+  RunLookupTest<hash_map<Key, int> >("hash_map", test, keys, lookups);
+  RunLookupTest<flat_hash_map<Key, int> >("flat_hash_map", test, keys,
+                                          lookups);
+}
+
+// Shuffles |keys| with a fixed seed, so runs are comparable.
+template <typename Key>
+std::vector<Key> Shuffled(const std::vector<Key>& keys) {
+  std::vector<Key> shuffled(keys);
+  srand(1);
+  for (size_t i = shuffled.size() - 1; i > 0; --i)
+    std::swap(shuffled[i], shuffled[rand() % (i + 1)]);
+  return shuffled;
+}
+
+}  // namespace
+
+// Routing IDs: small, dense integers.  Few per map in the common case, but
+// thousands in browser-wide tables.
+TEST(FlatHashTablesPerfTest, RoutingIds) {
+  std::vector<int> small;
+  for (int i = 1; i <= 8; ++i)
+    small.push_back(i);
+  RunLookupTests("RoutingIds8", small, Shuffled(small));
+
+  std::vector<int> large;
+  for (int i = 1; i <= 10000; ++i)
+    large.push_back(i);
+  RunLookupTests("RoutingIds10000", large, Shuffled(large));
+}
+
+// Host names, looked up both present and absent, as by HostCache.
+TEST(FlatHashTablesPerfTest, HostNames) {
+  std::vector<std::string> hosts;
+  std::vector<std::string> misses;
+  for (int i = 0; i < 1000; ++i) {
+    hosts.push_back(StringPrintf("host%d.example.com", i * 7919));
+    misses.push_back(StringPrintf("host%d.example.org", i * 7919));
+  }
+  RunLookupTests("HostNames_Hit", hosts, Shuffled(hosts));
+  RunLookupTests("HostNames_Miss", hosts, misses);
+}
+
+// 64-bit hashes of cache keys, as in the disk cache's indices.
+TEST(FlatHashTablesPerfTest, CacheHashes) {
+  std::vector<uint64> hashes;
+  srand(2);
+  for (int i = 0; i < 100000; ++i) {
+    hashes.push_back((static_cast<uint64>(rand()) << 40) ^
+                     (static_cast<uint64>(rand()) << 20) ^ rand());
+  }
+  std::vector<uint64> resident(hashes.begin(), hashes.begin() + 10000);
+  RunLookupTests("CacheHashes", resident, Shuffled(resident));
+
+  RunChurnTest<std::map<uint64, int> >("map", hashes, 10000);
+  RunChurnTest<hash_map<uint64, int> >("hash_map", hashes, 10000);
+  RunChurnTest<flat_hash_map<uint64, int> >("flat_hash_map", hashes, 10000);
+
+  RunIterateTest<std::map<uint64, int> >("map", resident);
+  RunIterateTest<hash_map<uint64, int> >("hash_map", resident);
+  RunIterateTest<flat_hash_map<uint64, int> >("flat_hash_map", resident);
+}
+
+}  // namespace base
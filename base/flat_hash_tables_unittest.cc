@@ -0,0 +1,227 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/flat_hash_tables.h"
+
+#include <stdlib.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Counts the live instances, to check that the table destroys what it
+// constructs.
+class Counted {
+ public:
+  Counted() : value_(0) { ++live_; }
+  explicit Counted(int value) : value_(value) { ++live_; }
+  Counted(const Counted& other) : value_(other.value_) { ++live_; }
+  ~Counted() { --live_; }
+
+  Counted& operator=(const Counted& other) {
+    value_ = other.value_;
+    return *this;
+  }
+
+  int value() const { return value_; }
+  static int live() { return live_; }
+
+ private:
+  int value_;
+  static int live_;
+};
+
+int Counted::live_ = 0;
+
+// Puts every key in the same group, so lookups rely on comparing keys.
+struct CollidingHash {
+  size_t operator()(int key) const { return 0; }
+};
+
+}  // namespace
+
+TEST(FlatHashTablesTest, Basic) {
+  flat_hash_map<int, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(1) == map.end());
+  EXPECT_EQ(0u, map.erase(1));
+
+  EXPECT_TRUE(map.insert(std::make_pair(1, 10)).second);
+  EXPECT_FALSE(map.insert(std::make_pair(1, 20)).second);
+  map[2] = 20;
+  map[3];
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(10, map.find(1)->second);
+  EXPECT_EQ(20, map[2]);
+  EXPECT_EQ(0, map[3]);
+  EXPECT_EQ(1u, map.count(2));
+  EXPECT_EQ(0u, map.count(4));
+
+  EXPECT_EQ(1u, map.erase(2));
+  EXPECT_TRUE(map.find(2) == map.end());
+  map.erase(map.find(1));
+  EXPECT_EQ(1u, map.size());
+  EXPECT_EQ(3, map.begin()->first);
+}
+
+TEST(FlatHashTablesTest, Grow) {
+  const int kCount = 10000;
+  flat_hash_map<int, int> map;
+  for (int i = 0; i < kCount; ++i)
+    map[i] = i * 2;
+  EXPECT_EQ(static_cast<size_t>(kCount), map.size());
+  EXPECT_GE(map.bucket_count() * 7 / 8, map.size());
+  for (int i = 0; i < kCount; ++i) {
+    flat_hash_map<int, int>::const_iterator it = map.find(i);
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(i * 2, it->second);
+  }
+  EXPECT_TRUE(map.find(kCount) == map.end());
+
+  // Iteration visits every element once.
+  std::set<int> seen;
+  for (flat_hash_map<int, int>::iterator it = map.begin(); it != map.end();
+       ++it) {
+    EXPECT_TRUE(seen.insert(it->first).second);
+  }
+  EXPECT_EQ(static_cast<size_t>(kCount), seen.size());
+}
+
+TEST(FlatHashTablesTest, Resize) {
+  flat_hash_map<int, int> map(100);
+  const size_t buckets = map.bucket_count();
+  EXPECT_LE(100u, buckets * 7 / 8);
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+  EXPECT_EQ(buckets, map.bucket_count());
+}
+
+TEST(FlatHashTablesTest, EraseWhileIterating) {
+  flat_hash_map<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+  for (flat_hash_map<int, int>::iterator it = map.begin(); it != map.end();) {
+    if (it->first % 3)
+      map.erase(it++);
+    else
+      ++it;
+  }
+  EXPECT_EQ(334u, map.size());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 3 ? 0u : 1u, map.count(i));
+}
+
+// Random inserts and erases, checked against std::map.  Exercises reusing
+// erased slots and rehashing to drop them.
+TEST(FlatHashTablesTest, Churn) {
+  flat_hash_map<int, int> map;
+  std::map<int, int> expected;
+  srand(1);
+  for (int i = 0; i < 100000; ++i) {
+    int key = rand() % 500;
+    if (rand() % 2) {
+      map[key] = i;
+      expected[key] = i;
+    } else {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+  }
+  ASSERT_EQ(expected.size(), map.size());
+  for (std::map<int, int>::iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    ASSERT_EQ(1u, map.count(it->first));
+    EXPECT_EQ(it->second, map[it->first]);
+  }
+  // Half full, so the table didn't keep growing to hold erased slots.
+  EXPECT_GE(1024u, map.bucket_count());
+}
+
+TEST(FlatHashTablesTest, Collisions) {
+  flat_hash_map<int, int, CollidingHash> map;
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+  for (int i = 0; i < 100; i += 2)
+    map.erase(i);
+  for (int i = 1; i < 100; i += 2)
+    EXPECT_EQ(i, map[i]);
+  EXPECT_TRUE(map.find(0) == map.end());
+  EXPECT_EQ(50u, map.size());
+}
+
+TEST(FlatHashTablesTest, StringKeys) {
+  flat_hash_map<std::string, int> map;
+  for (int i = 0; i < 500; ++i)
+    map[StringPrintf("www.example%d.com", i)] = i;
+  for (int i = 0; i < 500; ++i)
+    EXPECT_EQ(i, map[StringPrintf("www.example%d.com", i)]);
+  EXPECT_TRUE(map.find("www.example.com") == map.end());
+}
+
+TEST(FlatHashTablesTest, Lifetimes) {
+  {
+    flat_hash_map<int, Counted> map;
+    for (int i = 0; i < 1000; ++i)
+      map.insert(std::make_pair(i, Counted(i)));
+    EXPECT_EQ(1000, Counted::live());
+    for (int i = 0; i < 1000; i += 2)
+      map.erase(i);
+    EXPECT_EQ(500, Counted::live());
+
+    flat_hash_map<int, Counted> copy(map);
+    EXPECT_EQ(1000, Counted::live());
+    EXPECT_EQ(501, copy[501].value());
+    copy.clear();
+    EXPECT_EQ(500, Counted::live());
+    EXPECT_TRUE(copy.empty());
+    copy[7] = Counted(7);
+    EXPECT_EQ(501, Counted::live());
+  }
+  EXPECT_EQ(0, Counted::live());
+}
+
+TEST(FlatHashTablesTest, CopyAndSwap) {
+  flat_hash_map<int, int> a;
+  flat_hash_map<int, int> b;
+  a[1] = 1;
+  b[2] = 2;
+  b[3] = 3;
+  a.swap(b);
+  EXPECT_EQ(2u, a.size());
+  EXPECT_EQ(1u, b.size());
+  EXPECT_EQ(3, a[3]);
+
+  b = a;
+  EXPECT_EQ(2u, b.size());
+  EXPECT_EQ(2, b[2]);
+  b[4] = 4;
+  EXPECT_EQ(0u, a.count(4));
+}
+
+TEST(FlatHashTablesTest, Set) {
+  flat_hash_set<std::string> set;
+  EXPECT_TRUE(set.insert("a").second);
+  EXPECT_FALSE(set.insert("a").second);
+  EXPECT_TRUE(set.insert("b").second);
+  EXPECT_EQ(2u, set.size());
+  EXPECT_EQ(1u, set.count("b"));
+  EXPECT_EQ("a", *set.find("a"));
+
+  flat_hash_set<std::string>::iterator it = set.find("a");
+  set.erase(it);
+  EXPECT_EQ(0u, set.count("a"));
+
+  std::set<std::string> contents(set.begin(), set.end());
+  EXPECT_EQ(1u, contents.size());
+  EXPECT_EQ(1u, contents.count("b"));
+}
+
+}  // namespace base
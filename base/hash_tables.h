@@ -11,6 +11,10 @@
 //   base::hash_map<int> my_map;
 //   base::hash_set<int> my_set;
 //
+// These are node-based.  For tables on hot paths, consider
+// base::flat_hash_map and base::flat_hash_set in base/flat_hash_tables.h,
+// which have the same interface but keep their elements in one array.
+//
 // NOTE: It is an explicit non-goal of this class to provide a generic hash
 // function for pointers.  If you want to hash a pointers to a particular class,
 // please define the template specialization elsewhere (for example, in its
@@ -0,0 +1,87 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/incoming_task_queue.h"
+
+#include "base/logging.h"
+#include "base/memory/fixed_size_pool.h"
+
+namespace base {
+
+IncomingTaskQueue::Node::Node() : next(0) {
+}
+
+// Nodes are created on the posting threads and deleted on the consumer
+// thread at the rate tasks are posted, so they come from a pool rather than
+// the heap.
+struct IncomingTaskQueue::TaskNode : public IncomingTaskQueue::Node {
+  DECLARE_POOLED_ALLOCATION();
+
+  explicit TaskNode(PendingTask* pending_task)
+      : task(pending_task) {
+  }
+
+  PendingTask task;
+};
+
+DEFINE_POOLED_ALLOCATION(IncomingTaskQueue::TaskNode);
+
+IncomingTaskQueue::IncomingTaskQueue()
+    : head_(reinterpret_cast<subtle::AtomicWord>(&stub_)),
+      tail_(&stub_),
+      pending_count_(0) {
+}
+
+IncomingTaskQueue::~IncomingTaskQueue() {
+  TaskQueue leftovers;
+  bool in_flight = ReloadInto(&leftovers);
+  DCHECK(!in_flight);
+  if (tail_ != &stub_)
+    delete static_cast<TaskNode*>(tail_);
+}
+
+bool IncomingTaskQueue::Push(PendingTask* pending_task) {
+  // Count the task before it becomes reachable, so that the consumer never
+  // sees more tasks than |pending_count_| accounts for.
+  bool was_empty = subtle::Barrier_AtomicIncrement(&pending_count_, 1) == 1;
+
+  TaskNode* node = new TaskNode(pending_task);
+  // The exchange makes |node| visible to other producers, so the writes that
+  // built it must not move past it.  atomicops has no exchange with a
+  // barrier, so the barrier comes first.
+  subtle::MemoryBarrier();
+  Node* prev = reinterpret_cast<Node*>(subtle::NoBarrier_AtomicExchange(
+      &head_, reinterpret_cast<subtle::AtomicWord>(node)));
+  // The consumer reaches |node| through |prev->next|, with an acquire load
+  // that pairs with this release store.
+  subtle::Release_Store(&prev->next,
+                        reinterpret_cast<subtle::AtomicWord>(node));
+  return was_empty;
+}
+
+bool IncomingTaskQueue::ReloadInto(TaskQueue* work_queue) {
+  subtle::Atomic32 moved = 0;
+  for (;;) {
+    TaskNode* next =
+        reinterpret_cast<TaskNode*>(subtle::Acquire_Load(&tail_->next));
+    if (!next)
+      break;  // Either empty, or the next producer is still in flight.
+    // |next| becomes the new dummy.  Moving the task out also drops its
+    // reference to the callback's bound state, which must not outlive the run.
+    work_queue->PushByMove(&next->task);
+    if (tail_ != &stub_)
+      delete static_cast<TaskNode*>(tail_);
+    tail_ = next;
+    ++moved;
+  }
+  if (!moved)
+    return !IsEmpty();
+  return subtle::Barrier_AtomicIncrement(&pending_count_, -moved) != 0;
+}
+
+bool IncomingTaskQueue::IsEmpty() const {
+  return subtle::Acquire_Load(&pending_count_) == 0;
+}
+
+}  // namespace base
@@ -0,0 +1,81 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_INCOMING_TASK_QUEUE_H_
+#define BASE_INCOMING_TASK_QUEUE_H_
+#pragma once
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/pending_task.h"
+
+namespace base {
+
+// A multi-producer, single-consumer queue of PendingTasks that does not take
+// a lock on either side.  Any thread may call Push(); only one thread (the
+// owning MessageLoop's thread) may call ReloadInto().
+//
+// The implementation is a variant of Dmitry Vyukov's non-intrusive MPSC node
+// queue: producers atomically swap themselves in as the new head and
+// then link the previous head to their node.  Between those two steps the
+// queue is briefly "in flight": the consumer cannot see the new node (nor any
+// node pushed after it) until the link is published.  A separate atomic count
+// of pushed-but-not-yet-consumed tasks lets both sides tell an in-flight queue
+// apart from an empty one, which is what drives wake-up decisions.
+class BASE_EXPORT IncomingTaskQueue {
+ public:
+  IncomingTaskQueue();
+
+  // Destroys any tasks that were never reloaded.  Must be called on the
+  // consumer thread, after all producers are done.
+  ~IncomingTaskQueue();
+
+  // Appends |pending_task|, moving its closure into the queue and leaving
+  // |pending_task->task| null.  Safe to call from any thread.  Returns true if
+  // the queue held no unconsumed tasks before this call, in which case the
+  // caller is responsible for waking the consumer.
+  bool Push(PendingTask* pending_task);
+
+  // Moves every published task onto the back of |work_queue|, preserving
+  // push order.  Consumer thread only.  Returns true if tasks remain that were
+  // pushed but could not be moved because their producer has not finished
+  // publishing them yet; the caller must arrange to call ReloadInto() again.
+  bool ReloadInto(TaskQueue* work_queue);
+
+  // Returns true if there are no pushed-but-unconsumed tasks.  This is only a
+  // snapshot when producers are active.
+  bool IsEmpty() const;
+
+ private:
+  struct Node {
+    Node();
+
+    // The node pushed after this one, or 0 if none has been published yet.
+    volatile subtle::AtomicWord next;
+  };
+  struct TaskNode;
+
+  // Dummy node the queue starts out with, so that neither side ever has to
+  // deal with a NULL head or tail.  Once consumed past it is never reused.
+  Node stub_;
+
+  // The most recently pushed node.  Swapped by producers.
+  volatile subtle::AtomicWord head_;
+
+  // The oldest node, whose task has already been consumed.  Its |next| is the
+  // first unconsumed task.  Only touched by the consumer.
+  Node* tail_;
+
+  // Number of tasks that have been (or are being) pushed but not yet moved
+  // out by ReloadInto().  Producers increment it before they link their node,
+  // so it never undercounts what the consumer can see.
+  volatile subtle::Atomic32 pending_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_INCOMING_TASK_QUEUE_H_
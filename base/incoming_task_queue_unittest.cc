@@ -0,0 +1,154 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/incoming_task_queue.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void Increment(int* value) {
+  ++*value;
+}
+
+bool PushTask(IncomingTaskQueue* queue, int sequence_num) {
+  PendingTask pending_task(FROM_HERE, Bind(&DoNothing));
+  pending_task.sequence_num = sequence_num;
+  return queue->Push(&pending_task);
+}
+
+// Pushes |count| tasks numbered [first, first + count) in order.
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(IncomingTaskQueue* queue, int first, int count)
+      : queue_(queue), first_(first), count_(count) {
+  }
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < count_; ++i)
+      PushTask(queue_, first_ + i);
+  }
+
+ private:
+  IncomingTaskQueue* queue_;
+  int first_;
+  int count_;
+};
+
+}  // namespace
+
+TEST(IncomingTaskQueueTest, Empty) {
+  IncomingTaskQueue queue;
+  EXPECT_TRUE(queue.IsEmpty());
+
+  TaskQueue work_queue;
+  EXPECT_FALSE(queue.ReloadInto(&work_queue));
+  EXPECT_TRUE(work_queue.empty());
+}
+
+TEST(IncomingTaskQueueTest, PushReportsEmptyTransitions) {
+  IncomingTaskQueue queue;
+  EXPECT_TRUE(PushTask(&queue, 0));
+  EXPECT_FALSE(PushTask(&queue, 1));
+  EXPECT_FALSE(queue.IsEmpty());
+
+  TaskQueue work_queue;
+  EXPECT_FALSE(queue.ReloadInto(&work_queue));
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(2u, work_queue.size());
+
+  // Once drained, the next push is the one that must wake the consumer.
+  EXPECT_TRUE(PushTask(&queue, 2));
+}
+
+TEST(IncomingTaskQueueTest, PreservesOrder) {
+  IncomingTaskQueue queue;
+  for (int i = 0; i < 10; ++i)
+    PushTask(&queue, i);
+
+  TaskQueue work_queue;
+  PendingTask first_task(FROM_HERE, Bind(&DoNothing));
+  first_task.sequence_num = -1;
+  work_queue.PushByMove(&first_task);
+  EXPECT_FALSE(queue.ReloadInto(&work_queue));
+  ASSERT_EQ(11u, work_queue.size());
+  for (int i = -1; i < 10; ++i) {
+    EXPECT_EQ(i, work_queue.front().sequence_num);
+    work_queue.pop();
+  }
+}
+
+TEST(IncomingTaskQueueTest, MovesClosures) {
+  IncomingTaskQueue queue;
+  int value = 0;
+  PendingTask pending_task(FROM_HERE, BindOnce(&Increment, &value),
+                           TimeTicks(), true);
+  queue.Push(&pending_task);
+  EXPECT_TRUE(pending_task.task.is_null());
+
+  TaskQueue work_queue;
+  EXPECT_FALSE(queue.ReloadInto(&work_queue));
+  ASSERT_EQ(1u, work_queue.size());
+  work_queue.front().task.Run();
+  EXPECT_EQ(1, value);
+}
+
+TEST(IncomingTaskQueueTest, DestroysUnconsumedTasks) {
+  // Tasks that were never reloaded must be released, not leaked.
+  IncomingTaskQueue* queue = new IncomingTaskQueue;
+  PushTask(queue, 0);
+  PushTask(queue, 1);
+  delete queue;
+}
+
+TEST(IncomingTaskQueueTest, ManyProducers) {
+  const int kNumProducers = 8;
+  const int kTasksPerProducer = 10000;
+
+  IncomingTaskQueue queue;
+  ScopedVector<Producer> producers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.push_back(
+        new Producer(&queue, i * kTasksPerProducer, kTasksPerProducer));
+    threads.push_back(
+        new DelegateSimpleThread(producers[i], "IncomingTaskQueueProducer"));
+  }
+  for (int i = 0; i < kNumProducers; ++i)
+    threads[i]->Start();
+
+  // Each producer's tasks must come out in the order that producer pushed
+  // them, however the producers interleave.
+  std::vector<int> next_expected(kNumProducers, 0);
+  int consumed = 0;
+  while (consumed < kNumProducers * kTasksPerProducer) {
+    TaskQueue work_queue;
+    queue.ReloadInto(&work_queue);
+    if (work_queue.empty())
+      PlatformThread::YieldCurrentThread();
+    while (!work_queue.empty()) {
+      int producer = work_queue.front().sequence_num / kTasksPerProducer;
+      int index = work_queue.front().sequence_num % kTasksPerProducer;
+      ASSERT_LT(producer, kNumProducers);
+      EXPECT_EQ(next_expected[producer], index);
+      next_expected[producer] = index + 1;
+      work_queue.pop();
+      ++consumed;
+    }
+  }
+
+  for (int i = 0; i < kNumProducers; ++i)
+    threads[i]->Join();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+}  // namespace base
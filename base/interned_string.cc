@@ -0,0 +1,162 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/interned_string.h"
+
+#include <ostream>
+
+#include "base/atomicops.h"
+#include "base/debug/leak_annotations.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/string_util.h"
+
+namespace base {
+
+namespace internal {
+
+struct InternedStringEntry {
+  InternedStringEntry(const StringPiece& str, size_t hash)
+      : str(str.data(), str.size()),
+        hash(hash),
+        next(NULL) {
+  }
+
+  const std::string str;
+  const size_t hash;
+
+  // The next entry in the same bucket.  Set before the entry is published,
+  // and never changed afterwards.
+  const InternedStringEntry* next;
+};
+
+}  // namespace internal
+
+namespace {
+
+using internal::InternedStringEntry;
+
+// The table is a fixed array of buckets, each a singly linked list that only
+// ever grows at its head.  Readers load the head and walk the immutable
+// links; writers publish a new head with a compare-and-swap.  Nothing is
+// ever removed, so there is nothing to reclaim and no ABA problem.
+//
+// The bucket count is fixed because the table can't be resized without a
+// lock.  Chrome interns a few thousand names, which keeps the lists short.
+class InternTable {
+ public:
+  InternTable() {
+    for (size_t i = 0; i < kBucketCount; ++i)
+      buckets_[i] = 0;
+  }
+
+  const InternedStringEntry* Find(const StringPiece& str, size_t hash) const {
+    return FindInList(Head(hash), str, hash, NULL);
+  }
+
+  const InternedStringEntry* Insert(const StringPiece& str, size_t hash) {
+    subtle::AtomicWord* bucket = &buckets_[BucketIndex(hash)];
+    const InternedStringEntry* head = Head(hash);
+    const InternedStringEntry* found = FindInList(head, str, hash, NULL);
+    if (found)
+      return found;
+
+    InternedStringEntry* entry = new InternedStringEntry(str, hash);
+    for (;;) {
+      entry->next = head;
+      subtle::AtomicWord old_head = subtle::Release_CompareAndSwap(
+          bucket,
+          reinterpret_cast<subtle::AtomicWord>(head),
+          reinterpret_cast<subtle::AtomicWord>(entry));
+      if (old_head == reinterpret_cast<subtle::AtomicWord>(head))
+        break;
+
+      // Another thread added to the bucket first.  It may have added the
+      // same string, so look again, but only through the new entries.
+      const InternedStringEntry* new_head =
+          reinterpret_cast<const InternedStringEntry*>(
+              subtle::Acquire_Load(bucket));
+      found = FindInList(new_head, str, hash, head);
+      if (found) {
+        delete entry;
+        return found;
+      }
+      head = new_head;
+    }
+    ANNOTATE_LEAKING_OBJECT_PTR(entry);
+    return entry;
+  }
+
+ private:
+  static const size_t kBucketCount = 4096;
+
+  static size_t BucketIndex(size_t hash) {
+    // The string hash mixes its high bits poorly into its low ones.
+    return (hash ^ (hash >> 12) ^ (hash >> 24)) & (kBucketCount - 1);
+  }
+
+  const InternedStringEntry* Head(size_t hash) const {
+    return reinterpret_cast<const InternedStringEntry*>(
+        subtle::Acquire_Load(&buckets_[BucketIndex(hash)]));
+  }
+
+  // Looks for |str| in the list from |entry| up to, but not including,
+  // |end|.
+  static const InternedStringEntry* FindInList(
+      const InternedStringEntry* entry,
+      const StringPiece& str,
+      size_t hash,
+      const InternedStringEntry* end) {
+    for (; entry != end; entry = entry->next) {
+      if (entry->hash == hash && StringPiece(entry->str) == str)
+        return entry;
+    }
+    return NULL;
+  }
+
+  subtle::AtomicWord buckets_[kBucketCount];
+
+  DISALLOW_COPY_AND_ASSIGN(InternTable);
+};
+
+LazyInstance<InternTable>::Leaky g_table = LAZY_INSTANCE_INITIALIZER;
+
+// The same hash as hash<std::string>.
+size_t HashString(const StringPiece& str) {
+  HASH_STRING_PIECE(StringPiece, str);
+}
+
+}  // namespace
+
+InternedString::InternedString(const StringPiece& str)
+    : entry_(str.empty() ? NULL : g_table.Get().Insert(str, HashString(str))) {
+}
+
+// static
+bool InternedString::Find(const StringPiece& str, InternedString* result) {
+  DCHECK(result);
+  if (str.empty()) {
+    *result = InternedString();
+    return true;
+  }
+  const InternedStringEntry* entry = g_table.Get().Find(str, HashString(str));
+  if (!entry)
+    return false;
+  *result = InternedString(entry);
+  return true;
+}
+
+const std::string& InternedString::as_string() const {
+  return entry_ ? entry_->str : EmptyString();
+}
+
+size_t InternedString::hash() const {
+  return entry_ ? entry_->hash : 0;
+}
+
+std::ostream& operator<<(std::ostream& out, const InternedString& str) {
+  return out << str.as_string();
+}
+
+}  // namespace base
@@ -0,0 +1,107 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// InternedString is a handle to a string kept in a process-wide table, with
+// one copy per distinct value.  Handles are the size of a pointer, copy for
+// free, compare equal exactly when their strings do, and carry a precomputed
+// hash, so maps keyed by them do no string allocation, hashing or comparison
+// on lookup.  Use them for keys that are looked up over and over, such as
+// preference paths and histogram names:
+//
+//   base::InternedString name("browser.show_home_button");
+//   base::hash_map<base::InternedString, Preference*> prefs;
+//   prefs[name] = pref;
+//
+// Strings are never removed from the table, so only intern values from a
+// bounded set, typically names that appear in the code.  Never intern strings
+// that come from the network, from web content or from other processes; use
+// Find(), which does not add to the table, to look those up.
+//
+// The table can be read and added to from any thread without locking.
+
+#ifndef BASE_INTERNED_STRING_H_
+#define BASE_INTERNED_STRING_H_
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+#include "base/base_export.h"
+#include "base/hash_tables.h"
+#include "base/string_piece.h"
+
+namespace base {
+
+namespace internal {
+struct InternedStringEntry;
+}
+
+class BASE_EXPORT InternedString {
+ public:
+  // The empty string.
+  InternedString() : entry_(NULL) {}
+
+  // Returns a handle to |str|, adding it to the table if needed.
+  explicit InternedString(const StringPiece& str);
+
+  // Looks up |str| without adding it to the table.  Returns false if it has
+  // never been interned, in which case no map keyed by InternedString can
+  // contain it.
+  static bool Find(const StringPiece& str, InternedString* result);
+
+  const std::string& as_string() const;
+  const char* c_str() const { return as_string().c_str(); }
+  size_t size() const { return as_string().size(); }
+  bool empty() const { return entry_ == NULL; }
+
+  // The hash<std::string> of the string, computed once when it was interned.
+  size_t hash() const;
+
+  bool operator==(const InternedString& other) const {
+    return entry_ == other.entry_;
+  }
+  bool operator!=(const InternedString& other) const {
+    return entry_ != other.entry_;
+  }
+
+  // Orders handles by address: consistent within a process, so usable as a
+  // std::map key, but not alphabetical.
+  bool operator<(const InternedString& other) const {
+    return entry_ < other.entry_;
+  }
+
+ private:
+  explicit InternedString(const internal::InternedStringEntry* entry)
+      : entry_(entry) {
+  }
+
+  // NULL for the empty string.
+  const internal::InternedStringEntry* entry_;
+};
+
+BASE_EXPORT std::ostream& operator<<(std::ostream& out,
+                                     const InternedString& str);
+
+}  // namespace base
+
+namespace BASE_HASH_NAMESPACE {
+#if defined(COMPILER_GCC)
+
+template<>
+struct hash<base::InternedString> {
+  std::size_t operator()(const base::InternedString& str) const {
+    return str.hash();
+  }
+};
+
+#elif defined(COMPILER_MSVC)
+
+inline size_t hash_value(const base::InternedString& str) {
+  return str.hash();
+}
+
+#endif  // COMPILER
+}  // namespace BASE_HASH_NAMESPACE
+
+#endif  // BASE_INTERNED_STRING_H_
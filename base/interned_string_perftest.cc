@@ -0,0 +1,81 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/hash_tables.h"
+#include "base/interned_string.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// About as many names as Chrome registers prefs.
+const int kNames = 2000;
+const int kLookups = 1000000;
+
+// Names shaped like pref paths, all longer than any small-string buffer.
+std::vector<std::string> MakeNames() {
+  std::vector<std::string> names;
+  for (int i = 0; i < kNames; ++i)
+    names.push_back(StringPrintf("browser.preference_%d.enabled", i));
+  return names;
+}
+
+void LogLookupTime(const char* name, const PerfTimer& timer) {
+  LogPerfResult(name,
+                timer.Elapsed().InMicroseconds() * 1000.0 / kLookups,
+                "ns/lookup");
+}
+
+}  // namespace
+
+// Compares looking a name given as a char* up in a string-keyed map, as
+// PrefService and StatisticsRecorder used to, with the interned equivalents.
+TEST(InternedStringPerfTest, Lookup) {
+  const std::vector<std::string> names = MakeNames();
+  std::vector<const char*> keys;
+  std::map<std::string, int> string_map;
+  hash_map<InternedString, int> interned_map;
+  std::vector<InternedString> interned_keys;
+  for (int i = 0; i < kNames; ++i) {
+    keys.push_back(names[i].c_str());
+    string_map[names[i]] = i;
+    interned_keys.push_back(InternedString(names[i]));
+    interned_map[interned_keys.back()] = i;
+  }
+
+  // Each lookup copies the key into a std::string, then compares strings
+  // down the tree.
+  int found = 0;
+  PerfTimer string_timer;
+  for (int i = 0; i < kLookups; ++i)
+    found += string_map.find(keys[i % kNames])->second;
+  LogLookupTime("InternedString_Lookup_StringMap", string_timer);
+
+  // Each lookup hashes the key once and compares it with one interned
+  // string, then probes the map with the precomputed hash.
+  PerfTimer find_timer;
+  for (int i = 0; i < kLookups; ++i) {
+    InternedString key;
+    InternedString::Find(keys[i % kNames], &key);
+    found -= interned_map.find(key)->second;
+  }
+  LogLookupTime("InternedString_Lookup_FindAndHashMap", find_timer);
+
+  // Callers that keep the handle skip the hashing too.
+  PerfTimer handle_timer;
+  for (int i = 0; i < kLookups; ++i)
+    found += interned_map.find(interned_keys[i % kNames])->second;
+  LogLookupTime("InternedString_Lookup_Handle", handle_timer);
+
+  EXPECT_EQ((kLookups / kNames) * (kNames * (kNames - 1) / 2), found);
+}
+
+}  // namespace base
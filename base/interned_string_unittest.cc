@@ -0,0 +1,118 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/interned_string.h"
+
+#include <vector>
+
+#include "base/memory/scoped_vector.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kThreads = 4;
+const int kStrings = 2000;
+
+// Interns the same strings as every other InternThread, in its own order.
+class InternThread : public DelegateSimpleThread::Delegate {
+ public:
+  explicit InternThread(int seed) : seed_(seed) {}
+
+  virtual void Run() OVERRIDE {
+    results_.resize(kStrings);
+    for (int i = 0; i < kStrings; ++i) {
+      int index = (i * 7 + seed_ * 331) % kStrings;
+      results_[index] = InternedString(StringPrintf("threaded.%d", index));
+    }
+  }
+
+  const std::vector<InternedString>& results() const { return results_; }
+
+ private:
+  int seed_;
+  std::vector<InternedString> results_;
+};
+
+}  // namespace
+
+TEST(InternedStringTest, Basic) {
+  InternedString a("InternedStringTest.a");
+  InternedString b("InternedStringTest.b");
+  std::string a_copy("InternedStringTest.a");
+  InternedString a2(a_copy);
+
+  EXPECT_EQ(a, a2);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a.c_str(), a2.c_str());
+  EXPECT_EQ("InternedStringTest.a", a.as_string());
+  EXPECT_EQ(a_copy.size(), a.size());
+  EXPECT_EQ(BASE_HASH_NAMESPACE::hash<std::string>()(a_copy), a.hash());
+  EXPECT_TRUE(a < b || b < a);
+}
+
+TEST(InternedStringTest, Empty) {
+  InternedString empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ("", empty.as_string());
+  EXPECT_EQ(empty, InternedString(""));
+  EXPECT_EQ(BASE_HASH_NAMESPACE::hash<std::string>()(""), empty.hash());
+
+  InternedString found(std::string("x"));
+  EXPECT_TRUE(InternedString::Find("", &found));
+  EXPECT_TRUE(found.empty());
+}
+
+TEST(InternedStringTest, EmbeddedNul) {
+  std::string with_nul("a\0b", 3);
+  InternedString str(with_nul);
+  EXPECT_EQ(with_nul, str.as_string());
+  EXPECT_NE(InternedString("a"), str);
+}
+
+TEST(InternedStringTest, Find) {
+  InternedString result;
+  EXPECT_FALSE(InternedString::Find("InternedStringTest.never", &result));
+  EXPECT_FALSE(InternedString::Find("InternedStringTest.never", &result));
+
+  InternedString interned("InternedStringTest.find");
+  EXPECT_TRUE(InternedString::Find("InternedStringTest.find", &result));
+  EXPECT_EQ(interned, result);
+}
+
+TEST(InternedStringTest, HashMap) {
+  hash_map<InternedString, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[InternedString(StringPrintf("map.%d", i))] = i;
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i, map[InternedString(StringPrintf("map.%d", i))]);
+  EXPECT_EQ(100u, map.size());
+}
+
+// Threads interning the same strings at the same time agree on the handles.
+TEST(InternedStringTest, Threaded) {
+  ScopedVector<InternThread> delegates;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    delegates.push_back(new InternThread(i));
+    threads.push_back(new DelegateSimpleThread(delegates[i], "Intern"));
+  }
+  for (int i = 0; i < kThreads; ++i)
+    threads[i]->Start();
+  for (int i = 0; i < kThreads; ++i)
+    threads[i]->Join();
+
+  for (int i = 0; i < kStrings; ++i) {
+    InternedString expected;
+    ASSERT_TRUE(InternedString::Find(StringPrintf("threaded.%d", i),
+                                     &expected));
+    for (int j = 0; j < kThreads; ++j)
+      EXPECT_EQ(expected, delegates[j]->results()[i]);
+  }
+}
+
+}  // namespace base
@@ -4,60 +4,134 @@
 
 #include "base/json/json_reader.h"
 
+#include <string.h>
+
+#include <vector>
+
 #include "base/float_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stringprintf.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
-#include "base/utf_string_conversions.h"
+#include "base/third_party/icu/icu_utf.h"
+#include "base/utf_string_conversion_utils.h"
 #include "base/values.h"
 
 namespace {
 
-const wchar_t kNullString[] = L"null";
-const wchar_t kTrueString[] = L"true";
-const wchar_t kFalseString[] = L"false";
+const char kNullString[] = "null";
+const char kTrueString[] = "true";
+const char kFalseString[] = "false";
 
 const int kStackLimit = 100;
 
-// A helper method for ParseNumberToken.  It reads an int from the end of
-// token.  The method returns false if there is no valid integer at the end of
-// the token.
-bool ReadInt(base::JSONReader::Token& token, bool can_have_leading_zeros) {
-  wchar_t first = token.NextChar();
-  int len = 0;
+// The UTF-8 encoding of U+FEFF.
+const char kUTF8ByteOrderMark[] = "\xEF\xBB\xBF";
+
+// Integers with no more digits than this always fit in an int.
+const int kMaxFastIntegerDigits = 9;
+
+// Like IsStringUTF8(), but for a piece of a string, and quicker on ASCII.
+bool IsUTF8(const base::StringPiece& input) {
+  const char* src = input.data();
+  int32 src_len = static_cast<int32>(input.length());
+  int32 char_index = 0;
+  while (char_index < src_len) {
+    if (static_cast<unsigned char>(src[char_index]) < 0x80) {
+      ++char_index;
+      continue;
+    }
+    int32 code_point;
+    CBU8_NEXT(src, char_index, src_len, code_point);
+    if (!base::IsValidCharacter(code_point))
+      return false;
+  }
+  return true;
+}
 
-  // Read in more digits.
-  wchar_t c = first;
-  while ('\0' != c && IsAsciiDigit(c)) {
-    ++token.length;
-    ++len;
-    c = token.NextChar();
+// Builds a Value from what JSONReader::Parse() reports.
+class ValueBuilder : public base::JSONReader::Delegate {
+ public:
+  ValueBuilder() {}
+  virtual ~ValueBuilder() {}
+
+  // Returns the root of the parsed value.  The caller owns it.
+  base::Value* Release() {
+    DCHECK(containers_.empty());
+    return root_.release();
   }
-  // We need at least 1 digit.
-  if (len == 0)
-    return false;
 
-  if (!can_have_leading_zeros && len > 1 && '0' == first)
-    return false;
+  virtual void OnNull() OVERRIDE {
+    Add(base::Value::CreateNullValue());
+  }
 
-  return true;
-}
+  virtual void OnBoolean(bool value) OVERRIDE {
+    Add(base::Value::CreateBooleanValue(value));
+  }
 
-// A helper method for ParseStringToken.  It reads |digits| hex digits from the
-// token. If the sequence if digits is not valid (contains other characters),
-// the method returns false.
-bool ReadHexDigits(base::JSONReader::Token& token, int digits) {
-  for (int i = 1; i <= digits; ++i) {
-    wchar_t c = *(token.begin + token.length + i);
-    if (c == '\0' || !IsHexDigit(c))
-      return false;
+  virtual void OnInteger(int value) OVERRIDE {
+    Add(base::Value::CreateIntegerValue(value));
   }
 
-  token.length += digits;
-  return true;
-}
+  virtual void OnDouble(double value) OVERRIDE {
+    Add(base::Value::CreateDoubleValue(value));
+  }
+
+  virtual void OnString(const base::StringPiece& value) OVERRIDE {
+    Add(base::Value::CreateStringValue(value.as_string()));
+  }
+
+  virtual void OnListBegin() OVERRIDE {
+    base::ListValue* list = new base::ListValue;
+    Add(list);
+    containers_.push_back(list);
+  }
+
+  virtual void OnListEnd() OVERRIDE {
+    containers_.pop_back();
+  }
+
+  virtual void OnDictionaryBegin() OVERRIDE {
+    base::DictionaryValue* dictionary = new base::DictionaryValue;
+    Add(dictionary);
+    containers_.push_back(dictionary);
+  }
+
+  virtual void OnDictionaryKey(const base::StringPiece& key) OVERRIDE {
+    key.CopyToString(&key_);
+  }
+
+  virtual void OnDictionaryEnd() OVERRIDE {
+    containers_.pop_back();
+  }
+
+ private:
+  // Adds |value| to the innermost list or dictionary, under the last key
+  // that was reported, or makes it the root if there is none.
+  void Add(base::Value* value) {
+    if (containers_.empty()) {
+      DCHECK(!root_.get());
+      root_.reset(value);
+    } else if (containers_.back()->IsType(base::Value::TYPE_LIST)) {
+      static_cast<base::ListValue*>(containers_.back())->Append(value);
+    } else {
+      static_cast<base::DictionaryValue*>(containers_.back())->
+          SetWithoutPathExpansion(key_, value);
+    }
+  }
+
+  // Owns everything that has been built so far, even if parsing fails.
+  scoped_ptr<base::Value> root_;
+
+  // The lists and dictionaries that are being filled, innermost last.
+  std::vector<base::Value*> containers_;
+
+  // The key for the next value added to a dictionary.
+  std::string key_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueBuilder);
+};
 
 }  // namespace
 
@@ -83,6 +157,8 @@ const char* JSONReader::kUnquotedDictionaryKey =
 JSONReader::JSONReader()
     : start_pos_(NULL),
       json_pos_(NULL),
+      end_pos_(NULL),
+      delegate_(NULL),
       stack_depth_(0),
       allow_trailing_comma_(false),
       error_code_(JSON_NO_ERROR),
@@ -147,45 +223,53 @@ std::string JSONReader::GetErrorMessage() const {
 
 Value* JSONReader::JsonToValue(const std::string& json, bool check_root,
                                bool allow_trailing_comma) {
+  // The input ends at the first null byte, if there is one.
+  ValueBuilder builder;
+  if (!Parse(StringPiece(json.c_str()), check_root, allow_trailing_comma,
+             &builder)) {
+    return NULL;
+  }
+  return builder.Release();
+}
+
+bool JSONReader::Parse(const StringPiece& json, bool check_root,
+                       bool allow_trailing_comma, Delegate* delegate) {
   // The input must be in UTF-8.
-  if (!IsStringUTF8(json.c_str())) {
+  if (!IsUTF8(json)) {
     error_code_ = JSON_UNSUPPORTED_ENCODING;
-    return NULL;
+    return false;
   }
 
-  // The conversion from UTF8 to wstring removes null bytes for us
-  // (a good thing).
-  std::wstring json_wide(UTF8ToWide(json));
-  start_pos_ = json_wide.c_str();
+  start_pos_ = json.data();
+  end_pos_ = json.data() + json.length();
 
   // When the input JSON string starts with a UTF-8 Byte-Order-Mark
-  // (0xEF, 0xBB, 0xBF), the UTF8ToWide() function converts it to a Unicode
-  // BOM (U+FEFF). To avoid the JSONReader::BuildValue() function from
-  // mis-treating a Unicode BOM as an invalid character and returning NULL,
-  // skip a converted Unicode BOM if it exists.
-  if (!json_wide.empty() && start_pos_[0] == 0xFEFF) {
-    ++start_pos_;
-  }
+  // (0xEF, 0xBB, 0xBF), skip it so that ParseValue() does not mis-treat it
+  // as an invalid character.
+  if (json.starts_with(kUTF8ByteOrderMark))
+    start_pos_ += arraysize(kUTF8ByteOrderMark) - 1;
 
   json_pos_ = start_pos_;
+  delegate_ = delegate;
   allow_trailing_comma_ = allow_trailing_comma;
   stack_depth_ = 0;
   error_code_ = JSON_NO_ERROR;
 
-  scoped_ptr<Value> root(BuildValue(check_root));
-  if (root.get()) {
+  if (ParseValue(check_root)) {
     if (ParseToken().type == Token::END_OF_INPUT) {
-      return root.release();
+      delegate_ = NULL;
+      return true;
     } else {
       SetErrorCode(JSON_UNEXPECTED_DATA_AFTER_ROOT, json_pos_);
     }
   }
+  delegate_ = NULL;
 
   // Default to calling errors "syntax errors".
   if (error_code_ == 0)
     SetErrorCode(JSON_SYNTAX_ERROR, json_pos_);
 
-  return NULL;
+  return false;
 }
 
 // static
@@ -198,11 +282,11 @@ std::string JSONReader::FormatErrorMessage(int line, int column,
   return description;
 }
 
-Value* JSONReader::BuildValue(bool is_root) {
+bool JSONReader::ParseValue(bool is_root) {
   ++stack_depth_;
   if (stack_depth_ > kStackLimit) {
     SetErrorCode(JSON_TOO_MUCH_NESTING, json_pos_);
-    return NULL;
+    return false;
   }
 
   Token token = ParseToken();
@@ -210,51 +294,49 @@ Value* JSONReader::BuildValue(bool is_root) {
   if (is_root && token.type != Token::OBJECT_BEGIN &&
       token.type != Token::ARRAY_BEGIN) {
     SetErrorCode(JSON_BAD_ROOT_ELEMENT_TYPE, json_pos_);
-    return NULL;
+    return false;
   }
 
-  scoped_ptr<Value> node;
-
   switch (token.type) {
     case Token::END_OF_INPUT:
     case Token::INVALID_TOKEN:
-      return NULL;
+      return false;
 
     case Token::NULL_TOKEN:
-      node.reset(Value::CreateNullValue());
+      delegate_->OnNull();
       break;
 
     case Token::BOOL_TRUE:
-      node.reset(Value::CreateBooleanValue(true));
+      delegate_->OnBoolean(true);
       break;
 
     case Token::BOOL_FALSE:
-      node.reset(Value::CreateBooleanValue(false));
+      delegate_->OnBoolean(false);
       break;
 
     case Token::NUMBER:
-      node.reset(DecodeNumber(token));
-      if (!node.get())
-        return NULL;
+      if (!DecodeNumber(token))
+        return false;
       break;
 
     case Token::STRING:
-      node.reset(DecodeString(token));
-      if (!node.get())
-        return NULL;
-      break;
+      {
+        StringPiece value;
+        if (!DecodeString(token, &value))
+          return false;
+        delegate_->OnString(value);
+        break;
+      }
 
     case Token::ARRAY_BEGIN:
       {
         json_pos_ += token.length;
         token = ParseToken();
 
-        node.reset(new ListValue());
+        delegate_->OnListBegin();
         while (token.type != Token::ARRAY_END) {
-          Value* array_node = BuildValue(false);
-          if (!array_node)
-            return NULL;
-          static_cast<ListValue*>(node.get())->Append(array_node);
+          if (!ParseValue(false))
+            return false;
 
           // After a list value, we expect a comma or the end of the list.
           token = ParseToken();
@@ -266,19 +348,20 @@ Value* JSONReader::BuildValue(bool is_root) {
             if (token.type == Token::ARRAY_END) {
               if (!allow_trailing_comma_) {
                 SetErrorCode(JSON_TRAILING_COMMA, json_pos_);
-                return NULL;
+                return false;
               }
               // Trailing comma OK, stop parsing the Array.
               break;
             }
           } else if (token.type != Token::ARRAY_END) {
             // Unexpected value after list value.  Bail out.
-            return NULL;
+            return false;
           }
         }
         if (token.type != Token::ARRAY_END) {
-          return NULL;
+          return false;
         }
+        delegate_->OnListEnd();
         break;
       }
 
@@ -287,33 +370,26 @@ Value* JSONReader::BuildValue(bool is_root) {
         json_pos_ += token.length;
         token = ParseToken();
 
-        node.reset(new DictionaryValue);
+        delegate_->OnDictionaryBegin();
         while (token.type != Token::OBJECT_END) {
           if (token.type != Token::STRING) {
             SetErrorCode(JSON_UNQUOTED_DICTIONARY_KEY, json_pos_);
-            return NULL;
+            return false;
           }
-          scoped_ptr<Value> dict_key_value(DecodeString(token));
-          if (!dict_key_value.get())
-            return NULL;
-
-          // Convert the key into a wstring.
-          std::string dict_key;
-          bool success = dict_key_value->GetAsString(&dict_key);
-          DCHECK(success);
+          StringPiece dict_key;
+          if (!DecodeString(token, &dict_key))
+            return false;
+          delegate_->OnDictionaryKey(dict_key);
 
           json_pos_ += token.length;
           token = ParseToken();
           if (token.type != Token::OBJECT_PAIR_SEPARATOR)
-            return NULL;
+            return false;
 
           json_pos_ += token.length;
           token = ParseToken();
-          Value* dict_value = BuildValue(false);
-          if (!dict_value)
-            return NULL;
-          static_cast<DictionaryValue*>(node.get())->SetWithoutPathExpansion(
-              dict_key, dict_value);
+          if (!ParseValue(false))
+            return false;
 
           // After a key/value pair, we expect a comma or the end of the
           // object.
@@ -326,101 +402,153 @@ Value* JSONReader::BuildValue(bool is_root) {
             if (token.type == Token::OBJECT_END) {
               if (!allow_trailing_comma_) {
                 SetErrorCode(JSON_TRAILING_COMMA, json_pos_);
-                return NULL;
+                return false;
               }
               // Trailing comma OK, stop parsing the Object.
               break;
             }
           } else if (token.type != Token::OBJECT_END) {
             // Unexpected value after last object value.  Bail out.
-            return NULL;
+            return false;
           }
         }
         if (token.type != Token::OBJECT_END)
-          return NULL;
+          return false;
 
+        delegate_->OnDictionaryEnd();
         break;
       }
 
     default:
       // We got a token that's not a value.
-      return NULL;
+      return false;
   }
   json_pos_ += token.length;
 
   --stack_depth_;
-  return node.release();
+  return true;
 }
 
 JSONReader::Token JSONReader::ParseNumberToken() {
   // We just grab the number here.  We validate the size in DecodeNumber.
   // According   to RFC4627, a valid number is: [minus] int [frac] [exp]
   Token token(Token::NUMBER, json_pos_, 0);
-  wchar_t c = *json_pos_;
+  char c = CharAt(json_pos_);
   if ('-' == c) {
     ++token.length;
-    c = token.NextChar();
+    c = NextChar(token);
   }
 
-  if (!ReadInt(token, false))
+  if (!ReadInt(&token, false))
     return Token::CreateInvalidToken();
 
   // Optional fraction part
-  c = token.NextChar();
+  c = NextChar(token);
   if ('.' == c) {
     ++token.length;
-    if (!ReadInt(token, true))
+    if (!ReadInt(&token, true))
       return Token::CreateInvalidToken();
-    c = token.NextChar();
+    c = NextChar(token);
   }
 
   // Optional exponent part
   if ('e' == c || 'E' == c) {
     ++token.length;
-    c = token.NextChar();
+    c = NextChar(token);
     if ('-' == c || '+' == c) {
       ++token.length;
-      c = token.NextChar();
+      c = NextChar(token);
     }
-    if (!ReadInt(token, true))
+    if (!ReadInt(&token, true))
       return Token::CreateInvalidToken();
   }
 
   return token;
 }
 
-Value* JSONReader::DecodeNumber(const Token& token) {
-  const std::wstring num_string(token.begin, token.length);
+bool JSONReader::ReadInt(Token* token, bool can_have_leading_zeros) {
+  char first = NextChar(*token);
+  int len = 0;
 
+  // Read in more digits.
+  char c = first;
+  while ('\0' != c && IsAsciiDigit(c)) {
+    ++token->length;
+    ++len;
+    c = NextChar(*token);
+  }
+  // We need at least 1 digit.
+  if (len == 0)
+    return false;
+
+  if (!can_have_leading_zeros && len > 1 && '0' == first)
+    return false;
+
+  return true;
+}
+
+bool JSONReader::ReadHexDigits(Token* token, int digits) {
+  for (int i = 1; i <= digits; ++i) {
+    char c = CharAt(token->begin + token->length + i);
+    if (c == '\0' || !IsHexDigit(c))
+      return false;
+  }
+
+  token->length += digits;
+  return true;
+}
+
+bool JSONReader::DecodeNumber(const Token& token) {
+  // Most numbers are small integers, which can be converted directly.
+  const char* pos = token.begin;
+  const char* end = token.begin + token.length;
+  bool negative = (*pos == '-');
+  if (negative)
+    ++pos;
+  if (end - pos <= kMaxFastIntegerDigits) {
+    int num_int = 0;
+    for (; pos < end && IsAsciiDigit(*pos); ++pos)
+      num_int = num_int * 10 + (*pos - '0');
+    if (pos == end) {
+      delegate_->OnInteger(negative ? -num_int : num_int);
+      return true;
+    }
+  }
+
+  StringPiece num_string(token.begin, token.length);
   int num_int;
-  if (StringToInt(WideToUTF8(num_string), &num_int))
-    return Value::CreateIntegerValue(num_int);
+  if (StringToInt(num_string, &num_int)) {
+    delegate_->OnInteger(num_int);
+    return true;
+  }
 
   double num_double;
-  if (StringToDouble(WideToUTF8(num_string), &num_double) &&
-      base::IsFinite(num_double))
-    return Value::CreateDoubleValue(num_double);
+  if (StringToDouble(num_string.as_string(), &num_double) &&
+      base::IsFinite(num_double)) {
+    delegate_->OnDouble(num_double);
+    return true;
+  }
 
-  return NULL;
+  return false;
 }
 
 JSONReader::Token JSONReader::ParseStringToken() {
   Token token(Token::STRING, json_pos_, 1);
-  wchar_t c = token.NextChar();
+  char c = NextChar(token);
   while ('\0' != c) {
     if ('\\' == c) {
       ++token.length;
-      c = token.NextChar();
+      c = NextChar(token);
       // Make sure the escaped char is valid.
       switch (c) {
         case 'x':
-          if (!ReadHexDigits(token, 2)) {
+          if (!ReadHexDigits(&token, 2)) {
             SetErrorCode(JSON_INVALID_ESCAPE, json_pos_ + token.length);
             return Token::CreateInvalidToken();
           }
           break;
         case 'u':
-          if (!ReadHexDigits(token, 4)) {
+          if (!ReadHexDigits(&token, 4)) {
             SetErrorCode(JSON_INVALID_ESCAPE, json_pos_ + token.length);
             return Token::CreateInvalidToken();
           }
@@ -444,81 +572,110 @@ JSONReader::Token JSONReader::ParseStringToken() {
       return token;
     }
     ++token.length;
-    c = token.NextChar();
+    c = NextChar(token);
   }
   return Token::CreateInvalidToken();
 }
 
-Value* JSONReader::DecodeString(const Token& token) {
-  std::wstring decoded_str;
-  decoded_str.reserve(token.length - 2);
+bool JSONReader::DecodeString(const Token& token, StringPiece* value) {
+  const char* begin = token.begin + 1;
+  const char* end = token.begin + token.length - 1;
 
-  for (int i = 1; i < token.length - 1; ++i) {
-    wchar_t c = *(token.begin + i);
-    if ('\\' == c) {
-      ++i;
-      c = *(token.begin + i);
-      switch (c) {
-        case '"':
-        case '/':
-        case '\\':
-          decoded_str.push_back(c);
-          break;
-        case 'b':
-          decoded_str.push_back('\b');
-          break;
-        case 'f':
-          decoded_str.push_back('\f');
-          break;
-        case 'n':
-          decoded_str.push_back('\n');
-          break;
-        case 'r':
-          decoded_str.push_back('\r');
-          break;
-        case 't':
-          decoded_str.push_back('\t');
-          break;
-        case 'v':
-          decoded_str.push_back('\v');
-          break;
+  // Most strings have no escapes and can be passed on as they are.
+  if (!memchr(begin, '\\', end - begin)) {
+    value->set(begin, end - begin);
+    return true;
+  }
 
-        case 'x':
-          decoded_str.push_back((HexDigitToInt(*(token.begin + i + 1)) << 4) +
-                                HexDigitToInt(*(token.begin + i + 2)));
-          i += 2;
-          break;
-        case 'u':
-          decoded_str.push_back((HexDigitToInt(*(token.begin + i + 1)) << 12 ) +
-                                (HexDigitToInt(*(token.begin + i + 2)) << 8) +
-                                (HexDigitToInt(*(token.begin + i + 3)) << 4) +
-                                HexDigitToInt(*(token.begin + i + 4)));
-          i += 4;
+  string_buffer_.clear();
+  string_buffer_.reserve(end - begin);
+  for (const char* pos = begin; pos < end; ++pos) {
+    char c = *pos;
+    if ('\\' != c) {
+      // Not escaped
+      string_buffer_.push_back(c);
+      continue;
+    }
+
+    ++pos;
+    c = *pos;
+    switch (c) {
+      case '"':
+      case '/':
+      case '\\':
+        string_buffer_.push_back(c);
+        break;
+      case 'b':
+        string_buffer_.push_back('\b');
+        break;
+      case 'f':
+        string_buffer_.push_back('\f');
+        break;
+      case 'n':
+        string_buffer_.push_back('\n');
+        break;
+      case 'r':
+        string_buffer_.push_back('\r');
+        break;
+      case 't':
+        string_buffer_.push_back('\t');
+        break;
+      case 'v':
+        string_buffer_.push_back('\v');
+        break;
+
+      case 'x':
+        WriteUnicodeCharacter((HexDigitToInt(pos[1]) << 4) +
+                              HexDigitToInt(pos[2]), &string_buffer_);
+        pos += 2;
+        break;
+      case 'u':
+        {
+          uint32 code_unit = (HexDigitToInt(pos[1]) << 12) +
+                             (HexDigitToInt(pos[2]) << 8) +
+                             (HexDigitToInt(pos[3]) << 4) +
+                             HexDigitToInt(pos[4]);
+          pos += 4;
+          // Escaped UTF-16 surrogate pairs make up a single character.
+          if (CBU16_IS_LEAD(code_unit) && end - pos > 6 &&
+              pos[1] == '\\' && pos[2] == 'u') {
+            uint32 trail = (HexDigitToInt(pos[3]) << 12) +
+                           (HexDigitToInt(pos[4]) << 8) +
+                           (HexDigitToInt(pos[5]) << 4) +
+                           HexDigitToInt(pos[6]);
+            if (CBU16_IS_TRAIL(trail)) {
+              code_unit = CBU16_GET_SUPPLEMENTARY(code_unit, trail);
+              pos += 6;
+            }
+          }
+          // Unpaired surrogates can't be encoded in UTF-8.
+          if (!IsValidCodepoint(code_unit))
+            code_unit = 0xFFFD;
+          WriteUnicodeCharacter(code_unit, &string_buffer_);
           break;
+        }
 
-        default:
-          // We should only have valid strings at this point.  If not,
-          // ParseStringToken didn't do it's job.
-          NOTREACHED();
-          return NULL;
-      }
-    } else {
-      // Not escaped
-      decoded_str.push_back(c);
+      default:
+        // We should only have valid strings at this point.  If not,
+        // ParseStringToken didn't do it's job.
+        NOTREACHED();
+        return false;
     }
   }
-  return Value::CreateStringValue(WideToUTF16Hack(decoded_str));
+  *value = string_buffer_;
+  return true;
 }
 
 JSONReader::Token JSONReader::ParseToken() {
   EatWhitespaceAndComments();
 
   Token token(Token::INVALID_TOKEN, 0, 0);
-  switch (*json_pos_) {
-    case '\0':
-      token.type = Token::END_OF_INPUT;
-      break;
+  if (json_pos_ == end_pos_) {
+    token.type = Token::END_OF_INPUT;
+    return token;
+  }
 
+  switch (*json_pos_) {
     case 'n':
       if (NextStringMatch(kNullString, arraysize(kNullString) - 1))
         token = Token(Token::NULL_TOKEN, json_pos_, 4);
@@ -580,7 +737,7 @@ JSONReader::Token JSONReader::ParseToken() {
 }
 
 void JSONReader::EatWhitespaceAndComments() {
-  while ('\0' != *json_pos_) {
+  while (json_pos_ < end_pos_) {
     switch (*json_pos_) {
       case ' ':
       case '\n':
@@ -601,14 +758,14 @@ void JSONReader::EatWhitespaceAndComments() {
 }
 
 bool JSONReader::EatComment() {
-  if ('/' != *json_pos_)
+  if ('/' != CharAt(json_pos_))
     return false;
 
-  wchar_t next_char = *(json_pos_ + 1);
+  char next_char = CharAt(json_pos_ + 1);
   if ('/' == next_char) {
     // Line comment, read until \n or \r
     json_pos_ += 2;
-    while ('\0' != *json_pos_) {
+    while (json_pos_ < end_pos_) {
       switch (*json_pos_) {
         case '\n':
         case '\r':
@@ -621,8 +778,8 @@ bool JSONReader::EatComment() {
   } else if ('*' == next_char) {
     // Block comment, read until */
     json_pos_ += 2;
-    while ('\0' != *json_pos_) {
-      if ('*' == *json_pos_ && '/' == *(json_pos_ + 1)) {
+    while (json_pos_ < end_pos_) {
+      if ('*' == *json_pos_ && '/' == CharAt(json_pos_ + 1)) {
         json_pos_ += 2;
         return true;
       }
@@ -634,18 +791,20 @@ bool JSONReader::EatComment() {
   return true;
 }
 
-bool JSONReader::NextStringMatch(const wchar_t* str, size_t length) {
-  return wcsncmp(json_pos_, str, length) == 0;
+bool JSONReader::NextStringMatch(const char* str, size_t length) {
+  return static_cast<size_t>(end_pos_ - json_pos_) >= length &&
+         strncmp(json_pos_, str, length) == 0;
 }
 
 void JSONReader::SetErrorCode(JsonParseError error,
-                              const wchar_t* error_pos) {
+                              const char* error_pos) {
   int line_number = 1;
   int column_number = 1;
 
-  // Figure out the line and column the error occured at.
-  for (const wchar_t* pos = start_pos_; pos != error_pos; ++pos) {
-    if (*pos == '\0') {
+  // Figure out the line and column the error occured at.  Columns are
+  // counted in characters, so UTF-8 continuation bytes are skipped.
+  for (const char* pos = start_pos_; pos != error_pos; ++pos) {
+    if (pos == end_pos_) {
       NOTREACHED();
       return;
     }
@@ -653,7 +812,7 @@ void JSONReader::SetErrorCode(JsonParseError error,
     if (*pos == '\n') {
       ++line_number;
       column_number = 1;
-    } else {
+    } else if ((*pos & 0xC0) != 0x80) {
       ++column_number;
     }
   }
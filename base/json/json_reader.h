@@ -3,7 +3,8 @@
 // found in the LICENSE file.
 //
 // A JSON parser.  Converts strings of JSON into a Value object (see
-// base/values.h).
+// base/values.h), or reports what they contain to a JSONReader::Delegate as
+// it reads them, without building any Values.
 // http://www.ietf.org/rfc/rfc4627.txt?number=4627
 //
 // Known limitations/deviations from the RFC:
@@ -18,8 +19,8 @@
 //   UTF-8 string for the JSONReader::JsonToValue() function may start with a
 //   UTF-8 BOM (0xEF, 0xBB, 0xBF).
 //   To avoid the function from mis-treating a UTF-8 BOM as an invalid
-//   character, the function skips a Unicode BOM at the beginning of the
-//   Unicode string (converted from the input UTF-8 string) before parsing it.
+//   character, the function skips a UTF-8 BOM at the beginning of the input
+//   before parsing it.
 //
 // TODO(tc): Add a parsing option to to relax object keys being wrapped in
 //   double quotes
@@ -33,6 +34,7 @@
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
+#include "base/string_piece.h"
 
 // Chromium and Chromium OS check out gtest to different places, so we're
 // unable to compile on both if we include gtest_prod.h here.  Instead, include
@@ -71,27 +73,51 @@ class BASE_EXPORT JSONReader {
      INVALID_TOKEN,
     };
 
-    Token(Type t, const wchar_t* b, int len)
+    Token(Type t, const char* b, int len)
         : type(t), begin(b), length(len) {}
 
-    // Get the character that's one past the end of this token.
-    wchar_t NextChar() {
-      return *(begin + length);
-    }
-
     static Token CreateInvalidToken() {
       return Token(INVALID_TOKEN, 0, 0);
     }
 
     Type type;
 
-    // A pointer into JSONReader::json_pos_ that's the beginning of this token.
-    const wchar_t* begin;
+    // A pointer into the input that's the beginning of this token.
+    const char* begin;
 
     // End should be one char past the end of the token.
     int length;
   };
 
+  // Receives the values of a JSON document from Parse(), in the order in
+  // which they appear.  A list's elements are reported between its
+  // OnListBegin() and OnListEnd(), and a dictionary's between its
+  // OnDictionaryBegin() and OnDictionaryEnd(), each preceded by its key.
+  //
+  // Strings and keys are passed as pieces of the input when they contain no
+  // escape sequences, and are only decoded into a buffer when they do.
+  // Either way, they are only valid until the method returns.
+  //
+  // If the input turns out to be malformed, Parse() stops calling the
+  // delegate and returns false; anything built from the values reported so
+  // far should be thrown away.
+  class BASE_EXPORT Delegate {
+   public:
+    virtual void OnNull() = 0;
+    virtual void OnBoolean(bool value) = 0;
+    virtual void OnInteger(int value) = 0;
+    virtual void OnDouble(double value) = 0;
+    virtual void OnString(const StringPiece& value) = 0;
+    virtual void OnListBegin() = 0;
+    virtual void OnListEnd() = 0;
+    virtual void OnDictionaryBegin() = 0;
+    virtual void OnDictionaryKey(const StringPiece& key) = 0;
+    virtual void OnDictionaryEnd() = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
   // Error codes during parsing.
   enum JsonParseError {
     JSON_NO_ERROR = 0,
@@ -136,7 +162,8 @@ class BASE_EXPORT JSONReader {
   // Returns an empty string if error_code is JSON_NO_ERROR.
   static std::string ErrorCodeToString(JsonParseError error_code);
 
-  // Returns the error code if the last call to JsonToValue() failed.
+  // Returns the error code if the last call to JsonToValue() or Parse()
+  // failed.
   // Returns JSON_NO_ERROR otherwise.
   JsonParseError error_code() const { return error_code_; }
 
@@ -154,6 +181,14 @@ class BASE_EXPORT JSONReader {
   Value* JsonToValue(const std::string& json, bool check_root,
                      bool allow_trailing_comma);
 
+  // Reads and parses |json| like JsonToValue(), but reports the values it
+  // contains to |delegate| instead of building a Value.  Returns false if
+  // |json| is not a properly formed JSON string, in which case a detailed
+  // error can be retrieved from |error_message()|.  Unlike JsonToValue(),
+  // |json| does not end at the first NUL character, if it has one.
+  bool Parse(const StringPiece& json, bool check_root,
+             bool allow_trailing_comma, Delegate* delegate);
+
  private:
   FRIEND_TEST_ALL_PREFIXES(JSONReaderTest, Reading);
   FRIEND_TEST_ALL_PREFIXES(JSONReaderTest, ErrorMessages);
@@ -161,10 +196,20 @@ class BASE_EXPORT JSONReader {
   static std::string FormatErrorMessage(int line, int column,
                                         const std::string& description);
 
-  // Recursively build Value.  Returns NULL if we don't have a valid JSON
-  // string.  If |is_root| is true, we verify that the root element is either
-  // an object or an array.
-  Value* BuildValue(bool is_root);
+  // Recursively parse a value, reporting it to |delegate_|.  Returns false if
+  // we don't have a valid JSON string.  If |is_root| is true, we verify that
+  // the root element is either an object or an array.
+  bool ParseValue(bool is_root);
+
+  // Returns the character at |pos|, or '\0' at the end of the input.
+  char CharAt(const char* pos) const {
+    return pos < end_pos_ ? *pos : '\0';
+  }
+
+  // Returns the character that's one past the end of |token|.
+  char NextChar(const Token& token) const {
+    return CharAt(token.begin + token.length);
+  }
 
   // Parses a sequence of characters into a Token::NUMBER. If the sequence of
   // characters is not a valid number, returns a Token::INVALID_TOKEN. Note
@@ -172,19 +217,26 @@ class BASE_EXPORT JSONReader {
   // int/double.
   Token ParseNumberToken();
 
-  // Try and convert the substring that token holds into an int or a double. If
-  // we can (ie., no overflow), return the value, else return NULL.
-  Value* DecodeNumber(const Token& token);
+  // Helpers for ParseNumberToken() and ParseStringToken().  They extend
+  // |token| by the digits following it, and return false if there are none
+  // or they are invalid.
+  bool ReadInt(Token* token, bool can_have_leading_zeros);
+  bool ReadHexDigits(Token* token, int digits);
+
+  // Try and convert the substring that token holds into an int or a double,
+  // and report it.  If we can't (ie., overflow), return false.
+  bool DecodeNumber(const Token& token);
 
   // Parses a sequence of characters into a Token::STRING. If the sequence of
   // characters is not a valid string, returns a Token::INVALID_TOKEN. Note
-  // that DecodeString is used to actually decode the escaped string into an
-  // actual wstring.
+  // that DecodeString is used to actually decode the escaped string.
   Token ParseStringToken();
 
-  // Convert the substring into a value string.  This should always succeed
-  // (otherwise ParseStringToken would have failed).
-  Value* DecodeString(const Token& token);
+  // Sets |value| to the contents of the string that |token| holds.  It points
+  // into the input if the string has no escape sequences, or into
+  // |string_buffer_| otherwise.  This should always succeed (otherwise
+  // ParseStringToken would have failed).
+  bool DecodeString(const Token& token, StringPiece* value);
 
   // Grabs the next token in the JSON stream.  This does not increment the
   // stream so it can be used to look ahead at the next token.
@@ -198,17 +250,26 @@ class BASE_EXPORT JSONReader {
   bool EatComment();
 
   // Checks if |json_pos_| matches str.
-  bool NextStringMatch(const wchar_t* str, size_t length);
+  bool NextStringMatch(const char* str, size_t length);
 
   // Sets the error code that will be returned to the caller. The current
   // line and column are determined and added into the final message.
-  void SetErrorCode(const JsonParseError error, const wchar_t* error_pos);
+  void SetErrorCode(const JsonParseError error, const char* error_pos);
 
   // Pointer to the starting position in the input string.
-  const wchar_t* start_pos_;
+  const char* start_pos_;
 
   // Pointer to the current position in the input string.
-  const wchar_t* json_pos_;
+  const char* json_pos_;
+
+  // Pointer to one past the end of the input string.
+  const char* end_pos_;
+
+  // Receives the values that are parsed.
+  Delegate* delegate_;
+
+  // Holds the last string that had to be unescaped.
+  std::string string_buffer_;
 
   // Used to keep track of how many nested lists/dicts there are.
   int stack_depth_;
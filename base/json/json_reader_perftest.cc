@@ -0,0 +1,97 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kIterations = 10;
+
+// The number of records in the generated document, which makes it about 4MB,
+// the size of a large preferences file or extension manifest bundle.
+const int kRecords = 20000;
+
+// Builds a list of dictionaries holding the kinds of values found in real
+// documents: short keys, numbers, booleans, and strings, a few of them
+// escaped.
+std::string BuildDocument() {
+  std::string json("[\n");
+  for (int i = 0; i < kRecords; ++i) {
+    base::StringAppendF(&json,
+        "  {\"id\": %d, \"name\": \"record number %d\", \"enabled\": %s,\n"
+        "   \"score\": %d.%d, \"path\": \"C:\\\\dir\\\\file%d.txt\",\n"
+        "   \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"parent\": null,\n"
+        "   \"description\": \"a fairly typical string value of medium "
+        "length\"}%s\n",
+        i, i, i % 2 ? "true" : "false", i, i % 100, i,
+        i + 1 < kRecords ? "," : "");
+  }
+  json += "]\n";
+  return json;
+}
+
+// Does nothing with the values, to measure the cost of parsing alone.
+class NullDelegate : public base::JSONReader::Delegate {
+ public:
+  NullDelegate() : values_(0) {}
+  virtual ~NullDelegate() {}
+
+  int values() const { return values_; }
+
+  virtual void OnNull() OVERRIDE { ++values_; }
+  virtual void OnBoolean(bool value) OVERRIDE { ++values_; }
+  virtual void OnInteger(int value) OVERRIDE { ++values_; }
+  virtual void OnDouble(double value) OVERRIDE { ++values_; }
+  virtual void OnString(const base::StringPiece& value) OVERRIDE {
+    ++values_;
+  }
+  virtual void OnListBegin() OVERRIDE {}
+  virtual void OnListEnd() OVERRIDE {}
+  virtual void OnDictionaryBegin() OVERRIDE {}
+  virtual void OnDictionaryKey(const base::StringPiece& key) OVERRIDE {}
+  virtual void OnDictionaryEnd() OVERRIDE {}
+
+ private:
+  int values_;
+};
+
+void LogThroughput(const char* name, size_t bytes,
+                   base::TimeDelta elapsed) {
+  LogPerfResult(name,
+                bytes * kIterations / elapsed.InSecondsF() / (1024 * 1024),
+                "MB/s");
+}
+
+}  // namespace
+
+TEST(JSONReaderPerfTest, Parse) {
+  std::string json(BuildDocument());
+
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    NullDelegate delegate;
+    base::JSONReader reader;
+    ASSERT_TRUE(reader.Parse(json, true, false, &delegate));
+    EXPECT_EQ(kRecords * 10, delegate.values());
+  }
+  LogThroughput("JSONReader_Parse", json.size(), timer.Elapsed());
+}
+
+TEST(JSONReaderPerfTest, Read) {
+  std::string json(BuildDocument());
+
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<base::Value> root(base::JSONReader::Read(json, false));
+    ASSERT_TRUE(root.get());
+  }
+  LogThroughput("JSONReader_Read", json.size(), timer.Elapsed());
+}
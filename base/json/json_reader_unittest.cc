@@ -5,6 +5,7 @@
 #include "testing/gtest/include/gtest/gtest.h"
 #include "base/json/json_reader.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/string_number_conversions.h"
 #include "base/string_piece.h"
 #include "base/utf_string_conversions.h"
 #include "base/values.h"
@@ -12,6 +13,58 @@
 
 namespace base {
 
+namespace {
+
+// Records what JSONReader::Parse() reports as a readable string, along with
+// whether each string it was given pointed into the input.
+class RecordingDelegate : public JSONReader::Delegate {
+ public:
+  explicit RecordingDelegate(const StringPiece& input)
+      : input_(input), in_situ_strings_(0) {}
+  virtual ~RecordingDelegate() {}
+
+  const std::string& events() const { return events_; }
+  int in_situ_strings() const { return in_situ_strings_; }
+
+  virtual void OnNull() OVERRIDE { events_ += "null "; }
+  virtual void OnBoolean(bool value) OVERRIDE {
+    events_ += value ? "true " : "false ";
+  }
+  virtual void OnInteger(int value) OVERRIDE {
+    events_ += "int:" + IntToString(value) + " ";
+  }
+  virtual void OnDouble(double value) OVERRIDE {
+    events_ += "double:" + DoubleToString(value) + " ";
+  }
+  virtual void OnString(const StringPiece& value) OVERRIDE {
+    RecordString("str:", value);
+  }
+  virtual void OnListBegin() OVERRIDE { events_ += "[ "; }
+  virtual void OnListEnd() OVERRIDE { events_ += "] "; }
+  virtual void OnDictionaryBegin() OVERRIDE { events_ += "{ "; }
+  virtual void OnDictionaryKey(const StringPiece& key) OVERRIDE {
+    RecordString("key:", key);
+  }
+  virtual void OnDictionaryEnd() OVERRIDE { events_ += "} "; }
+
+ private:
+  void RecordString(const char* prefix, const StringPiece& value) {
+    events_ += prefix;
+    value.AppendToString(&events_);
+    events_ += " ";
+    if (value.data() >= input_.data() &&
+        value.data() + value.size() <= input_.data() + input_.size()) {
+      ++in_situ_strings_;
+    }
+  }
+
+  StringPiece input_;
+  std::string events_;
+  int in_situ_strings_;
+};
+
+}  // namespace
+
 TEST(JSONReaderTest, Reading) {
   // some whitespace checking
   scoped_ptr<Value> root;
@@ -563,4 +616,61 @@ TEST(JSONReaderTest, ErrorMessages) {
   EXPECT_EQ(JSONReader::JSON_INVALID_ESCAPE, error_code);
 }
 
+TEST(JSONReaderTest, Parse) {
+  std::string input("{\"a\": [1, -2.5, true, null], \"b\\u0063\": \"d\","
+                    " \"e\": {}}");
+  RecordingDelegate delegate(input);
+  JSONReader reader;
+  EXPECT_TRUE(reader.Parse(input, true, false, &delegate));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  EXPECT_EQ("{ key:a [ int:1 double:-2.5 true null ] key:bc str:d key:e { } } ",
+            delegate.events());
+  // Only the escaped key had to be copied.
+  EXPECT_EQ(3, delegate.in_situ_strings());
+
+  // Scalars are allowed at the root if |check_root| is false.
+  RecordingDelegate scalar_delegate("");
+  EXPECT_FALSE(reader.Parse("\"x\"", true, false, &scalar_delegate));
+  EXPECT_EQ(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, reader.error_code());
+  EXPECT_TRUE(reader.Parse("\"x\"", false, false, &scalar_delegate));
+  EXPECT_EQ("str:x ", scalar_delegate.events());
+
+  // Parsing stops at the first error.
+  RecordingDelegate error_delegate("");
+  EXPECT_FALSE(reader.Parse("[1, 2,]", true, false, &error_delegate));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, reader.error_code());
+  EXPECT_EQ("[ int:1 int:2 ", error_delegate.events());
+
+  // Unlike JsonToValue(), Parse() doesn't stop at a NUL character.
+  std::string with_nul("[1]\0", 4);
+  RecordingDelegate nul_delegate(with_nul);
+  EXPECT_FALSE(reader.Parse(with_nul, true, false, &nul_delegate));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, reader.error_code());
+  scoped_ptr<Value> root(JSONReader().JsonToValue(with_nul, true, false));
+  EXPECT_TRUE(root.get());
+
+  // Only the given piece of the input is parsed.
+  std::string partial("[\"abc\"]trailing");
+  RecordingDelegate partial_delegate(partial);
+  EXPECT_TRUE(reader.Parse(StringPiece(partial.data(), 7), true, false,
+                           &partial_delegate));
+  EXPECT_EQ("[ str:abc ] ", partial_delegate.events());
+}
+
+TEST(JSONReaderTest, SurrogatePairs) {
+  // U+1D11E, MUSICAL SYMBOL G CLEF.
+  scoped_ptr<Value> root(JSONReader().JsonToValue("\"\\ud834\\udd1e\"",
+                                                  false, false));
+  ASSERT_TRUE(root.get());
+  std::string str_val;
+  EXPECT_TRUE(root->GetAsString(&str_val));
+  EXPECT_EQ("\xF0\x9D\x84\x9E", str_val);
+
+  // Unpaired surrogates are replaced.
+  root.reset(JSONReader().JsonToValue("\"\\ud834x\\udd1e\"", false, false));
+  ASSERT_TRUE(root.get());
+  EXPECT_TRUE(root->GetAsString(&str_val));
+  EXPECT_EQ("\xEF\xBF\xBDx\xEF\xBF\xBD", str_val);
+}
+
 }  // namespace base
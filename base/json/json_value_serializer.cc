@@ -9,6 +9,30 @@
 #include "base/json/json_writer.h"
 #include "base/string_util.h"
 
+namespace {
+
+// Writes JSON output to a file, and remembers whether any write failed.
+class FileSink : public base::JSONWriter::Sink {
+ public:
+  explicit FileSink(FILE* file) : file_(file), failed_(false) {}
+  virtual ~FileSink() {}
+
+  bool failed() const { return failed_; }
+
+  virtual void Append(const char* data, size_t length) OVERRIDE {
+    if (!failed_ && fwrite(data, 1, length, file_) != length)
+      failed_ = true;
+  }
+
+ private:
+  FILE* file_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileSink);
+};
+
+}  // namespace
+
 const char* JSONFileValueSerializer::kAccessDenied = "Access denied.";
 const char* JSONFileValueSerializer::kCannotReadFile = "Can't read file.";
 const char* JSONFileValueSerializer::kFileLocked = "File locked.";
@@ -61,22 +85,19 @@ bool JSONFileValueSerializer::SerializeAndOmitBinaryValues(const Value& root) {
 
 bool JSONFileValueSerializer::SerializeInternal(const Value& root,
                                                 bool omit_binary_values) {
-  std::string json_string;
-  JSONStringValueSerializer serializer(&json_string);
-  serializer.set_pretty_print(true);
-  bool result = omit_binary_values ?
-      serializer.SerializeAndOmitBinaryValues(root) :
-      serializer.Serialize(root);
-  if (!result)
-    return false;
-
-  int data_size = static_cast<int>(json_string.size());
-  if (file_util::WriteFile(json_file_path_,
-                           json_string.data(),
-                           data_size) != data_size)
+  // Stream the output to the file rather than building it up in memory.
+  FILE* file = file_util::OpenFile(json_file_path_, "wb");
+  if (!file)
     return false;
 
-  return true;
+  FileSink sink(file);
+  base::JSONWriter::WriteToSink(
+      &root,
+      true,
+      omit_binary_values ? base::JSONWriter::OPTIONS_OMIT_BINARY_VALUES : 0,
+      &sink);
+  bool closed = file_util::CloseFile(file);
+  return closed && !sink.failed();
 }
 
 int JSONFileValueSerializer::ReadFileToString(std::string* json_string) {
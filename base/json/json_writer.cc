@@ -4,12 +4,14 @@
 
 #include "base/json/json_writer.h"
 
-#include "base/json/string_escape.h"
+#include <math.h>
+
+#include "base/compiler_specific.h"
 #include "base/logging.h"
-#include "base/stringprintf.h"
-#include "base/string_number_conversions.h"
+#include "base/third_party/dmg_fp/dmg_fp.h"
+#include "base/third_party/icu/icu_utf.h"
+#include "base/utf_string_conversion_utils.h"
 #include "base/values.h"
-#include "base/utf_string_conversions.h"
 
 namespace base {
 
@@ -19,6 +21,39 @@ static const char kPrettyPrintLineEnding[] = "\r\n";
 static const char kPrettyPrintLineEnding[] = "\n";
 #endif
 
+namespace {
+
+const char kHexDigits[] = "0123456789ABCDEF";
+
+// Integral doubles with a smaller magnitude than this are exact, and are
+// written the way dmg_fp would write them unless they end in many zeros.
+const double kMaxFastIntegralDouble = 1e15;
+
+// Appends to a string.
+class StringSink : public JSONWriter::Sink {
+ public:
+  explicit StringSink(std::string* json) : json_(json) {}
+  virtual ~StringSink() {}
+
+  virtual void Append(const char* data, size_t length) OVERRIDE {
+    json_->append(data, length);
+  }
+
+ private:
+  std::string* json_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringSink);
+};
+
+// Returns true if |c| can't be written to a JSON string as it is.  Besides
+// what the JSON spec requires, < and > are escaped to prevent script
+// execution, and non-ASCII characters to keep the output ASCII.
+inline bool NeedsEscape(unsigned char c) {
+  return c < 32 || c > 126 || c == '"' || c == '\\' || c == '<' || c == '>';
+}
+
+}  // namespace
+
 /* static */
 const char* JSONWriter::kEmptyArray = "[]";
 
@@ -34,30 +69,40 @@ void JSONWriter::WriteWithOptions(const Value* const node,
                                   bool pretty_print,
                                   int options,
                                   std::string* json) {
+  DCHECK(json);
   json->clear();
-  // Is there a better way to estimate the size of the output?
-  json->reserve(1024);
-  JSONWriter writer(pretty_print, json);
+  StringSink sink(json);
+  WriteToSink(node, pretty_print, options, &sink);
+}
+
+/* static */
+void JSONWriter::WriteToSink(const Value* const node,
+                             bool pretty_print,
+                             int options,
+                             Sink* sink) {
   bool escape = !(options & OPTIONS_DO_NOT_ESCAPE);
   bool omit_binary_values = !!(options & OPTIONS_OMIT_BINARY_VALUES);
-  writer.BuildJSONString(node, 0, escape, omit_binary_values);
+  JSONWriter writer(pretty_print, escape, omit_binary_values, sink);
+  writer.BuildJSONString(node, 0);
   if (pretty_print)
-    json->append(kPrettyPrintLineEnding);
+    writer.Append(kPrettyPrintLineEnding);
+  writer.Flush();
 }
 
-JSONWriter::JSONWriter(bool pretty_print, std::string* json)
-    : json_string_(json),
-      pretty_print_(pretty_print) {
-  DCHECK(json);
+JSONWriter::JSONWriter(bool pretty_print, bool escape,
+                       bool omit_binary_values, Sink* sink)
+    : pretty_print_(pretty_print),
+      escape_(escape),
+      omit_binary_values_(omit_binary_values),
+      sink_(sink),
+      buffer_used_(0) {
+  DCHECK(sink);
 }
 
-void JSONWriter::BuildJSONString(const Value* const node,
-                                 int depth,
-                                 bool escape,
-                                 bool omit_binary_values) {
+void JSONWriter::BuildJSONString(const Value* const node, int depth) {
   switch (node->GetType()) {
     case Value::TYPE_NULL:
-      json_string_->append("null");
+      Append("null");
       break;
 
     case Value::TYPE_BOOLEAN:
@@ -65,7 +110,10 @@ void JSONWriter::BuildJSONString(const Value* const node,
         bool value;
         bool result = node->GetAsBoolean(&value);
         DCHECK(result);
-        json_string_->append(value ? "true" : "false");
+        if (value)
+          Append("true");
+        else
+          Append("false");
         break;
       }
 
@@ -74,7 +122,7 @@ void JSONWriter::BuildJSONString(const Value* const node,
         int value;
         bool result = node->GetAsInteger(&value);
         DCHECK(result);
-        base::StringAppendF(json_string_, "%d", value);
+        AppendInteger(value);
         break;
       }
 
@@ -83,24 +131,7 @@ void JSONWriter::BuildJSONString(const Value* const node,
         double value;
         bool result = node->GetAsDouble(&value);
         DCHECK(result);
-        std::string real = DoubleToString(value);
-        // Ensure that the number has a .0 if there's no decimal or 'e'.  This
-        // makes sure that when we read the JSON back, it's interpreted as a
-        // real rather than an int.
-        if (real.find('.') == std::string::npos &&
-            real.find('e') == std::string::npos &&
-            real.find('E') == std::string::npos) {
-          real.append(".0");
-        }
-        // The JSON spec requires that non-integer values in the range (-1,1)
-        // have a zero before the decimal point - ".52" is not valid, "0.52" is.
-        if (real[0] == '.') {
-          real.insert(0, "0");
-        } else if (real.length() > 1 && real[0] == '-' && real[1] == '.') {
-          // "-.1" bad "-0.1" good
-          real.insert(1, "0");
-        }
-        json_string_->append(real);
+        AppendDouble(value);
         break;
       }
 
@@ -109,94 +140,84 @@ void JSONWriter::BuildJSONString(const Value* const node,
         std::string value;
         bool result = node->GetAsString(&value);
         DCHECK(result);
-        if (escape) {
-          JsonDoubleQuote(UTF8ToUTF16(value), true, json_string_);
-        } else {
-          JsonDoubleQuote(value, true, json_string_);
-        }
+        AppendQuotedString(value, escape_);
         break;
       }
 
     case Value::TYPE_LIST:
       {
-        json_string_->append("[");
+        Append('[');
         if (pretty_print_)
-          json_string_->append(" ");
+          Append(' ');
 
         const ListValue* list = static_cast<const ListValue*>(node);
-        for (size_t i = 0; i < list->GetSize(); ++i) {
-          Value* value = NULL;
-          bool result = list->Get(i, &value);
-          DCHECK(result);
-
-          if (omit_binary_values && value->GetType() == Value::TYPE_BINARY) {
+        bool first_value = true;
+        for (ListValue::const_iterator it = list->begin(); it != list->end();
+             ++it) {
+          const Value* value = *it;
+          if (omit_binary_values_ && value->GetType() == Value::TYPE_BINARY)
             continue;
-          }
 
-          if (i != 0) {
-            json_string_->append(",");
+          if (!first_value) {
+            Append(',');
             if (pretty_print_)
-              json_string_->append(" ");
+              Append(' ');
           }
+          first_value = false;
 
-          BuildJSONString(value, depth, escape, omit_binary_values);
+          BuildJSONString(value, depth);
         }
 
         if (pretty_print_)
-          json_string_->append(" ");
-        json_string_->append("]");
+          Append(' ');
+        Append(']');
         break;
       }
 
     case Value::TYPE_DICTIONARY:
       {
-        json_string_->append("{");
+        Append('{');
         if (pretty_print_)
-          json_string_->append(kPrettyPrintLineEnding);
+          Append(kPrettyPrintLineEnding);
 
         const DictionaryValue* dict =
           static_cast<const DictionaryValue*>(node);
-        for (DictionaryValue::key_iterator key_itr = dict->begin_keys();
-             key_itr != dict->end_keys();
-             ++key_itr) {
-          Value* value = NULL;
-          bool result = dict->GetWithoutPathExpansion(*key_itr, &value);
-          DCHECK(result);
-
-          if (omit_binary_values && value->GetType() == Value::TYPE_BINARY) {
+        bool first_entry = true;
+        for (DictionaryValue::Iterator it(*dict); it.HasNext(); it.Advance()) {
+          const Value* value = &it.value();
+          if (omit_binary_values_ && value->GetType() == Value::TYPE_BINARY)
             continue;
-          }
 
-          if (key_itr != dict->begin_keys()) {
-            json_string_->append(",");
+          if (!first_entry) {
+            Append(',');
             if (pretty_print_)
-              json_string_->append(kPrettyPrintLineEnding);
+              Append(kPrettyPrintLineEnding);
           }
+          first_entry = false;
 
           if (pretty_print_)
             IndentLine(depth + 1);
-          AppendQuotedString(*key_itr);
+          // Keys are always escaped.
+          AppendQuotedString(it.key(), true);
           if (pretty_print_) {
-            json_string_->append(": ");
+            Append(": ");
           } else {
-            json_string_->append(":");
+            Append(':');
           }
-          BuildJSONString(value, depth + 1, escape, omit_binary_values);
+          BuildJSONString(value, depth + 1);
         }
 
         if (pretty_print_) {
-          json_string_->append(kPrettyPrintLineEnding);
+          Append(kPrettyPrintLineEnding);
           IndentLine(depth);
-          json_string_->append("}");
-        } else {
-          json_string_->append("}");
         }
+        Append('}');
         break;
       }
 
     case Value::TYPE_BINARY:
       {
-        if (!omit_binary_values) {
+        if (!omit_binary_values_) {
           NOTREACHED() << "Cannot serialize binary value.";
         }
         break;
@@ -207,16 +228,168 @@ void JSONWriter::BuildJSONString(const Value* const node,
   }
 }
 
-void JSONWriter::AppendQuotedString(const std::string& str) {
-  // TODO(viettrungluu): |str| is UTF-8, not ASCII, so to properly escape it we
-  // have to convert it to UTF-16. This round-trip is suboptimal.
-  JsonDoubleQuote(UTF8ToUTF16(str), true, json_string_);
+void JSONWriter::AppendQuotedString(const std::string& str, bool escape) {
+  Append('"');
+
+  const char* data = str.data();
+  int32 length = static_cast<int32>(str.length());
+  int32 i = 0;
+  while (i < length) {
+    // Copy runs of characters that need no escaping all at once.
+    int32 run_start = i;
+    while (i < length && !NeedsEscape(static_cast<unsigned char>(data[i])))
+      ++i;
+    Append(data + run_start, i - run_start);
+    if (i == length)
+      break;
+
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    switch (c) {
+      // WARNING: if you add a new case here, you need to update the reader as
+      // well.  Note: \v is in the reader, but not here since the JSON spec
+      // doesn't allow it.
+      case '\b':
+        Append("\\b");
+        break;
+      case '\f':
+        Append("\\f");
+        break;
+      case '\n':
+        Append("\\n");
+        break;
+      case '\r':
+        Append("\\r");
+        break;
+      case '\t':
+        Append("\\t");
+        break;
+      case '\\':
+        Append("\\\\");
+        break;
+      case '"':
+        Append("\\\"");
+        break;
+      default:
+        if (c < 0x80 || !escape) {
+          AppendUnicodeEscape(c);
+          break;
+        }
+        // Escape the UTF-16 code units of the character, the way
+        // JsonDoubleQuote() does for UTF8ToUTF16() of the string.
+        uint32 code_point;
+        if (!ReadUnicodeCharacter(data, length, &i, &code_point))
+          code_point = 0xFFFD;
+        if (CBU16_LENGTH(code_point) == 1) {
+          AppendUnicodeEscape(code_point);
+        } else {
+          // A surrogate pair.
+          AppendUnicodeEscape((code_point >> 10) + 0xD7C0);
+          AppendUnicodeEscape((code_point & 0x3FF) | 0xDC00);
+        }
+        break;
+    }
+    ++i;
+  }
+
+  Append('"');
+}
+
+void JSONWriter::AppendDouble(double value) {
+  // Integral values, like times, are common and don't need the general
+  // algorithm.  dmg_fp switches to exponent notation once there are more
+  // than five trailing zeros, so those are left to it, as are zeros, whose
+  // sign matters.
+  if (value != 0 && value > -kMaxFastIntegralDouble &&
+      value < kMaxFastIntegralDouble && value == floor(value)) {
+    int64 integer = static_cast<int64>(value);
+    if (integer % 1000000 != 0) {
+      AppendInteger(integer);
+      Append(".0");
+      return;
+    }
+  }
+
+  // According to g_fmt.cc, it is sufficient to declare a buffer of size 32.
+  // That leaves room for the two characters added below.
+  char buffer[32 + 2];
+  char* real = buffer + 1;
+  dmg_fp::g_fmt(real, value);
+  size_t length = strlen(real);
+
+  // The JSON spec requires that non-integer values in the range (-1,1)
+  // have a zero before the decimal point - ".52" is not valid, "0.52" is.
+  if (real[0] == '.') {
+    --real;
+    real[0] = '0';
+    ++length;
+  } else if (real[0] == '-' && real[1] == '.') {
+    // "-.1" bad "-0.1" good
+    --real;
+    real[0] = '-';
+    real[1] = '0';
+    ++length;
+  }
+  Append(real, length);
+
+  // Ensure that the number has a .0 if there's no decimal or 'e'.  This
+  // makes sure that when we read the JSON back, it's interpreted as a
+  // real rather than an int.
+  if (!memchr(real, '.', length) && !memchr(real, 'e', length) &&
+      !memchr(real, 'E', length)) {
+    Append(".0");
+  }
+}
+
+void JSONWriter::AppendInteger(int64 value) {
+  // Enough for the digits of any 64-bit int and a sign.
+  char buffer[24];
+  char* end = buffer + arraysize(buffer);
+  char* start = end;
+  // Work with the magnitude as an unsigned value, so that the most negative
+  // value works.
+  uint64 magnitude = value < 0 ? 0u - static_cast<uint64>(value) :
+                                 static_cast<uint64>(value);
+  do {
+    *--start = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    *--start = '-';
+  Append(start, end - start);
+}
+
+void JSONWriter::AppendUnicodeEscape(uint32 code_unit) {
+  char escape[6] = {
+    '\\',
+    'u',
+    kHexDigits[(code_unit >> 12) & 0xF],
+    kHexDigits[(code_unit >> 8) & 0xF],
+    kHexDigits[(code_unit >> 4) & 0xF],
+    kHexDigits[code_unit & 0xF],
+  };
+  Append(escape, arraysize(escape));
 }
 
 void JSONWriter::IndentLine(int depth) {
-  // It may be faster to keep an indent string so we don't have to keep
-  // reallocating.
-  json_string_->append(std::string(depth * 3, ' '));
+  for (int i = 0; i < depth * 3; ++i)
+    Append(' ');
+}
+
+void JSONWriter::Flush() {
+  if (buffer_used_)
+    sink_->Append(buffer_, buffer_used_);
+  buffer_used_ = 0;
+}
+
+void JSONWriter::AppendSlow(const char* data, size_t length) {
+  Flush();
+  if (length >= kBufferSize) {
+    // Long strings go straight through.
+    sink_->Append(data, length);
+    return;
+  }
+  memcpy(buffer_, data, length);
+  buffer_used_ = length;
 }
 
 }  // namespace base
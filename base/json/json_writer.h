@@ -6,6 +6,8 @@
 #define BASE_JSON_JSON_WRITER_H_
 #pragma once
 
+#include <string.h>
+
 #include <string>
 
 #include "base/base_export.h"
@@ -43,28 +45,93 @@ class BASE_EXPORT JSONWriter {
   static void WriteWithOptions(const Value* const node, bool pretty_print,
                                int options, std::string* json);
 
+  // Receives the output of WriteToSink() in chunks, as it's generated, so
+  // that large documents can be sent straight to a file or socket without
+  // being held in memory.
+  class BASE_EXPORT Sink {
+   public:
+    virtual void Append(const char* data, size_t length) = 0;
+
+   protected:
+    virtual ~Sink() {}
+  };
+
+  // Same as WriteWithOptions(), but passes the JSON string to |sink| instead
+  // of building it up in a string.
+  static void WriteToSink(const Value* const node, bool pretty_print,
+                          int options, Sink* sink);
+
   // A static, constant JSON string representing an empty array.  Useful
   // for empty JSON argument passing.
   static const char* kEmptyArray;
 
  private:
-  JSONWriter(bool pretty_print, std::string* json);
+  // The output is gathered into chunks of this size before being passed on.
+  enum { kBufferSize = 4096 };
+
+  JSONWriter(bool pretty_print, bool escape, bool omit_binary_values,
+             Sink* sink);
+
+  // Called recursively to build the JSON string.  The output is passed to
+  // |sink_| as it's generated, and the last of it by Flush().
+  void BuildJSONString(const Value* const node, int depth);
 
-  // Called recursively to build the JSON string.  Whe completed, value is
-  // json_string_ will contain the JSON.
-  void BuildJSONString(const Value* const node, int depth, bool escape,
-                       bool ignore_binary_values);
+  // Appends a quoted, escaped, version of (UTF-8) str to the output.  If
+  // |escape| is true, non-ASCII characters are escaped as UTF-16 code units,
+  // otherwise byte by byte.
+  void AppendQuotedString(const std::string& str, bool escape);
 
-  // Appends a quoted, escaped, version of (UTF-8) str to json_string_.
-  void AppendQuotedString(const std::string& str);
+  // Appends the shortest string that reads back as |value|, with a decimal
+  // point or exponent so that it reads back as a double rather than an int.
+  void AppendDouble(double value);
 
-  // Adds space to json_string_ for the indent level.
+  // Appends |value| in decimal.
+  void AppendInteger(int64 value);
+
+  // Appends a \uXXXX escape sequence for the UTF-16 code unit |code_unit|.
+  void AppendUnicodeEscape(uint32 code_unit);
+
+  // Adds space to the output for the indent level.
   void IndentLine(int depth);
 
-  // Where we write JSON data as we generate it.
-  std::string* json_string_;
+  // Appends |length| bytes of |data| to the output.
+  void Append(const char* data, size_t length) {
+    if (length > kBufferSize - buffer_used_) {
+      AppendSlow(data, length);
+      return;
+    }
+    memcpy(buffer_ + buffer_used_, data, length);
+    buffer_used_ += length;
+  }
+
+  // Appends a string literal to the output.
+  template <size_t N>
+  void Append(const char (&literal)[N]) {
+    Append(literal, N - 1);
+  }
+
+  void Append(char c) {
+    if (buffer_used_ == kBufferSize)
+      Flush();
+    buffer_[buffer_used_++] = c;
+  }
+
+  // Passes the contents of |buffer_| to |sink_|, and empties it.
+  void Flush();
+
+  // Handles Append() when |buffer_| doesn't have room for |data|.
+  void AppendSlow(const char* data, size_t length);
 
   bool pretty_print_;
+  bool escape_;
+  bool omit_binary_values_;
+
+  // Where we write JSON data as we generate it.
+  Sink* sink_;
+
+  // Output that hasn't been passed to |sink_| yet.
+  char buffer_[kBufferSize];
+  size_t buffer_used_;
 
   DISALLOW_COPY_AND_ASSIGN(JSONWriter);
 };
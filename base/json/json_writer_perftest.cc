@@ -0,0 +1,101 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kIterations = 10;
+
+// The number of records in the generated tree, which makes the JSON about
+// 4MB, the size of a large preferences file or trace.
+const int kRecords = 20000;
+
+// Builds a list of dictionaries holding the kinds of values found in real
+// documents: short keys, numbers, booleans, and strings, a few of them with
+// characters that have to be escaped.
+base::ListValue* BuildTree() {
+  base::ListValue* list = new base::ListValue;
+  for (int i = 0; i < kRecords; ++i) {
+    base::DictionaryValue* record = new base::DictionaryValue;
+    record->SetInteger("id", i);
+    record->SetString("name", base::StringPrintf("record number %d", i));
+    record->SetBoolean("enabled", i % 2 == 0);
+    record->SetDouble("score", i / 7.0);
+    record->SetDouble("last_modified", 1330000000000.0 + i * 1001);
+    record->SetString("path", base::StringPrintf("C:\\dir\\file%d.txt", i));
+    base::ListValue* tags = new base::ListValue;
+    tags->Append(base::Value::CreateStringValue("alpha"));
+    tags->Append(base::Value::CreateStringValue("beta"));
+    tags->Append(base::Value::CreateStringValue("gamma"));
+    record->Set("tags", tags);
+    record->Set("parent", base::Value::CreateNullValue());
+    record->SetString("description",
+                      "a fairly typical string value of medium length");
+    list->Append(record);
+  }
+  return list;
+}
+
+// Throws the output away, to measure the cost of generating it alone.
+class NullSink : public base::JSONWriter::Sink {
+ public:
+  NullSink() : size_(0) {}
+  virtual ~NullSink() {}
+
+  size_t size() const { return size_; }
+
+  virtual void Append(const char* data, size_t length) OVERRIDE {
+    size_ += length;
+  }
+
+ private:
+  size_t size_;
+};
+
+void LogThroughput(const std::string& name, size_t bytes,
+                   base::TimeDelta elapsed) {
+  LogPerfResult(name.c_str(),
+                bytes * kIterations / elapsed.InSecondsF() / (1024 * 1024),
+                "MB/s");
+}
+
+void RunWriteTest(bool pretty_print) {
+  scoped_ptr<base::Value> tree(BuildTree());
+  std::string json;
+
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i)
+    base::JSONWriter::Write(tree.get(), pretty_print, &json);
+  LogThroughput(base::StringPrintf("JSONWriter_Write%s",
+                                   pretty_print ? "_Pretty" : ""),
+                json.size(), timer.Elapsed());
+
+  PerfTimer sink_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    NullSink sink;
+    base::JSONWriter::WriteToSink(tree.get(), pretty_print, 0, &sink);
+    EXPECT_EQ(json.size(), sink.size());
+  }
+  LogThroughput(base::StringPrintf("JSONWriter_WriteToSink%s",
+                                   pretty_print ? "_Pretty" : ""),
+                json.size(), sink_timer.Elapsed());
+}
+
+}  // namespace
+
+TEST(JSONWriterPerfTest, Write) {
+  RunWriteTest(false);
+}
+
+TEST(JSONWriterPerfTest, WritePretty) {
+  RunWriteTest(true);
+}
@@ -119,6 +119,111 @@ TEST(JSONWriterTest, Writing) {
                                JSONWriter::OPTIONS_OMIT_BINARY_VALUES,
                                &output_js);
   ASSERT_EQ("{\"a\":5,\"c\":2}", output_js);
+
+  // Test omitting binary values at the start of a list or dictionary.
+  ListValue binary_first_list;
+  binary_first_list.Append(BinaryValue::CreateWithCopiedBuffer("asdf", 4));
+  binary_first_list.Append(Value::CreateIntegerValue(5));
+  JSONWriter::WriteWithOptions(&binary_first_list, false,
+                               JSONWriter::OPTIONS_OMIT_BINARY_VALUES,
+                               &output_js);
+  ASSERT_EQ("[5]", output_js);
+
+  DictionaryValue binary_first_dict;
+  binary_first_dict.Set("a", BinaryValue::CreateWithCopiedBuffer("asdf", 4));
+  binary_first_dict.Set("b", Value::CreateIntegerValue(5));
+  JSONWriter::WriteWithOptions(&binary_first_dict, false,
+                               JSONWriter::OPTIONS_OMIT_BINARY_VALUES,
+                               &output_js);
+  ASSERT_EQ("{\"b\":5}", output_js);
+}
+
+TEST(JSONWriterTest, Numbers) {
+  std::string output_js;
+  ListValue list;
+  list.Append(Value::CreateIntegerValue(0));
+  list.Append(Value::CreateIntegerValue(-42));
+  list.Append(Value::CreateIntegerValue(kint32max));
+  list.Append(Value::CreateIntegerValue(kint32min));
+  list.Append(Value::CreateDoubleValue(-3.0));
+  list.Append(Value::CreateDoubleValue(0.1));
+  list.Append(Value::CreateDoubleValue(-0.125));
+  list.Append(Value::CreateDoubleValue(1e100));
+  list.Append(Value::CreateDoubleValue(1.5e-7));
+  list.Append(Value::CreateDoubleValue(0.0));
+  list.Append(Value::CreateDoubleValue(-0.0));
+  list.Append(Value::CreateDoubleValue(1330000123456.0));
+  list.Append(Value::CreateDoubleValue(-100000.0));
+  list.Append(Value::CreateDoubleValue(1000000.0));
+  list.Append(Value::CreateDoubleValue(1e15 + 1));
+  JSONWriter::Write(&list, false, &output_js);
+  EXPECT_EQ("[0,-42,2147483647,-2147483648,-3.0,0.1,-0.125,1e+100,1.5e-07,"
+            "0.0,-0.0,1330000123456.0,-100000.0,1e+06,1000000000000001.0]",
+            output_js);
+}
+
+TEST(JSONWriterTest, Escaping) {
+  std::string output_js;
+  DictionaryValue dict;
+  dict.SetString("ascii", "a\"b\\c\b\f\n\r\t<>\x01");
+  // U+00E9 and U+1D11E.
+  dict.SetString("utf8", "\xC3\xA9\xF0\x9D\x84\x9E");
+  dict.SetString("\xC3\xA9", "key");
+  JSONWriter::Write(&dict, false, &output_js);
+  EXPECT_EQ("{\"ascii\":\"a\\\"b\\\\c\\b\\f\\n\\r\\t\\u003C\\u003E"
+            "\\u0001\","
+            "\"utf8\":\"\\u00E9\\uD834\\uDD1E\","
+            "\"\\u00E9\":\"key\"}",
+            output_js);
+
+  // With OPTIONS_DO_NOT_ESCAPE, values are escaped byte by byte, and keys as
+  // before.
+  JSONWriter::WriteWithOptions(&dict, false, JSONWriter::OPTIONS_DO_NOT_ESCAPE,
+                               &output_js);
+  EXPECT_EQ("{\"ascii\":\"a\\\"b\\\\c\\b\\f\\n\\r\\t\\u003C\\u003E"
+            "\\u0001\","
+            "\"utf8\":\"\\u00C3\\u00A9\\u00F0\\u009D\\u0084\\u009E\","
+            "\"\\u00E9\":\"key\"}",
+            output_js);
+}
+
+namespace {
+
+// Gathers what JSONWriter passes it, and counts the calls.
+class RecordingSink : public JSONWriter::Sink {
+ public:
+  RecordingSink() : appends_(0) {}
+  virtual ~RecordingSink() {}
+
+  const std::string& output() const { return output_; }
+  int appends() const { return appends_; }
+
+  virtual void Append(const char* data, size_t length) OVERRIDE {
+    output_.append(data, length);
+    ++appends_;
+  }
+
+ private:
+  std::string output_;
+  int appends_;
+};
+
+}  // namespace
+
+TEST(JSONWriterTest, WriteToSink) {
+  ListValue list;
+  for (int i = 0; i < 10000; ++i)
+    list.Append(Value::CreateStringValue("some string"));
+  list.Append(Value::CreateStringValue(std::string(100000, 'x')));
+
+  std::string output_js;
+  JSONWriter::Write(&list, true, &output_js);
+  RecordingSink sink;
+  JSONWriter::WriteToSink(&list, true, 0, &sink);
+  EXPECT_EQ(output_js, sink.output());
+  // The output is passed on in large chunks.
+  EXPECT_GT(sink.appends(), 1);
+  EXPECT_LT(sink.appends(), static_cast<int>(output_js.size() / 1000));
 }
 
 }  // namespace base
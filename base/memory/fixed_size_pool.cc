@@ -0,0 +1,332 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/fixed_size_pool.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/third_party/dynamic_annotations/dynamic_annotations.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+
+namespace {
+
+// Blocks get the same alignment as malloc gives on common platforms.
+const size_t kAlignment = 2 * sizeof(void*);
+
+// Blocks move between a thread's cache and the central free list this many
+// at a time.
+const int kBatchSize = 32;
+
+// A thread's cache gives a batch back once it holds more than this many bytes
+// of blocks, or two batches if that is more.  Small limits make a thread with
+// a steady working set bounce batches through the lock.
+const size_t kMaxCacheBytes = 32 * 1024;
+
+// A thread adds its counters to the pool's totals at least this often, in
+// allocations, so that the stats of a thread that runs from its cache stay
+// current.
+const int kFoldInterval = 4096;
+
+// Slabs are at least this big, and hold at least one batch.
+const size_t kMinSlabBytes = 16 * 1024;
+
+bool ShouldBypass() {
+#if defined(ADDRESS_SANITIZER)
+  return true;
+#else
+  return RunningOnValgrind() != 0;
+#endif
+}
+
+// Every pool that has been constructed, indexed by FixedSizePool::index_.
+// Destroyed pools leave a NULL behind, so that exiting threads don't give
+// blocks back to them.
+struct PoolList {
+  Lock lock;
+  std::vector<FixedSizePool*> pools;
+};
+
+LazyInstance<PoolList>::Leaky g_pool_list = LAZY_INSTANCE_INITIALIZER;
+
+// Holds each thread's FixedSizePool::ThreadCacheList.  Initialized when the
+// first pool is constructed, with |g_pool_list|'s lock held.
+ThreadLocalStorage::StaticSlot g_thread_caches = TLS_INITIALIZER;
+
+}  // namespace
+
+struct FixedSizePool::FreeBlock {
+  FreeBlock* next;
+};
+
+struct FixedSizePool::ThreadCache {
+  ThreadCache()
+      : head(NULL),
+        count(0),
+        allocations(0),
+        frees(0) {
+  }
+
+  FreeBlock* head;
+  int count;
+
+  // Operations since the counters were last folded into the pool's totals.
+  int allocations;
+  int frees;
+};
+
+FixedSizePool::FixedSizePool(const char* name, size_t object_size)
+    : name_(name),
+      object_size_(object_size),
+      block_size_((std::max(object_size, sizeof(FreeBlock)) + kAlignment - 1) &
+                  ~(kAlignment - 1)),
+      max_cached_blocks_(std::max(2 * kBatchSize,
+                                  static_cast<int>(kMaxCacheBytes /
+                                                   block_size_))),
+      bypass_(ShouldBypass()),
+      free_list_(NULL),
+      free_count_(0),
+      slabs_(NULL),
+      slab_bytes_(0),
+      allocations_(0),
+      frees_(0),
+      fallback_allocations_(0) {
+  AutoLock auto_lock(g_pool_list.Get().lock);
+  if (!g_thread_caches.initialized()) {
+    bool initialized = g_thread_caches.Initialize(&FixedSizePool::OnThreadExit);
+    CHECK(initialized);
+  }
+  std::vector<FixedSizePool*>& pools = g_pool_list.Get().pools;
+  index_ = pools.size();
+  pools.push_back(this);
+}
+
+FixedSizePool::~FixedSizePool() {
+  {
+    AutoLock auto_lock(g_pool_list.Get().lock);
+    g_pool_list.Get().pools[index_] = NULL;
+  }
+
+  // Other threads' caches are dropped when those threads exit.
+  ThreadCacheList* caches =
+      static_cast<ThreadCacheList*>(g_thread_caches.Get());
+  if (caches && index_ < caches->size()) {
+    delete (*caches)[index_];
+    (*caches)[index_] = NULL;
+  }
+
+  while (slabs_) {
+    void* next = *static_cast<void**>(slabs_);
+    free(slabs_);
+    slabs_ = next;
+  }
+}
+
+// static
+FixedSizePool* FixedSizePool::GetOrCreate(subtle::AtomicWord* pool,
+                                          const char* name,
+                                          size_t object_size) {
+  subtle::AtomicWord value = subtle::Acquire_Load(pool);
+  if (value)
+    return reinterpret_cast<FixedSizePool*>(value);
+
+  // Several threads may get here at once; the first to publish its pool wins
+  // and the others delete theirs, which nothing has used yet.
+  FixedSizePool* new_pool = new FixedSizePool(name, object_size);
+  value = subtle::Release_CompareAndSwap(
+      pool, 0, reinterpret_cast<subtle::AtomicWord>(new_pool));
+  if (value) {
+    delete new_pool;
+    return reinterpret_cast<FixedSizePool*>(value);
+  }
+  return new_pool;
+}
+
+void* FixedSizePool::Allocate(size_t size) {
+  if (size != object_size_ || bypass_) {
+    if (!bypass_)
+      subtle::NoBarrier_AtomicIncrement(&fallback_allocations_, 1);
+    return ::operator new(size);
+  }
+
+  ThreadCache* cache = GetThreadCache();
+  if (!cache->head)
+    Refill(cache);
+  FreeBlock* block = cache->head;
+  cache->head = block->next;
+  --cache->count;
+  if (++cache->allocations >= kFoldInterval) {
+    AutoLock auto_lock(lock_);
+    FoldCounters(cache);
+  }
+  return block;
+}
+
+void FixedSizePool::Free(void* object, size_t size) {
+  if (!object)
+    return;
+  if (size != object_size_ || bypass_) {
+    ::operator delete(object);
+    return;
+  }
+
+  ThreadCache* cache = GetThreadCache();
+  FreeBlock* block = static_cast<FreeBlock*>(object);
+  block->next = cache->head;
+  cache->head = block;
+  ++cache->count;
+  ++cache->frees;
+  if (cache->count > max_cached_blocks_)
+    Release(cache, kBatchSize);
+}
+
+// static
+void FixedSizePool::GetStats(std::string* output) {
+  output->append("------------------------------------------------\n");
+  output->append("Fixed-size pools\n");
+  output->append("------------------------------------------------\n");
+  StringAppendF(output, "%-24s %6s %8s %8s %12s %12s %10s\n", "Pool", "Size",
+                "Slab KB", "Free", "Allocations", "Frees", "Fallbacks");
+
+  AutoLock list_lock(g_pool_list.Get().lock);
+  const std::vector<FixedSizePool*>& pools = g_pool_list.Get().pools;
+  for (size_t i = 0; i < pools.size(); ++i) {
+    FixedSizePool* pool = pools[i];
+    if (!pool)
+      continue;
+    AutoLock pool_lock(pool->lock_);
+    StringAppendF(output,
+                  "%-24s %6u %8u %8d %12" PRId64 " %12" PRId64 " %10d\n",
+                  pool->name_,
+                  static_cast<unsigned>(pool->object_size_),
+                  static_cast<unsigned>(pool->slab_bytes_ / 1024),
+                  pool->free_count_,
+                  pool->allocations_,
+                  pool->frees_,
+                  subtle::NoBarrier_Load(&pool->fallback_allocations_));
+  }
+}
+
+FixedSizePool::ThreadCache* FixedSizePool::GetThreadCache() {
+  ThreadCacheList* caches =
+      static_cast<ThreadCacheList*>(g_thread_caches.Get());
+  if (caches && index_ < caches->size() && (*caches)[index_])
+    return (*caches)[index_];
+
+  if (!caches) {
+    caches = new ThreadCacheList;
+    g_thread_caches.Set(caches);
+  }
+  if (index_ >= caches->size())
+    caches->resize(index_ + 1);
+  ThreadCache* cache = new ThreadCache;
+  (*caches)[index_] = cache;
+  return cache;
+}
+
+void FixedSizePool::Refill(ThreadCache* cache) {
+  AutoLock auto_lock(lock_);
+  FoldCounters(cache);
+
+  if (!free_list_) {
+    // The slab's first block-aligned word links it to the previous slab.
+    size_t blocks = std::max(static_cast<size_t>(kBatchSize),
+                             (kMinSlabBytes - kAlignment) / block_size_);
+    size_t bytes = kAlignment + blocks * block_size_;
+    char* slab = static_cast<char*>(malloc(bytes));
+    CHECK(slab);
+    *reinterpret_cast<void**>(slab) = slabs_;
+    slabs_ = slab;
+    slab_bytes_ += bytes;
+
+    // Thread the blocks in address order, so a new slab is handed out
+    // sequentially.
+    for (size_t i = blocks; i > 0; --i) {
+      FreeBlock* block =
+          reinterpret_cast<FreeBlock*>(slab + kAlignment +
+                                       (i - 1) * block_size_);
+      block->next = free_list_;
+      free_list_ = block;
+    }
+    free_count_ += static_cast<int>(blocks);
+  }
+
+  // Detach up to a batch from the front of the central list.
+  FreeBlock* first = free_list_;
+  FreeBlock* last = first;
+  int count = 1;
+  while (count < kBatchSize && last->next) {
+    last = last->next;
+    ++count;
+  }
+  free_list_ = last->next;
+  free_count_ -= count;
+
+  last->next = cache->head;
+  cache->head = first;
+  cache->count += count;
+}
+
+void FixedSizePool::Release(ThreadCache* cache, int count) {
+  DCHECK_LE(count, cache->count);
+  if (count == 0)
+    return;
+
+  // Detach the first |count| blocks of the thread's list before locking.
+  FreeBlock* first = cache->head;
+  FreeBlock* last = first;
+  for (int i = 1; i < count; ++i)
+    last = last->next;
+  cache->head = last->next;
+  cache->count -= count;
+
+  AutoLock auto_lock(lock_);
+  FoldCounters(cache);
+  last->next = free_list_;
+  free_list_ = first;
+  free_count_ += count;
+}
+
+void FixedSizePool::FoldCounters(ThreadCache* cache) {
+  lock_.AssertAcquired();
+  allocations_ += cache->allocations;
+  frees_ += cache->frees;
+  cache->allocations = 0;
+  cache->frees = 0;
+}
+
+// static
+void FixedSizePool::OnThreadExit(void* value) {
+  ThreadCacheList* caches = static_cast<ThreadCacheList*>(value);
+  // Holding the list's lock keeps the pools from being destroyed meanwhile.
+  AutoLock list_lock(g_pool_list.Get().lock);
+  const std::vector<FixedSizePool*>& pools = g_pool_list.Get().pools;
+  for (size_t i = 0; i < caches->size(); ++i) {
+    ThreadCache* cache = (*caches)[i];
+    if (!cache)
+      continue;
+    // The blocks of a destroyed pool went with its slabs.
+    FixedSizePool* pool = pools[i];
+    if (pool) {
+      pool->Release(cache, cache->count);
+      if (cache->allocations || cache->frees) {
+        AutoLock auto_lock(pool->lock_);
+        pool->FoldCounters(cache);
+      }
+    }
+    delete cache;
+  }
+  delete caches;
+}
+
+}  // namespace base
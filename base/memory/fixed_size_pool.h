@@ -0,0 +1,168 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// FixedSizePool hands out blocks of one size, carved from large slabs, with a
+// cache of free blocks on each thread.  Allocating and freeing usually just
+// pop and push a per-thread list, without taking a lock or going through the
+// general-purpose heap.  That makes it worthwhile for small objects that are
+// created and destroyed at a high rate, like the nodes of a task queue.
+//
+// A class opts in by declaring a class-level operator new and delete:
+//
+//   // foo.h
+//   class Foo {
+//    public:
+//     DECLARE_POOLED_ALLOCATION();
+//     ...
+//   };
+//
+//   // foo.cc
+//   DEFINE_POOLED_ALLOCATION(Foo);
+//
+// Subclasses inherit the operators.  Blocks are sized for the class itself,
+// so subclasses that are larger fall back to the heap; to pool them too, they
+// need their own DECLARE/DEFINE.  Classes that are deleted through a base
+// pointer must have a virtual destructor, as usual, so that operator delete
+// is passed the right size.
+//
+// Memory in a pool's slabs is never returned to the system, only reused for
+// objects of the same size.  Pools are meant for types whose peak count is
+// modest, not for one-off bursts of millions of objects.
+//
+// Under AddressSanitizer and Valgrind, pools pass everything through to the
+// heap so that those tools still see each allocation.
+
+#ifndef BASE_MEMORY_FIXED_SIZE_POOL_H_
+#define BASE_MEMORY_FIXED_SIZE_POOL_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+class BASE_EXPORT FixedSizePool {
+ public:
+  // |name| must outlive the pool; it is normally a string literal.
+  FixedSizePool(const char* name, size_t object_size);
+
+  // Pools are normally leaked.  Destroying one frees its slabs, so all of its
+  // blocks must have been freed, and no other thread may be using it.
+  ~FixedSizePool();
+
+  // Returns the pool stored in |*pool|, creating it first if |*pool| is null.
+  // Safe to call from any thread; |*pool| is normally a function-level static
+  // initialized to 0.
+  static FixedSizePool* GetOrCreate(subtle::AtomicWord* pool,
+                                    const char* name,
+                                    size_t object_size);
+
+  // Allocates |size| bytes.  Comes from the pool if |size| is the pool's
+  // object size, and from the heap otherwise.  Never returns NULL.
+  void* Allocate(size_t size);
+
+  // Frees a block returned by Allocate(size).  |object| may be NULL.
+  void Free(void* object, size_t size);
+
+  // Appends a table of every pool's counters to |output|, for about:tcmalloc.
+  // Threads add their counters to the totals every few thousand operations,
+  // so the numbers may lag by that much per thread.
+  static void GetStats(std::string* output);
+
+  const char* name() const { return name_; }
+  size_t object_size() const { return object_size_; }
+
+ private:
+  struct FreeBlock;
+  struct ThreadCache;
+
+  // A thread's caches for every pool it has used, indexed by |index_|.  All
+  // pools share a single TLS slot that holds one of these.
+  typedef std::vector<ThreadCache*> ThreadCacheList;
+
+  // Returns this thread's cache, creating it on first use.
+  ThreadCache* GetThreadCache();
+
+  // Moves a batch of blocks from the central free list to |cache|, carving a
+  // new slab first if the list is empty.
+  void Refill(ThreadCache* cache);
+
+  // Moves |count| blocks from |cache| to the central free list.
+  void Release(ThreadCache* cache, int count);
+
+  // Adds the counters in |cache| to the totals and zeroes them.  Must be
+  // called with |lock_| held.
+  void FoldCounters(ThreadCache* cache);
+
+  // Destructor of the TLS slot; gives the exiting thread's blocks back to
+  // the pools that still exist.
+  static void OnThreadExit(void* value);
+
+  const char* const name_;
+  const size_t object_size_;
+
+  // Size of each block: |object_size_| rounded up to malloc's alignment.
+  const size_t block_size_;
+
+  // Most blocks a thread's cache holds before giving a batch back.
+  const int max_cached_blocks_;
+
+  // True to send everything to the heap, when running under memory tools.
+  const bool bypass_;
+
+  // Position of this pool in each thread's ThreadCacheList.  Not reused when
+  // the pool is destroyed.
+  size_t index_;
+
+  // Guards everything below.
+  Lock lock_;
+
+  // Blocks that no thread has cached.
+  FreeBlock* free_list_;
+  int free_count_;
+
+  // Slabs are chained through their first word so they can be freed.
+  void* slabs_;
+  size_t slab_bytes_;
+
+  int64 allocations_;
+  int64 frees_;
+
+  // Allocations of other sizes, passed to the heap.  Updated without the
+  // lock.
+  volatile subtle::Atomic32 fallback_allocations_;
+
+  DISALLOW_COPY_AND_ASSIGN(FixedSizePool);
+};
+
+}  // namespace base
+
+// Declares a class-level operator new and delete that use a FixedSizePool.
+// Goes in the public section of the class.
+#define DECLARE_POOLED_ALLOCATION() \
+  static void* operator new(size_t size); \
+  static void operator delete(void* object, size_t size); \
+  static base::FixedSizePool* GetAllocationPool()
+
+// Defines the operators declared above, with a pool named after |class_name|.
+// Goes at namespace scope in the class's .cc file.
+#define DEFINE_POOLED_ALLOCATION(class_name) \
+  base::FixedSizePool* class_name::GetAllocationPool() { \
+    static base::subtle::AtomicWord pool = 0; \
+    return base::FixedSizePool::GetOrCreate(&pool, #class_name, \
+                                            sizeof(class_name)); \
+  } \
+  void* class_name::operator new(size_t size) { \
+    return GetAllocationPool()->Allocate(size); \
+  } \
+  void class_name::operator delete(void* object, size_t size) { \
+    GetAllocationPool()->Free(object, size); \
+  }
+
+#endif  // BASE_MEMORY_FIXED_SIZE_POOL_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/memory/fixed_size_pool.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kRounds = 2000;
+
+// Objects alive at once, like the buffers and messages in flight on a busy
+// I/O thread.
+const int kLiveObjects = 100;
+
+// Allocates and frees |kLiveObjects| blocks of |size| bytes per round, from
+// |pool| or, if it is NULL, from the heap.
+class ChurnThread : public SimpleThread {
+ public:
+  ChurnThread(FixedSizePool* pool, size_t size)
+      : SimpleThread("ChurnThread"),
+        pool_(pool),
+        size_(size) {
+  }
+
+  virtual void Run() OVERRIDE {
+    std::vector<void*> objects(kLiveObjects);
+    for (int round = 0; round < kRounds; ++round) {
+      for (int i = 0; i < kLiveObjects; ++i) {
+        objects[i] = pool_ ? pool_->Allocate(size_) : ::operator new(size_);
+        *static_cast<char*>(objects[i]) = 0;
+      }
+      for (int i = 0; i < kLiveObjects; ++i) {
+        if (pool_)
+          pool_->Free(objects[i], size_);
+        else
+          ::operator delete(objects[i]);
+      }
+    }
+  }
+
+ private:
+  FixedSizePool* pool_;
+  size_t size_;
+};
+
+// Runs |threads| ChurnThreads at once and logs the cost per allocation.
+void RunChurnTest(size_t size, int threads, bool pooled) {
+  FixedSizePool pool("PerfTest", size);
+  std::vector<ChurnThread*> churners;
+  for (int i = 0; i < threads; ++i)
+    churners.push_back(new ChurnThread(pooled ? &pool : NULL, size));
+
+  PerfTimer timer;
+  for (int i = 0; i < threads; ++i)
+    churners[i]->Start();
+  for (int i = 0; i < threads; ++i) {
+    churners[i]->Join();
+    delete churners[i];
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = StringPrintf("FixedSizePool_%s_%dB_%dThreads",
+                                  pooled ? "Pool" : "Heap",
+                                  static_cast<int>(size), threads);
+  LogPerfResult(name.c_str(),
+                elapsed.InMicroseconds() * 1000.0 /
+                    (kRounds * kLiveObjects * threads),
+                "ns/alloc");
+}
+
+}  // namespace
+
+TEST(FixedSizePoolPerfTest, OneThread) {
+  const size_t kSizes[] = { 32, 64, 256 };
+  for (size_t i = 0; i < arraysize(kSizes); ++i) {
+    RunChurnTest(kSizes[i], 1, false);
+    RunChurnTest(kSizes[i], 1, true);
+  }
+}
+
+TEST(FixedSizePoolPerfTest, FourThreads) {
+  RunChurnTest(64, 4, false);
+  RunChurnTest(64, 4, true);
+}
+
+}  // namespace base
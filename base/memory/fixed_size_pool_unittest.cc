@@ -0,0 +1,185 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/fixed_size_pool.h"
+
+#include <string.h>
+
+#include <set>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/third_party/dynamic_annotations/dynamic_annotations.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class Pooled {
+ public:
+  DECLARE_POOLED_ALLOCATION();
+
+  explicit Pooled(int value) : value_(value) {}
+  virtual ~Pooled() {}
+
+  int value() const { return value_; }
+
+ private:
+  int value_;
+};
+
+DEFINE_POOLED_ALLOCATION(Pooled);
+
+// Bigger than Pooled, so it is allocated from the heap.
+class BigPooled : public Pooled {
+ public:
+  explicit BigPooled(int value) : Pooled(value) {
+    memset(padding_, 0, sizeof(padding_));
+  }
+
+ private:
+  char padding_[64];
+};
+
+// Frees every block in |blocks| and allocates as many again, checking that
+// they come from the same set.
+class PoolThread : public SimpleThread {
+ public:
+  PoolThread(FixedSizePool* pool, std::vector<void*>* blocks)
+      : SimpleThread("PoolThread"),
+        pool_(pool),
+        blocks_(blocks) {
+  }
+
+  virtual void Run() OVERRIDE {
+    for (size_t i = 0; i < blocks_->size(); ++i)
+      pool_->Free((*blocks_)[i], pool_->object_size());
+    for (size_t i = 0; i < blocks_->size(); ++i)
+      (*blocks_)[i] = pool_->Allocate(pool_->object_size());
+  }
+
+ private:
+  FixedSizePool* pool_;
+  std::vector<void*>* blocks_;
+};
+
+// Caches blocks of two pools, then waits to exit until |exit| is signaled.
+class TwoPoolThread : public SimpleThread {
+ public:
+  TwoPoolThread(FixedSizePool* first, FixedSizePool* second,
+                WaitableEvent* used, WaitableEvent* exit)
+      : SimpleThread("TwoPoolThread"),
+        first_(first),
+        second_(second),
+        used_(used),
+        exit_(exit) {
+  }
+
+  virtual void Run() OVERRIDE {
+    first_->Free(first_->Allocate(first_->object_size()),
+                 first_->object_size());
+    second_->Free(second_->Allocate(second_->object_size()),
+                  second_->object_size());
+    used_->Signal();
+    exit_->Wait();
+  }
+
+ private:
+  FixedSizePool* first_;
+  FixedSizePool* second_;
+  WaitableEvent* used_;
+  WaitableEvent* exit_;
+};
+
+}  // namespace
+
+TEST(FixedSizePoolTest, AllocateAndFree) {
+  FixedSizePool pool("Test", 24);
+  std::set<void*> blocks;
+  for (int i = 0; i < 1000; ++i) {
+    void* block = pool.Allocate(24);
+    ASSERT_TRUE(block);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block) % sizeof(void*));
+    memset(block, 0xAB, 24);
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+  for (std::set<void*>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+    pool.Free(*it, 24);
+
+  // Freed blocks are reused, unless the pool passes everything to the heap.
+  void* block = pool.Allocate(24);
+#if !defined(ADDRESS_SANITIZER)
+  if (!RunningOnValgrind())
+    EXPECT_EQ(1u, blocks.count(block));
+#endif
+  pool.Free(block, 24);
+  pool.Free(NULL, 24);
+}
+
+TEST(FixedSizePoolTest, OtherSizes) {
+  FixedSizePool pool("Test", 16);
+  void* small = pool.Allocate(8);
+  void* large = pool.Allocate(4096);
+  memset(large, 0, 4096);
+  pool.Free(small, 8);
+  pool.Free(large, 4096);
+}
+
+TEST(FixedSizePoolTest, ClassOperators) {
+  scoped_ptr<Pooled> pooled(new Pooled(1));
+  scoped_ptr<Pooled> big(new BigPooled(2));
+  EXPECT_EQ(1, pooled->value());
+  EXPECT_EQ(2, big->value());
+  EXPECT_EQ(sizeof(Pooled), Pooled::GetAllocationPool()->object_size());
+  EXPECT_EQ(Pooled::GetAllocationPool(), BigPooled::GetAllocationPool());
+
+  std::string stats;
+  FixedSizePool::GetStats(&stats);
+  EXPECT_NE(std::string::npos, stats.find("Pooled"));
+}
+
+// Blocks freed on one thread can be allocated on another, and a thread gives
+// back its cache when it exits.
+TEST(FixedSizePoolTest, Threads) {
+  const size_t kBlocks = 500;
+  FixedSizePool pool("Test", 40);
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < kBlocks; ++i)
+    blocks.push_back(pool.Allocate(40));
+
+  for (int round = 0; round < 3; ++round) {
+    PoolThread thread(&pool, &blocks);
+    thread.Start();
+    thread.Join();
+  }
+
+  std::set<void*> unique(blocks.begin(), blocks.end());
+  EXPECT_EQ(kBlocks, unique.size());
+  for (size_t i = 0; i < kBlocks; ++i)
+    pool.Free(blocks[i], 40);
+}
+
+// Pools share a TLS slot.  A thread that used several gives its blocks back
+// to each when it exits, except to those that were destroyed meanwhile.
+TEST(FixedSizePoolTest, ThreadExitAfterPoolDestroyed) {
+  FixedSizePool first("First", 24);
+  scoped_ptr<FixedSizePool> second(new FixedSizePool("Second", 48));
+  WaitableEvent used(false, false);
+  WaitableEvent exit(false, false);
+  TwoPoolThread thread(&first, second.get(), &used, &exit);
+  thread.Start();
+  used.Wait();
+  second.reset();
+  exit.Signal();
+  thread.Join();
+
+  void* block = first.Allocate(24);
+  EXPECT_TRUE(block);
+  first.Free(block, 24);
+}
+
+}  // namespace base
@@ -255,6 +255,14 @@ void MessageLoop::PostTask(
   AddToIncomingQueue(&pending_task);
 }
 
+void MessageLoop::PostTask(
+    const tracked_objects::Location& from_here, base::OnceClosure task) {
+  DCHECK(!task.is_null()) << from_here.ToString();
+  PendingTask pending_task(from_here, task.Pass(), CalculateDelayedRuntime(0),
+                           true);
+  AddToIncomingQueue(&pending_task);
+}
+
 void MessageLoop::PostDelayedTask(
     const tracked_objects::Location& from_here,
     const base::Closure& task,
@@ -272,6 +280,17 @@ void MessageLoop::PostDelayedTask(
   PostDelayedTask(from_here, task, delay.InMillisecondsRoundedUp());
 }
 
+void MessageLoop::PostDelayedTask(
+    const tracked_objects::Location& from_here,
+    base::OnceClosure task,
+    base::TimeDelta delay) {
+  DCHECK(!task.is_null()) << from_here.ToString();
+  PendingTask pending_task(
+      from_here, task.Pass(),
+      CalculateDelayedRuntime(delay.InMillisecondsRoundedUp()), true);
+  AddToIncomingQueue(&pending_task);
+}
+
 void MessageLoop::PostNonNestableTask(
     const tracked_objects::Location& from_here, const base::Closure& task) {
   DCHECK(!task.is_null()) << from_here.ToString();
@@ -362,9 +381,9 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 }
 
 void MessageLoop::AssertIdle() const {
-  // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
-  DCHECK(incoming_queue_.empty());
+  // We only check |incoming_queue_|, since |work_queue_| belongs to the loop's
+  // thread.
+  DCHECK(incoming_queue_.IsEmpty());
 }
 
 bool MessageLoop::is_running() const {
@@ -424,7 +443,7 @@ bool MessageLoop::ProcessNextDelayedNonNestableTask() {
   if (deferred_non_nestable_work_queue_.empty())
     return false;
 
-  PendingTask pending_task = deferred_non_nestable_work_queue_.front();
+  PendingTask pending_task(&deferred_non_nestable_work_queue_.front());
   deferred_non_nestable_work_queue_.pop();
 
   RunTask(pending_task);
@@ -465,9 +484,9 @@ void MessageLoop::RunTask(const PendingTask& pending_task) {
   nestable_tasks_allowed_ = true;
 }
 
-bool MessageLoop::DeferOrRunPendingTask(const PendingTask& pending_task) {
-  if (pending_task.nestable || state_->run_depth == 1) {
-    RunTask(pending_task);
+bool MessageLoop::DeferOrRunPendingTask(PendingTask* pending_task) {
+  if (pending_task->nestable || state_->run_depth == 1) {
+    RunTask(*pending_task);
     // Show that we ran a task (Note: a new one might arrive as a
     // consequence!).
     return true;
@@ -475,36 +494,33 @@ bool MessageLoop::DeferOrRunPendingTask(const PendingTask& pending_task) {
 
   // We couldn't run the task now because we're in a nested message loop
   // and the task isn't nestable.
-  deferred_non_nestable_work_queue_.push(pending_task);
+  deferred_non_nestable_work_queue_.PushByMove(pending_task);
   return false;
 }
 
-void MessageLoop::AddToDelayedWorkQueue(const PendingTask& pending_task) {
+void MessageLoop::AddToDelayedWorkQueue(PendingTask* pending_task) {
   // Move to the delayed work queue.  Initialize the sequence number
   // before inserting into the delayed_work_queue_.  The sequence number
   // is used to faciliate FIFO sorting when two tasks have the same
   // delayed_run_time value.
-  PendingTask new_pending_task(pending_task);
-  new_pending_task.sequence_num = next_sequence_num_++;
-  delayed_work_queue_.push(new_pending_task);
+  pending_task->sequence_num = next_sequence_num_++;
+  delayed_work_queue_.PushByMove(pending_task);
 }
 
 void MessageLoop::ReloadWorkQueue() {
   // We can improve performance of our loading tasks from incoming_queue_ to
   // work_queue_ by waiting until the last minute (work_queue_ is empty) to
-  // load.  That reduces the number of locks-per-task significantly when our
-  // queues get large.
+  // load.  That reduces the number of atomic operations per task significantly
+  // when our queues get large.
   if (!work_queue_.empty())
-    return;  // Wait till we *really* need to lock and load.
+    return;  // Wait till we *really* need to load.
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
-      return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
-  }
+  // Acquire all we can from the inter-thread queue.  If a producer was caught
+  // half way through a push, its task (and any pushed after it) stays behind,
+  // and that producer will not wake us since the queue wasn't empty when it
+  // started.  Schedule another pass ourselves so the task isn't stranded.
+  if (incoming_queue_.ReloadInto(&work_queue_))
+    pump_->ScheduleWork();
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -521,13 +537,13 @@ bool MessageLoop::DeletePendingTasks() {
         should_leak_tasks_ = false;
 #endif  // defined(OS_POSIX)
   while (!work_queue_.empty()) {
-    PendingTask pending_task = work_queue_.front();
+    PendingTask pending_task(&work_queue_.front());
     work_queue_.pop();
     if (!pending_task.delayed_run_time.is_null()) {
       // We want to delete delayed tasks in the same order in which they would
       // normally be deleted in case of any funny dependencies between delayed
       // tasks.
-      AddToDelayedWorkQueue(pending_task);
+      AddToDelayedWorkQueue(&pending_task);
     }
   }
   did_work |= !deferred_non_nestable_work_queue_.empty();
@@ -594,22 +610,15 @@ void MessageLoop::AddToIncomingQueue(PendingTask* pending_task) {
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
-
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(*pending_task);
-    pending_task->task.Reset();
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
-
-    pump = pump_;
-  }
   // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
+  // loop, we cannot touch |this| once the task has been pushed.  We use a
+  // stack-based reference to the message pump, taken beforehand, so that we
+  // can call ScheduleWork afterwards.
+  scoped_refptr<base::MessagePump> pump(pump_);
+
+  bool was_empty = incoming_queue_.Push(pending_task);
+  if (!was_empty)
+    return;  // Someone else should have started the sub-pump.
 
   pump->ScheduleWork();
 }
@@ -649,15 +658,15 @@ bool MessageLoop::DoWork() {
 
     // Execute oldest task.
     do {
-      PendingTask pending_task = work_queue_.front();
+      PendingTask pending_task(&work_queue_.front());
       work_queue_.pop();
       if (!pending_task.delayed_run_time.is_null()) {
-        AddToDelayedWorkQueue(pending_task);
+        AddToDelayedWorkQueue(&pending_task);
         // If we changed the topmost task, then it is time to reschedule.
-        if (delayed_work_queue_.top().task.Equals(pending_task.task))
+        if (delayed_work_queue_.top().sequence_num == pending_task.sequence_num)
           pump_->ScheduleDelayedWork(pending_task.delayed_run_time);
       } else {
-        if (DeferOrRunPendingTask(pending_task))
+        if (DeferOrRunPendingTask(&pending_task))
           return true;
       }
     } while (!work_queue_.empty());
@@ -689,13 +698,13 @@ bool MessageLoop::DoDelayedWork(TimeTicks* next_delayed_work_time) {
     }
   }
 
-  PendingTask pending_task = delayed_work_queue_.top();
+  PendingTask pending_task(&delayed_work_queue_.top());
   delayed_work_queue_.pop();
 
   if (!delayed_work_queue_.empty())
     *next_delayed_work_time = delayed_work_queue_.top().delayed_run_time;
 
-  return DeferOrRunPendingTask(pending_task);
+  return DeferOrRunPendingTask(&pending_task);
 }
 
 bool MessageLoop::DoIdleWork() {
@@ -12,12 +12,14 @@
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/callback_forward.h"
+#include "base/incoming_task_queue.h"
 #include "base/location.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop_helpers.h"
 #include "base/message_loop_proxy.h"
 #include "base/message_pump.h"
 #include "base/observer_list.h"
+#include "base/once_closure.h"
 #include "base/pending_task.h"
 #include "base/synchronization/lock.h"
 #include "base/tracking_info.h"
@@ -159,12 +161,20 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
   // The MessageLoop takes ownership of the Task, and deletes it after it has
   // been Run().
   //
+  // The variants that take a base::OnceClosure avoid the heap allocation and
+  // the reference counting of a base::Closure when the task is made with
+  // base::BindOnce().
+  //
   // NOTE: These methods may be called on any thread.  The Task will be invoked
   // on the thread that executes MessageLoop::Run().
   void PostTask(
       const tracked_objects::Location& from_here,
       const base::Closure& task);
 
+  void PostTask(
+      const tracked_objects::Location& from_here,
+      base::OnceClosure task);
+
   void PostDelayedTask(
       const tracked_objects::Location& from_here,
       const base::Closure& task, int64 delay_ms);
@@ -174,6 +184,11 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
       const base::Closure& task,
       base::TimeDelta delay);
 
+  void PostDelayedTask(
+      const tracked_objects::Location& from_here,
+      base::OnceClosure task,
+      base::TimeDelta delay);
+
   void PostNonNestableTask(
       const tracked_objects::Location& from_here,
       const base::Closure& task);
@@ -421,24 +436,25 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
   // Runs the specified PendingTask.
   void RunTask(const base::PendingTask& pending_task);
 
-  // Calls RunTask or queues the pending_task on the deferred task list if it
+  // Calls RunTask or moves the pending_task onto the deferred task list if it
   // cannot be run right now.  Returns true if the task was run.
-  bool DeferOrRunPendingTask(const base::PendingTask& pending_task);
+  bool DeferOrRunPendingTask(base::PendingTask* pending_task);
 
-  // Adds the pending task to delayed_work_queue_.
-  void AddToDelayedWorkQueue(const base::PendingTask& pending_task);
+  // Moves the pending task into delayed_work_queue_, leaving
+  // pending_task->task null.
+  void AddToDelayedWorkQueue(base::PendingTask* pending_task);
 
   // Adds the pending task to our incoming_queue_.
   //
   // Caller retains ownership of |pending_task|, but this function will
-  // reset the value of pending_task->task.  This is needed to ensure
-  // that the posting call stack does not retain pending_task->task
-  // beyond this function call.
+  // move pending_task->task into the queue, leaving it null.  This is needed
+  // to ensure that the posting call stack does not retain pending_task->task
+  // beyond this function call, and avoids refcount traffic on the closure.
   void AddToIncomingQueue(base::PendingTask* pending_task);
 
   // Load tasks from the incoming_queue_ into work_queue_ if the latter is
-  // empty.  The former requires a lock to access, while the latter is directly
-  // accessible on this thread.
+  // empty.  The former is shared with posting threads, while the latter is
+  // directly accessible on this thread.
   void ReloadWorkQueue();
 
   // Delete tasks that haven't run yet without running them.  Used in the
@@ -494,13 +510,10 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
   // A profiling histogram showing the counts of various messages and events.
   base::Histogram* message_histogram_;
 
-  // A null terminated list which creates an incoming_queue of tasks that are
-  // acquired under a mutex for processing on this instance's thread. These
-  // tasks have not yet been sorted out into items for our work_queue_ vs items
-  // that will be handled by the TimerManager.
-  base::TaskQueue incoming_queue_;
-  // Protect access to incoming_queue_.
-  mutable base::Lock incoming_queue_lock_;
+  // A lock-free queue of tasks posted from any thread for processing on this
+  // instance's thread. These tasks have not yet been sorted out into items for
+  // our work_queue_ vs items that will be handled by the TimerManager.
+  base::IncomingTaskQueue incoming_queue_;
 
   RunState* state_;
 
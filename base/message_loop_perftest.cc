@@ -0,0 +1,183 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kTotalPosts = 320000;
+
+// Counts tasks run on the target loop and signals once all have arrived.
+class TaskCounter {
+ public:
+  TaskCounter(int expected, base::WaitableEvent* done)
+      : expected_(expected), count_(0), done_(done) {
+  }
+
+  void Increment() {
+    if (++count_ == expected_)
+      done_->Signal();
+  }
+
+ private:
+  const int expected_;
+  int count_;  // Only touched on the target loop's thread.
+  base::WaitableEvent* done_;
+};
+
+// Waits for |start| and then posts |count| tasks to |target|.
+class Poster : public base::DelegateSimpleThread::Delegate {
+ public:
+  Poster(MessageLoop* target, TaskCounter* counter, int count,
+         base::WaitableEvent* start)
+      : target_(target), counter_(counter), count_(count), start_(start) {
+  }
+
+  virtual void Run() OVERRIDE {
+    start_->Wait();
+    for (int i = 0; i < count_; ++i) {
+      target_->PostTask(FROM_HERE,
+                        base::Bind(&TaskCounter::Increment,
+                                   base::Unretained(counter_)));
+    }
+  }
+
+ private:
+  MessageLoop* target_;
+  TaskCounter* counter_;
+  int count_;
+  base::WaitableEvent* start_;
+};
+
+// Posts kTotalPosts tasks, split evenly across |num_producers| threads, to a
+// loop of type |type| and logs the sustained post rate.
+void RunPostTaskTest(MessageLoop::Type type, const char* type_name,
+                     int num_producers) {
+  base::Thread target("MessageLoopPerfTestTarget");
+  base::Thread::Options options;
+  options.message_loop_type = type;
+  ASSERT_TRUE(target.StartWithOptions(options));
+
+  const int posts_per_producer = kTotalPosts / num_producers;
+  base::WaitableEvent start(true, false);
+  base::WaitableEvent done(false, false);
+  TaskCounter counter(posts_per_producer * num_producers, &done);
+
+  ScopedVector<Poster> posters;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int i = 0; i < num_producers; ++i) {
+    posters.push_back(new Poster(target.message_loop(), &counter,
+                                 posts_per_producer, &start));
+    threads.push_back(new base::DelegateSimpleThread(
+        posters[i], "MessageLoopPerfTestPoster"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  done.Wait();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  for (int i = 0; i < num_producers; ++i)
+    threads[i]->Join();
+  target.Stop();
+
+  std::string name = base::StringPrintf("MessageLoop_%s_PostTask_%d_producers",
+                                        type_name, num_producers);
+  LogPerfResult(name.c_str(),
+                posts_per_producer * num_producers / elapsed.InSecondsF(),
+                "posts/s");
+}
+
+const int kProducerCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+const int kSingleThreadTasks = 1000000;
+
+void Increment(int* count) {
+  ++*count;
+}
+
+}  // namespace
+
+TEST(MessageLoopPerfTest, PostTaskDefault) {
+  for (size_t i = 0; i < arraysize(kProducerCounts); ++i)
+    RunPostTaskTest(MessageLoop::TYPE_DEFAULT, "Default", kProducerCounts[i]);
+}
+
+TEST(MessageLoopPerfTest, PostTaskIO) {
+  for (size_t i = 0; i < arraysize(kProducerCounts); ++i)
+    RunPostTaskTest(MessageLoop::TYPE_IO, "IO", kProducerCounts[i]);
+}
+
+// Measures the per-task cost of each stage of posting a task to the current
+// thread's loop: binding the closure, posting it, and running it.
+TEST(MessageLoopPerfTest, BindPostTaskRun) {
+  MessageLoop loop;
+  int count = 0;
+
+  PerfTimer bind_timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i) {
+    base::Closure task = base::Bind(&Increment, &count);
+  }
+  LogPerfResult("MessageLoop_Bind",
+                bind_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+
+  PerfTimer post_timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i)
+    loop.PostTask(FROM_HERE, base::Bind(&Increment, &count));
+  LogPerfResult("MessageLoop_BindAndPostTask",
+                post_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+
+  PerfTimer run_timer;
+  loop.RunAllPending();
+  LogPerfResult("MessageLoop_RunTask",
+                run_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+  EXPECT_EQ(kSingleThreadTasks, count);
+}
+
+// Same as above, with closures made by BindOnce(), which are stored inline
+// and moved through the queues without allocating or reference counting.
+TEST(MessageLoopPerfTest, BindOncePostTaskRun) {
+  MessageLoop loop;
+  int count = 0;
+
+  PerfTimer bind_timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i) {
+    base::OnceClosure task = base::BindOnce(&Increment, &count);
+  }
+  LogPerfResult("MessageLoop_BindOnce",
+                bind_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+
+  PerfTimer post_timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i)
+    loop.PostTask(FROM_HERE, base::BindOnce(&Increment, &count));
+  LogPerfResult("MessageLoop_BindOnceAndPostTask",
+                post_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+
+  PerfTimer run_timer;
+  loop.RunAllPending();
+  LogPerfResult("MessageLoop_RunOnceTask",
+                run_timer.Elapsed().InMillisecondsF() * 1000000 /
+                    kSingleThreadTasks,
+                "ns/task");
+  EXPECT_EQ(kSingleThreadTasks, count);
+}
@@ -285,6 +285,32 @@ void RunTest_PostDelayedTask_InPostOrder_3(
   EXPECT_TRUE(run_time2 > run_time1);
 }
 
+void RunTest_PostOnceClosure(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  // Test that tasks made with BindOnce() run like others: delayed ones in
+  // delay order, after the ones that aren't delayed.
+  int num_tasks = 3;
+  Time run_time1, run_time2, run_time3;
+
+  loop.PostDelayedTask(
+      FROM_HERE, base::BindOnce(&RecordRunTimeFunc, &run_time1, &num_tasks),
+      TimeDelta::FromMilliseconds(200));
+  loop.PostDelayedTask(
+      FROM_HERE, base::BindOnce(&RecordRunTimeFunc, &run_time2, &num_tasks),
+      TimeDelta::FromMilliseconds(10));
+  base::OnceClosure task =
+      base::BindOnce(&RecordRunTimeFunc, &run_time3, &num_tasks);
+  loop.PostTask(FROM_HERE, task.Pass());
+  EXPECT_TRUE(task.is_null());
+
+  loop.Run();
+  EXPECT_EQ(0, num_tasks);
+
+  EXPECT_TRUE(run_time3 < run_time2);
+  EXPECT_TRUE(run_time2 < run_time1);
+}
+
 void RunTest_PostDelayedTask_SharedTimer(
     MessageLoop::Type message_loop_type) {
   MessageLoop loop(message_loop_type);
@@ -1308,6 +1334,12 @@ TEST(MessageLoopTest, PostDelayedTask_InPostOrder_3) {
   RunTest_PostDelayedTask_InPostOrder_3(MessageLoop::TYPE_IO);
 }
 
+TEST(MessageLoopTest, PostOnceClosure) {
+  RunTest_PostOnceClosure(MessageLoop::TYPE_DEFAULT);
+  RunTest_PostOnceClosure(MessageLoop::TYPE_UI);
+  RunTest_PostOnceClosure(MessageLoop::TYPE_IO);
+}
+
 TEST(MessageLoopTest, PostDelayedTask_SharedTimer) {
   RunTest_PostDelayedTask_SharedTimer(MessageLoop::TYPE_DEFAULT);
   RunTest_PostDelayedTask_SharedTimer(MessageLoop::TYPE_UI);
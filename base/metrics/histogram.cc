@@ -14,8 +14,10 @@
 #include <algorithm>
 #include <string>
 
+#include "base/bits.h"
 #include "base/debug/leak_annotations.h"
 #include "base/logging.h"
+#include "base/metrics/shared_histogram_arena.h"
 #include "base/pickle.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/lock.h"
@@ -74,6 +76,91 @@ typedef Histogram::Count Count;
 // static
 const size_t Histogram::kBucketCount_MAX = 16384u;
 
+namespace {
+
+// Add |delta| to |*value| without a lock.  Without 64-bit atomics, the two
+// halves are updated separately with the carry propagated afterwards, so a
+// concurrent reader may briefly see a value that is off by 2^32.
+void AtomicAdd64(int64* value, int64 delta) {
+#if defined(ARCH_CPU_64_BITS)
+  subtle::NoBarrier_AtomicIncrement(
+      reinterpret_cast<volatile subtle::Atomic64*>(value),
+      static_cast<subtle::Atomic64>(delta));
+#else
+#if !defined(ARCH_CPU_LITTLE_ENDIAN)
+#error The low half of an int64 is assumed to come first.
+#endif
+  volatile subtle::Atomic32* halves =
+      reinterpret_cast<volatile subtle::Atomic32*>(value);
+  uint32 low_delta = static_cast<uint32>(delta);
+  int32 high_delta = static_cast<int32>(delta >> 32);
+  uint32 new_low = static_cast<uint32>(subtle::NoBarrier_AtomicIncrement(
+      &halves[0], static_cast<subtle::Atomic32>(low_delta)));
+  if (new_low < low_delta)
+    ++high_delta;  // The low half wrapped around.
+  if (high_delta)
+    subtle::NoBarrier_AtomicIncrement(&halves[1], high_delta);
+#endif
+}
+
+// Record |count| samples of |value| in bucket |index|.  The same updates are
+// used whether the storage belongs to a SampleSet or to a
+// SharedHistogramArena.
+void AccumulateInto(Count* counts, int64* sum, int64* redundant_count,
+                    Histogram::Sample value, Count count, size_t index) {
+  DCHECK(count == 1 || count == -1);
+  Count new_count = subtle::NoBarrier_AtomicIncrement(&counts[index], count);
+  AtomicAdd64(sum, static_cast<int64>(count) * value);
+  AtomicAdd64(redundant_count, count);
+  DCHECK_GE(new_count, 0);
+}
+
+// Add all of the samples in |other| to the given storage, which may belong to
+// a live histogram.
+void AddInto(const Histogram::SampleSet& other, size_t bucket_count,
+             Count* counts, int64* sum, int64* redundant_count) {
+  AtomicAdd64(sum, other.sum());
+  AtomicAdd64(redundant_count, other.redundant_count());
+  for (size_t index = 0; index < bucket_count; ++index) {
+    if (other.counts(index))
+      subtle::NoBarrier_AtomicIncrement(&counts[index], other.counts(index));
+  }
+}
+
+// For bucket lookup, samples are grouped by their highest set bit and the
+// |group_bits| bits below it, so that every power of two is split into
+// 2^group_bits groups.  Samples below 2^group_bits each get a group of their
+// own.  Exponential ranges do with the fewest bits; custom ranges and dense
+// linear ranges get more, up to the maximum, until no group holds the start
+// of more than kMaxBucketsPerSampleGroup buckets.
+const int kMinSampleGroupBits = 3;
+const int kMaxSampleGroupBits = 10;
+const size_t kMaxBucketsPerSampleGroup = 2;
+
+size_t SampleGroup(Histogram::Sample value, int group_bits) {
+  DCHECK_GE(value, 0);
+  if (value < (1 << group_bits))
+    return value;
+  int shift = bits::Log2Floor(value) - group_bits;
+  return ((shift + 1) << group_bits) +
+         ((value >> shift) & ((1 << group_bits) - 1));
+}
+
+// The smallest sample in |group|.
+Histogram::Sample SampleGroupStart(size_t group, int group_bits) {
+  if (group < (1u << group_bits))
+    return static_cast<Histogram::Sample>(group);
+  int shift = static_cast<int>(group >> group_bits) - 1;
+  return static_cast<Histogram::Sample>(
+      ((1 << group_bits) | (group & ((1 << group_bits) - 1))) << shift);
+}
+
+bool HistogramNameLess(const Histogram* a, const Histogram* b) {
+  return a->histogram_name() < b->histogram_name();
+}
+
+}  // namespace
+
 // Collect the number of histograms created.
 static uint32 number_of_histograms_ = 0;
 // Collect the number of vectors saved because of caching ranges.
@@ -149,7 +236,12 @@ void Histogram::AddBoolean(bool value) {
 }
 
 void Histogram::AddSampleSet(const SampleSet& sample) {
-  sample_.Add(sample);
+  if (shared_samples_) {
+    AddInto(sample, bucket_count_, shared_samples_->counts,
+            &shared_samples_->sum, &shared_samples_->redundant_count);
+  } else {
+    sample_.Add(sample);
+  }
 }
 
 void Histogram::SetRangeDescriptions(const DescriptionPair descriptions[]) {
@@ -280,6 +372,35 @@ bool Histogram::DeserializeHistogramInfo(const std::string& histogram_info) {
   }
 
   DCHECK(pickle_flags & kIPCSerializationSourceFlag);
+
+  std::vector<Histogram::Sample> custom_ranges;
+  if (histogram_type == CUSTOM_HISTOGRAM) {
+    if (INT_MAX / sizeof(Count) <= bucket_count) {
+      DLOG(ERROR) << "Values error decoding Histogram: " << histogram_name;
+      return false;
+    }
+    custom_ranges.resize(bucket_count);
+    if (!CustomHistogram::DeserializeRanges(&iter, pickle, &custom_ranges)) {
+      DLOG(ERROR) << "Pickle error decoding ranges: " << histogram_name;
+      return false;
+    }
+  }
+
+  return AddReportedSamples(histogram_name, histogram_type, declared_min,
+                            declared_max, bucket_count, range_checksum,
+                            pickle_flags, custom_ranges, sample);
+}
+
+// static
+bool Histogram::AddReportedSamples(const std::string& histogram_name,
+                                   int histogram_type,
+                                   Sample declared_min,
+                                   Sample declared_max,
+                                   size_t bucket_count,
+                                   uint32 range_checksum,
+                                   int reported_flags,
+                                   const std::vector<Sample>& custom_ranges,
+                                   const SampleSet& sample) {
   // Since these fields may have come from an untrusted renderer, do additional
   // checks above and beyond those in Histogram::Initialize()
   if (declared_max <= 0 || declared_min <= 0 || declared_max < declared_min ||
@@ -288,7 +409,8 @@ bool Histogram::DeserializeHistogramInfo(const std::string& histogram_info) {
     return false;
   }
 
-  Flags flags = static_cast<Flags>(pickle_flags & ~kIPCSerializationSourceFlag);
+  Flags flags =
+      static_cast<Flags>(reported_flags & ~kIPCSerializationSourceFlag);
 
   DCHECK_NE(NOT_VALID_IN_RENDERER, histogram_type);
 
@@ -303,13 +425,9 @@ bool Histogram::DeserializeHistogramInfo(const std::string& histogram_info) {
   } else if (histogram_type == BOOLEAN_HISTOGRAM) {
     render_histogram = BooleanHistogram::FactoryGet(histogram_name, flags);
   } else if (histogram_type == CUSTOM_HISTOGRAM) {
-    std::vector<Histogram::Sample> sample_ranges(bucket_count);
-    if (!CustomHistogram::DeserializeRanges(&iter, pickle, &sample_ranges)) {
-      DLOG(ERROR) << "Pickle error decoding ranges: " << histogram_name;
-      return false;
-    }
+    DCHECK_EQ(bucket_count, custom_ranges.size());
     render_histogram =
-        CustomHistogram::FactoryGet(histogram_name, sample_ranges, flags);
+        CustomHistogram::FactoryGet(histogram_name, custom_ranges, flags);
   } else {
     DLOG(ERROR) << "Error Deserializing Histogram Unknown histogram_type: "
                 << histogram_type;
@@ -393,11 +511,14 @@ size_t Histogram::bucket_count() const {
   return bucket_count_;
 }
 
-// Do a safe atomic snapshot of sample data.
-// This implementation assumes we are on a safe single thread.
+// Snapshot the sample data without blocking writers.  Each field is updated
+// atomically, but a sample being added during the copy may be seen in some
+// fields and not others; FindCorruption() allows for that.
 void Histogram::SnapshotSample(SampleSet* sample) const {
-  // Note locking not done in this version!!!
-  *sample = sample_;
+  if (shared_samples_)
+    sample->CopyFrom(*shared_samples_, bucket_count_);
+  else
+    *sample = sample_;
 }
 
 bool Histogram::HasConstructorArguments(Sample minimum,
@@ -428,7 +549,8 @@ Histogram::Histogram(const std::string& name, Sample minimum,
     flags_(kNoFlags),
     cached_ranges_(new CachedRanges(bucket_count + 1, 0)),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    shared_samples_(NULL) {
   Initialize();
 }
 
@@ -441,7 +563,8 @@ Histogram::Histogram(const std::string& name, TimeDelta minimum,
     flags_(kNoFlags),
     cached_ranges_(new CachedRanges(bucket_count + 1, 0)),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    shared_samples_(NULL) {
   Initialize();
 }
 
@@ -491,6 +614,7 @@ void Histogram::InitializeBucketRange() {
     SetBucketRange(bucket_index, current);
   }
   ResetRangeChecksum();
+  cached_ranges_->InitializeBucketIndexTable();
 
   DCHECK_EQ(bucket_count(), bucket_index);
 }
@@ -500,10 +624,12 @@ bool Histogram::PrintEmptyBucket(size_t index) const {
 }
 
 size_t Histogram::BucketIndex(Sample value) const {
-  // Use simple binary search.  This is very general, but there are better
-  // approaches if we knew that the buckets were linearly distributed.
   DCHECK_LE(ranges(0), value);
   DCHECK_GT(ranges(bucket_count()), value);
+  if (cached_ranges_->has_bucket_index_table())
+    return cached_ranges_->BucketIndex(value);
+
+  // Fall back to a simple binary search for ranges set up by other means.
   size_t under = 0;
   size_t over = bucket_count();
   size_t mid;
@@ -551,10 +677,21 @@ const std::string Histogram::GetAsciiBucketRange(size_t i) const {
   return result;
 }
 
-// Update histogram data with new sample.
+// Update histogram data with new sample.  This does not lock; the SampleSet
+// updates each of its fields atomically.
 void Histogram::Accumulate(Sample value, Count count, size_t index) {
-  // Note locking not done in this version!!!
-  sample_.Accumulate(value, count, index);
+  if (shared_samples_) {
+    AccumulateInto(shared_samples_->counts, &shared_samples_->sum,
+                   &shared_samples_->redundant_count, value, count, index);
+  } else {
+    sample_.Accumulate(value, count, index);
+  }
+}
+
+void Histogram::set_shared_samples(SharedSamples* samples) {
+  DCHECK(!shared_samples_);
+  DCHECK_EQ(0, sample_.redundant_count());
+  shared_samples_ = samples;
 }
 
 void Histogram::SetBucketRange(size_t i, Sample value) {
@@ -720,13 +857,7 @@ void Histogram::SampleSet::CheckSize(const Histogram& histogram) const {
 
 void Histogram::SampleSet::Accumulate(Sample value,  Count count,
                                       size_t index) {
-  DCHECK(count == 1 || count == -1);
-  counts_[index] += count;
-  sum_ += count * value;
-  redundant_count_ += count;
-  DCHECK_GE(counts_[index], 0);
-  DCHECK_GE(sum_, 0);
-  DCHECK_GE(redundant_count_, 0);
+  AccumulateInto(&counts_[0], &sum_, &redundant_count_, value, count, index);
 }
 
 Count Histogram::SampleSet::TotalCount() const {
@@ -741,10 +872,11 @@ Count Histogram::SampleSet::TotalCount() const {
 
 void Histogram::SampleSet::Add(const SampleSet& other) {
   DCHECK_EQ(counts_.size(), other.counts_.size());
-  sum_ += other.sum_;
-  redundant_count_ += other.redundant_count_;
-  for (size_t index = 0; index < counts_.size(); ++index)
-    counts_[index] += other.counts_[index];
+  if (counts_.empty())
+    return;
+  // This may be a live histogram's sample set, so update it the same way as
+  // Accumulate() does.
+  AddInto(other, counts_.size(), &counts_[0], &sum_, &redundant_count_);
 }
 
 void Histogram::SampleSet::Subtract(const SampleSet& other) {
@@ -760,6 +892,13 @@ void Histogram::SampleSet::Subtract(const SampleSet& other) {
   }
 }
 
+void Histogram::SampleSet::CopyFrom(const SharedSamples& samples,
+                                    size_t bucket_count) {
+  counts_.assign(samples.counts, samples.counts + bucket_count);
+  sum_ = samples.sum;
+  redundant_count_ = samples.redundant_count;
+}
+
 bool Histogram::SampleSet::Serialize(Pickle* pickle) const {
   pickle->WriteInt64(sum_);
   pickle->WriteInt64(redundant_count_);
@@ -886,6 +1025,27 @@ void LinearHistogram::InitializeBucketRange() {
     SetBucketRange(i, static_cast<int> (linear_range + 0.5));
   }
   ResetRangeChecksum();
+  // LinearHistogram doesn't use the table, but an exponential histogram with
+  // identical ranges might end up sharing our CachedRanges.
+  cached_ranges()->InitializeBucketIndexTable();
+}
+
+size_t LinearHistogram::BucketIndex(Sample value) const {
+  DCHECK_LE(ranges(0), value);
+  DCHECK_GT(ranges(bucket_count()), value);
+  if (value < declared_min())
+    return 0;
+  // Invert the calculation in InitializeBucketRange().  Its rounding may leave
+  // the estimate one bucket off.
+  size_t index = 1 + static_cast<size_t>(
+      static_cast<int64>(value - declared_min()) * (bucket_count() - 2) /
+      (declared_max() - declared_min()));
+  index = std::min(index, bucket_count() - 1);
+  while (ranges(index) > value)
+    --index;
+  while (ranges(index + 1) <= value)
+    ++index;
+  return index;
 }
 
 double LinearHistogram::GetBucketSize(Count current, size_t i) const {
@@ -1031,6 +1191,7 @@ void CustomHistogram::InitializedCustomBucketRange(
   for (size_t index = 0; index < custom_ranges.size(); ++index)
     SetBucketRange(index, custom_ranges[index]);
   ResetRangeChecksum();
+  cached_ranges()->InitializeBucketIndexTable();
 }
 
 double CustomHistogram::GetBucketSize(Count current, size_t i) const {
@@ -1108,15 +1269,21 @@ Histogram* StatisticsRecorder::RegisterOrDeleteDuplicate(Histogram* histogram) {
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
     return histogram;
   }
+  // Registered histograms are never deleted, so interning their names adds
+  // nothing that wouldn't be kept anyway.
+  const InternedString name(histogram->histogram_name());
   base::AutoLock auto_lock(*lock_);
   if (!histograms_) {
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
     return histogram;
   }
-  const std::string name = histogram->histogram_name();
   HistogramMap::iterator it = histograms_->find(name);
   // Avoid overwriting a previous registration.
   if (histograms_->end() == it) {
+    // Move the samples into shared memory before any other thread can see
+    // the histogram.
+    if (SharedHistogramArena::current())
+      SharedHistogramArena::current()->Allocate(histogram);
     (*histograms_)[name] = histogram;
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
     RegisterOrDeleteDuplicateRanges(histogram);
@@ -1261,7 +1428,7 @@ void StatisticsRecorder::GetHistograms(Histograms* output) {
   for (HistogramMap::iterator it = histograms_->begin();
        histograms_->end() != it;
        ++it) {
-    DCHECK_EQ(it->first, it->second->histogram_name());
+    DCHECK_EQ(it->first.as_string(), it->second->histogram_name());
     output->push_back(it->second);
   }
 }
@@ -1270,10 +1437,14 @@ bool StatisticsRecorder::FindHistogram(const std::string& name,
                                        Histogram** histogram) {
   if (lock_ == NULL)
     return false;
+  // Names that were never interned were never registered.
+  InternedString interned_name;
+  if (!InternedString::Find(name, &interned_name))
+    return false;
   base::AutoLock auto_lock(*lock_);
   if (!histograms_)
     return false;
-  HistogramMap::iterator it = histograms_->find(name);
+  HistogramMap::iterator it = histograms_->find(interned_name);
   if (histograms_->end() == it)
     return false;
   *histogram = it->second;
@@ -1291,14 +1462,16 @@ void StatisticsRecorder::GetSnapshot(const std::string& query,
   for (HistogramMap::iterator it = histograms_->begin();
        histograms_->end() != it;
        ++it) {
-    if (it->first.find(query) != std::string::npos)
+    if (it->first.as_string().find(query) != std::string::npos)
       snapshot->push_back(it->second);
   }
+  std::sort(snapshot->begin(), snapshot->end(), &HistogramNameLess);
 }
 
 CachedRanges::CachedRanges(size_t bucket_count, int initial_value)
     : ranges_(bucket_count, initial_value),
-      range_checksum_(0) {
+      range_checksum_(0),
+      sample_group_bits_(kMinSampleGroupBits) {
 }
 
 CachedRanges::~CachedRanges() {
@@ -1310,6 +1483,45 @@ void CachedRanges::SetBucketRange(size_t i, Histogram::Sample value) {
   ranges_[i] = value;
 }
 
+void CachedRanges::InitializeBucketIndexTable() {
+  DCHECK_EQ(Histogram::kSampleType_MAX, ranges_.back());
+  // Every sample from the start of the last bucket on is in the last bucket,
+  // so the table stops at that bucket's group.
+  DCHECK_GE(ranges_.size(), 2u);
+  Histogram::Sample last_start = ranges_[ranges_.size() - 2];
+  for (sample_group_bits_ = kMinSampleGroupBits; ; ++sample_group_bits_) {
+    size_t group_count = SampleGroup(last_start, sample_group_bits_) + 1;
+    bucket_index_table_.resize(group_count);
+    size_t index = 0;
+    size_t most_buckets_per_group = 0;
+    for (size_t group = 0; group < group_count; ++group) {
+      Histogram::Sample group_start =
+          SampleGroupStart(group, sample_group_bits_);
+      size_t group_index = index;
+      while (ranges_[index + 1] <= group_start)
+        ++index;
+      bucket_index_table_[group] = static_cast<uint16>(index);
+      if (group > 0)
+        most_buckets_per_group = std::max(most_buckets_per_group,
+                                          index - group_index);
+    }
+    most_buckets_per_group = std::max(most_buckets_per_group,
+                                      ranges_.size() - 2 - index);
+    if (most_buckets_per_group <= kMaxBucketsPerSampleGroup ||
+        sample_group_bits_ == kMaxSampleGroupBits)
+      break;
+  }
+}
+
+size_t CachedRanges::BucketIndex(Histogram::Sample value) const {
+  size_t group = std::min(SampleGroup(value, sample_group_bits_),
+                          bucket_index_table_.size() - 1);
+  size_t index = bucket_index_table_[group];
+  while (ranges_[index + 1] <= value)
+    ++index;
+  return index;
+}
+
 bool CachedRanges::Equals(CachedRanges* other) const {
   if (range_checksum_ != other->range_checksum_)
     return false;
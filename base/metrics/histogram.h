@@ -50,6 +50,8 @@
 #include "base/base_export.h"
 #include "base/compiler_specific.h"
 #include "base/gtest_prod_util.h"
+#include "base/hash_tables.h"
+#include "base/interned_string.h"
 #include "base/logging.h"
 #include "base/time.h"
 
@@ -322,6 +324,7 @@ class CachedRanges;
 class CustomHistogram;
 class Histogram;
 class LinearHistogram;
+class SharedHistogramArena;
 
 class BASE_EXPORT Histogram {
  public:
@@ -378,6 +381,15 @@ class BASE_EXPORT Histogram {
     const char* description;  // Null means end of a list of pairs.
   };
 
+  // The layout of a histogram's sample data when it is kept outside of the
+  // Histogram, in a SharedHistogramArena.  |counts| actually has
+  // bucket_count() entries.
+  struct SharedSamples {
+    int64 sum;
+    int64 redundant_count;
+    Count counts[1];
+  };
+
   //----------------------------------------------------------------------------
   // Statistic values, developed over the life of the histogram.
 
@@ -403,6 +415,10 @@ class BASE_EXPORT Histogram {
     void Add(const SampleSet& other);
     void Subtract(const SampleSet& other);
 
+    // Replace the contents of this set with a copy of |samples|, which has
+    // |bucket_count| buckets.
+    void CopyFrom(const SharedSamples& samples, size_t bucket_count);
+
     bool Serialize(Pickle* pickle) const;
     bool Deserialize(void** iter, const Pickle& pickle);
 
@@ -422,10 +438,9 @@ class BASE_EXPORT Histogram {
     // To help identify memory corruption, we reduntantly save the number of
     // samples we've accumulated into all of our buckets.  We can compare this
     // count to the sum of the counts in all buckets, and detect problems.  Note
-    // that due to races in histogram accumulation (if a histogram is indeed
-    // updated on several threads simultaneously), the tallies might mismatch,
-    // and also the snapshotting code may asynchronously get a mismatch (though
-    // generally either race based mismatch cause is VERY rare).
+    // that each field is updated atomically but separately, so snapshotting
+    // code that races with an update may asynchronously get a mismatch (though
+    // such race based mismatches are VERY rare).
     int64 redundant_count_;
   };
 
@@ -517,6 +532,9 @@ class BASE_EXPORT Histogram {
   void set_cached_ranges(CachedRanges* cached_ranges) {
     cached_ranges_ = cached_ranges;
   }
+  // True if the samples are kept in a SharedHistogramArena, to be collected
+  // by the process that reads the arena.
+  bool has_shared_samples() const { return shared_samples_ != NULL; }
   // Snapshot the current complete set of sample data.
   // Override with atomic/locked snapshot if needed.
   virtual void SnapshotSample(SampleSet* sample) const;
@@ -593,10 +611,29 @@ class BASE_EXPORT Histogram {
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, Crc32TableTest);
 
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
+  friend class SharedHistogramArena;  // To move samples into shared memory.
 
   // Post constructor initialization.
   void Initialize();
 
+  // Find or create the histogram described by the arguments, which were
+  // reported by another process, and add |sample| to it.  |custom_ranges| is
+  // only used by CUSTOM_HISTOGRAM.  Returns false if the description is not
+  // valid.
+  static bool AddReportedSamples(const std::string& histogram_name,
+                                 int histogram_type,
+                                 Sample declared_min,
+                                 Sample declared_max,
+                                 size_t bucket_count,
+                                 uint32 range_checksum,
+                                 int reported_flags,
+                                 const std::vector<Sample>& custom_ranges,
+                                 const SampleSet& sample);
+
+  // Record samples in |samples| from now on, rather than in |sample_|.  Must
+  // be called before any samples are added.
+  void set_shared_samples(SharedSamples* samples);
+
   // Checksum function for accumulating range values into a checksum.
   static uint32 Crc32(uint32 sum, Sample range);
 
@@ -656,6 +693,10 @@ class BASE_EXPORT Histogram {
   // sample.
   SampleSet sample_;
 
+  // If non-NULL, samples are recorded here instead of in |sample_|.  This
+  // is memory owned by the current SharedHistogramArena.
+  SharedSamples* shared_samples_;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
@@ -699,6 +740,9 @@ class BASE_EXPORT LinearHistogram : public Histogram {
   void InitializeBucketRange();
   virtual double GetBucketSize(Count current, size_t i) const OVERRIDE;
 
+  // Buckets are evenly spaced, so the bucket can be computed directly.
+  virtual size_t BucketIndex(Sample value) const OVERRIDE;
+
   // If we have a description for a bucket, then return that.  Otherwise
   // let parent class provide a (numeric) description.
   virtual const std::string GetAsciiBucketRange(size_t i) const OVERRIDE;
@@ -830,13 +874,14 @@ class BASE_EXPORT StatisticsRecorder {
   // GetSnapshot copies some of the pointers to registered histograms into the
   // caller supplied vector (Histograms).  Only histograms with names matching
   // query are returned. The query must be a substring of histogram name for its
-  // pointer to be copied.
+  // pointer to be copied.  The snapshot is sorted by name.
   static void GetSnapshot(const std::string& query, Histograms* snapshot);
 
 
  private:
-  // We keep all registered histograms in a map, from name to histogram.
-  typedef std::map<std::string, Histogram*> HistogramMap;
+  // We keep all registered histograms in a map, from interned name to
+  // histogram, so FindHistogram() does no string comparisons.
+  typedef hash_map<InternedString, Histogram*> HistogramMap;
 
   // We keep all |cached_ranges_| in a map, from checksum to a list of
   // |cached_ranges_|.  Checksum is calculated from the |ranges_| in
@@ -879,6 +924,15 @@ class BASE_EXPORT CachedRanges {
   // Return true iff |other| object has same ranges_ as |this| object's ranges_.
   bool Equals(CachedRanges* other) const;
 
+  // Build the table used by BucketIndex().  Call once all ranges are set.
+  void InitializeBucketIndexTable();
+  bool has_bucket_index_table() const { return !bucket_index_table_.empty(); }
+
+  // Find the bucket holding |value| in constant time, using the table built
+  // by InitializeBucketIndexTable().  Only custom ranges with many buckets
+  // within 1/1024th of a power of two take more than a few steps.
+  size_t BucketIndex(Histogram::Sample value) const;
+
  private:
   // Allow tests to corrupt our innards for testing purposes.
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, CorruptBucketBounds);
@@ -893,6 +947,14 @@ class BASE_EXPORT CachedRanges {
   // possibly Equal() to this instance.
   uint32 range_checksum_;
 
+  // Samples are split into groups, each spanning at most 1/2^n of a power of
+  // two, where n is |sample_group_bits_|.  For each group, this holds the
+  // bucket of the smallest sample in the group; the bucket of any other
+  // sample is then at most a few steps further on.  n is picked per set of
+  // ranges, so that dense ranges get finer groups.
+  std::vector<uint16> bucket_index_table_;
+  int sample_group_bits_;
+
   DISALLOW_COPY_AND_ASSIGN(CachedRanges);
 };
 
@@ -0,0 +1,84 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/histogram.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTotalSamples = 4000000;
+
+// Waits for |start| and then adds |count| samples to |histogram|.
+class Sampler : public DelegateSimpleThread::Delegate {
+ public:
+  Sampler(Histogram* histogram, int count, WaitableEvent* start)
+      : histogram_(histogram), count_(count), start_(start) {
+  }
+
+  virtual void Run() OVERRIDE {
+    start_->Wait();
+    for (int i = 0; i < count_; ++i)
+      histogram_->Add(i & 0xffff);
+  }
+
+ private:
+  Histogram* histogram_;
+  int count_;
+  WaitableEvent* start_;
+};
+
+// Adds kTotalSamples samples to |histogram|, split evenly across
+// |num_threads| threads, and logs the rate at which they were recorded.
+void RunAddTest(Histogram* histogram, int num_threads) {
+  const int samples_per_thread = kTotalSamples / num_threads;
+  WaitableEvent start(true, false);
+  ScopedVector<Sampler> samplers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    samplers.push_back(new Sampler(histogram, samples_per_thread, &start));
+    threads.push_back(new DelegateSimpleThread(samplers[i],
+                                               "HistogramPerfTest"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  for (int i = 0; i < num_threads; ++i)
+    threads[i]->Join();
+  TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = StringPrintf("%s_%d_threads",
+                                  histogram->histogram_name().c_str(),
+                                  num_threads);
+  LogPerfResult(name.c_str(),
+                samples_per_thread * num_threads / elapsed.InSecondsF(),
+                "samples/s");
+}
+
+const int kThreadCounts[] = { 1, 4 };
+
+}  // namespace
+
+TEST(HistogramPerfTest, Exponential) {
+  Histogram* histogram = Histogram::FactoryGet(
+      "Histogram_Exponential", 1, 10000, 50, Histogram::kNoFlags);
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i)
+    RunAddTest(histogram, kThreadCounts[i]);
+}
+
+TEST(HistogramPerfTest, Linear) {
+  Histogram* histogram = LinearHistogram::FactoryGet(
+      "Histogram_Linear", 1, 10000, 100, Histogram::kNoFlags);
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i)
+    RunAddTest(histogram, kThreadCounts[i]);
+}
+
+}  // namespace base
@@ -8,7 +8,9 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/metrics/histogram.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -347,6 +349,120 @@ TEST(HistogramTest, BucketPlacementTest) {
     EXPECT_EQ(i + 1, sample.counts(i));
 }
 
+// Add |value| to |histogram| and check, by a linear search of the ranges, that
+// it landed in the right bucket.
+// |value| must be in [0, kSampleType_MAX).
+void AddAndCheckBucket(Histogram* histogram, int value) {
+  size_t expected = 0;
+  while (histogram->ranges(expected + 1) <= value)
+    ++expected;
+
+  Histogram::SampleSet before;
+  histogram->SnapshotSample(&before);
+  histogram->Add(value);
+  Histogram::SampleSet after;
+  histogram->SnapshotSample(&after);
+  after.Subtract(before);
+  EXPECT_EQ(1, after.counts(expected)) << histogram->histogram_name()
+                                       << " value " << value;
+}
+
+// Check that bucket lookup agrees with the ranges for every layout, including
+// values right at and around bucket boundaries.
+TEST(HistogramTest, BucketLookupTest) {
+  std::vector<int> custom_ranges;
+  custom_ranges.push_back(3);
+  custom_ranges.push_back(4);
+  custom_ranges.push_back(100);
+  custom_ranges.push_back(5000);
+  custom_ranges.push_back(1 << 30);
+
+  // Ranges dense enough that the lookup table needs finer groups.
+  std::vector<int> dense_ranges;
+  for (int i = 1; i < 600; ++i)
+    dense_ranges.push_back(i);
+  for (int i = 4000; i < 4100; ++i)
+    dense_ranges.push_back(i);
+
+  Histogram* histograms[] = {
+    Histogram::FactoryGet("Lookup1", 1, 64, 8, Histogram::kNoFlags),
+    Histogram::FactoryGet("Lookup2", 1, 10000, 50, Histogram::kNoFlags),
+    Histogram::FactoryGet("Lookup3", 5, 100, 96, Histogram::kNoFlags),
+    Histogram::FactoryGet("Lookup4", 1, INT_MAX - 1, 100, Histogram::kNoFlags),
+    LinearHistogram::FactoryGet("Lookup5", 1, 1000, 100, Histogram::kNoFlags),
+    LinearHistogram::FactoryGet("Lookup6", 7, 13, 8, Histogram::kNoFlags),
+    LinearHistogram::FactoryGet("Lookup7", 1, 100000, 7, Histogram::kNoFlags),
+    BooleanHistogram::FactoryGet("Lookup8", Histogram::kNoFlags),
+    CustomHistogram::FactoryGet("Lookup9", custom_ranges, Histogram::kNoFlags),
+    CustomHistogram::FactoryGet("Lookup10", dense_ranges, Histogram::kNoFlags),
+    Histogram::FactoryGet("Lookup11", 1, 500, 400, Histogram::kNoFlags),
+  };
+
+  for (size_t i = 0; i < arraysize(histograms); ++i) {
+    Histogram* histogram = histograms[i];
+    for (int value = 0; value < 300; ++value)
+      AddAndCheckBucket(histogram, value);
+    for (size_t bucket = 1; bucket < histogram->bucket_count(); ++bucket) {
+      int range = histogram->ranges(bucket);
+      AddAndCheckBucket(histogram, range - 1);
+      AddAndCheckBucket(histogram, range);
+      if (range < Histogram::kSampleType_MAX - 1)
+        AddAndCheckBucket(histogram, range + 1);
+    }
+    AddAndCheckBucket(histogram, INT_MAX - 1);
+  }
+}
+
+// Adds |count| samples of |value| to |histogram|.
+class HistogramAdder : public DelegateSimpleThread::Delegate {
+ public:
+  HistogramAdder(Histogram* histogram, int value, int count)
+      : histogram_(histogram), value_(value), count_(count) {
+  }
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < count_; ++i)
+      histogram_->Add(value_);
+  }
+
+ private:
+  Histogram* histogram_;
+  int value_;
+  int count_;
+};
+
+// Check that no samples are lost when several threads add to the same
+// histogram at once.
+TEST(HistogramTest, ConcurrentAddTest) {
+  Histogram* histogram(Histogram::FactoryGet(
+      "Concurrent", 1, 1000, 10, Histogram::kNoFlags));
+
+  const int kNumThreads = 4;
+  const int kNumSamples = 100000;
+  // Large enough that the sum overflows 32 bits.
+  const int kValue = 900000;
+  ScopedVector<HistogramAdder> adders;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    adders.push_back(new HistogramAdder(histogram, kValue, kNumSamples));
+    threads.push_back(new DelegateSimpleThread(adders[i], "HistogramAdder"));
+  }
+  for (int i = 0; i < kNumThreads; ++i)
+    threads[i]->Start();
+  for (int i = 0; i < kNumThreads; ++i)
+    threads[i]->Join();
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(kNumThreads * kNumSamples, sample.TotalCount());
+  EXPECT_EQ(kNumThreads * kNumSamples, sample.redundant_count());
+  EXPECT_EQ(static_cast<int64>(kNumThreads) * kNumSamples * kValue,
+            sample.sum());
+  EXPECT_EQ(kNumThreads * kNumSamples,
+            sample.counts(histogram->bucket_count() - 1));
+  EXPECT_EQ(0, histogram->FindCorruption(sample));
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
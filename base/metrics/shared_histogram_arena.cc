@@ -0,0 +1,302 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/shared_histogram_arena.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/shared_memory.h"
+
+namespace base {
+
+// The arena is laid out as follows, with everything aligned to 8 bytes:
+//
+// +------------------------------------------------+
+// | Version | Size | Used                          |
+// +------------------------------------------------+
+// | Record: header | samples | ranges | name      |
+// +------------------------------------------------+
+// | Record ...                                     |
+// +------------------------------------------------+
+// | Free space, up to Size                         |
+// +------------------------------------------------+
+//
+// A record's samples are a Histogram::SharedSamples with one count per
+// bucket.  Its ranges are the bucket_count + 1 ranges of the histogram, and
+// its name is not NUL terminated.
+
+struct SharedHistogramArena::Header {
+  uint32 version;
+  uint32 size;
+  // The offset of the first byte that has not been allocated.
+  volatile subtle::Atomic32 used;
+  uint32 padding;
+};
+
+struct SharedHistogramArena::Record {
+  // kRecordReady once the rest of the record has been written.
+  volatile subtle::Atomic32 state;
+  // Written first, so that readers can step over a record that is not ready.
+  volatile subtle::Atomic32 size;
+  int32 histogram_type;
+  int32 flags;
+  int32 declared_min;
+  int32 declared_max;
+  uint32 bucket_count;
+  uint32 range_checksum;
+  uint32 name_length;
+  uint32 padding;
+};
+
+namespace {
+
+// An internal version in case we ever change the layout of the arena, and so
+// that we can identify it.
+const uint32 kArenaVersion = 0x48534131;
+
+const subtle::Atomic32 kRecordReady = 1;
+
+// Longer names are not worth the space; such histograms stay in the process.
+const size_t kMaxNameLength = 1024;
+
+const size_t kAlignment = 8;
+
+inline size_t AlignedSize(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+inline size_t SamplesSize(size_t bucket_count) {
+  return offsetof(Histogram::SharedSamples, counts) +
+         bucket_count * sizeof(Histogram::Count);
+}
+
+}  // namespace
+
+// static
+const size_t SharedHistogramArena::kMinimumSize =
+    sizeof(SharedHistogramArena::Header);
+
+subtle::AtomicWord SharedHistogramArena::current_ = 0;
+
+// static
+SharedHistogramArena* SharedHistogramArena::Create(SharedMemory* shared_memory,
+                                                   size_t size) {
+  scoped_ptr<SharedHistogramArena> arena(
+      new SharedHistogramArena(shared_memory, size));
+  if (size < kMinimumSize || size > static_cast<size_t>(kint32max)) {
+    DLOG(ERROR) << "Bad shared histogram arena size: " << size;
+    return NULL;
+  }
+
+  Header* header = arena->header();
+  memset(header, 0, sizeof(*header));
+  header->version = kArenaVersion;
+  header->size = static_cast<uint32>(size);
+  subtle::Release_Store(&header->used, sizeof(Header));
+  return arena.release();
+}
+
+// static
+SharedHistogramArena* SharedHistogramArena::Attach(SharedMemory* shared_memory,
+                                                   size_t size) {
+  scoped_ptr<SharedHistogramArena> arena(
+      new SharedHistogramArena(shared_memory, size));
+  if (size < kMinimumSize)
+    return NULL;
+
+  Header* header = arena->header();
+  if (header->version != kArenaVersion || header->size > size ||
+      header->size < kMinimumSize) {
+    DLOG(ERROR) << "Memory does not hold a shared histogram arena";
+    return NULL;
+  }
+  arena->size_ = header->size;
+  return arena.release();
+}
+
+SharedHistogramArena::SharedHistogramArena(SharedMemory* shared_memory,
+                                           size_t size)
+    : shared_memory_(shared_memory),
+      memory_(static_cast<char*>(shared_memory->memory())),
+      size_(size) {
+  DCHECK(memory_);
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(memory_) % kAlignment);
+}
+
+SharedHistogramArena::~SharedHistogramArena() {
+  DCHECK_NE(this, current());
+}
+
+bool SharedHistogramArena::Allocate(Histogram* histogram) {
+  const std::string& name = histogram->histogram_name();
+  size_t bucket_count = histogram->bucket_count();
+  if (name.size() > kMaxNameLength) {
+    DLOG(WARNING) << "Histogram name too long for shared memory: " << name;
+    return false;
+  }
+  DCHECK_LE(bucket_count, Histogram::kBucketCount_MAX);
+  uint32 record_size = static_cast<uint32>(RecordSize(bucket_count,
+                                                      name.size()));
+
+  // Claim the space.  Allocation is normally serialized by the
+  // StatisticsRecorder's lock, but does not rely on it.
+  Header* header = this->header();
+  uint32 offset;
+  for (;;) {
+    subtle::Atomic32 used = subtle::NoBarrier_Load(&header->used);
+    offset = static_cast<uint32>(used);
+    if (offset > size_ || record_size > size_ - offset) {
+      DVLOG(1) << "Shared histogram arena is full; " << name
+               << " stays in the process";
+      return false;
+    }
+    subtle::Atomic32 new_used =
+        used + static_cast<subtle::Atomic32>(record_size);
+    if (subtle::NoBarrier_CompareAndSwap(&header->used, used, new_used) ==
+        used) {
+      break;
+    }
+  }
+
+  // Samples recorded in the arena are merged by another process, so this
+  // process must not also send them when it serializes its histograms.
+  histogram->SetFlags(Histogram::kIPCSerializationSourceFlag);
+
+  char* data = memory_ + offset;
+  Record* record = reinterpret_cast<Record*>(data);
+  subtle::Release_Store(&record->size,
+                        static_cast<subtle::Atomic32>(record_size));
+  record->histogram_type = histogram->histogram_type();
+  record->flags = histogram->flags();
+  record->declared_min = histogram->declared_min();
+  record->declared_max = histogram->declared_max();
+  record->bucket_count = static_cast<uint32>(bucket_count);
+  record->range_checksum = histogram->range_checksum();
+  record->name_length = static_cast<uint32>(name.size());
+  data += sizeof(Record);
+
+  Histogram::SharedSamples* samples =
+      reinterpret_cast<Histogram::SharedSamples*>(data);
+  memset(samples, 0, SamplesSize(bucket_count));
+  data += SamplesSize(bucket_count);
+
+  Histogram::Sample* ranges = reinterpret_cast<Histogram::Sample*>(data);
+  for (size_t i = 0; i <= bucket_count; ++i)
+    ranges[i] = histogram->ranges(i);
+  data += (bucket_count + 1) * sizeof(Histogram::Sample);
+
+  memcpy(data, name.data(), name.size());
+
+  histogram->set_shared_samples(samples);
+  subtle::Release_Store(&record->state, kRecordReady);
+  return true;
+}
+
+// static
+size_t SharedHistogramArena::RecordSize(size_t bucket_count,
+                                        size_t name_length) {
+  COMPILE_ASSERT(sizeof(Record) % kAlignment == 0, record_is_not_aligned);
+  return AlignedSize(sizeof(Record) + SamplesSize(bucket_count) +
+                     (bucket_count + 1) * sizeof(Histogram::Sample) +
+                     name_length);
+}
+
+int SharedHistogramArena::MergeNewSamples() {
+  uint32 used = static_cast<uint32>(subtle::Acquire_Load(&header()->used));
+  if (used > size_)
+    used = static_cast<uint32>(size_);
+
+  int merged = 0;
+  uint32 offset = sizeof(Header);
+  while (Record* shared_record = GetRecord(offset, used)) {
+    if (subtle::Acquire_Load(&shared_record->state) != kRecordReady) {
+      // Still being written, or its writer died.  Step over it by its size,
+      // which is written first; until then the records after it can't be
+      // found, and are picked up next time.
+      uint32 size = static_cast<uint32>(
+          subtle::Acquire_Load(&shared_record->size));
+      if (size == 0)
+        break;
+      if (size % kAlignment != 0 || size < sizeof(Record) ||
+          size > used - offset) {
+        DLOG(ERROR) << "Corrupt record in shared histogram arena";
+        break;
+      }
+      offset += size;
+      continue;
+    }
+
+    // The writer may be hostile, so work from a copy of the record header
+    // that cannot change underneath us.
+    Record record;
+    memcpy(&record, const_cast<Record*>(shared_record), sizeof(record));
+    uint32 record_size = static_cast<uint32>(record.size);
+    if (record.bucket_count > Histogram::kBucketCount_MAX ||
+        record.name_length > kMaxNameLength ||
+        record_size != RecordSize(record.bucket_count, record.name_length) ||
+        record_size > used - offset) {
+      DLOG(ERROR) << "Corrupt record in shared histogram arena";
+      break;  // There is no trustworthy way to find the next record.
+    }
+    if (MergeRecord(offset, record))
+      ++merged;
+    offset += record_size;
+  }
+  return merged;
+}
+
+size_t SharedHistogramArena::used() const {
+  return static_cast<size_t>(subtle::Acquire_Load(&header()->used));
+}
+
+SharedHistogramArena::Header* SharedHistogramArena::header() const {
+  return reinterpret_cast<Header*>(memory_);
+}
+
+SharedHistogramArena::Record* SharedHistogramArena::GetRecord(
+    uint32 offset, uint32 used) const {
+  if (offset > used || used - offset < sizeof(Record))
+    return NULL;
+  return reinterpret_cast<Record*>(memory_ + offset);
+}
+
+bool SharedHistogramArena::MergeRecord(uint32 offset, const Record& record) {
+  const char* data = memory_ + offset + sizeof(Record);
+  const Histogram::SharedSamples* samples =
+      reinterpret_cast<const Histogram::SharedSamples*>(data);
+  data += SamplesSize(record.bucket_count);
+  const Histogram::Sample* ranges =
+      reinterpret_cast<const Histogram::Sample*>(data);
+  data += (record.bucket_count + 1) * sizeof(Histogram::Sample);
+  std::string name(data, record.name_length);
+
+  Histogram::SampleSet snapshot;
+  snapshot.CopyFrom(*samples, record.bucket_count);
+  Histogram::SampleSet delta = snapshot;
+  MergedSamplesMap::const_iterator it = merged_samples_.find(offset);
+  if (it != merged_samples_.end())
+    delta.Subtract(it->second);
+  if (delta.redundant_count() == 0)
+    return false;
+
+  std::vector<Histogram::Sample> custom_ranges;
+  if (record.histogram_type == Histogram::CUSTOM_HISTOGRAM)
+    custom_ranges.assign(ranges, ranges + record.bucket_count);
+  if (!Histogram::AddReportedSamples(name, record.histogram_type,
+                                     record.declared_min, record.declared_max,
+                                     record.bucket_count, record.range_checksum,
+                                     record.flags, custom_ranges, delta)) {
+    return false;
+  }
+  merged_samples_[offset] = snapshot;
+  return true;
+}
+
+}  // namespace base
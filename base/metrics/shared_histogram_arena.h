@@ -0,0 +1,130 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A SharedHistogramArena is a block of shared memory that holds the sample
+// data of histograms, so that one process can read the histograms recorded by
+// another without asking it to serialize them.
+//
+// The browser creates an arena for each renderer and hands the renderer a
+// handle to it (see RendererHistogramArenas).  The renderer attaches to the
+// arena and makes it current() as soon as it gets the handle.  From then on,
+// every histogram registered with the StatisticsRecorder in the renderer
+// records its samples directly in the arena, at the same cost as recording
+// them in the process.  The browser calls MergeNewSamples() on its own
+// mapping whenever it wants to collect them.
+// Because the browser keeps its mapping, samples recorded by a renderer before
+// it crashed can still be collected afterwards.
+//
+// Histograms created before the arena became current, or after it filled up,
+// keep their samples in the process and must be collected as before, through
+// Histogram::SerializeHistogramInfo().
+//
+// The arena is an append-only list of records, one per histogram.  Records
+// are allocated by bumping an offset in the arena's header, and are published
+// to readers once they are completely written.  Nothing written by the child
+// is trusted by the reader.
+
+#ifndef BASE_METRICS_SHARED_HISTOGRAM_ARENA_H_
+#define BASE_METRICS_SHARED_HISTOGRAM_ARENA_H_
+#pragma once
+
+#include <map>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram.h"
+
+namespace base {
+
+class SharedMemory;
+
+class BASE_EXPORT SharedHistogramArena {
+ public:
+  // The smallest arena that can hold anything.
+  static const size_t kMinimumSize;
+
+  // Formats the first |size| bytes of |shared_memory|, which must already be
+  // mapped and still be all zeros, as newly created shared memory is, as an
+  // empty arena.  Only the header is written, so that the rest of the pages
+  // are committed as records are allocated.  Takes ownership of
+  // |shared_memory|.  Returns NULL if |size| is too small or too large.
+  static SharedHistogramArena* Create(SharedMemory* shared_memory,
+                                      size_t size);
+
+  // Attaches to an arena formatted by Create(), possibly in another process.
+  // |size| is the number of bytes of |shared_memory| that are mapped.  Takes
+  // ownership of |shared_memory|.  Returns NULL if the memory does not hold
+  // an arena of at most |size| bytes.
+  static SharedHistogramArena* Attach(SharedMemory* shared_memory,
+                                      size_t size);
+
+  ~SharedHistogramArena();
+
+  // The arena in which the histograms of this process record their samples,
+  // or NULL.  This is set once, normally early during startup, and may be
+  // set while other threads are creating histograms; the arena must then
+  // outlive all histograms.
+  static SharedHistogramArena* current() {
+    return reinterpret_cast<SharedHistogramArena*>(
+        subtle::Acquire_Load(&current_));
+  }
+  static void set_current(SharedHistogramArena* arena) {
+    subtle::Release_Store(&current_,
+                          reinterpret_cast<subtle::AtomicWord>(arena));
+  }
+
+  // Allocates a record for |histogram| and moves its sample data there.
+  // Returns false, leaving the histogram untouched, if the arena is full.
+  // Called by the StatisticsRecorder when a histogram is registered.
+  bool Allocate(Histogram* histogram);
+
+  // Adds all of the samples recorded in the arena since the last call to the
+  // histograms of this process, creating them as needed.  Returns the number
+  // of histograms that had new samples.  Records that are still being written
+  // are skipped, and picked up by a later call.
+  int MergeNewSamples();
+
+  // The number of bytes of the arena that are in use.
+  size_t used() const;
+  size_t size() const { return size_; }
+
+ private:
+  struct Header;
+  struct Record;
+
+  // Samples last merged from each record, keyed by the record's offset.
+  typedef std::map<uint32, Histogram::SampleSet> MergedSamplesMap;
+
+  SharedHistogramArena(SharedMemory* shared_memory, size_t size);
+
+  // The space taken by a record for a histogram with |bucket_count| buckets
+  // and a name of |name_length| characters.  The arguments must be no larger
+  // than Histogram::kBucketCount_MAX and kMaxNameLength.
+  static size_t RecordSize(size_t bucket_count, size_t name_length);
+
+  Header* header() const;
+
+  // Returns the record at |offset|, or NULL if it does not fit below |used|.
+  Record* GetRecord(uint32 offset, uint32 used) const;
+
+  // Merges the new samples of the record at |offset| into this process's
+  // histograms.  Returns true if there were any and they were valid.
+  bool MergeRecord(uint32 offset, const Record& record);
+
+  scoped_ptr<SharedMemory> shared_memory_;
+  char* memory_;
+  size_t size_;
+
+  MergedSamplesMap merged_samples_;
+
+  static subtle::AtomicWord current_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedHistogramArena);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_SHARED_HISTOGRAM_ARENA_H_
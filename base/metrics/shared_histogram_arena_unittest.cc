@@ -0,0 +1,279 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/shared_histogram_arena.h"
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram.h"
+#include "base/process_util.h"
+#include "base/shared_memory.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const size_t kArenaSize = 64 * 1024;
+
+}  // namespace
+
+// Each test plays both processes: histograms are recorded into a "child"
+// arena with one StatisticsRecorder, which is then replaced by a fresh one
+// standing in for the browser's, which merges from its own mapping.
+class SharedHistogramArenaTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    recorder_.reset(new StatisticsRecorder);
+
+    SharedMemory* child_memory = new SharedMemory;
+    ASSERT_TRUE(child_memory->CreateAndMapAnonymous(kArenaSize));
+    SharedMemoryHandle handle;
+    ASSERT_TRUE(child_memory->ShareToProcess(GetCurrentProcessHandle(),
+                                             &handle));
+    browser_memory_.reset(new SharedMemory(handle, false));
+    ASSERT_TRUE(browser_memory_->Map(kArenaSize));
+
+    child_arena_.reset(SharedHistogramArena::Create(child_memory, kArenaSize));
+    ASSERT_TRUE(child_arena_.get());
+    SharedHistogramArena::set_current(child_arena_.get());
+  }
+
+  virtual void TearDown() {
+    SharedHistogramArena::set_current(NULL);
+  }
+
+  // Stops recording into the arena and switches to the browser's view of it,
+  // with a StatisticsRecorder that knows none of the child's histograms.
+  SharedHistogramArena* SwitchToBrowser() {
+    SharedHistogramArena::set_current(NULL);
+    recorder_.reset();
+    recorder_.reset(new StatisticsRecorder);
+    browser_arena_.reset(
+        SharedHistogramArena::Attach(browser_memory_.release(), kArenaSize));
+    return browser_arena_.get();
+  }
+
+  scoped_ptr<StatisticsRecorder> recorder_;
+  scoped_ptr<SharedMemory> browser_memory_;
+  scoped_ptr<SharedHistogramArena> child_arena_;
+  scoped_ptr<SharedHistogramArena> browser_arena_;
+};
+
+TEST_F(SharedHistogramArenaTest, SamplesRecordedInArena) {
+  Histogram* histogram = Histogram::FactoryGet(
+      "Shared1", 1, 1000, 10, Histogram::kUmaTargetedHistogramFlag);
+  EXPECT_TRUE(histogram->has_shared_samples());
+  EXPECT_LT(SharedHistogramArena::kMinimumSize, child_arena_->used());
+
+  histogram->Add(5);
+  histogram->Add(5);
+  histogram->Add(500);
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(3, sample.TotalCount());
+  EXPECT_EQ(3, sample.redundant_count());
+  EXPECT_EQ(510, sample.sum());
+  EXPECT_EQ(Histogram::NO_INCONSISTENCIES, histogram->FindCorruption(sample));
+
+  // Histograms created without a current arena are unaffected.
+  SharedHistogramArena::set_current(NULL);
+  Histogram* local = Histogram::FactoryGet(
+      "Local1", 1, 1000, 10, Histogram::kNoFlags);
+  EXPECT_FALSE(local->has_shared_samples());
+}
+
+TEST_F(SharedHistogramArenaTest, MergeAllTypes) {
+  std::vector<int> custom_ranges;
+  custom_ranges.push_back(5);
+  custom_ranges.push_back(10);
+  custom_ranges.push_back(100);
+
+  Histogram* exponential = Histogram::FactoryGet(
+      "Shared2", 1, 1000, 10, Histogram::kUmaTargetedHistogramFlag);
+  Histogram* linear = LinearHistogram::FactoryGet(
+      "Shared3", 1, 100, 20, Histogram::kNoFlags);
+  Histogram* boolean = BooleanHistogram::FactoryGet(
+      "Shared4", Histogram::kNoFlags);
+  Histogram* custom = CustomHistogram::FactoryGet(
+      "Shared5", custom_ranges, Histogram::kNoFlags);
+  Histogram* unused = Histogram::FactoryGet(
+      "Shared6", 1, 1000, 10, Histogram::kNoFlags);
+  EXPECT_TRUE(unused->has_shared_samples());
+
+  exponential->Add(20);
+  linear->Add(50);
+  linear->Add(51);
+  boolean->AddBoolean(true);
+  custom->Add(7);
+
+  SharedHistogramArena* browser_arena = SwitchToBrowser();
+  ASSERT_TRUE(browser_arena);
+  EXPECT_EQ(4, browser_arena->MergeNewSamples());
+
+  Histogram* histogram;
+  Histogram::SampleSet sample;
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared2", &histogram));
+  EXPECT_FALSE(histogram->has_shared_samples());
+  EXPECT_EQ(Histogram::HISTOGRAM, histogram->histogram_type());
+  EXPECT_EQ(Histogram::kUmaTargetedHistogramFlag, histogram->flags());
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1, sample.TotalCount());
+  EXPECT_EQ(20, sample.sum());
+
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared3", &histogram));
+  EXPECT_EQ(Histogram::LINEAR_HISTOGRAM, histogram->histogram_type());
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(2, sample.TotalCount());
+  EXPECT_EQ(101, sample.sum());
+
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared4", &histogram));
+  EXPECT_EQ(Histogram::BOOLEAN_HISTOGRAM, histogram->histogram_type());
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1, sample.counts(1));
+
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared5", &histogram));
+  EXPECT_EQ(Histogram::CUSTOM_HISTOGRAM, histogram->histogram_type());
+  EXPECT_EQ(custom->range_checksum(), histogram->range_checksum());
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1, sample.counts(1));
+
+  // Nothing was recorded, so nothing was created.
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("Shared6", &histogram));
+}
+
+// Only samples added since the previous merge are merged again.
+TEST_F(SharedHistogramArenaTest, MergeIsIncremental) {
+  Histogram* child_histogram = Histogram::FactoryGet(
+      "Shared7", 1, 1000, 10, Histogram::kNoFlags);
+  child_histogram->Add(10);
+
+  SharedHistogramArena* browser_arena = SwitchToBrowser();
+  ASSERT_TRUE(browser_arena);
+  EXPECT_EQ(1, browser_arena->MergeNewSamples());
+  EXPECT_EQ(0, browser_arena->MergeNewSamples());
+
+  // The child keeps recording into its mapping.
+  child_histogram->Add(10);
+  child_histogram->Add(900);
+  EXPECT_EQ(1, browser_arena->MergeNewSamples());
+
+  Histogram* histogram;
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared7", &histogram));
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(3, sample.TotalCount());
+  EXPECT_EQ(920, sample.sum());
+}
+
+// Samples are still there after the child has gone away.
+TEST_F(SharedHistogramArenaTest, SurvivesChild) {
+  Histogram* child_histogram = Histogram::FactoryGet(
+      "Shared8", 1, 1000, 10, Histogram::kNoFlags);
+  child_histogram->Add(3);
+  SharedHistogramArena* browser_arena = SwitchToBrowser();
+  child_arena_.reset();
+
+  ASSERT_TRUE(browser_arena);
+  EXPECT_EQ(1, browser_arena->MergeNewSamples());
+  Histogram* histogram;
+  ASSERT_TRUE(StatisticsRecorder::FindHistogram("Shared8", &histogram));
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1, sample.TotalCount());
+}
+
+// When the same arena is read in the process that records into it, the
+// samples must not be counted twice.
+TEST_F(SharedHistogramArenaTest, SingleProcess) {
+  Histogram* histogram = Histogram::FactoryGet(
+      "Shared9", 1, 1000, 10, Histogram::kNoFlags);
+  histogram->Add(3);
+  scoped_ptr<SharedHistogramArena> browser_arena(
+      SharedHistogramArena::Attach(browser_memory_.release(), kArenaSize));
+  ASSERT_TRUE(browser_arena.get());
+  browser_arena->MergeNewSamples();
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1, sample.TotalCount());
+}
+
+TEST_F(SharedHistogramArenaTest, ArenaFull) {
+  int shared = 0;
+  for (int i = 0; i < 1000; ++i) {
+    Histogram* histogram = Histogram::FactoryGet(
+        StringPrintf("Full%d", i), 1, 1000, 50, Histogram::kNoFlags);
+    if (histogram->has_shared_samples())
+      ++shared;
+    histogram->Add(i);
+    Histogram::SampleSet sample;
+    histogram->SnapshotSample(&sample);
+    EXPECT_EQ(1, sample.TotalCount());
+  }
+  EXPECT_LT(0, shared);
+  EXPECT_GT(1000, shared);
+  EXPECT_GE(kArenaSize, child_arena_->used());
+}
+
+// A record that is not ready yet does not hide the records after it.
+TEST_F(SharedHistogramArenaTest, RecordNotReady) {
+  Histogram::FactoryGet("Shared12", 1, 1000, 10, Histogram::kNoFlags)->Add(1);
+  Histogram::FactoryGet("Shared13", 1, 1000, 10, Histogram::kNoFlags)->Add(2);
+  Histogram::FactoryGet("Shared14", 1, 1000, 10, Histogram::kNoFlags)->Add(3);
+
+  // Take the second record back to the state its writer leaves it in while
+  // filling it in.
+  uint32* words = static_cast<uint32*>(browser_memory_->memory());
+  size_t used = child_arena_->used();
+  size_t record_size = (used - SharedHistogramArena::kMinimumSize) / 3;
+  uint32* second_record =
+      words + (SharedHistogramArena::kMinimumSize + record_size) / 4;
+  second_record[0] = 0;  // state
+
+  SharedHistogramArena* browser_arena = SwitchToBrowser();
+  ASSERT_TRUE(browser_arena);
+  EXPECT_EQ(2, browser_arena->MergeNewSamples());
+  Histogram* histogram;
+  EXPECT_TRUE(StatisticsRecorder::FindHistogram("Shared12", &histogram));
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("Shared13", &histogram));
+  EXPECT_TRUE(StatisticsRecorder::FindHistogram("Shared14", &histogram));
+
+  // Once it is ready, it is merged.
+  second_record[0] = 1;
+  EXPECT_EQ(1, browser_arena->MergeNewSamples());
+  EXPECT_TRUE(StatisticsRecorder::FindHistogram("Shared13", &histogram));
+}
+
+TEST_F(SharedHistogramArenaTest, CorruptRecords) {
+  Histogram* histogram = Histogram::FactoryGet(
+      "Shared10", 1, 1000, 10, Histogram::kNoFlags);
+  histogram->Add(3);
+  Histogram::FactoryGet("Shared11", 1, 1000, 10, Histogram::kNoFlags)->Add(4);
+
+  // Claim a huge number of buckets in the second record.
+  uint32* words = static_cast<uint32*>(browser_memory_->memory());
+  size_t used = child_arena_->used();
+  size_t record_size = (used - SharedHistogramArena::kMinimumSize) / 2;
+  uint32* second_record =
+      words + (SharedHistogramArena::kMinimumSize + record_size) / 4;
+  second_record[6] = 0xffffff;  // bucket_count
+
+  SharedHistogramArena* browser_arena = SwitchToBrowser();
+  ASSERT_TRUE(browser_arena);
+  EXPECT_EQ(1, browser_arena->MergeNewSamples());
+  EXPECT_TRUE(StatisticsRecorder::FindHistogram("Shared10", &histogram));
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("Shared11", &histogram));
+
+  // An arena that does not start with a valid header is rejected.
+  SharedMemory* memory = new SharedMemory;
+  ASSERT_TRUE(memory->CreateAndMapAnonymous(kArenaSize));
+  scoped_ptr<SharedHistogramArena> arena(
+      SharedHistogramArena::Attach(memory, kArenaSize));
+  EXPECT_FALSE(arena.get());
+}
+
+}  // namespace base
@@ -7,10 +7,14 @@
 #pragma once
 
 #include <algorithm>
+#include <deque>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/bind.h"
+#include "base/callback.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
@@ -44,11 +48,19 @@
 //   whereas with the non-thread-safe observer_list, notifications happen
 //   synchronously and immediately.
 //
+//   Lists that notify in bursts can be created with DELIVER_COALESCED.  Each
+//   thread then gets at most one pending task for the list, which delivers
+//   every notification queued by the time it runs, in order.  Notifications
+//   may then run ahead of tasks posted to the thread after the first one of
+//   the burst.
+//
 //   IMPLEMENTATION NOTES
 //   The ObserverListThreadSafe maintains an ObserverList for each thread
 //   which uses the ThreadSafeObserver.  When Notifying the observers,
 //   we simply call PostTask to each registered thread, and then each thread
-//   will notify its regular ObserverList.
+//   will notify its regular ObserverList.  The threads to post to are kept in
+//   a snapshot that is rebuilt only when a thread's list is added or removed,
+//   so Notify() holds the lock just long enough to take a reference to it.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -99,9 +111,24 @@ class ObserverListThreadSafe
   typedef typename ObserverList<ObserverType>::NotificationType
       NotificationType;
 
+  enum DeliveryMode {
+    // Every Notify() posts a task to each thread with observers.
+    DELIVER_EACH,
+
+    // Notify() queues the notification for each thread, and only posts a
+    // task to threads that don't already have one pending.
+    DELIVER_COALESCED,
+  };
+
   ObserverListThreadSafe()
-      : type_(ObserverListBase<ObserverType>::NOTIFY_ALL) {}
-  explicit ObserverListThreadSafe(NotificationType type) : type_(type) {}
+      : type_(ObserverListBase<ObserverType>::NOTIFY_ALL),
+        delivery_(DELIVER_EACH) {}
+  explicit ObserverListThreadSafe(NotificationType type)
+      : type_(type),
+        delivery_(DELIVER_EACH) {}
+  ObserverListThreadSafe(NotificationType type, DeliveryMode delivery)
+      : type_(type),
+        delivery_(delivery) {}
 
   // Add an observer to the list.  An observer should not be added to
   // the same list more than once.
@@ -115,8 +142,10 @@ class ObserverListThreadSafe
     base::PlatformThreadId thread_id = base::PlatformThread::CurrentId();
     {
       base::AutoLock lock(list_lock_);
-      if (observer_lists_.find(thread_id) == observer_lists_.end())
+      if (observer_lists_.find(thread_id) == observer_lists_.end()) {
         observer_lists_[thread_id] = new ObserverListContext(type_);
+        snapshot_ = NULL;
+      }
       list = &(observer_lists_[thread_id]->list);
     }
     list->AddObserver(obs);
@@ -144,8 +173,10 @@ class ObserverListThreadSafe
 
       // If we're about to remove the last observer from the list,
       // then we can remove this observer_list entirely.
-      if (list->HasObserver(obs) && list->size() == 1)
+      if (list->HasObserver(obs) && list->size() == 1) {
         observer_lists_.erase(it);
+        snapshot_ = NULL;
+      }
     }
     list->RemoveObserver(obs);
 
@@ -200,18 +231,40 @@ class ObserverListThreadSafe
   // See comment above ObserverListThreadSafeTraits' definition.
   friend struct ObserverListThreadSafeTraits<ObserverType>;
 
+  // A notification bound to its arguments, waiting for an observer.
+  typedef base::Callback<void(ObserverType*)> Notification;
+
   struct ObserverListContext {
     explicit ObserverListContext(NotificationType type)
         : loop(base::MessageLoopProxy::current()),
-          list(type) {
+          list(type),
+          drain_posted(false) {
     }
 
     scoped_refptr<base::MessageLoopProxy> loop;
     ObserverList<ObserverType> list;
 
+    // For DELIVER_COALESCED, the notifications not yet delivered, and whether
+    // a task to deliver them has been posted.  Guarded by |list_lock_|.
+    std::deque<Notification> pending;
+    bool drain_posted;
+
     DISALLOW_COPY_AND_ASSIGN(ObserverListContext);
   };
 
+  // The threads to post notifications to.  The contexts are only used to
+  // recognize the thread's list when the task runs, since they may be gone
+  // by then.
+  struct ContextSnapshot
+      : public base::RefCountedThreadSafe<ContextSnapshot> {
+    std::vector<std::pair<scoped_refptr<base::MessageLoopProxy>,
+                          ObserverListContext*> > contexts;
+
+   private:
+    friend class base::RefCountedThreadSafe<ContextSnapshot>;
+    ~ContextSnapshot() {}
+  };
+
   ~ObserverListThreadSafe() {
     typename ObserversListMap::const_iterator it;
     for (it = observer_lists_.begin(); it != observer_lists_.end(); ++it)
@@ -221,17 +274,68 @@ class ObserverListThreadSafe
 
   template <class Method, class Params>
   void Notify(const UnboundMethod<ObserverType, Method, Params>& method) {
-    base::AutoLock lock(list_lock_);
-    typename ObserversListMap::iterator it;
-    for (it = observer_lists_.begin(); it != observer_lists_.end(); ++it) {
-      ObserverListContext* context = (*it).second;
-      context->loop->PostTask(
+    if (delivery_ == DELIVER_COALESCED) {
+      NotifyCoalesced(base::Bind(&ObserverListThreadSafe<ObserverType>::
+          template RunUnboundMethod<Method, Params>, method));
+      return;
+    }
+
+    scoped_refptr<ContextSnapshot> snapshot;
+    {
+      base::AutoLock lock(list_lock_);
+      if (!snapshot_) {
+        snapshot_ = new ContextSnapshot;
+        typename ObserversListMap::iterator it;
+        for (it = observer_lists_.begin(); it != observer_lists_.end(); ++it) {
+          snapshot_->contexts.push_back(
+              std::make_pair(it->second->loop, it->second));
+        }
+      }
+      snapshot = snapshot_;
+    }
+
+    for (size_t i = 0; i < snapshot->contexts.size(); ++i) {
+      snapshot->contexts[i].first->PostTask(
           FROM_HERE,
           base::Bind(&ObserverListThreadSafe<ObserverType>::
-              template NotifyWrapper<Method, Params>, this, context, method));
+              template NotifyWrapper<Method, Params>, this,
+              snapshot->contexts[i].second, method));
     }
   }
 
+  // Queues |notification| for every thread, and posts a task to deliver the
+  // queue to the threads that don't have one pending.
+  void NotifyCoalesced(const Notification& notification) {
+    std::vector<std::pair<scoped_refptr<base::MessageLoopProxy>,
+                          ObserverListContext*> > to_post;
+    {
+      base::AutoLock lock(list_lock_);
+      typename ObserversListMap::iterator it;
+      for (it = observer_lists_.begin(); it != observer_lists_.end(); ++it) {
+        ObserverListContext* context = it->second;
+        context->pending.push_back(notification);
+        if (!context->drain_posted) {
+          context->drain_posted = true;
+          to_post.push_back(std::make_pair(context->loop, context));
+        }
+      }
+    }
+
+    for (size_t i = 0; i < to_post.size(); ++i) {
+      to_post[i].first->PostTask(
+          FROM_HERE,
+          base::Bind(&ObserverListThreadSafe<ObserverType>::DrainWrapper,
+                     this, to_post[i].second));
+    }
+  }
+
+  template <class Method, class Params>
+  static void RunUnboundMethod(
+      const UnboundMethod<ObserverType, Method, Params>& method,
+      ObserverType* obs) {
+    method.Run(obs);
+  }
+
   // Wrapper which is called to fire the notifications for each thread's
   // ObserverList.  This function MUST be called on the thread which owns
   // the unsafe ObserverList.
@@ -242,14 +346,7 @@ class ObserverListThreadSafe
     // Check that this list still needs notifications.
     {
       base::AutoLock lock(list_lock_);
-      typename ObserversListMap::iterator it =
-          observer_lists_.find(base::PlatformThread::CurrentId());
-
-      // The ObserverList could have been removed already.  In fact, it could
-      // have been removed and then re-added!  If the master list's loop
-      // does not match this one, then we do not need to finish this
-      // notification.
-      if (it == observer_lists_.end() || it->second != context)
+      if (!IsCurrentContext(context))
         return;
     }
 
@@ -260,6 +357,51 @@ class ObserverListThreadSafe
         method.Run(obs);
     }
 
+    DeleteContextIfEmpty(context);
+  }
+
+  // Delivers the notifications queued for the current thread by
+  // NotifyCoalesced().  Like NotifyWrapper(), it MUST be called on the thread
+  // which owns the unsafe ObserverList.
+  void DrainWrapper(ObserverListContext* context) {
+    std::deque<Notification> notifications;
+    {
+      base::AutoLock lock(list_lock_);
+      if (!IsCurrentContext(context))
+        return;
+      notifications.swap(context->pending);
+      context->drain_posted = false;
+    }
+
+    for (size_t i = 0; i < notifications.size(); ++i) {
+      {
+        typename ObserverList<ObserverType>::Iterator it(context->list);
+        ObserverType* obs;
+        while ((obs = it.GetNext()) != NULL)
+          notifications[i].Run(obs);
+      }
+      // The observers may all have removed themselves.
+      if (context->list.size() == 0)
+        break;
+    }
+
+    DeleteContextIfEmpty(context);
+  }
+
+  // Returns true if |context| is the current thread's list.  The ObserverList
+  // could have been removed already.  In fact, it could have been removed and
+  // then re-added!  If the master list's context does not match this one,
+  // then we do not need to finish the notification.  Must be called with
+  // |list_lock_| held.
+  bool IsCurrentContext(ObserverListContext* context) {
+    list_lock_.AssertAcquired();
+    typename ObserversListMap::iterator it =
+        observer_lists_.find(base::PlatformThread::CurrentId());
+    return it != observer_lists_.end() && it->second == context;
+  }
+
+  // Called on the thread which owns |context| after notifying it.
+  void DeleteContextIfEmpty(ObserverListContext* context) {
     // If there are no more observers on the list, we can now delete it.
     if (context->list.size() == 0) {
       {
@@ -267,10 +409,10 @@ class ObserverListThreadSafe
         // Remove |list| if it's not already removed.
         // This can happen if multiple observers got removed in a notification.
         // See http://crbug.com/55725.
-        typename ObserversListMap::iterator it =
-            observer_lists_.find(base::PlatformThread::CurrentId());
-        if (it != observer_lists_.end() && it->second == context)
-          observer_lists_.erase(it);
+        if (IsCurrentContext(context)) {
+          observer_lists_.erase(base::PlatformThread::CurrentId());
+          snapshot_ = NULL;
+        }
       }
       delete context;
     }
@@ -282,9 +424,15 @@ class ObserverListThreadSafe
   typedef std::map<base::PlatformThreadId, ObserverListContext*>
       ObserversListMap;
 
-  base::Lock list_lock_;  // Protects the observer_lists_.
+  base::Lock list_lock_;  // Protects the observer_lists_ and snapshot_.
   ObserversListMap observer_lists_;
+
+  // The threads in |observer_lists_|, or NULL if it has changed since the
+  // last Notify().
+  scoped_refptr<ContextSnapshot> snapshot_;
+
   const NotificationType type_;
+  const DeliveryMode delivery_;
 
   DISALLOW_COPY_AND_ASSIGN(ObserverListThreadSafe);
 };
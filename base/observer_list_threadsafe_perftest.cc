@@ -0,0 +1,104 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/observer_list_threadsafe.h"
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kThreads = 4;
+const int kNotifications = 20000;
+
+class Counter {
+ public:
+  virtual void Observe(int x) = 0;
+
+ protected:
+  virtual ~Counter() {}
+};
+
+// Lives on one thread, and signals |done| after |kNotifications|.
+class CountingObserver : public Counter {
+ public:
+  explicit CountingObserver(base::WaitableEvent* done)
+      : done_(done),
+        count_(0) {
+  }
+
+  virtual void Observe(int x) OVERRIDE {
+    if (++count_ == kNotifications)
+      done_->Signal();
+  }
+
+ private:
+  base::WaitableEvent* done_;
+  int count_;
+};
+
+void AddObserver(ObserverListThreadSafe<Counter>* list,
+                 Counter* observer,
+                 base::WaitableEvent* added) {
+  list->AddObserver(observer);
+  added->Signal();
+}
+
+void RemoveObserver(ObserverListThreadSafe<Counter>* list,
+                    Counter* observer) {
+  list->RemoveObserver(observer);
+}
+
+// Sends a burst of notifications to an observer on each of |kThreads| threads
+// and logs the time per notification until all of them have been delivered.
+void RunBurstTest(ObserverListThreadSafe<Counter>::DeliveryMode delivery,
+                  const char* name) {
+  scoped_refptr<ObserverListThreadSafe<Counter> > list(
+      new ObserverListThreadSafe<Counter>(ObserverList<Counter>::NOTIFY_ALL,
+                                          delivery));
+  ScopedVector<base::Thread> threads;
+  ScopedVector<base::WaitableEvent> done;
+  ScopedVector<CountingObserver> observers;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(new base::Thread("ObserverThread"));
+    ASSERT_TRUE(threads[i]->Start());
+    done.push_back(new base::WaitableEvent(false, false));
+    observers.push_back(new CountingObserver(done[i]));
+
+    base::WaitableEvent added(false, false);
+    threads[i]->message_loop()->PostTask(
+        FROM_HERE,
+        base::Bind(&AddObserver, list, observers[i], &added));
+    added.Wait();
+  }
+
+  PerfTimer timer;
+  for (int i = 0; i < kNotifications; ++i)
+    list->Notify(&Counter::Observe, i);
+  for (int i = 0; i < kThreads; ++i)
+    done[i]->Wait();
+  LogPerfResult(name,
+                timer.Elapsed().InMicroseconds() * 1000.0 / kNotifications,
+                "ns/notify");
+
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->message_loop()->PostTask(
+        FROM_HERE, base::Bind(&RemoveObserver, list, observers[i]));
+    threads[i]->Stop();
+  }
+}
+
+}  // namespace
+
+TEST(ObserverListThreadSafePerfTest, Burst) {
+  RunBurstTest(ObserverListThreadSafe<Counter>::DELIVER_EACH,
+               "ObserverListThreadSafe_Burst_Each");
+  RunBurstTest(ObserverListThreadSafe<Counter>::DELIVER_COALESCED,
+               "ObserverListThreadSafe_Burst_Coalesced");
+}
@@ -7,6 +7,7 @@
 
 #include <vector>
 
+#include "base/bind.h"
 #include "base/compiler_specific.h"
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop.h"
@@ -229,6 +230,65 @@ TEST(ObserverListThreadSafeTest, BasicTest) {
   EXPECT_EQ(d.total, -10);
 }
 
+TEST(ObserverListThreadSafeTest, CoalescedBasicTest) {
+  MessageLoop loop;
+
+  scoped_refptr<ObserverListThreadSafe<Foo> > observer_list(
+      new ObserverListThreadSafe<Foo>(
+          ObserverList<Foo>::NOTIFY_ALL,
+          ObserverListThreadSafe<Foo>::DELIVER_COALESCED));
+  Adder a(1);
+  Adder b(-1);
+  Adder c(1);
+  ThreadSafeDisrupter evil(observer_list.get(), &c);
+
+  observer_list->AddObserver(&a);
+  observer_list->AddObserver(&b);
+  observer_list->AddObserver(&evil);
+  observer_list->AddObserver(&c);
+
+  // |evil| removes |c| during the first notification, so |c| doesn't get the
+  // second one either, though both were queued before it was removed.
+  observer_list->Notify(&Foo::Observe, 10);
+  observer_list->Notify(&Foo::Observe, 5);
+  loop.RunAllPending();
+
+  EXPECT_EQ(15, a.total);
+  EXPECT_EQ(-15, b.total);
+  EXPECT_EQ(0, c.total);
+}
+
+void RecordTotal(const Adder* adder, int* total) {
+  *total = adder->total;
+}
+
+// Notifications queued while a delivery task is pending go out with it, ahead
+// of tasks posted in between.
+TEST(ObserverListThreadSafeTest, CoalescedNotificationsShareATask) {
+  MessageLoop loop;
+
+  scoped_refptr<ObserverListThreadSafe<Foo> > observer_list(
+      new ObserverListThreadSafe<Foo>(
+          ObserverList<Foo>::NOTIFY_ALL,
+          ObserverListThreadSafe<Foo>::DELIVER_COALESCED));
+  Adder a(1);
+  observer_list->AddObserver(&a);
+
+  int total_between = -1;
+  observer_list->Notify(&Foo::Observe, 1);
+  loop.PostTask(FROM_HERE, base::Bind(&RecordTotal, &a, &total_between));
+  observer_list->Notify(&Foo::Observe, 2);
+  loop.RunAllPending();
+  EXPECT_EQ(3, total_between);
+
+  // Once delivered, the next notification posts a new task.
+  observer_list->Notify(&Foo::Observe, 4);
+  loop.PostTask(FROM_HERE, base::Bind(&RecordTotal, &a, &total_between));
+  loop.RunAllPending();
+  EXPECT_EQ(7, total_between);
+  EXPECT_EQ(7, a.total);
+}
+
 TEST(ObserverListThreadSafeTest, RemoveObserver) {
   MessageLoop loop;
 
@@ -355,15 +415,17 @@ TEST(ObserverListThreadSafeTest, RemoveMultipleObservers) {
 // from the observer list.  Optionally, if cross_thread_notifies is set
 // to true, the observer threads will also trigger notifications to
 // all observers.
-static void ThreadSafeObserverHarness(int num_threads,
-                                      bool cross_thread_notifies) {
+static void ThreadSafeObserverHarness(
+    int num_threads,
+    bool cross_thread_notifies,
+    ObserverListThreadSafe<Foo>::DeliveryMode delivery) {
   MessageLoop loop;
 
   const int kMaxThreads = 15;
   num_threads = num_threads > kMaxThreads ? kMaxThreads : num_threads;
 
   scoped_refptr<ObserverListThreadSafe<Foo> > observer_list(
-      new ObserverListThreadSafe<Foo>);
+      new ObserverListThreadSafe<Foo>(ObserverList<Foo>::NOTIFY_ALL, delivery));
   Adder a(1);
   Adder b(-1);
   Adder c(1);
@@ -399,13 +461,20 @@ static void ThreadSafeObserverHarness(int num_threads,
 TEST(ObserverListThreadSafeTest, CrossThreadObserver) {
   // Use 7 observer threads.  Notifications only come from
   // the main thread.
-  ThreadSafeObserverHarness(7, false);
+  ThreadSafeObserverHarness(7, false,
+                            ObserverListThreadSafe<Foo>::DELIVER_EACH);
 }
 
 TEST(ObserverListThreadSafeTest, CrossThreadNotifications) {
   // Use 3 observer threads.  Notifications will fire from
   // the main thread and all 3 observer threads.
-  ThreadSafeObserverHarness(3, true);
+  ThreadSafeObserverHarness(3, true,
+                            ObserverListThreadSafe<Foo>::DELIVER_EACH);
+}
+
+TEST(ObserverListThreadSafeTest, CrossThreadCoalescedNotifications) {
+  ThreadSafeObserverHarness(3, true,
+                            ObserverListThreadSafe<Foo>::DELIVER_COALESCED);
 }
 
 TEST(ObserverListThreadSafeTest, OutlivesMessageLoop) {
@@ -0,0 +1,69 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/once_closure.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+
+namespace base {
+
+OnceClosure::OnceClosure(const Closure& closure)
+    : inline_state_(NULL),
+      inline_invoke_(NULL),
+      closure_(closure) {
+}
+
+OnceClosure& OnceClosure::operator=(RValue& other) {
+  if (this != &other) {
+    Reset();
+    MoveFrom(&other);
+  }
+  return *this;
+}
+
+void OnceClosure::Reset() {
+  if (inline_state_) {
+    inline_state_->DestroyInPlace();
+    inline_state_ = NULL;
+    inline_invoke_ = NULL;
+  }
+  closure_.Reset();
+}
+
+void OnceClosure::Swap(OnceClosure* other) {
+  // Swaps mostly move a closure into or out of a null one, which takes a
+  // single copy of the inline storage.
+  if (!inline_state_ && !other->inline_state_) {
+    closure_.Swap(&other->closure_);
+  } else if (is_null()) {
+    MoveFrom(other);
+  } else if (other->is_null()) {
+    other->MoveFrom(this);
+  } else {
+    OnceClosure temp;
+    temp.MoveFrom(other);
+    other->MoveFrom(this);
+    MoveFrom(&temp);
+  }
+}
+
+void OnceClosure::MoveFrom(OnceClosure* other) {
+  DCHECK(is_null());
+  if (other->inline_state_) {
+    // IsMemcpyMovable<> guarantees that the bind state survives being copied
+    // byte for byte, as long as the original is never used again.
+    memcpy(storage_, other->storage_, sizeof(storage_));
+    inline_state_ = reinterpret_cast<internal::BindStateBase*>(
+        storage_ + (reinterpret_cast<char*>(other->inline_state_) -
+                    other->storage_));
+    inline_invoke_ = other->inline_invoke_;
+    other->inline_state_ = NULL;
+    other->inline_invoke_ = NULL;
+  }
+  closure_.Swap(&other->closure_);
+}
+
+}  // namespace base
@@ -0,0 +1,144 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_ONCE_CLOSURE_H_
+#define BASE_ONCE_CLOSURE_H_
+#pragma once
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/callback.h"
+
+namespace base {
+
+namespace internal {
+class BindStateBase;
+class OnceClosureBuilder;
+}  // namespace internal
+
+// OnceClosure is a Closure that can be moved but not copied, for tasks that
+// are run once, like the ones posted to a MessageLoop.
+//
+// BindOnce() (see base/bind.h) stores small bind states inside the
+// OnceClosure instead of on the heap, as long as the functor and the bound
+// arguments can be moved with memcpy (see IsMemcpyMovable<> in
+// base/bind_internal.h).  Such a closure is bound, moved through the task
+// queues and run without allocating memory or touching a reference count.
+// Any other closure holds a reference to a bind state on the heap, as a
+// Closure does.  A OnceClosure made from a Closure shares its bind state.
+//
+// Like scoped_ptr, a OnceClosure is passed along with Pass():
+//
+//   base::OnceClosure task = base::BindOnce(&Foo::Bar, foo, 42);
+//   message_loop->PostTask(FROM_HERE, task.Pass());
+class BASE_EXPORT OnceClosure {
+  // What MOVE_ONLY_TYPE_FOR_CPP_03 (see base/move.h) declares.  The macro
+  // can't be used here because it derives RValue from the class in its
+  // body, which only compiles for templates.
+ private:
+  struct RValue;
+  OnceClosure(OnceClosure&);
+  void operator=(OnceClosure&);
+
+ public:
+  operator RValue&() { return *reinterpret_cast<RValue*>(this); }
+  OnceClosure Pass() { return OnceClosure(*reinterpret_cast<RValue*>(this)); }
+
+  // Size of the storage for bind states kept inline: enough for a method,
+  // its object and a few word-sized arguments.
+  enum { kInlineStorageSize = 64 };
+
+  OnceClosure() : inline_state_(NULL), inline_invoke_(NULL) {}
+
+  // Shares |closure|'s bind state.
+  explicit OnceClosure(const Closure& closure);
+
+  // Move constructor and move assignment, used by Pass().
+  OnceClosure(RValue& other) : inline_state_(NULL), inline_invoke_(NULL) {
+    MoveFrom(reinterpret_cast<OnceClosure*>(&other));
+  }
+  OnceClosure& operator=(RValue& other);
+
+  ~OnceClosure() {
+    if (inline_state_)
+      Reset();
+  }
+
+  bool is_null() const { return !inline_state_ && closure_.is_null(); }
+
+  // Destroys or releases the bind state, making the closure null.
+  void Reset();
+
+  // Runs the closure, which must not be null.
+  void Run() const {
+    if (inline_state_)
+      inline_invoke_(inline_state_);
+    else
+      closure_.Run();
+  }
+
+  // Exchanges the closure with |other|.
+  void Swap(OnceClosure* other);
+
+ private:
+  friend class internal::OnceClosureBuilder;
+
+  typedef void(*InlineInvokeFunc)(internal::BindStateBase*);
+
+  // Moves the bind state of |other| into this closure, which must be null,
+  // and leaves |other| null.
+  void MoveFrom(OnceClosure* other);
+
+  // The bind state when it is stored in |storage_|, and NULL otherwise.
+  internal::BindStateBase* inline_state_;
+
+  // Runs |inline_state_|.
+  InlineInvokeFunc inline_invoke_;
+
+  // Holds the inline bind state.  The other members of the union align it
+  // for any bound argument.
+  union {
+    char storage_[kInlineStorageSize];
+    double align_double_;
+    long double align_long_double_;
+    int64 align_int64_;
+    void* align_pointer_;
+  };
+
+  // The closure when its bind state is on the heap.
+  Closure closure_;
+};
+
+struct OnceClosure::RValue : public OnceClosure {
+  RValue();
+  ~RValue();
+  RValue(const RValue&);
+  void operator=(const RValue&);
+};
+
+namespace internal {
+
+// Lets BindOnce() construct bind states inside a OnceClosure.
+class OnceClosureBuilder {
+ public:
+  // Returns the inline storage of |closure|, which must be null.
+  static void* GetStorage(OnceClosure* closure) {
+    return closure->storage_;
+  }
+
+  // Makes |closure| run |bind_state|, which was constructed in the storage
+  // returned by GetStorage().
+  template <typename BindStateType>
+  static void SetInlineState(OnceClosure* closure,
+                             BindStateType* bind_state) {
+    closure->inline_state_ = bind_state;
+    closure->inline_invoke_ = &BindStateType::InvokerType::Run;
+  }
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_ONCE_CLOSURE_H_
@@ -0,0 +1,154 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/once_closure.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/ref_counted.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class Counter : public RefCountedThreadSafe<Counter> {
+ public:
+  Counter() : count_(0) {}
+
+  void Increment() { ++count_; }
+  void Add(int amount) { count_ += amount; }
+  int count() const { return count_; }
+
+ private:
+  friend class RefCountedThreadSafe<Counter>;
+  ~Counter() {}
+
+  int count_;
+};
+
+void Increment(int* value) {
+  ++*value;
+}
+
+void AppendTo(std::string* result, const std::string& text) {
+  result->append(text);
+}
+
+void AddToCounter(const scoped_refptr<Counter>& counter, int amount) {
+  counter->Add(amount);
+}
+
+class Deleted {
+ public:
+  explicit Deleted(bool* deleted) : deleted_(deleted) {}
+  ~Deleted() { *deleted_ = true; }
+
+  void Run() {}
+
+ private:
+  bool* deleted_;
+};
+
+TEST(OnceClosureTest, Null) {
+  OnceClosure closure;
+  EXPECT_TRUE(closure.is_null());
+
+  OnceClosure from_null_closure = OnceClosure(Closure());
+  EXPECT_TRUE(from_null_closure.is_null());
+}
+
+TEST(OnceClosureTest, RunInline) {
+  int value = 0;
+  OnceClosure closure = BindOnce(&Increment, &value);
+  ASSERT_FALSE(closure.is_null());
+  closure.Run();
+  EXPECT_EQ(1, value);
+
+  OnceClosure moved = closure.Pass();
+  EXPECT_TRUE(closure.is_null());
+  moved.Run();
+  EXPECT_EQ(2, value);
+}
+
+// A std::string may point into itself, so its bind state is kept on the heap.
+TEST(OnceClosureTest, RunOnHeap) {
+  std::string result;
+  OnceClosure closure = BindOnce(&AppendTo, &result, std::string("abc"));
+  OnceClosure moved = closure.Pass();
+  EXPECT_TRUE(closure.is_null());
+  moved.Run();
+  EXPECT_EQ("abc", result);
+}
+
+TEST(OnceClosureTest, FromClosure) {
+  int value = 0;
+  Closure closure = Bind(&Increment, &value);
+  OnceClosure once_closure(closure);
+  once_closure.Run();
+  closure.Run();
+  EXPECT_EQ(2, value);
+}
+
+// Moving an inline bind state doesn't touch the reference counts of what it
+// holds, and destroying it releases them.
+TEST(OnceClosureTest, MoveKeepsReferences) {
+  scoped_refptr<Counter> counter(new Counter);
+  OnceClosure closure = BindOnce(&Counter::Increment, counter.get());
+  EXPECT_FALSE(counter->HasOneRef());
+
+  OnceClosure moved = closure.Pass();
+  OnceClosure moved_again;
+  moved_again = moved.Pass();
+  moved_again.Run();
+  EXPECT_EQ(1, counter->count());
+
+  moved_again.Reset();
+  EXPECT_TRUE(moved_again.is_null());
+  EXPECT_TRUE(counter->HasOneRef());
+
+  OnceClosure with_scoped_refptr = BindOnce(&AddToCounter, counter, 2);
+  EXPECT_FALSE(counter->HasOneRef());
+  OnceClosure moved_scoped_refptr = with_scoped_refptr.Pass();
+  moved_scoped_refptr.Run();
+  EXPECT_EQ(3, counter->count());
+  moved_scoped_refptr.Reset();
+  EXPECT_TRUE(counter->HasOneRef());
+}
+
+TEST(OnceClosureTest, DestroyOwned) {
+  bool deleted = false;
+  {
+    OnceClosure closure =
+        BindOnce(&Deleted::Run, Owned(new Deleted(&deleted)));
+    OnceClosure moved = closure.Pass();
+    EXPECT_FALSE(deleted);
+  }
+  EXPECT_TRUE(deleted);
+}
+
+TEST(OnceClosureTest, Swap) {
+  int value = 0;
+  std::string result;
+  OnceClosure inline_closure = BindOnce(&Increment, &value);
+  OnceClosure heap_closure =
+      BindOnce(&AppendTo, &result, std::string("abc"));
+
+  inline_closure.Swap(&heap_closure);
+  inline_closure.Run();
+  EXPECT_EQ("abc", result);
+  heap_closure.Run();
+  EXPECT_EQ(1, value);
+
+  OnceClosure null_closure;
+  null_closure.Swap(&heap_closure);
+  EXPECT_TRUE(heap_closure.is_null());
+  null_closure.Run();
+  EXPECT_EQ(2, value);
+}
+
+}  // namespace
+
+}  // namespace base
@@ -4,6 +4,9 @@
 
 #include "base/pending_task.h"
 
+#include <algorithm>
+
+#include "base/logging.h"
 #include "base/tracked_objects.h"
 
 namespace base {
@@ -28,9 +31,47 @@ PendingTask::PendingTask(const tracked_objects::Location& posted_from,
       nestable(nestable) {
 }
 
+PendingTask::PendingTask(const tracked_objects::Location& posted_from,
+                         OnceClosure task,
+                         TimeTicks delayed_run_time,
+                         bool nestable)
+    : base::TrackingInfo(posted_from, delayed_run_time),
+      task(task.Pass()),
+      posted_from(posted_from),
+      sequence_num(0),
+      nestable(nestable) {
+}
+
+PendingTask::PendingTask(PendingTask* other)
+    : base::TrackingInfo(*other),
+      posted_from(other->posted_from),
+      sequence_num(other->sequence_num),
+      nestable(other->nestable) {
+  task.Swap(&other->task);
+}
+
+PendingTask::PendingTask(const PendingTask& other)
+    : base::TrackingInfo(other),
+      posted_from(other.posted_from),
+      sequence_num(other.sequence_num),
+      nestable(other.nestable) {
+  // A copy would silently drop the closure, so crash rather than lose a task.
+  CHECK(other.task.is_null());
+}
+
 PendingTask::~PendingTask() {
 }
 
+void PendingTask::Swap(PendingTask* other) {
+  std::swap(birth_tally, other->birth_tally);
+  std::swap(time_posted, other->time_posted);
+  std::swap(delayed_run_time, other->delayed_run_time);
+  task.Swap(&other->task);
+  std::swap(posted_from, other->posted_from);
+  std::swap(sequence_num, other->sequence_num);
+  std::swap(nestable, other->nestable);
+}
+
 bool PendingTask::operator<(const PendingTask& other) const {
   // Since the top of a priority queue is defined as the "greatest" element, we
   // need to invert the comparison here.  We want the smaller time to be at the
@@ -51,4 +92,56 @@ void TaskQueue::Swap(TaskQueue* queue) {
   c.swap(queue->c);  // Calls std::deque::swap.
 }
 
+void TaskQueue::PushByMove(PendingTask* pending_task) {
+  // Copy the task while its closure is null, then move the closure in.
+  OnceClosure task;
+  task.Swap(&pending_task->task);
+  push(*pending_task);
+  back().task.Swap(&task);
+}
+
+DelayedTaskQueue::DelayedTaskQueue() {
+}
+
+DelayedTaskQueue::~DelayedTaskQueue() {
+}
+
+void DelayedTaskQueue::PushByMove(PendingTask* pending_task) {
+  OnceClosure task;
+  task.Swap(&pending_task->task);
+  heap_.push_back(*pending_task);
+  heap_.back().task.Swap(&task);
+
+  // Sift the new task up.  PendingTask::operator< is inverted, so the task
+  // that should run first is the greatest.
+  size_t index = heap_.size() - 1;
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!(heap_[parent] < heap_[index]))
+      break;
+    heap_[parent].Swap(&heap_[index]);
+    index = parent;
+  }
+}
+
+void DelayedTaskQueue::pop() {
+  DCHECK(!heap_.empty());
+  heap_.front().Swap(&heap_.back());
+  heap_.pop_back();
+
+  // Sift the task that was last down from the top.
+  size_t index = 0;
+  for (;;) {
+    size_t child = 2 * index + 1;
+    if (child >= heap_.size())
+      break;
+    if (child + 1 < heap_.size() && heap_[child] < heap_[child + 1])
+      ++child;
+    if (!(heap_[index] < heap_[child]))
+      break;
+    heap_[index].Swap(&heap_[child]);
+    index = child;
+  }
+}
+
 }  // namespace base
@@ -6,11 +6,14 @@
 #define PENDING_TASK_H_
 #pragma once
 
+#include <deque>
 #include <queue>
 
 #include "base/base_export.h"
+#include "base/basictypes.h"
 #include "base/callback.h"
 #include "base/location.h"
+#include "base/once_closure.h"
 #include "base/time.h"
 #include "base/tracking_info.h"
 
@@ -25,13 +28,28 @@ struct BASE_EXPORT PendingTask : public TrackingInfo {
               const Closure& task,
               TimeTicks delayed_run_time,
               bool nestable);
+  PendingTask(const tracked_objects::Location& posted_from,
+              OnceClosure task,
+              TimeTicks delayed_run_time,
+              bool nestable);
+  // Copies everything from |other| except its closure, which is moved, leaving
+  // |other->task| null.
+  explicit PendingTask(PendingTask* other);
+  // The closure can't be copied, so |other.task| must be null; copying a task
+  // that still holds its closure CHECKs, even in release builds.  This exists
+  // only because the standard containers behind the queues below need it; they
+  // copy a task with its closure moved out and then move the closure back in.
+  PendingTask(const PendingTask& other);
   ~PendingTask();
 
+  // Exchanges everything, closure included, with |other|.
+  void Swap(PendingTask* other);
+
   // Used to support sorting.
   bool operator<(const PendingTask& other) const;
 
   // The task to run.
-  Closure task;
+  OnceClosure task;
 
   // The site this PendingTask was posted from.
   tracked_objects::Location posted_from;
@@ -43,15 +61,45 @@ struct BASE_EXPORT PendingTask : public TrackingInfo {
   bool nestable;
 };
 
-// Wrapper around std::queue specialized for PendingTask which adds a Swap
-// helper method.
+// Wrapper around std::queue specialized for PendingTask which adds Swap and
+// PushByMove helper methods.
 class BASE_EXPORT TaskQueue : public std::queue<PendingTask> {
  public:
   void Swap(TaskQueue* queue);
+
+  // Like push(), but moves |pending_task|'s closure into the queue rather than
+  // copying it, leaving |pending_task->task| null.
+  void PushByMove(PendingTask* pending_task);
 };
 
-// PendingTasks are sorted by their |delayed_run_time| property.
-typedef std::priority_queue<base::PendingTask> DelayedTaskQueue;
+// Priority queue of PendingTasks, sorted by their |delayed_run_time| property.
+// std::priority_queue copies its elements around, which PendingTask doesn't
+// allow, so this is a binary heap that swaps them instead.
+class BASE_EXPORT DelayedTaskQueue {
+ public:
+  DelayedTaskQueue();
+  ~DelayedTaskQueue();
+
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+
+  // The task that should run first.  The non-const version lets its closure be
+  // moved out before pop().
+  const PendingTask& top() const { return heap_.front(); }
+  PendingTask& top() { return heap_.front(); }
+
+  // Moves |pending_task| into the queue, leaving |pending_task->task| null.
+  void PushByMove(PendingTask* pending_task);
+
+  void pop();
+
+ private:
+  // The heap, with top() first.  A deque, so that growing it doesn't copy the
+  // tasks.
+  std::deque<PendingTask> heap_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayedTaskQueue);
+};
 
 }  // namespace base
 
@@ -0,0 +1,69 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/pending_task.h"
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void Increment(int* value) {
+  ++*value;
+}
+
+void PushTask(DelayedTaskQueue* queue, int64 delay_ms, int sequence_num) {
+  PendingTask pending_task(
+      FROM_HERE, Bind(&DoNothing),
+      TimeTicks() + TimeDelta::FromMilliseconds(delay_ms), true);
+  pending_task.sequence_num = sequence_num;
+  queue->PushByMove(&pending_task);
+  EXPECT_TRUE(pending_task.task.is_null());
+}
+
+}  // namespace
+
+TEST(PendingTaskTest, Swap) {
+  int value = 0;
+  PendingTask task1(FROM_HERE, BindOnce(&Increment, &value), TimeTicks(),
+                    true);
+  PendingTask task2(FROM_HERE, Closure());
+  task1.sequence_num = 1;
+  task2.sequence_num = 2;
+
+  task1.Swap(&task2);
+  EXPECT_EQ(2, task1.sequence_num);
+  EXPECT_TRUE(task1.task.is_null());
+  EXPECT_EQ(1, task2.sequence_num);
+  task2.task.Run();
+  EXPECT_EQ(1, value);
+}
+
+// Tasks come out earliest first, and in push order when they are due at the
+// same time.
+TEST(PendingTaskTest, DelayedTaskQueueOrder) {
+  const int64 kDelays[] = { 50, 10, 30, 10, 70, 20, 30, 60, 10, 40 };
+  DelayedTaskQueue queue;
+  for (size_t i = 0; i < arraysize(kDelays); ++i)
+    PushTask(&queue, kDelays[i], static_cast<int>(i));
+  ASSERT_EQ(arraysize(kDelays), queue.size());
+
+  TimeTicks last_run_time;
+  int last_sequence_num = -1;
+  while (!queue.empty()) {
+    PendingTask pending_task(&queue.top());
+    queue.pop();
+    ASSERT_FALSE(pending_task.task.is_null());
+    EXPECT_LE(last_run_time, pending_task.delayed_run_time);
+    if (last_run_time == pending_task.delayed_run_time)
+      EXPECT_LT(last_sequence_num, pending_task.sequence_num);
+    last_run_time = pending_task.delayed_run_time;
+    last_sequence_num = pending_task.sequence_num;
+  }
+}
+
+}  // namespace base
@@ -21,7 +21,9 @@ Pickle::Pickle()
     : header_(NULL),
       header_size_(sizeof(Header)),
       capacity_(0),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      segment_size_(0),
+      first_payload_size_(0) {
   Resize(kPayloadUnit);
   header_->payload_size = 0;
 }
@@ -30,7 +32,9 @@ Pickle::Pickle(int header_size)
     : header_(NULL),
       header_size_(AlignInt(header_size, sizeof(uint32))),
       capacity_(0),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      segment_size_(0),
+      first_payload_size_(0) {
   DCHECK_GE(static_cast<size_t>(header_size), sizeof(Header));
   DCHECK_LE(header_size, kPayloadUnit);
   Resize(kPayloadUnit);
@@ -41,7 +45,9 @@ Pickle::Pickle(const char* data, int data_len)
     : header_(reinterpret_cast<Header*>(const_cast<char*>(data))),
       header_size_(0),
       capacity_(kCapacityReadOnly),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      segment_size_(0),
+      first_payload_size_(0) {
   if (data_len >= static_cast<int>(sizeof(Header)))
     header_size_ = data_len - header_->payload_size;
 
@@ -60,14 +66,16 @@ Pickle::Pickle(const Pickle& other)
     : header_(NULL),
       header_size_(other.header_size_),
       capacity_(0),
-      variable_buffer_offset_(other.variable_buffer_offset_) {
-  size_t payload_size = header_size_ + other.header_->payload_size;
-  bool resized = Resize(payload_size);
+      variable_buffer_offset_(other.variable_buffer_offset_),
+      segment_size_(other.segment_size_),
+      first_payload_size_(0) {
+  bool resized = Resize(other.size());
   CHECK(resized);  // Realloc failed.
-  memcpy(header_, other.header_, payload_size);
+  CopyDataFrom(other);
 }
 
 Pickle::~Pickle() {
+  FreeSegments();
   if (capacity_ != kCapacityReadOnly)
     free(header_);
 }
@@ -81,19 +89,60 @@ Pickle& Pickle::operator=(const Pickle& other) {
     header_ = NULL;
     capacity_ = 0;
   }
+  FreeSegments();
   if (header_size_ != other.header_size_) {
     free(header_);
     header_ = NULL;
     header_size_ = other.header_size_;
   }
-  bool resized = Resize(other.header_size_ + other.header_->payload_size);
+  bool resized = Resize(other.size());
   CHECK(resized);  // Realloc failed.
-  memcpy(header_, other.header_,
-         other.header_size_ + other.header_->payload_size);
+  CopyDataFrom(other);
   variable_buffer_offset_ = other.variable_buffer_offset_;
+  segment_size_ = other.segment_size_;
   return *this;
 }
 
+void Pickle::EnableSegments(size_t segment_size) {
+  DCHECK_NE(kCapacityReadOnly, capacity_);
+  DCHECK_GT(segment_size, 0U);
+  segment_size_ = segment_size;
+}
+
+void Pickle::Flatten() {
+  if (segments_.empty())
+    return;
+  bool resized = Resize(size());
+  CHECK(resized);  // Realloc failed.
+  char* dest = payload() + first_payload_size_;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    memcpy(dest, segments_[i].data, segments_[i].size);
+    dest += segments_[i].size;
+  }
+  FreeSegments();
+}
+
+const char* Pickle::GetDataSegment(size_t offset, size_t* length) const {
+  DCHECK_LT(offset, size());
+  size_t first_size = header_size_ +
+      (segments_.empty() ? payload_size() : first_payload_size_);
+  if (offset < first_size) {
+    *length = first_size - offset;
+    return reinterpret_cast<const char*>(header_) + offset;
+  }
+  offset -= first_size;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    if (offset < segments_[i].size) {
+      *length = segments_[i].size - offset;
+      return segments_[i].data + offset;
+    }
+    offset -= segments_[i].size;
+  }
+  NOTREACHED();
+  *length = 0;
+  return NULL;
+}
+
 bool Pickle::ReadBool(void** iter, bool* result) const {
   DCHECK(iter);
 
@@ -107,10 +156,7 @@ bool Pickle::ReadBool(void** iter, bool* result) const {
 
 bool Pickle::ReadInt(void** iter, int* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   // TODO(jar): http://crbug.com/13108 Pickle should be cleaned up, and not
@@ -124,10 +170,7 @@ bool Pickle::ReadInt(void** iter, int* result) const {
 
 bool Pickle::ReadLong(void** iter, long* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   // TODO(jar): http://crbug.com/13108 Pickle should be cleaned up, and not
@@ -140,10 +183,7 @@ bool Pickle::ReadLong(void** iter, long* result) const {
 
 bool Pickle::ReadSize(void** iter, size_t* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   // TODO(jar): http://crbug.com/13108 Pickle should be cleaned up, and not
@@ -157,10 +197,7 @@ bool Pickle::ReadSize(void** iter, size_t* result) const {
 
 bool Pickle::ReadUInt16(void** iter, uint16* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   memcpy(result, *iter, sizeof(*result));
@@ -171,10 +208,7 @@ bool Pickle::ReadUInt16(void** iter, uint16* result) const {
 
 bool Pickle::ReadUInt32(void** iter, uint32* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   memcpy(result, *iter, sizeof(*result));
@@ -185,10 +219,7 @@ bool Pickle::ReadUInt32(void** iter, uint32* result) const {
 
 bool Pickle::ReadInt64(void** iter, int64* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   memcpy(result, *iter, sizeof(*result));
@@ -199,10 +230,7 @@ bool Pickle::ReadInt64(void** iter, int64* result) const {
 
 bool Pickle::ReadUInt64(void** iter, uint64* result) const {
   DCHECK(iter);
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, sizeof(*result)))
+  if (!PrepareRead(iter, sizeof(*result)))
     return false;
 
   memcpy(result, *iter, sizeof(*result));
@@ -217,7 +245,7 @@ bool Pickle::ReadString(void** iter, std::string* result) const {
   int len;
   if (!ReadLength(iter, &len))
     return false;
-  if (!IteratorHasRoomFor(*iter, len))
+  if (!PrepareRead(iter, len))
     return false;
 
   char* chars = reinterpret_cast<char*>(*iter);
@@ -236,7 +264,7 @@ bool Pickle::ReadWString(void** iter, std::wstring* result) const {
   // Avoid integer overflow.
   if (len > INT_MAX / static_cast<int>(sizeof(wchar_t)))
     return false;
-  if (!IteratorHasRoomFor(*iter, len * sizeof(wchar_t)))
+  if (!PrepareRead(iter, len * sizeof(wchar_t)))
     return false;
 
   wchar_t* chars = reinterpret_cast<wchar_t*>(*iter);
@@ -252,7 +280,7 @@ bool Pickle::ReadString16(void** iter, string16* result) const {
   int len;
   if (!ReadLength(iter, &len))
     return false;
-  if (!IteratorHasRoomFor(*iter, len * sizeof(char16)))
+  if (!PrepareRead(iter, len * sizeof(char16)))
     return false;
 
   char16* chars = reinterpret_cast<char16*>(*iter);
@@ -279,10 +307,7 @@ bool Pickle::ReadBytes(void** iter, const char** data, int length) const {
   DCHECK(iter);
   DCHECK(data);
   *data = 0;
-  if (!*iter)
-    *iter = const_cast<char*>(payload());
-
-  if (!IteratorHasRoomFor(*iter, length))
+  if (!PrepareRead(iter, length))
     return false;
 
   *data = reinterpret_cast<const char*>(*iter);
@@ -341,15 +366,19 @@ char* Pickle::BeginWriteData(int length) {
   DCHECK_EQ(variable_buffer_offset_, 0U) <<
     "There can only be one variable buffer in a Pickle";
 
-  if (length < 0 || !WriteInt(length))
+  if (length < 0)
     return NULL;
 
-  char *data_ptr = BeginWrite(length);
-  if (!data_ptr)
+  // Write the length together with the data so that they are always in the
+  // same segment.
+  char* length_ptr = BeginWrite(sizeof(int) + length);
+  if (!length_ptr)
     return NULL;
+  memcpy(length_ptr, &length, sizeof(int));
+  char* data_ptr = length_ptr + sizeof(int);
 
   variable_buffer_offset_ =
-      data_ptr - reinterpret_cast<char*>(header_) - sizeof(int);
+      header_size_ + header_->payload_size - length - sizeof(int);
 
   // EndWrite doesn't necessarily have to be called after the write operation,
   // so we call it here to pad out what the caller will eventually write.
@@ -361,8 +390,9 @@ void Pickle::TrimWriteData(int new_length) {
   DCHECK_NE(variable_buffer_offset_, 0U);
 
   // Fetch the the variable buffer size
-  int* cur_length = reinterpret_cast<int*>(
-      reinterpret_cast<char*>(header_) + variable_buffer_offset_);
+  size_t length;
+  int* cur_length = reinterpret_cast<int*>(const_cast<char*>(
+      GetDataSegment(variable_buffer_offset_, &length)));
 
   if (new_length < 0 || new_length > *cur_length) {
     NOTREACHED() << "Invalid length in TrimWriteData.";
@@ -371,6 +401,8 @@ void Pickle::TrimWriteData(int new_length) {
 
   // Update the payload size and variable buffer size
   header_->payload_size -= (*cur_length - new_length);
+  if (!segments_.empty())
+    segments_.back().size -= (*cur_length - new_length);
   *cur_length = new_length;
 }
 
@@ -380,17 +412,54 @@ char* Pickle::BeginWrite(size_t length) {
 
   size_t new_size = offset + length;
   size_t needed_size = header_size_ + new_size;
-  if (needed_size > capacity_ && !Resize(std::max(capacity_ * 2, needed_size)))
-    return NULL;
 
 #ifdef ARCH_CPU_64_BITS
   DCHECK_LE(length, kuint32max);
 #endif
 
+  if (!segments_.empty() ||
+      (segment_size_ && needed_size > capacity_ &&
+       needed_size > segment_size_)) {
+    return BeginWriteSegment(offset, length);
+  }
+
+  if (needed_size > capacity_ && !Resize(std::max(capacity_ * 2, needed_size)))
+    return NULL;
+
   header_->payload_size = static_cast<uint32>(new_size);
   return payload() + offset;
 }
 
+char* Pickle::BeginWriteSegment(size_t offset, size_t length) {
+  // The gap between the current end of the payload and |offset| is padding
+  // that belongs to the segment which is currently last.
+  size_t padding = offset - header_->payload_size;
+  if (!segments_.empty()) {
+    Segment& last = segments_.back();
+    size_t start = last.size + padding;
+    if (start + length <= last.capacity) {
+      last.size = start + length;
+      header_->payload_size = static_cast<uint32>(offset + length);
+      return last.data + start;
+    }
+  }
+
+  Segment segment;
+  segment.capacity = AlignInt(std::max(segment_size_, length), kPayloadUnit);
+  segment.data = static_cast<char*>(malloc(segment.capacity));
+  if (!segment.data)
+    return NULL;
+  segment.size = length;
+
+  if (segments_.empty())
+    first_payload_size_ = offset;
+  else
+    segments_.back().size += padding;
+  segments_.push_back(segment);
+  header_->payload_size = static_cast<uint32>(offset + length);
+  return segment.data;
+}
+
 void Pickle::EndWrite(char* dest, int length) {
   // Zero-pad to keep tools like valgrind from complaining about uninitialized
   // memory.
@@ -411,6 +480,64 @@ bool Pickle::Resize(size_t new_capacity) {
   return true;
 }
 
+bool Pickle::PrepareRead(void** iter, int len) const {
+  if (!*iter)
+    *iter = const_cast<char*>(payload());
+  if (segments_.empty())
+    return IteratorHasRoomFor(*iter, len);
+
+  // A value is never split between segments, so one that would start at the
+  // end of a segment starts at the beginning of the next one instead.
+  const char* position = static_cast<const char*>(*iter);
+  if (position == payload() + first_payload_size_)
+    position = segments_[0].data;
+  for (size_t i = 0; i + 1 < segments_.size(); ++i) {
+    if (position == segments_[i].data + segments_[i].size)
+      position = segments_[i + 1].data;
+  }
+  *iter = const_cast<char*>(position);
+  return SegmentHasRoomFor(position, len);
+}
+
+bool Pickle::SegmentHasRoomFor(const void* iter, int len) const {
+  if (len < 0)
+    return false;
+  const char* position = static_cast<const char*>(iter);
+  const char* start = payload();
+  size_t size = first_payload_size_;
+  for (size_t i = 0; i <= segments_.size(); ++i) {
+    if (i > 0) {
+      start = segments_[i - 1].data;
+      size = segments_[i - 1].size;
+    }
+    // Compare sizes rather than pointers, which could wrap.
+    if (position >= start && position <= start + size &&
+        static_cast<size_t>(len) <= size - (position - start)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Pickle::CopyDataFrom(const Pickle& other) {
+  size_t first_size = other.header_size_ + (other.segments_.empty() ?
+      other.payload_size() : other.first_payload_size_);
+  DCHECK_LE(other.size(), capacity_);
+  memcpy(header_, other.header_, first_size);
+  char* dest = reinterpret_cast<char*>(header_) + first_size;
+  for (size_t i = 0; i < other.segments_.size(); ++i) {
+    memcpy(dest, other.segments_[i].data, other.segments_[i].size);
+    dest += other.segments_[i].size;
+  }
+}
+
+void Pickle::FreeSegments() {
+  for (size_t i = 0; i < segments_.size(); ++i)
+    free(segments_[i].data);
+  segments_.clear();
+  first_payload_size_ = 0;
+}
+
 // static
 const char* Pickle::FindNext(size_t header_size,
                              const char* start,
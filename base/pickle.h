@@ -7,6 +7,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
@@ -31,6 +32,15 @@
 // space is controlled by the header_size parameter passed to the Pickle
 // constructor.
 //
+// By default the header and payload are kept in a single buffer, which is
+// reallocated as the Pickle grows.  A Pickle that may become large can
+// instead be told to EnableSegments(), after which it grows by chaining new
+// buffers once its data outgrows the first one, so that what has been written
+// is never copied again.  Such a Pickle can be read, and its data sent with
+// a scatter/gather write using GetDataSegment(), without copying the segments
+// together.  Flatten() copies them into a single buffer, which data()
+// requires.
+//
 class BASE_EXPORT Pickle {
  public:
   // Initialize a Pickle object using the default header size.
@@ -63,8 +73,28 @@ class BASE_EXPORT Pickle {
   // Returns the size of the Pickle's data.
   size_t size() const { return header_size_ + header_->payload_size; }
 
-  // Returns the data for this Pickle.
-  const void* data() const { return header_; }
+  // Returns the data for this Pickle.  A Pickle whose data is split across
+  // segments must be flattened first.
+  const void* data() const {
+    DCHECK(segments_.empty()) << "Flatten() the Pickle first";
+    return header_;
+  }
+
+  // Copies the segments of the Pickle's data, if there are any, into a single
+  // buffer, so that data() can be called.
+  void Flatten();
+
+  // Makes the Pickle grow by chaining segments of at least |segment_size|
+  // bytes once its data no longer fits in |segment_size| bytes, rather than
+  // by reallocating its buffer.  The header always stays in the first buffer.
+  void EnableSegments(size_t segment_size);
+
+  // Returns the run of the Pickle's data that starts |offset| bytes into
+  // data() and is contiguous in memory, and stores its length in |length|.
+  // Unlike Flatten(), this does not copy any segments together, so it can be
+  // used to gather the data for a write.  |offset| must be less than size().
+  // The pointer is only valid until the next write to the Pickle.
+  const char* GetDataSegment(size_t offset, size_t* length) const;
 
   // Methods for reading the payload of the Pickle.  To read from the start of
   // the Pickle, initialize *iter to NULL.  If successful, these methods return
@@ -166,6 +196,8 @@ class BASE_EXPORT Pickle {
   // length. If there is no room for the given data before the end of the
   // payload, returns false.
   bool IteratorHasRoomFor(const void* iter, int len) const {
+    if (!segments_.empty())
+      return SegmentHasRoomFor(iter, len);
     if ((len < 0) || (iter < header_) || iter > end_of_payload())
       return false;
     const char* end_of_region = reinterpret_cast<const char*>(iter) + len;
@@ -184,12 +216,16 @@ class BASE_EXPORT Pickle {
   }
 
   // Returns the address of the byte immediately following the currently valid
-  // header + payload.
+  // header + payload, which is in the last segment if there are segments.
   char* end_of_payload() {
+    if (!segments_.empty())
+      return segments_.back().data + segments_.back().size;
     // We must have a valid header_.
     return payload() + payload_size();
   }
   const char* end_of_payload() const {
+    if (!segments_.empty())
+      return segments_.back().data + segments_.back().size;
     // This object may be invalid.
     return header_ ? payload() + payload_size() : NULL;
   }
@@ -227,6 +263,11 @@ class BASE_EXPORT Pickle {
     *iter = static_cast<char*>(*iter) + AlignInt(bytes, sizeof(uint32));
   }
 
+  // Sets |*iter| to the start of the payload if it is NULL, and returns true
+  // if it then points to |len| bytes of payload.  If the iterator is at the
+  // end of a segment, it is first moved to the start of the next one.
+  bool PrepareRead(void** iter, int len) const;
+
   // Find the end of the pickled data that starts at range_start.  Returns NULL
   // if the entire Pickle is not found in the given data range.
   static const char* FindNext(size_t header_size,
@@ -237,11 +278,40 @@ class BASE_EXPORT Pickle {
   static const int kPayloadUnit;
 
  private:
+  // A buffer chained after the first one by a Pickle with segments enabled.
+  // Writes are never split between segments, so every value that is read
+  // lies entirely within one.
+  struct Segment {
+    char* data;
+    size_t size;  // Bytes of payload written to the segment.
+    size_t capacity;
+  };
+
+  // Writes |length| bytes at payload offset |offset| into the last segment,
+  // adding a segment if there is no room in it.
+  char* BeginWriteSegment(size_t offset, size_t length);
+
+  // IteratorHasRoomFor() for a Pickle whose payload is split across segments.
+  bool SegmentHasRoomFor(const void* iter, int len) const;
+
+  // Copies the data of |other| into this Pickle's buffer, which must be
+  // large enough to hold it.
+  void CopyDataFrom(const Pickle& other);
+
+  // Frees the segments, leaving only the first buffer.
+  void FreeSegments();
+
   Header* header_;
   size_t header_size_;  // Supports extra data between header and payload.
   // Allocation size of payload (or -1 if allocation is const).
   size_t capacity_;
   size_t variable_buffer_offset_;  // IF non-zero, then offset to a buffer.
+  // The size of the segments chained after the first buffer, or 0 if the
+  // Pickle keeps its data in a single buffer.
+  size_t segment_size_;
+  // The bytes of payload in the first buffer, once there are segments.
+  size_t first_payload_size_;
+  std::vector<Segment> segments_;
 
   FRIEND_TEST_ALL_PREFIXES(PickleTest, Resize);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNext);
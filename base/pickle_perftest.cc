@@ -0,0 +1,65 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/pickle.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kPickles = 50;
+
+// The size of each string written, and how many make up a Pickle of about
+// 4MB, the size of a large resource or paint message.
+const size_t kStringSize = 1000;
+const int kStrings = 4000;
+
+// Writes kPickles large Pickles, with segments of |segment_size| bytes or in
+// a single buffer if it is 0, and logs the rate at which they are written.
+// If |gather| is true, the data of each Pickle is also walked the way a
+// channel would send it.
+void RunWriteTest(size_t segment_size, bool gather) {
+  std::string value(kStringSize, 'x');
+  size_t gathered = 0;
+
+  PerfTimer timer;
+  for (int i = 0; i < kPickles; ++i) {
+    Pickle pickle;
+    if (segment_size)
+      pickle.EnableSegments(segment_size);
+    for (int j = 0; j < kStrings; ++j)
+      pickle.WriteString(value);
+    if (gather) {
+      size_t offset = 0;
+      while (offset < pickle.size()) {
+        size_t length;
+        pickle.GetDataSegment(offset, &length);
+        offset += length;
+      }
+      gathered += offset;
+    }
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  if (gather)
+    EXPECT_LT(0U, gathered);
+
+  std::string name = base::StringPrintf(
+      "Pickle_Write_%s%s", segment_size ? "Segmented" : "Contiguous",
+      gather ? "_Gather" : "");
+  LogPerfResult(name.c_str(),
+                kPickles * kStrings * kStringSize /
+                    (elapsed.InSecondsF() * 1024 * 1024),
+                "MB/s");
+}
+
+}  // namespace
+
+TEST(PicklePerfTest, Write) {
+  RunWriteTest(0, false);
+  RunWriteTest(64 * 1024, false);
+  RunWriteTest(64 * 1024, true);
+}
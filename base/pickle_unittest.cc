@@ -323,3 +323,120 @@ TEST(PickleTest, ReadBytes) {
   memcpy(&outdata, outdata_char, sizeof(outdata));
   EXPECT_EQ(data, outdata);
 }
+
+namespace {
+
+// Returns the data of |pickle| gathered from its segments.
+std::string GatherData(const Pickle& pickle) {
+  std::string data;
+  size_t offset = 0;
+  while (offset < pickle.size()) {
+    size_t length;
+    const char* segment = pickle.GetDataSegment(offset, &length);
+    EXPECT_TRUE(segment);
+    EXPECT_LT(0U, length);
+    data.append(segment, length);
+    offset += length;
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(PickleTest, SegmentedEncodeDecode) {
+  Pickle pickle;
+  pickle.EnableSegments(64);
+
+  EXPECT_TRUE(pickle.WriteInt(testint));
+  EXPECT_TRUE(pickle.WriteString(teststr));
+  EXPECT_TRUE(pickle.WriteWString(testwstr));
+  EXPECT_TRUE(pickle.WriteBool(testbool1));
+  EXPECT_TRUE(pickle.WriteBool(testbool2));
+  EXPECT_TRUE(pickle.WriteUInt16(testuint16));
+  EXPECT_TRUE(pickle.WriteData(testdata, testdatalen));
+
+  // The variable buffer is trimmed in a segment other than the first.
+  char* dest = pickle.BeginWriteData(testdatalen + 100);
+  EXPECT_TRUE(dest);
+  memcpy(dest, testdata, testdatalen);
+  pickle.TrimWriteData(testdatalen);
+
+  size_t first_length;
+  pickle.GetDataSegment(0, &first_length);
+  EXPECT_GT(pickle.size(), first_length);
+  VerifyResult(pickle);
+
+  Pickle pickle2(pickle);
+  VerifyResult(pickle2);
+
+  Pickle pickle3;
+  pickle3 = pickle;
+  VerifyResult(pickle3);
+
+  // Flatten() copies the segments together.
+  std::string gathered = GatherData(pickle);
+  pickle.Flatten();
+  EXPECT_EQ(gathered, std::string(static_cast<const char*>(pickle.data()),
+                                  pickle.size()));
+  pickle.GetDataSegment(0, &first_length);
+  EXPECT_EQ(pickle.size(), first_length);
+  VerifyResult(pickle);
+}
+
+// A Pickle with segments has the same data as one without, and can be read
+// without copying its segments together.
+TEST(PickleTest, Segments) {
+  Pickle contiguous;
+  Pickle segmented;
+  segmented.EnableSegments(4096);
+  for (int i = 0; i < 1000; ++i) {
+    std::string value(i % 300, 'a' + i % 26);
+    EXPECT_TRUE(contiguous.WriteString(value));
+    EXPECT_TRUE(segmented.WriteString(value));
+    EXPECT_TRUE(contiguous.WriteInt(i));
+    EXPECT_TRUE(segmented.WriteInt(i));
+  }
+  // A value larger than a segment gets a segment of its own.
+  std::string big(10000, 'z');
+  EXPECT_TRUE(contiguous.WriteString(big));
+  EXPECT_TRUE(segmented.WriteString(big));
+  EXPECT_TRUE(contiguous.WriteInt(-1));
+  EXPECT_TRUE(segmented.WriteInt(-1));
+
+  ASSERT_EQ(contiguous.size(), segmented.size());
+  size_t first_length;
+  segmented.GetDataSegment(0, &first_length);
+  EXPECT_GE(4096U, first_length);
+  EXPECT_EQ(std::string(static_cast<const char*>(contiguous.data()),
+                        contiguous.size()),
+            GatherData(segmented));
+
+  // Reading from a segmented Pickle does not flatten it.
+  void* iter = NULL;
+  for (int i = 0; i < 1000; ++i) {
+    std::string value;
+    int index;
+    EXPECT_TRUE(segmented.ReadString(&iter, &value));
+    EXPECT_EQ(std::string(i % 300, 'a' + i % 26), value);
+    EXPECT_TRUE(segmented.ReadInt(&iter, &index));
+    EXPECT_EQ(i, index);
+  }
+  std::string value;
+  int last;
+  EXPECT_TRUE(segmented.ReadString(&iter, &value));
+  EXPECT_EQ(big, value);
+  EXPECT_TRUE(segmented.ReadInt(&iter, &last));
+  EXPECT_EQ(-1, last);
+  EXPECT_FALSE(segmented.ReadInt(&iter, &last));
+  segmented.GetDataSegment(0, &first_length);
+  EXPECT_GE(4096U, first_length);
+
+  // A Pickle built from the gathered data reads the same.
+  std::string gathered = GatherData(segmented);
+  Pickle received(gathered.data(), static_cast<int>(gathered.size()));
+  iter = NULL;
+  EXPECT_TRUE(received.ReadString(&iter, &value));
+  EXPECT_EQ(std::string(), value);
+  EXPECT_TRUE(received.ReadInt(&iter, &last));
+  EXPECT_EQ(0, last);
+}
@@ -473,6 +473,13 @@ bool IsStringUTF8(const std::string& str) {
   int32 char_index = 0;
 
   while (char_index < src_len) {
+    // ASCII is always valid, so runs of it are skipped all at once.
+    if (static_cast<unsigned char>(src[char_index]) < 0x80) {
+      char_index += static_cast<int32>(
+          base::CountLeadingASCII(src + char_index, src_len - char_index));
+      continue;
+    }
+
     int32 code_point;
     CBU8_NEXT(src, char_index, src_len, code_point);
     if (!base::IsValidCharacter(code_point))
@@ -21,7 +21,10 @@ static int kDelayedBatteryCheckMs = 10 * 1000;
 SystemMonitor::SystemMonitor()
     : power_observer_list_(new ObserverListThreadSafe<PowerObserver>()),
       devices_changed_observer_list_(
-          new ObserverListThreadSafe<DevicesChangedObserver>()),
+          new ObserverListThreadSafe<DevicesChangedObserver>(
+              ObserverListBase<DevicesChangedObserver>::NOTIFY_ALL,
+              ObserverListThreadSafe<DevicesChangedObserver>::
+                  DELIVER_COALESCED)),
       battery_in_use_(false),
       suspended_(false) {
   DCHECK(!g_system_monitor);
@@ -5,10 +5,11 @@
 #include "base/threading/sequenced_worker_pool.h"
 
 #include <deque>
-#include <set>
+#include <map>
 
 #include "base/atomicops.h"
 #include "base/bind.h"
+#include "base/memory/linked_ptr.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
 #include "base/stringprintf.h"
@@ -27,6 +28,35 @@ struct SequencedTask {
   base::Closure task;
 };
 
+// A queue of runnable tasks belonging to one worker. Each queue has its own
+// lock, so posting to and taking from different queues never contend. A
+// worker that runs out of tasks in its own queue steals from the others.
+class WorkQueue {
+ public:
+  WorkQueue() {}
+
+  void Push(const SequencedTask& task) {
+    base::AutoLock lock(lock_);
+    tasks_.push_back(task);
+  }
+
+  // Removes the oldest task into |task|. Returns false if the queue is empty.
+  bool TryPop(SequencedTask* task) {
+    base::AutoLock lock(lock_);
+    if (tasks_.empty())
+      return false;
+    *task = tasks_.front();
+    tasks_.pop_front();
+    return true;
+  }
+
+ private:
+  base::Lock lock_;
+  std::deque<SequencedTask> tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkQueue);
+};
+
 }  // namespace
 
 // Worker ---------------------------------------------------------------------
@@ -43,7 +73,6 @@ class SequencedWorkerPool::Worker : public base::SimpleThread {
 
  private:
   SequencedWorkerPool::Inner* inner_;
-  SequencedWorkerPool::WorkerShutdown current_shutdown_mode_;
 
   DISALLOW_COPY_AND_ASSIGN(Worker);
 };
@@ -63,7 +92,7 @@ class SequencedWorkerPool::Inner
 
   // This function accepts a name and an ID. If the name is null, the
   // token ID is used. This allows us to implement the optional name lookup
-  // from a single function without having to enter the lock a separate time.
+  // from a single function.
   bool PostTask(const std::string* optional_token_name,
                 int sequence_token_id,
                 SequencedWorkerPool::WorkerShutdown shutdown_behavior,
@@ -84,22 +113,34 @@ class SequencedWorkerPool::Inner
   // token ID, creating a new one if necessary.
   int LockedGetNamedTokenID(const std::string& name);
 
-  // The calling code should clear the given delete_these_oustide_lock
-  // vector the next time the lock is released. See the implementation for
-  // a more detailed description.
-  bool GetWork(SequencedTask* task,
-               std::vector<base::Closure>* delete_these_outside_lock);
+  // Picks the work queue that a task posted from outside the pool goes to.
+  size_t NextWorkQueueIndex();
+
+  // Makes |task| available to the workers by adding it to the given work
+  // queue, then wakes or starts a worker if none is free to pick it up.
+  void EnqueueRunnableTask(size_t queue_index, const SequencedTask& task);
+
+  // Wakes up a waiting worker if there is one, or otherwise starts a new one
+  // if that would help. Takes the lock only when there may be something to do.
+  void WakeOrStartWorker();
+
+  // Takes the next runnable task, looking in the worker's own queue first and
+  // then stealing from the other workers' queues. Returns false if there was
+  // no runnable task. Must be called outside the lock.
+  bool TakeWork(size_t queue_index, SequencedTask* task);
+
+  // Blocks the calling worker until there is runnable work. Returns false if
+  // the worker should exit instead. Must be called outside the lock.
+  bool WaitForWork();
 
-  // Peforms init and cleanup around running the given task. WillRun...
-  // returns the value from PrepareToStartAdditionalThreadIfNecessary.
-  // The calling code should call FinishStartingAdditionalThread once the
-  // lock is released if the return values is nonzero.
-  int WillRunWorkerTask(const SequencedTask& task);
-  void DidRunWorkerTask(const SequencedTask& task);
+  // Releases the sequence and the counts held by |task| once it has run or
+  // been discarded. If the task's sequence has more tasks waiting, the next
+  // one is queued on |queue_index|, the queue of the worker that ran this one.
+  void DidRunWorkerTask(size_t queue_index, const SequencedTask& task);
 
-  // Returns true if there are no threads currently running the given
-  // sequence token.
-  bool IsSequenceTokenRunnable(int sequence_token_id) const;
+  // Drops the count of a BLOCK_SHUTDOWN task and wakes up Shutdown() and any
+  // idle workers if that was the last one.
+  void DidFinishBlockingShutdownTask();
 
   // Checks if all threads are busy and the addition of one more could run an
   // additional task waiting in the queue. This must be called from within
@@ -130,13 +171,18 @@ class SequencedWorkerPool::Inner
   // lock.
   volatile base::subtle::Atomic32 last_sequence_number_;
 
-  // This lock protects |everything in this class|. Do not read or modify
-  // anything without holding this lock. Do not block while holding this
-  // lock.
+  // This lock protects the thread bookkeeping, the named tokens and the
+  // testing observer, and is the lock the condition variables below wait on.
+  // Posting and running tasks do not take it unless a worker has to be woken
+  // up or started. Do not block while holding this lock.
   base::Lock lock_;
 
-  // Condition variable used to wake up worker threads when a task is runnable.
-  base::ConditionVariable cond_var_;
+  // Signaled when a waiting worker has runnable work, or should exit.
+  base::ConditionVariable has_work_cv_;
+
+  // Signaled when |pending_task_count_| drops to zero, or when shutdown may
+  // have become possible.
+  base::ConditionVariable is_idle_cv_;
 
   // The maximum number of worker threads we'll create.
   size_t max_threads_;
@@ -155,31 +201,47 @@ class SequencedWorkerPool::Inner
   // See PrepareToStartAdditionalThreadIfHelpful for more.
   bool thread_being_created_;
 
-  // Number of threads currently waiting for work.
-  size_t waiting_thread_count_;
+  // One queue of runnable tasks per potential worker. Worker N (counting from
+  // zero) owns work_queues_[N]. Allocated up front so that posting threads can
+  // reach them without the lock.
+  scoped_array<WorkQueue> work_queues_;
 
-  // Number of threads currently running tasks that have the BLOCK_SHUTDOWN
-  // flag set.
-  size_t blocking_shutdown_thread_count_;
+  // Number of entries in threads_, readable without the lock.
+  volatile base::subtle::Atomic32 thread_count_;
 
-  // In-order list of all pending tasks. These are tasks waiting for a thread
-  // to run on or that are blocked on a previous task in their sequence.
-  //
-  // We maintain the pending_task_count_ separately for metrics because
-  // list.size() can be linear time.
-  std::list<SequencedTask> pending_tasks_;
-  size_t pending_task_count_;
+  // Round-robin cursor used by NextWorkQueueIndex.
+  volatile base::subtle::Atomic32 next_work_queue_;
+
+  // Number of threads currently waiting for work.
+  volatile base::subtle::Atomic32 waiting_thread_count_;
 
-  // Number of tasks in the pending_tasks_ list that are marked as blocking
-  // shutdown.
-  size_t blocking_shutdown_pending_task_count_;
+  // Number of tasks sitting in the work queues. It is raised after a task is
+  // pushed and lowered after one is taken, so it may briefly disagree with
+  // the queues, but a worker never sleeps while it is positive and a poster
+  // never skips waking a worker that has gone to sleep.
+  volatile base::subtle::Atomic32 runnable_task_count_;
 
-  // Lists all sequence tokens currently executing.
-  std::set<int> current_sequences_;
+  // Number of tasks that have been posted and have not finished running or
+  // been discarded, including ones blocked behind their sequence.
+  volatile base::subtle::Atomic32 pending_task_count_;
+
+  // Number of BLOCK_SHUTDOWN tasks that have been posted and have not
+  // finished running, wherever they are.
+  volatile base::subtle::Atomic32 blocking_shutdown_task_count_;
 
   // Set when the app is terminating and no further tasks should be allowed,
   // though we may still be running existing tasks.
-  bool terminating_;
+  volatile base::subtle::Atomic32 terminating_;
+
+  // Protects |sequences_|.
+  base::Lock sequence_lock_;
+
+  // Every sequence token with a task queued or running has an entry here.
+  // The entry holds the tasks of that sequence waiting for it to finish, in
+  // posting order. Only the head of a sequence is ever in a work queue, which
+  // is how sequence ordering is kept without workers having to skip over
+  // tasks they can't run yet.
+  std::map<int, std::deque<SequencedTask> > sequences_;
 
   // Set when Shutdown is called to do some assertions.
   bool shutdown_called_;
@@ -192,8 +254,7 @@ SequencedWorkerPool::Worker::Worker(SequencedWorkerPool::Inner* inner,
                                     const std::string& prefix)
     : base::SimpleThread(
           prefix + StringPrintf("Worker%d", thread_number).c_str()),
-      inner_(inner),
-      current_shutdown_mode_(SequencedWorkerPool::CONTINUE_ON_SHUTDOWN) {
+      inner_(inner) {
   Start();
 }
 
@@ -213,17 +274,22 @@ SequencedWorkerPool::Inner::Inner(size_t max_threads,
                                   const std::string& thread_name_prefix)
     : last_sequence_number_(0),
       lock_(),
-      cond_var_(&lock_),
+      has_work_cv_(&lock_),
+      is_idle_cv_(&lock_),
       max_threads_(max_threads),
       thread_name_prefix_(thread_name_prefix),
       thread_being_created_(false),
+      work_queues_(new WorkQueue[max_threads]),
+      thread_count_(0),
+      next_work_queue_(0),
       waiting_thread_count_(0),
-      blocking_shutdown_thread_count_(0),
+      runnable_task_count_(0),
       pending_task_count_(0),
-      blocking_shutdown_pending_task_count_(0),
-      terminating_(false),
+      blocking_shutdown_task_count_(0),
+      terminating_(0),
       shutdown_called_(false),
       testing_observer_(NULL)  {
+  DCHECK_GT(max_threads_, 0u);
 }
 
 SequencedWorkerPool::Inner::~Inner() {
@@ -263,41 +329,47 @@ bool SequencedWorkerPool::Inner::PostTask(
   sequenced.location = from_here;
   sequenced.task = task;
 
-  int create_thread_id = 0;
-  {
-    base::AutoLock lock(lock_);
-    if (terminating_)
-      return false;
-
-    // Now that we have the lock, apply the named token rules.
-    if (optional_token_name)
-      sequenced.sequence_token_id = LockedGetNamedTokenID(*optional_token_name);
-
-    pending_tasks_.push_back(sequenced);
-    pending_task_count_++;
+  // Count a blocking task before checking |terminating_|. Shutdown() sets
+  // |terminating_| before it checks the count, so either it sees this task
+  // and waits for it, or we see the flag and refuse the task.
+  if (shutdown_behavior == BLOCK_SHUTDOWN)
+    base::subtle::Barrier_AtomicIncrement(&blocking_shutdown_task_count_, 1);
+  if (base::subtle::Acquire_Load(&terminating_)) {
     if (shutdown_behavior == BLOCK_SHUTDOWN)
-      blocking_shutdown_pending_task_count_++;
+      DidFinishBlockingShutdownTask();
+    return false;
+  }
 
-    create_thread_id = PrepareToStartAdditionalThreadIfHelpful();
+  // Apply the named token rules.
+  if (optional_token_name) {
+    base::AutoLock lock(lock_);
+    sequenced.sequence_token_id = LockedGetNamedTokenID(*optional_token_name);
   }
 
-  // Actually start the additional thread or signal an existing one now that
-  // we're outside the lock.
-  if (create_thread_id)
-    FinishStartingAdditionalThread(create_thread_id);
-  else
-    cond_var_.Signal();
+  base::subtle::NoBarrier_AtomicIncrement(&pending_task_count_, 1);
+
+  if (sequenced.sequence_token_id) {
+    base::AutoLock lock(sequence_lock_);
+    std::map<int, std::deque<SequencedTask> >::iterator found =
+        sequences_.find(sequenced.sequence_token_id);
+    if (found != sequences_.end()) {
+      // Another task of this sequence is queued or running. This one will be
+      // queued when that one finishes.
+      found->second.push_back(sequenced);
+      return true;
+    }
+    // Mark the sequence as busy.
+    sequences_[sequenced.sequence_token_id];
+  }
 
+  EnqueueRunnableTask(NextWorkQueueIndex(), sequenced);
   return true;
 }
 
 void SequencedWorkerPool::Inner::Flush() {
-  {
-    base::AutoLock lock(lock_);
-    while (pending_task_count_ > 0 || waiting_thread_count_ < threads_.size())
-      cond_var_.Wait();
-  }
-  cond_var_.Signal();
+  base::AutoLock lock(lock_);
+  while (base::subtle::Acquire_Load(&pending_task_count_) > 0)
+    is_idle_cv_.Wait();
 }
 
 void SequencedWorkerPool::Inner::Shutdown() {
@@ -305,18 +377,19 @@ void SequencedWorkerPool::Inner::Shutdown() {
     return;
   shutdown_called_ = true;
 
-  // Mark us as terminated and go through and drop all tasks that aren't
-  // required to run on shutdown. Since no new tasks will get posted once the
-  // terminated flag is set, this ensures that all remaining tasks are required
-  // for shutdown whenever the termianted_ flag is set.
+  // Mark us as terminated. Since no new tasks will get posted once the
+  // terminating flag is set, and workers discard rather than run any task that
+  // isn't required to run on shutdown, all remaining work is that which is
+  // required for shutdown whenever the terminating_ flag is set.
   {
     base::AutoLock lock(lock_);
-    DCHECK(!terminating_);
-    terminating_ = true;
+    DCHECK(!base::subtle::NoBarrier_Load(&terminating_));
+    base::subtle::NoBarrier_Store(&terminating_, 1);
+    base::subtle::MemoryBarrier();
 
-    // Tickle the threads. This will wake up a waiting one so it will know that
-    // it can exit, which in turn will wake up any other waiting ones.
-    cond_var_.Signal();
+    // Tickle the threads. Idle ones will exit once nothing blocks shutdown,
+    // and busy ones will start discarding the tasks they would have run.
+    has_work_cv_.Broadcast();
 
     // There are no pending or running tasks blocking shutdown, we're done.
     if (CanShutdown())
@@ -336,7 +409,7 @@ void SequencedWorkerPool::Inner::Shutdown() {
   {
     base::AutoLock lock(lock_);
     while (!CanShutdown())
-      cond_var_.Wait();
+      is_idle_cv_.Wait();
   }
   UMA_HISTOGRAM_TIMES("SequencedWorkerPool.ShutdownDelayTime",
                       base::TimeTicks::Now() - shutdown_wait_begin);
@@ -349,53 +422,65 @@ void SequencedWorkerPool::Inner::SetTestingObserver(
 }
 
 void SequencedWorkerPool::Inner::ThreadLoop(Worker* this_worker) {
+  size_t queue_index;
   {
     base::AutoLock lock(lock_);
     DCHECK(thread_being_created_);
     thread_being_created_ = false;
+    queue_index = threads_.size();
     threads_.push_back(linked_ptr<Worker>(this_worker));
+    base::subtle::Release_Store(&thread_count_,
+                                static_cast<int>(threads_.size()));
 
-    while (true) {
-      // See GetWork for what delete_these_outside_lock is doing.
-      SequencedTask task;
-      std::vector<base::Closure> delete_these_outside_lock;
-      if (GetWork(&task, &delete_these_outside_lock)) {
-        int new_thread_id = WillRunWorkerTask(task);
-        {
-          base::AutoUnlock unlock(lock_);
-          cond_var_.Signal();
-          delete_these_outside_lock.clear();
-
-          // Complete thread creation outside the lock if necessary.
-          if (new_thread_id)
-            FinishStartingAdditionalThread(new_thread_id);
-
-          task.task.Run();
-
-          // Make sure our task is erased outside the lock for the same reason
-          // we do this with delete_these_oustide_lock.
-          task.task = base::Closure();
-        }
-        DidRunWorkerTask(task);  // Must be done inside the lock.
-      } else {
-        // When we're terminating and there's no more work, we can shut down.
-        // You can't get more tasks posted once terminating_ is set. There may
-        // be some tasks stuck behind running ones with the same sequence
-        // token, but additional threads won't help this case.
-        if (terminating_)
-          break;
-        waiting_thread_count_++;
-        cond_var_.Signal();  // For Flush() that may be waiting on the
-                             // waiting thread count to go up.
-        cond_var_.Wait();
-        waiting_thread_count_--;
-      }
-    }
+    // Shutdown() may be waiting for this thread to finish being created.
+    if (base::subtle::NoBarrier_Load(&terminating_))
+      is_idle_cv_.Broadcast();
   }
+  DCHECK_LT(queue_index, max_threads_);
+
+  while (true) {
+    SequencedTask task;
+    if (!TakeWork(queue_index, &task)) {
+      if (!WaitForWork())
+        break;
+      continue;
+    }
 
-  // We noticed we should exit. Wake up the next worker so it knows it should
-  // exit as well (because the Shutdown() code only signals once).
-  cond_var_.Signal();
+    // We just picked up a task. Since thread creation only happens when no
+    // thread is free, there is a race when posting tasks that many tasks
+    // could have been posted before a thread started running them, so only
+    // one thread would have been created. So if there is more work, we wake
+    // or create another worker now, which also has the nice side effect of
+    // creating the workers from background threads rather than the main
+    // thread of the app.
+    //
+    // Note that we really need to do this *before* running the task, not
+    // after. Otherwise, if more than one task is posted, the creation of the
+    // second thread (since we only create one at a time) will be blocked by
+    // the execution of the first task, which could be arbitrarily long.
+    if (base::subtle::Acquire_Load(&runnable_task_count_) > 0)
+      WakeOrStartWorker();
+
+    if (base::subtle::Acquire_Load(&terminating_) &&
+        task.shutdown_behavior != BLOCK_SHUTDOWN) {
+      // We're shutting down and the task we just found isn't blocking
+      // shutdown. Delete it rather than running it.
+      //
+      // Only the head of a sequence is ever runnable, so this never deletes a
+      // task that's supposed to run after one that's currently running, which
+      // could cause an obscure crash. No lock is held here either, so closures
+      // holding refs to objects that want to post work from their destructors
+      // can't deadlock.
+      task.task.Reset();
+    } else {
+      task.task.Run();
+
+      // Make sure our task is erased before the next one is picked up, so
+      // that whatever it holds isn't kept alive while this worker sleeps.
+      task.task.Reset();
+    }
+    DidRunWorkerTask(queue_index, task);
+  }
 }
 
 int SequencedWorkerPool::Inner::LockedGetNamedTokenID(
@@ -414,136 +499,137 @@ int SequencedWorkerPool::Inner::LockedGetNamedTokenID(
   return result.id_;
 }
 
-bool SequencedWorkerPool::Inner::GetWork(
-    SequencedTask* task,
-    std::vector<base::Closure>* delete_these_outside_lock) {
-  lock_.AssertAcquired();
+size_t SequencedWorkerPool::Inner::NextWorkQueueIndex() {
+  uint32 thread_count =
+      static_cast<uint32>(base::subtle::Acquire_Load(&thread_count_));
+  if (!thread_count)
+    return 0;  // The first worker will pick it up once it starts.
+  uint32 next = static_cast<uint32>(
+      base::subtle::NoBarrier_AtomicIncrement(&next_work_queue_, 1));
+  return next % thread_count;
+}
+
+void SequencedWorkerPool::Inner::EnqueueRunnableTask(
+    size_t queue_index,
+    const SequencedTask& task) {
+  work_queues_[queue_index].Push(task);
+  base::subtle::Barrier_AtomicIncrement(&runnable_task_count_, 1);
+  WakeOrStartWorker();
+}
+
+void SequencedWorkerPool::Inner::WakeOrStartWorker() {
+  // This pairs with WaitForWork(): the runnable count was raised before this
+  // load, and a worker raises the waiting count before it checks the runnable
+  // count. So if we see no waiting worker, any worker about to wait will see
+  // the task and not go to sleep.
+  bool all_threads_created =
+      static_cast<size_t>(base::subtle::Acquire_Load(&thread_count_)) >=
+      max_threads_;
+  if (all_threads_created &&
+      !base::subtle::Acquire_Load(&waiting_thread_count_))
+    return;  // Every worker is busy; one of them will get to it.
+
+  // Taking the lock also guarantees that a worker which decided to wait has
+  // actually started waiting, so the signal below can't be missed.
+  bool wake_worker = false;
+  int create_thread_id = 0;
+  {
+    base::AutoLock lock(lock_);
+    if (base::subtle::NoBarrier_Load(&waiting_thread_count_))
+      wake_worker = true;
+    else
+      create_thread_id = PrepareToStartAdditionalThreadIfHelpful();
+  }
 
-  DCHECK_EQ(pending_tasks_.size(), pending_task_count_);
-  UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.TaskCount",
-                           static_cast<int>(pending_task_count_));
+  // Signal or start the additional thread now that we're outside the lock, so
+  // the woken worker doesn't immediately block on it.
+  if (wake_worker)
+    has_work_cv_.Signal();
+  else if (create_thread_id)
+    FinishStartingAdditionalThread(create_thread_id);
+}
 
-  // Find the next task with a sequence token that's not currently in use.
-  // If the token is in use, that means another thread is running something
-  // in that sequence, and we can't run it without going out-of-order.
-  //
-  // This algorithm is simple and fair, but inefficient in some cases. For
-  // example, say somebody schedules 1000 slow tasks with the same sequence
-  // number. We'll have to go through all those tasks each time we feel like
-  // there might be work to schedule. If this proves to be a problem, we
-  // should make this more efficient.
-  //
-  // One possible enhancement would be to keep a map from sequence ID to a
-  // list of pending but currently blocked SequencedTasks for that ID.
-  // When a worker finishes a task of one sequence token, it can pick up the
-  // next one from that token right away.
-  //
-  // This may lead to starvation if there are sufficient numbers of sequences
-  // in use. To alleviate this, we could add an incrementing priority counter
-  // to each SequencedTask. Then maintain a priority_queue of all runnable
-  // tasks, sorted by priority counter. When a sequenced task is completed
-  // we would pop the head element off of that tasks pending list and add it
-  // to the priority queue. Then we would run the first item in the priority
-  // queue.
-  bool found_task = false;
-  int unrunnable_tasks = 0;
-  std::list<SequencedTask>::iterator i = pending_tasks_.begin();
-  while (i != pending_tasks_.end()) {
-    if (!IsSequenceTokenRunnable(i->sequence_token_id)) {
-      unrunnable_tasks++;
-      ++i;
-      continue;
-    }
+bool SequencedWorkerPool::Inner::TakeWork(size_t queue_index,
+                                          SequencedTask* task) {
+  if (base::subtle::Acquire_Load(&runnable_task_count_) <= 0)
+    return false;
 
-    if (terminating_ && i->shutdown_behavior != BLOCK_SHUTDOWN) {
-      // We're shutting down and the task we just found isn't blocking
-      // shutdown. Delete it and get more work.
-      //
-      // Note that we do not want to delete unrunnable tasks. Deleting a task
-      // can have side effects (like freeing some objects) and deleting a
-      // task that's supposed to run after one that's currently running could
-      // cause an obscure crash.
-      //
-      // We really want to delete these tasks outside the lock in case the
-      // closures are holding refs to objects that want to post work from
-      // their destructorss (which would deadlock). The closures are
-      // internally refcounted, so we just need to keep a copy of them alive
-      // until the lock is exited. The calling code can just clear() the
-      // vector they passed to us once the lock is exited to make this
-      // happen.
-      delete_these_outside_lock->push_back(i->task);
-      i = pending_tasks_.erase(i);
-      pending_task_count_--;
-    } else {
-      // Found a runnable task.
-      *task = *i;
-      i = pending_tasks_.erase(i);
-      pending_task_count_--;
-      if (task->shutdown_behavior == BLOCK_SHUTDOWN)
-        blocking_shutdown_pending_task_count_--;
-
-      found_task = true;
-      break;
+  for (size_t i = 0; i < max_threads_; i++) {
+    if (work_queues_[(queue_index + i) % max_threads_].TryPop(task)) {
+      base::subtle::Barrier_AtomicIncrement(&runnable_task_count_, -1);
+      UMA_HISTOGRAM_COUNTS_100(
+          "SequencedWorkerPool.TaskCount",
+          base::subtle::NoBarrier_Load(&pending_task_count_));
+      return true;
     }
   }
-
-  // Track the number of tasks we had to skip over to see if we should be
-  // making this more efficient. If this number ever becomes large or is
-  // frequently "some", we should consider the optimization above.
-  UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.UnrunnableTaskCount",
-                           unrunnable_tasks);
-  return found_task;
+  return false;
 }
 
-int SequencedWorkerPool::Inner::WillRunWorkerTask(const SequencedTask& task) {
-  lock_.AssertAcquired();
-
-  // Mark the task's sequence number as in use.
-  if (task.sequence_token_id)
-    current_sequences_.insert(task.sequence_token_id);
-
-  if (task.shutdown_behavior == SequencedWorkerPool::BLOCK_SHUTDOWN)
-    blocking_shutdown_thread_count_++;
-
-  // We just picked up a task. Since StartAdditionalThreadIfHelpful only
-  // creates a new thread if there is no free one, there is a race when posting
-  // tasks that many tasks could have been posted before a thread started
-  // running them, so only one thread would have been created. So we also check
-  // whether we should create more threads after removing our task from the
-  // queue, which also has the nice side effect of creating the workers from
-  // background threads rather than the main thread of the app.
-  //
-  // If another thread wasn't created, we want to wake up an existing thread
-  // if there is one waiting to pick up the next task.
-  //
-  // Note that we really need to do this *before* running the task, not
-  // after. Otherwise, if more than one task is posted, the creation of the
-  // second thread (since we only create one at a time) will be blocked by
-  // the execution of the first task, which could be arbitrarily long.
-  return PrepareToStartAdditionalThreadIfHelpful();
-}
+bool SequencedWorkerPool::Inner::WaitForWork() {
+  base::AutoLock lock(lock_);
+  base::subtle::Barrier_AtomicIncrement(&waiting_thread_count_, 1);
+  bool keep_running = true;
+  while (base::subtle::Acquire_Load(&runnable_task_count_) <= 0) {
+    // When we're terminating and nothing blocks shutdown any more, we can
+    // exit. You can't get more tasks posted once terminating_ is set. There
+    // may be some tasks stuck behind running ones with the same sequence
+    // token, but additional threads won't help this case.
+    if (base::subtle::Acquire_Load(&terminating_) &&
+        !base::subtle::Acquire_Load(&blocking_shutdown_task_count_)) {
+      keep_running = false;
+      break;
+    }
+    has_work_cv_.Wait();
+  }
+  base::subtle::Barrier_AtomicIncrement(&waiting_thread_count_, -1);
+  return keep_running;
+}
+
+void SequencedWorkerPool::Inner::DidRunWorkerTask(size_t queue_index,
+                                                  const SequencedTask& task) {
+  if (task.sequence_token_id) {
+    SequencedTask next;
+    bool has_next = false;
+    {
+      base::AutoLock lock(sequence_lock_);
+      std::map<int, std::deque<SequencedTask> >::iterator found =
+          sequences_.find(task.sequence_token_id);
+      DCHECK(found != sequences_.end());
+      if (found->second.empty()) {
+        sequences_.erase(found);
+      } else {
+        next = found->second.front();
+        found->second.pop_front();
+        has_next = true;
+      }
+    }
+    // Keep the sequence on this worker; its data is likely still in cache.
+    if (has_next)
+      EnqueueRunnableTask(queue_index, next);
+  }
 
-void SequencedWorkerPool::Inner::DidRunWorkerTask(const SequencedTask& task) {
-  lock_.AssertAcquired();
+  if (task.shutdown_behavior == BLOCK_SHUTDOWN)
+    DidFinishBlockingShutdownTask();
 
-  if (task.shutdown_behavior == SequencedWorkerPool::BLOCK_SHUTDOWN) {
-    DCHECK_GT(blocking_shutdown_thread_count_, 0u);
-    blocking_shutdown_thread_count_--;
+  if (base::subtle::Barrier_AtomicIncrement(&pending_task_count_, -1) == 0) {
+    base::AutoLock lock(lock_);
+    is_idle_cv_.Broadcast();
   }
-
-  if (task.sequence_token_id)
-    current_sequences_.erase(task.sequence_token_id);
 }
 
-bool SequencedWorkerPool::Inner::IsSequenceTokenRunnable(
-    int sequence_token_id) const {
-  lock_.AssertAcquired();
-  return !sequence_token_id ||
-      current_sequences_.find(sequence_token_id) ==
-          current_sequences_.end();
+void SequencedWorkerPool::Inner::DidFinishBlockingShutdownTask() {
+  if (base::subtle::Barrier_AtomicIncrement(&blocking_shutdown_task_count_,
+                                            -1) == 0 &&
+      base::subtle::Acquire_Load(&terminating_)) {
+    base::AutoLock lock(lock_);
+    is_idle_cv_.Broadcast();
+    has_work_cv_.Broadcast();
+  }
 }
 
 int SequencedWorkerPool::Inner::PrepareToStartAdditionalThreadIfHelpful() {
+  lock_.AssertAcquired();
   // How thread creation works:
   //
   // We'de like to avoid creating threads with the lock held. However, we
@@ -573,19 +659,15 @@ int SequencedWorkerPool::Inner::PrepareToStartAdditionalThreadIfHelpful() {
   // given the workload, but in reality fewer may be created because the
   // sequence of thread creation on the background threads is racing with the
   // shutdown call.
-  if (!terminating_ &&
+  if (!base::subtle::NoBarrier_Load(&terminating_) &&
       !thread_being_created_ &&
       threads_.size() < max_threads_ &&
-      waiting_thread_count_ == 0) {
-    // We could use an additional thread if there's work to be done.
-    for (std::list<SequencedTask>::iterator i = pending_tasks_.begin();
-         i != pending_tasks_.end(); ++i) {
-      if (IsSequenceTokenRunnable(i->sequence_token_id)) {
-        // Found a runnable task, mark the thread as being started.
-        thread_being_created_ = true;
-        return static_cast<int>(threads_.size() + 1);
-      }
-    }
+      !base::subtle::NoBarrier_Load(&waiting_thread_count_) &&
+      base::subtle::Acquire_Load(&runnable_task_count_) > 0) {
+    // We could use an additional thread since there's work to be done. Mark
+    // the thread as being started.
+    thread_being_created_ = true;
+    return static_cast<int>(threads_.size() + 1);
   }
   return 0;
 }
@@ -604,8 +686,7 @@ bool SequencedWorkerPool::Inner::CanShutdown() const {
   lock_.AssertAcquired();
   // See PrepareToStartAdditionalThreadIfHelpful for how thread creation works.
   return !thread_being_created_ &&
-         blocking_shutdown_thread_count_ == 0 &&
-         blocking_shutdown_pending_task_count_ == 0;
+         !base::subtle::Acquire_Load(&blocking_shutdown_task_count_);
 }
 
 // SequencedWorkerPool --------------------------------------------------------
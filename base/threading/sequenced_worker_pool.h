@@ -46,6 +46,11 @@ namespace base {
 // not enforce shutdown semantics or allow us to specify how many worker
 // threads to run. For the typical use case of random background work, we don't
 // necessarily want to be super aggressive about creating threads.
+//
+// Each worker has its own queue of runnable tasks and steals from the others
+// when it runs dry, so posting and running tasks doesn't serialize on a single
+// lock. Tasks waiting on an earlier task of their sequence are kept aside
+// until it finishes and are then queued on the worker that ran it.
 class BASE_EXPORT SequencedWorkerPool {
  public:
   // Defines what should happen to a task posted to the worker pool on shutdown.
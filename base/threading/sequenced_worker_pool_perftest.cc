@@ -0,0 +1,126 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const size_t kNumWorkerThreads = 4;
+const int kTotalTasks = 200000;
+
+// Counts completed tasks from any worker and signals once all have run.
+class TaskCounter {
+ public:
+  TaskCounter(int expected, WaitableEvent* done)
+      : remaining_(expected), done_(done) {
+  }
+
+  void Run() {
+    if (subtle::Barrier_AtomicIncrement(&remaining_, -1) == 0)
+      done_->Signal();
+  }
+
+ private:
+  volatile subtle::Atomic32 remaining_;
+  WaitableEvent* done_;
+};
+
+// Waits for |start| and then posts |count| tasks to |pool|, spreading them
+// over |num_tokens| sequence tokens (or none, if |num_tokens| is 0).
+class Poster : public DelegateSimpleThread::Delegate {
+ public:
+  Poster(SequencedWorkerPool* pool, TaskCounter* counter, int count,
+         int num_tokens, WaitableEvent* start)
+      : pool_(pool), counter_(counter), count_(count), start_(start) {
+    for (int i = 0; i < num_tokens; ++i)
+      tokens_.push_back(pool->GetSequenceToken());
+  }
+
+  virtual void Run() OVERRIDE {
+    start_->Wait();
+    Closure task = Bind(&TaskCounter::Run, Unretained(counter_));
+    for (int i = 0; i < count_; ++i) {
+      if (tokens_.empty()) {
+        pool_->PostWorkerTask(FROM_HERE, task);
+      } else {
+        pool_->PostSequencedWorkerTask(tokens_[i % tokens_.size()],
+                                       FROM_HERE, task);
+      }
+    }
+  }
+
+ private:
+  SequencedWorkerPool* pool_;
+  TaskCounter* counter_;
+  int count_;
+  std::vector<SequencedWorkerPool::SequenceToken> tokens_;
+  WaitableEvent* start_;
+};
+
+// Runs kTotalTasks trivial tasks through a pool of kNumWorkerThreads workers,
+// posted from |num_posters| threads, and logs the throughput.
+void RunThroughputTest(int num_posters, int tokens_per_poster) {
+  SequencedWorkerPool pool(kNumWorkerThreads, "PerfTest");
+
+  const int tasks_per_poster = kTotalTasks / num_posters;
+  WaitableEvent start(true, false);
+  WaitableEvent done(false, false);
+  TaskCounter counter(tasks_per_poster * num_posters, &done);
+
+  ScopedVector<Poster> posters;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_posters; ++i) {
+    posters.push_back(new Poster(&pool, &counter, tasks_per_poster,
+                                 tokens_per_poster, &start));
+    threads.push_back(
+        new DelegateSimpleThread(posters[i], "SequencedWorkerPoolPerfPoster"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  done.Wait();
+  TimeDelta elapsed = timer.Elapsed();
+
+  for (int i = 0; i < num_posters; ++i)
+    threads[i]->Join();
+  pool.Shutdown();
+
+  std::string name = StringPrintf(
+      "SequencedWorkerPool_%d_posters_%d_tokens", num_posters,
+      num_posters * tokens_per_poster);
+  LogPerfResult(name.c_str(),
+                tasks_per_poster * num_posters / elapsed.InSecondsF(),
+                "tasks/s");
+}
+
+}  // namespace
+
+TEST(SequencedWorkerPoolPerfTest, Unsequenced) {
+  RunThroughputTest(1, 0);
+  RunThroughputTest(4, 0);
+  RunThroughputTest(16, 0);
+}
+
+TEST(SequencedWorkerPoolPerfTest, FewSequences) {
+  RunThroughputTest(1, 1);
+  RunThroughputTest(4, 1);
+}
+
+TEST(SequencedWorkerPoolPerfTest, ManySequences) {
+  RunThroughputTest(1, 64);
+  RunThroughputTest(4, 64);
+}
+
+}  // namespace base
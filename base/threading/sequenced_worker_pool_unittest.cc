@@ -328,6 +328,80 @@ TEST_F(SequencedWorkerPoolTest, Sequence) {
   EXPECT_EQ(101, result[result.size() - 1]);
 }
 
+// Tests that tasks of many interleaved sequences each run in posting order,
+// however the workers pick them up.
+TEST_F(SequencedWorkerPoolTest, ManySequencesKeepOrder) {
+  const int kNumSequences = 10;
+  const int kTasksPerSequence = 50;
+
+  std::vector<SequencedWorkerPool::SequenceToken> tokens;
+  for (int i = 0; i < kNumSequences; i++)
+    tokens.push_back(pool().GetSequenceToken());
+  for (int task = 0; task < kTasksPerSequence; task++) {
+    for (int sequence = 0; sequence < kNumSequences; sequence++) {
+      pool().PostSequencedWorkerTask(
+          tokens[sequence], FROM_HERE,
+          base::Bind(&TestTracker::FastTask, tracker(),
+                     sequence * kTasksPerSequence + task));
+    }
+  }
+
+  std::vector<int> result =
+      tracker()->WaitUntilTasksComplete(kNumSequences * kTasksPerSequence);
+  ASSERT_EQ(static_cast<size_t>(kNumSequences * kTasksPerSequence),
+            result.size());
+  std::vector<int> next_expected(kNumSequences, 0);
+  for (size_t i = 0; i < result.size(); i++) {
+    int sequence = result[i] / kTasksPerSequence;
+    EXPECT_EQ(next_expected[sequence], result[i] % kTasksPerSequence);
+    next_expected[sequence]++;
+  }
+}
+
+// Tests that FlushForTesting waits for tasks queued behind their sequence.
+TEST_F(SequencedWorkerPoolTest, FlushWaitsForSequencedTasks) {
+  SequencedWorkerPool::SequenceToken token = pool().GetSequenceToken();
+  pool().PostSequencedWorkerTask(
+      token, FROM_HERE, base::Bind(&TestTracker::SlowTask, tracker(), 0));
+  pool().PostSequencedWorkerTask(
+      token, FROM_HERE, base::Bind(&TestTracker::FastTask, tracker(), 1));
+
+  pool().FlushForTesting();
+  std::vector<int> result = tracker()->WaitUntilTasksComplete(0);
+  ASSERT_EQ(2u, result.size());
+  EXPECT_EQ(0, result[0]);
+  EXPECT_EQ(1, result[1]);
+}
+
+// Tests that a BLOCK_SHUTDOWN task queued behind a running task of the same
+// sequence still runs before shutdown completes.
+TEST_F(SequencedWorkerPoolTest, BlockShutdownBehindSequence) {
+  EnsureAllWorkersCreated();
+  ThreadBlocker blocker;
+  SequencedWorkerPool::SequenceToken token = pool().GetSequenceToken();
+  pool().PostSequencedWorkerTask(
+      token, FROM_HERE,
+      base::Bind(&TestTracker::BlockTask, tracker(), 0, &blocker));
+  pool().PostSequencedWorkerTaskWithShutdownBehavior(
+      token, FROM_HERE, base::Bind(&TestTracker::FastTask, tracker(), 1),
+      SequencedWorkerPool::SKIP_ON_SHUTDOWN);
+  pool().PostSequencedWorkerTask(
+      token, FROM_HERE, base::Bind(&TestTracker::FastTask, tracker(), 2));
+  tracker()->WaitUntilTasksBlocked(1);
+
+  // The SKIP_ON_SHUTDOWN task is dropped once it reaches the head of the
+  // sequence; the BLOCK_SHUTDOWN one after it must still run.
+  before_wait_for_shutdown_ =
+      base::Bind(&EnsureTasksToCompleteCountAndUnblock,
+                 scoped_refptr<TestTracker>(tracker()), 0, &blocker, 1);
+  pool().Shutdown();
+
+  std::vector<int> result = tracker()->WaitUntilTasksComplete(2);
+  ASSERT_EQ(2u, result.size());
+  EXPECT_EQ(0, result[0]);
+  EXPECT_EQ(2, result[1]);
+}
+
 // Tests that unrun tasks are discarded properly according to their shutdown
 // mode.
 TEST_F(SequencedWorkerPoolTest, DiscardOnShutdown) {
@@ -78,7 +78,8 @@ void WorkerThread::ThreadMain() {
   PlatformThread::SetName(name.c_str());
 
   for (;;) {
-    PendingTask pending_task = pool_->WaitForTask();
+    PendingTask pending_task(FROM_HERE, base::Closure());
+    pool_->WaitForTask(&pending_task);
     if (pending_task.task.is_null())
       break;
     UNSHIPPED_TRACE_EVENT2("task", "WorkerThread::ThreadMain::Run",
@@ -143,8 +144,7 @@ void PosixDynamicThreadPool::AddTask(PendingTask* pending_task) {
   DCHECK(!terminated_) <<
       "This thread pool is already terminated.  Do not post new tasks.";
 
-  pending_tasks_.push(*pending_task);
-  pending_task->task.Reset();
+  pending_tasks_.PushByMove(pending_task);
 
   // We have enough worker threads.
   if (static_cast<size_t>(num_idle_threads_) >= pending_tasks_.size()) {
@@ -158,11 +158,11 @@ void PosixDynamicThreadPool::AddTask(PendingTask* pending_task) {
   }
 }
 
-PendingTask PosixDynamicThreadPool::WaitForTask() {
+void PosixDynamicThreadPool::WaitForTask(PendingTask* pending_task) {
   AutoLock locked(lock_);
 
   if (terminated_)
-    return PendingTask(FROM_HERE, base::Closure());
+    return;
 
   if (pending_tasks_.empty()) {  // No work available, wait for work.
     num_idle_threads_++;
@@ -174,15 +174,14 @@ PendingTask PosixDynamicThreadPool::WaitForTask() {
     if (num_idle_threads_cv_.get())
       num_idle_threads_cv_->Signal();
     if (pending_tasks_.empty()) {
-      // We waited for work, but there's still no work.  Return NULL to signal
-      // the thread to terminate.
-      return PendingTask(FROM_HERE, base::Closure());
+      // We waited for work, but there's still no work.  Leave the closure
+      // null to signal the thread to terminate.
+      return;
     }
   }
 
-  PendingTask pending_task = pending_tasks_.front();
+  pending_task->Swap(&pending_tasks_.front());
   pending_tasks_.pop();
-  return pending_task;
 }
 
 }  // namespace base
@@ -64,14 +64,15 @@ class BASE_EXPORT PosixDynamicThreadPool
                 const Closure& task);
 
   // Worker thread method to wait for up to |idle_seconds_before_exit| for more
-  // work from the thread pool.  Returns NULL if no work is available.
-  PendingTask WaitForTask();
+  // work from the thread pool.  Moves the task into |pending_task|, whose
+  // closure is left null if no work is available.
+  void WaitForTask(PendingTask* pending_task);
 
  private:
   friend class PosixDynamicThreadPoolPeer;
 
-  // Adds pending_task to the thread pool.  This function will clear
-  // |pending_task->task|.
+  // Adds pending_task to the thread pool.  This function will move
+  // |pending_task->task| into the pool, leaving it null.
   void AddTask(PendingTask* pending_task);
 
   const std::string name_prefix_;
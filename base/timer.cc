@@ -10,22 +10,81 @@
 
 namespace base {
 
+BaseTimer_Helper::TimerTask::~TimerTask() {
+  if (timer_) {
+    DCHECK_EQ(this, timer_->delayed_task_);
+    timer_->delayed_task_ = NULL;
+    timer_->delayed_task_loop_ = NULL;
+    timer_->is_running_ = false;
+  }
+}
+
+void BaseTimer_Helper::TimerTask::Run() {
+  if (timer_)  // timer_ is null if we were orphaned.
+    timer_->RunScheduledTask();
+}
+
+void BaseTimer_Helper::StartTimer() {
+  DCHECK(run_user_task_);
+  is_running_ = true;
+  TimeTicks now = TimeTicks::Now();
+  desired_run_time_ = now + delay_;
+
+  // Keep the posted task if it will run in time, on this thread.  It posts
+  // another for the rest of the delay when it runs.
+  if (delayed_task_ && delayed_task_loop_ == MessageLoop::current() &&
+      scheduled_run_time_ <= desired_run_time_) {
+    return;
+  }
+  PostNewTask(delay_);
+}
+
 void BaseTimer_Helper::OrphanDelayedTask() {
   if (delayed_task_) {
     delayed_task_->timer_ = NULL;
     delayed_task_ = NULL;
+    delayed_task_loop_ = NULL;
   }
 }
 
-void BaseTimer_Helper::InitiateDelayedTask(TimerTask* timer_task) {
+void BaseTimer_Helper::PostNewTask(TimeDelta delay) {
   OrphanDelayedTask();
 
-  delayed_task_ = timer_task;
-  delayed_task_->timer_ = this;
-  MessageLoop::current()->PostDelayedTask(
-      timer_task->posted_from_,
-      base::Bind(&TimerTask::Run, base::Owned(timer_task)),
-      timer_task->delay_);
+  TimeTicks now = TimeTicks::Now();
+  scheduled_run_time_ = now + delay;
+  if (slack_ > TimeDelta()) {
+    // Round up to a multiple of the slack, so that timers with the same
+    // slack run together.
+    int64 slack = slack_.InMicroseconds();
+    int64 run_time = scheduled_run_time_.ToInternalValue();
+    scheduled_run_time_ = TimeTicks::FromInternalValue(
+        (run_time + slack - 1) / slack * slack);
+    delay = scheduled_run_time_ - now;
+  }
+
+  delayed_task_ = new TimerTask(this);
+  delayed_task_loop_ = MessageLoop::current();
+  delayed_task_loop_->PostDelayedTask(
+      posted_from_,
+      base::Bind(&TimerTask::Run, base::Owned(delayed_task_)),
+      delay);
+}
+
+void BaseTimer_Helper::RunScheduledTask() {
+  // The task that called us is done with the timer.
+  OrphanDelayedTask();
+
+  if (!is_running_)
+    return;
+
+  // The timer was reset after the task was posted, so wait some more.
+  TimeTicks now = TimeTicks::Now();
+  if (desired_run_time_ > now) {
+    PostNewTask(desired_run_time_ - now);
+    return;
+  }
+
+  run_user_task_(this);
 }
 
 }  // namespace base
@@ -63,6 +63,12 @@ namespace base {
 //
 // This class exists to share code between BaseTimer<T> template instantiations.
 //
+// Resetting a timer is cheap: it only moves the time at which the timer wants
+// to run.  The task posted to the MessageLoop is kept, and when it runs
+// early, it posts another for the rest of the delay.  So a timer that keeps
+// being reset before it fires, like an idle timeout, allocates and posts
+// about one task per delay rather than one per reset.
+//
 class BASE_EXPORT BaseTimer_Helper {
  public:
   // Stops the timer.
@@ -72,44 +78,87 @@ class BASE_EXPORT BaseTimer_Helper {
 
   // Returns true if the timer is running (i.e., not stopped).
   bool IsRunning() const {
-    return delayed_task_ != NULL;
+    return is_running_;
   }
 
   // Returns the current delay for this timer.  May only call this method when
   // the timer is running!
   TimeDelta GetCurrentDelay() const {
     DCHECK(IsRunning());
-    return delayed_task_->delay_;
+    return delay_;
+  }
+
+  // Lets the timer run up to |slack| after its delay has passed.  The time it
+  // runs at is rounded up to a multiple of |slack|, so timers with the same
+  // slack, like those of idle sockets, share wakeups instead of each waking
+  // the thread on its own.  Takes effect the next time the timer is started
+  // or reset.
+  void set_slack(TimeDelta slack) {
+    slack_ = slack;
   }
 
  protected:
-  BaseTimer_Helper() : delayed_task_(NULL) {}
+  typedef void (*RunUserTaskFunction)(BaseTimer_Helper* timer);
+
+  BaseTimer_Helper()
+      : delayed_task_(NULL),
+        delayed_task_loop_(NULL),
+        run_user_task_(NULL),
+        is_running_(false) {
+  }
 
-  // We have access to the timer_ member so we can orphan this task.
-  class TimerTask {
+  // The task posted to the MessageLoop.  It calls back into its timer, unless
+  // it has been orphaned.
+  class BASE_EXPORT TimerTask {
    public:
-    TimerTask(const tracked_objects::Location& posted_from,
-              TimeDelta delay)
-        : posted_from_(posted_from),
-          timer_(NULL),
-          delay_(delay) {
-    }
-    virtual ~TimerTask() {}
-    virtual void Run() = 0;
-    tracked_objects::Location posted_from_;
+    explicit TimerTask(BaseTimer_Helper* timer) : timer_(timer) {}
+
+    // This task may be getting deleted because the MessageLoop has been
+    // destructed.  If so, don't leave the timer with a dangling pointer to it.
+    ~TimerTask();
+
+    void Run();
+
     BaseTimer_Helper* timer_;
-    TimeDelta delay_;
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(TimerTask);
   };
 
+  // Starts the timer, or restarts it if it is running, to run |run_user_task_|
+  // after |delay_|.
+  void StartTimer();
+
+  // Stops the timer.  The posted task is kept, in case the timer is started
+  // again before it runs.
+  void StopTimer() {
+    is_running_ = false;
+  }
+
   // Used to orphan delayed_task_ so that when it runs it does nothing.
   void OrphanDelayedTask();
 
-  // Used to initiated a new delayed task.  This has the side-effect of
-  // orphaning delayed_task_ if it is non-null.
-  void InitiateDelayedTask(TimerTask* timer_task);
+  // Posts a new task to run after |delay|, orphaning delayed_task_.
+  void PostNewTask(TimeDelta delay);
+
+  // Called by the posted task.
+  void RunScheduledTask();
 
   TimerTask* delayed_task_;
 
+  // The MessageLoop delayed_task_ was posted to.
+  MessageLoop* delayed_task_loop_;
+
+  // When delayed_task_ will run, and when the timer wants to run.
+  TimeTicks scheduled_run_time_;
+  TimeTicks desired_run_time_;
+
+  tracked_objects::Location posted_from_;
+  TimeDelta delay_;
+  TimeDelta slack_;
+  RunUserTaskFunction run_user_task_;
+  bool is_running_;
+
   DISALLOW_COPY_AND_ASSIGN(BaseTimer_Helper);
 };
 
@@ -121,6 +170,8 @@ class BaseTimer : public BaseTimer_Helper {
  public:
   typedef void (Receiver::*ReceiverMethod)();
 
+  BaseTimer() : receiver_(NULL), method_(NULL) {}
+
   // Call this method to start the timer.  It is an error to call this method
   // while the timer is already running.
   void Start(const tracked_objects::Location& posted_from,
@@ -128,84 +179,41 @@ class BaseTimer : public BaseTimer_Helper {
              Receiver* receiver,
              ReceiverMethod method) {
     DCHECK(!IsRunning());
-    InitiateDelayedTask(new TimerTask(posted_from, delay, receiver, method));
+    posted_from_ = posted_from;
+    delay_ = delay;
+    receiver_ = receiver;
+    method_ = method;
+    run_user_task_ = &SelfType::RunUserTask;
+    StartTimer();
   }
 
   // Call this method to stop the timer.  It is a no-op if the timer is not
   // running.
   void Stop() {
-    OrphanDelayedTask();
+    StopTimer();
   }
 
   // Call this method to reset the timer delay of an already running timer.
   void Reset() {
     DCHECK(IsRunning());
-    InitiateDelayedTask(static_cast<TimerTask*>(delayed_task_)->Clone());
+    StartTimer();
   }
 
  private:
   typedef BaseTimer<Receiver, kIsRepeating> SelfType;
 
-  class TimerTask : public BaseTimer_Helper::TimerTask {
-   public:
-    TimerTask(const tracked_objects::Location& posted_from,
-              TimeDelta delay,
-              Receiver* receiver,
-              ReceiverMethod method)
-        : BaseTimer_Helper::TimerTask(posted_from, delay),
-          receiver_(receiver),
-          method_(method) {
-    }
-
-    virtual ~TimerTask() {
-      // This task may be getting cleared because the MessageLoop has been
-      // destructed.  If so, don't leave the Timer with a dangling pointer
-      // to this now-defunct task.
-      ClearBaseTimer();
-    }
-
-    virtual void Run() {
-      if (!timer_)  // timer_ is null if we were orphaned.
-        return;
-      if (kIsRepeating)
-        ResetBaseTimer();
-      else
-        ClearBaseTimer();
-      (receiver_->*method_)();
-    }
-
-    TimerTask* Clone() const {
-      return new TimerTask(posted_from_, delay_, receiver_, method_);
-    }
+  static void RunUserTask(BaseTimer_Helper* timer) {
+    SelfType* self = static_cast<SelfType*>(timer);
+    if (kIsRepeating)
+      self->StartTimer();
+    else
+      self->StopTimer();
+    // This must come last, as the receiver may delete the timer.
+    (self->receiver_->*self->method_)();
+  }
 
-   private:
-    // Inform the Base that the timer is no longer active.
-    void ClearBaseTimer() {
-      if (timer_) {
-        SelfType* self = static_cast<SelfType*>(timer_);
-        // It is possible that the Timer has already been reset, and that this
-        // Task is old.  So, if the Timer points to a different task, assume
-        // that the Timer has already taken care of properly setting the task.
-        if (self->delayed_task_ == this)
-          self->delayed_task_ = NULL;
-        // By now the delayed_task_ in the Timer does not point to us anymore.
-        // We should reset our own timer_ because the Timer can not do this
-        // for us in its destructor.
-        timer_ = NULL;
-      }
-    }
-
-    // Inform the Base that we're resetting the timer.
-    void ResetBaseTimer() {
-      DCHECK(timer_);
-      DCHECK(kIsRepeating);
-      SelfType* self = static_cast<SelfType*>(timer_);
-      self->Reset();
-    }
-
-    Receiver* receiver_;
-    ReceiverMethod method_;
-  };
+  Receiver* receiver_;
+  ReceiverMethod method_;
 };
 
 //-----------------------------------------------------------------------------
@@ -245,44 +253,20 @@ class DelayTimer {
   }
 
   void Reset() {
-    DelayFor(delay_);
+    // The timer only posts a new task when the old one would run too early.
+    if (timer_.IsRunning())
+      timer_.Reset();
+    else
+      timer_.Start(posted_from_, delay_, receiver_, method_);
   }
 
  private:
-  void DelayFor(TimeDelta delay) {
-    trigger_time_ = TimeTicks::Now() + delay;
-
-    // If we already have a timer that will expire at or before the given delay,
-    // then we have nothing more to do now.
-    if (timer_.IsRunning() && timer_.GetCurrentDelay() <= delay)
-      return;
-
-    // The timer isn't running, or will expire too late, so restart it.
-    timer_.Stop();
-    timer_.Start(posted_from_, delay, this, &DelayTimer<Receiver>::Check);
-  }
-
-  void Check() {
-    if (trigger_time_.is_null())
-      return;
-
-    // If we have not waited long enough, then wait some more.
-    const TimeTicks now = TimeTicks::Now();
-    if (now < trigger_time_) {
-      DelayFor(trigger_time_ - now);
-      return;
-    }
-
-    (receiver_->*method_)();
-  }
-
   tracked_objects::Location posted_from_;
   Receiver *const receiver_;
   const ReceiverMethod method_;
   const TimeDelta delay_;
 
-  OneShotTimer<DelayTimer<Receiver> > timer_;
-  TimeTicks trigger_time_;
+  OneShotTimer<Receiver> timer_;
 };
 
 }  // namespace base
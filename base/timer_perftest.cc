@@ -0,0 +1,100 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Like the idle timeouts of sockets, which are reset on every read and
+// write, and rarely fire.
+const int kTimers = 10000;
+const int kResetsPerTimer = 10;
+
+// Counts the times the thread woke up to run timers, taking callbacks closer
+// together than this as one wakeup.
+const int64 kWakeupGapMicroseconds = 500;
+
+class Target {
+ public:
+  Target() : callbacks_(0), wakeups_(0) {}
+
+  void Run() {
+    ++callbacks_;
+    base::TimeTicks now = base::TimeTicks::Now();
+    if ((now - last_run_time_).InMicroseconds() > kWakeupGapMicroseconds)
+      ++wakeups_;
+    last_run_time_ = now;
+  }
+
+  int callbacks() const { return callbacks_; }
+  int wakeups() const { return wakeups_; }
+
+ private:
+  int callbacks_;
+  int wakeups_;
+  base::TimeTicks last_run_time_;
+};
+
+typedef base::OneShotTimer<Target> TargetOneShotTimer;
+typedef base::RepeatingTimer<Target> TargetRepeatingTimer;
+
+}  // namespace
+
+TEST(TimerPerfTest, Reset) {
+  MessageLoop loop;
+  Target target;
+  ScopedVector<TargetOneShotTimer> timers;
+  for (int i = 0; i < kTimers; ++i) {
+    timers.push_back(new TargetOneShotTimer);
+    timers[i]->Start(FROM_HERE, base::TimeDelta::FromMinutes(1), &target,
+                     &Target::Run);
+  }
+
+  PerfTimer timer;
+  for (int i = 0; i < kResetsPerTimer; ++i) {
+    for (int j = 0; j < kTimers; ++j)
+      timers[j]->Reset();
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  LogPerfResult("Timer_Reset",
+                elapsed.InMicroseconds() * 1000.0 / (kTimers * kResetsPerTimer),
+                "ns/reset");
+  EXPECT_EQ(0, target.callbacks());
+}
+
+// Runs timers with spread out delays for a second, with and without slack.
+void RunWakeupTest(int slack_ms) {
+  const int kRepeatingTimers = 1000;
+  MessageLoop loop;
+  Target target;
+  ScopedVector<TargetRepeatingTimer> timers;
+  for (int i = 0; i < kRepeatingTimers; ++i) {
+    timers.push_back(new TargetRepeatingTimer);
+    timers[i]->set_slack(base::TimeDelta::FromMilliseconds(slack_ms));
+    timers[i]->Start(FROM_HERE,
+                     base::TimeDelta::FromMilliseconds(50 + i % 200),
+                     &target, &Target::Run);
+  }
+
+  MessageLoop::current()->PostDelayedTask(
+      FROM_HERE, MessageLoop::QuitClosure(), base::TimeDelta::FromSeconds(1));
+  MessageLoop::current()->Run();
+
+  LogPerfResult(base::StringPrintf("Timer_Wakeups_Slack%dms", slack_ms).c_str(),
+                target.wakeups(), "wakeups/s");
+  EXPECT_GT(target.callbacks(), kRepeatingTimers);
+}
+
+TEST(TimerPerfTest, Wakeups) {
+  RunWakeupTest(0);
+}
+
+TEST(TimerPerfTest, WakeupsWithSlack) {
+  RunWakeupTest(16);
+}
@@ -252,6 +252,158 @@ class DelayTimerFatalTarget {
 };
 
 
+// Records when it was run, and quits the loop.
+class TimeRecordingTarget {
+ public:
+  TimeRecordingTarget() : runs_(0) {}
+
+  void Run() {
+    ++runs_;
+    run_time_ = base::TimeTicks::Now();
+    MessageLoop::current()->Quit();
+  }
+
+  int runs() const { return runs_; }
+  base::TimeTicks run_time() const { return run_time_; }
+
+ private:
+  int runs_;
+  base::TimeTicks run_time_;
+};
+
+void RunTest_OneShotTimer_Reset(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  TimeRecordingTarget target;
+  base::OneShotTimer<TimeRecordingTarget> timer;
+  timer.Start(FROM_HERE, TimeDelta::FromMilliseconds(20), &target,
+              &TimeRecordingTarget::Run);
+  for (int i = 0; i < 5; ++i) {
+    base::PlatformThread::Sleep(TimeDelta::FromMilliseconds(2));
+    timer.Reset();
+  }
+  base::TimeTicks last_reset_time = base::TimeTicks::Now();
+  timer.Reset();
+
+  MessageLoop::current()->Run();
+
+  EXPECT_EQ(1, target.runs());
+  EXPECT_GE(target.run_time() - last_reset_time,
+            TimeDelta::FromMilliseconds(20));
+  EXPECT_FALSE(timer.IsRunning());
+}
+
+void RunTest_OneShotTimer_Restart(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  // The task posted by the first Start() must not run the timer again.
+  TimeRecordingTarget target;
+  base::OneShotTimer<TimeRecordingTarget> timer;
+  timer.Start(FROM_HERE, TimeDelta::FromMilliseconds(20), &target,
+              &TimeRecordingTarget::Run);
+  timer.Stop();
+  EXPECT_FALSE(timer.IsRunning());
+  timer.Start(FROM_HERE, TimeDelta::FromMilliseconds(10), &target,
+              &TimeRecordingTarget::Run);
+  EXPECT_TRUE(timer.IsRunning());
+
+  MessageLoop::current()->Run();
+  EXPECT_EQ(1, target.runs());
+
+  MessageLoop::current()->PostDelayedTask(
+      FROM_HERE, MessageLoop::QuitClosure(), TimeDelta::FromMilliseconds(30));
+  MessageLoop::current()->Run();
+  EXPECT_EQ(1, target.runs());
+}
+
+void RunTest_OneShotTimer_Slack(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  TimeRecordingTarget target;
+  base::OneShotTimer<TimeRecordingTarget> timer;
+  timer.set_slack(TimeDelta::FromMilliseconds(20));
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  timer.Start(FROM_HERE, TimeDelta::FromMilliseconds(5), &target,
+              &TimeRecordingTarget::Run);
+
+  MessageLoop::current()->Run();
+
+  EXPECT_EQ(1, target.runs());
+  EXPECT_GE(target.run_time() - start_time, TimeDelta::FromMilliseconds(5));
+}
+
+// Counts the runs of several timers, noting when the first and the last ran,
+// and quits the loop once all have run.
+class CountingTarget {
+ public:
+  explicit CountingTarget(int num_timers)
+      : num_timers_(num_timers), runs_(0) {
+  }
+
+  void Run() {
+    base::TimeTicks now = base::TimeTicks::Now();
+    if (runs_ == 0)
+      first_run_time_ = now;
+    last_run_time_ = now;
+    if (++runs_ == num_timers_)
+      MessageLoop::current()->Quit();
+  }
+
+  int runs() const { return runs_; }
+  base::TimeTicks first_run_time() const { return first_run_time_; }
+  base::TimeTicks last_run_time() const { return last_run_time_; }
+
+ private:
+  const int num_timers_;
+  int runs_;
+  base::TimeTicks first_run_time_;
+  base::TimeTicks last_run_time_;
+};
+
+// Returns |time| rounded up to a multiple of |slack|.
+base::TimeTicks RoundUpToSlack(base::TimeTicks time, TimeDelta slack) {
+  int64 slack_us = slack.InMicroseconds();
+  return base::TimeTicks::FromInternalValue(
+      (time.ToInternalValue() + slack_us - 1) / slack_us * slack_us);
+}
+
+void RunTest_OneShotTimer_SlackCoalesces(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  const TimeDelta kSlack = TimeDelta::FromMilliseconds(50);
+  const TimeDelta kDelay1 = TimeDelta::FromMilliseconds(5);
+  const TimeDelta kDelay2 = TimeDelta::FromMilliseconds(15);
+
+  // Start just after a multiple of the slack, so that both delays end before
+  // the next one.
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::PlatformThread::Sleep(
+      RoundUpToSlack(now, kSlack) - now + TimeDelta::FromMilliseconds(1));
+
+  CountingTarget target(2);
+  base::OneShotTimer<CountingTarget> timer1;
+  base::OneShotTimer<CountingTarget> timer2;
+  timer1.set_slack(kSlack);
+  timer2.set_slack(kSlack);
+  base::TimeTicks start_time1 = base::TimeTicks::Now();
+  timer1.Start(FROM_HERE, kDelay1, &target, &CountingTarget::Run);
+  base::TimeTicks start_time2 = base::TimeTicks::Now();
+  timer2.Start(FROM_HERE, kDelay2, &target, &CountingTarget::Run);
+  base::TimeTicks run_time = RoundUpToSlack(start_time1 + kDelay1, kSlack);
+  ASSERT_TRUE(run_time == RoundUpToSlack(start_time2 + kDelay2, kSlack));
+
+  MessageLoop::current()->Run();
+
+  EXPECT_EQ(2, target.runs());
+  // Both ran at the multiple of the slack after their delays, not when their
+  // delays ended...
+  EXPECT_TRUE(target.first_run_time() >= run_time);
+  // ...so the second was already due when the first ran, and both ran in one
+  // wakeup.
+  EXPECT_TRUE(target.first_run_time() >= start_time2 + kDelay2);
+  EXPECT_TRUE(target.last_run_time() >= run_time);
+}
+
 void RunTest_DelayTimer_Deleted(MessageLoop::Type message_loop_type) {
   MessageLoop loop(message_loop_type);
 
@@ -295,6 +447,30 @@ TEST(TimerTest, OneShotSelfDeletingTimer) {
   RunTest_OneShotSelfDeletingTimer(MessageLoop::TYPE_IO);
 }
 
+TEST(TimerTest, OneShotTimer_Reset) {
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_DEFAULT);
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_UI);
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_IO);
+}
+
+TEST(TimerTest, OneShotTimer_Restart) {
+  RunTest_OneShotTimer_Restart(MessageLoop::TYPE_DEFAULT);
+  RunTest_OneShotTimer_Restart(MessageLoop::TYPE_UI);
+  RunTest_OneShotTimer_Restart(MessageLoop::TYPE_IO);
+}
+
+TEST(TimerTest, OneShotTimer_Slack) {
+  RunTest_OneShotTimer_Slack(MessageLoop::TYPE_DEFAULT);
+  RunTest_OneShotTimer_Slack(MessageLoop::TYPE_UI);
+  RunTest_OneShotTimer_Slack(MessageLoop::TYPE_IO);
+}
+
+TEST(TimerTest, OneShotTimer_SlackCoalesces) {
+  RunTest_OneShotTimer_SlackCoalesces(MessageLoop::TYPE_DEFAULT);
+  RunTest_OneShotTimer_SlackCoalesces(MessageLoop::TYPE_UI);
+  RunTest_OneShotTimer_SlackCoalesces(MessageLoop::TYPE_IO);
+}
+
 TEST(TimerTest, RepeatingTimer) {
   RunTest_RepeatingTimer(MessageLoop::TYPE_DEFAULT);
   RunTest_RepeatingTimer(MessageLoop::TYPE_UI);
@@ -5,7 +5,11 @@
 #include "base/tracked_objects.h"
 
 #include <math.h>
+#include <string.h>
 
+#include <algorithm>
+
+#include "base/bits.h"
 #include "base/format_macros.h"
 #include "base/message_loop.h"
 #include "base/stringprintf.h"
@@ -61,10 +65,13 @@ DeathData::DeathData(int count) {
 
 void DeathData::RecordDeath(const DurationInt queue_duration,
                             const DurationInt run_duration,
-                            int32 random_number) {
-  ++count_;
-  queue_duration_sum_ += queue_duration;
-  run_duration_sum_ += run_duration;
+                            int32 random_number,
+                            int weight) {
+  count_ += weight;
+  queue_duration_sum_ += queue_duration * weight;
+  run_duration_sum_ += run_duration * weight;
+  queue_duration_histogram_[DurationBucket(queue_duration)] += weight;
+  run_duration_histogram_[DurationBucket(run_duration)] += weight;
 
   if (queue_duration_max_ < queue_duration)
     queue_duration_max_ = queue_duration;
@@ -72,11 +79,12 @@ void DeathData::RecordDeath(const DurationInt queue_duration,
     run_duration_max_ = run_duration;
 
   // Take a uniformly distributed sample over all durations ever supplied.
-  // The probability that we (instead) use this new sample is 1/count_.  This
-  // results in a completely uniform selection of the sample.
+  // The probability that we (instead) use this new sample is weight/count_.
+  // This results in a completely uniform selection of the sample.
   // We ignore the fact that we correlated our selection of a sample of run
   // and queue times.
-  if (0 == (random_number % count_)) {
+  if (static_cast<uint32>(random_number) % count_ <
+      static_cast<uint32>(weight)) {
     queue_duration_sample_ = queue_duration;
     run_duration_sample_ = run_duration;
   }
@@ -104,6 +112,54 @@ DurationInt DeathData::queue_duration_sample() const {
   return queue_duration_sample_;
 }
 
+DurationInt DeathData::run_duration_percentile(int percentile) const {
+  return Percentile(run_duration_histogram_, count_, run_duration_max_,
+                    percentile);
+}
+
+DurationInt DeathData::queue_duration_percentile(int percentile) const {
+  return Percentile(queue_duration_histogram_, count_, queue_duration_max_,
+                    percentile);
+}
+
+// static
+int DeathData::DurationBucket(DurationInt duration) {
+  if (duration <= 0)
+    return 0;
+  return std::min(1 + base::bits::Log2Floor(duration), kDurationBuckets - 1);
+}
+
+// static
+DurationInt DeathData::Percentile(const int* histogram,
+                                  int count,
+                                  DurationInt max,
+                                  int percentile) {
+  if (count <= 0)
+    return 0;
+  // The rank, counting from 1, of the death we want.
+  int64 rank = (static_cast<int64>(count) * percentile + 99) / 100;
+  int64 below = 0;
+  for (int bucket = 0; bucket < kDurationBuckets; ++bucket) {
+    if (below + histogram[bucket] < rank) {
+      below += histogram[bucket];
+      continue;
+    }
+    if (bucket == 0)
+      return 0;
+    // Assume the durations are spread evenly over the bucket, which ends at
+    // the max if that is in it.
+    int64 low = 1 << (bucket - 1);
+    int64 high = bucket < kDurationBuckets - 1 ? (1 << bucket) - 1 : max;
+    if (max >= low && max < high)
+      high = max;
+    if (high < low)  // The max has been reset.
+      high = low;
+    return static_cast<DurationInt>(
+        low + (high - low) * (rank - below) / histogram[bucket]);
+  }
+  return max;
+}
+
 
 base::DictionaryValue* DeathData::ToValue() const {
   base::DictionaryValue* dictionary = new base::DictionaryValue;
@@ -120,6 +176,18 @@ base::DictionaryValue* DeathData::ToValue() const {
       base::Value::CreateIntegerValue(queue_duration_max()));
   dictionary->Set("queue_ms_sample",
       base::Value::CreateIntegerValue(queue_duration_sample()));
+  dictionary->Set("run_ms_p50",
+      base::Value::CreateIntegerValue(run_duration_percentile(50)));
+  dictionary->Set("run_ms_p90",
+      base::Value::CreateIntegerValue(run_duration_percentile(90)));
+  dictionary->Set("run_ms_p99",
+      base::Value::CreateIntegerValue(run_duration_percentile(99)));
+  dictionary->Set("queue_ms_p50",
+      base::Value::CreateIntegerValue(queue_duration_percentile(50)));
+  dictionary->Set("queue_ms_p90",
+      base::Value::CreateIntegerValue(queue_duration_percentile(90)));
+  dictionary->Set("queue_ms_p99",
+      base::Value::CreateIntegerValue(queue_duration_percentile(99)));
   return dictionary;
 }
 
@@ -136,6 +204,8 @@ void DeathData::Clear() {
   queue_duration_sum_ = 0;
   queue_duration_max_ = 0;
   queue_duration_sample_ = 0;
+  memset(run_duration_histogram_, 0, sizeof(run_duration_histogram_));
+  memset(queue_duration_histogram_, 0, sizeof(queue_duration_histogram_));
 }
 
 //------------------------------------------------------------------------------
@@ -158,11 +228,11 @@ void BirthOnThread::ToValue(const std::string& prefix,
 //------------------------------------------------------------------------------
 Births::Births(const Location& location, const ThreadData& current)
     : BirthOnThread(location, current),
-      birth_count_(1) { }
+      birth_count_(0) { }
 
 int Births::birth_count() const { return birth_count_; }
 
-void Births::RecordBirth() { ++birth_count_; }
+void Births::RecordBirth(int weight) { birth_count_ += weight; }
 
 void Births::ForgetBirth() { --birth_count_; }
 
@@ -204,10 +274,14 @@ base::LazyInstance<base::Lock>::Leaky
 // static
 ThreadData::Status ThreadData::status_ = ThreadData::UNINITIALIZED;
 
+// static
+int ThreadData::sampling_interval_ = 1;
+
 ThreadData::ThreadData(const std::string& suggested_name)
     : next_(NULL),
       next_retired_worker_(NULL),
       worker_thread_number_(0),
+      births_until_sample_(0),
       incarnation_count_for_pool_(-1) {
   DCHECK_GE(suggested_name.size(), 0u);
   thread_name_ = suggested_name;
@@ -218,6 +292,7 @@ ThreadData::ThreadData(int thread_number)
     : next_(NULL),
       next_retired_worker_(NULL),
       worker_thread_number_(thread_number),
+      births_until_sample_(0),
       incarnation_count_for_pool_(-1)  {
   CHECK_GT(thread_number, 0);
   base::StringAppendF(&thread_name_, "WorkerThread-%d", thread_number);
@@ -332,12 +407,23 @@ base::DictionaryValue* ThreadData::ToValue(bool reset_max) {
   return dictionary;
 }
 
-Births* ThreadData::TallyABirth(const Location& location) {
+bool ThreadData::ShouldSampleBirth() {
+  if (--births_until_sample_ > 0)
+    return false;
+  // Skip a random number of births, averaging the interval, so that tasks
+  // posted in a regular pattern aren't always, or never, sampled.
+  random_number_ = static_cast<int32>(
+      static_cast<uint32>(random_number_) * 1103515245u + 12345u);
+  births_until_sample_ = 1 + (static_cast<uint32>(random_number_) >> 8) %
+                             (2 * sampling_interval_ - 1);
+  return true;
+}
+
+Births* ThreadData::TallyABirth(const Location& location, int weight) {
   BirthMap::iterator it = birth_map_.find(location);
   Births* child;
   if (it != birth_map_.end()) {
     child =  it->second;
-    child->RecordBirth();
   } else {
     child = new Births(location, *this);  // Leak this.
     // Lock since the map may get relocated now, and other threads sometimes
@@ -345,6 +431,7 @@ Births* ThreadData::TallyABirth(const Location& location) {
     base::AutoLock lock(map_lock_);
     birth_map_[location] = child;
   }
+  child->RecordBirth(weight);
 
   if (kTrackParentChildLinks && status_ > PROFILING_ACTIVE &&
       !parent_stack_.empty()) {
@@ -378,7 +465,8 @@ void ThreadData::TallyADeath(const Births& birth,
     base::AutoLock lock(map_lock_);  // Lock as the map may get relocated now.
     death_data = &death_map_[&birth];
   }  // Release lock ASAP.
-  death_data->RecordDeath(queue_duration, run_duration, random_number_);
+  death_data->RecordDeath(queue_duration, run_duration, random_number_,
+                          sampling_interval_);
 
   if (!kTrackParentChildLinks)
     return;
@@ -398,7 +486,10 @@ Births* ThreadData::TallyABirthIfActive(const Location& location) {
   ThreadData* current_thread_data = Get();
   if (!current_thread_data)
     return NULL;
-  return current_thread_data->TallyABirth(location);
+  int weight = sampling_interval_;
+  if (weight > 1 && !current_thread_data->ShouldSampleBirth())
+    return NULL;
+  return current_thread_data->TallyABirth(location, weight);
 }
 
 // static
@@ -647,9 +738,23 @@ bool ThreadData::tracking_parent_child_status() {
   return status_ >= PROFILING_CHILDREN_ACTIVE;
 }
 
+// static
+void ThreadData::SetSamplingInterval(int interval) {
+  DCHECK_GE(interval, 1);
+  sampling_interval_ = interval;
+}
+
+// static
+int ThreadData::sampling_interval() {
+  return sampling_interval_;
+}
+
 // static
 TrackedTime ThreadData::NowForStartOfRun(const Births* parent) {
-  if (kTrackParentChildLinks && parent && status_ > PROFILING_ACTIVE) {
+  // Runs of tasks whose births weren't tallied aren't tallied either.
+  if (!parent)
+    return TrackedTime();
+  if (kTrackParentChildLinks && status_ > PROFILING_ACTIVE) {
     ThreadData* current_thread_data = Get();
     if (current_thread_data)
       current_thread_data->parent_stack_.push(parent);
@@ -708,6 +813,7 @@ void ThreadData::ShutdownSingleThreadedCleanup(bool leak) {
   cleanup_count_ = 0;
   tls_index_.Set(NULL);
   status_ = DORMANT_DURING_TESTS;  // Almost UNINITIALIZED.
+  sampling_interval_ = 1;
 
   // To avoid any chance of racing in unit tests, which is the only place we
   // call this function, we may sometimes leak all the data structures we
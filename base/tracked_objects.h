@@ -224,12 +224,14 @@ class BASE_EXPORT BirthOnThread {
 
 class BASE_EXPORT Births: public BirthOnThread {
  public:
+  // The count starts at zero; the first birth is recorded like the rest.
   Births(const Location& location, const ThreadData& current);
 
   int birth_count() const;
 
-  // When we have a birth we update the count for this BirhPLace.
-  void RecordBirth();
+  // When we have a birth we update the count for this BirhPLace.  When only
+  // some births are sampled, each sampled birth stands for |weight| births.
+  void RecordBirth(int weight);
 
   // When a birthplace is changed (updated), we need to decrement the counter
   // for the old instance.
@@ -261,10 +263,12 @@ class BASE_EXPORT DeathData {
   explicit DeathData(int count);
 
   // Update stats for a task destruction (death) that had a Run() time of
-  // |duration|, and has had a queueing delay of |queue_duration|.
+  // |duration|, and has had a queueing delay of |queue_duration|.  When only
+  // some tasks are sampled, each sampled death stands for |weight| deaths.
   void RecordDeath(const DurationInt queue_duration,
                    const DurationInt run_duration,
-                   int random_number);
+                   int random_number,
+                   int weight);
 
   // Metrics accessors, used only in tests.
   int count() const;
@@ -275,6 +279,12 @@ class BASE_EXPORT DeathData {
   DurationInt queue_duration_max() const;
   DurationInt queue_duration_sample() const;
 
+  // Estimates of the durations that |percentile| percent of the deaths were
+  // at most.  Durations are kept in power of two buckets, so these are only
+  // exact when they are the max, as they are for a single death.
+  DurationInt run_duration_percentile(int percentile) const;
+  DurationInt queue_duration_percentile(int percentile) const;
+
   // Construct a DictionaryValue instance containing all our stats. The caller
   // assumes ownership of the returned instance.
   base::DictionaryValue* ToValue() const;
@@ -286,6 +296,16 @@ class BASE_EXPORT DeathData {
   void Clear();
 
  private:
+  // Bucket i > 0 holds durations in [2^(i-1), 2^i), bucket 0 holds zero, and
+  // the last bucket holds everything above 16 seconds.
+  static const int kDurationBuckets = 16;
+
+  static int DurationBucket(DurationInt duration);
+  static DurationInt Percentile(const int* histogram,
+                                int count,
+                                DurationInt max,
+                                int percentile);
+
   // Members are ordered from most regularly read and updated, to least
   // frequently used.  This might help a bit with cache lines.
   // Number of runs seen (divisor for calculating averages).
@@ -301,6 +321,9 @@ class BASE_EXPORT DeathData {
   // and rarely updated.
   DurationInt run_duration_sample_;
   DurationInt queue_duration_sample_;
+  // Distributions, used to compute percentiles.
+  int run_duration_histogram_[kDurationBuckets];
+  int queue_duration_histogram_[kDurationBuckets];
 };
 
 //------------------------------------------------------------------------------
@@ -452,12 +475,21 @@ class BASE_EXPORT ThreadData {
   // on.  This is currently a compiled option, atop tracking_status().
   static bool tracking_parent_child_status();
 
+  // Profile only about one in |interval| tasks, chosen at random on each
+  // thread, to make tracking cheap enough to leave on.  Counts and totals are
+  // scaled up by |interval| to estimate those of all tasks; changing the
+  // interval while tasks are in flight skews the count of those still alive.
+  // An |interval| of 1, the default, profiles every task.
+  static void SetSamplingInterval(int interval);
+  static int sampling_interval();
+
   // Special versions of Now() for getting times at start and end of a tracked
   // run.  They are super fast when tracking is disabled, and have some internal
   // side effects when we are tracking, so that we can deduce the amount of time
   // accumulated outside of execution of tracked runs.
   // The task that will be tracked is passed in as |parent| so that parent-child
-  // relationships can be (optionally) calculated.
+  // relationships can be (optionally) calculated.  If it is NULL, the task
+  // won't be tallied and a null time is returned.
   static TrackedTime NowForStartOfRun(const Births* parent);
   static TrackedTime NowForEndOfRun();
 
@@ -503,8 +535,12 @@ class BASE_EXPORT ThreadData {
   ThreadData* next() const;
 
 
-  // In this thread's data, record a new birth.
-  Births* TallyABirth(const Location& location);
+  // Decides whether the next birth on this thread is sampled, when only one
+  // in |sampling_interval_| is.
+  bool ShouldSampleBirth();
+
+  // In this thread's data, record a new birth, standing for |weight| births.
+  Births* TallyABirth(const Location& location, int weight);
 
   // Find a place to record a death on this thread.
   void TallyADeath(const Births& birth,
@@ -580,6 +616,9 @@ class BASE_EXPORT ThreadData {
   // We set status_ to SHUTDOWN when we shut down the tracking service.
   static Status status_;
 
+  // Profile one in this many tasks.
+  static int sampling_interval_;
+
   // Link to next instance (null terminated list). Used to globally track all
   // registered instances (corresponds to all registered threads where we keep
   // data).
@@ -641,6 +680,9 @@ class BASE_EXPORT ThreadData {
   // we stir in more and more as we go.
   int32 random_number_;
 
+  // How many more births on this thread are skipped before the next sample.
+  int births_until_sample_;
+
   // Record of what the incarnation_counter_ was when this instance was created.
   // If the incarnation_counter_ has changed, then we avoid pushing into the
   // pool (this is only critical in tests which go through multiple
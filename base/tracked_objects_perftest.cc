@@ -0,0 +1,68 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/tracked_objects.h"
+#include "base/tracking_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tracked_objects {
+
+namespace {
+
+const int kTasks = 1000000;
+
+// Tasks are posted from this many places.
+const int kLocations = 64;
+
+// Does what MessageLoop does to track a task, from posting it to running it,
+// for |kTasks| tasks, and logs the cost per task.
+void RunTrackingTest(const char* name) {
+  ThreadData::InitializeThreadContext("PerfTestThread");
+  Location* locations[kLocations];
+  for (int i = 0; i < kLocations; ++i)
+    locations[i] = new Location("RunTrackingTest", "FixedFileName", i, NULL);
+
+  PerfTimer timer;
+  for (int i = 0; i < kTasks; ++i) {
+    base::TrackingInfo pending_task(*locations[i % kLocations],
+                                    base::TimeTicks());
+    TrackedTime start_time =
+        ThreadData::NowForStartOfRun(pending_task.birth_tally);
+    ThreadData::TallyRunOnNamedThreadIfTracking(pending_task, start_time,
+                                                ThreadData::NowForEndOfRun());
+  }
+  LogPerfResult(name, timer.Elapsed().InMicroseconds() * 1000.0 / kTasks,
+                "ns/task");
+
+  // The Location objects are leaked, as births refer to them.
+}
+
+}  // namespace
+
+TEST(TrackedObjectsPerfTest, Disabled) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(false))
+    return;
+  RunTrackingTest("TrackedObjects_Disabled");
+}
+
+TEST(TrackedObjectsPerfTest, AllTasks) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;
+  ThreadData::SetSamplingInterval(1);
+  RunTrackingTest("TrackedObjects_AllTasks");
+}
+
+TEST(TrackedObjectsPerfTest, Sampled) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;
+  const int kInterval = 100;
+  ThreadData::SetSamplingInterval(kInterval);
+  RunTrackingTest(base::StringPrintf("TrackedObjects_Sampled%d",
+                                     kInterval).c_str());
+  ThreadData::SetSamplingInterval(1);
+}
+
+}  // namespace tracked_objects
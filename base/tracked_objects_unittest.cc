@@ -193,9 +193,15 @@ TEST_F(TrackedObjectsTest, ParentChildTest) {
             "\"count\":2,"
             "\"queue_ms\":0,"
             "\"queue_ms_max\":0,"
+            "\"queue_ms_p50\":0,"
+            "\"queue_ms_p90\":0,"
+            "\"queue_ms_p99\":0,"
             "\"queue_ms_sample\":0,"
             "\"run_ms\":0,"
             "\"run_ms_max\":0,"
+            "\"run_ms_p50\":0,"
+            "\"run_ms_p90\":0,"
+            "\"run_ms_p99\":0,"
             "\"run_ms_sample\":0"
           "},"
           "\"death_thread\":\"Still_Alive\","
@@ -226,14 +232,14 @@ TEST_F(TrackedObjectsTest, DeathDataTest) {
   DurationInt queue_ms = 8;
 
   const int kUnrandomInt = 0;  // Fake random int that ensure we sample data.
-  data->RecordDeath(queue_ms, run_ms, kUnrandomInt);
+  data->RecordDeath(queue_ms, run_ms, kUnrandomInt, 1);
   EXPECT_EQ(data->run_duration_sum(), run_ms);
   EXPECT_EQ(data->run_duration_sample(), run_ms);
   EXPECT_EQ(data->queue_duration_sum(), queue_ms);
   EXPECT_EQ(data->queue_duration_sample(), queue_ms);
   EXPECT_EQ(data->count(), 1);
 
-  data->RecordDeath(queue_ms, run_ms, kUnrandomInt);
+  data->RecordDeath(queue_ms, run_ms, kUnrandomInt, 1);
   EXPECT_EQ(data->run_duration_sum(), run_ms + run_ms);
   EXPECT_EQ(data->run_duration_sample(), run_ms);
   EXPECT_EQ(data->queue_duration_sum(), queue_ms + queue_ms);
@@ -260,14 +266,88 @@ TEST_F(TrackedObjectsTest, DeathDataTest) {
       "\"count\":2,"
       "\"queue_ms\":16,"
       "\"queue_ms_max\":8,"
+      "\"queue_ms_p50\":8,"
+      "\"queue_ms_p90\":8,"
+      "\"queue_ms_p99\":8,"
       "\"queue_ms_sample\":8,"
       "\"run_ms\":84,"
       "\"run_ms_max\":42,"
+      "\"run_ms_p50\":37,"
+      "\"run_ms_p90\":42,"
+      "\"run_ms_p99\":42,"
       "\"run_ms_sample\":42"
       "}";
   EXPECT_EQ(birth_only_result, json);
 }
 
+TEST_F(TrackedObjectsTest, DeathDataPercentiles) {
+  DeathData data;
+  EXPECT_EQ(0, data.run_duration_percentile(50));
+
+  // Durations are kept in power of two buckets, but spread evenly like these
+  // they come out exact.
+  const int kUnrandomInt = 0;
+  for (DurationInt run_ms = 1; run_ms <= 100; ++run_ms)
+    data.RecordDeath(0, run_ms, kUnrandomInt, 1);
+  EXPECT_EQ(100, data.count());
+  EXPECT_EQ(50, data.run_duration_percentile(50));
+  EXPECT_EQ(90, data.run_duration_percentile(90));
+  EXPECT_EQ(99, data.run_duration_percentile(99));
+  EXPECT_EQ(100, data.run_duration_percentile(100));
+  EXPECT_EQ(0, data.queue_duration_percentile(90));
+
+  // Weighted deaths count as many.  The median is now the top of the bucket
+  // holding 100, and the 99th percentile is in the bucket holding 5000.
+  data.RecordDeath(0, 5000, kUnrandomInt, 100);
+  EXPECT_EQ(200, data.count());
+  EXPECT_EQ(127, data.run_duration_percentile(50));
+  EXPECT_LE(4096, data.run_duration_percentile(99));
+  EXPECT_GE(5000, data.run_duration_percentile(99));
+}
+
+TEST_F(TrackedObjectsTest, Sampling) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;
+
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  const int kInterval = 10;
+  ThreadData::SetSamplingInterval(kInterval);
+  Location location("Sampling", "FixedFileName", 1, NULL);
+
+  const int kTasks = 1000;
+  const TrackedTime kStartOfRun = TrackedTime() +
+      Duration::FromMilliseconds(5);
+  const TrackedTime kEndOfRun = TrackedTime() + Duration::FromMilliseconds(7);
+  int sampled = 0;
+  for (int i = 0; i < kTasks; ++i) {
+    Births* birth = ThreadData::TallyABirthIfActive(location);
+    if (!birth)
+      continue;
+    ++sampled;
+    ThreadData::TallyRunInAScopedRegionIfTracking(birth, kStartOfRun,
+                                                  kEndOfRun);
+  }
+  EXPECT_GT(sampled, kTasks / kInterval / 2);
+  EXPECT_LT(sampled, kTasks / kInterval * 2);
+
+  // Unsampled tasks aren't timed.
+  EXPECT_TRUE(ThreadData::NowForStartOfRun(NULL).is_null());
+
+  scoped_ptr<base::DictionaryValue> value(ThreadData::ToValue(false));
+  base::ListValue* list;
+  ASSERT_TRUE(value->GetList("list", &list));
+  ASSERT_EQ(1u, list->GetSize());
+  base::DictionaryValue* snapshot;
+  ASSERT_TRUE(list->GetDictionary(0, &snapshot));
+  int integer;
+  EXPECT_TRUE(snapshot->GetInteger("death_data.count", &integer));
+  EXPECT_EQ(sampled * kInterval, integer);
+  EXPECT_TRUE(snapshot->GetInteger("death_data.run_ms", &integer));
+  EXPECT_EQ(sampled * kInterval * 2, integer);
+  EXPECT_TRUE(snapshot->GetInteger("death_data.run_ms_p90", &integer));
+  EXPECT_EQ(2, integer);
+}
+
 TEST_F(TrackedObjectsTest, DeactivatedBirthOnlyToValueWorkerThread) {
   // Transition to Deactivated state before doing anything.
   if (!ThreadData::InitializeAndSetTrackingStatus(false))
@@ -347,9 +427,15 @@ TEST_F(TrackedObjectsTest, BirthOnlyToValueWorkerThread) {
             "\"count\":1,"
             "\"queue_ms\":0,"
             "\"queue_ms_max\":0,"
+            "\"queue_ms_p50\":0,"
+            "\"queue_ms_p90\":0,"
+            "\"queue_ms_p99\":0,"
             "\"queue_ms_sample\":0,"
             "\"run_ms\":0,"
             "\"run_ms_max\":0,"
+            "\"run_ms_p50\":0,"
+            "\"run_ms_p90\":0,"
+            "\"run_ms_p99\":0,"
             "\"run_ms_sample\":0"
           "},"
           "\"death_thread\":\"Still_Alive\","
@@ -391,9 +477,15 @@ TEST_F(TrackedObjectsTest, BirthOnlyToValueMainThread) {
             "\"count\":1,"
             "\"queue_ms\":0,"
             "\"queue_ms_max\":0,"
+            "\"queue_ms_p50\":0,"
+            "\"queue_ms_p90\":0,"
+            "\"queue_ms_p99\":0,"
             "\"queue_ms_sample\":0,"
             "\"run_ms\":0,"
             "\"run_ms_max\":0,"
+            "\"run_ms_p50\":0,"
+            "\"run_ms_p90\":0,"
+            "\"run_ms_p99\":0,"
             "\"run_ms_sample\":0"
           "},"
           "\"death_thread\":\"Still_Alive\","
@@ -448,9 +540,15 @@ TEST_F(TrackedObjectsTest, LifeCycleToValueMainThread) {
             "\"count\":1,"
             "\"queue_ms\":4,"
             "\"queue_ms_max\":4,"
+            "\"queue_ms_p50\":4,"
+            "\"queue_ms_p90\":4,"
+            "\"queue_ms_p99\":4,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":2,"
             "\"run_ms_max\":2,"
+            "\"run_ms_p50\":2,"
+            "\"run_ms_p90\":2,"
+            "\"run_ms_p99\":2,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"SomeMainThreadName\","
@@ -512,9 +610,15 @@ TEST_F(TrackedObjectsTest, LifeCycleMidDeactivatedToValueMainThread) {
             "\"count\":1,"
             "\"queue_ms\":4,"
             "\"queue_ms_max\":4,"
+            "\"queue_ms_p50\":4,"
+            "\"queue_ms_p90\":4,"
+            "\"queue_ms_p99\":4,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":2,"
             "\"run_ms_max\":2,"
+            "\"run_ms_p50\":2,"
+            "\"run_ms_p90\":2,"
+            "\"run_ms_p99\":2,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"SomeMainThreadName\","
@@ -606,9 +710,15 @@ TEST_F(TrackedObjectsTest, LifeCycleToValueWorkerThread) {
             "\"count\":1,"
             "\"queue_ms\":4,"
             "\"queue_ms_max\":4,"
+            "\"queue_ms_p50\":4,"
+            "\"queue_ms_p90\":4,"
+            "\"queue_ms_p99\":4,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":2,"
             "\"run_ms_max\":2,"
+            "\"run_ms_p50\":2,"
+            "\"run_ms_p90\":2,"
+            "\"run_ms_p99\":2,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"WorkerThread-1\","
@@ -644,9 +754,15 @@ TEST_F(TrackedObjectsTest, LifeCycleToValueWorkerThread) {
             "\"count\":1,"
             "\"queue_ms\":4,"
             "\"queue_ms_max\":0,"  // Note zero here.
+            "\"queue_ms_p50\":7,"  // Only the bucket is known now.
+            "\"queue_ms_p90\":7,"
+            "\"queue_ms_p99\":7,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":2,"
             "\"run_ms_max\":0,"   // Note zero here.
+            "\"run_ms_p50\":3,"
+            "\"run_ms_p90\":3,"
+            "\"run_ms_p99\":3,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"WorkerThread-1\","
@@ -709,9 +825,15 @@ TEST_F(TrackedObjectsTest, TwoLives) {
             "\"count\":2,"
             "\"queue_ms\":8,"
             "\"queue_ms_max\":4,"
+            "\"queue_ms_p50\":4,"
+            "\"queue_ms_p90\":4,"
+            "\"queue_ms_p99\":4,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":4,"
             "\"run_ms_max\":2,"
+            "\"run_ms_p50\":2,"
+            "\"run_ms_p90\":2,"
+            "\"run_ms_p99\":2,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"SomeFileThreadName\","
@@ -770,9 +892,15 @@ TEST_F(TrackedObjectsTest, DifferentLives) {
             "\"count\":1,"
             "\"queue_ms\":4,"
             "\"queue_ms_max\":4,"
+            "\"queue_ms_p50\":4,"
+            "\"queue_ms_p90\":4,"
+            "\"queue_ms_p99\":4,"
             "\"queue_ms_sample\":4,"
             "\"run_ms\":2,"
             "\"run_ms_max\":2,"
+            "\"run_ms_p50\":2,"
+            "\"run_ms_p90\":2,"
+            "\"run_ms_p99\":2,"
             "\"run_ms_sample\":2"
           "},"
           "\"death_thread\":\"SomeFileThreadName\","
@@ -788,9 +916,15 @@ TEST_F(TrackedObjectsTest, DifferentLives) {
             "\"count\":1,"
             "\"queue_ms\":0,"
             "\"queue_ms_max\":0,"
+            "\"queue_ms_p50\":0,"
+            "\"queue_ms_p90\":0,"
+            "\"queue_ms_p99\":0,"
             "\"queue_ms_sample\":0,"
             "\"run_ms\":0,"
             "\"run_ms_max\":0,"
+            "\"run_ms_p50\":0,"
+            "\"run_ms_p90\":0,"
+            "\"run_ms_p99\":0,"
             "\"run_ms_sample\":0"
           "},"
           "\"death_thread\":\"Still_Alive\","
@@ -5,9 +5,107 @@
 #include "base/utf_string_conversion_utils.h"
 
 #include "base/third_party/icu/icu_utf.h"
+#include "build/build_config.h"
+
+// SSE2 is part of x86-64, and is enabled on 32-bit x86 by -msse2 in most of
+// our builds; where it isn't (32-bit MSVC), the CPU is checked at runtime.
+#if defined(ARCH_CPU_X86_FAMILY) && \
+    (defined(__SSE2__) || defined(COMPILER_MSVC))
+#define UTF_CONVERSION_USE_SSE2
+#include <emmintrin.h>
+#if !defined(__SSE2__) && !defined(ARCH_CPU_X86_64)
+#include "base/cpu.h"
+#endif
+#endif
 
 namespace base {
 
+namespace {
+
+size_t CountLeadingASCII_C(const char* src, size_t src_len) {
+  size_t i = 0;
+  while (i < src_len && static_cast<unsigned char>(src[i]) < 0x80)
+    ++i;
+  return i;
+}
+
+size_t CopyLeadingASCII_C(const char* src, size_t src_len, char16* dest) {
+  size_t i = 0;
+  for (; i < src_len && static_cast<unsigned char>(src[i]) < 0x80; ++i)
+    dest[i] = src[i];
+  return i;
+}
+
+size_t CopyLeadingASCII_C(const char16* src, size_t src_len, char* dest) {
+  size_t i = 0;
+  for (; i < src_len && src[i] < 0x80; ++i)
+    dest[i] = static_cast<char>(src[i]);
+  return i;
+}
+
+#if defined(UTF_CONVERSION_USE_SSE2)
+
+// These take 16 characters at a time while they are all ASCII, and leave the
+// rest of the run, at most 15 characters, to the C versions.
+
+size_t CountLeadingASCII_SSE2(const char* src, size_t src_len) {
+  size_t i = 0;
+  for (; i + 16 <= src_len; i += 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(chars))
+      break;
+  }
+  return i + CountLeadingASCII_C(src + i, src_len - i);
+}
+
+size_t CopyLeadingASCII_SSE2(const char* src, size_t src_len, char16* dest) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= src_len; i += 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(chars))
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_unpacklo_epi8(chars, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8),
+                     _mm_unpackhi_epi8(chars, zero));
+  }
+  return i + CopyLeadingASCII_C(src + i, src_len - i, dest + i);
+}
+
+size_t CopyLeadingASCII_SSE2(const char16* src, size_t src_len, char* dest) {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= src_len; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), non_ascii_bits);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packus_epi16(low, high));
+  }
+  return i + CopyLeadingASCII_C(src + i, src_len - i, dest + i);
+}
+
+bool CanUseSSE2() {
+#if defined(__SSE2__) || defined(ARCH_CPU_X86_64)
+  return true;
+#else
+  // Racing threads will all store the same answer.
+  static int has_sse2 = -1;
+  if (has_sse2 < 0)
+    has_sse2 = CPU().has_sse2() ? 1 : 0;
+  return has_sse2 == 1;
+#endif
+}
+
+#endif  // defined(UTF_CONVERSION_USE_SSE2)
+
+}  // namespace
+
 // ReadUnicodeCharacter --------------------------------------------------------
 
 bool ReadUnicodeCharacter(const char* src,
@@ -102,6 +200,32 @@ size_t WriteUnicodeCharacter(uint32 code_point, string16* output) {
   return CBU16_MAX_LENGTH;
 }
 
+// ASCII runs ------------------------------------------------------------------
+
+size_t CountLeadingASCII(const char* src, size_t src_len) {
+#if defined(UTF_CONVERSION_USE_SSE2)
+  if (CanUseSSE2())
+    return CountLeadingASCII_SSE2(src, src_len);
+#endif
+  return CountLeadingASCII_C(src, src_len);
+}
+
+size_t CopyLeadingASCII(const char* src, size_t src_len, char16* dest) {
+#if defined(UTF_CONVERSION_USE_SSE2)
+  if (CanUseSSE2())
+    return CopyLeadingASCII_SSE2(src, src_len, dest);
+#endif
+  return CopyLeadingASCII_C(src, src_len, dest);
+}
+
+size_t CopyLeadingASCII(const char16* src, size_t src_len, char* dest) {
+#if defined(UTF_CONVERSION_USE_SSE2)
+  if (CanUseSSE2())
+    return CopyLeadingASCII_SSE2(src, src_len, dest);
+#endif
+  return CopyLeadingASCII_C(src, src_len, dest);
+}
+
 // Generalized Unicode converter -----------------------------------------------
 
 template<typename CHAR>
@@ -79,6 +79,25 @@ inline size_t WriteUnicodeCharacter(uint32 code_point, std::wstring* output) {
 }
 #endif  // defined(WCHAR_T_IS_UTF32)
 
+// ASCII runs ------------------------------------------------------------------
+
+// Most text is mostly ASCII, which converts one code unit to one code unit.
+// These functions handle runs of it many units at a time, using SSE2 where
+// the CPU has it.
+
+// Returns the number of ASCII characters at the start of |src|.
+BASE_EXPORT size_t CountLeadingASCII(const char* src, size_t src_len);
+
+// Copies the ASCII characters at the start of |src| to |dest|, widening or
+// narrowing them, and returns how many there were.  |dest| must have room
+// for |src_len| code units; it may be written past the end of the run.
+BASE_EXPORT size_t CopyLeadingASCII(const char* src,
+                                    size_t src_len,
+                                    char16* dest);
+BASE_EXPORT size_t CopyLeadingASCII(const char16* src,
+                                    size_t src_len,
+                                    char* dest);
+
 // Generalized Unicode converter -----------------------------------------------
 
 // Guesses the length of the output in UTF-8 in bytes, clears that output
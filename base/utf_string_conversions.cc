@@ -4,6 +4,8 @@
 
 #include "base/utf_string_conversions.h"
 
+#include <algorithm>
+
 #include "base/string_piece.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversion_utils.h"
@@ -17,6 +19,48 @@ namespace {
 
 // Generalized Unicode converter -----------------------------------------------
 
+// The number of ASCII characters converted at a time through a buffer on the
+// stack.
+const size_t kASCIIChunkLength = 256;
+
+// Appends the run of ASCII characters at the start of |src| to |output|, and
+// returns its length.  Only UTF-8 <-> UTF-16 conversions have fast versions;
+// for the rest, this returns 0 and the characters are converted one by one.
+template<typename SRC_CHAR, typename DEST_STRING>
+size_t AppendLeadingASCII(const SRC_CHAR* src,
+                          size_t src_len,
+                          DEST_STRING* output) {
+  return 0;
+}
+
+template<typename SRC_CHAR, typename DEST_STRING>
+size_t AppendLeadingASCIIInChunks(const SRC_CHAR* src,
+                                  size_t src_len,
+                                  DEST_STRING* output) {
+  typename DEST_STRING::value_type buffer[kASCIIChunkLength];
+  size_t copied = 0;
+  while (copied < src_len) {
+    size_t chunk_length = std::min(src_len - copied, kASCIIChunkLength);
+    size_t run_length =
+        base::CopyLeadingASCII(src + copied, chunk_length, buffer);
+    output->append(buffer, run_length);
+    copied += run_length;
+    if (run_length < chunk_length)
+      break;
+  }
+  return copied;
+}
+
+size_t AppendLeadingASCII(const char* src, size_t src_len, string16* output) {
+  return AppendLeadingASCIIInChunks(src, src_len, output);
+}
+
+size_t AppendLeadingASCII(const char16* src,
+                          size_t src_len,
+                          std::string* output) {
+  return AppendLeadingASCIIInChunks(src, src_len, output);
+}
+
 // Converts the given source Unicode character type to the given destination
 // Unicode character type as a STL string. The given input buffer and size
 // determine the source, and the given output STL string will be replaced by
@@ -29,6 +73,14 @@ bool ConvertUnicode(const SRC_CHAR* src,
   bool success = true;
   int32 src_len32 = static_cast<int32>(src_len);
   for (int32 i = 0; i < src_len32; i++) {
+    if (static_cast<uint32>(src[i]) < 0x80) {
+      size_t run_length = AppendLeadingASCII(src + i, src_len32 - i, output);
+      if (run_length) {
+        // Leave |i| on the last character of the run for the loop.
+        i += static_cast<int32>(run_length) - 1;
+        continue;
+      }
+    }
     uint32 code_point;
     if (ReadUnicodeCharacter(src, src_len32, &i, &code_point)) {
       WriteUnicodeCharacter(code_point, output);
@@ -0,0 +1,89 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/string16.h"
+#include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "base/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kIterations = 20;
+
+// The size of each corpus, about that of a large web page.
+const size_t kCorpusLength = 1 << 20;
+
+// Builds about |kCorpusLength| UTF-16 code units by repeating |sentence|.
+string16 BuildCorpus(const char* sentence) {
+  string16 unit(UTF8ToUTF16(sentence));
+  string16 corpus;
+  corpus.reserve(kCorpusLength + unit.length());
+  while (corpus.length() < kCorpusLength)
+    corpus += unit;
+  return corpus;
+}
+
+void LogThroughput(const char* test, const char* corpus, size_t bytes,
+                   base::TimeDelta elapsed) {
+  LogPerfResult(base::StringPrintf("%s_%s", test, corpus).c_str(),
+                bytes * kIterations / elapsed.InSecondsF() / (1024 * 1024),
+                "MB/s");
+}
+
+// Measures the conversions in both directions, and validation, of |sentence|
+// repeated.  Throughput is given in terms of the UTF-8 size of the text.
+void RunConversionTests(const char* name, const char* sentence) {
+  string16 utf16(BuildCorpus(sentence));
+  std::string utf8(UTF16ToUTF8(utf16));
+
+  PerfTimer to_utf16_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    string16 result;
+    EXPECT_TRUE(UTF8ToUTF16(utf8.data(), utf8.length(), &result));
+    EXPECT_EQ(utf16.length(), result.length());
+  }
+  LogThroughput("UTF8ToUTF16", name, utf8.length(), to_utf16_timer.Elapsed());
+
+  PerfTimer to_utf8_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    std::string result;
+    EXPECT_TRUE(UTF16ToUTF8(utf16.data(), utf16.length(), &result));
+    EXPECT_EQ(utf8.length(), result.length());
+  }
+  LogThroughput("UTF16ToUTF8", name, utf8.length(), to_utf8_timer.Elapsed());
+
+  PerfTimer validate_timer;
+  for (int i = 0; i < kIterations; ++i)
+    EXPECT_TRUE(IsStringUTF8(utf8));
+  LogThroughput("IsStringUTF8", name, utf8.length(), validate_timer.Elapsed());
+}
+
+}  // namespace
+
+TEST(UTFStringConversionsPerfTest, ASCII) {
+  RunConversionTests("ASCII",
+      "The quick brown fox jumps over the lazy dog, and then it runs away "
+      "into the woods where nobody will ever find it again.\n");
+}
+
+TEST(UTFStringConversionsPerfTest, Latin1) {
+  // French, with an accented letter every few words.
+  RunConversionTests("Latin1",
+      "Le c\xC5\x93ur a ses raisons que la raison ne conna\xC3\xAEt point. "
+      "\xC3\x80 bient\xC3\xB4t, ch\xC3\xA8re amie, et merci pour le "
+      "caf\xC3\xA9.\n");
+}
+
+TEST(UTFStringConversionsPerfTest, CJK) {
+  // Japanese, with the occasional ASCII space and punctuation.
+  RunConversionTests("CJK",
+      "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB"
+      "\xA0\xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82 \xE6\x9D\xB1\xE4\xBA\xAC"
+      "\xE3\x81\xAF\xE5\xA4\xA7\xE3\x81\x8D\xE3\x81\x84\xE8\xA1\x97\xE3\x81"
+      "\xA7\xE3\x81\x99\xE3\x80\x82\n");
+}
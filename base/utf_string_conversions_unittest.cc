@@ -208,4 +208,50 @@ TEST(UTFStringConversionsTest, ConvertMultiString) {
   EXPECT_EQ(expected, converted);
 }
 
+// ASCII is converted many characters at a time, so put a non-ASCII character
+// at every position around the block boundaries.
+TEST(UTFStringConversionsTest, ConvertASCIIRuns) {
+  for (size_t length = 0; length < 40; ++length) {
+    std::string ascii;
+    for (size_t i = 0; i < length; ++i)
+      ascii.push_back(static_cast<char>('a' + i % 26));
+    string16 ascii16(ascii.begin(), ascii.end());
+
+    EXPECT_EQ(ascii16, UTF8ToUTF16(ascii));
+    EXPECT_EQ(ascii, UTF16ToUTF8(ascii16));
+    EXPECT_TRUE(IsStringUTF8(ascii));
+
+    for (size_t pos = 0; pos < length; ++pos) {
+      // U+00E9, LATIN SMALL LETTER E WITH ACUTE.
+      std::string utf8(ascii);
+      utf8.replace(pos, 1, "\xC3\xA9");
+      string16 utf16(ascii16);
+      utf16[pos] = 0xE9;
+      EXPECT_EQ(utf16, UTF8ToUTF16(utf8));
+      EXPECT_EQ(utf8, UTF16ToUTF8(utf16));
+      EXPECT_TRUE(IsStringUTF8(utf8));
+
+      // An invalid byte, and a lone surrogate, are replaced with U+FFFD.
+      std::string invalid8(ascii);
+      invalid8[pos] = '\xFF';
+      string16 replaced16(ascii16);
+      replaced16[pos] = 0xFFFD;
+      string16 converted16;
+      EXPECT_FALSE(UTF8ToUTF16(invalid8.data(), invalid8.length(),
+                               &converted16));
+      EXPECT_EQ(replaced16, converted16);
+      EXPECT_FALSE(IsStringUTF8(invalid8));
+
+      string16 invalid16(ascii16);
+      invalid16[pos] = 0xD800;
+      std::string replaced8(ascii);
+      replaced8.replace(pos, 1, "\xEF\xBF\xBD");
+      std::string converted8;
+      EXPECT_FALSE(UTF16ToUTF8(invalid16.data(), invalid16.length(),
+                               &converted8));
+      EXPECT_EQ(replaced8, converted8);
+    }
+  }
+}
+
 }  // base
@@ -5,10 +5,12 @@
 #include "base/values.h"
 
 #include <algorithm>
+#include <set>
 
 #include "base/float_util.h"
 #include "base/logging.h"
 #include "base/string_util.h"
+#include "base/synchronization/lock.h"
 #include "base/utf_string_conversions.h"
 
 namespace {
@@ -345,8 +347,38 @@ BinaryValue::BinaryValue(char* buffer, size_t size)
 
 ///////////////////// DictionaryValue ////////////////////
 
+// The keys of a tree of frozen dictionaries.  Each distinct key is only
+// stored once, however many dictionaries have it.  Trees copied from a frozen
+// tree share its keys, possibly on another thread, so interning is locked.
+class DictionaryValue::FrozenKeys
+    : public RefCountedThreadSafe<DictionaryValue::FrozenKeys> {
+ public:
+  FrozenKeys() {}
+
+  // Returns the stored copy of |key|, which lives as long as this object.
+  const std::string* Intern(const std::string& key) {
+    AutoLock auto_lock(lock_);
+    return &*keys_.insert(key).first;
+  }
+
+ private:
+  friend class RefCountedThreadSafe<FrozenKeys>;
+
+  ~FrozenKeys() {}
+
+  // Protects |keys_|.
+  Lock lock_;
+
+  // Nodes of a set don't move, so pointers to the keys stay valid.
+  std::set<std::string> keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrozenKeys);
+};
+
 DictionaryValue::DictionaryValue()
-    : Value(TYPE_DICTIONARY) {
+    : Value(TYPE_DICTIONARY),
+      frozen_(NULL),
+      frozen_size_(0) {
 }
 
 DictionaryValue::~DictionaryValue() {
@@ -367,12 +399,24 @@ bool DictionaryValue::GetAsDictionary(const DictionaryValue** out_value) const {
 
 bool DictionaryValue::HasKey(const std::string& key) const {
   DCHECK(IsStringUTF8(key));
+  if (frozen_)
+    return FindFrozenEntry(key) != NULL;
   ValueMap::const_iterator current_entry = dictionary_.find(key);
   DCHECK((current_entry == dictionary_.end()) || current_entry->second);
   return current_entry != dictionary_.end();
 }
 
 void DictionaryValue::Clear() {
+  if (frozen_) {
+    // There's no need to thaw the entries just to delete them.
+    for (size_t i = 0; i < frozen_size_; ++i)
+      delete frozen_[i].value;
+    delete[] frozen_;
+    frozen_ = NULL;
+    frozen_size_ = 0;
+    frozen_keys_ = NULL;
+  }
+
   ValueMap::iterator dict_iterator = dictionary_.begin();
   while (dict_iterator != dictionary_.end()) {
     delete dict_iterator->second;
@@ -430,6 +474,7 @@ void DictionaryValue::SetString(const std::string& path,
 
 void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
+  Thaw();
   // If there's an existing value here, we need to delete it, because
   // we own all our children.
   std::pair<ValueMap::iterator, bool> ins_res =
@@ -562,11 +607,19 @@ bool DictionaryValue::GetList(const std::string& path,
 bool DictionaryValue::GetWithoutPathExpansion(const std::string& key,
                                               Value** out_value) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
-    return false;
+  Value* entry;
+  if (frozen_) {
+    FrozenEntry* frozen_entry = FindFrozenEntry(key);
+    if (!frozen_entry)
+      return false;
+    entry = frozen_entry->value;
+  } else {
+    ValueMap::const_iterator entry_iterator = dictionary_.find(key);
+    if (entry_iterator == dictionary_.end())
+      return false;
+    entry = entry_iterator->second;
+  }
 
-  Value* entry = entry_iterator->second;
   if (out_value)
     *out_value = entry;
   return true;
@@ -656,6 +709,7 @@ bool DictionaryValue::Remove(const std::string& path, Value** out_value) {
 bool DictionaryValue::RemoveWithoutPathExpansion(const std::string& key,
                                                  Value** out_value) {
   DCHECK(IsStringUTF8(key));
+  Thaw();
   ValueMap::iterator entry_iterator = dictionary_.find(key);
   if (entry_iterator == dictionary_.end())
     return false;
@@ -694,9 +748,35 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
   }
 }
 
+void DictionaryValue::Swap(DictionaryValue* other) {
+  dictionary_.swap(other->dictionary_);
+  std::swap(frozen_, other->frozen_);
+  std::swap(frozen_size_, other->frozen_size_);
+  frozen_keys_.swap(other->frozen_keys_);
+}
+
+void DictionaryValue::Freeze() {
+  scoped_refptr<FrozenKeys> keys(frozen_keys_);
+  if (!keys)
+    keys = new FrozenKeys;
+  FreezeValue(this, keys);
+}
+
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
 
+  if (frozen_) {
+    // The copy is frozen as well, and shares the keys.
+    result->frozen_ = new FrozenEntry[frozen_size_];
+    result->frozen_size_ = frozen_size_;
+    result->frozen_keys_ = frozen_keys_;
+    for (size_t i = 0; i < frozen_size_; ++i) {
+      result->frozen_[i].key = frozen_[i].key;
+      result->frozen_[i].value = frozen_[i].value->DeepCopy();
+    }
+    return result;
+  }
+
   for (ValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
     result->SetWithoutPathExpansion(current_entry->first,
@@ -732,6 +812,70 @@ bool DictionaryValue::Equals(const Value* other) const {
   return true;
 }
 
+// static
+void DictionaryValue::FreezeValue(Value* value, FrozenKeys* keys) {
+  if (value->IsType(TYPE_LIST)) {
+    ListValue* list = static_cast<ListValue*>(value);
+    for (ListValue::iterator it = list->begin(); it != list->end(); ++it)
+      FreezeValue(*it, keys);
+    return;
+  }
+  if (!value->IsType(TYPE_DICTIONARY))
+    return;
+
+  DictionaryValue* dictionary = static_cast<DictionaryValue*>(value);
+  if (!dictionary->frozen_ && !dictionary->dictionary_.empty()) {
+    // The map is already sorted by key.
+    ValueMap& map = dictionary->dictionary_;
+    FrozenEntry* entries = new FrozenEntry[map.size()];
+    size_t i = 0;
+    for (ValueMap::const_iterator it = map.begin(); it != map.end(); ++it) {
+      entries[i].key = keys->Intern(it->first);
+      entries[i].value = it->second;
+      ++i;
+    }
+    dictionary->frozen_ = entries;
+    dictionary->frozen_size_ = map.size();
+    dictionary->frozen_keys_ = keys;
+    map.clear();
+  }
+
+  for (size_t i = 0; i < dictionary->frozen_size_; ++i)
+    FreezeValue(dictionary->frozen_[i].value, keys);
+}
+
+DictionaryValue::FrozenEntry* DictionaryValue::FindFrozenEntry(
+    const std::string& key) const {
+  size_t low = 0;
+  size_t high = frozen_size_;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    int comparison = frozen_[middle].key->compare(key);
+    if (comparison == 0)
+      return &frozen_[middle];
+    if (comparison < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return NULL;
+}
+
+void DictionaryValue::Thaw() {
+  if (!frozen_)
+    return;
+
+  // The entries are sorted, so each one goes at the end of the map.
+  for (size_t i = 0; i < frozen_size_; ++i) {
+    dictionary_.insert(dictionary_.end(),
+                       std::make_pair(*frozen_[i].key, frozen_[i].value));
+  }
+  delete[] frozen_;
+  frozen_ = NULL;
+  frozen_size_ = 0;
+  frozen_keys_ = NULL;
+}
+
 ///////////////////// ListValue ////////////////////
 
 ListValue::ListValue() : Value(TYPE_LIST) {
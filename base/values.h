@@ -30,6 +30,7 @@
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
 #include "base/string16.h"
 
 // This file declares "using base::Value", etc. at the bottom, so that
@@ -212,7 +213,14 @@ class BASE_EXPORT BinaryValue: public Value {
 // DictionaryValue provides a key-value dictionary with (optional) "path"
 // parsing for recursive access; see the comment at the top of the file. Keys
 // are |std::string|s and should be UTF-8 encoded.
+//
+// Large trees that are read far more often than they are written, such as
+// preferences and extension manifests, can be frozen with Freeze().  See
+// below.
 class BASE_EXPORT DictionaryValue : public Value {
+ private:
+  struct FrozenEntry;
+
  public:
   DictionaryValue();
   virtual ~DictionaryValue();
@@ -226,10 +234,10 @@ class BASE_EXPORT DictionaryValue : public Value {
   bool HasKey(const std::string& key) const;
 
   // Returns the number of Values in this dictionary.
-  size_t size() const { return dictionary_.size(); }
+  size_t size() const { return frozen_ ? frozen_size_ : dictionary_.size(); }
 
   // Returns whether the dictionary is empty.
-  bool empty() const { return dictionary_.empty(); }
+  bool empty() const { return size() == 0; }
 
   // Clears any current contents of this dictionary.
   void Clear();
@@ -320,9 +328,19 @@ class BASE_EXPORT DictionaryValue : public Value {
   void MergeDictionary(const DictionaryValue* dictionary);
 
   // Swaps contents with the |other| dictionary.
-  void Swap(DictionaryValue* other) {
-    dictionary_.swap(other->dictionary_);
-  }
+  void Swap(DictionaryValue* other);
+
+  // Packs this dictionary, and the dictionaries below it, into sorted arrays
+  // of entries, one allocation each, whose keys are shared by the whole tree.
+  // This takes far less memory than the usual representation and is quicker
+  // to look up in.  Frozen dictionaries can be used like any other, and each
+  // one goes back to the usual representation the first time it's modified.
+  // Empty dictionaries are left as they are.
+  void Freeze();
+
+  // Returns true if this dictionary is frozen.  Dictionaries below it may not
+  // be, if they have been modified since.
+  bool is_frozen() const { return frozen_ != NULL; }
 
   // This class provides an iterator for the keys in the dictionary.
   // It can't be used to modify the dictionary.
@@ -333,38 +351,72 @@ class BASE_EXPORT DictionaryValue : public Value {
   class key_iterator
       : private std::iterator<std::input_iterator_tag, const std::string> {
    public:
-    explicit key_iterator(ValueMap::const_iterator itr) { itr_ = itr; }
+    explicit key_iterator(ValueMap::const_iterator itr)
+        : itr_(itr), frozen_itr_(NULL) {}
+    explicit key_iterator(const FrozenEntry* frozen_itr)
+        : frozen_itr_(frozen_itr) {}
     key_iterator operator++() {
-      ++itr_;
+      if (frozen_itr_)
+        ++frozen_itr_;
+      else
+        ++itr_;
       return *this;
     }
-    const std::string& operator*() { return itr_->first; }
-    bool operator!=(const key_iterator& other) { return itr_ != other.itr_; }
-    bool operator==(const key_iterator& other) { return itr_ == other.itr_; }
+    const std::string& operator*() {
+      return frozen_itr_ ? *frozen_itr_->key : itr_->first;
+    }
+    bool operator!=(const key_iterator& other) { return !(*this == other); }
+    bool operator==(const key_iterator& other) {
+      if (frozen_itr_ || other.frozen_itr_)
+        return frozen_itr_ == other.frozen_itr_;
+      return itr_ == other.itr_;
+    }
 
    private:
     ValueMap::const_iterator itr_;
+    const FrozenEntry* frozen_itr_;
   };
 
-  key_iterator begin_keys() const { return key_iterator(dictionary_.begin()); }
-  key_iterator end_keys() const { return key_iterator(dictionary_.end()); }
+  key_iterator begin_keys() const {
+    return frozen_ ? key_iterator(frozen_) : key_iterator(dictionary_.begin());
+  }
+  key_iterator end_keys() const {
+    return frozen_ ? key_iterator(frozen_ + frozen_size_) :
+                     key_iterator(dictionary_.end());
+  }
 
   // This class provides an iterator over both keys and values in the
   // dictionary.  It can't be used to modify the dictionary.
   class Iterator {
    public:
     explicit Iterator(const DictionaryValue& target)
-        : target_(target), it_(target.dictionary_.begin()) {}
-
-    bool HasNext() const { return it_ != target_.dictionary_.end(); }
-    void Advance() { ++it_; }
+        : target_(target),
+          it_(target.dictionary_.begin()),
+          frozen_it_(target.frozen_) {}
+
+    bool HasNext() const {
+      if (frozen_it_)
+        return frozen_it_ != target_.frozen_ + target_.frozen_size_;
+      return it_ != target_.dictionary_.end();
+    }
+    void Advance() {
+      if (frozen_it_)
+        ++frozen_it_;
+      else
+        ++it_;
+    }
 
-    const std::string& key() const { return it_->first; }
-    const Value& value() const { return *it_->second; }
+    const std::string& key() const {
+      return frozen_it_ ? *frozen_it_->key : it_->first;
+    }
+    const Value& value() const {
+      return frozen_it_ ? *frozen_it_->value : *it_->second;
+    }
 
    private:
     const DictionaryValue& target_;
     ValueMap::const_iterator it_;
+    const FrozenEntry* frozen_it_;
   };
 
   // Overridden from Value:
@@ -372,8 +424,35 @@ class BASE_EXPORT DictionaryValue : public Value {
   virtual bool Equals(const Value* other) const OVERRIDE;
 
  private:
+  class FrozenKeys;
+
+  // An entry of a frozen dictionary.  The key belongs to |frozen_keys_|.
+  struct FrozenEntry {
+    const std::string* key;
+    Value* value;
+  };
+
+  // Freezes |value| if it's a dictionary, and the dictionaries below it,
+  // adding their keys to |keys|.
+  static void FreezeValue(Value* value, FrozenKeys* keys);
+
+  // Returns the entry for |key| in a frozen dictionary, or NULL if there is
+  // none.
+  FrozenEntry* FindFrozenEntry(const std::string& key) const;
+
+  // Moves the entries of a frozen dictionary back into |dictionary_|, before
+  // it's modified.
+  void Thaw();
+
+  // Holds the entries when the dictionary isn't frozen.
   ValueMap dictionary_;
 
+  // Holds the entries, sorted by key, and the keys, when the dictionary is
+  // frozen.  |frozen_| is NULL otherwise.
+  FrozenEntry* frozen_;
+  size_t frozen_size_;
+  scoped_refptr<FrozenKeys> frozen_keys_;
+
   DISALLOW_COPY_AND_ASSIGN(DictionaryValue);
 };
 
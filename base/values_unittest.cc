@@ -755,4 +755,100 @@ TEST(ValuesTest, DictionaryIterator) {
   EXPECT_TRUE(seen2);
 }
 
+TEST(ValuesTest, Freeze) {
+  DictionaryValue root;
+  root.SetString("name", "root");
+  root.SetInteger("pref.count", 3);
+  root.SetBoolean("pref.enabled", true);
+  ListValue* list = new ListValue;
+  DictionaryValue* item = new DictionaryValue;
+  item->SetString("name", "item");
+  list->Append(item);
+  root.Set("list", list);
+  root.Set("empty", new DictionaryValue);
+  scoped_ptr<DictionaryValue> original(root.DeepCopy());
+
+  root.Freeze();
+  EXPECT_TRUE(root.is_frozen());
+  DictionaryValue* pref = NULL;
+  ASSERT_TRUE(root.GetDictionary("pref", &pref));
+  EXPECT_TRUE(pref->is_frozen());
+  EXPECT_TRUE(item->is_frozen());
+  DictionaryValue* empty = NULL;
+  ASSERT_TRUE(root.GetDictionary("empty", &empty));
+  EXPECT_FALSE(empty->is_frozen());
+
+  // Reading works as before.
+  EXPECT_EQ(4U, root.size());
+  EXPECT_TRUE(root.HasKey("name"));
+  EXPECT_FALSE(root.HasKey("missing"));
+  EXPECT_FALSE(root.HasKey("pref.count"));
+  int count = 0;
+  EXPECT_TRUE(root.GetInteger("pref.count", &count));
+  EXPECT_EQ(3, count);
+  EXPECT_FALSE(root.GetInteger("pref.missing", &count));
+  EXPECT_TRUE(root.Equals(original.get()));
+  EXPECT_TRUE(original->Equals(&root));
+
+  const char* expected_keys[] = { "empty", "list", "name", "pref" };
+  size_t i = 0;
+  for (DictionaryValue::key_iterator key = root.begin_keys();
+       key != root.end_keys(); ++key, ++i) {
+    ASSERT_LT(i, arraysize(expected_keys));
+    EXPECT_EQ(expected_keys[i], *key);
+  }
+  EXPECT_EQ(arraysize(expected_keys), i);
+  i = 0;
+  for (DictionaryValue::Iterator it(root); it.HasNext(); it.Advance(), ++i) {
+    ASSERT_LT(i, arraysize(expected_keys));
+    EXPECT_EQ(expected_keys[i], it.key());
+  }
+  EXPECT_EQ(arraysize(expected_keys), i);
+
+  // Copies are frozen too.
+  scoped_ptr<DictionaryValue> copy(root.DeepCopy());
+  EXPECT_TRUE(copy->is_frozen());
+  EXPECT_TRUE(copy->Equals(&root));
+
+  // Writing only unfreezes the dictionary that's written to.
+  root.SetInteger("pref.count", 4);
+  EXPECT_TRUE(root.is_frozen());
+  EXPECT_FALSE(pref->is_frozen());
+  EXPECT_TRUE(root.GetInteger("pref.count", &count));
+  EXPECT_EQ(4, count);
+  EXPECT_TRUE(copy->GetInteger("pref.count", &count));
+  EXPECT_EQ(3, count);
+  EXPECT_FALSE(root.Equals(original.get()));
+
+  EXPECT_TRUE(root.Remove("name", NULL));
+  EXPECT_FALSE(root.is_frozen());
+  EXPECT_FALSE(root.HasKey("name"));
+  EXPECT_EQ(3U, root.size());
+
+  // Dictionaries can be frozen again, and swapped while frozen.
+  root.Freeze();
+  EXPECT_TRUE(root.is_frozen());
+  EXPECT_TRUE(pref->is_frozen());
+  DictionaryValue other;
+  other.SetString("other", "value");
+  other.Swap(&root);
+  EXPECT_TRUE(other.is_frozen());
+  EXPECT_FALSE(root.is_frozen());
+  EXPECT_TRUE(other.HasKey("pref"));
+  EXPECT_TRUE(root.HasKey("other"));
+
+  other.Clear();
+  EXPECT_FALSE(other.is_frozen());
+  EXPECT_TRUE(other.empty());
+
+  // Clearing a frozen dictionary deletes its values.
+  bool deletion_flag = false;
+  other.Set("deleted", new DeletionTestValue(&deletion_flag));
+  other.Freeze();
+  EXPECT_TRUE(other.is_frozen());
+  other.Clear();
+  EXPECT_TRUE(deletion_flag);
+  EXPECT_FALSE(other.is_frozen());
+}
+
 }  // namespace base
@@ -74,6 +74,7 @@
 #include "chrome/browser/search_engines/template_url_service.h"
 #include "chrome/browser/service/service_process_control.h"
 #include "chrome/browser/shell_integration.h"
+#include "chrome/browser/startup_prefetch.h"
 #include "chrome/browser/translate/translate_manager.h"
 #include "chrome/browser/ui/browser.h"
 #include "chrome/browser/ui/browser_init.h"
@@ -1167,6 +1168,12 @@ int ChromeBrowserMainParts::PreCreateThreadsImpl() {
       parsed_command_line().GetSwitchValueASCII(switches::kEnableProfiling);
     bool enabled = flag.compare("0") != 0;
     tracked_objects::ThreadData::InitializeAndSetTrackingStatus(enabled);
+    // A larger number profiles only about one in that many tasks.
+    int sampling_interval;
+    if (enabled && base::StringToInt(flag, &sampling_interval) &&
+        sampling_interval > 1) {
+      tracked_objects::ThreadData::SetSamplingInterval(sampling_interval);
+    }
   }
 
   // This forces the TabCloseableStateWatcher to be created and, on chromeos,
@@ -1357,6 +1364,8 @@ void ChromeBrowserMainParts::PreBrowserStart() {
 void ChromeBrowserMainParts::PostBrowserStart() {
   for (size_t i = 0; i < chrome_extra_parts_.size(); ++i)
     chrome_extra_parts_[i]->PostBrowserStart();
+
+  startup_prefetch::ScheduleFinish(user_data_dir_);
 }
 
 int ChromeBrowserMainParts::PreMainMessageLoopRunImpl() {
@@ -1419,6 +1428,8 @@ int ChromeBrowserMainParts::PreMainMessageLoopRunImpl() {
     return chrome::RESULT_CODE_PACK_EXTENSION_ERROR;
   }
 
+  // Whether this process got the ProcessSingleton.
+  bool owns_profile = false;
 #if !defined(OS_MACOSX)
   // In environments other than Mac OS X we support import of settings
   // from other browsers. In case this process is a short-lived "import"
@@ -1435,6 +1446,7 @@ int ChromeBrowserMainParts::PreMainMessageLoopRunImpl() {
     switch (notify_result_) {
       case ProcessSingleton::PROCESS_NONE:
         // No process already running, fall through to starting a new one.
+        owns_profile = true;
         break;
 
       case ProcessSingleton::PROCESS_NOTIFIED:
@@ -1462,6 +1474,14 @@ int ChromeBrowserMainParts::PreMainMessageLoopRunImpl() {
   }
 #endif
 
+  // Start bringing in what the last startup read before we read it.  Only
+  // the process that holds the profile does this, so that processes that
+  // exit right away or only import don't replace the list of reads.
+  if (owns_profile && !parameters().ui_task &&
+      !parsed_command_line().HasSwitch(switches::kDisableStartupPrefetch)) {
+    startup_prefetch::Start(user_data_dir_);
+  }
+
 #if defined(USE_X11)
   SetBrowserX11ErrorHandlers();
 #endif
@@ -1853,6 +1873,10 @@ void ChromeBrowserMainParts::PostMainMessageLoopRun() {
   for (size_t i = 0; i < chrome_extra_parts_.size(); ++i)
     chrome_extra_parts_[i]->PostMainMessageLoopRun();
 
+  // Save what startup read, if the browser is quitting before the recording
+  // window has closed.
+  startup_prefetch::Finish(user_data_dir_);
+
 #if defined(OS_WIN)
   // Log the search engine chosen on first run. Do this at shutdown, after any
   // changes are made from the first run bubble link, etc.
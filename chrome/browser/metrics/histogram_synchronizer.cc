@@ -8,6 +8,7 @@
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/threading/thread.h"
+#include "chrome/browser/metrics/renderer_histogram_arenas.h"
 #include "chrome/common/chrome_constants.h"
 #include "chrome/common/render_messages.h"
 #include "content/public/browser/browser_thread.h"
@@ -26,7 +27,8 @@ using content::BrowserThread;
 static const int kNeverUsableSequenceNumber = -2;
 
 HistogramSynchronizer::HistogramSynchronizer()
-  : lock_(),
+  : renderer_histogram_arenas_(new RendererHistogramArenas),
+    lock_(),
     received_all_renderer_histograms_(&lock_),
     callback_thread_(NULL),
     last_used_sequence_number_(kNeverUsableSequenceNumber),
@@ -133,6 +135,8 @@ int HistogramSynchronizer::NotifyAllRenderers(
   // need to be on the UI thread.
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
 
+  renderer_histogram_arenas_->MergeNewSamples();
+
   int notification_count = 0;
   for (content::RenderProcessHost::iterator it(
           content::RenderProcessHost::AllHostsIterator());
@@ -12,11 +12,13 @@
 #include "base/basictypes.h"
 #include "base/callback.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/time.h"
 
 class MessageLoop;
+class RendererHistogramArenas;
 
 // This class maintains state that is used to upload histogram data from the
 // various renderer processes, into the browser process.  Such transactions are
@@ -47,6 +49,10 @@ class MessageLoop;
 // specified by a browser request.  Since this sequence number can't match an
 // outstanding sequence number, the pickled data is accepted into the browser,
 // but there is no impact on the counters.
+//
+// Most renderer histograms don't go through IPC at all: they are recorded in
+// shared memory, and merged from there at the start of each update, and when
+// a renderer exits (see RendererHistogramArenas).
 
 class HistogramSynchronizer : public
     base::RefCountedThreadSafe<HistogramSynchronizer> {
@@ -125,7 +131,10 @@ class HistogramSynchronizer : public
                         int unresponsive_renderers,
                         const base::TimeTicks& started);
 
-  // This lock_ protects access to all members.
+  // Only used on the UI thread.
+  scoped_ptr<RendererHistogramArenas> renderer_histogram_arenas_;
+
+  // This lock_ protects access to all members below.
   base::Lock lock_;
 
   // This condition variable is used to block caller of the synchronous request
@@ -0,0 +1,94 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/metrics/renderer_histogram_arenas.h"
+
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/shared_histogram_arena.h"
+#include "base/shared_memory.h"
+#include "chrome/common/render_messages.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/notification_service.h"
+#include "content/public/browser/notification_source.h"
+#include "content/public/browser/notification_types.h"
+#include "content/public/browser/render_process_host.h"
+
+using content::BrowserThread;
+
+namespace {
+
+// Enough for the few hundred histograms a renderer typically has.  Pages are
+// only committed as records are allocated.
+const uint32 kArenaSize = 512 * 1024;
+
+}  // namespace
+
+RendererHistogramArenas::RendererHistogramArenas() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CREATED,
+                 content::NotificationService::AllBrowserContextsAndSources());
+  registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CLOSED,
+                 content::NotificationService::AllBrowserContextsAndSources());
+  registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_TERMINATED,
+                 content::NotificationService::AllBrowserContextsAndSources());
+}
+
+RendererHistogramArenas::~RendererHistogramArenas() {
+}
+
+void RendererHistogramArenas::MergeNewSamples() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  for (ArenaMap::iterator it = arenas_.begin(); it != arenas_.end(); ++it)
+    it->second->MergeNewSamples();
+}
+
+void RendererHistogramArenas::Observe(
+    int type,
+    const content::NotificationSource& source,
+    const content::NotificationDetails& details) {
+  content::RenderProcessHost* host =
+      content::Source<content::RenderProcessHost>(source).ptr();
+  switch (type) {
+    case content::NOTIFICATION_RENDERER_PROCESS_CREATED:
+      // A host that is reused after its renderer exited gets a new arena.
+      RemoveArena(host->GetID());
+      AddArena(host);
+      break;
+    case content::NOTIFICATION_RENDERER_PROCESS_CLOSED:
+    case content::NOTIFICATION_RENDERER_PROCESS_TERMINATED:
+      RemoveArena(host->GetID());
+      break;
+    default:
+      NOTREACHED();
+      break;
+  }
+}
+
+void RendererHistogramArenas::AddArena(content::RenderProcessHost* host) {
+  scoped_ptr<base::SharedMemory> shared_memory(new base::SharedMemory);
+  if (!shared_memory->CreateAndMapAnonymous(kArenaSize))
+    return;
+  base::SharedMemory* memory = shared_memory.get();
+  linked_ptr<base::SharedHistogramArena> arena(
+      base::SharedHistogramArena::Create(shared_memory.release(), kArenaSize));
+  if (!arena.get())
+    return;
+
+  base::SharedMemoryHandle handle_for_process;
+  memory->ShareToProcess(host->GetHandle(), &handle_for_process);
+  if (!base::SharedMemory::IsHandleValid(handle_for_process))
+    return;
+  arenas_[host->GetID()] = arena;
+  host->Send(new ChromeViewMsg_SetHistogramArena(handle_for_process,
+                                                 kArenaSize));
+}
+
+void RendererHistogramArenas::RemoveArena(int host_id) {
+  ArenaMap::iterator it = arenas_.find(host_id);
+  if (it == arenas_.end())
+    return;
+  it->second->MergeNewSamples();
+  arenas_.erase(it);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// RendererHistogramArenas gives each renderer process a
+// base::SharedHistogramArena to record its histograms in, and merges the
+// samples recorded there into the browser's histograms.  Renderers only send
+// the histograms that did not fit, or were created before the arena arrived,
+// through HistogramSynchronizer.
+
+#ifndef CHROME_BROWSER_METRICS_RENDERER_HISTOGRAM_ARENAS_H_
+#define CHROME_BROWSER_METRICS_RENDERER_HISTOGRAM_ARENAS_H_
+#pragma once
+
+#include <map>
+
+#include "base/basictypes.h"
+#include "base/memory/linked_ptr.h"
+#include "content/public/browser/notification_observer.h"
+#include "content/public/browser/notification_registrar.h"
+
+namespace base {
+class SharedHistogramArena;
+}
+
+namespace content {
+class RenderProcessHost;
+}
+
+class RendererHistogramArenas : public content::NotificationObserver {
+ public:
+  // Must be created on the UI thread, before renderers are started.
+  RendererHistogramArenas();
+  virtual ~RendererHistogramArenas();
+
+  // Merges the samples recorded by all renderers since the last call.  Must
+  // be called on the UI thread.
+  void MergeNewSamples();
+
+ private:
+  // Arenas of live renderers, by RenderProcessHost id.
+  typedef std::map<int, linked_ptr<base::SharedHistogramArena> > ArenaMap;
+
+  // content::NotificationObserver implementation.
+  virtual void Observe(int type,
+                       const content::NotificationSource& source,
+                       const content::NotificationDetails& details) OVERRIDE;
+
+  // Creates an arena for the renderer of |host| and sends it over.
+  void AddArena(content::RenderProcessHost* host);
+
+  // Merges the last samples of the renderer with |host_id|, whose process is
+  // gone, and drops its arena.
+  void RemoveArena(int host_id);
+
+  ArenaMap arenas_;
+  content::NotificationRegistrar registrar_;
+
+  DISALLOW_COPY_AND_ASSIGN(RendererHistogramArenas);
+};
+
+#endif  // CHROME_BROWSER_METRICS_RENDERER_HISTOGRAM_ARENAS_H_
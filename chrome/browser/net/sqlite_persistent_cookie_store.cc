@@ -55,7 +55,10 @@ using content::BrowserThread;
 // Subsequent to loading, mutations may be queued by any thread using
 // AddCookie, UpdateCookieAccessTime, and DeleteCookie. These are flushed to
 // disk on the DB thread every 30 seconds, 512 operations, or call to Flush(),
-// whichever occurs first.
+// whichever occurs first, in a single transaction. Operations on a cookie that
+// is still in the batch are folded into its pending operation, so a cookie
+// whose access time is updated many times is written once, and one that is
+// added and deleted again before the commit is never written at all.
 class SQLitePersistentCookieStore::Backend
     : public base::RefCountedThreadSafe<SQLitePersistentCookieStore::Backend> {
  public:
@@ -63,6 +66,7 @@ class SQLitePersistentCookieStore::Backend
       : path_(path),
         db_(NULL),
         num_pending_(0),
+        num_coalesced_(0),
         clear_local_state_on_exit_(false),
         initialized_(false),
         restore_old_session_cookies_(restore_old_session_cookies),
@@ -123,6 +127,9 @@ class SQLitePersistentCookieStore::Backend
     OperationType op() const { return op_; }
     const net::CookieMonster::CanonicalCookie& cc() const { return cc_; }
 
+    // Replaces the cookie this operation writes, keeping the operation.
+    void set_cc(const net::CookieMonster::CanonicalCookie& cc) { cc_ = cc; }
+
    private:
     OperationType op_;
     net::CookieMonster::CanonicalCookie cc_;
@@ -190,9 +197,17 @@ class SQLitePersistentCookieStore::Backend
   typedef std::list<PendingOperation*> PendingOperationsList;
   PendingOperationsList pending_;
   PendingOperationsList::size_type num_pending_;
+  // The last operation in |pending_| for each cookie, by creation time, which
+  // is the cookie's primary key in the DB.
+  std::map<int64, PendingOperationsList::iterator> pending_by_creation_;
+  // The number of operations folded into another since the last commit.
+  int num_coalesced_;
+  // When the first operation of the current batch was queued.
+  base::TimeTicks batch_start_;
   // True if the persistent store should be deleted upon destruction.
   bool clear_local_state_on_exit_;
-  // Guard |cookies_|, |pending_|, |num_pending_|, |clear_local_state_on_exit_|
+  // Guard |cookies_|, |pending_|, |num_pending_|, |pending_by_creation_|,
+  // |num_coalesced_|, |batch_start_|, |clear_local_state_on_exit_|
   base::Lock lock_;
 
   // Temporary buffer for cookies loaded from DB. Accumulates cookies to reduce
@@ -370,6 +385,7 @@ void SQLitePersistentCookieStore::Backend::LoadKeyAndNotifyOnDBThread(
       base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
       50);
 
+  const base::TimeTicks start = base::TimeTicks::Now();
   bool success = false;
   if (InitializeDatabase()) {
     std::map<std::string, std::set<std::string> >::iterator
@@ -382,6 +398,12 @@ void SQLitePersistentCookieStore::Backend::LoadKeyAndNotifyOnDBThread(
     }
   }
 
+  UMA_HISTOGRAM_CUSTOM_TIMES(
+      "Cookie.TimeKeyLoad",
+      base::TimeTicks::Now() - start,
+      base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
+      50);
+
   BrowserThread::PostTask(
     BrowserThread::IO, FROM_HERE,
     base::Bind(
@@ -750,14 +772,43 @@ void SQLitePersistentCookieStore::Backend::BatchOperation(
   static const size_t kCommitAfterBatchSize = 512;
   DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
 
-  // We do a full copy of the cookie here, and hopefully just here.
-  scoped_ptr<PendingOperation> po(new PendingOperation(op, cc));
-
+  const int64 creation = cc.CreationDate().ToInternalValue();
   PendingOperationsList::size_type num_pending;
   {
     base::AutoLock locked(lock_);
-    pending_.push_back(po.release());
+    std::map<int64, PendingOperationsList::iterator>::iterator last =
+        pending_by_creation_.find(creation);
+    if (last != pending_by_creation_.end() &&
+        op != PendingOperation::COOKIE_ADD &&
+        (*last->second)->op() != PendingOperation::COOKIE_DELETE) {
+      PendingOperation* pending = *last->second;
+      // Nothing queued after |pending| touches this cookie, so it can take
+      // on this operation where it stands.
+      ++num_coalesced_;
+      if (op == PendingOperation::COOKIE_UPDATEACCESS) {
+        // The pending add or update writes the new access time instead.
+        pending->set_cc(cc);
+      } else if (pending->op() == PendingOperation::COOKIE_ADD) {
+        // The row was never written, so there is nothing to delete.
+        delete pending;
+        pending_.erase(last->second);
+        pending_by_creation_.erase(last);
+        --num_pending_;
+        ++num_coalesced_;
+      } else {
+        // The update is moot once the row is deleted.
+        *last->second = new PendingOperation(op, cc);
+        delete pending;
+      }
+      return;
+    }
+
+    // We do a full copy of the cookie here, and hopefully just here.
+    pending_.push_back(new PendingOperation(op, cc));
+    pending_by_creation_[creation] = --pending_.end();
     num_pending = ++num_pending_;
+    if (num_pending == 1)
+      batch_start_ = base::TimeTicks::Now();
   }
 
   if (num_pending == 1) {
@@ -777,16 +828,33 @@ void SQLitePersistentCookieStore::Backend::Commit() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
 
   PendingOperationsList ops;
+  PendingOperationsList::size_type num_ops;
+  int num_coalesced;
+  base::TimeTicks batch_start;
   {
     base::AutoLock locked(lock_);
     pending_.swap(ops);
+    pending_by_creation_.clear();
+    num_ops = num_pending_;
     num_pending_ = 0;
+    num_coalesced = num_coalesced_;
+    num_coalesced_ = 0;
+    batch_start = batch_start_;
   }
 
   // Maybe an old timer fired or we are already Close()'ed.
   if (!db_.get() || ops.empty())
     return;
 
+  const base::TimeTicks start = base::TimeTicks::Now();
+  UMA_HISTOGRAM_CUSTOM_TIMES(
+      "Cookie.CommitQueueWait",
+      start - batch_start,
+      base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
+      50);
+  UMA_HISTOGRAM_COUNTS_10000("Cookie.CommitBatchSize", num_ops);
+  UMA_HISTOGRAM_COUNTS_10000("Cookie.CoalescedOperations", num_coalesced);
+
   sql::Statement add_smt(db_->GetCachedStatement(SQL_FROM_HERE,
       "INSERT INTO cookies (creation_utc, host_key, name, value, path, "
       "expires_utc, secure, httponly, last_access_utc, has_expires, "
@@ -863,6 +931,11 @@ void SQLitePersistentCookieStore::Backend::Commit() {
   bool succeeded = transaction.Commit();
   UMA_HISTOGRAM_ENUMERATION("Cookie.BackingStoreUpdateResults",
                             succeeded ? 0 : 1, 2);
+  UMA_HISTOGRAM_CUSTOM_TIMES(
+      "Cookie.TimeCommit",
+      base::TimeTicks::Now() - start,
+      base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
+      50);
 }
 
 void SQLitePersistentCookieStore::Backend::Flush(
@@ -269,6 +269,63 @@ TEST_F(SQLitePersistentCookieStoreTest, TestFlush) {
   ASSERT_GT(info.size, base_size);
 }
 
+// Test that operations on a cookie still waiting to be committed are folded
+// into the pending one, and that what is written is the final state.
+TEST_F(SQLitePersistentCookieStoreTest, TestCoalescePendingOperations) {
+  base::Time t = base::Time::Now() + base::TimeDelta::FromInternalValue(10);
+  const base::Time updated = t + base::TimeDelta::FromDays(1);
+  net::CookieMonster::CanonicalCookie updated_cookie(
+      GURL(), "updated", "B", "www.aaa.com", "/", std::string(),
+      std::string(), t, t, t, false, false, true, true);
+  store_->AddCookie(updated_cookie);
+  updated_cookie.SetLastAccessDate(updated);
+  store_->UpdateCookieAccessTime(updated_cookie);
+
+  t += base::TimeDelta::FromInternalValue(10);
+  net::CookieMonster::CanonicalCookie never_written(
+      GURL(), "never_written", "B", "www.aaa.com", "/", std::string(),
+      std::string(), t, t, t, false, false, true, true);
+  store_->AddCookie(never_written);
+  store_->DeleteCookie(never_written);
+
+  t += base::TimeDelta::FromInternalValue(10);
+  net::CookieMonster::CanonicalCookie deleted(
+      GURL(), "deleted", "B", "www.aaa.com", "/", std::string(),
+      std::string(), t, t, t, false, false, true, true);
+  store_->AddCookie(deleted);
+
+  // Commit, so that the next batch updates and deletes a row on disk.
+  store_->Flush(base::Closure());
+  scoped_refptr<base::ThreadTestHelper> helper(
+      new base::ThreadTestHelper(
+          BrowserThread::GetMessageLoopProxyForThread(BrowserThread::DB)));
+  ASSERT_TRUE(helper->Run());
+
+  deleted.SetLastAccessDate(updated);
+  store_->UpdateCookieAccessTime(deleted);
+  store_->DeleteCookie(deleted);
+  store_ = NULL;
+  // Make sure we wait until the destructor has run.
+  ASSERT_TRUE(helper->Run());
+
+  store_ = new SQLitePersistentCookieStore(
+      temp_dir_.path().Append(chrome::kCookieFilename), false);
+  std::vector<net::CookieMonster::CanonicalCookie*> cookies;
+  Load(&cookies);
+  std::map<std::string, net::CookieMonster::CanonicalCookie*> cookie_map;
+  for (std::vector<net::CookieMonster::CanonicalCookie*>::const_iterator
+       it = cookies.begin(); it != cookies.end(); ++it)
+    cookie_map[(*it)->Name()] = *it;
+  // The cookie added in SetUp() and |updated_cookie|.
+  ASSERT_EQ(2U, cookie_map.size());
+  ASSERT_TRUE(cookie_map.count("updated"));
+  EXPECT_EQ(updated.ToInternalValue(),
+            cookie_map["updated"]->LastAccessDate().ToInternalValue());
+  EXPECT_FALSE(cookie_map.count("never_written"));
+  EXPECT_FALSE(cookie_map.count("deleted"));
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+}
+
 // Counts the number of times Callback() has been run.
 class CallbackCounter : public base::RefCountedThreadSafe<CallbackCounter> {
  public:
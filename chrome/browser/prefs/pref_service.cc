@@ -250,8 +250,7 @@ PrefService::PrefService(PrefNotifierImpl* pref_notifier,
 
 PrefService::~PrefService() {
   DCHECK(CalledOnValidThread());
-  STLDeleteContainerPointers(prefs_.begin(), prefs_.end());
-  prefs_.clear();
+  STLDeleteValues(&prefs_);
 
   // Reset pointers so accesses after destruction reliably crash.
   pref_value_store_.reset();
@@ -663,15 +662,19 @@ DictionaryValue* PrefService::GetPreferenceValues() const {
 const PrefService::Preference* PrefService::FindPreference(
     const char* pref_name) const {
   DCHECK(CalledOnValidThread());
-  Preference p(this, pref_name, Value::TYPE_NULL);
-  PreferenceSet::const_iterator it = prefs_.find(&p);
-  if (it != prefs_.end())
-    return *it;
+  // A name that was never interned can't be in |prefs_|.  Only registered
+  // names get interned, below.
+  base::InternedString name;
+  if (base::InternedString::Find(pref_name, &name)) {
+    PreferenceMap::const_iterator it = prefs_.find(name);
+    if (it != prefs_.end())
+      return it->second;
+  }
   const base::Value::Type type = default_store_->GetType(pref_name);
   if (type == Value::TYPE_NULL)
     return NULL;
   Preference* new_pref = new Preference(this, pref_name, type);
-  prefs_.insert(new_pref);
+  prefs_[new_pref->name_] = new_pref;
   return new_pref;
 }
 
@@ -754,14 +757,16 @@ void PrefService::RegisterPreference(const char* path,
 void PrefService::UnregisterPreference(const char* path) {
   DCHECK(CalledOnValidThread());
 
-  Preference p(this, path, Value::TYPE_NULL);
-  PreferenceSet::iterator it = prefs_.find(&p);
+  base::InternedString name;
+  PreferenceMap::iterator it = prefs_.end();
+  if (base::InternedString::Find(path, &name))
+    it = prefs_.find(name);
   if (it == prefs_.end()) {
     NOTREACHED() << "Trying to unregister an unregistered pref: " << path;
     return;
   }
 
-  delete *it;
+  delete it->second;
   prefs_.erase(it);
   default_store_->RemoveDefaultValue(path);
   if (pref_sync_associator_.get() &&
@@ -916,7 +921,7 @@ const Value* PrefService::Preference::GetValue() const {
       "Must register pref before getting its value";
 
   const Value* found_value = NULL;
-  if (pref_value_store()->GetValue(name_, type_, &found_value)) {
+  if (pref_value_store()->GetValue(name_.as_string(), type_, &found_value)) {
     DCHECK(found_value->IsType(type_));
     return found_value;
   }
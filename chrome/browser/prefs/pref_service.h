@@ -11,6 +11,8 @@
 #include <set>
 #include <string>
 
+#include "base/hash_tables.h"
+#include "base/interned_string.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
@@ -64,7 +66,7 @@ class PrefService : public base::NonThreadSafe {
 
     // Returns the name of the Preference (i.e., the key, e.g.,
     // browser.window_placement).
-    const std::string name() const { return name_; }
+    const std::string& name() const { return name_.as_string(); }
 
     // Returns the registered type of the preference.
     base::Value::Type GetType() const;
@@ -120,7 +122,7 @@ class PrefService : public base::NonThreadSafe {
       return pref_service_->pref_value_store_.get();
     }
 
-    std::string name_;
+    base::InternedString name_;
 
     base::Value::Type type_;
 
@@ -317,13 +319,9 @@ class PrefService : public base::NonThreadSafe {
   scoped_ptr<PrefNotifierImpl> pref_notifier_;
 
  private:
-  class PreferencePathComparator {
-   public:
-    bool operator() (Preference* lhs, Preference* rhs) const {
-      return lhs->name() < rhs->name();
-    }
-  };
-  typedef std::set<Preference*, PreferencePathComparator> PreferenceSet;
+  // Preferences are looked up by interned name, so that the many lookups by
+  // path cost neither a string copy nor string comparisons.
+  typedef base::hash_map<base::InternedString, Preference*> PreferenceMap;
 
   friend class PrefServiceMockBuilder;
 
@@ -389,7 +387,7 @@ class PrefService : public base::NonThreadSafe {
   // Local cache of registered Preference objects. The default_store_
   // is authoritative with respect to what the types and default values
   // of registered preferences are.
-  mutable PreferenceSet prefs_;
+  mutable PreferenceMap prefs_;
 
   // The model associator that maintains the links with the sync db.
   scoped_ptr<PrefModelAssociator> pref_sync_associator_;
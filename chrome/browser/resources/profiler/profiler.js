@@ -130,9 +130,11 @@ var MainView = (function() {
   var KEY_RUN_TIME = END_KEY++;
   var KEY_AVG_RUN_TIME = END_KEY++;
   var KEY_MAX_RUN_TIME = END_KEY++;
+  var KEY_P90_RUN_TIME = END_KEY++;
   var KEY_QUEUE_TIME = END_KEY++;
   var KEY_AVG_QUEUE_TIME = END_KEY++;
   var KEY_MAX_QUEUE_TIME = END_KEY++;
+  var KEY_P90_QUEUE_TIME = END_KEY++;
   var KEY_BIRTH_THREAD = END_KEY++;
   var KEY_DEATH_THREAD = END_KEY++;
   var KEY_PROCESS_TYPE = END_KEY++;
@@ -414,6 +416,18 @@ var MainView = (function() {
     diff: diffFuncForMax,
   };
 
+  // The percentiles of merged rows can't be computed from those of the rows,
+  // so the largest is shown, as for the max.
+  KEY_PROPERTIES[KEY_P90_QUEUE_TIME] = {
+    name: '90th percentile queue time',
+    cellAlignment: 'right',
+    sortDescending: true,
+    textPrinter: formatNumberAsText,
+    inputJsonKey: 'death_data.queue_ms_p90',
+    aggregator: MaxAggregator,
+    diff: diffFuncForMax,
+  };
+
   KEY_PROPERTIES[KEY_RUN_TIME] = {
     name: 'Total run time',
     cellAlignment: 'right',
@@ -442,6 +456,16 @@ var MainView = (function() {
     diff: diffFuncForMax,
   };
 
+  KEY_PROPERTIES[KEY_P90_RUN_TIME] = {
+    name: '90th percentile run time',
+    cellAlignment: 'right',
+    sortDescending: true,
+    textPrinter: formatNumberAsText,
+    inputJsonKey: 'death_data.run_ms_p90',
+    aggregator: MaxAggregator,
+    diff: diffFuncForMax,
+  };
+
   KEY_PROPERTIES[KEY_AVG_QUEUE_TIME] = {
     name: 'Avg queue time',
     cellAlignment: 'right',
@@ -486,6 +510,7 @@ var MainView = (function() {
     KEY_FILE_NAME,
     KEY_LINE_NUMBER,
     KEY_QUEUE_TIME,
+    KEY_P90_QUEUE_TIME,
   ];
 
   /**
@@ -118,6 +118,56 @@ bool WriteContainer(const CT& values, FILE* fp,
   return true;
 }
 
+// Reads items in order out of a mapped file, without copying each one
+// through stdio like ReadItem() does.
+class MappedFileReader {
+ public:
+  explicit MappedFileReader(const file_util::MemoryMappedFile& map)
+      : next_(map.data()),
+        remaining_(map.length()) {
+  }
+
+  // Like ReadItem(), but from the mapping.
+  template <class T>
+  bool ReadItem(T* item, base::MD5Context* context) {
+    if (sizeof(T) > remaining_)
+      return false;
+    memcpy(item, next_, sizeof(T));
+    Consume(sizeof(T), context);
+    return true;
+  }
+
+  // Like ReadToContainer(), but checksums the items with one call.
+  template <typename CT>
+  bool ReadToContainer(CT* values, size_t count, base::MD5Context* context) {
+    typedef typename CT::value_type ValueType;
+    if (count > remaining_ / sizeof(ValueType))
+      return false;
+    const ValueType* items = reinterpret_cast<const ValueType*>(next_);
+    // Coded this way, like ReadToContainer(), so std::set can be read too.
+    for (size_t i = 0; i < count; ++i)
+      values->insert(values->end(), items[i]);
+    Consume(count * sizeof(ValueType), context);
+    return true;
+  }
+
+ private:
+  void Consume(size_t bytes, base::MD5Context* context) {
+    if (context) {
+      base::MD5Update(context,
+                      base::StringPiece(reinterpret_cast<const char*>(next_),
+                                        bytes));
+    }
+    next_ += bytes;
+    remaining_ -= bytes;
+  }
+
+  const uint8* next_;
+  size_t remaining_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFileReader);
+};
+
 // Delete the chunks in |deleted| from |chunks|.
 void DeleteChunksFromSet(const base::hash_set<int32>& deleted,
                          std::set<int32>* chunks) {
@@ -464,34 +514,41 @@ bool SafeBrowsingStoreFile::DoUpdate(
   if (!empty_) {
     DCHECK(file_.get());
 
-    if (!FileRewind(file_.get()))
+    // The whole file is read once, front to back, so map it for sequential
+    // access rather than reading it item by item through stdio.
+    file_util::MemoryMappedFile map;
+    if (!map.Initialize(filename_))
       return OnCorruptDatabase();
+    map.SetAccessPattern(file_util::MemoryMappedFile::ACCESS_SEQUENTIAL);
+    MappedFileReader reader(map);
 
     base::MD5Context context;
     base::MD5Init(&context);
 
     // Read the file header and make sure it looks right.
     FileHeader header;
-    if (!ReadAndVerifyHeader(filename_, file_.get(), &header, &context))
+    if (!reader.ReadItem(&header, &context) ||
+        header.magic != kFileMagic || header.version != kFileVersion ||
+        !FileHeaderSanityCheck(filename_, header))
       return OnCorruptDatabase();
 
     // Re-read the chunks-seen data to get to the later data in the
     // file and calculate the checksum.  No new elements should be
     // added to the sets.
-    if (!ReadToContainer(&add_chunks_cache_, header.add_chunk_count,
-                         file_.get(), &context) ||
-        !ReadToContainer(&sub_chunks_cache_, header.sub_chunk_count,
-                         file_.get(), &context))
+    if (!reader.ReadToContainer(&add_chunks_cache_, header.add_chunk_count,
+                                &context) ||
+        !reader.ReadToContainer(&sub_chunks_cache_, header.sub_chunk_count,
+                                &context))
       return OnCorruptDatabase();
 
-    if (!ReadToContainer(&add_prefixes, header.add_prefix_count,
-                         file_.get(), &context) ||
-        !ReadToContainer(&sub_prefixes, header.sub_prefix_count,
-                         file_.get(), &context) ||
-        !ReadToContainer(&add_full_hashes, header.add_hash_count,
-                         file_.get(), &context) ||
-        !ReadToContainer(&sub_full_hashes, header.sub_hash_count,
-                         file_.get(), &context))
+    if (!reader.ReadToContainer(&add_prefixes, header.add_prefix_count,
+                                &context) ||
+        !reader.ReadToContainer(&sub_prefixes, header.sub_prefix_count,
+                                &context) ||
+        !reader.ReadToContainer(&add_full_hashes, header.add_hash_count,
+                                &context) ||
+        !reader.ReadToContainer(&sub_full_hashes, header.sub_hash_count,
+                                &context))
       return OnCorruptDatabase();
 
     // Calculate the digest to this point.
@@ -500,7 +557,7 @@ bool SafeBrowsingStoreFile::DoUpdate(
 
     // Read the stored checksum and verify it.
     base::MD5Digest file_digest;
-    if (!ReadItem(&file_digest, file_.get(), NULL))
+    if (!reader.ReadItem(&file_digest, NULL))
       return OnCorruptDatabase();
 
     if (0 != memcmp(&file_digest, &calculated_digest, sizeof(file_digest)))
@@ -0,0 +1,155 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/startup_prefetch.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/message_loop.h"
+#include "base/metrics/histogram.h"
+#include "base/pickle.h"
+#include "base/threading/worker_pool.h"
+#include "base/time.h"
+#include "chrome/common/chrome_constants.h"
+#include "content/public/browser/browser_thread.h"
+
+using base::FileReadRecorder;
+using base::TimeDelta;
+using base::TimeTicks;
+using content::BrowserThread;
+
+namespace startup_prefetch {
+
+namespace {
+
+// Bump when the list format changes; lists of other versions are ignored.
+const int kListVersion = 1;
+
+// How long after the browser has started to keep recording.  Long enough to
+// cover restoring the last session and loading the first pages.
+const int kRecordingSeconds = 20;
+
+// Bounds what one run prefetches, in case the list names huge files.
+const int64 kMaxPrefetchBytes = 128 * 1024 * 1024;
+
+FilePath GetListPath(const FilePath& user_data_dir) {
+  return user_data_dir.Append(chrome::kStartupReadsFilename);
+}
+
+void PrefetchList(const FilePath& list_path) {
+  FileReadRecorder::Extents extents;
+  if (!ReadList(list_path, &extents))
+    return;
+
+  TimeTicks start = TimeTicks::Now();
+  int64 prefetched = 0;
+  for (size_t i = 0; i < extents.size(); ++i) {
+    const FileReadRecorder::Extent& extent = extents[i];
+    // An extent that doesn't fit is cut to what is left, so that one huge
+    // extent doesn't cost the smaller ones after it.
+    int64 length = std::min(extent.length, kMaxPrefetchBytes - prefetched);
+    if (length <= 0)
+      break;
+    if (file_util::PrefetchFileRange(extent.path, extent.offset, length))
+      prefetched += length;
+  }
+  UMA_HISTOGRAM_MEDIUM_TIMES("StartupPrefetch.Time", TimeTicks::Now() - start);
+  UMA_HISTOGRAM_MEMORY_KB("StartupPrefetch.PrefetchedKB",
+                          static_cast<int>(prefetched / 1024));
+}
+
+void SaveList(const FilePath& list_path,
+              const FileReadRecorder::Extents& extents) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  UMA_HISTOGRAM_COUNTS_10000("StartupPrefetch.RecordedExtents",
+                             extents.size());
+  if (!WriteList(list_path, extents))
+    file_util::Delete(list_path, false);
+}
+
+}  // namespace
+
+void Start(const FilePath& user_data_dir) {
+  base::WorkerPool::PostTask(
+      FROM_HERE, base::Bind(&PrefetchList, GetListPath(user_data_dir)), true);
+  FileReadRecorder::Start();
+}
+
+void ScheduleFinish(const FilePath& user_data_dir) {
+  if (!FileReadRecorder::IsRecording())
+    return;
+  MessageLoop::current()->PostDelayedTask(
+      FROM_HERE, base::Bind(&Finish, user_data_dir),
+      TimeDelta::FromSeconds(kRecordingSeconds));
+}
+
+void Finish(const FilePath& user_data_dir) {
+  if (!FileReadRecorder::IsRecording())
+    return;
+  FileReadRecorder::Extents extents;
+  FileReadRecorder::Stop(&extents);
+  BrowserThread::PostTask(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&SaveList, GetListPath(user_data_dir), extents));
+}
+
+bool WriteList(const FilePath& path,
+               const FileReadRecorder::Extents& extents) {
+  Pickle pickle;
+  pickle.WriteInt(kListVersion);
+  int count = 0;
+  for (size_t i = 0; i < extents.size(); ++i) {
+    if (extents[i].path != path)
+      ++count;
+  }
+  pickle.WriteInt(count);
+  for (size_t i = 0; i < extents.size(); ++i) {
+    if (extents[i].path == path)
+      continue;
+    FilePath extent_path(extents[i].path);
+    extent_path.WriteToPickle(&pickle);
+    pickle.WriteInt64(extents[i].offset);
+    pickle.WriteInt64(extents[i].length);
+  }
+  const char* data = static_cast<const char*>(pickle.data());
+  return file_util::WriteFile(path, data, pickle.size()) ==
+      static_cast<int>(pickle.size());
+}
+
+bool ReadList(const FilePath& path, FileReadRecorder::Extents* extents) {
+  std::string data;
+  if (!file_util::ReadFileToString(path, &data))
+    return false;
+
+  Pickle pickle(data.data(), data.size());
+  void* iter = NULL;
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) || version != kListVersion ||
+      !pickle.ReadInt(&iter, &count) || count < 0 ||
+      count > static_cast<int>(FileReadRecorder::kMaxExtents)) {
+    return false;
+  }
+
+  extents->clear();
+  extents->reserve(count);
+  for (int i = 0; i < count; ++i) {
+    FileReadRecorder::Extent extent;
+    if (!extent.path.ReadFromPickle(&pickle, &iter) ||
+        !pickle.ReadInt64(&iter, &extent.offset) ||
+        !pickle.ReadInt64(&iter, &extent.length) ||
+        extent.offset < 0 || extent.length <= 0) {
+      extents->clear();
+      return false;
+    }
+    extents->push_back(extent);
+  }
+  return true;
+}
+
+}  // namespace startup_prefetch
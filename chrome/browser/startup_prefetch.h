@@ -0,0 +1,45 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_STARTUP_PREFETCH_H_
+#define CHROME_BROWSER_STARTUP_PREFETCH_H_
+#pragma once
+
+#include "base/file_read_recorder.h"
+
+class FilePath;
+
+// Startup reads many small parts of many files: resource packs, preferences,
+// and the profile's databases.  On a cold disk each costs a seek.  Each run
+// records what it reads during startup, and the next run reads the same
+// parts, in the same order, on a worker thread as soon as it starts, so that
+// the startup path finds them in the system cache.
+namespace startup_prefetch {
+
+// Prefetches the list saved in |user_data_dir| by the last run, and starts
+// recording this run's.  Call on the UI thread as early as possible once the
+// process holds the profile's ProcessSingleton.
+void Start(const FilePath& user_data_dir);
+
+// Stops recording once startup is surely over.  Call once the browser has
+// started.
+void ScheduleFinish(const FilePath& user_data_dir);
+
+// Stops recording, if still recording, and saves the list on the file
+// thread.  Called at the end of the recording window, or at shutdown if that
+// comes first.
+void Finish(const FilePath& user_data_dir);
+
+// Writes |extents| to |path|, leaving out |path| itself.  Exposed for
+// testing.
+bool WriteList(const FilePath& path,
+               const base::FileReadRecorder::Extents& extents);
+
+// Reads a list written by WriteList().  Returns false if |path| is missing or
+// malformed.  Exposed for testing.
+bool ReadList(const FilePath& path, base::FileReadRecorder::Extents* extents);
+
+}  // namespace startup_prefetch
+
+#endif  // CHROME_BROWSER_STARTUP_PREFETCH_H_
@@ -0,0 +1,73 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/startup_prefetch.h"
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using base::FileReadRecorder;
+
+TEST(StartupPrefetchTest, RoundTrip) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath list_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("Startup Reads"));
+  const FilePath a = temp_dir.path().Append(FILE_PATH_LITERAL("a"));
+  const FilePath b = temp_dir.path().Append(FILE_PATH_LITERAL("b"));
+
+  FileReadRecorder::Extents extents;
+  extents.push_back(FileReadRecorder::Extent(a, 0, 4096));
+  extents.push_back(FileReadRecorder::Extent(list_path, 0, 100));
+  extents.push_back(FileReadRecorder::Extent(b, 1 << 20, 512));
+  extents.push_back(FileReadRecorder::Extent(a, kint64max - 1, 1));
+  ASSERT_TRUE(startup_prefetch::WriteList(list_path, extents));
+
+  // The list itself is left out.
+  FileReadRecorder::Extents read;
+  ASSERT_TRUE(startup_prefetch::ReadList(list_path, &read));
+  ASSERT_EQ(3u, read.size());
+  EXPECT_EQ(a.value(), read[0].path.value());
+  EXPECT_EQ(0, read[0].offset);
+  EXPECT_EQ(4096, read[0].length);
+  EXPECT_EQ(b.value(), read[1].path.value());
+  EXPECT_EQ(1 << 20, read[1].offset);
+  EXPECT_EQ(512, read[1].length);
+  EXPECT_EQ(a.value(), read[2].path.value());
+  EXPECT_EQ(kint64max - 1, read[2].offset);
+}
+
+TEST(StartupPrefetchTest, Malformed) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath list_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("Startup Reads"));
+
+  FileReadRecorder::Extents read;
+  EXPECT_FALSE(startup_prefetch::ReadList(list_path, &read));
+
+  const std::string garbage("not a list");
+  ASSERT_EQ(static_cast<int>(garbage.size()),
+            file_util::WriteFile(list_path, garbage.data(), garbage.size()));
+  EXPECT_FALSE(startup_prefetch::ReadList(list_path, &read));
+
+  // A truncated list is rejected as a whole.
+  FileReadRecorder::Extents extents;
+  for (int i = 0; i < 10; ++i) {
+    extents.push_back(FileReadRecorder::Extent(
+        temp_dir.path().Append(FILE_PATH_LITERAL("file")), i * 8192, 4096));
+  }
+  ASSERT_TRUE(startup_prefetch::WriteList(list_path, extents));
+  std::string data;
+  ASSERT_TRUE(file_util::ReadFileToString(list_path, &data));
+  data.resize(data.size() - 10);
+  ASSERT_EQ(static_cast<int>(data.size()),
+            file_util::WriteFile(list_path, data.data(), data.size()));
+  EXPECT_FALSE(startup_prefetch::ReadList(list_path, &read));
+  EXPECT_TRUE(read.empty());
+}
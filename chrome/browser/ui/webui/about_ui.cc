@@ -15,6 +15,7 @@
 #include "base/file_util.h"
 #include "base/i18n/number_formatting.h"
 #include "base/json/json_writer.h"
+#include "base/memory/fixed_size_pool.h"
 #include "base/memory/singleton.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/stats_table.h"
@@ -704,8 +705,10 @@ std::string AboutTcmalloc() {
   // and send off requests to all the renderer processes.
   char buffer[1024 * 32];
   MallocExtension::instance()->GetStats(buffer, sizeof(buffer));
+  std::string browser_output(buffer);
+  base::FixedSizePool::GetStats(&browser_output);
   std::string browser("Browser");
-  AboutTcmallocOutputs::GetInstance()->SetOutput(browser, buffer);
+  AboutTcmallocOutputs::GetInstance()->SetOutput(browser, browser_output);
   content::RenderProcessHost::iterator
       it(content::RenderProcessHost::AllHostsIterator());
   while (!it.IsAtEnd()) {
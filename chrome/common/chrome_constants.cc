@@ -143,6 +143,7 @@ const FilePath::CharType kSafeBrowsingBaseFilename[] = FPL("Safe Browsing");
 const FilePath::CharType kSingletonCookieFilename[] = FPL("SingletonCookie");
 const FilePath::CharType kSingletonSocketFilename[] = FPL("SingletonSocket");
 const FilePath::CharType kSingletonLockFilename[] = FPL("SingletonLock");
+const FilePath::CharType kStartupReadsFilename[] = FPL("Startup Reads");
 const FilePath::CharType kThumbnailsFilename[] = FPL("Thumbnails");
 const FilePath::CharType kNewTabThumbnailsFilename[] = FPL("Top Thumbnails");
 const FilePath::CharType kTopSitesFilename[] = FPL("Top Sites");
@@ -354,6 +354,10 @@ const char kDisableSiteSpecificQuirks[]     = "disable-site-specific-quirks";
 // Disables SSL v3 (usually for testing purposes).
 const char kDisableSSL3[]                   = "disable-ssl3";
 
+// Disables prefetching the files the last run read during startup, and
+// recording this run's.
+const char kDisableStartupPrefetch[]        = "disable-startup-prefetch";
+
 // Disables syncing browser data to a Google Account.
 const char kDisableSync[]                   = "disable-sync";
 
@@ -574,6 +578,8 @@ const char kEnablePreconnect[]              = "enable-preconnect";
 // --enable-profiling=0
 // Some tracking will still take place at startup, but it will be turned off
 // during chrome_browser_main.
+// To track only about one in N tasks, which is cheap enough to leave on, use:
+// --enable-profiling=N
 const char kEnableProfiling[]               = "enable-profiling";
 
 // Experimental. Enables restoring session state (cookies, session storage,
@@ -103,6 +103,7 @@ extern const char kDisableRestoreBackgroundContents[];
 extern const char kDisableShortcutsProvider[];
 extern const char kDisableSiteSpecificQuirks[];
 extern const char kDisableSSL3[];
+extern const char kDisableStartupPrefetch[];
 extern const char kDisableSync[];
 extern const char kDisableSyncApps[];
 extern const char kDisableSyncAppNotifications[];
@@ -216,6 +216,7 @@ bool ExtensionUnpacker::Run() {
 bool ExtensionUnpacker::DumpImagesToFile() {
   IPC::Message pickle;  // We use a Message so we can use WriteParam.
   IPC::WriteParam(&pickle, decoded_images_);
+  pickle.Flatten();
 
   FilePath path = extension_path_.DirName().AppendASCII(
       filenames::kDecodedImagesFilename);
@@ -231,6 +232,7 @@ bool ExtensionUnpacker::DumpImagesToFile() {
 bool ExtensionUnpacker::DumpMessageCatalogsToFile() {
   IPC::Message pickle;
   IPC::WriteParam(&pickle, *parsed_catalogs_.get());
+  pickle.Flatten();
 
   FilePath path = extension_path_.DirName().AppendASCII(
       filenames::kDecodedMessageCatalogsFilename);
@@ -115,7 +115,10 @@ std::set<std::string> Manifest::GetAllKnownKeys() {
   return keys;
 }
 
-Manifest::Manifest(DictionaryValue* value) : value_(value) {}
+Manifest::Manifest(DictionaryValue* value) : value_(value) {
+  // Manifests are rarely modified once loaded.
+  value_->Freeze();
+}
 Manifest::~Manifest() {}
 
 bool Manifest::ValidateManifest(string16* error) const {
@@ -238,6 +238,9 @@ void JsonPrefStore::OnFileRead(Value* value_owned,
     case PREF_READ_ERROR_NONE:
       DCHECK(value.get());
       prefs_.reset(static_cast<DictionaryValue*>(value.release()));
+      // Most preferences are only ever read; the dictionaries that are
+      // written to are unfrozen as needed.
+      prefs_->Freeze();
       break;
     case PREF_READ_ERROR_NO_FILE:
       // If the file just doesn't exist, maybe this is first run.  In any case
@@ -22,6 +22,9 @@ void HistogramSender::TransmitAllHistograms(Histogram::Flags flag_to_set,
     if (send_only_uma &&
         0 == ((*it)->flags() & Histogram::kUmaTargetedHistogramFlag))
       continue;
+    // Whoever reads the shared memory collects these.
+    if ((*it)->has_shared_samples())
+      continue;
     TransmitHistogram(**it);
   }
 }
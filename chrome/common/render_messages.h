@@ -240,6 +240,13 @@ IPC_MESSAGE_CONTROL0(ChromeViewMsg_GetCacheResourceStats)
 IPC_MESSAGE_CONTROL1(ChromeViewMsg_GetRendererHistograms,
                      int /* sequence number of Renderer Histograms. */)
 
+// Gives the renderer a base::SharedHistogramArena, in which its histograms
+// record their samples from then on.  The browser reads them from there, so
+// they are not sent back with ChromeViewHostMsg_RendererHistograms.
+IPC_MESSAGE_CONTROL2(ChromeViewMsg_SetHistogramArena,
+                     base::SharedMemoryHandle /* arena */,
+                     uint32 /* size of the arena, in bytes */)
+
 // Tells the renderer to create a FieldTrial, and by using a 100% probability
 // for the FieldTrial, forces the FieldTrial to have assigned group name.
 IPC_MESSAGE_CONTROL2(ChromeViewMsg_SetFieldTrialGroup,
@@ -8,8 +8,10 @@
 
 #include "base/bind.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/message_loop.h"
 #include "base/metrics/histogram.h"
+#include "base/metrics/shared_histogram_arena.h"
 #include "chrome/common/render_messages.h"
 #include "content/public/renderer/render_thread.h"
 
@@ -39,6 +41,7 @@ bool RendererHistogramSnapshots::OnControlMessageReceived(
   IPC_BEGIN_MESSAGE_MAP(RendererHistogramSnapshots, message)
     IPC_MESSAGE_HANDLER(ChromeViewMsg_GetRendererHistograms,
                         OnGetRendererHistograms)
+    IPC_MESSAGE_HANDLER(ChromeViewMsg_SetHistogramArena, OnSetHistogramArena)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -48,6 +51,20 @@ void RendererHistogramSnapshots::OnGetRendererHistograms(int sequence_number) {
   SendHistograms(sequence_number);
 }
 
+void RendererHistogramSnapshots::OnSetHistogramArena(
+    base::SharedMemoryHandle handle,
+    uint32 size) {
+  scoped_ptr<base::SharedMemory> shared_memory(
+      new base::SharedMemory(handle, false));
+  if (base::SharedHistogramArena::current() || !shared_memory->Map(size))
+    return;
+  // Histograms keep pointers into the arena, so it is never deleted.
+  base::SharedHistogramArena* arena =
+      base::SharedHistogramArena::Attach(shared_memory.release(), size);
+  if (arena)
+    base::SharedHistogramArena::set_current(arena);
+}
+
 void RendererHistogramSnapshots::UploadAllHistrograms(int sequence_number) {
   DCHECK_EQ(0u, pickled_histograms_.size());
 
@@ -14,6 +14,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/metrics/histogram.h"
 #include "base/process.h"
+#include "base/shared_memory.h"
 #include "chrome/common/metrics/histogram_sender.h"
 #include "content/public/renderer/render_process_observer.h"
 
@@ -31,6 +32,7 @@ class RendererHistogramSnapshots : public HistogramSender,
   virtual bool OnControlMessageReceived(const IPC::Message& message) OVERRIDE;
 
   void OnGetRendererHistograms(int sequence_number);
+  void OnSetHistogramArena(base::SharedMemoryHandle handle, uint32 size);
 
   // Maintain a map of histogram names to the sample stats we've sent.
   typedef std::map<std::string, base::Histogram::SampleSet> LoggedSampleMap;
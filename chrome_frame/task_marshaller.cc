@@ -45,7 +45,7 @@ void TaskMarshallerThroughMessageQueue::PostDelayedTask(
   base::PendingTask delayed_task(source, task, base::TimeTicks::Now() + delay,
                                  true);
   base::TimeTicks top_run_time = delayed_tasks_.top().delayed_run_time;
-  delayed_tasks_.push(delayed_task);
+  delayed_tasks_.PushByMove(&delayed_task);
 
   // Reschedule the timer if |delayed_task| will be the next delayed task to
   // run.
@@ -104,9 +104,8 @@ void TaskMarshallerThroughMessageQueue::ExecuteDelayedTasks() {
       return;
     }
 
-    base::PendingTask next_task = delayed_tasks_.top();
     base::TimeTicks now = base::TimeTicks::Now();
-    base::TimeTicks next_run = next_task.delayed_run_time;
+    base::TimeTicks next_run = delayed_tasks_.top().delayed_run_time;
     if (next_run > now) {
       int64 delay = (next_run - now).InMillisecondsRoundedUp();
       ::SetTimer(wnd_, reinterpret_cast<UINT_PTR>(this),
@@ -115,6 +114,7 @@ void TaskMarshallerThroughMessageQueue::ExecuteDelayedTasks() {
       return;
     }
 
+    base::PendingTask next_task(&delayed_tasks_.top());
     delayed_tasks_.pop();
     lock_.Release();
 
@@ -10,11 +10,8 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
-#include <sys/un.h>
-
-#if defined(OS_OPENBSD)
 #include <sys/uio.h>
-#endif
+#include <sys/un.h>
 
 #include <string>
 #include <map>
@@ -291,6 +288,9 @@ bool SocketWriteErrorIsRecoverable() {
 #endif  // OS_MACOSX
 }
 
+// The most segments of a message that are written with one sendmsg().
+const size_t kMaxIOVecs = 64;
+
 }  // namespace
 //------------------------------------------------------------------------------
 
@@ -741,7 +741,13 @@ bool Channel::ChannelImpl::ProcessIncomingMessages() {
       fds = vector_as_array(&input_overflow_fds_);
       num_fds = input_overflow_fds_.size();
     }
-    input_overflow_buf_.assign(p, end - p);
+    // Keep whatever is left for the next read.  If nothing was consumed, it
+    // is all in the overflow buffer already, and copying it there again would
+    // make reading a large message quadratic in its size.  The buffer grows
+    // as the rest of the message arrives, rather than trusting the size in
+    // its header, which comes from the peer.
+    if (p != input_overflow_buf_.data())
+      input_overflow_buf_.assign(p, end - p);
     input_overflow_fds_ = std::vector<int>(&fds[fds_i], &fds[num_fds]);
 
     // When the input data buffer is empty, the overflow fds should be too. If
@@ -770,15 +776,26 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
   while (!output_queue_.empty()) {
     Message* msg = output_queue_.front();
 
-    size_t amt_to_write = msg->size() - message_send_bytes_written_;
+    // Large messages are made of several segments, which are gathered by
+    // sendmsg() rather than copied together.
+    struct iovec iov[kMaxIOVecs];
+    size_t iov_count = 0;
+    size_t amt_to_write = 0;
+    size_t offset = message_send_bytes_written_;
+    while (offset < msg->size() && iov_count < kMaxIOVecs) {
+      size_t length;
+      const char* segment = msg->GetDataSegment(offset, &length);
+      iov[iov_count].iov_base = const_cast<char*>(segment);
+      iov[iov_count].iov_len = length;
+      ++iov_count;
+      offset += length;
+      amt_to_write += length;
+    }
     DCHECK_NE(0U, amt_to_write);
-    const char* out_bytes = reinterpret_cast<const char*>(msg->data()) +
-        message_send_bytes_written_;
 
     struct msghdr msgh = {0};
-    struct iovec iov = {const_cast<char*>(out_bytes), amt_to_write};
-    msgh.msg_iov = &iov;
-    msgh.msg_iovlen = 1;
+    msgh.msg_iov = iov;
+    msgh.msg_iovlen = iov_count;
     char buf[CMSG_SPACE(
         sizeof(int) * FileDescriptorSet::kMaxDescriptorsPerMessage)];
 
@@ -825,7 +842,7 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
         msgh.msg_iov = &fd_pipe_iov;
         fd_written = fd_pipe_;
         bytes_written = HANDLE_EINTR(sendmsg(fd_pipe_, &msgh, MSG_DONTWAIT));
-        msgh.msg_iov = &iov;
+        msgh.msg_iov = iov;
         msgh.msg_controllen = 0;
         if (bytes_written > 0) {
           msg->file_descriptor_set()->CommitAll();
@@ -841,7 +858,7 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
         DCHECK_EQ(msg->file_descriptor_set()->size(), 1U);
       }
       if (!msgh.msg_controllen) {
-        bytes_written = HANDLE_EINTR(write(pipe_, out_bytes, amt_to_write));
+        bytes_written = HANDLE_EINTR(writev(pipe_, iov, iov_count));
       } else
 #endif  // IPC_USES_READWRITE
       {
@@ -885,6 +902,9 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
           &write_watcher_,
           this);
       return true;
+    } else if (offset < msg->size()) {
+      // The rest of the message's segments did not fit in |iov|.
+      message_send_bytes_written_ = offset;
     } else {
       message_send_bytes_written_ = 0;
 
@@ -11,6 +11,8 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <string>
+
 #include "base/basictypes.h"
 #include "base/eintr_wrapper.h"
 #include "base/file_path.h"
@@ -90,6 +92,43 @@ class IPCChannelPosixTestListener : public IPC::Channel::Listener {
   bool quit_only_on_message_;
 };
 
+// Checks the contents of messages written by WriteLargeMessage() and quits
+// the run loop once |expected| of them have arrived.
+class LargeMessageListener : public IPC::Channel::Listener {
+ public:
+  explicit LargeMessageListener(int expected)
+      : expected_(expected), received_(0) {}
+
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
+    void* iter = NULL;
+    int count;
+    EXPECT_TRUE(message.ReadInt(&iter, &count));
+    for (int i = 0; i < count; ++i) {
+      std::string value;
+      EXPECT_TRUE(message.ReadString(&iter, &value));
+      EXPECT_EQ(std::string(i % 5000, 'a' + i % 26), value);
+    }
+    if (++received_ == expected_)
+      MessageLoopForIO::current()->QuitNow();
+    return true;
+  }
+
+  int received() const { return received_; }
+
+ private:
+  int expected_;
+  int received_;
+};
+
+IPC::Message* WriteLargeMessage(int count) {
+  IPC::Message* message =
+      new IPC::Message(0, kQuitMessage, IPC::Message::PRIORITY_NORMAL);
+  message->WriteInt(count);
+  for (int i = 0; i < count; ++i)
+    message->WriteString(std::string(i % 5000, 'a' + i % 26));
+  return message;
+}
+
 }  // namespace
 
 class IPCChannelPosixTest : public base::MultiProcessTest {
@@ -380,6 +419,25 @@ TEST_F(IPCChannelPosixTest, IsNamedServerInitialized) {
       kConnectionSocketTestName));
 }
 
+// Messages that are written in many segments, some of them more than fit in
+// one sendmsg(), arrive intact.
+TEST_F(IPCChannelPosixTest, LargeMessages) {
+  IPCChannelPosixTestListener server_listener(true);
+  LargeMessageListener client_listener(3);
+  IPC::Channel server("IPCChannelPosixTest_LargeMessages",
+                      IPC::Channel::MODE_SERVER, &server_listener);
+  IPC::Channel client("IPCChannelPosixTest_LargeMessages",
+                      IPC::Channel::MODE_CLIENT, &client_listener);
+  ASSERT_TRUE(server.Connect());
+  ASSERT_TRUE(client.Connect());
+
+  ASSERT_TRUE(server.Send(WriteLargeMessage(10)));
+  ASSERT_TRUE(server.Send(WriteLargeMessage(100)));
+  ASSERT_TRUE(server.Send(WriteLargeMessage(3000)));
+  SpinRunLoop(TestTimeouts::action_max_timeout_ms());
+  EXPECT_EQ(3, client_listener.received());
+}
+
 // A long running process that connects to us
 MULTIPROCESS_TEST_MAIN(IPCChannelPosixTestConnectionProc) {
   MessageLoopForIO message_loop;
@@ -11,6 +11,16 @@
 #include "ipc/file_descriptor_set_posix.h"
 #endif
 
+namespace {
+
+#if defined(OS_POSIX)
+// Large messages grow in segments of this size, which the channel writes out
+// with a single sendmsg() instead of copying them together.
+const size_t kSegmentSize = 64 * 1024;
+#endif
+
+}  // namespace
+
 namespace IPC {
 
 //------------------------------------------------------------------------------
@@ -24,6 +34,7 @@ Message::Message()
 #if defined(OS_POSIX)
   header()->num_fds = 0;
   header()->pad = 0;
+  EnableSegments(kSegmentSize);
 #endif
   InitLoggingVariables();
 }
@@ -36,6 +47,7 @@ Message::Message(int32 routing_id, uint32 type, PriorityValue priority)
 #if defined(OS_POSIX)
   header()->num_fds = 0;
   header()->pad = 0;
+  EnableSegments(kSegmentSize);
 #endif
   InitLoggingVariables();
 }
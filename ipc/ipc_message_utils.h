@@ -846,7 +846,19 @@ struct ParamTraits<Message> {
     DCHECK(p.size() <= INT_MAX);
     int message_size = static_cast<int>(p.size());
     m->WriteInt(message_size);
-    m->WriteData(reinterpret_cast<const char*>(p.data()), message_size);
+    // A message split across segments is gathered into a single buffer.
+    size_t length;
+    const char* data = p.GetDataSegment(0, &length);
+    std::string gathered;
+    if (length < p.size()) {
+      gathered.reserve(p.size());
+      for (size_t offset = 0; offset < p.size(); offset += length) {
+        data = p.GetDataSegment(offset, &length);
+        gathered.append(data, length);
+      }
+      data = gathered.data();
+    }
+    m->WriteData(data, message_size);
   }
   static bool Read(const Message* m, void** iter, Message* r) {
     int size;
@@ -16,6 +16,14 @@ enum CacheType {
   APP_CACHE  // Backing store for an AppCache.
 };
 
+// The implementations of caches stored on disk.
+enum BackendType {
+  CACHE_BACKEND_DEFAULT,
+  CACHE_BACKEND_BLOCKFILE,  // Entries share block files, and an index.
+  CACHE_BACKEND_SIMPLE,  // Every entry is stored in files of its own.
+  CACHE_BACKEND_SHARDED  // Block file caches, each with its own thread.
+};
+
 }  // namespace disk_cache
 
 #endif  // NET_BASE_CACHE_TYPE_H_
@@ -108,6 +108,10 @@ typedef std::vector<CookieMonster::CanonicalCookie*> CanonicalCookieVector;
 // will update it again.
 const int kDefaultAccessUpdateThresholdSeconds = 60;
 
+// The most hosts whose cookies are kept by FindCookiesForURL().  A page
+// load requests cookies from a few dozen hosts at most.
+const size_t kMaxHostCookies = 200;
+
 // Comparator to sort cookies from highest creation date to lowest
 // creation date.
 struct OrderByCreationTimeDesc {
@@ -362,7 +366,9 @@ void BuildCookieInfoList(const CanonicalCookieVector& cookies,
 bool CookieMonster::enable_file_scheme_ = false;
 
 CookieMonster::CookieMonster(PersistentCookieStore* store, Delegate* delegate)
-    : initialized_(false),
+    : host_cookies_(HostCookiesCache::NO_AUTO_EVICT),
+      next_key_generation_(0),
+      initialized_(false),
       loaded_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
       store_(store),
@@ -379,7 +385,9 @@ CookieMonster::CookieMonster(PersistentCookieStore* store, Delegate* delegate)
 CookieMonster::CookieMonster(PersistentCookieStore* store,
                              Delegate* delegate,
                              int last_access_threshold_milliseconds)
-    : initialized_(false),
+    : host_cookies_(HostCookiesCache::NO_AUTO_EVICT),
+      next_key_generation_(0),
+      initialized_(false),
       loaded_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
       store_(store),
@@ -1166,7 +1174,7 @@ CookieList CookieMonster::GetAllCookiesForURLWithOptions(
   base::AutoLock autolock(lock_);
 
   std::vector<CanonicalCookie*> cookie_ptrs;
-  FindCookiesForHostAndDomain(url, options, false, &cookie_ptrs);
+  FindCookiesForHostAndDomain(url, options, true, false, &cookie_ptrs);
   std::sort(cookie_ptrs.begin(), cookie_ptrs.end(), CookieSorter);
 
   CookieList cookies;
@@ -1327,8 +1335,7 @@ std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
   TimeTicks start_time(TimeTicks::Now());
 
   std::vector<CanonicalCookie*> cookies;
-  FindCookiesForHostAndDomain(url, options, true, &cookies);
-  std::sort(cookies.begin(), cookies.end(), CookieSorter);
+  FindCookiesForURL(url, options, &cookies);
 
   std::string cookie_line = BuildCookieLine(cookies);
 
@@ -1354,8 +1361,7 @@ void CookieMonster::GetCookiesWithInfo(const GURL& url,
   TimeTicks start_time(TimeTicks::Now());
 
   std::vector<CanonicalCookie*> cookies;
-  FindCookiesForHostAndDomain(url, options, true, &cookies);
-  std::sort(cookies.begin(), cookies.end(), CookieSorter);
+  FindCookiesForURL(url, options, &cookies);
   *cookie_line = BuildCookieLine(cookies);
 
   histogram_time_get_->AddTime(TimeTicks::Now() - start_time);
@@ -1376,7 +1382,7 @@ void CookieMonster::DeleteCookie(const GURL& url,
   options.set_include_httponly();
   // Get the cookies for this host and its domain(s).
   std::vector<CanonicalCookie*> cookies;
-  FindCookiesForHostAndDomain(url, options, true, &cookies);
+  FindCookiesForHostAndDomain(url, options, true, true, &cookies);
   std::set<CanonicalCookie*> matching_cookies;
 
   for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
@@ -1651,9 +1657,114 @@ void CookieMonster::SetDefaultCookieableSchemes() {
 }
 
 
+CookieMonster::HostCookies::HostCookies() : generation(0) {
+}
+
+CookieMonster::HostCookies::~HostCookies() {
+}
+
+void CookieMonster::FindCookiesForURL(const GURL& url,
+                                      const CookieOptions& options,
+                                      std::vector<CanonicalCookie*>* cookies) {
+  lock_.AssertAcquired();
+
+  // The cookies found for a host depend on the options and on whether the
+  // scheme is secure and cookieable.
+  std::string host_key(options.exclude_httponly() ? "-" : "+");
+  host_key += url.scheme();
+  host_key += "://";
+  host_key += url.host();
+
+  const Time current(CurrentTime());
+  HostCookiesCache::iterator it = host_cookies_.Get(host_key);
+  bool current_host_cookies = false;
+  if (it != host_cookies_.end()) {
+    const HostCookies& host_cookies = it->second;
+    KeyGenerationMap::const_iterator generation =
+        key_generations_.find(host_cookies.key);
+    current_host_cookies =
+        generation != key_generations_.end() &&
+        generation->second.generation == host_cookies.generation &&
+        (host_cookies.expiry.is_null() || host_cookies.expiry > current ||
+         keep_expired_cookies_);
+  }
+
+  if (current_host_cookies) {
+    // Do what FindCookiesForHostAndDomain() would have done.
+    RecordPeriodicStats(current);
+  } else {
+    std::vector<CanonicalCookie*> host_cookies;
+    FindCookiesForHostAndDomain(url, options, false, false, &host_cookies);
+    std::sort(host_cookies.begin(), host_cookies.end(), CookieSorter);
+
+    // Finding the cookies may have deleted expired ones, which can drop
+    // entries, so look again.  For the same reason, the generation is taken
+    // after.
+    it = host_cookies_.Peek(host_key);
+    if (it != host_cookies_.end())
+      EraseHostCookies(it);
+    else if (host_cookies_.size() >= kMaxHostCookies)
+      EraseHostCookies(--host_cookies_.end());
+    it = host_cookies_.Put(host_key, HostCookies());
+
+    HostCookies& entry = it->second;
+    entry.key = GetKey(url.host());
+    KeyGeneration& generation = key_generations_.insert(
+        KeyGenerationMap::value_type(entry.key, KeyGeneration())).first->second;
+    ++generation.num_hosts;
+    entry.generation = generation.generation;
+    for (size_t i = 0; i < host_cookies.size(); ++i) {
+      if (host_cookies[i]->DoesExpire() &&
+          (entry.expiry.is_null() ||
+           host_cookies[i]->ExpiryDate() < entry.expiry)) {
+        entry.expiry = host_cookies[i]->ExpiryDate();
+      }
+    }
+    entry.cookies.swap(host_cookies);
+  }
+
+  // Filtering keeps the cookies sorted.
+  const std::vector<CanonicalCookie*>& host_cookies = it->second.cookies;
+  const std::string path(url.path());
+  for (size_t i = 0; i < host_cookies.size(); ++i) {
+    if (!host_cookies[i]->IsOnPath(path))
+      continue;
+    InternalUpdateCookieAccessTime(host_cookies[i], current);
+    cookies->push_back(host_cookies[i]);
+  }
+}
+
+void CookieMonster::InvalidateHostCookies(const std::string& key) {
+  lock_.AssertAcquired();
+
+  // Under the old key scheme, a host's cookies can come from several keys;
+  // see FindCookiesForHostAndDomain().
+  if (expiry_and_key_scheme_ == EKS_DISCARD_RECENT_AND_PURGE_DOMAIN) {
+    host_cookies_.Clear();
+    key_generations_.clear();
+    return;
+  }
+
+  KeyGenerationMap::iterator it = key_generations_.find(key);
+  if (it != key_generations_.end())
+    it->second.generation = ++next_key_generation_;
+}
+
+void CookieMonster::EraseHostCookies(HostCookiesCache::iterator it) {
+  lock_.AssertAcquired();
+
+  KeyGenerationMap::iterator generation = key_generations_.find(it->second.key);
+  if (generation != key_generations_.end() &&
+      --generation->second.num_hosts == 0) {
+    key_generations_.erase(generation);
+  }
+  host_cookies_.Erase(it);
+}
+
 void CookieMonster::FindCookiesForHostAndDomain(
     const GURL& url,
     const CookieOptions& options,
+    bool match_path,
     bool update_access_time,
     std::vector<CanonicalCookie*>* cookies) {
   lock_.AssertAcquired();
@@ -1668,7 +1779,7 @@ void CookieMonster::FindCookiesForHostAndDomain(
   if (expiry_and_key_scheme_ == EKS_DISCARD_RECENT_AND_PURGE_DOMAIN) {
     // Can just dispatch to FindCookiesForKey
     const std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time,
+    FindCookiesForKey(key, url, options, match_path, current_time,
                       update_access_time, cookies);
   } else {
     // Need to probe for all domains that might have relevant
@@ -1676,8 +1787,8 @@ void CookieMonster::FindCookiesForHostAndDomain(
 
     // Query for the full host, For example: 'a.c.blah.com'.
     std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time, update_access_time,
-                      cookies);
+    FindCookiesForKey(key, url, options, match_path, current_time,
+                      update_access_time, cookies);
 
     // See if we can search for domain cookies, i.e. if the host has a TLD + 1.
     const std::string domain(cookie_util::GetEffectiveDomain(url.scheme(),
@@ -1694,8 +1805,8 @@ void CookieMonster::FindCookiesForHostAndDomain(
     // registrars other domains can, in which case we don't want to read their
     // cookies.
     for (key = "." + key; key.length() > domain.length(); ) {
-      FindCookiesForKey(key, url, options, current_time, update_access_time,
-                        cookies);
+      FindCookiesForKey(key, url, options, match_path, current_time,
+                        update_access_time, cookies);
       const size_t next_dot = key.find('.', 1);  // Skip over leading dot.
       key.erase(0, next_dot);
     }
@@ -1706,6 +1817,7 @@ void CookieMonster::FindCookiesForKey(
     const std::string& key,
     const GURL& url,
     const CookieOptions& options,
+    bool match_path,
     const Time& current,
     bool update_access_time,
     std::vector<CanonicalCookie*>* cookies) {
@@ -1740,7 +1852,7 @@ void CookieMonster::FindCookiesForKey(
         && !cc->IsDomainMatch(scheme, host))
       continue;
 
-    if (!cc->IsOnPath(url.path()))
+    if (match_path && !cc->IsOnPath(url.path()))
       continue;
 
     // Add this cookie to the set of matching cookies.  Update the access
@@ -1792,6 +1904,7 @@ void CookieMonster::InternalInsertCookie(const std::string& key,
       store_ && sync_to_store)
     store_->AddCookie(*cc);
   cookies_.insert(CookieMap::value_type(key, cc));
+  InvalidateHostCookies(key);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(
         *cc, false, CookieMonster::Delegate::CHANGE_COOKIE_EXPLICIT);
@@ -1937,6 +2050,7 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
     if (mapping.notify)
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
+  InvalidateHostCookies(it->first);
   cookies_.erase(it);
   delete cc;
 }
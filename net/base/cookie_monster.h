@@ -18,7 +18,9 @@
 
 #include "base/basictypes.h"
 #include "base/callback_forward.h"
+#include "base/flat_hash_tables.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/mru_cache.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/synchronization/lock.h"
@@ -499,14 +501,50 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   void SetDefaultCookieableSchemes();
 
+  // The cookies that apply to a host, before filtering by path, and what's
+  // needed to tell whether they are still current.
+  struct HostCookies {
+    HostCookies();
+    ~HostCookies();
+
+    // The CookieMap key of the cookies, and its generation when they were
+    // found; see |key_generations_|.
+    std::string key;
+    int64 generation;
+
+    // The earliest expiry date of the cookies, or null if none expire.
+    base::Time expiry;
+
+    // Sorted with CookieSorter.
+    std::vector<CanonicalCookie*> cookies;
+  };
+  typedef base::HashingMRUCache<std::string, HostCookies> HostCookiesCache;
+
+  // Finds the cookies for |url|, sorted, as FindCookiesForHostAndDomain()
+  // would and updating their access times.  The host's cookies are taken
+  // from |host_cookies_| if they haven't changed since they were last found.
+  void FindCookiesForURL(const GURL& url,
+                         const CookieOptions& options,
+                         std::vector<CanonicalCookie*>* cookies);
+
+  // Drops the HostCookies found from cookies with CookieMap key |key|.
+  void InvalidateHostCookies(const std::string& key);
+
+  // Removes |it| from |host_cookies_|, forgetting the generation of its key
+  // once no other entry uses it.
+  void EraseHostCookies(HostCookiesCache::iterator it);
+
+  // Unless |match_path| is false, only cookies on |url|'s path are found.
   void FindCookiesForHostAndDomain(const GURL& url,
                                    const CookieOptions& options,
+                                   bool match_path,
                                    bool update_access_time,
                                    std::vector<CanonicalCookie*>* cookies);
 
   void FindCookiesForKey(const std::string& key,
                          const GURL& url,
                          const CookieOptions& options,
+                         bool match_path,
                          const base::Time& current,
                          bool update_access_time,
                          std::vector<CanonicalCookie*>* cookies);
@@ -621,6 +659,25 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   CookieMap cookies_;
 
+  // Cookies found by FindCookiesForURL(), keyed by the options, scheme and
+  // host they were found for, most recently used first.  Pages request the
+  // cookies of the same few hosts over and over, while the cookies of any one
+  // eTLD+1 rarely change, so most requests only need to filter these by path
+  // rather than walk and sort the cookies.
+  HostCookiesCache host_cookies_;
+
+  // The generation of each CookieMap key that has entries in |host_cookies_|,
+  // and how many.  Changing a key's cookies moves it to a new generation,
+  // which drops all of the key's entries at the cost of one lookup: an entry
+  // is only current while its key is still at the generation it was found at.
+  struct KeyGeneration {
+    int64 generation;
+    int num_hosts;
+  };
+  typedef base::flat_hash_map<std::string, KeyGeneration> KeyGenerationMap;
+  KeyGenerationMap key_generations_;
+  int64 next_key_generation_;
+
   // Indicates whether the cookie store has been initialized. This happens
   // lazily in InitStoreIfNecessary().
   bool initialized_;
@@ -7,6 +7,7 @@
 #include "base/bind.h"
 #include "base/message_loop.h"
 #include "base/perftimer.h"
+#include "base/string_number_conversions.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "googleurl/src/gurl.h"
@@ -321,6 +322,77 @@ TEST_F(CookieMonsterTest, TestDomainLine) {
   timer2.Done();
 }
 
+// Fills |cm| with a jar near the size limit: 300 sites of 10 cookies each,
+// some for the site's domain and some for one host or path.  Returns URLs
+// of pages on the sites, for requests.
+static std::vector<GURL> SetUpLargeJar(CookieMonster* cm) {
+  SetCookieCallback setCookieCallback;
+  std::vector<GURL> gurls;
+  for (int site = 0; site < 300; ++site) {
+    const std::string domain(base::StringPrintf("site%03d.izzle", site));
+    const GURL www("http://www." + domain + "/");
+    for (int i = 0; i < 10; ++i) {
+      std::string cookie(base::StringPrintf("c%d=%08d", i, site * 10 + i));
+      if (i % 3 == 0)
+        cookie += "; domain=." + domain;
+      else if (i % 3 == 1)
+        cookie += "; path=/p" + base::IntToString(i);
+      setCookieCallback.SetCookie(cm, www, cookie);
+    }
+    gurls.push_back(GURL("http://www." + domain + "/p1/index.html"));
+    gurls.push_back(GURL("http://img." + domain + "/a.png"));
+  }
+  return gurls;
+}
+
+// A page load requests cookies for its document and each subresource, most
+// of them from a handful of hosts.
+TEST_F(CookieMonsterTest, TestQueryLargeJar) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  std::vector<GURL> gurls = SetUpLargeJar(cm);
+  GetCookiesCallback getCookiesCallback;
+
+  PerfTimeLogger timer("Cookie_monster_query_large_jar");
+  for (int i = 0; i < kNumCookies; ++i)
+    getCookiesCallback.GetCookies(cm, gurls[(i * 7) % 40]);
+  timer.Done();
+
+  // More hosts than are cached, so each request finds the cookies afresh.
+  PerfTimeLogger timer2("Cookie_monster_query_large_jar_all_sites");
+  for (int i = 0; i < kNumCookies; ++i)
+    getCookiesCallback.GetCookies(cm, gurls[(i * 7) % gurls.size()]);
+  timer2.Done();
+
+  // Most subresources are requested only once, so their paths are new.
+  std::vector<GURL> unique_gurls;
+  for (int i = 0; i < kNumCookies; ++i) {
+    unique_gurls.push_back(gurls[(i * 7) % 40].Resolve(
+        base::StringPrintf("/p%d/r%d.png", i % 10, i)));
+  }
+  PerfTimeLogger timer3("Cookie_monster_query_large_jar_unique_paths");
+  for (int i = 0; i < kNumCookies; ++i)
+    getCookiesCallback.GetCookies(cm, unique_gurls[i]);
+  timer3.Done();
+}
+
+// As above, but one request in ten also sets a cookie, as tracking and
+// session cookies are refreshed during browsing.
+TEST_F(CookieMonsterTest, TestQueryLargeJarWithSets) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  std::vector<GURL> gurls = SetUpLargeJar(cm);
+  GetCookiesCallback getCookiesCallback;
+  SetCookieCallback setCookieCallback;
+
+  PerfTimeLogger timer("Cookie_monster_query_large_jar_with_sets");
+  for (int i = 0; i < kNumCookies; ++i) {
+    const GURL& gurl = gurls[(i * 7) % 40];
+    if (i % 10 == 0)
+      setCookieCallback.SetCookie(cm, gurl, base::StringPrintf("t=%d", i));
+    getCookiesCallback.GetCookies(cm, gurl);
+  }
+  timer.Done();
+}
+
 TEST_F(CookieMonsterTest, TestImport) {
   scoped_refptr<MockPersistentCookieStore> store(new MockPersistentCookieStore);
   std::vector<CookieMonster::CanonicalCookie*> initial_cookies;
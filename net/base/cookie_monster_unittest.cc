@@ -2040,6 +2040,94 @@ TEST_F(CookieMonsterTest, TestLastAccess) {
   EXPECT_FALSE(last_access_date == GetFirstCookieAccessDate(cm));
 }
 
+// GetCookies() answers repeated requests for a host from the host's cached
+// cookies; check that every kind of change to the cookies reaches them.
+TEST_F(CookieMonsterTest, CookieLinesFollowChanges) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  CookieOptions options;
+  options.set_include_httponly();
+  const GURL url_other("http://www.other.izzle");
+
+  EXPECT_TRUE(SetCookie(cm, url_google_, "A=B"));
+  EXPECT_EQ("A=B", GetCookies(cm, url_google_));
+  EXPECT_EQ("A=B", GetCookies(cm, url_google_));
+
+  // A new cookie, and one set on another host of the same domain.
+  EXPECT_TRUE(SetCookie(cm, url_google_, "C=D"));
+  EXPECT_EQ("A=B; C=D", GetCookies(cm, url_google_));
+  EXPECT_TRUE(SetCookie(cm, GURL(kUrlGoogleSpecific),
+                        "G=H; domain=.google.izzle"));
+  EXPECT_EQ("A=B; C=D; G=H", GetCookies(cm, url_google_));
+
+  // Cookies of other domains don't matter.
+  EXPECT_TRUE(SetCookie(cm, url_other, "X=Y"));
+  EXPECT_EQ("A=B; C=D; G=H", GetCookies(cm, url_google_));
+  EXPECT_EQ("X=Y", GetCookies(cm, url_other));
+
+  // Overwriting and deleting.
+  EXPECT_TRUE(SetCookie(cm, url_google_, "A=Z"));
+  EXPECT_EQ("C=D; G=H; A=Z", GetCookies(cm, url_google_));
+  DeleteCookie(cm, url_google_, "C");
+  EXPECT_EQ("G=H; A=Z", GetCookies(cm, url_google_));
+
+  // The options, scheme and path each get their own line.
+  EXPECT_TRUE(SetCookieWithOptions(cm, url_google_, "I=J; httponly",
+                                   options));
+  EXPECT_TRUE(SetCookie(cm, url_google_, "K=L; secure"));
+  EXPECT_TRUE(SetCookie(cm, url_google_foo_, "M=N; path=/foo"));
+  EXPECT_EQ("G=H; A=Z", GetCookies(cm, url_google_));
+  EXPECT_EQ("G=H; A=Z; I=J", GetCookiesWithOptions(cm, url_google_, options));
+  EXPECT_EQ("G=H; A=Z; K=L", GetCookies(cm, url_google_secure_));
+  EXPECT_EQ("M=N; G=H; A=Z", GetCookies(cm, url_google_foo_));
+  EXPECT_EQ("G=H; A=Z", GetCookies(cm, url_google_bar_));
+
+  // Expiry.
+  EXPECT_TRUE(SetCookieWithDetails(
+      cm, url_google_, "O", "P", std::string(), "/",
+      Time::Now() + TimeDelta::FromMilliseconds(kAccessDelayMs),
+      false, false));
+  EXPECT_EQ("G=H; A=Z; O=P", GetCookies(cm, url_google_));
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromMilliseconds(kAccessDelayMs));
+  EXPECT_EQ("G=H; A=Z", GetCookies(cm, url_google_));
+
+  EXPECT_EQ(6, DeleteAll(cm));
+  EXPECT_EQ("", GetCookies(cm, url_google_));
+  EXPECT_EQ("", GetCookies(cm, url_other));
+}
+
+// Only so many hosts' cookies are cached; check that the cookies of hosts
+// dropped from the cache, and of those still in it, are found and kept
+// current.
+TEST_F(CookieMonsterTest, HostCookiesOfManyHosts) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  const int kNumSites = 300;
+
+  for (int i = 0; i < kNumSites; ++i) {
+    const std::string www(base::StringPrintf("http://www.site%d.izzle", i));
+    const GURL img(base::StringPrintf("http://img.site%d.izzle/", i));
+    EXPECT_TRUE(SetCookie(cm, GURL(www),
+                          base::StringPrintf("A=B; domain=.site%d.izzle", i)));
+    EXPECT_TRUE(SetCookie(cm, GURL(www), "C=D; path=/p"));
+    EXPECT_EQ("C=D; A=B", GetCookies(cm, GURL(www + "/p")));
+    EXPECT_EQ("A=B", GetCookies(cm, img));
+  }
+
+  const int sites[] = { 0, kNumSites - 1 };
+  for (size_t i = 0; i < arraysize(sites); ++i) {
+    const std::string www(
+        base::StringPrintf("http://www.site%d.izzle", sites[i]));
+    const GURL img(base::StringPrintf("http://img.site%d.izzle/", sites[i]));
+    EXPECT_EQ("A=B", GetCookies(cm, GURL(www)));
+    EXPECT_EQ("C=D; A=B", GetCookies(cm, GURL(www + "/p/q")));
+    EXPECT_TRUE(SetCookie(
+        cm, GURL(www),
+        base::StringPrintf("E=F; domain=.site%d.izzle", sites[i])));
+    EXPECT_EQ("C=D; A=B; E=F", GetCookies(cm, GURL(www + "/p")));
+    EXPECT_EQ("A=B; E=F", GetCookies(cm, img));
+  }
+}
+
 TEST_F(CookieMonsterTest, TestHostGarbageCollection) {
   TestHostGarbageCollectHelper(
       CookieMonster::kDomainMaxCookies, CookieMonster::kDomainPurgeCookies,
@@ -3560,14 +3648,14 @@ TEST_F(CookieMonsterTest, ShortLivedSessionCookies) {
   // Get cookies before the cookie has expired.
   std::vector<CookieMonster::CanonicalCookie*> cookies;
   cm->FindCookiesForKey(cm->GetKey(url_google_.host()), url_google_,
-                        CookieOptions(), current, false, &cookies);
+                        CookieOptions(), true, current, false, &cookies);
   EXPECT_EQ(1U, cookies.size());
 
   // Get cookies after the cookie has expired.
   cookies.clear();
   cm->FindCookiesForKey(cm->GetKey(url_google_.host()), url_google_,
-                        CookieOptions(), current + TimeDelta::FromSeconds(20),
-                        false, &cookies);
+                        CookieOptions(), true,
+                        current + TimeDelta::FromSeconds(20), false, &cookies);
   EXPECT_EQ(0U, cookies.size());
 }
 
@@ -126,13 +126,15 @@ void NetworkChangeNotifier::RemoveDNSObserver(DNSObserver* observer) {
 NetworkChangeNotifier::NetworkChangeNotifier()
     : ip_address_observer_list_(
         new ObserverListThreadSafe<IPAddressObserver>(
-            ObserverListBase<IPAddressObserver>::NOTIFY_EXISTING_ONLY)),
+            ObserverListBase<IPAddressObserver>::NOTIFY_EXISTING_ONLY,
+            ObserverListThreadSafe<IPAddressObserver>::DELIVER_COALESCED)),
       online_state_observer_list_(
         new ObserverListThreadSafe<OnlineStateObserver>(
             ObserverListBase<OnlineStateObserver>::NOTIFY_EXISTING_ONLY)),
       resolver_state_observer_list_(
         new ObserverListThreadSafe<DNSObserver>(
-            ObserverListBase<DNSObserver>::NOTIFY_EXISTING_ONLY)) {
+            ObserverListBase<DNSObserver>::NOTIFY_EXISTING_ONLY,
+            ObserverListThreadSafe<DNSObserver>::DELIVER_COALESCED)) {
   DCHECK(!g_network_change_notifier);
   g_network_change_notifier = this;
 }
@@ -28,6 +28,8 @@
 #include "net/disk_cache/file.h"
 #include "net/disk_cache/hash.h"
 #include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/sharded_backend.h"
+#include "net/disk_cache/simple_backend_impl.h"
 
 // This has to be defined before including histogram_macros.h from this file.
 #define NET_DISK_CACHE_BACKEND_IMPL_CC_
@@ -302,6 +304,15 @@ int CreateCacheBackend(net::CacheType type, const FilePath& path, int max_bytes,
                        bool force, base::MessageLoopProxy* thread,
                        net::NetLog* net_log, Backend** backend,
                        const net::CompletionCallback& callback) {
+  return CreateCacheBackend(type, net::CACHE_BACKEND_DEFAULT, path, max_bytes,
+                            force, thread, net_log, backend, callback);
+}
+
+int CreateCacheBackend(net::CacheType type, net::BackendType backend_type,
+                       const FilePath& path, int max_bytes, bool force,
+                       base::MessageLoopProxy* thread, net::NetLog* net_log,
+                       Backend** backend,
+                       const net::CompletionCallback& callback) {
   DCHECK(!callback.is_null());
   if (type == net::MEMORY_CACHE) {
     *backend = MemBackendImpl::CreateBackend(max_bytes, net_log);
@@ -309,6 +320,16 @@ int CreateCacheBackend(net::CacheType type, const FilePath& path, int max_bytes,
   }
   DCHECK(thread);
 
+  if (backend_type == net::CACHE_BACKEND_SIMPLE) {
+    return SimpleBackendImpl::CreateBackend(path, force, max_bytes, thread,
+                                            backend, callback);
+  }
+  if (backend_type == net::CACHE_BACKEND_SHARDED) {
+    // The shards run on threads of their own, not on |thread|.
+    return ShardedBackend::CreateBackend(
+        path, force, max_bytes, type, kNone,
+        ShardedBackend::GetDefaultNumShards(), net_log, backend, callback);
+  }
   return BackendImpl::CreateBackend(path, force, max_bytes, type, kNone, thread,
                                     net_log, backend, callback);
 }
@@ -362,6 +383,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       read_only_(false),
       disabled_(false),
       new_eviction_(false),
+      use_eviction_policy_(false),
       first_timer_(true),
       user_load_(false),
       net_log_(net_log),
@@ -388,6 +410,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       read_only_(false),
       disabled_(false),
       new_eviction_(false),
+      use_eviction_policy_(false),
       first_timer_(true),
       user_load_(false),
       net_log_(net_log),
@@ -519,6 +542,8 @@ int BackendImpl::SyncInit() {
     return net::ERR_FAILED;
 
   disabled_ = !rankings_.Init(this, new_eviction_);
+  if (!disabled_)
+    eviction_.LoadEntries();
 
 #if defined(STRESS_CACHE_EXTENDED_VALIDATION)
   trace_object_->EnableTracing(false);
@@ -1288,6 +1313,11 @@ void BackendImpl::SetNewEviction() {
   new_eviction_ = true;
 }
 
+void BackendImpl::SetEvictionPolicy() {
+  user_flags_ |= kEvictionPolicy;
+  use_eviction_policy_ = true;
+}
+
 void BackendImpl::SetFlags(uint32 flags) {
   user_flags_ |= flags;
 }
@@ -1573,6 +1603,9 @@ void BackendImpl::PrepareForRestart() {
   if (!(user_flags_ & kNewEviction))
     new_eviction_ = false;
 
+  if (!(user_flags_ & kEvictionPolicy))
+    use_eviction_policy_ = false;
+
   disabled_ = true;
   data_->header.crash = 0;
   index_ = NULL;
@@ -2207,21 +2240,22 @@ bool BackendImpl::CheckEntry(EntryImpl* cache_entry) {
 }
 
 int BackendImpl::MaxBuffersSize() {
-  static int64 total_memory = base::SysInfo::AmountOfPhysicalMemory();
-  static bool done = false;
+  // The cache threads of a sharded backend may get here at the same time. They
+  // all compute the same value, and only store the final one.
+  static int max_buffers_size = 0;
 
-  if (!done) {
+  if (!max_buffers_size) {
     const int kMaxBuffersSize = 30 * 1024 * 1024;
 
     // We want to use up to 2% of the computer's memory.
-    total_memory = total_memory * 2 / 100;
+    int64 total_memory = base::SysInfo::AmountOfPhysicalMemory() * 2 / 100;
     if (total_memory > kMaxBuffersSize || total_memory <= 0)
       total_memory = kMaxBuffersSize;
 
-    done = true;
+    max_buffers_size = static_cast<int>(total_memory);
   }
 
-  return static_cast<int>(total_memory);
+  return max_buffers_size;
 }
 
 }  // namespace disk_cache
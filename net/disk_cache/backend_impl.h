@@ -35,7 +35,8 @@ enum BackendFlags {
   kNewEviction = 1 << 4,        // Use of new eviction was specified.
   kNoRandom = 1 << 5,           // Don't add randomness to the behavior.
   kNoLoadProtection = 1 << 6,   // Don't act conservatively under load.
-  kNoBuffering = 1 << 7         // Disable extended IO buffering.
+  kNoBuffering = 1 << 7,        // Disable extended IO buffering.
+  kEvictionPolicy = 1 << 8      // Use of an EvictionPolicy was specified.
 };
 
 // This class implements the Backend interface. An object of this
@@ -231,6 +232,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Sets the eviction algorithm to version 2.
   void SetNewEviction();
 
+  // Lets an EvictionPolicy pick the entries to evict. This is off by default:
+  // the policy learns about every stored entry when the cache starts.
+  void SetEvictionPolicy();
+
   // Sets an explicit set of BackendFlags.
   void SetFlags(uint32 flags);
 
@@ -380,6 +385,7 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   bool read_only_;  // Prevents updates of the rankings data (used by tools).
   bool disabled_;
   bool new_eviction_;  // What eviction algorithm should be used.
+  bool use_eviction_policy_;  // Whether an EvictionPolicy picks the victims.
   bool first_timer_;  // True if the timer has not been called.
   bool user_load_;  // True if we see a high load coming from the caller.
 
@@ -446,6 +446,12 @@ TEST_F(DiskCacheBackendTest, NewEvictionSetSize) {
   BackendSetSize();
 }
 
+TEST_F(DiskCacheBackendTest, EvictionPolicySetSize) {
+  SetNewEviction();
+  SetEvictionPolicy();
+  BackendSetSize();
+}
+
 TEST_F(DiskCacheBackendTest, MemoryOnlySetSize) {
   SetMemoryOnlyMode();
   BackendSetSize();
@@ -544,6 +550,37 @@ TEST_F(DiskCacheBackendTest, NewEvictionTrim) {
   entry->Close();
 }
 
+// With an EvictionPolicy, the entries that were reused stay longer than the
+// ones that were not, even after a restart.
+TEST_F(DiskCacheBackendTest, EvictionPolicyTrim) {
+  SetNewEviction();
+  SetEvictionPolicy();
+  SetDirectMode();
+  InitCache();
+
+  disk_cache::Entry* entry;
+  for (int i = 0; i < 44; i++) {
+    std::string name(StringPrintf("Key %d", i));
+    ASSERT_EQ(net::OK, CreateEntry(name, &entry));
+    entry->Close();
+    if (i < 40) {
+      // Entries 0 to 39 are reused; without the policy, the first eviction
+      // would come from their list.
+      ASSERT_EQ(net::OK, OpenEntry(name, &entry));
+      entry->Close();
+    }
+  }
+
+  TrimForTest(false);
+  EXPECT_NE(net::OK, OpenEntry("Key 40", &entry));
+
+  SimulateCrash();
+  TrimForTest(false);
+  EXPECT_NE(net::OK, OpenEntry("Key 41", &entry));
+  ASSERT_EQ(net::OK, OpenEntry("Key 0", &entry));
+  entry->Close();
+}
+
 // Before looking for invalid entries, let's check a valid entry.
 void DiskCacheBackendTest::BackendValidEntry() {
   SetDirectMode();
@@ -55,6 +55,15 @@ NET_EXPORT int CreateCacheBackend(net::CacheType type, const FilePath& path,
                                   net::NetLog* net_log, Backend** backend,
                                   const net::CompletionCallback& callback);
 
+// Same as above, but with |backend_type| choosing how a cache stored on disk
+// keeps its files. It is ignored for a MEMORY_CACHE.
+NET_EXPORT int CreateCacheBackend(net::CacheType type,
+                                  net::BackendType backend_type,
+                                  const FilePath& path, int max_bytes,
+                                  bool force, base::MessageLoopProxy* thread,
+                                  net::NetLog* net_log, Backend** backend,
+                                  const net::CompletionCallback& callback);
+
 // The root interface for a disk cache instance.
 class NET_EXPORT Backend {
  public:
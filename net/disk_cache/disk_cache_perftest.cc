@@ -7,8 +7,10 @@
 #include "base/basictypes.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/file_util.h"
 #include "base/perftimer.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/threading/thread.h"
 #include "base/test/test_file_util.h"
 #include "base/timer.h"
@@ -21,6 +23,7 @@
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
 #include "net/disk_cache/hash.h"
+#include "net/disk_cache/sharded_backend.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
@@ -37,9 +40,9 @@ typedef std::vector<TestEntry> TestEntries;
 const int kMaxSize = 16 * 1024 - 1;
 
 // Creates num_entries on the cache, and writes 200 bytes of metadata and up
-// to kMaxSize of data to each entry.
-bool TimeWrite(int num_entries, disk_cache::Backend* cache,
-              TestEntries* entries) {
+// to kMaxSize of data to each entry. |prefix| names the backend in the log.
+bool TimeWrite(const std::string& prefix, int num_entries,
+               disk_cache::Backend* cache, TestEntries* entries) {
   const int kSize1 = 200;
   scoped_refptr<net::IOBuffer> buffer1(new net::IOBuffer(kSize1));
   scoped_refptr<net::IOBuffer> buffer2(new net::IOBuffer(kMaxSize));
@@ -52,7 +55,7 @@ bool TimeWrite(int num_entries, disk_cache::Backend* cache,
   MessageLoopHelper helper;
   CallbackTest callback(&helper, true);
 
-  PerfTimeLogger timer("Write disk cache entries");
+  PerfTimeLogger timer((prefix + "Write disk cache entries").c_str());
 
   for (int i = 0; i < num_entries; i++) {
     TestEntry entry;
@@ -90,8 +93,9 @@ bool TimeWrite(int num_entries, disk_cache::Backend* cache,
 }
 
 // Reads the data and metadata from each entry listed on |entries|.
-bool TimeRead(int num_entries, disk_cache::Backend* cache,
-             const TestEntries& entries, bool cold) {
+bool TimeRead(const std::string& prefix, int num_entries,
+              disk_cache::Backend* cache, const TestEntries& entries,
+              bool cold) {
   const int kSize1 = 200;
   scoped_refptr<net::IOBuffer> buffer1(new net::IOBuffer(kSize1));
   scoped_refptr<net::IOBuffer> buffer2(new net::IOBuffer(kMaxSize));
@@ -104,9 +108,9 @@ bool TimeRead(int num_entries, disk_cache::Backend* cache,
   MessageLoopHelper helper;
   CallbackTest callback(&helper, true);
 
-  const char* message = cold ? "Read disk cache entries (cold)" :
-                        "Read disk cache entries (warm)";
-  PerfTimeLogger timer(message);
+  std::string message = prefix + (cold ? "Read disk cache entries (cold)" :
+                                         "Read disk cache entries (warm)");
+  PerfTimeLogger timer(message.c_str());
 
   for (int i = 0; i < num_entries; i++) {
     disk_cache::Entry* cache_entry;
@@ -138,6 +142,60 @@ bool TimeRead(int num_entries, disk_cache::Backend* cache,
   return (expected == helper.callbacks_called());
 }
 
+void OnOperationDone(MessageLoopHelper* helper, int* failures, int result) {
+  if (result < 0)
+    (*failures)++;
+  helper->CallbackWasCalled();
+}
+
+// Opens and reads all the |entries|, sending every request to the cache
+// before waiting for any of them, so that a backend with more than one thread
+// can work on several entries at the same time. Logs the number of entries
+// read per second.
+bool TimeParallelRead(const std::string& message, disk_cache::Backend* cache,
+                      const TestEntries& entries) {
+  int num_entries = static_cast<int>(entries.size());
+  std::vector<disk_cache::Entry*> cache_entries(num_entries);
+  std::vector<scoped_refptr<net::IOBuffer> > buffers(num_entries);
+
+  MessageLoopHelper helper;
+  int failures = 0;
+  int expected = 0;
+  net::CompletionCallback callback =
+      base::Bind(&OnOperationDone, &helper, &failures);
+
+  PerfTimer timer;
+
+  for (int i = 0; i < num_entries; i++) {
+    int rv = cache->OpenEntry(entries[i].key, &cache_entries[i], callback);
+    if (net::ERR_IO_PENDING == rv)
+      expected++;
+    else if (net::OK != rv)
+      return false;
+  }
+  if (!helper.WaitUntilCacheIoFinished(expected) || failures)
+    return false;
+
+  for (int i = 0; i < num_entries; i++) {
+    buffers[i] = new net::IOBuffer(kMaxSize);
+    int rv = cache_entries[i]->ReadData(1, 0, buffers[i], entries[i].data_len,
+                                        callback);
+    if (net::ERR_IO_PENDING == rv)
+      expected++;
+    else if (entries[i].data_len != rv)
+      return false;
+  }
+  bool result = helper.WaitUntilCacheIoFinished(expected) && !failures;
+
+  for (int i = 0; i < num_entries; i++)
+    cache_entries[i]->Close();
+
+  double seconds = timer.Elapsed().InSecondsF();
+  if (seconds)
+    LogPerfResult(message.c_str(), num_entries / seconds, "entries/s");
+  return result;
+}
+
 int BlockSize() {
   // We can use form 1 to 4 blocks.
   return (rand() & 0x3) + 1;
@@ -157,16 +215,34 @@ TEST_F(DiskCacheTest, Hash) {
   timer.Done();
 }
 
-TEST_F(DiskCacheTest, CacheBackendPerformance) {
+namespace {
+
+// Removes every file of the cache at |cache_path| from the system cache.
+bool EvictCacheFromSystemCache(const FilePath& cache_path) {
+  file_util::FileEnumerator iter(cache_path, false,
+                                 file_util::FileEnumerator::FILES);
+  for (FilePath file = iter.Next(); !file.empty(); file = iter.Next()) {
+    if (!file_util::EvictFileFromSystemCache(file))
+      return false;
+  }
+  return true;
+}
+
+// Writes 1000 entries to a new cache of type |backend_type| and reads them
+// back, with the cache out of and in the system cache. |prefix| names the
+// backend in the log.
+void CacheBackendPerformance(const FilePath& cache_path,
+                             net::BackendType backend_type,
+                             const std::string& prefix) {
   base::Thread cache_thread("CacheThread");
   ASSERT_TRUE(cache_thread.StartWithOptions(
                   base::Thread::Options(MessageLoop::TYPE_IO, 0)));
 
-  ASSERT_TRUE(CleanupCacheDir());
+  ASSERT_TRUE(DeleteCache(cache_path));
   net::TestCompletionCallback cb;
   disk_cache::Backend* cache;
   int rv = disk_cache::CreateCacheBackend(
-      net::DISK_CACHE, cache_path_, 0, false,
+      net::DISK_CACHE, backend_type, cache_path, 0, false,
       cache_thread.message_loop_proxy(), NULL, &cache, cb.callback());
 
   ASSERT_EQ(net::OK, cb.GetResult(rv));
@@ -177,35 +253,78 @@ TEST_F(DiskCacheTest, CacheBackendPerformance) {
   TestEntries entries;
   int num_entries = 1000;
 
-  EXPECT_TRUE(TimeWrite(num_entries, cache, &entries));
+  EXPECT_TRUE(TimeWrite(prefix, num_entries, cache, &entries));
 
   MessageLoop::current()->RunAllPending();
   delete cache;
 
-  ASSERT_TRUE(file_util::EvictFileFromSystemCache(
-              cache_path_.AppendASCII("index")));
-  ASSERT_TRUE(file_util::EvictFileFromSystemCache(
-              cache_path_.AppendASCII("data_0")));
-  ASSERT_TRUE(file_util::EvictFileFromSystemCache(
-              cache_path_.AppendASCII("data_1")));
-  ASSERT_TRUE(file_util::EvictFileFromSystemCache(
-              cache_path_.AppendASCII("data_2")));
-  ASSERT_TRUE(file_util::EvictFileFromSystemCache(
-              cache_path_.AppendASCII("data_3")));
+  // Some backends finish writing their files on the cache thread after they
+  // are gone.
+  net::TestCompletionCallback flush_cb;
+  cache_thread.message_loop_proxy()->PostTaskAndReply(
+      FROM_HERE, base::Bind(&base::DoNothing),
+      base::Bind(flush_cb.callback(), net::OK));
+  ASSERT_EQ(net::OK, flush_cb.WaitForResult());
+
+  ASSERT_TRUE(EvictCacheFromSystemCache(cache_path));
 
   rv = disk_cache::CreateCacheBackend(
-      net::DISK_CACHE, cache_path_, 0, false, cache_thread.message_loop_proxy(),
-      NULL, &cache, cb.callback());
+      net::DISK_CACHE, backend_type, cache_path, 0, false,
+      cache_thread.message_loop_proxy(), NULL, &cache, cb.callback());
   ASSERT_EQ(net::OK, cb.GetResult(rv));
 
-  EXPECT_TRUE(TimeRead(num_entries, cache, entries, true));
+  EXPECT_TRUE(TimeRead(prefix, num_entries, cache, entries, true));
 
-  EXPECT_TRUE(TimeRead(num_entries, cache, entries, false));
+  EXPECT_TRUE(TimeRead(prefix, num_entries, cache, entries, false));
 
   MessageLoop::current()->RunAllPending();
   delete cache;
 }
 
+}  // namespace
+
+TEST_F(DiskCacheTest, CacheBackendPerformance) {
+  CacheBackendPerformance(cache_path_, net::CACHE_BACKEND_BLOCKFILE, "");
+}
+
+// The same benchmark, for the simple cache.
+TEST_F(DiskCacheTest, SimpleCacheBackendPerformance) {
+  CacheBackendPerformance(cache_path_, net::CACHE_BACKEND_SIMPLE,
+                          "Simple cache: ");
+}
+
+// Measures how the number of entries that can be read per second grows with
+// the number of cache threads, by spreading the same cache over 1, 2 and 4
+// shards.
+TEST_F(DiskCacheTest, ShardedBackendPerformance) {
+  int seed = static_cast<int>(Time::Now().ToInternalValue());
+  srand(seed);
+
+  const int kNumEntries = 2000;
+  const int kNumShards[] = { 1, 2, 4 };
+  for (size_t i = 0; i < arraysize(kNumShards); i++) {
+    ASSERT_TRUE(file_util::Delete(cache_path_, true));
+
+    net::TestCompletionCallback cb;
+    disk_cache::Backend* cache;
+    int rv = disk_cache::ShardedBackend::CreateBackend(
+        cache_path_, false, 0, net::DISK_CACHE, disk_cache::kNone,
+        kNumShards[i], NULL, &cache, cb.callback());
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+    TestEntries entries;
+    EXPECT_TRUE(TimeWrite("", kNumEntries, cache, &entries));
+
+    std::string message = base::StringPrintf(
+        "Read disk cache entries (warm), %d shards", kNumShards[i]);
+    EXPECT_TRUE(TimeParallelRead(message, cache, entries));
+
+    MessageLoop::current()->RunAllPending();
+    delete cache;
+  }
+  ASSERT_TRUE(file_util::Delete(cache_path_, true));
+}
+
 // Creating and deleting "entries" on a block-file is something quite frequent
 // (after all, almost everything is stored on block files). The operation is
 // almost free when the file is empty, but can be expensive if the file gets
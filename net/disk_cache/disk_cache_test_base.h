@@ -86,6 +86,10 @@ class DiskCacheTestWithCache : public DiskCacheTest {
     new_eviction_ = true;
   }
 
+  void SetEvictionPolicy() {
+    eviction_policy_ = true;
+  }
+
   void DisableFirstCleanup() {
     first_cleanup_ = false;
   }
@@ -146,6 +150,7 @@ class DiskCacheTestWithCache : public DiskCacheTest {
   bool implementation_;
   bool force_creation_;
   bool new_eviction_;
+  bool eviction_policy_;
   bool first_cleanup_;
   bool integrity_;
   bool use_current_thread_;
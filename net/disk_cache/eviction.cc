@@ -26,8 +26,21 @@
 // size so that we have a chance to see an element again and move it to another
 // list.
 
+// Instead of the lists, an EvictionPolicy (see eviction_policy.h) can pick the
+// entries to evict, when the backend asks for it with SetEvictionPolicy(). The
+// lists are still kept as usual, and the policy learns from them about the
+// entries of earlier runs when the backend starts: the entries on the LOW_USE
+// and HIGH_USE lists were reused. That walks every entry of the cache and
+// keeps a node in memory for each one, so no cache uses a policy by default.
+// The policy knows the entries by their address, and it doesn't know the size
+// of an old entry until it is opened, so until then the entry counts as an
+// average one.
+
 #include "net/disk_cache/eviction.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "base/bind.h"
 #include "base/compiler_specific.h"
 #include "base/logging.h"
@@ -57,6 +70,31 @@ int LowWaterAdjust(int high_water) {
   return high_water - kCleanUpMargin;
 }
 
+// An entry found on the lists when the backend starts.
+struct StoredEntry {
+  bool operator<(const StoredEntry& other) const {
+    return last_used < other.last_used;
+  }
+
+  uint64 last_used;
+  disk_cache::CacheAddr address;
+  disk_cache::EvictionPolicy::EntryState state;
+};
+
+// Returns how the EvictionPolicy knows |entry|.
+uint64 GetPolicyKey(disk_cache::EntryImpl* entry) {
+  return entry->entry()->address().value();
+}
+
+// Returns the bytes that |entry| adds to the size of the cache.
+int64 GetEntrySize(disk_cache::EntryImpl* entry) {
+  disk_cache::EntryStore* info = entry->entry()->Data();
+  int64 size = info->key_len;
+  for (size_t i = 0; i < arraysize(info->data_size); i++)
+    size += info->data_size[i];
+  return size;
+}
+
 }  // namespace
 
 namespace disk_cache {
@@ -85,6 +123,12 @@ void Eviction::Init(BackendImpl* backend) {
   init_ = true;
   test_mode_ = false;
   in_experiment_ = (header_->experiment == EXPERIMENT_DELETED_LIST_IN);
+
+  policy_.reset();
+  if (backend->use_eviction_policy_) {
+    policy_.reset(EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+    policy_->SetMaxSize(backend_->max_size_);
+  }
 }
 
 void Eviction::Stop() {
@@ -100,6 +144,40 @@ void Eviction::Stop() {
   ptr_factory_.InvalidateWeakPtrs();
 }
 
+void Eviction::LoadEntries() {
+  if (!policy_.get())
+    return;
+
+  // Each list is sorted by last use.
+  std::vector<StoredEntry> entries;
+  int num_lists = new_eviction_ ? Rankings::HIGH_USE + 1 : 1;
+  for (int i = 0; i < num_lists; i++) {
+    Rankings::List list = static_cast<Rankings::List>(i);
+    Rankings::ScopedRankingsBlock node(rankings_);
+    Rankings::ScopedRankingsBlock next(rankings_,
+                                       rankings_->GetPrev(node.get(), list));
+    while (next.get()) {
+      node.reset(next.release());
+      next.reset(rankings_->GetPrev(node.get(), list));
+      StoredEntry entry;
+      entry.last_used = node->Data()->last_used;
+      entry.address = node->Data()->contents;
+      entry.state = (list == Rankings::NO_USE) ?
+          EvictionPolicy::ENTRY_NEW : EvictionPolicy::ENTRY_REUSED;
+      entries.push_back(entry);
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end());
+
+  int64 average_size = 0;
+  if (!entries.empty())
+    average_size = header_->num_bytes / static_cast<int64>(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    policy_->OnEntryLoaded(entries[i].address, average_size,
+                           entries[i].state);
+  }
+}
+
 void Eviction::TrimCache(bool empty) {
   if (backend_->disabled_ || trimming_)
     return;
@@ -107,6 +185,9 @@ void Eviction::TrimCache(bool empty) {
   if (!empty && !ShouldTrim())
     return PostDelayedTrim();
 
+  if (policy_.get() && !empty)
+    return TrimCacheWithPolicy();
+
   if (new_eviction_)
     return TrimCacheV2(empty);
 
@@ -155,6 +236,9 @@ void Eviction::TrimCache(bool empty) {
 }
 
 void Eviction::UpdateRank(EntryImpl* entry, bool modified) {
+  if (policy_.get() && modified)
+    policy_->OnEntryResized(GetPolicyKey(entry), GetEntrySize(entry));
+
   if (new_eviction_)
     return UpdateRankV2(entry, modified);
 
@@ -162,11 +246,20 @@ void Eviction::UpdateRank(EntryImpl* entry, bool modified) {
 }
 
 void Eviction::OnOpenEntry(EntryImpl* entry) {
+  if (policy_.get()) {
+    // Entries of earlier runs have a guess of their size until now.
+    policy_->OnEntryResized(GetPolicyKey(entry), GetEntrySize(entry));
+    policy_->OnEntryUsed(GetPolicyKey(entry));
+  }
+
   if (new_eviction_)
     return OnOpenEntryV2(entry);
 }
 
 void Eviction::OnCreateEntry(EntryImpl* entry) {
+  if (policy_.get())
+    policy_->OnEntryAdded(GetPolicyKey(entry), GetEntrySize(entry));
+
   if (new_eviction_)
     return OnCreateEntryV2(entry);
 
@@ -174,6 +267,9 @@ void Eviction::OnCreateEntry(EntryImpl* entry) {
 }
 
 void Eviction::OnDoomEntry(EntryImpl* entry) {
+  if (policy_.get())
+    policy_->OnEntryRemoved(GetPolicyKey(entry));
+
   if (new_eviction_)
     return OnDoomEntryV2(entry);
 
@@ -277,6 +373,9 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
   }
 
   ReportTrimTimes(entry);
+  if (policy_.get())
+    policy_->OnEntryRemoved(GetPolicyKey(entry));
+
   if (empty || !new_eviction_) {
     entry->DoomImpl();
     if (!empty)
@@ -297,6 +396,71 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
   return true;
 }
 
+void Eviction::TrimCacheWithPolicy() {
+  Trace("*** Trim Cache ***");
+  trimming_ = true;
+  TimeTicks start = TimeTicks::Now();
+
+  // The policy may have to be asked again, as it only has a guess of the size
+  // of some entries.
+  int64 target_size = policy_->GetSize() - (header_->num_bytes - max_size_);
+  if (test_mode_)
+    target_size = std::min(target_size, policy_->GetSize() - 1);
+  std::vector<uint64> candidates;
+  policy_->GetEvictionCandidates(target_size, &candidates);
+
+  int deleted_entries = 0;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (header_->num_bytes <= max_size_ && !test_mode_)
+      break;
+
+    // This entry is being used by somebody.
+    Addr address(static_cast<CacheAddr>(candidates[i]));
+    if (backend_->open_entries_.count(address.value()))
+      continue;
+
+    EntryImpl* entry;
+    if (backend_->NewEntry(address, &entry)) {
+      Trace("NewEntry failed on Trim 0x%x", address.value());
+      policy_->OnEntryRemoved(candidates[i]);
+      continue;
+    }
+
+    if (ENTRY_NORMAL == entry->entry()->Data()->state) {
+      Rankings::List list = new_eviction_ ? GetListForEntryV2(entry) :
+                                            GetListForEntry(entry);
+      if (EvictEntry(entry->rankings(), false, list))
+        deleted_entries++;
+    } else {
+      policy_->OnEntryRemoved(candidates[i]);
+    }
+    entry->Release();
+
+    if (test_mode_)
+      break;
+    if (deleted_entries > 20 ||
+        (TimeTicks::Now() - start).InMilliseconds() > 20) {
+      break;
+    }
+  }
+
+  if (deleted_entries && header_->num_bytes > max_size_ && !test_mode_) {
+    MessageLoop::current()->PostTask(FROM_HERE, base::Bind(
+        &Eviction::TrimCache, ptr_factory_.GetWeakPtr(), false));
+  }
+
+  if (new_eviction_ && ShouldTrimDeleted()) {
+    MessageLoop::current()->PostTask(FROM_HERE,
+        base::Bind(&Eviction::TrimDeleted, ptr_factory_.GetWeakPtr(), false));
+  }
+
+  CACHE_UMA(AGE_MS, "TotalTrimTimePolicy", 0, start);
+  CACHE_UMA(COUNTS, "TrimItemsPolicy", 0, deleted_entries);
+
+  trimming_ = false;
+  Trace("*** Trim Cache end ***");
+}
+
 // -----------------------------------------------------------------------
 
 void Eviction::TrimCacheV2(bool empty) {
@@ -7,8 +7,10 @@
 #pragma once
 
 #include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "net/disk_cache/disk_format.h"
+#include "net/disk_cache/eviction_policy.h"
 #include "net/disk_cache/rankings.h"
 
 namespace disk_cache {
@@ -17,7 +19,9 @@ class BackendImpl;
 class EntryImpl;
 
 // This class implements the eviction algorithm for the cache and it is tightly
-// integrated with BackendImpl.
+// integrated with BackendImpl. When the backend asks for it, an EvictionPolicy
+// picks the entries to evict, while the lists keep track of the entries on
+// disk as usual.
 class Eviction {
  public:
   Eviction();
@@ -26,6 +30,10 @@ class Eviction {
   void Init(BackendImpl* backend);
   void Stop();
 
+  // Tells the EvictionPolicy, if there is one, about the entries stored on
+  // the lists. Called once the lists are ready.
+  void LoadEntries();
+
   // Deletes entries from the cache until the current size is below the limit.
   // If empty is true, the whole cache will be trimmed, regardless of being in
   // use.
@@ -53,6 +61,9 @@ class Eviction {
   Rankings::List GetListForEntry(EntryImpl* entry);
   bool EvictEntry(CacheRankingsBlock* node, bool empty, Rankings::List list);
 
+  // Evicts the entries picked by |policy_|.
+  void TrimCacheWithPolicy();
+
   // We'll just keep for a while a separate set of methods that implement the
   // new eviction algorithm. This code will replace the original methods when
   // finished.
@@ -82,6 +93,7 @@ class Eviction {
   bool init_;
   bool test_mode_;
   bool in_experiment_;
+  scoped_ptr<EvictionPolicy> policy_;
   base::WeakPtrFactory<Eviction> ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(Eviction);
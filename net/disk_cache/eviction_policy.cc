@@ -0,0 +1,494 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The LRU policy keeps all the entries on one list, and sends an entry to the
+// front of the list whenever it is used. It is what the block file cache does
+// without the new eviction, and it has the same problem: a burst of entries
+// that are never used again, like a long video, flushes out everything else,
+// no matter how often it was used.
+
+// The segmented LRU policy splits the entries between three lists, and evicts
+// from the end of each list in turn, as long as it has entries:
+
+// A new entry goes to the PROBATION list. When it is used again, it moves to
+// the PROTECTED list, that takes up to kProtectedPercent of the cache; the
+// entries that don't fit on it go back to the front of the PROBATION list. A
+// burst of new entries only pushes out other entries that were not reused.
+
+// Large entries, that take more than 1 / kLargeEntryDivisor of the cache, also
+// have to pass an admission test, like TinyLFU: a FrequencySketch counts the
+// recent uses of every key, and a large entry stays on PROBATION only if its
+// key was used more often than the key of the entry at the end of the list,
+// the next one to go. Otherwise it goes to the COLD list, which is evicted
+// first. The sketch remembers evicted keys, so an entry that is fetched over
+// and over is admitted, while a one-shot download is not. Small entries are
+// admitted without the test, as they are cheap to keep.
+
+// The thresholds follow the size of the cache, so the same policy works for a
+// small media cache and for a big HTTP cache.
+
+// The segment of each entry and the sketch are saved by the cache, so that a
+// restart doesn't send every entry back to PROBATION, nor forget which keys
+// keep coming back.
+
+#include "net/disk_cache/eviction_policy.h"
+
+#include <algorithm>
+#include <list>
+
+#include "base/compiler_specific.h"
+#include "base/flat_hash_tables.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+
+namespace {
+
+const int kProtectedPercent = 80;
+const int kLargeEntryDivisor = 256;
+const int64 kMinLargeEntrySize = 64 * 1024;
+
+// The sketch gets about one counter per entry, for entries of this size.
+const int kAverageEntrySize = 16 * 1024;
+const int kMinSketchWidth = 256;
+const int kMaxSketchWidth = 64 * 1024;
+
+// The counters are halved after this many additions per counter of a row.
+const int kSampleSizeMultiplier = 10;
+
+int RoundUpToPowerOfTwo(int value) {
+  int result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+// Spreads the bits of |hash| over the whole value (the finalizer of
+// MurmurHash3).
+uint64 MixHash(uint64 hash) {
+  hash ^= hash >> 33;
+  hash *= GG_UINT64_C(0xff51afd7ed558ccd);
+  hash ^= hash >> 33;
+  hash *= GG_UINT64_C(0xc4ceb9fe1a85ec53);
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// The entries of a policy, on one or more lists, most recently used first.
+class EntryLists {
+ public:
+  explicit EntryLists(int num_lists)
+      : lists_(num_lists), list_sizes_(num_lists, 0), size_(0) {}
+
+  bool Has(uint64 entry_hash) const {
+    return nodes_.count(entry_hash) != 0;
+  }
+
+  // Returns the list of an entry that is here.
+  int GetList(uint64 entry_hash) const {
+    NodeMap::const_iterator it = nodes_.find(entry_hash);
+    DCHECK(it != nodes_.end());
+    return it->second.list;
+  }
+
+  int64 GetEntrySize(uint64 entry_hash) const {
+    NodeMap::const_iterator it = nodes_.find(entry_hash);
+    DCHECK(it != nodes_.end());
+    return it->second.size;
+  }
+
+  // Adds a new entry at the front of |list|.
+  void Add(uint64 entry_hash, int64 size, int list) {
+    DCHECK(!Has(entry_hash));
+    lists_[list].push_front(entry_hash);
+    Node node;
+    node.position = lists_[list].begin();
+    node.size = size;
+    node.list = list;
+    nodes_[entry_hash] = node;
+    list_sizes_[list] += size;
+    size_ += size;
+  }
+
+  // Moves an entry to the front of |list|.
+  void MoveToFront(uint64 entry_hash, int list) {
+    NodeMap::iterator it = nodes_.find(entry_hash);
+    DCHECK(it != nodes_.end());
+    Node& node = it->second;
+    lists_[list].splice(lists_[list].begin(), lists_[node.list],
+                        node.position);
+    list_sizes_[node.list] -= node.size;
+    list_sizes_[list] += node.size;
+    node.list = list;
+  }
+
+  void Resize(uint64 entry_hash, int64 size) {
+    NodeMap::iterator it = nodes_.find(entry_hash);
+    DCHECK(it != nodes_.end());
+    Node& node = it->second;
+    list_sizes_[node.list] += size - node.size;
+    size_ += size - node.size;
+    node.size = size;
+  }
+
+  void Remove(uint64 entry_hash) {
+    NodeMap::iterator it = nodes_.find(entry_hash);
+    if (it == nodes_.end())
+      return;
+    const Node& node = it->second;
+    lists_[node.list].erase(node.position);
+    list_sizes_[node.list] -= node.size;
+    size_ -= node.size;
+    nodes_.erase(it);
+  }
+
+  void Clear() {
+    nodes_.clear();
+    for (size_t i = 0; i < lists_.size(); i++) {
+      lists_[i].clear();
+      list_sizes_[i] = 0;
+    }
+    size_ = 0;
+  }
+
+  // Sets |entry_hash| to the least recently used entry of |list|. Returns
+  // false if the list is empty.
+  bool GetLast(int list, uint64* entry_hash) const {
+    if (lists_[list].empty())
+      return false;
+    *entry_hash = lists_[list].back();
+    return true;
+  }
+
+  // Appends the entries of |list| to |entry_hashes|, least recently used
+  // first, until |size| goes down to |target_size|.
+  void AppendOldest(int list, int64 target_size, int64* size,
+                    std::vector<uint64>* entry_hashes) const {
+    for (EntryList::const_reverse_iterator it = lists_[list].rbegin();
+         it != lists_[list].rend() && *size > target_size; ++it) {
+      entry_hashes->push_back(*it);
+      *size -= GetEntrySize(*it);
+    }
+  }
+
+  int64 list_size(int list) const { return list_sizes_[list]; }
+  int64 size() const { return size_; }
+
+ private:
+  typedef std::list<uint64> EntryList;
+  struct Node {
+    EntryList::iterator position;
+    int64 size;
+    int list;
+  };
+  typedef base::flat_hash_map<uint64, Node> NodeMap;
+
+  NodeMap nodes_;
+  std::vector<EntryList> lists_;
+  std::vector<int64> list_sizes_;  // Bytes on each list.
+  int64 size_;
+
+  DISALLOW_COPY_AND_ASSIGN(EntryLists);
+};
+
+class LruPolicy : public disk_cache::EvictionPolicy {
+ public:
+  LruPolicy() : entries_(1) {}
+
+  virtual void SetMaxSize(int64 max_bytes) OVERRIDE {}
+
+  virtual void OnEntryAdded(uint64 entry_hash, int64 size) OVERRIDE {
+    entries_.Remove(entry_hash);
+    entries_.Add(entry_hash, size, 0);
+  }
+
+  virtual void OnEntryLoaded(uint64 entry_hash, int64 size,
+                             EntryState state) OVERRIDE {
+    OnEntryAdded(entry_hash, size);
+  }
+
+  virtual void OnEntryUsed(uint64 entry_hash) OVERRIDE {
+    if (entries_.Has(entry_hash))
+      entries_.MoveToFront(entry_hash, 0);
+  }
+
+  virtual void OnEntryResized(uint64 entry_hash, int64 size) OVERRIDE {
+    if (entries_.Has(entry_hash))
+      entries_.Resize(entry_hash, size);
+  }
+
+  virtual void OnEntryRemoved(uint64 entry_hash) OVERRIDE {
+    entries_.Remove(entry_hash);
+  }
+
+  virtual void Clear() OVERRIDE {
+    entries_.Clear();
+  }
+
+  virtual int64 GetSize() const OVERRIDE {
+    return entries_.size();
+  }
+
+  virtual EntryState GetEntryState(uint64 entry_hash) const OVERRIDE {
+    return ENTRY_NEW;
+  }
+
+  virtual void SaveHistory(std::string* data) const OVERRIDE {
+    data->clear();
+  }
+
+  virtual bool LoadHistory(const std::string& data) OVERRIDE {
+    return data.empty();
+  }
+
+  virtual void GetEvictionCandidates(
+      int64 target_size, std::vector<uint64>* entry_hashes) const OVERRIDE {
+    int64 size = entries_.size();
+    entries_.AppendOldest(0, target_size, &size, entry_hashes);
+  }
+
+ private:
+  EntryLists entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LruPolicy);
+};
+
+class SegmentedLruPolicy : public disk_cache::EvictionPolicy {
+ public:
+  // In eviction order.
+  enum Segment {
+    COLD = 0,
+    PROBATION,
+    PROTECTED,
+    NUM_SEGMENTS
+  };
+
+  // Until the size of the cache is known, there are no limits.
+  SegmentedLruPolicy()
+      : entries_(NUM_SEGMENTS),
+        sketch_(new disk_cache::FrequencySketch(kMinSketchWidth)),
+        protected_limit_(kint64max),
+        large_entry_size_(kint64max) {}
+
+  virtual void SetMaxSize(int64 max_bytes) OVERRIDE {
+    protected_limit_ = max_bytes / 100 * kProtectedPercent;
+    large_entry_size_ = std::max(kMinLargeEntrySize,
+                                 max_bytes / kLargeEntryDivisor);
+
+    int64 width = max_bytes / kAverageEntrySize;
+    width = std::min(std::max(width, static_cast<int64>(kMinSketchWidth)),
+                     static_cast<int64>(kMaxSketchWidth));
+    int sketch_width = RoundUpToPowerOfTwo(static_cast<int>(width));
+    if (sketch_width != sketch_->width())
+      sketch_.reset(new disk_cache::FrequencySketch(sketch_width));
+
+    DemoteProtected();
+  }
+
+  virtual void OnEntryAdded(uint64 entry_hash, int64 size) OVERRIDE {
+    sketch_->Increment(entry_hash);
+    entries_.Remove(entry_hash);
+    entries_.Add(entry_hash, size, PROBATION);
+    AdmitOrReject(entry_hash);
+  }
+
+  virtual void OnEntryLoaded(uint64 entry_hash, int64 size,
+                             EntryState state) OVERRIDE {
+    entries_.Remove(entry_hash);
+    if (state == ENTRY_REUSED) {
+      entries_.Add(entry_hash, size, PROTECTED);
+      DemoteProtected();
+    } else {
+      entries_.Add(entry_hash, size, state == ENTRY_COLD ? COLD : PROBATION);
+    }
+  }
+
+  virtual void OnEntryUsed(uint64 entry_hash) OVERRIDE {
+    if (!entries_.Has(entry_hash))
+      return;
+    sketch_->Increment(entry_hash);
+    entries_.MoveToFront(entry_hash, PROTECTED);
+    DemoteProtected();
+  }
+
+  virtual void OnEntryResized(uint64 entry_hash, int64 size) OVERRIDE {
+    if (!entries_.Has(entry_hash))
+      return;
+    entries_.Resize(entry_hash, size);
+    if (entries_.GetList(entry_hash) == PROTECTED)
+      DemoteProtected();
+    else if (entries_.GetList(entry_hash) == PROBATION)
+      AdmitOrReject(entry_hash);
+  }
+
+  virtual void OnEntryRemoved(uint64 entry_hash) OVERRIDE {
+    entries_.Remove(entry_hash);
+  }
+
+  virtual void Clear() OVERRIDE {
+    entries_.Clear();
+  }
+
+  virtual int64 GetSize() const OVERRIDE {
+    return entries_.size();
+  }
+
+  virtual EntryState GetEntryState(uint64 entry_hash) const OVERRIDE {
+    if (!entries_.Has(entry_hash))
+      return ENTRY_NEW;
+    switch (entries_.GetList(entry_hash)) {
+      case COLD:
+        return ENTRY_COLD;
+      case PROTECTED:
+        return ENTRY_REUSED;
+      default:
+        return ENTRY_NEW;
+    }
+  }
+
+  virtual void SaveHistory(std::string* data) const OVERRIDE {
+    sketch_->Serialize(data);
+  }
+
+  virtual bool LoadHistory(const std::string& data) OVERRIDE {
+    return sketch_->Merge(data);
+  }
+
+  virtual void GetEvictionCandidates(
+      int64 target_size, std::vector<uint64>* entry_hashes) const OVERRIDE {
+    int64 size = entries_.size();
+    for (int i = 0; i < NUM_SEGMENTS; i++)
+      entries_.AppendOldest(i, target_size, &size, entry_hashes);
+  }
+
+ private:
+  // Sends a large entry on PROBATION to the COLD list, unless it was used
+  // more often than the next entry to be evicted from PROBATION.
+  void AdmitOrReject(uint64 entry_hash) {
+    if (entries_.GetEntrySize(entry_hash) <= large_entry_size_)
+      return;
+
+    // With nothing to compare to, the entry has to be seen twice.
+    int victim_frequency = 1;
+    uint64 victim;
+    if (entries_.GetLast(PROBATION, &victim) && victim != entry_hash)
+      victim_frequency = sketch_->Estimate(victim);
+
+    if (sketch_->Estimate(entry_hash) <= victim_frequency)
+      entries_.MoveToFront(entry_hash, COLD);
+  }
+
+  // Moves the oldest PROTECTED entries back to PROBATION until the segment
+  // fits in its limit.
+  void DemoteProtected() {
+    uint64 entry_hash;
+    while (entries_.list_size(PROTECTED) > protected_limit_ &&
+           entries_.GetLast(PROTECTED, &entry_hash)) {
+      entries_.MoveToFront(entry_hash, PROBATION);
+    }
+  }
+
+  EntryLists entries_;
+  scoped_ptr<disk_cache::FrequencySketch> sketch_;
+  int64 protected_limit_;
+  int64 large_entry_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentedLruPolicy);
+};
+
+}  // namespace
+
+namespace disk_cache {
+
+FrequencySketch::FrequencySketch(int width)
+    : width_(RoundUpToPowerOfTwo(std::max(width, 1))),
+      additions_(0),
+      sample_size_(width_ * kSampleSizeMultiplier),
+      counters_(kRows * width_, 0) {
+}
+
+FrequencySketch::~FrequencySketch() {
+}
+
+void FrequencySketch::Increment(uint64 entry_hash) {
+  bool added = false;
+  for (int row = 0; row < kRows; row++) {
+    uint8& counter = counters_[GetIndex(entry_hash, row)];
+    if (counter < kMaxCount) {
+      counter++;
+      added = true;
+    }
+  }
+  if (added && ++additions_ >= sample_size_)
+    Age();
+}
+
+int FrequencySketch::Estimate(uint64 entry_hash) const {
+  int estimate = kMaxCount;
+  for (int row = 0; row < kRows; row++) {
+    estimate = std::min(estimate,
+                        static_cast<int>(counters_[GetIndex(entry_hash, row)]));
+  }
+  return estimate;
+}
+
+void FrequencySketch::Serialize(std::string* data) const {
+  Pickle pickle;
+  pickle.WriteInt(width_);
+  pickle.WriteInt(additions_);
+  pickle.WriteData(reinterpret_cast<const char*>(&counters_[0]),
+                   static_cast<int>(counters_.size()));
+  data->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+bool FrequencySketch::Merge(const std::string& data) {
+  Pickle pickle(data.data(), static_cast<int>(data.size()));
+  void* iter = NULL;
+  int width;
+  int additions;
+  const char* counters;
+  int length;
+  if (!pickle.ReadInt(&iter, &width) || width != width_ ||
+      !pickle.ReadInt(&iter, &additions) || additions < 0 ||
+      additions >= sample_size_ ||
+      !pickle.ReadData(&iter, &counters, &length) ||
+      length != static_cast<int>(counters_.size())) {
+    return false;
+  }
+
+  for (int i = 0; i < length; i++) {
+    int counter = counters_[i] + static_cast<uint8>(counters[i]);
+    counters_[i] = static_cast<uint8>(std::min(counter, kMaxCount));
+  }
+  additions_ += additions;
+  if (additions_ >= sample_size_)
+    Age();
+  return true;
+}
+
+int FrequencySketch::GetIndex(uint64 entry_hash, int row) const {
+  // Every row uses a different hash of the key.
+  uint64 hash = MixHash(entry_hash + row * GG_UINT64_C(0x9e3779b97f4a7c15));
+  return row * width_ + static_cast<int>(hash & (width_ - 1));
+}
+
+void FrequencySketch::Age() {
+  for (size_t i = 0; i < counters_.size(); i++)
+    counters_[i] >>= 1;
+  additions_ /= 2;
+}
+
+// static
+EvictionPolicy* EvictionPolicy::Create(Type type) {
+  switch (type) {
+    case LRU:
+      return new LruPolicy();
+    case SEGMENTED_LRU:
+      return new SegmentedLruPolicy();
+  }
+  NOTREACHED();
+  return NULL;
+}
+
+}  // namespace disk_cache
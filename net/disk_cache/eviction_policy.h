@@ -0,0 +1,150 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The eviction policies for caches that keep their list of entries in memory.
+// The block file cache can use them too (see net/disk_cache/eviction.h).
+
+#ifndef NET_DISK_CACHE_EVICTION_POLICY_H_
+#define NET_DISK_CACHE_EVICTION_POLICY_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "net/base/net_export.h"
+
+namespace disk_cache {
+
+// This class estimates how many times each entry was used recently, with a
+// count-min sketch: every entry maps to one small counter on each of a few
+// rows, and the estimate is the lowest of those counters. Entries that share
+// counters can only make the estimate too high. The counters are halved after
+// a number of uses proportional to the size of the sketch, so that the
+// estimates follow what is popular now, and they saturate at kMaxCount.
+//
+// The sketch remembers entries after they are evicted, which is what lets an
+// eviction policy tell an entry that keeps coming back from a one-shot fetch.
+class NET_EXPORT_PRIVATE FrequencySketch {
+ public:
+  static const int kMaxCount = 15;
+
+  // |width| is the number of counters per row, rounded up to a power of two;
+  // it should be about the number of entries to track.
+  explicit FrequencySketch(int width);
+  ~FrequencySketch();
+
+  // Records one use of |entry_hash|.
+  void Increment(uint64 entry_hash);
+
+  // Returns how many times |entry_hash| was used, give or take.
+  int Estimate(uint64 entry_hash) const;
+
+  // Saves the counters to |data|.
+  void Serialize(std::string* data) const;
+
+  // Adds the counters saved by Serialize() to this sketch, which must have the
+  // same width. Returns false if |data| is not usable.
+  bool Merge(const std::string& data);
+
+  int width() const { return width_; }
+
+ private:
+  static const int kRows = 4;
+
+  int GetIndex(uint64 entry_hash, int row) const;
+
+  // Halves every counter.
+  void Age();
+
+  int width_;
+  int additions_;
+  int sample_size_;  // How many additions trigger Age().
+  std::vector<uint8> counters_;  // kRows rows of |width_| counters.
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
+// This interface decides which entries of a cache go first when the cache is
+// too big. The cache tells the policy about every entry it adds, uses, resizes
+// and removes, and asks for the entries to evict when it needs room; the
+// policy never removes an entry by itself.
+//
+// Entries are identified by a 64 bit value that the cache picks, like the
+// hash of their key.
+class NET_EXPORT_PRIVATE EvictionPolicy {
+ public:
+  enum Type {
+    // Evicts the least recently used entries.
+    LRU,
+    // Keeps reused entries on a protected segment, away from bursts of new
+    // entries, and evicts large entries that are not likely to be used again
+    // before anything else. See eviction_policy.cc for the details.
+    SEGMENTED_LRU
+  };
+
+  // What a policy keeps about an entry from one run to the next, besides its
+  // place in the order of use. The values are saved to disk.
+  enum EntryState {
+    // The entry was not used since it was stored, or nothing is known about
+    // it.
+    ENTRY_NEW = 0,
+    // The entry was used again after it was stored.
+    ENTRY_REUSED = 1,
+    // The entry goes before the others, whatever its age.
+    ENTRY_COLD = 2,
+    ENTRY_STATE_MAX
+  };
+
+  // Returns a new policy of the given |type|.
+  static EvictionPolicy* Create(Type type);
+
+  virtual ~EvictionPolicy() {}
+
+  // Sets the size of the cache, that some policies use to size their
+  // thresholds.
+  virtual void SetMaxSize(int64 max_bytes) = 0;
+
+  // Adds an entry of |size| bytes, new or found on disk. Entries are added as
+  // the most recently used entry.
+  virtual void OnEntryAdded(uint64 entry_hash, int64 size) = 0;
+
+  // Adds an entry stored on an earlier run, as the most recently used entry,
+  // in the |state| that GetEntryState() returned then. Unlike OnEntryAdded(),
+  // this doesn't count as a use.
+  virtual void OnEntryLoaded(uint64 entry_hash, int64 size,
+                             EntryState state) = 0;
+
+  // An entry was opened or otherwise used.
+  virtual void OnEntryUsed(uint64 entry_hash) = 0;
+
+  virtual void OnEntryResized(uint64 entry_hash, int64 size) = 0;
+  virtual void OnEntryRemoved(uint64 entry_hash) = 0;
+
+  // Forgets every entry. What was learned about the use of the entries, if
+  // anything, is kept.
+  virtual void Clear() = 0;
+
+  // Returns the size of all the entries.
+  virtual int64 GetSize() const = 0;
+
+  // Returns the state of an entry, to save for the next run.
+  virtual EntryState GetEntryState(uint64 entry_hash) const = 0;
+
+  // Saves what was learned about the use of the entries, including the ones
+  // that are gone, to |data|. The next run adds it back with LoadHistory(),
+  // after SetMaxSize(). Returns false if |data| is not usable.
+  virtual void SaveHistory(std::string* data) const = 0;
+  virtual bool LoadHistory(const std::string& data) = 0;
+
+  // Returns the entries to remove for the cache to fit in |target_size|, in
+  // the order they should go. The cache may keep some of them, if they are in
+  // use.
+  virtual void GetEvictionCandidates(
+      int64 target_size, std::vector<uint64>* entry_hashes) const = 0;
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_EVICTION_POLICY_H_
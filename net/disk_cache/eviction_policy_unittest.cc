@@ -0,0 +1,243 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "net/disk_cache/eviction_policy.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using disk_cache::EvictionPolicy;
+using disk_cache::FrequencySketch;
+
+namespace {
+
+const int64 kMaxSize = 1024 * 1024;
+const int64 kSmallSize = 10 * 1024;
+const int64 kLargeSize = 100 * 1024;
+
+bool Contains(const std::vector<uint64>& entry_hashes, uint64 entry_hash) {
+  return std::find(entry_hashes.begin(), entry_hashes.end(), entry_hash) !=
+         entry_hashes.end();
+}
+
+// Adds the entries |first| to |last| with |size| bytes, the way a cache does
+// it: empty first, and then with their data.
+void AddEntries(EvictionPolicy* policy, uint64 first, uint64 last,
+                int64 size) {
+  for (uint64 i = first; i <= last; i++) {
+    policy->OnEntryAdded(i, 0);
+    policy->OnEntryResized(i, size);
+  }
+}
+
+}  // namespace
+
+TEST(DiskCacheEvictionPolicyTest, FrequencySketch) {
+  FrequencySketch sketch(1000);
+  EXPECT_EQ(1024, sketch.width());
+  EXPECT_EQ(0, sketch.Estimate(1));
+
+  sketch.Increment(1);
+  sketch.Increment(1);
+  sketch.Increment(2);
+  EXPECT_EQ(2, sketch.Estimate(1));
+  EXPECT_EQ(1, sketch.Estimate(2));
+
+  // The counters saturate.
+  for (int i = 0; i < 2 * FrequencySketch::kMaxCount; i++)
+    sketch.Increment(3);
+  EXPECT_EQ(FrequencySketch::kMaxCount, sketch.Estimate(3));
+
+  // And they are halved once in a while, so old uses count less.
+  uint64 key = 100;
+  while (sketch.Estimate(3) == FrequencySketch::kMaxCount && key < 100000)
+    sketch.Increment(key++);
+  EXPECT_EQ(FrequencySketch::kMaxCount / 2, sketch.Estimate(3));
+}
+
+TEST(DiskCacheEvictionPolicyTest, FrequencySketchMerge) {
+  FrequencySketch sketch(1000);
+  sketch.Increment(1);
+  sketch.Increment(1);
+  std::string data;
+  sketch.Serialize(&data);
+
+  FrequencySketch other(1000);
+  other.Increment(1);
+  ASSERT_TRUE(other.Merge(data));
+  EXPECT_EQ(3, other.Estimate(1));
+  EXPECT_EQ(0, other.Estimate(2));
+
+  // Only a sketch of the same width can use the counters.
+  FrequencySketch smaller(100);
+  EXPECT_FALSE(smaller.Merge(data));
+  EXPECT_FALSE(other.Merge(std::string()));
+  EXPECT_FALSE(other.Merge(data.substr(0, data.size() - 1)));
+}
+
+TEST(DiskCacheEvictionPolicyTest, Lru) {
+  scoped_ptr<EvictionPolicy> policy(
+      EvictionPolicy::Create(EvictionPolicy::LRU));
+  AddEntries(policy.get(), 1, 4, kSmallSize);
+  EXPECT_EQ(4 * kSmallSize, policy->GetSize());
+
+  policy->OnEntryUsed(1);
+  policy->OnEntryRemoved(3);
+  EXPECT_EQ(3 * kSmallSize, policy->GetSize());
+
+  std::vector<uint64> candidates;
+  policy->GetEvictionCandidates(3 * kSmallSize, &candidates);
+  EXPECT_TRUE(candidates.empty());
+
+  policy->GetEvictionCandidates(kSmallSize, &candidates);
+  ASSERT_EQ(2U, candidates.size());
+  EXPECT_EQ(2U, candidates[0]);
+  EXPECT_EQ(4U, candidates[1]);
+
+  policy->Clear();
+  EXPECT_EQ(0, policy->GetSize());
+}
+
+// Reused entries are not flushed out by a burst of new entries.
+TEST(DiskCacheEvictionPolicyTest, SegmentedLruScan) {
+  scoped_ptr<EvictionPolicy> policy(
+      EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  scoped_ptr<EvictionPolicy> lru(EvictionPolicy::Create(EvictionPolicy::LRU));
+  policy->SetMaxSize(kMaxSize);
+  lru->SetMaxSize(kMaxSize);
+
+  // Ten entries used a few times, and forty used once.
+  EvictionPolicy* policies[] = { policy.get(), lru.get() };
+  for (size_t i = 0; i < arraysize(policies); i++) {
+    AddEntries(policies[i], 1, 10, kSmallSize);
+    for (uint64 j = 1; j <= 10; j++) {
+      policies[i]->OnEntryUsed(j);
+      policies[i]->OnEntryUsed(j);
+    }
+    AddEntries(policies[i], 11, 50, kSmallSize);
+  }
+
+  std::vector<uint64> candidates;
+  policy->GetEvictionCandidates(20 * kSmallSize, &candidates);
+  EXPECT_EQ(30U, candidates.size());
+  for (uint64 i = 1; i <= 10; i++)
+    EXPECT_FALSE(Contains(candidates, i));
+
+  // LRU evicts the reused entries first.
+  candidates.clear();
+  lru->GetEvictionCandidates(20 * kSmallSize, &candidates);
+  for (uint64 i = 1; i <= 10; i++)
+    EXPECT_TRUE(Contains(candidates, i));
+}
+
+// Large entries used once go before anything else, unless they come back.
+TEST(DiskCacheEvictionPolicyTest, SegmentedLruAdmission) {
+  scoped_ptr<EvictionPolicy> policy(
+      EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  policy->SetMaxSize(kMaxSize);
+
+  AddEntries(policy.get(), 1, 10, kSmallSize);
+  AddEntries(policy.get(), 11, 11, kLargeSize);
+
+  // Entry 12 was in the cache before, and was evicted.
+  AddEntries(policy.get(), 12, 12, kLargeSize);
+  policy->OnEntryRemoved(12);
+  AddEntries(policy.get(), 12, 12, kLargeSize);
+
+  std::vector<uint64> candidates;
+  policy->GetEvictionCandidates(policy->GetSize() - kLargeSize, &candidates);
+  ASSERT_EQ(1U, candidates.size());
+  EXPECT_EQ(11U, candidates[0]);
+
+  // Next, the oldest small entries, before the large entry that came back.
+  candidates.clear();
+  policy->GetEvictionCandidates(policy->GetSize() - kLargeSize - kSmallSize,
+                                &candidates);
+  ASSERT_EQ(2U, candidates.size());
+  EXPECT_EQ(11U, candidates[0]);
+  EXPECT_EQ(1U, candidates[1]);
+
+  // Without the size of the cache, no entry is large.
+  policy.reset(EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  AddEntries(policy.get(), 1, 1, kSmallSize);
+  AddEntries(policy.get(), 2, 2, 10 * kLargeSize);
+  candidates.clear();
+  policy->GetEvictionCandidates(policy->GetSize() - 1, &candidates);
+  ASSERT_EQ(1U, candidates.size());
+  EXPECT_EQ(1U, candidates[0]);
+}
+
+// The protected segment takes at most 80% of the cache.
+TEST(DiskCacheEvictionPolicyTest, SegmentedLruProtectedLimit) {
+  scoped_ptr<EvictionPolicy> policy(
+      EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  policy->SetMaxSize(10 * kSmallSize);
+
+  AddEntries(policy.get(), 1, 10, kSmallSize);
+  for (uint64 i = 1; i <= 10; i++)
+    policy->OnEntryUsed(i);
+
+  // Entries 1 and 2 don't fit on the protected segment.
+  std::vector<uint64> candidates;
+  policy->GetEvictionCandidates(8 * kSmallSize, &candidates);
+  ASSERT_EQ(2U, candidates.size());
+  EXPECT_EQ(1U, candidates[0]);
+  EXPECT_EQ(2U, candidates[1]);
+
+  // A smaller cache has a smaller protected segment.
+  policy->SetMaxSize(5 * kSmallSize);
+  candidates.clear();
+  policy->GetEvictionCandidates(4 * kSmallSize, &candidates);
+  ASSERT_EQ(6U, candidates.size());
+  EXPECT_EQ(1U, candidates[0]);
+  EXPECT_EQ(6U, candidates[5]);
+}
+
+// The segments of the entries and the history of their use survive a restart.
+TEST(DiskCacheEvictionPolicyTest, SegmentedLruRestart) {
+  scoped_ptr<EvictionPolicy> policy(
+      EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  policy->SetMaxSize(kMaxSize);
+  AddEntries(policy.get(), 1, 2, kSmallSize);
+  policy->OnEntryUsed(1);
+  AddEntries(policy.get(), 3, 3, kLargeSize);
+
+  // Entry 4 was evicted.
+  AddEntries(policy.get(), 4, 4, kLargeSize);
+  policy->OnEntryRemoved(4);
+
+  EXPECT_EQ(EvictionPolicy::ENTRY_REUSED, policy->GetEntryState(1));
+  EXPECT_EQ(EvictionPolicy::ENTRY_NEW, policy->GetEntryState(2));
+  EXPECT_EQ(EvictionPolicy::ENTRY_COLD, policy->GetEntryState(3));
+  EXPECT_EQ(EvictionPolicy::ENTRY_NEW, policy->GetEntryState(4));
+  std::string history;
+  policy->SaveHistory(&history);
+
+  scoped_ptr<EvictionPolicy> restarted(
+      EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU));
+  restarted->SetMaxSize(kMaxSize);
+  ASSERT_TRUE(restarted->LoadHistory(history));
+  restarted->OnEntryLoaded(2, kSmallSize, EvictionPolicy::ENTRY_NEW);
+  restarted->OnEntryLoaded(3, kLargeSize, EvictionPolicy::ENTRY_COLD);
+  restarted->OnEntryLoaded(1, kSmallSize, EvictionPolicy::ENTRY_REUSED);
+  for (uint64 i = 1; i <= 3; i++)
+    EXPECT_EQ(policy->GetEntryState(i), restarted->GetEntryState(i));
+  EXPECT_EQ(policy->GetSize(), restarted->GetSize());
+
+  // Loading entries doesn't count as using them, but the history remembers
+  // entry 4, so it is admitted when it comes back.
+  AddEntries(restarted.get(), 4, 4, kLargeSize);
+  EXPECT_EQ(EvictionPolicy::ENTRY_NEW, restarted->GetEntryState(4));
+
+  std::vector<uint64> candidates;
+  restarted->GetEvictionCandidates(
+      restarted->GetSize() - kLargeSize - kSmallSize, &candidates);
+  ASSERT_EQ(2U, candidates.size());
+  EXPECT_EQ(3U, candidates[0]);
+  EXPECT_EQ(2U, candidates[1]);
+}
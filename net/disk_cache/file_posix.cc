@@ -7,8 +7,10 @@
 #include <fcntl.h>
 
 #include "base/bind.h"
+#include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/threading/thread_local.h"
 #include "base/threading/worker_pool.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/disk_cache.h"
@@ -146,22 +148,26 @@ void FileInFlightIO::OnOperationComplete(disk_cache::BackgroundIO* operation,
   callback->OnFileIOComplete(bytes);
 }
 
-// A static object tha will broker all async operations.
-FileInFlightIO* s_file_operations = NULL;
+// The objects that broker all async operations, one per thread that starts
+// them, so that each cache thread gets its own completions back.
+base::LazyInstance<base::ThreadLocalPointer<FileInFlightIO> >::Leaky
+    s_file_operations = LAZY_INSTANCE_INITIALIZER;
 
 // Returns the current FileInFlightIO.
 FileInFlightIO* GetFileInFlightIO() {
-  if (!s_file_operations) {
-    s_file_operations = new FileInFlightIO;
+  FileInFlightIO* file_operations = s_file_operations.Get().Get();
+  if (!file_operations) {
+    file_operations = new FileInFlightIO;
+    s_file_operations.Get().Set(file_operations);
   }
-  return s_file_operations;
+  return file_operations;
 }
 
 // Deletes the current FileInFlightIO.
 void DeleteFileInFlightIO() {
-  DCHECK(s_file_operations);
-  delete s_file_operations;
-  s_file_operations = NULL;
+  DCHECK(s_file_operations.Get().Get());
+  delete s_file_operations.Get().Get();
+  s_file_operations.Get().Set(NULL);
 }
 
 }  // namespace
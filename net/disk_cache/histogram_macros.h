@@ -17,17 +17,21 @@
 // These histograms follow the definition of UMA_HISTOGRAMN_XXX except that
 // whenever the name changes (the experiment group changes), the histrogram
 // object is re-created.
-// Note: These macros are only run on one thread, so the declarations of
-// |counter| was made static (i.e., there will be no race for reinitialization).
+// Note: |counter| only remembers the last histogram used. The cache threads of
+// a sharded backend may replace it at the same time, so each use reads it once
+// into |histogram| and adds the sample there.
 
 #define CACHE_HISTOGRAM_CUSTOM_COUNTS(name, sample, min, max, bucket_count) \
     do { \
       static base::Histogram* counter(NULL); \
-      if (!counter || name != counter->histogram_name()) \
-        counter = base::Histogram::FactoryGet( \
+      base::Histogram* histogram = counter; \
+      if (!histogram || name != histogram->histogram_name()) { \
+        histogram = base::Histogram::FactoryGet( \
             name, min, max, bucket_count, \
             base::Histogram::kUmaTargetedHistogramFlag); \
-      counter->Add(sample); \
+        counter = histogram; \
+      } \
+      histogram->Add(sample); \
     } while (0)
 
 #define CACHE_HISTOGRAM_COUNTS(name, sample) CACHE_HISTOGRAM_CUSTOM_COUNTS( \
@@ -42,11 +46,14 @@
 #define CACHE_HISTOGRAM_CUSTOM_TIMES(name, sample, min, max, bucket_count) \
     do { \
       static base::Histogram* counter(NULL); \
-      if (!counter || name != counter->histogram_name()) \
-        counter = base::Histogram::FactoryTimeGet( \
+      base::Histogram* histogram = counter; \
+      if (!histogram || name != histogram->histogram_name()) { \
+        histogram = base::Histogram::FactoryTimeGet( \
             name, min, max, bucket_count, \
             base::Histogram::kUmaTargetedHistogramFlag); \
-      counter->AddTime(sample); \
+        counter = histogram; \
+      } \
+      histogram->AddTime(sample); \
     } while (0)
 
 #define CACHE_HISTOGRAM_TIMES(name, sample) CACHE_HISTOGRAM_CUSTOM_TIMES( \
@@ -55,11 +62,14 @@
 
 #define CACHE_HISTOGRAM_ENUMERATION(name, sample, boundary_value) do { \
     static base::Histogram* counter(NULL); \
-    if (!counter || name != counter->histogram_name()) \
-      counter = base::LinearHistogram::FactoryGet( \
-                    name, 1, boundary_value, boundary_value + 1, \
-                    base::Histogram::kUmaTargetedHistogramFlag); \
-    counter->Add(sample); \
+    base::Histogram* histogram = counter; \
+    if (!histogram || name != histogram->histogram_name()) { \
+      histogram = base::LinearHistogram::FactoryGet( \
+                      name, 1, boundary_value, boundary_value + 1, \
+                      base::Histogram::kUmaTargetedHistogramFlag); \
+      counter = histogram; \
+    } \
+    histogram->Add(sample); \
   } while (0)
 
 #define CACHE_HISTOGRAM_PERCENTAGE(name, under_one_hundred) \
@@ -8,6 +8,7 @@
 #define NET_DISK_CACHE_MAPPED_FILE_H_
 #pragma once
 
+#include "base/memory/scoped_ptr.h"
 #include "net/base/net_export.h"
 #include "net/disk_cache/disk_format.h"
 #include "net/disk_cache/file.h"
@@ -15,6 +16,10 @@
 
 class FilePath;
 
+namespace file_util {
+class MemoryMappedFile;
+}
+
 namespace disk_cache {
 
 // This class implements a memory mapped file used to access block-files. The
@@ -23,7 +28,7 @@ namespace disk_cache {
 // time).
 class NET_EXPORT_PRIVATE MappedFile : public File {
  public:
-  MappedFile() : File(true), init_(false) {}
+  MappedFile();
 
   // Performs object initialization. name is the file to use, and size is the
   // ammount of data to memory map from th efile. If size is 0, the whole file
@@ -44,6 +49,8 @@ class NET_EXPORT_PRIVATE MappedFile : public File {
   bool init_;
 #if defined(OS_WIN)
   HANDLE section_;
+#else
+  scoped_ptr<file_util::MemoryMappedFile> map_;
 #endif
   void* buffer_;  // Address of the memory mapped buffer.
   size_t view_size_;  // Size of the memory pointed by buffer_.
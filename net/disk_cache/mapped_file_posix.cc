@@ -4,15 +4,19 @@
 
 #include "net/disk_cache/mapped_file.h"
 
-#include <errno.h>
-#include <sys/mman.h>
+#include <unistd.h>
 
+#include "base/eintr_wrapper.h"
 #include "base/file_path.h"
+#include "base/file_util.h"
 #include "base/logging.h"
 #include "net/disk_cache/disk_cache.h"
 
 namespace disk_cache {
 
+MappedFile::MappedFile() : File(true), init_(false) {
+}
+
 void* MappedFile::Init(const FilePath& name, size_t size) {
   DCHECK(!init_);
   if (init_ || !File::Init(name))
@@ -21,14 +25,35 @@ void* MappedFile::Init(const FilePath& name, size_t size) {
   if (!size)
     size = GetLength();
 
-  buffer_ = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
-                 platform_file(), 0);
+  buffer_ = NULL;
   init_ = true;
-  DCHECK(reinterpret_cast<intptr_t>(buffer_) != -1);
-  if (reinterpret_cast<intptr_t>(buffer_) == -1)
-    buffer_ = 0;
-
   view_size_ = size;
+
+  // MemoryMappedFile only maps what the file holds.  Grow a shorter file to
+  // |size|, as CreateFileMapping() does in the Windows version, so that the
+  // whole buffer can be used.
+  if (GetLength() < size && !SetLength(size))
+    return NULL;
+
+  // The mapping gets its own descriptor, since MemoryMappedFile closes the
+  // one it is given.
+  int fd = HANDLE_EINTR(dup(platform_file()));
+  if (fd < 0)
+    return NULL;
+  const file_util::MemoryMappedFile::Region region = {
+    0, static_cast<int64>(size)
+  };
+  map_.reset(new file_util::MemoryMappedFile);
+  if (!map_->Initialize(fd, region,
+                        file_util::MemoryMappedFile::READ_WRITE)) {
+    map_.reset();
+    return NULL;
+  }
+
+  // The mapped part is the index or a block file's header and bitmap, which
+  // are used all the time.  Read it in ahead of the first lookups.
+  map_->Prefetch(0, size);
+  buffer_ = map_->writable_data();
   return buffer_;
 }
 
@@ -43,13 +68,6 @@ bool MappedFile::Store(const FileBlock* block) {
 }
 
 MappedFile::~MappedFile() {
-  if (!init_)
-    return;
-
-  if (buffer_) {
-    int ret = munmap(buffer_, view_size_);
-    DCHECK_EQ(0, ret);
-  }
 }
 
 }  // namespace disk_cache
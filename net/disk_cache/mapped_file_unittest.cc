@@ -56,6 +56,18 @@ TEST_F(DiskCacheTest, MappedFile_SyncIO) {
   EXPECT_STREQ(buffer1, buffer2);
 }
 
+// Mapping more than the file holds grows the file.
+TEST_F(DiskCacheTest, MappedFile_ShortFile) {
+  FilePath filename = cache_path_.AppendASCII("a_test");
+  ASSERT_EQ(4, file_util::WriteFile(filename, "data", 4));
+  scoped_refptr<disk_cache::MappedFile> file(new disk_cache::MappedFile);
+  char* buffer = reinterpret_cast<char*>(file->Init(filename, 8192));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(8192u, file->GetLength());
+  EXPECT_EQ(0, memcmp(buffer, "data", 4));
+  buffer[8191] = 'x';
+}
+
 TEST_F(DiskCacheTest, MappedFile_AsyncIO) {
   FilePath filename = cache_path_.AppendASCII("a_test");
   scoped_refptr<disk_cache::MappedFile> file(new disk_cache::MappedFile);
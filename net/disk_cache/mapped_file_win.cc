@@ -11,6 +11,9 @@
 
 namespace disk_cache {
 
+MappedFile::MappedFile() : File(true), init_(false) {
+}
+
 void* MappedFile::Init(const FilePath& name, size_t size) {
   DCHECK(!init_);
   if (init_ || !File::Init(name))
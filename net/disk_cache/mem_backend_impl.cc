@@ -32,10 +32,13 @@ MemBackendImpl::MemBackendImpl(net::NetLog* net_log)
     : max_size_(0), current_size_(0), net_log_(net_log) {}
 
 MemBackendImpl::~MemBackendImpl() {
+  // Dooming an entry erases only that entry from |entries_|, which leaves
+  // the other iterators valid.
   EntryMap::iterator it = entries_.begin();
   while (it != entries_.end()) {
-    it->second->Doom();
-    it = entries_.begin();
+    MemEntryImpl* entry = it->second;
+    ++it;
+    entry->Doom();
   }
   DCHECK(!current_size_);
 }
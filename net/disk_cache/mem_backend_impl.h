@@ -9,7 +9,7 @@
 #pragma once
 
 #include "base/compiler_specific.h"
-#include "base/hash_tables.h"
+#include "base/flat_hash_tables.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/mem_rankings.h"
 
@@ -86,7 +86,7 @@ class NET_EXPORT_PRIVATE MemBackendImpl : public Backend {
   virtual void OnExternalCacheHit(const std::string& key) OVERRIDE;
 
  private:
-  typedef base::hash_map<std::string, MemEntryImpl*> EntryMap;
+  typedef base::flat_hash_map<std::string, MemEntryImpl*> EntryMap;
 
   // Old Backend interface.
   bool OpenEntry(const std::string& key, Entry** entry);
@@ -0,0 +1,348 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/sharded_backend.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "base/stl_util.h"
+#include "base/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/threading/thread.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/hash.h"
+
+namespace {
+
+// The size split among the shards when the caller doesn't set one.
+const int kDefaultCacheSize = 80 * 1024 * 1024;
+
+// More cache threads than this mostly wait for the disk.
+const int kMaxDefaultShards = 4;
+
+void OnBackendCreated(disk_cache::ShardedBackend* cache,
+                      disk_cache::Backend** backend,
+                      const net::CompletionCallback& callback,
+                      int result) {
+  if (result == net::OK) {
+    *backend = cache;
+  } else {
+    LOG(ERROR) << "Unable to create cache";
+    *backend = NULL;
+    delete cache;
+  }
+  callback.Run(result);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// Collects the results of an operation sent to all the shards, and reports
+// the first error, if any, once the last shard is done. The shards' callbacks
+// hold the references, so a Barrier whose callbacks are cancelled goes away
+// with them.
+class ShardedBackend::Barrier
+    : public base::RefCountedThreadSafe<ShardedBackend::Barrier> {
+ public:
+  explicit Barrier(const net::CompletionCallback& callback)
+      : callback_(callback), pending_(1), result_(net::OK) {
+  }
+
+  // Returns the callback for one more shard operation.
+  net::CompletionCallback AddShard() {
+    pending_++;
+    return base::Bind(&Barrier::OnShardComplete, this);
+  }
+
+  // Takes the result of a shard operation that completed synchronously.
+  void OnShardResult(int result) {
+    DCHECK_NE(net::ERR_IO_PENDING, result);
+    RecordResult(result);
+    pending_--;
+  }
+
+  // Called once every shard has its operation. Returns the final result, or
+  // ERR_IO_PENDING if the callback will get it.
+  int Done() {
+    if (--pending_)
+      return net::ERR_IO_PENDING;
+    callback_.Reset();
+    return result_;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<Barrier>;
+  ~Barrier() {}
+
+  void RecordResult(int result) {
+    if (result != net::OK && result_ == net::OK)
+      result_ = result;
+  }
+
+  void OnShardComplete(int result) {
+    RecordResult(result);
+    if (!--pending_)
+      callback_.Run(result_);
+  }
+
+  net::CompletionCallback callback_;
+  int pending_;
+  int result_;
+
+  DISALLOW_COPY_AND_ASSIGN(Barrier);
+};
+
+// The state of an enumeration: the shard being walked, and its iterator.
+struct ShardedBackend::Iterator {
+  Iterator() : shard(0), shard_iter(NULL) {}
+
+  int shard;
+  void* shard_iter;
+};
+
+ShardedBackend::ShardedBackend(const FilePath& path, int num_shards,
+                               net::NetLog* net_log)
+    : path_(path),
+      num_shards_(num_shards),
+      net_log_(net_log),
+      force_(false),
+      shard_max_bytes_(0),
+      type_(net::DISK_CACHE),
+      flags_(0),
+      new_shard_(NULL) {
+  DCHECK_GT(num_shards, 0);
+  for (int i = 0; i < num_shards_; i++) {
+    shard_paths_.push_back(
+        path_.AppendASCII(base::StringPrintf("shard_%d", i)));
+  }
+}
+
+ShardedBackend::~ShardedBackend() {
+  // Each shard waits for its own thread to clean up, so they go away one at a
+  // time, before the threads are stopped.
+  STLDeleteElements(&shards_);
+  STLDeleteElements(&threads_);
+}
+
+// Static.
+int ShardedBackend::CreateBackend(const FilePath& full_path, bool force,
+                                  int max_bytes, net::CacheType type,
+                                  uint32 flags, int num_shards,
+                                  net::NetLog* net_log, Backend** backend,
+                                  const net::CompletionCallback& callback) {
+  DCHECK(!callback.is_null());
+  ShardedBackend* cache = new ShardedBackend(full_path, num_shards, net_log);
+  int rv = cache->Init(force, max_bytes, type, flags,
+                       base::Bind(&OnBackendCreated, cache, backend, callback));
+  if (rv != net::ERR_IO_PENDING) {
+    DCHECK_NE(net::OK, rv);
+    *backend = NULL;
+    delete cache;
+  }
+  return rv;
+}
+
+// Static.
+int ShardedBackend::GetDefaultNumShards() {
+  return std::min(std::max(base::SysInfo::NumberOfProcessors(), 1),
+                  kMaxDefaultShards);
+}
+
+int ShardedBackend::Init(bool force, int max_bytes, net::CacheType type,
+                         uint32 flags,
+                         const net::CompletionCallback& callback) {
+  DCHECK(shards_.empty());
+  DCHECK_NE(net::MEMORY_CACHE, type);
+  if (max_bytes < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  force_ = force;
+  shard_max_bytes_ = (max_bytes ? max_bytes : kDefaultCacheSize) / num_shards_;
+  type_ = type;
+  flags_ = flags;
+  init_callback_ = callback;
+
+  for (int i = 0; i < num_shards_; i++) {
+    base::Thread* thread =
+        new base::Thread(base::StringPrintf("Cache shard %d", i).c_str());
+    threads_.push_back(thread);
+    if (!thread->StartWithOptions(
+            base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+      return net::ERR_FAILED;
+    }
+  }
+
+  // The shards are created one at a time: BackendImpl initialization touches
+  // process-wide state (field trials and histograms) that is not meant to be
+  // used from several threads at once.
+  CreateNextShard();
+  return net::ERR_IO_PENDING;
+}
+
+int ShardedBackend::GetShardForKey(const std::string& key) const {
+  // BackendImpl indexes its table with the low bits of the same hash, so
+  // pick the shard with the high bits, or each shard would only use part of
+  // its table.
+  return static_cast<int>((static_cast<uint64>(Hash(key)) * num_shards_) >> 32);
+}
+
+int32 ShardedBackend::GetEntryCount() const {
+  int32 count = 0;
+  for (size_t i = 0; i < shards_.size(); i++)
+    count += shards_[i]->GetEntryCount();
+  return count;
+}
+
+int ShardedBackend::OpenEntry(const std::string& key, Entry** entry,
+                              const net::CompletionCallback& callback) {
+  return shards_[GetShardForKey(key)]->OpenEntry(key, entry, callback);
+}
+
+int ShardedBackend::CreateEntry(const std::string& key, Entry** entry,
+                                const net::CompletionCallback& callback) {
+  return shards_[GetShardForKey(key)]->CreateEntry(key, entry, callback);
+}
+
+int ShardedBackend::DoomEntry(const std::string& key,
+                              const net::CompletionCallback& callback) {
+  return shards_[GetShardForKey(key)]->DoomEntry(key, callback);
+}
+
+int ShardedBackend::DoomAllEntries(const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (size_t i = 0; i < shards_.size(); i++) {
+    net::CompletionCallback shard_callback = barrier->AddShard();
+    int rv = shards_[i]->DoomAllEntries(shard_callback);
+    if (rv != net::ERR_IO_PENDING)
+      barrier->OnShardResult(rv);
+  }
+  return barrier->Done();
+}
+
+int ShardedBackend::DoomEntriesBetween(
+    const base::Time initial_time,
+    const base::Time end_time,
+    const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (size_t i = 0; i < shards_.size(); i++) {
+    net::CompletionCallback shard_callback = barrier->AddShard();
+    int rv = shards_[i]->DoomEntriesBetween(initial_time, end_time,
+                                            shard_callback);
+    if (rv != net::ERR_IO_PENDING)
+      barrier->OnShardResult(rv);
+  }
+  return barrier->Done();
+}
+
+int ShardedBackend::DoomEntriesSince(const base::Time initial_time,
+                                     const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (size_t i = 0; i < shards_.size(); i++) {
+    net::CompletionCallback shard_callback = barrier->AddShard();
+    int rv = shards_[i]->DoomEntriesSince(initial_time, shard_callback);
+    if (rv != net::ERR_IO_PENDING)
+      barrier->OnShardResult(rv);
+  }
+  return barrier->Done();
+}
+
+int ShardedBackend::OpenNextEntry(void** iter, Entry** next_entry,
+                                  const net::CompletionCallback& callback) {
+  if (!*iter)
+    *iter = new Iterator;
+  return ContinueEnumeration(reinterpret_cast<Iterator*>(*iter), next_entry,
+                             callback);
+}
+
+void ShardedBackend::EndEnumeration(void** iter) {
+  Iterator* iterator = reinterpret_cast<Iterator*>(*iter);
+  if (iterator && iterator->shard_iter)
+    shards_[iterator->shard]->EndEnumeration(&iterator->shard_iter);
+  delete iterator;
+  *iter = NULL;
+}
+
+void ShardedBackend::GetStats(StatsItems* stats) {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    StatsItems shard_stats;
+    shards_[i]->GetStats(&shard_stats);
+    for (size_t j = 0; j < shard_stats.size(); j++) {
+      stats->push_back(std::make_pair(
+          base::StringPrintf("Shard %d: %s", static_cast<int>(i),
+                             shard_stats[j].first.c_str()),
+          shard_stats[j].second));
+    }
+  }
+}
+
+void ShardedBackend::OnExternalCacheHit(const std::string& key) {
+  shards_[GetShardForKey(key)]->OnExternalCacheHit(key);
+}
+
+void ShardedBackend::CreateNextShard() {
+  int i = static_cast<int>(shards_.size());
+  int rv = BackendImpl::CreateBackend(
+      shard_paths_[i], force_, shard_max_bytes_, type_, flags_,
+      threads_[i]->message_loop_proxy(), net_log_, &new_shard_,
+      base::Bind(&ShardedBackend::OnShardCreated, base::Unretained(this)));
+  if (rv != net::ERR_IO_PENDING)
+    OnShardCreated(rv);
+}
+
+void ShardedBackend::OnShardCreated(int result) {
+  if (result != net::OK) {
+    // The callback may delete this object.
+    net::CompletionCallback callback = init_callback_;
+    init_callback_.Reset();
+    callback.Run(result);
+    return;
+  }
+
+  shards_.push_back(new_shard_);
+  new_shard_ = NULL;
+  if (static_cast<int>(shards_.size()) < num_shards_)
+    return CreateNextShard();
+
+  net::CompletionCallback callback = init_callback_;
+  init_callback_.Reset();
+  callback.Run(net::OK);
+}
+
+int ShardedBackend::ContinueEnumeration(
+    Iterator* iterator, Entry** next_entry,
+    const net::CompletionCallback& callback) {
+  for (;;) {
+    int rv = shards_[iterator->shard]->OpenNextEntry(
+        &iterator->shard_iter, next_entry,
+        base::Bind(&ShardedBackend::OnShardEnumerated, base::Unretained(this),
+                   iterator, next_entry, callback));
+    if (rv != net::ERR_FAILED || iterator->shard + 1 == num_shards_)
+      return rv;
+
+    // This shard has no more entries.
+    DCHECK(!iterator->shard_iter);
+    iterator->shard++;
+  }
+}
+
+void ShardedBackend::OnShardEnumerated(Iterator* iterator, Entry** next_entry,
+                                       const net::CompletionCallback& callback,
+                                       int result) {
+  if (result == net::ERR_FAILED && iterator->shard + 1 < num_shards_) {
+    DCHECK(!iterator->shard_iter);
+    iterator->shard++;
+    result = ContinueEnumeration(iterator, next_entry, callback);
+    if (result == net::ERR_IO_PENDING)
+      return;
+  }
+  callback.Run(result);
+}
+
+}  // namespace disk_cache
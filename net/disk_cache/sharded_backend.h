@@ -0,0 +1,122 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_SHARDED_BACKEND_H_
+#define NET_DISK_CACHE_SHARDED_BACKEND_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/stats.h"
+
+namespace base {
+class Thread;
+}  // namespace base
+
+namespace disk_cache {
+
+// This class implements the Backend interface by splitting the keys among a
+// number of independent BackendImpl instances (the shards), each with its own
+// files, in its own folder, and its own cache thread. A BackendImpl keeps its
+// index, rankings and block files consistent by doing all its work on one
+// thread; the shards share nothing, so lookups, block allocation and entry IO
+// of different shards run in parallel, with each shard acting as the lock for
+// its part of the keys.
+//
+// Eviction is done by each shard on its own part of the keys and of the
+// maximum size. Enumerations walk the shards one after the other, so entries
+// are not returned in global LRU order.
+class NET_EXPORT_PRIVATE ShardedBackend : public Backend {
+ public:
+  ShardedBackend(const FilePath& path, int num_shards, net::NetLog* net_log);
+  virtual ~ShardedBackend();
+
+  // Returns a new backend that spreads the cache at |full_path| over
+  // |num_shards| threads. The other arguments are the same as for
+  // BackendImpl::CreateBackend(); a zero |max_bytes| means a fixed default
+  // size, split among the shards.
+  static int CreateBackend(const FilePath& full_path, bool force,
+                           int max_bytes, net::CacheType type, uint32 flags,
+                           int num_shards, net::NetLog* net_log,
+                           Backend** backend,
+                           const net::CompletionCallback& callback);
+
+  // Returns the number of shards that CreateCacheBackend() uses: one per
+  // core, up to a few.
+  static int GetDefaultNumShards();
+
+  // Creates the shards, one after the other. See CreateBackend().
+  int Init(bool force, int max_bytes, net::CacheType type, uint32 flags,
+           const net::CompletionCallback& callback);
+
+  int num_shards() const { return num_shards_; }
+
+  // Returns the shard that stores |key|.
+  int GetShardForKey(const std::string& key) const;
+
+  // Backend interface.
+  virtual int32 GetEntryCount() const OVERRIDE;
+  virtual int OpenEntry(const std::string& key, Entry** entry,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int CreateEntry(const std::string& key, Entry** entry,
+                          const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntry(const std::string& key,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomAllEntries(const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesBetween(
+      const base::Time initial_time,
+      const base::Time end_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesSince(
+      const base::Time initial_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int OpenNextEntry(void** iter, Entry** next_entry,
+                            const net::CompletionCallback& callback) OVERRIDE;
+  virtual void EndEnumeration(void** iter) OVERRIDE;
+  virtual void GetStats(StatsItems* stats) OVERRIDE;
+  virtual void OnExternalCacheHit(const std::string& key) OVERRIDE;
+
+ private:
+  class Barrier;
+  struct Iterator;
+
+  // Creates the next shard, or reports the end of Init().
+  void CreateNextShard();
+  void OnShardCreated(int result);
+
+  // Continues OpenNextEntry() with the next shard once one runs out.
+  int ContinueEnumeration(Iterator* iterator, Entry** next_entry,
+                          const net::CompletionCallback& callback);
+  void OnShardEnumerated(Iterator* iterator, Entry** next_entry,
+                         const net::CompletionCallback& callback, int result);
+
+  FilePath path_;
+  int num_shards_;
+  net::NetLog* net_log_;
+
+  // The arguments of Init(), kept while the shards are being created.
+  bool force_;
+  int shard_max_bytes_;
+  net::CacheType type_;
+  uint32 flags_;
+  net::CompletionCallback init_callback_;
+
+  std::vector<FilePath> shard_paths_;
+  std::vector<base::Thread*> threads_;
+  std::vector<Backend*> shards_;
+  // Where BackendImpl::CreateBackend() returns the shard being created.
+  Backend* new_shard_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedBackend);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SHARDED_BACKEND_H_
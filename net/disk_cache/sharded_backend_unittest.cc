@@ -0,0 +1,206 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop_proxy.h"
+#include "base/stringprintf.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/sharded_backend.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumShards = 4;
+const int kNumEntries = 100;
+
+class DiskCacheShardedBackendTest : public DiskCacheTest {
+ protected:
+  // The shards live in folders that CleanupCacheDir() leaves alone.
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(file_util::Delete(cache_path_, true));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    cache_.reset();
+    EXPECT_TRUE(file_util::Delete(cache_path_, true));
+    DiskCacheTest::TearDown();
+  }
+
+  void CreateCache() {
+    disk_cache::Backend* cache = NULL;
+    net::TestCompletionCallback cb;
+    int rv = disk_cache::ShardedBackend::CreateBackend(
+        cache_path_, false, 10 * 1024 * 1024, net::DISK_CACHE,
+        disk_cache::kNoRandom, kNumShards, NULL, &cache, cb.callback());
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    ASSERT_TRUE(cache);
+    cache_.reset(static_cast<disk_cache::ShardedBackend*>(cache));
+  }
+
+  // Creates |kNumEntries| entries, storing the key as the data of stream 0.
+  void CreateEntries() {
+    net::TestCompletionCallback cb;
+    for (int i = 0; i < kNumEntries; i++) {
+      std::string key = base::StringPrintf("the key %d", i);
+      disk_cache::Entry* entry;
+      ASSERT_EQ(net::OK,
+                cb.GetResult(cache_->CreateEntry(key, &entry, cb.callback())));
+      scoped_refptr<net::StringIOBuffer> buffer(new net::StringIOBuffer(key));
+      int len = static_cast<int>(key.size());
+      EXPECT_EQ(len, cb.GetResult(entry->WriteData(0, 0, buffer, len,
+                                                   cb.callback(), false)));
+      entry->Close();
+    }
+  }
+
+  // Opens the entry for |key| and checks its data.
+  bool CheckEntry(const std::string& key) {
+    net::TestCompletionCallback cb;
+    disk_cache::Entry* entry;
+    if (cb.GetResult(cache_->OpenEntry(key, &entry, cb.callback())) != net::OK)
+      return false;
+    int len = static_cast<int>(key.size());
+    scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(len));
+    int rv = cb.GetResult(entry->ReadData(0, 0, buffer, len, cb.callback()));
+    entry->Close();
+    return rv == len && std::string(buffer->data(), len) == key;
+  }
+
+  scoped_ptr<disk_cache::ShardedBackend> cache_;
+};
+
+}  // namespace
+
+TEST_F(DiskCacheShardedBackendTest, Basics) {
+  CreateCache();
+  CreateEntries();
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  // The keys are spread over all the shards.
+  std::set<int> shards;
+  for (int i = 0; i < kNumEntries; i++) {
+    std::string key = base::StringPrintf("the key %d", i);
+    int shard = cache_->GetShardForKey(key);
+    EXPECT_LE(0, shard);
+    EXPECT_GT(kNumShards, shard);
+    shards.insert(shard);
+    EXPECT_TRUE(CheckEntry(key));
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumShards), shards.size());
+
+  net::TestCompletionCallback cb;
+  disk_cache::Entry* entry;
+  EXPECT_NE(net::OK,
+            cb.GetResult(cache_->OpenEntry("no such key", &entry,
+                                           cb.callback())));
+  EXPECT_EQ(net::OK,
+            cb.GetResult(cache_->DoomEntry("the key 7", cb.callback())));
+  EXPECT_FALSE(CheckEntry("the key 7"));
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+
+  // Each shard is a regular cache of its own.
+  cache_.reset();
+  for (int i = 0; i < kNumShards; i++) {
+    EXPECT_TRUE(CheckCacheIntegrity(
+        cache_path_.AppendASCII(base::StringPrintf("shard_%d", i)), false, 0));
+  }
+
+  CreateCache();
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+  EXPECT_TRUE(CheckEntry("the key 0"));
+  EXPECT_TRUE(CheckEntry("the key 99"));
+}
+
+TEST_F(DiskCacheShardedBackendTest, Enumerations) {
+  CreateCache();
+  CreateEntries();
+
+  // Every entry is returned once.
+  std::set<std::string> keys;
+  net::TestCompletionCallback cb;
+  void* iter = NULL;
+  disk_cache::Entry* entry;
+  while (cb.GetResult(cache_->OpenNextEntry(&iter, &entry, cb.callback())) ==
+         net::OK) {
+    EXPECT_TRUE(keys.insert(entry->GetKey()).second);
+    entry->Close();
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumEntries), keys.size());
+  cache_->EndEnumeration(&iter);
+
+  // An enumeration can be ended half way.
+  iter = NULL;
+  for (int i = 0; i < kNumEntries / 2; i++) {
+    ASSERT_EQ(net::OK,
+              cb.GetResult(cache_->OpenNextEntry(&iter, &entry,
+                                                 cb.callback())));
+    entry->Close();
+  }
+  cache_->EndEnumeration(&iter);
+  EXPECT_TRUE(iter == NULL);
+}
+
+TEST_F(DiskCacheShardedBackendTest, DoomEntries) {
+  CreateCache();
+  CreateEntries();
+
+  net::TestCompletionCallback cb;
+  base::Time now = base::Time::Now();
+  EXPECT_EQ(net::OK,
+            cb.GetResult(cache_->DoomEntriesSince(now, cb.callback())));
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  EXPECT_EQ(net::OK,
+            cb.GetResult(cache_->DoomEntriesBetween(base::Time(), now,
+                                                    cb.callback())));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  CreateEntries();
+  EXPECT_EQ(net::OK, cb.GetResult(cache_->DoomAllEntries(cb.callback())));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+  EXPECT_FALSE(CheckEntry("the key 3"));
+}
+
+// A shard that fails to initialize fails the whole cache.
+TEST_F(DiskCacheShardedBackendTest, ShardInitFails) {
+  ASSERT_TRUE(file_util::CreateDirectory(cache_path_));
+  ASSERT_EQ(4, file_util::WriteFile(cache_path_.AppendASCII("shard_2"),
+                                    "file", 4));
+
+  disk_cache::Backend* cache = reinterpret_cast<disk_cache::Backend*>(1);
+  net::TestCompletionCallback cb;
+  int rv = disk_cache::ShardedBackend::CreateBackend(
+      cache_path_, false, 10 * 1024 * 1024, net::DISK_CACHE,
+      disk_cache::kNoRandom, kNumShards, NULL, &cache, cb.callback());
+  EXPECT_NE(net::OK, cb.GetResult(rv));
+  EXPECT_TRUE(cache == NULL);
+}
+
+TEST_F(DiskCacheShardedBackendTest, CreateCacheBackend) {
+  disk_cache::Backend* cache = NULL;
+  net::TestCompletionCallback cb;
+  int rv = disk_cache::CreateCacheBackend(
+      net::DISK_CACHE, net::CACHE_BACKEND_SHARDED, cache_path_, 0, false,
+      base::MessageLoopProxy::current(), NULL, &cache, cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  ASSERT_TRUE(cache);
+  cache_.reset(static_cast<disk_cache::ShardedBackend*>(cache));
+  EXPECT_EQ(disk_cache::ShardedBackend::GetDefaultNumShards(),
+            cache_->num_shards());
+  EXPECT_TRUE(file_util::DirectoryExists(cache_path_.AppendASCII("shard_0")));
+
+  CreateEntries();
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  EXPECT_TRUE(CheckEntry("the key 42"));
+}
@@ -0,0 +1,478 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple_backend_impl.h"
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/string_number_conversions.h"
+#include "base/sys_info.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/cache_util.h"
+#include "net/disk_cache/eviction_policy.h"
+#include "net/disk_cache/simple_entry_impl.h"
+#include "net/disk_cache/simple_synchronous_entry.h"
+
+namespace {
+
+// The cache size used when there is no better idea.
+const int kDefaultCacheSize = 80 * 1024 * 1024;
+
+// When the cache is too big, it is trimmed to this percentage of its size, so
+// that eviction doesn't run for every new entry.
+const int kEvictionTargetPercent = 90;
+
+// The folder of a simple cache has an "index" file, like the folder of a
+// BackendImpl cache, but with this header only, so that one kind of cache
+// doesn't try to use the files of the other.
+const uint64 kSimpleInitialMagicNumber = GG_UINT64_C(0xfcfb6d1ba7725c30);
+const uint32 kSimpleVersion = 1;
+const char kFakeIndexFile[] = "index";
+
+struct FakeIndexHeader {
+  uint64 magic;
+  uint32 version;
+  uint32 unused;
+};
+
+void OnBackendCreated(disk_cache::SimpleBackendImpl* cache,
+                      disk_cache::Backend** backend,
+                      const net::CompletionCallback& callback,
+                      int result) {
+  if (result == net::OK) {
+    *backend = cache;
+  } else {
+    LOG(ERROR) << "Unable to create cache";
+    *backend = NULL;
+    delete cache;
+  }
+  callback.Run(result);
+}
+
+bool IsSimpleCacheFolder(const FilePath& fake_index) {
+  FakeIndexHeader header;
+  return file_util::ReadFile(fake_index, reinterpret_cast<char*>(&header),
+                             sizeof(header)) == sizeof(header) &&
+         header.magic == kSimpleInitialMagicNumber &&
+         header.version == kSimpleVersion;
+}
+
+// Runs on the cache thread.
+void InitCacheStructureOnDisk(const FilePath& path, bool force, int* max_size,
+                              int* result) {
+  *result = net::OK;
+  FilePath fake_index = path.AppendASCII(kFakeIndexFile);
+  if (file_util::PathExists(fake_index) && !IsSimpleCacheFolder(fake_index)) {
+    if (!force) {
+      LOG(ERROR) << "The folder is used by another cache";
+      *result = net::ERR_FAILED;
+      return;
+    }
+    disk_cache::DeleteCache(path, false);
+    file_util::Delete(disk_cache::SimpleIndex::GetIndexFilePath(path).DirName(),
+                      true);
+  }
+
+  if (!file_util::PathExists(fake_index)) {
+    FakeIndexHeader header;
+    header.magic = kSimpleInitialMagicNumber;
+    header.version = kSimpleVersion;
+    header.unused = 0;
+    if (!file_util::CreateDirectory(path) ||
+        file_util::WriteFile(fake_index, reinterpret_cast<char*>(&header),
+                             sizeof(header)) != sizeof(header)) {
+      LOG(ERROR) << "Unable to create the simple cache";
+      *result = net::ERR_FAILED;
+      return;
+    }
+  }
+
+  if (!*max_size) {
+    int64 available = base::SysInfo::AmountOfFreeDiskSpace(path);
+    *max_size = available > 0 ? disk_cache::PreferedCacheSize(available) :
+                                kDefaultCacheSize;
+  }
+}
+
+void DeleteEntriesFiles(const FilePath& path,
+                        const std::vector<uint64>& entry_hashes) {
+  for (size_t i = 0; i < entry_hashes.size(); i++)
+    disk_cache::SimpleSynchronousEntry::DeleteFiles(path, entry_hashes[i]);
+}
+
+void OpenEntryOnCacheThread(
+    const FilePath& path, uint64 entry_hash, const std::string& key,
+    disk_cache::SimpleSynchronousEntry** synchronous_entry) {
+  *synchronous_entry =
+      disk_cache::SimpleSynchronousEntry::Open(path, entry_hash, key);
+}
+
+void CreateEntryOnCacheThread(
+    const FilePath& path, const std::string& key,
+    disk_cache::SimpleSynchronousEntry** synchronous_entry) {
+  *synchronous_entry = disk_cache::SimpleSynchronousEntry::Create(path, key);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// The state of an enumeration: the entries in the index when it started.
+struct SimpleBackendImpl::Iterator {
+  Iterator() : position(0) {}
+
+  std::vector<uint64> entry_hashes;
+  size_t position;
+};
+
+SimpleBackendImpl::SimpleBackendImpl(const FilePath& path, int max_bytes,
+                                     base::MessageLoopProxy* cache_thread)
+    : path_(path),
+      max_size_(max_bytes),
+      cache_thread_(cache_thread),
+      index_(new SimpleIndex(
+          cache_thread, path,
+          EvictionPolicy::Create(EvictionPolicy::SEGMENTED_LRU))) {
+}
+
+SimpleBackendImpl::~SimpleBackendImpl() {
+}
+
+// Static.
+int SimpleBackendImpl::CreateBackend(const FilePath& full_path, bool force,
+                                     int max_bytes,
+                                     base::MessageLoopProxy* thread,
+                                     Backend** backend,
+                                     const net::CompletionCallback& callback) {
+  DCHECK(!callback.is_null());
+  if (max_bytes < 0)
+    return net::ERR_INVALID_ARGUMENT;
+  SimpleBackendImpl* cache = new SimpleBackendImpl(full_path, max_bytes,
+                                                   thread);
+  return cache->Init(force,
+                     base::Bind(&OnBackendCreated, cache, backend, callback));
+}
+
+int SimpleBackendImpl::Init(bool force,
+                            const net::CompletionCallback& callback) {
+  int* max_size = new int(max_size_);
+  int* result = new int(net::OK);
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&InitCacheStructureOnDisk, path_, force, max_size, result),
+      base::Bind(&SimpleBackendImpl::OnInitComplete, AsWeakPtr(), callback,
+                 base::Owned(max_size), base::Owned(result)));
+  return net::ERR_IO_PENDING;
+}
+
+void SimpleBackendImpl::OnEntryUsed(uint64 entry_hash) {
+  index_->UseIfExists(entry_hash);
+}
+
+void SimpleBackendImpl::OnEntryResized(uint64 entry_hash, int64 size) {
+  index_->UpdateEntrySize(entry_hash, size);
+  EvictIfNeeded();
+}
+
+void SimpleBackendImpl::OnEntryDoomed(SimpleEntryImpl* entry) {
+  OnEntryClosed(entry);
+  index_->Remove(entry->entry_hash());
+}
+
+void SimpleBackendImpl::OnEntryClosed(SimpleEntryImpl* entry) {
+  EntryMap::iterator it = active_entries_.find(entry->entry_hash());
+  if (it != active_entries_.end() && it->second == entry)
+    active_entries_.erase(it);
+}
+
+int32 SimpleBackendImpl::GetEntryCount() const {
+  return index_->GetEntryCount();
+}
+
+int SimpleBackendImpl::OpenEntry(const std::string& key, Entry** entry,
+                                 const net::CompletionCallback& callback) {
+  return OpenEntryFromHash(GetSimpleEntryHash(key), key, entry, callback);
+}
+
+int SimpleBackendImpl::CreateEntry(const std::string& key, Entry** entry,
+                                   const net::CompletionCallback& callback) {
+  uint64 entry_hash = GetSimpleEntryHash(key);
+  if (active_entries_.count(entry_hash))
+    return net::ERR_FAILED;
+
+  SimpleSynchronousEntry** synchronous_entry = new SimpleSynchronousEntry*;
+  *synchronous_entry = NULL;
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&CreateEntryOnCacheThread, path_, key, synchronous_entry),
+      base::Bind(&SimpleBackendImpl::OnEntryOpened, AsWeakPtr(),
+                 cache_thread_, entry_hash, true, entry, callback,
+                 base::Owned(synchronous_entry)));
+  return net::ERR_IO_PENDING;
+}
+
+int SimpleBackendImpl::DoomEntry(const std::string& key,
+                                 const net::CompletionCallback& callback) {
+  uint64 entry_hash = GetSimpleEntryHash(key);
+  EntryMap::iterator it = active_entries_.find(entry_hash);
+  if (it != active_entries_.end()) {
+    it->second->Doom();
+    return net::OK;
+  }
+  if (index_->initialized() && !index_->Has(entry_hash))
+    return net::ERR_FAILED;
+
+  return DoomEntries(std::vector<uint64>(1, entry_hash), callback);
+}
+
+int SimpleBackendImpl::DoomAllEntries(const net::CompletionCallback& callback) {
+  return DoomEntriesBetween(base::Time(), base::Time(), callback);
+}
+
+int SimpleBackendImpl::DoomEntriesBetween(
+    const base::Time initial_time,
+    const base::Time end_time,
+    const net::CompletionCallback& callback) {
+  if (!index_->initialized()) {
+    index_->ExecuteWhenReady(
+        base::Bind(&SimpleBackendImpl::IndexReadyForDoom,
+                   base::Unretained(this), initial_time, end_time, callback));
+    return net::ERR_IO_PENDING;
+  }
+
+  std::vector<uint64> entry_hashes;
+  index_->GetEntriesBetween(initial_time, end_time, &entry_hashes);
+  return DoomEntries(entry_hashes, callback);
+}
+
+int SimpleBackendImpl::DoomEntriesSince(
+    const base::Time initial_time,
+    const net::CompletionCallback& callback) {
+  return DoomEntriesBetween(initial_time, base::Time(), callback);
+}
+
+int SimpleBackendImpl::OpenNextEntry(void** iter, Entry** next_entry,
+                                     const net::CompletionCallback& callback) {
+  if (!index_->initialized()) {
+    index_->ExecuteWhenReady(
+        base::Bind(&SimpleBackendImpl::IndexReadyForEnumeration,
+                   base::Unretained(this), iter, next_entry, callback));
+    return net::ERR_IO_PENDING;
+  }
+
+  Iterator* iterator = reinterpret_cast<Iterator*>(*iter);
+  if (!iterator) {
+    iterator = new Iterator;
+    index_->GetEntriesBetween(base::Time(), base::Time(),
+                              &iterator->entry_hashes);
+    *iter = iterator;
+  }
+
+  while (iterator->position < iterator->entry_hashes.size()) {
+    uint64 entry_hash = iterator->entry_hashes[iterator->position++];
+    // Skip the entries doomed since the enumeration started.
+    if (!index_->Has(entry_hash))
+      continue;
+    return OpenEntryFromHash(
+        entry_hash, std::string(), next_entry,
+        base::Bind(&SimpleBackendImpl::OnEnumeratedEntryOpened, AsWeakPtr(),
+                   iter, next_entry, callback));
+  }
+  return net::ERR_FAILED;
+}
+
+void SimpleBackendImpl::EndEnumeration(void** iter) {
+  delete reinterpret_cast<Iterator*>(*iter);
+  *iter = NULL;
+}
+
+void SimpleBackendImpl::GetStats(StatsItems* stats) {
+  stats->push_back(std::make_pair(std::string("Entries"),
+                                  base::IntToString(GetEntryCount())));
+  stats->push_back(std::make_pair(std::string("Size"),
+                                  base::Int64ToString(index_->cache_size())));
+  stats->push_back(std::make_pair(std::string("Max size"),
+                                  base::IntToString(max_size_)));
+  int open_entries = static_cast<int>(active_entries_.size());
+  stats->push_back(std::make_pair(std::string("Open entries"),
+                                  base::IntToString(open_entries)));
+  stats->push_back(std::make_pair(std::string("Index loaded"),
+                                  index_->initialized() ? "yes" : "no"));
+}
+
+void SimpleBackendImpl::OnExternalCacheHit(const std::string& key) {
+  index_->UseIfExists(GetSimpleEntryHash(key));
+}
+
+void SimpleBackendImpl::OnInitComplete(const net::CompletionCallback& callback,
+                                       int* max_size, int* result) {
+  if (*result == net::OK) {
+    max_size_ = *max_size;
+    index_->SetMaxSize(max_size_);
+    index_->Initialize();
+  }
+  callback.Run(*result);
+}
+
+int SimpleBackendImpl::OpenEntryFromHash(
+    uint64 entry_hash, const std::string& key, Entry** entry,
+    const net::CompletionCallback& callback) {
+  EntryMap::iterator it = active_entries_.find(entry_hash);
+  if (it != active_entries_.end()) {
+    if (!key.empty() && it->second->GetKey() != key)
+      return net::ERR_FAILED;
+    it->second->OnOpened();
+    *entry = it->second;
+    return net::OK;
+  }
+
+  // A miss doesn't need to touch the disk once the index is complete.
+  if (index_->initialized() && !index_->Has(entry_hash))
+    return net::ERR_FAILED;
+
+  SimpleSynchronousEntry** synchronous_entry = new SimpleSynchronousEntry*;
+  *synchronous_entry = NULL;
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&OpenEntryOnCacheThread, path_, entry_hash, key,
+                 synchronous_entry),
+      base::Bind(&SimpleBackendImpl::OnEntryOpened, AsWeakPtr(),
+                 cache_thread_, entry_hash, false, entry, callback,
+                 base::Owned(synchronous_entry)));
+  return net::ERR_IO_PENDING;
+}
+
+// Static.
+void SimpleBackendImpl::OnEntryOpened(
+    base::WeakPtr<SimpleBackendImpl> backend,
+    scoped_refptr<base::MessageLoopProxy> cache_thread,
+    uint64 entry_hash, bool created, Entry** entry,
+    const net::CompletionCallback& callback,
+    SimpleSynchronousEntry** synchronous_entry) {
+  if (!backend) {
+    if (*synchronous_entry)
+      cache_thread->DeleteSoon(FROM_HERE, *synchronous_entry);
+    return;
+  }
+  backend->AddEntry(entry_hash, created, entry, callback, *synchronous_entry);
+}
+
+void SimpleBackendImpl::AddEntry(uint64 entry_hash, bool created,
+                                 Entry** entry,
+                                 const net::CompletionCallback& callback,
+                                 SimpleSynchronousEntry* synchronous_entry) {
+  if (!synchronous_entry) {
+    // The index may be wrong about an entry that is not there.
+    if (!created && !active_entries_.count(entry_hash))
+      index_->Remove(entry_hash);
+    return callback.Run(net::ERR_FAILED);
+  }
+
+  // Another request for the same entry may have finished first.
+  DCHECK_EQ(entry_hash, synchronous_entry->entry_hash());
+  EntryMap::iterator it = active_entries_.find(entry_hash);
+  if (it != active_entries_.end()) {
+    DCHECK(!created);
+    cache_thread_->DeleteSoon(FROM_HERE, synchronous_entry);
+    it->second->OnOpened();
+    *entry = it->second;
+    return callback.Run(net::OK);
+  }
+
+  SimpleEntryImpl* entry_impl =
+      new SimpleEntryImpl(this, cache_thread_, path_, max_size_ / 8,
+                          synchronous_entry);
+  entry_impl->AddRef();
+  active_entries_[entry_hash] = entry_impl;
+
+  if (created || !index_->Has(entry_hash)) {
+    int64 data_size = 0;
+    for (int i = 0; i < kSimpleEntryFileCount; i++)
+      data_size += entry_impl->GetDataSize(i);
+    index_->Insert(entry_hash);
+    index_->UpdateEntrySize(
+        entry_hash, GetSimpleEntryFileSize(entry_impl->GetKey(), data_size));
+    EvictIfNeeded();
+  } else {
+    index_->UseIfExists(entry_hash);
+  }
+
+  *entry = entry_impl;
+  callback.Run(net::OK);
+}
+
+int SimpleBackendImpl::DoomEntries(const std::vector<uint64>& entry_hashes,
+                                   const net::CompletionCallback& callback) {
+  std::vector<uint64> to_delete;
+  for (size_t i = 0; i < entry_hashes.size(); i++) {
+    EntryMap::iterator it = active_entries_.find(entry_hashes[i]);
+    if (it != active_entries_.end()) {
+      it->second->Doom();
+      continue;
+    }
+    index_->Remove(entry_hashes[i]);
+    to_delete.push_back(entry_hashes[i]);
+  }
+
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&DeleteEntriesFiles, path_, to_delete),
+      base::Bind(&SimpleBackendImpl::RunCallback, AsWeakPtr(), callback,
+                 net::OK));
+  return net::ERR_IO_PENDING;
+}
+
+void SimpleBackendImpl::IndexReadyForDoom(
+    base::Time initial_time, base::Time end_time,
+    const net::CompletionCallback& callback) {
+  int rv = DoomEntriesBetween(initial_time, end_time, callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
+}
+
+void SimpleBackendImpl::IndexReadyForEnumeration(
+    void** iter, Entry** next_entry, const net::CompletionCallback& callback) {
+  int rv = OpenNextEntry(iter, next_entry, callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
+}
+
+void SimpleBackendImpl::OnEnumeratedEntryOpened(
+    void** iter, Entry** next_entry, const net::CompletionCallback& callback,
+    int result) {
+  // The entry may be gone from the disk; go on with the next one.
+  if (result == net::ERR_FAILED)
+    return IndexReadyForEnumeration(iter, next_entry, callback);
+  callback.Run(result);
+}
+
+void SimpleBackendImpl::EvictIfNeeded() {
+  if (index_->cache_size() <= max_size_)
+    return;
+
+  std::vector<uint64> candidates;
+  index_->GetEvictionCandidates(
+      static_cast<int64>(max_size_) * kEvictionTargetPercent / 100,
+      &candidates);
+
+  // The entries in use stay.
+  std::vector<uint64> to_delete;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (active_entries_.count(candidates[i]))
+      continue;
+    index_->Remove(candidates[i]);
+    to_delete.push_back(candidates[i]);
+  }
+  cache_thread_->PostTask(FROM_HERE,
+                          base::Bind(&DeleteEntriesFiles, path_, to_delete));
+}
+
+void SimpleBackendImpl::RunCallback(const net::CompletionCallback& callback,
+                                    int result) {
+  callback.Run(result);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,148 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_SIMPLE_BACKEND_IMPL_H_
+#define NET_DISK_CACHE_SIMPLE_BACKEND_IMPL_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/flat_hash_tables.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/simple_index.h"
+#include "net/disk_cache/stats.h"
+
+namespace base {
+class MessageLoopProxy;
+}
+
+namespace disk_cache {
+
+class SimpleEntryImpl;
+class SimpleSynchronousEntry;
+
+// This class implements the Backend interface with a "simple" cache: every
+// stream of every entry is a file of its own, named after the hash of the key,
+// so there are no shared block files or rankings to keep consistent. Opening
+// an existing cache doesn't read anything but a small header, and there is
+// nothing to recover after a crash: an entry is either in its files or not,
+// and the index of entries, used for eviction, enumeration and quick misses,
+// is rebuilt in the background when its saved copy is stale. See SimpleIndex.
+//
+// The backend and its entries live on the thread that uses the cache; all the
+// file IO happens on the cache thread.
+class NET_EXPORT_PRIVATE SimpleBackendImpl
+    : public Backend,
+      public base::SupportsWeakPtr<SimpleBackendImpl> {
+ public:
+  SimpleBackendImpl(const FilePath& path, int max_bytes,
+                    base::MessageLoopProxy* cache_thread);
+  virtual ~SimpleBackendImpl();
+
+  // Returns a new simple cache in |full_path|. The arguments are the same as
+  // for BackendImpl::CreateBackend().
+  static int CreateBackend(const FilePath& full_path, bool force,
+                           int max_bytes, base::MessageLoopProxy* thread,
+                           Backend** backend,
+                           const net::CompletionCallback& callback);
+
+  // Performs general initialization for this current instance of the cache.
+  // If |force| is true, a folder used by another kind of cache is emptied.
+  int Init(bool force, const net::CompletionCallback& callback);
+
+  int max_size() const { return max_size_; }
+  SimpleIndex* index() { return index_.get(); }
+
+  // Called by the entries.
+  void OnEntryUsed(uint64 entry_hash);
+  void OnEntryResized(uint64 entry_hash, int64 size);
+  void OnEntryDoomed(SimpleEntryImpl* entry);
+  void OnEntryClosed(SimpleEntryImpl* entry);
+
+  // Backend interface.
+  virtual int32 GetEntryCount() const OVERRIDE;
+  virtual int OpenEntry(const std::string& key, Entry** entry,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int CreateEntry(const std::string& key, Entry** entry,
+                          const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntry(const std::string& key,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomAllEntries(const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesBetween(
+      const base::Time initial_time,
+      const base::Time end_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesSince(
+      const base::Time initial_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int OpenNextEntry(void** iter, Entry** next_entry,
+                            const net::CompletionCallback& callback) OVERRIDE;
+  virtual void EndEnumeration(void** iter) OVERRIDE;
+  virtual void GetStats(StatsItems* stats) OVERRIDE;
+  virtual void OnExternalCacheHit(const std::string& key) OVERRIDE;
+
+ private:
+  typedef base::flat_hash_map<uint64, SimpleEntryImpl*> EntryMap;
+  struct Iterator;
+
+  void OnInitComplete(const net::CompletionCallback& callback, int* max_size,
+                      int* result);
+
+  // Opens the entry stored with |entry_hash|, checking that it is for |key|
+  // unless |key| is empty.
+  int OpenEntryFromHash(uint64 entry_hash, const std::string& key,
+                        Entry** entry,
+                        const net::CompletionCallback& callback);
+
+  // Receives the result of opening or creating an entry on the cache thread.
+  // Static so that the synchronous entry is not leaked if the backend is gone.
+  static void OnEntryOpened(base::WeakPtr<SimpleBackendImpl> backend,
+                            scoped_refptr<base::MessageLoopProxy> cache_thread,
+                            uint64 entry_hash, bool created, Entry** entry,
+                            const net::CompletionCallback& callback,
+                            SimpleSynchronousEntry** synchronous_entry);
+  void AddEntry(uint64 entry_hash, bool created, Entry** entry,
+                const net::CompletionCallback& callback,
+                SimpleSynchronousEntry* synchronous_entry);
+
+  // Dooms the entries stored with |entry_hashes|.
+  int DoomEntries(const std::vector<uint64>& entry_hashes,
+                  const net::CompletionCallback& callback);
+
+  // Continue operations that need the whole index.
+  void IndexReadyForDoom(base::Time initial_time, base::Time end_time,
+                         const net::CompletionCallback& callback);
+  void IndexReadyForEnumeration(void** iter, Entry** next_entry,
+                                const net::CompletionCallback& callback);
+  void OnEnumeratedEntryOpened(void** iter, Entry** next_entry,
+                               const net::CompletionCallback& callback,
+                               int result);
+
+  // Removes the least recently used entries if the cache is too big.
+  void EvictIfNeeded();
+
+  void RunCallback(const net::CompletionCallback& callback, int result);
+
+  const FilePath path_;
+  int max_size_;
+  scoped_refptr<base::MessageLoopProxy> cache_thread_;
+  scoped_ptr<SimpleIndex> index_;
+
+  // The entries in use. Each entry is here until it is closed or doomed.
+  EntryMap active_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleBackendImpl);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_BACKEND_IMPL_H_
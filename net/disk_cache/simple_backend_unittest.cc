@@ -0,0 +1,456 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/simple_backend_impl.h"
+#include "net/disk_cache/simple_index.h"
+#include "net/disk_cache/simple_synchronous_entry.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using disk_cache::EvictionPolicy;
+
+namespace {
+
+const int kNumEntries = 50;
+
+std::string GetKey(int i) {
+  return base::StringPrintf("the key %d", i);
+}
+
+class DiskCacheSimpleBackendTest : public DiskCacheTest {
+ protected:
+  DiskCacheSimpleBackendTest() : cache_thread_("CacheThread") {}
+
+  // The index lives in a folder that CleanupCacheDir() leaves alone.
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(cache_thread_.StartWithOptions(
+                    base::Thread::Options(MessageLoop::TYPE_IO, 0)));
+    ASSERT_TRUE(file_util::Delete(cache_path_, true));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    CloseCache();
+    EXPECT_TRUE(file_util::Delete(cache_path_, true));
+    DiskCacheTest::TearDown();
+  }
+
+  int CreateCache(int max_bytes) {
+    disk_cache::Backend* cache = NULL;
+    net::TestCompletionCallback cb;
+    int rv = disk_cache::CreateCacheBackend(
+        net::DISK_CACHE, net::CACHE_BACKEND_SIMPLE, cache_path_, max_bytes,
+        false, cache_thread_.message_loop_proxy(), NULL, &cache,
+        cb.callback());
+    rv = cb.GetResult(rv);
+    cache_.reset(static_cast<disk_cache::SimpleBackendImpl*>(cache));
+    return rv;
+  }
+
+  // Destroys the cache, and waits until the cache thread is done with it.
+  void CloseCache() {
+    cache_.reset();
+    FlushCacheThread();
+  }
+
+  void FlushCacheThread() {
+    net::TestCompletionCallback cb;
+    cache_thread_.message_loop_proxy()->PostTaskAndReply(
+        FROM_HERE, base::Bind(&base::DoNothing),
+        base::Bind(cb.callback(), net::OK));
+    EXPECT_EQ(net::OK, cb.WaitForResult());
+  }
+
+  void WaitForIndex() {
+    net::TestCompletionCallback cb;
+    cache_->index()->ExecuteWhenReady(base::Bind(cb.callback(), net::OK));
+    EXPECT_EQ(net::OK, cb.GetResult(net::ERR_IO_PENDING));
+  }
+
+  // Creates |count| entries, storing the key as the data of stream 1.
+  void CreateEntries(int count) {
+    net::TestCompletionCallback cb;
+    for (int i = 0; i < count; i++) {
+      std::string key = GetKey(i);
+      disk_cache::Entry* entry;
+      ASSERT_EQ(net::OK,
+                cb.GetResult(cache_->CreateEntry(key, &entry, cb.callback())));
+      scoped_refptr<net::StringIOBuffer> buffer(new net::StringIOBuffer(key));
+      int len = static_cast<int>(key.size());
+      EXPECT_EQ(len, cb.GetResult(entry->WriteData(1, 0, buffer, len,
+                                                   cb.callback(), false)));
+      entry->Close();
+    }
+  }
+
+  // Opens the entry for |key| and checks its data.
+  bool CheckEntry(const std::string& key) {
+    net::TestCompletionCallback cb;
+    disk_cache::Entry* entry;
+    if (cb.GetResult(cache_->OpenEntry(key, &entry, cb.callback())) != net::OK)
+      return false;
+    int len = static_cast<int>(key.size());
+    scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(len));
+    int rv = cb.GetResult(entry->ReadData(1, 0, buffer, len, cb.callback()));
+    bool result = rv == len && entry->GetDataSize(1) == len &&
+                  entry->GetKey() == key &&
+                  std::string(buffer->data(), len) == key;
+    entry->Close();
+    return result;
+  }
+
+  base::Thread cache_thread_;
+  scoped_ptr<disk_cache::SimpleBackendImpl> cache_;
+};
+
+}  // namespace
+
+TEST_F(DiskCacheSimpleBackendTest, Basics) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  CreateEntries(kNumEntries);
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  for (int i = 0; i < kNumEntries; i++)
+    EXPECT_TRUE(CheckEntry(GetKey(i)));
+
+  net::TestCompletionCallback cb;
+  disk_cache::Entry* entry;
+  EXPECT_NE(net::OK, cb.GetResult(cache_->OpenEntry("no such key", &entry,
+                                                    cb.callback())));
+  EXPECT_NE(net::OK, cb.GetResult(cache_->CreateEntry(GetKey(3), &entry,
+                                                      cb.callback())));
+
+  CloseCache();
+  ASSERT_EQ(net::OK, CreateCache(0));
+  WaitForIndex();
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  EXPECT_TRUE(CheckEntry(GetKey(0)));
+  EXPECT_TRUE(CheckEntry(GetKey(kNumEntries - 1)));
+
+  // Once the index is loaded, a miss doesn't wait for the disk.
+  EXPECT_EQ(net::ERR_FAILED,
+            cache_->OpenEntry("no such key", &entry, cb.callback()));
+}
+
+TEST_F(DiskCacheSimpleBackendTest, ReadWrite) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  net::TestCompletionCallback cb;
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->CreateEntry("key", &entry, cb.callback())));
+
+  const int kSize = 20000;
+  scoped_refptr<net::IOBuffer> buffer1(new net::IOBuffer(kSize));
+  scoped_refptr<net::IOBuffer> buffer2(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer1->data(), kSize, false);
+
+  // The operations are queued, and complete in order.
+  EXPECT_EQ(net::ERR_IO_PENDING,
+            entry->WriteData(0, 0, buffer1, kSize, cb.callback(), false));
+  EXPECT_EQ(kSize, entry->GetDataSize(0));
+  net::TestCompletionCallback cb2;
+  EXPECT_EQ(net::ERR_IO_PENDING,
+            entry->ReadData(0, 0, buffer2, kSize, cb2.callback()));
+  EXPECT_EQ(kSize, cb.WaitForResult());
+  EXPECT_EQ(kSize, cb2.WaitForResult());
+  EXPECT_EQ(0, memcmp(buffer1->data(), buffer2->data(), kSize));
+
+  // Reads are limited to the stream, and truncation shrinks it.
+  EXPECT_EQ(0, entry->ReadData(0, kSize, buffer2, kSize, cb.callback()));
+  EXPECT_EQ(100, cb.GetResult(entry->WriteData(0, 1000, buffer1, 100,
+                                               cb.callback(), true)));
+  EXPECT_EQ(1100, entry->GetDataSize(0));
+  EXPECT_EQ(100, cb.GetResult(entry->ReadData(0, 1000, buffer2, kSize,
+                                              cb.callback())));
+  EXPECT_EQ(0, memcmp(buffer1->data(), buffer2->data(), 100));
+
+  // A write past the end leaves zeros in between.
+  EXPECT_EQ(0, cb.GetResult(entry->WriteData(2, 500, buffer1, 0,
+                                             cb.callback(), false)));
+  EXPECT_EQ(500, entry->GetDataSize(2));
+  EXPECT_EQ(500, cb.GetResult(entry->ReadData(2, 0, buffer2, kSize,
+                                              cb.callback())));
+  EXPECT_EQ(std::string(500, '\0'), std::string(buffer2->data(), 500));
+
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT,
+            entry->ReadData(3, 0, buffer2, kSize, cb.callback()));
+  EXPECT_EQ(net::ERR_CACHE_OPERATION_NOT_SUPPORTED,
+            entry->WriteSparseData(0, buffer1, kSize, cb.callback()));
+  entry->Close();
+
+  // The data survives the backend.
+  CloseCache();
+  ASSERT_EQ(net::OK, CreateCache(0));
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->OpenEntry("key", &entry, cb.callback())));
+  EXPECT_EQ(1100, entry->GetDataSize(0));
+  EXPECT_EQ(0, entry->GetDataSize(1));
+  EXPECT_EQ(500, entry->GetDataSize(2));
+  EXPECT_EQ(1100, cb.GetResult(entry->ReadData(0, 0, buffer2, kSize,
+                                               cb.callback())));
+  EXPECT_EQ(0, memcmp(buffer1->data(), buffer2->data(), 1000));
+  entry->Close();
+}
+
+TEST_F(DiskCacheSimpleBackendTest, OpenTwice) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  net::TestCompletionCallback cb;
+  disk_cache::Entry* entry1;
+  disk_cache::Entry* entry2;
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->CreateEntry("key", &entry1, cb.callback())));
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->OpenEntry("key", &entry2, cb.callback())));
+  EXPECT_EQ(entry1, entry2);
+  entry1->Close();
+
+  // Dooming the entry lets a new one take its key, while the old one remains
+  // usable until it is closed.
+  EXPECT_EQ(net::OK, cb.GetResult(cache_->DoomEntry("key", cb.callback())));
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->CreateEntry("key", &entry1, cb.callback())));
+  EXPECT_NE(entry1, entry2);
+  scoped_refptr<net::StringIOBuffer> buffer(new net::StringIOBuffer("data"));
+  EXPECT_EQ(4, cb.GetResult(entry2->WriteData(0, 0, buffer, 4, cb.callback(),
+                                              false)));
+  EXPECT_EQ(0, entry1->GetDataSize(0));
+  entry2->Close();
+  entry1->Close();
+  EXPECT_EQ(1, cache_->GetEntryCount());
+}
+
+TEST_F(DiskCacheSimpleBackendTest, DoomEntries) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  CreateEntries(kNumEntries);
+
+  net::TestCompletionCallback cb;
+  EXPECT_EQ(net::OK, cb.GetResult(cache_->DoomEntry(GetKey(7),
+                                                    cb.callback())));
+  EXPECT_FALSE(CheckEntry(GetKey(7)));
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+
+  base::Time now = base::Time::Now();
+  EXPECT_EQ(net::OK,
+            cb.GetResult(cache_->DoomEntriesSince(now, cb.callback())));
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+
+  EXPECT_EQ(net::OK,
+            cb.GetResult(cache_->DoomEntriesBetween(base::Time(), now,
+                                                    cb.callback())));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  CreateEntries(kNumEntries);
+  EXPECT_EQ(net::OK, cb.GetResult(cache_->DoomAllEntries(cb.callback())));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+  EXPECT_FALSE(CheckEntry(GetKey(3)));
+
+  // Nothing is left on disk either.
+  CloseCache();
+  ASSERT_EQ(net::OK, CreateCache(0));
+  WaitForIndex();
+  EXPECT_EQ(0, cache_->GetEntryCount());
+}
+
+TEST_F(DiskCacheSimpleBackendTest, Enumerations) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  CreateEntries(kNumEntries);
+  CloseCache();
+  ASSERT_EQ(net::OK, CreateCache(0));
+
+  // The enumeration waits for the index, and returns every entry once.
+  std::set<std::string> keys;
+  net::TestCompletionCallback cb;
+  void* iter = NULL;
+  disk_cache::Entry* entry;
+  while (cb.GetResult(cache_->OpenNextEntry(&iter, &entry, cb.callback())) ==
+         net::OK) {
+    EXPECT_TRUE(keys.insert(entry->GetKey()).second);
+    entry->Close();
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumEntries), keys.size());
+  cache_->EndEnumeration(&iter);
+  EXPECT_TRUE(iter == NULL);
+}
+
+// Without the saved index, as after a crash, the index is rebuilt from the
+// files of the entries.
+TEST_F(DiskCacheSimpleBackendTest, RestoreIndex) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  CreateEntries(kNumEntries);
+  int64 size = cache_->index()->cache_size();
+  CloseCache();
+
+  FilePath index_file = disk_cache::SimpleIndex::GetIndexFilePath(cache_path_);
+  EXPECT_TRUE(file_util::PathExists(index_file));
+  ASSERT_TRUE(file_util::Delete(index_file, false));
+
+  // The cache is usable before the index is back.
+  ASSERT_EQ(net::OK, CreateCache(0));
+  EXPECT_TRUE(CheckEntry(GetKey(5)));
+  WaitForIndex();
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  EXPECT_EQ(size, cache_->index()->cache_size());
+  EXPECT_TRUE(CheckEntry(GetKey(kNumEntries - 1)));
+}
+
+// After a clean shutdown, the saved index is used as long as the folder didn't
+// change after it was saved.
+TEST_F(DiskCacheSimpleBackendTest, SavedIndex) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  CreateEntries(kNumEntries);
+  CloseCache();
+
+  // Remove an entry behind the back of the index, and make the folder look
+  // older than the index.
+  ASSERT_TRUE(disk_cache::SimpleSynchronousEntry::DeleteFiles(
+      cache_path_, disk_cache::GetSimpleEntryHash(GetKey(0))));
+  base::Time past = base::Time::Now() - base::TimeDelta::FromMinutes(1);
+  ASSERT_TRUE(file_util::TouchFile(cache_path_, past, past));
+
+  ASSERT_EQ(net::OK, CreateCache(0));
+  WaitForIndex();
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  // The index learns about the missing entry when it is not found.
+  EXPECT_FALSE(CheckEntry(GetKey(0)));
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+  EXPECT_TRUE(CheckEntry(GetKey(1)));
+}
+
+TEST_F(DiskCacheSimpleBackendTest, IndexSerialization) {
+  disk_cache::SimpleIndex::EntrySet entries;
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::SimpleIndex::EntryMetadata metadata;
+    metadata.last_used = i * 1000;
+    metadata.size = i;
+    metadata.eviction_state = static_cast<EvictionPolicy::EntryState>(
+        i % EvictionPolicy::ENTRY_STATE_MAX);
+    entries[i * GG_UINT64_C(0x123456789)] = metadata;
+  }
+
+  std::string data;
+  disk_cache::SimpleIndex::Serialize(entries, "history", &data);
+  disk_cache::SimpleIndex::EntrySet read;
+  std::string history;
+  ASSERT_TRUE(disk_cache::SimpleIndex::Deserialize(data, &read, &history));
+  EXPECT_EQ("history", history);
+  ASSERT_EQ(entries.size(), read.size());
+  for (int i = 0; i < kNumEntries; i++) {
+    uint64 entry_hash = i * GG_UINT64_C(0x123456789);
+    ASSERT_EQ(1u, read.count(entry_hash));
+    EXPECT_EQ(i * 1000, read[entry_hash].last_used);
+    EXPECT_EQ(i, read[entry_hash].size);
+    EXPECT_EQ(entries[entry_hash].eviction_state,
+              read[entry_hash].eviction_state);
+  }
+
+  // Any damage is detected.
+  data[data.size() / 2] ^= 1;
+  EXPECT_FALSE(disk_cache::SimpleIndex::Deserialize(data, &read, &history));
+  EXPECT_FALSE(disk_cache::SimpleIndex::Deserialize(std::string(), &read,
+                                                    &history));
+}
+
+// Reused entries stay protected from new ones after a restart.
+TEST_F(DiskCacheSimpleBackendTest, EvictionStateSurvivesRestart) {
+  ASSERT_EQ(net::OK, CreateCache(0));
+  WaitForIndex();
+  CreateEntries(2);
+  EXPECT_TRUE(CheckEntry(GetKey(0)));
+  EXPECT_TRUE(CheckEntry(GetKey(1)));
+  net::TestCompletionCallback cb;
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK,
+            cb.GetResult(cache_->CreateEntry("new", &entry, cb.callback())));
+  scoped_refptr<net::StringIOBuffer> buffer(new net::StringIOBuffer("data"));
+  EXPECT_EQ(4, cb.GetResult(entry->WriteData(1, 0, buffer, 4, cb.callback(),
+                                             false)));
+  entry->Close();
+  CloseCache();
+  base::Time past = base::Time::Now() - base::TimeDelta::FromMinutes(1);
+  ASSERT_TRUE(file_util::TouchFile(cache_path_, past, past));
+
+  ASSERT_EQ(net::OK, CreateCache(0));
+  WaitForIndex();
+  std::vector<uint64> candidates;
+  int64 size = cache_->index()->cache_size();
+  cache_->index()->GetEvictionCandidates(size - 1, &candidates);
+  ASSERT_EQ(1u, candidates.size());
+  EXPECT_EQ(disk_cache::GetSimpleEntryHash("new"), candidates[0]);
+}
+
+TEST_F(DiskCacheSimpleBackendTest, Eviction) {
+  const int kMaxSize = 200 * 1024;
+  ASSERT_EQ(net::OK, CreateCache(kMaxSize));
+
+  const int kSize = 10 * 1024;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  net::TestCompletionCallback cb;
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, cb.GetResult(cache_->CreateEntry(GetKey(i), &entry,
+                                                        cb.callback())));
+    EXPECT_EQ(kSize, cb.GetResult(entry->WriteData(1, 0, buffer, kSize,
+                                                   cb.callback(), false)));
+    entry->Close();
+    EXPECT_GE(kMaxSize, cache_->index()->cache_size());
+  }
+
+  // The oldest entries went first.
+  EXPECT_GT(kNumEntries, cache_->GetEntryCount());
+  EXPECT_LT(0, cache_->GetEntryCount());
+  disk_cache::Entry* entry;
+  EXPECT_NE(net::OK, cb.GetResult(cache_->OpenEntry(GetKey(0), &entry,
+                                                    cb.callback())));
+  ASSERT_EQ(net::OK, cb.GetResult(cache_->OpenEntry(GetKey(kNumEntries - 1),
+                                                    &entry, cb.callback())));
+  entry->Close();
+
+  // An entry can't take more than an eighth of the cache.
+  ASSERT_EQ(net::OK, cb.GetResult(cache_->CreateEntry("big", &entry,
+                                                      cb.callback())));
+  EXPECT_EQ(net::ERR_FAILED,
+            entry->WriteData(1, kMaxSize / 8, buffer, 1, cb.callback(),
+                             false));
+  entry->Close();
+}
+
+// A folder used by a BackendImpl cache is taken over only with |force|.
+TEST_F(DiskCacheSimpleBackendTest, OtherCacheFolder) {
+  net::TestCompletionCallback cb;
+  disk_cache::Backend* cache;
+  int rv = disk_cache::CreateCacheBackend(
+      net::DISK_CACHE, net::CACHE_BACKEND_BLOCKFILE, cache_path_, 0, false,
+      cache_thread_.message_loop_proxy(), NULL, &cache, cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  delete cache;
+  FlushCacheThread();
+
+  EXPECT_EQ(net::ERR_FAILED, CreateCache(0));
+  EXPECT_TRUE(cache_.get() == NULL);
+
+  rv = disk_cache::SimpleBackendImpl::CreateBackend(
+      cache_path_, true, 0, cache_thread_.message_loop_proxy(), &cache,
+      cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  cache_.reset(static_cast<disk_cache::SimpleBackendImpl*>(cache));
+  CreateEntries(1);
+  EXPECT_TRUE(CheckEntry(GetKey(0)));
+}
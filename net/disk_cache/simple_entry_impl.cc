@@ -0,0 +1,216 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple_entry_impl.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/simple_backend_impl.h"
+
+namespace {
+
+// These run on the cache thread.
+
+void ReadDataOnCacheThread(disk_cache::SimpleSynchronousEntry* entry,
+                           int index, int offset,
+                           scoped_refptr<net::IOBuffer> buf, int buf_len,
+                           int* result) {
+  *result = entry->ReadData(index, offset, buf, buf_len);
+}
+
+void WriteDataOnCacheThread(disk_cache::SimpleSynchronousEntry* entry,
+                            int index, int offset,
+                            scoped_refptr<net::IOBuffer> buf, int buf_len,
+                            bool truncate, int* result) {
+  *result = entry->WriteData(index, offset, buf, buf_len, truncate);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+SimpleEntryImpl::SimpleEntryImpl(SimpleBackendImpl* backend,
+                                 base::MessageLoopProxy* cache_thread,
+                                 const FilePath& path,
+                                 int max_file_size,
+                                 SimpleSynchronousEntry* synchronous_entry)
+    : backend_(backend->AsWeakPtr()),
+      cache_thread_(cache_thread),
+      path_(path),
+      max_file_size_(max_file_size),
+      synchronous_entry_(synchronous_entry),
+      key_(synchronous_entry->key()),
+      entry_hash_(synchronous_entry->entry_hash()),
+      last_used_(base::Time::Now()),
+      last_modified_(synchronous_entry->last_modified()),
+      doomed_(false) {
+  for (int i = 0; i < kSimpleEntryFileCount; i++)
+    data_size_[i] = synchronous_entry->data_size(i);
+}
+
+void SimpleEntryImpl::OnOpened() {
+  AddRef();
+  last_used_ = base::Time::Now();
+  if (backend_ && !doomed_)
+    backend_->OnEntryUsed(entry_hash_);
+}
+
+void SimpleEntryImpl::Doom() {
+  if (doomed_)
+    return;
+  doomed_ = true;
+  if (backend_)
+    backend_->OnEntryDoomed(this);
+
+  // The files go away now; the entry keeps working with the open files until
+  // it is closed.
+  cache_thread_->PostTask(
+      FROM_HERE, base::Bind(base::IgnoreResult(
+                                &SimpleSynchronousEntry::DeleteFiles),
+                            path_, entry_hash_));
+}
+
+void SimpleEntryImpl::Close() {
+  Release();
+}
+
+std::string SimpleEntryImpl::GetKey() const {
+  return key_;
+}
+
+base::Time SimpleEntryImpl::GetLastUsed() const {
+  return last_used_;
+}
+
+base::Time SimpleEntryImpl::GetLastModified() const {
+  return last_modified_;
+}
+
+int32 SimpleEntryImpl::GetDataSize(int index) const {
+  if (index < 0 || index >= kSimpleEntryFileCount)
+    return 0;
+  return data_size_[index];
+}
+
+int SimpleEntryImpl::ReadData(int index, int offset, net::IOBuffer* buf,
+                              int buf_len,
+                              const net::CompletionCallback& callback) {
+  DCHECK(!callback.is_null());
+  if (index < 0 || index >= kSimpleEntryFileCount || buf_len < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  if (offset >= data_size_[index] || offset < 0 || !buf_len)
+    return 0;
+  buf_len = std::min(buf_len, data_size_[index] - offset);
+
+  // The backend was told about this use when the entry was opened; the
+  // eviction policy counts uses per open, not per read.
+  last_used_ = base::Time::Now();
+
+  int* result = new int(0);
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&ReadDataOnCacheThread, synchronous_entry_, index, offset,
+                 make_scoped_refptr(buf), buf_len, result),
+      base::Bind(&SimpleEntryImpl::OnReadComplete, this, callback,
+                 base::Owned(result)));
+  return net::ERR_IO_PENDING;
+}
+
+int SimpleEntryImpl::WriteData(int index, int offset, net::IOBuffer* buf,
+                               int buf_len,
+                               const net::CompletionCallback& callback,
+                               bool truncate) {
+  if (index < 0 || index >= kSimpleEntryFileCount || offset < 0 ||
+      buf_len < 0) {
+    return net::ERR_INVALID_ARGUMENT;
+  }
+  if (offset > max_file_size_ || buf_len > max_file_size_ - offset)
+    return net::ERR_FAILED;
+
+  // The sizes change now, so that the next operations see them; the data
+  // follows on the cache thread, before any later operation.
+  int32 end = offset + buf_len;
+  if (truncate || end > data_size_[index])
+    data_size_[index] = end;
+  last_used_ = last_modified_ = base::Time::Now();
+  if (backend_ && !doomed_)
+    backend_->OnEntryResized(entry_hash_, GetFileSize());
+
+  int* result = new int(0);
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&WriteDataOnCacheThread, synchronous_entry_, index, offset,
+                 make_scoped_refptr(buf), buf_len, truncate, result),
+      base::Bind(&SimpleEntryImpl::OnWriteComplete, this, callback,
+                 base::Owned(result)));
+
+  // Without a callback, the write is reported as done right away.
+  return callback.is_null() ? buf_len : net::ERR_IO_PENDING;
+}
+
+int SimpleEntryImpl::ReadSparseData(int64 offset, net::IOBuffer* buf,
+                                    int buf_len,
+                                    const net::CompletionCallback& callback) {
+  return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+}
+
+int SimpleEntryImpl::WriteSparseData(int64 offset, net::IOBuffer* buf,
+                                     int buf_len,
+                                     const net::CompletionCallback& callback) {
+  return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+}
+
+int SimpleEntryImpl::GetAvailableRange(
+    int64 offset, int len, int64* start,
+    const net::CompletionCallback& callback) {
+  return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+}
+
+bool SimpleEntryImpl::CouldBeSparse() const {
+  return false;
+}
+
+void SimpleEntryImpl::CancelSparseIO() {
+}
+
+int SimpleEntryImpl::ReadyForSparseIO(
+    const net::CompletionCallback& callback) {
+  return net::OK;
+}
+
+SimpleEntryImpl::~SimpleEntryImpl() {
+  if (backend_)
+    backend_->OnEntryClosed(this);
+  cache_thread_->DeleteSoon(FROM_HERE, synchronous_entry_);
+}
+
+void SimpleEntryImpl::OnReadComplete(const net::CompletionCallback& callback,
+                                     int* result) {
+  callback.Run(*result);
+}
+
+void SimpleEntryImpl::OnWriteComplete(const net::CompletionCallback& callback,
+                                      int* result) {
+  // The sizes were updated already, so the entry can't be trusted anymore.
+  if (*result < 0)
+    Doom();
+  if (!callback.is_null())
+    callback.Run(*result);
+}
+
+int64 SimpleEntryImpl::GetFileSize() const {
+  int64 data_size = 0;
+  for (int i = 0; i < kSimpleEntryFileCount; i++)
+    data_size += data_size_[i];
+  return GetSimpleEntryFileSize(key_, data_size);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,105 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_ENTRY_IMPL_H_
+#define NET_DISK_CACHE_SIMPLE_ENTRY_IMPL_H_
+#pragma once
+
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/simple_synchronous_entry.h"
+
+namespace base {
+class MessageLoopProxy;
+}
+
+namespace disk_cache {
+
+class SimpleBackendImpl;
+
+// This class implements the Entry interface for the simple cache. It lives on
+// the thread that uses the cache, and keeps the sizes and times of the entry,
+// while its SimpleSynchronousEntry does the IO on the cache thread. The IO of
+// every entry goes through the cache thread in the order it is issued, so a
+// read always sees the writes issued before it. All the IO completes
+// asynchronously: reads need a callback, and a write without one is reported
+// as done right away. Sparse data is not supported.
+//
+// There is only one object per entry; every user of the entry holds a
+// reference, and so does every operation in progress.
+class SimpleEntryImpl : public Entry,
+                        public base::RefCounted<SimpleEntryImpl> {
+ public:
+  SimpleEntryImpl(SimpleBackendImpl* backend,
+                  base::MessageLoopProxy* cache_thread,
+                  const FilePath& path,
+                  int max_file_size,
+                  SimpleSynchronousEntry* synchronous_entry);
+
+  uint64 entry_hash() const { return entry_hash_; }
+
+  // Takes a reference for another user of the entry.
+  void OnOpened();
+
+  // Entry interface.
+  virtual void Doom() OVERRIDE;
+  virtual void Close() OVERRIDE;
+  virtual std::string GetKey() const OVERRIDE;
+  virtual base::Time GetLastUsed() const OVERRIDE;
+  virtual base::Time GetLastModified() const OVERRIDE;
+  virtual int32 GetDataSize(int index) const OVERRIDE;
+  virtual int ReadData(int index, int offset, net::IOBuffer* buf, int buf_len,
+                       const net::CompletionCallback& callback) OVERRIDE;
+  virtual int WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
+                        const net::CompletionCallback& callback,
+                        bool truncate) OVERRIDE;
+  virtual int ReadSparseData(int64 offset, net::IOBuffer* buf, int buf_len,
+                             const net::CompletionCallback& callback) OVERRIDE;
+  virtual int WriteSparseData(int64 offset, net::IOBuffer* buf, int buf_len,
+                              const net::CompletionCallback& callback) OVERRIDE;
+  virtual int GetAvailableRange(
+      int64 offset, int len, int64* start,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual bool CouldBeSparse() const OVERRIDE;
+  virtual void CancelSparseIO() OVERRIDE;
+  virtual int ReadyForSparseIO(
+      const net::CompletionCallback& callback) OVERRIDE;
+
+ private:
+  friend class base::RefCounted<SimpleEntryImpl>;
+  virtual ~SimpleEntryImpl();
+
+  void OnReadComplete(const net::CompletionCallback& callback, int* result);
+  void OnWriteComplete(const net::CompletionCallback& callback, int* result);
+
+  // Returns the size of all the files of the entry.
+  int64 GetFileSize() const;
+
+  base::WeakPtr<SimpleBackendImpl> backend_;
+  scoped_refptr<base::MessageLoopProxy> cache_thread_;
+  const FilePath path_;
+  const int max_file_size_;
+
+  // Owned by this object, but used and deleted on the cache thread.
+  SimpleSynchronousEntry* synchronous_entry_;
+
+  const std::string key_;
+  const uint64 entry_hash_;
+  int32 data_size_[kSimpleEntryFileCount];
+  base::Time last_used_;
+  base::Time last_modified_;
+  bool doomed_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleEntryImpl);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_ENTRY_IMPL_H_
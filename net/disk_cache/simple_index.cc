@@ -0,0 +1,348 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/pickle.h"
+#include "net/disk_cache/hash.h"
+#include "net/disk_cache/simple_synchronous_entry.h"
+
+namespace {
+
+const uint64 kSimpleIndexMagic = GG_UINT64_C(0x656e74657220796f);
+const uint32 kSimpleIndexVersion = 2;
+
+// How long to wait after a change before saving the index. A crash loses at
+// most this much of the index, and the index is rebuilt anyway if the folder
+// changed after it was saved.
+const int kWriteToDiskDelaySecs = 20;
+
+const char kIndexDirectory[] = "index-dir";
+const char kIndexFile[] = "the-real-index";
+const char kTempIndexFile[] = "temp-index";
+
+// Writes the index to a temporary file first, so that a crash never leaves a
+// half-written index behind.
+void WriteIndexFile(const FilePath& path, const std::string& data) {
+  FilePath index_file = disk_cache::SimpleIndex::GetIndexFilePath(path);
+  FilePath temp_file = index_file.DirName().AppendASCII(kTempIndexFile);
+  if (!file_util::CreateDirectory(index_file.DirName()) ||
+      file_util::WriteFile(temp_file, data.data(), data.size()) !=
+          static_cast<int>(data.size()) ||
+      !file_util::ReplaceFile(temp_file, index_file)) {
+    LOG(ERROR) << "Unable to write the simple cache index";
+    file_util::Delete(temp_file, false);
+  }
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+SimpleIndex::SimpleIndex(base::MessageLoopProxy* cache_thread,
+                         const FilePath& path,
+                         EvictionPolicy* eviction_policy)
+    : cache_thread_(cache_thread),
+      path_(path),
+      cache_size_(0),
+      initialized_(false),
+      eviction_policy_(eviction_policy) {
+}
+
+SimpleIndex::~SimpleIndex() {
+  if (write_timer_.IsRunning())
+    WriteToDisk();
+}
+
+void SimpleIndex::Initialize() {
+  EntrySet* entries = new EntrySet;
+  std::string* eviction_history = new std::string;
+  cache_thread_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&SimpleIndex::LoadFromDisk, path_, entries, eviction_history),
+      base::Bind(&SimpleIndex::OnIndexLoaded, AsWeakPtr(),
+                 base::Owned(entries), base::Owned(eviction_history)));
+}
+
+void SimpleIndex::SetMaxSize(int64 max_bytes) {
+  eviction_policy_->SetMaxSize(max_bytes);
+}
+
+void SimpleIndex::ExecuteWhenReady(const base::Closure& task) {
+  if (initialized_)
+    return task.Run();
+  to_run_when_initialized_.push_back(task);
+}
+
+void SimpleIndex::Insert(uint64 entry_hash) {
+  EntryMetadata metadata;
+  metadata.last_used = base::Time::Now().ToInternalValue();
+  Remove(entry_hash);
+  InsertInternal(entry_hash, metadata);
+  eviction_policy_->OnEntryAdded(entry_hash, metadata.size);
+  if (!initialized_)
+    removed_entries_.erase(entry_hash);
+  PostponeWrite();
+}
+
+void SimpleIndex::Remove(uint64 entry_hash) {
+  EntrySet::iterator it = entries_.find(entry_hash);
+  if (it != entries_.end()) {
+    cache_size_ -= it->second.size;
+    entries_.erase(it);
+    eviction_policy_->OnEntryRemoved(entry_hash);
+    PostponeWrite();
+  }
+  if (!initialized_)
+    removed_entries_.insert(entry_hash);
+}
+
+bool SimpleIndex::Has(uint64 entry_hash) const {
+  return entries_.count(entry_hash) != 0;
+}
+
+void SimpleIndex::UseIfExists(uint64 entry_hash) {
+  EntrySet::iterator it = entries_.find(entry_hash);
+  if (it == entries_.end())
+    return;
+  it->second.last_used = base::Time::Now().ToInternalValue();
+  eviction_policy_->OnEntryUsed(entry_hash);
+  PostponeWrite();
+}
+
+void SimpleIndex::UpdateEntrySize(uint64 entry_hash, int64 size) {
+  EntrySet::iterator it = entries_.find(entry_hash);
+  if (it == entries_.end())
+    return;
+  cache_size_ += size - it->second.size;
+  it->second.size = size;
+  eviction_policy_->OnEntryResized(entry_hash, size);
+  PostponeWrite();
+}
+
+int32 SimpleIndex::GetEntryCount() const {
+  return static_cast<int32>(entries_.size());
+}
+
+void SimpleIndex::GetEntriesBetween(base::Time initial_time,
+                                    base::Time end_time,
+                                    std::vector<uint64>* entry_hashes) const {
+  int64 initial = initial_time.ToInternalValue();
+  int64 end = end_time.is_null() ? kint64max : end_time.ToInternalValue();
+  for (EntrySet::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->second.last_used >= initial && it->second.last_used < end)
+      entry_hashes->push_back(it->first);
+  }
+}
+
+void SimpleIndex::GetEvictionCandidates(
+    int64 target_size, std::vector<uint64>* entry_hashes) const {
+  DCHECK_EQ(cache_size_, eviction_policy_->GetSize());
+  eviction_policy_->GetEvictionCandidates(target_size, entry_hashes);
+}
+
+void SimpleIndex::WriteToDisk() {
+  // Until it is loaded, the index lacks the entries of earlier runs, and the
+  // copy on disk is better than this one.
+  if (!initialized_)
+    return;
+  write_timer_.Stop();
+  CopyEvictionStates();
+  std::string eviction_history;
+  eviction_policy_->SaveHistory(&eviction_history);
+  std::string data;
+  Serialize(entries_, eviction_history, &data);
+  cache_thread_->PostTask(FROM_HERE,
+                          base::Bind(&WriteIndexFile, path_, data));
+}
+
+// Static.
+void SimpleIndex::Serialize(const EntrySet& entries,
+                            const std::string& eviction_history,
+                            std::string* data) {
+  Pickle pickle;
+  pickle.WriteUInt64(kSimpleIndexMagic);
+  pickle.WriteUInt32(kSimpleIndexVersion);
+  pickle.WriteUInt64(entries.size());
+  for (EntrySet::const_iterator it = entries.begin(); it != entries.end();
+       ++it) {
+    pickle.WriteUInt64(it->first);
+    pickle.WriteInt64(it->second.last_used);
+    pickle.WriteInt64(it->second.size);
+    pickle.WriteInt(it->second.eviction_state);
+  }
+  pickle.WriteString(eviction_history);
+
+  data->assign(static_cast<const char*>(pickle.data()), pickle.size());
+  uint32 checksum = Hash(*data);
+  data->append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+}
+
+// Static.
+bool SimpleIndex::Deserialize(const std::string& data, EntrySet* entries,
+                              std::string* eviction_history) {
+  uint32 checksum;
+  if (data.size() < sizeof(checksum))
+    return false;
+  size_t pickle_size = data.size() - sizeof(checksum);
+  memcpy(&checksum, data.data() + pickle_size, sizeof(checksum));
+  if (checksum != Hash(data.data(), pickle_size))
+    return false;
+
+  Pickle pickle(data.data(), pickle_size);
+  void* iter = NULL;
+  uint64 magic;
+  uint32 version;
+  uint64 count;
+  if (!pickle.ReadUInt64(&iter, &magic) || magic != kSimpleIndexMagic ||
+      !pickle.ReadUInt32(&iter, &version) || version != kSimpleIndexVersion ||
+      !pickle.ReadUInt64(&iter, &count)) {
+    return false;
+  }
+
+  entries->clear();
+  for (uint64 i = 0; i < count; i++) {
+    uint64 entry_hash;
+    EntryMetadata metadata;
+    int eviction_state;
+    if (!pickle.ReadUInt64(&iter, &entry_hash) ||
+        !pickle.ReadInt64(&iter, &metadata.last_used) ||
+        !pickle.ReadInt64(&iter, &metadata.size) || metadata.size < 0 ||
+        !pickle.ReadInt(&iter, &eviction_state) || eviction_state < 0 ||
+        eviction_state >= EvictionPolicy::ENTRY_STATE_MAX) {
+      entries->clear();
+      return false;
+    }
+    metadata.eviction_state =
+        static_cast<EvictionPolicy::EntryState>(eviction_state);
+    (*entries)[entry_hash] = metadata;
+  }
+  if (!pickle.ReadString(&iter, eviction_history)) {
+    entries->clear();
+    return false;
+  }
+  return true;
+}
+
+// Static.
+void SimpleIndex::LoadFromDisk(const FilePath& path, EntrySet* entries,
+                               std::string* eviction_history) {
+  // Creating or deleting an entry changes the folder, so an index saved
+  // before that (and not after) is stale.
+  FilePath index_file = GetIndexFilePath(path);
+  base::PlatformFileInfo index_info;
+  base::PlatformFileInfo folder_info;
+  std::string data;
+  if (file_util::GetFileInfo(index_file, &index_info) &&
+      file_util::GetFileInfo(path, &folder_info) &&
+      folder_info.last_modified < index_info.last_modified &&
+      file_util::ReadFileToString(index_file, &data) &&
+      Deserialize(data, entries, eviction_history)) {
+    return;
+  }
+  RestoreFromDisk(path, entries);
+}
+
+// Static.
+void SimpleIndex::RestoreFromDisk(const FilePath& path, EntrySet* entries) {
+  LOG(WARNING) << "Rebuilding the simple cache index";
+  entries->clear();
+  file_util::FileEnumerator enumerator(path, false,
+                                       file_util::FileEnumerator::FILES);
+  for (FilePath name = enumerator.Next(); !name.empty();
+       name = enumerator.Next()) {
+    uint64 entry_hash;
+    int index;
+    if (!ParseSimpleEntryFilename(name.BaseName().MaybeAsASCII(), &entry_hash,
+                                  &index)) {
+      continue;
+    }
+    file_util::FileEnumerator::FindInfo info;
+    enumerator.GetFindInfo(&info);
+    EntryMetadata& metadata = (*entries)[entry_hash];
+    metadata.size += file_util::FileEnumerator::GetFilesize(info);
+    metadata.last_used = std::max(
+        metadata.last_used,
+        file_util::FileEnumerator::GetLastModifiedTime(info).ToInternalValue());
+  }
+}
+
+// Static.
+FilePath SimpleIndex::GetIndexFilePath(const FilePath& path) {
+  return path.AppendASCII(kIndexDirectory).AppendASCII(kIndexFile);
+}
+
+void SimpleIndex::OnIndexLoaded(EntrySet* entries,
+                                std::string* eviction_history) {
+  DCHECK(!initialized_);
+  // The entries used since the backend started know better.
+  CopyEvictionStates();
+  for (EntrySet::const_iterator it = entries->begin(); it != entries->end();
+       ++it) {
+    if (!entries_.count(it->first) && !removed_entries_.count(it->first))
+      InsertInternal(it->first, it->second);
+  }
+  removed_entries_.clear();
+  if (!eviction_history->empty() &&
+      !eviction_policy_->LoadHistory(*eviction_history)) {
+    LOG(WARNING) << "Unable to use the saved eviction history";
+  }
+  RebuildEvictionOrder();
+  initialized_ = true;
+  PostponeWrite();
+
+  std::vector<base::Closure> tasks;
+  tasks.swap(to_run_when_initialized_);
+  for (size_t i = 0; i < tasks.size(); i++)
+    tasks[i].Run();
+}
+
+void SimpleIndex::PostponeWrite() {
+  if (!write_timer_.IsRunning()) {
+    write_timer_.Start(FROM_HERE,
+                       base::TimeDelta::FromSeconds(kWriteToDiskDelaySecs),
+                       this, &SimpleIndex::WriteToDisk);
+  }
+}
+
+void SimpleIndex::InsertInternal(uint64 entry_hash,
+                                 const EntryMetadata& metadata) {
+  entries_[entry_hash] = metadata;
+  cache_size_ += metadata.size;
+}
+
+void SimpleIndex::CopyEvictionStates() {
+  for (EntrySet::iterator it = entries_.begin(); it != entries_.end(); ++it)
+    it->second.eviction_state = eviction_policy_->GetEntryState(it->first);
+}
+
+void SimpleIndex::RebuildEvictionOrder() {
+  // The loaded entries are older than the ones used since the backend
+  // started, but the policy only adds entries as the most recently used.
+  typedef std::pair<int64, uint64> UseAndHash;
+  std::vector<UseAndHash> entries;
+  entries.reserve(entries_.size());
+  for (EntrySet::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    entries.push_back(std::make_pair(it->second.last_used, it->first));
+  }
+  std::sort(entries.begin(), entries.end());
+
+  eviction_policy_->Clear();
+  for (size_t i = 0; i < entries.size(); i++) {
+    const EntryMetadata& metadata = entries_[entries[i].second];
+    eviction_policy_->OnEntryLoaded(entries[i].second, metadata.size,
+                                    metadata.eviction_state);
+  }
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,159 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_INDEX_H_
+#define NET_DISK_CACHE_SIMPLE_INDEX_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/file_path.h"
+#include "base/flat_hash_tables.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time.h"
+#include "base/timer.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/eviction_policy.h"
+
+namespace base {
+class MessageLoopProxy;
+}
+
+namespace disk_cache {
+
+// This class keeps in memory the list of the entries of a simple cache, with
+// their sizes and the time they were last used, so that the backend can count,
+// evict and enumerate entries without touching their files.
+//
+// The index is saved a while after it changes, and when it is destroyed. The
+// saved copy is not needed to use the cache: it is loaded in the background,
+// and when it is missing, corrupt or older than the cache folder (after a
+// crash) it is rebuilt by listing the files of the folder. Until then, the
+// index only knows about the entries used since the backend started.
+//
+// The index keeps its EvictionPolicy up to date with the entries, and asks it
+// which entries to evict. The state of the entries in the policy, and what the
+// policy learned about their use, are saved with the index.
+//
+// Everything except the static methods runs on the thread that uses the cache;
+// the disk work is posted to the cache thread.
+class NET_EXPORT_PRIVATE SimpleIndex
+    : public base::SupportsWeakPtr<SimpleIndex> {
+ public:
+  struct EntryMetadata {
+    EntryMetadata()
+        : last_used(0), size(0), eviction_state(EvictionPolicy::ENTRY_NEW) {}
+
+    int64 last_used;  // The internal value of a base::Time.
+    int64 size;
+    EvictionPolicy::EntryState eviction_state;
+  };
+  typedef base::flat_hash_map<uint64, EntryMetadata> EntrySet;
+
+  // |path| is the cache folder. The index takes ownership of
+  // |eviction_policy|.
+  SimpleIndex(base::MessageLoopProxy* cache_thread, const FilePath& path,
+              EvictionPolicy* eviction_policy);
+  ~SimpleIndex();
+
+  // Starts loading the index.
+  void Initialize();
+
+  // Returns true once the index knows about every entry on disk.
+  bool initialized() const { return initialized_; }
+
+  // Sets the size of the cache, for the eviction policy.
+  void SetMaxSize(int64 max_bytes);
+
+  // Runs |task| as soon as the index is initialized.
+  void ExecuteWhenReady(const base::Closure& task);
+
+  // Adds a new, empty entry, used now.
+  void Insert(uint64 entry_hash);
+  void Remove(uint64 entry_hash);
+  bool Has(uint64 entry_hash) const;
+
+  // Marks an entry as used now, if it is in the index.
+  void UseIfExists(uint64 entry_hash);
+
+  // Sets the size of an entry, if it is in the index.
+  void UpdateEntrySize(uint64 entry_hash, int64 size);
+
+  int32 GetEntryCount() const;
+  int64 cache_size() const { return cache_size_; }
+
+  // Returns the entries last used between |initial_time| (included) and
+  // |end_time| (not included). A null |end_time| means no limit.
+  void GetEntriesBetween(base::Time initial_time, base::Time end_time,
+                         std::vector<uint64>* entry_hashes) const;
+
+  // Returns the entries that have to go for the cache to fit in
+  // |target_size|, in the order chosen by the eviction policy.
+  void GetEvictionCandidates(int64 target_size,
+                             std::vector<uint64>* entry_hashes) const;
+
+  // Saves the index now, instead of waiting for the timer.
+  void WriteToDisk();
+
+  // Converts a set of entries and the history of the eviction policy to and
+  // from the format of the index file.
+  static void Serialize(const EntrySet& entries,
+                        const std::string& eviction_history,
+                        std::string* data);
+  static bool Deserialize(const std::string& data, EntrySet* entries,
+                          std::string* eviction_history);
+
+  // Reads the saved index for the cache in |path|, or rebuilds it from the
+  // files of the cache if it is not usable; a rebuilt index has no
+  // |eviction_history|. Runs on the cache thread.
+  static void LoadFromDisk(const FilePath& path, EntrySet* entries,
+                           std::string* eviction_history);
+
+  // Rebuilds the index by listing the files of the cache in |path|.
+  static void RestoreFromDisk(const FilePath& path, EntrySet* entries);
+
+  // Returns the file that holds the saved index of the cache in |path|.
+  static FilePath GetIndexFilePath(const FilePath& path);
+
+ private:
+  void OnIndexLoaded(EntrySet* entries, std::string* eviction_history);
+
+  // Schedules a write of the index, unless there is one pending already.
+  void PostponeWrite();
+
+  void InsertInternal(uint64 entry_hash, const EntryMetadata& metadata);
+
+  // Copies the state of every entry from the eviction policy.
+  void CopyEvictionStates();
+
+  // Adds every entry to the eviction policy again, least recently used first,
+  // in its saved state.
+  void RebuildEvictionOrder();
+
+  scoped_refptr<base::MessageLoopProxy> cache_thread_;
+  const FilePath path_;
+
+  EntrySet entries_;
+  int64 cache_size_;
+  bool initialized_;
+  scoped_ptr<EvictionPolicy> eviction_policy_;
+
+  // The entries removed before the index is loaded, so that they are not
+  // brought back by the saved copy.
+  base::flat_hash_set<uint64> removed_entries_;
+  std::vector<base::Closure> to_run_when_initialized_;
+
+  base::OneShotTimer<SimpleIndex> write_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleIndex);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_INDEX_H_
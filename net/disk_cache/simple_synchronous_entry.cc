@@ -0,0 +1,295 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/simple_synchronous_entry.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/rand_util.h"
+#include "base/sha1.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/hash.h"
+
+using base::PlatformFile;
+using base::PlatformFileError;
+using base::PlatformFileInfo;
+
+namespace {
+
+const uint32 kSimpleFileMagic = 0xfcfb6d1a;
+const uint32 kSimpleFileVersion = 1;
+
+// Every file of an entry starts with this header, followed by the key and
+// then by the data of the stream.
+struct SimpleFileHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 key_length;
+  uint32 key_hash;
+};
+COMPILE_ASSERT(sizeof(SimpleFileHeader) == 16, bad_simple_file_header);
+
+const int kFileFlags = base::PLATFORM_FILE_READ | base::PLATFORM_FILE_WRITE |
+                       base::PLATFORM_FILE_SHARE_DELETE;
+
+// Deletes a file of an entry. On Windows, a file that is still open stays in
+// the folder under its name until it is closed, so a doomed entry would keep
+// a new entry with the same key from being created. Renaming it first frees
+// the name.
+bool DeleteEntryFile(const FilePath& name) {
+#if defined(OS_WIN)
+  FilePath to_delete = name.DirName().AppendASCII(
+      base::StringPrintf("todelete_%016" PRIx64, base::RandUint64()));
+  if (file_util::Move(name, to_delete))
+    return file_util::Delete(to_delete, false);
+#endif
+  return file_util::Delete(name, false);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+uint64 GetSimpleEntryHash(const std::string& key) {
+  std::string sha1 = base::SHA1HashString(key);
+  uint64 hash;
+  memcpy(&hash, sha1.data(), sizeof(hash));
+  return hash;
+}
+
+std::string GetSimpleEntryFilename(uint64 entry_hash, int index) {
+  return base::StringPrintf("%016" PRIx64 "_%d", entry_hash, index);
+}
+
+bool ParseSimpleEntryFilename(const std::string& name, uint64* entry_hash,
+                              int* index) {
+  if (name.size() != 18 || name[16] != '_' || name[17] < '0' ||
+      name[17] >= '0' + kSimpleEntryFileCount) {
+    return false;
+  }
+  std::vector<uint8> bytes;
+  if (!base::HexStringToBytes(name.substr(0, 16), &bytes))
+    return false;
+
+  DCHECK_EQ(sizeof(*entry_hash), bytes.size());
+  *entry_hash = 0;
+  for (size_t i = 0; i < bytes.size(); i++)
+    *entry_hash = (*entry_hash << 8) | bytes[i];
+  *index = name[17] - '0';
+  return true;
+}
+
+int64 GetSimpleEntryFileSize(const std::string& key, int64 data_size) {
+  return kSimpleEntryFileCount * (sizeof(SimpleFileHeader) + key.size()) +
+         data_size;
+}
+
+SimpleSynchronousEntry::SimpleSynchronousEntry(const FilePath& path,
+                                               uint64 entry_hash,
+                                               const std::string& key)
+    : path_(path),
+      entry_hash_(entry_hash),
+      key_(key) {
+  for (int i = 0; i < kSimpleEntryFileCount; i++) {
+    files_[i] = base::kInvalidPlatformFileValue;
+    data_size_[i] = 0;
+  }
+}
+
+SimpleSynchronousEntry::~SimpleSynchronousEntry() {
+  CloseFiles();
+}
+
+// Static.
+SimpleSynchronousEntry* SimpleSynchronousEntry::Open(const FilePath& path,
+                                                     uint64 entry_hash,
+                                                     const std::string& key) {
+  scoped_ptr<SimpleSynchronousEntry> entry(
+      new SimpleSynchronousEntry(path, entry_hash, key));
+  bool found = false;
+  if (entry->OpenFiles(&found))
+    return entry.release();
+
+  entry.reset();
+  if (found) {
+    LOG(WARNING) << "Deleting invalid simple cache entry";
+    DeleteFiles(path, entry_hash);
+  }
+  return NULL;
+}
+
+// Static.
+SimpleSynchronousEntry* SimpleSynchronousEntry::Create(const FilePath& path,
+                                                       const std::string& key) {
+  DCHECK(!key.empty());
+  uint64 entry_hash = GetSimpleEntryHash(key);
+  scoped_ptr<SimpleSynchronousEntry> entry(
+      new SimpleSynchronousEntry(path, entry_hash, key));
+  bool exists = false;
+  if (entry->CreateFiles(&exists))
+    return entry.release();
+
+  entry.reset();
+  if (!exists)
+    DeleteFiles(path, entry_hash);
+  return NULL;
+}
+
+// Static.
+bool SimpleSynchronousEntry::DeleteFiles(const FilePath& path,
+                                         uint64 entry_hash) {
+  bool result = true;
+  for (int i = 0; i < kSimpleEntryFileCount; i++) {
+    FilePath name = path.AppendASCII(GetSimpleEntryFilename(entry_hash, i));
+    if (!DeleteEntryFile(name))
+      result = false;
+  }
+  return result;
+}
+
+int SimpleSynchronousEntry::ReadData(int index, int offset, net::IOBuffer* buf,
+                                     int buf_len) {
+  DCHECK_LE(offset + buf_len, data_size_[index]);
+  int rv = base::ReadPlatformFile(files_[index], data_offset() + offset,
+                                  buf->data(), buf_len);
+  return rv < 0 ? net::ERR_CACHE_READ_FAILURE : rv;
+}
+
+int SimpleSynchronousEntry::WriteData(int index, int offset,
+                                      net::IOBuffer* buf, int buf_len,
+                                      bool truncate) {
+  int32 end = offset + buf_len;
+  if (buf_len && base::WritePlatformFile(files_[index], data_offset() + offset,
+                                         buf->data(), buf_len) != buf_len) {
+    return net::ERR_CACHE_WRITE_FAILURE;
+  }
+
+  // An empty write past the end still extends the stream, with zeros.
+  if (truncate || (!buf_len && end > data_size_[index])) {
+    if (!base::TruncatePlatformFile(files_[index], data_offset() + end))
+      return net::ERR_CACHE_WRITE_FAILURE;
+    data_size_[index] = end;
+  } else {
+    data_size_[index] = std::max(data_size_[index], end);
+  }
+  last_modified_ = base::Time::Now();
+  return buf_len;
+}
+
+bool SimpleSynchronousEntry::OpenFiles(bool* found) {
+  for (int i = 0; i < kSimpleEntryFileCount; i++) {
+    FilePath name = path_.AppendASCII(GetSimpleEntryFilename(entry_hash_, i));
+    PlatformFileError error;
+    files_[i] = base::CreatePlatformFile(
+        name, base::PLATFORM_FILE_OPEN | kFileFlags, NULL, &error);
+    if (files_[i] == base::kInvalidPlatformFileValue) {
+      if (error != base::PLATFORM_FILE_ERROR_NOT_FOUND)
+        *found = true;
+      return false;
+    }
+    *found = true;
+    if (!ReadHeader(i))
+      return false;
+  }
+  return true;
+}
+
+bool SimpleSynchronousEntry::CreateFiles(bool* exists) {
+  SimpleFileHeader header;
+  header.magic = kSimpleFileMagic;
+  header.version = kSimpleFileVersion;
+  header.key_length = static_cast<uint32>(key_.size());
+  header.key_hash = Hash(key_);
+
+  for (int i = 0; i < kSimpleEntryFileCount; i++) {
+    // The first file says whether the entry exists; the others may be left
+    // over from an entry that was not completely deleted.
+    int flags = i ? base::PLATFORM_FILE_CREATE_ALWAYS :
+                    base::PLATFORM_FILE_CREATE;
+    FilePath name = path_.AppendASCII(GetSimpleEntryFilename(entry_hash_, i));
+    PlatformFileError error;
+    files_[i] = base::CreatePlatformFile(name, flags | kFileFlags, NULL,
+                                         &error);
+    if (files_[i] == base::kInvalidPlatformFileValue) {
+      if (!i && error == base::PLATFORM_FILE_ERROR_EXISTS)
+        *exists = true;
+      return false;
+    }
+
+    if (base::WritePlatformFile(files_[i], 0,
+                                reinterpret_cast<char*>(&header),
+                                sizeof(header)) != sizeof(header) ||
+        base::WritePlatformFile(files_[i], sizeof(header), key_.data(),
+                                key_.size()) !=
+            static_cast<int>(key_.size())) {
+      return false;
+    }
+  }
+  last_modified_ = base::Time::Now();
+  return true;
+}
+
+bool SimpleSynchronousEntry::ReadHeader(int index) {
+  SimpleFileHeader header;
+  if (base::ReadPlatformFile(files_[index], 0, reinterpret_cast<char*>(&header),
+                             sizeof(header)) != sizeof(header) ||
+      header.magic != kSimpleFileMagic ||
+      header.version != kSimpleFileVersion) {
+    return false;
+  }
+
+  PlatformFileInfo info;
+  if (!base::GetPlatformFileInfo(files_[index], &info) ||
+      info.size < static_cast<int64>(sizeof(header) + header.key_length) ||
+      info.size - sizeof(header) - header.key_length > kint32max) {
+    return false;
+  }
+
+  std::string key;
+  key.resize(header.key_length);
+  if (header.key_length &&
+      base::ReadPlatformFile(files_[index], sizeof(header), &key[0],
+                             header.key_length) !=
+          static_cast<int>(header.key_length)) {
+    return false;
+  }
+  if (Hash(key) != header.key_hash)
+    return false;
+
+  if (key_.empty()) {
+    // Opening by hash: the first file tells the key.
+    if (GetSimpleEntryHash(key) != entry_hash_)
+      return false;
+    key_ = key;
+  } else if (key != key_) {
+    return false;
+  }
+
+  data_size_[index] = static_cast<int32>(info.size - data_offset());
+  if (!index)
+    last_modified_ = info.last_modified;
+  return true;
+}
+
+void SimpleSynchronousEntry::CloseFiles() {
+  for (int i = 0; i < kSimpleEntryFileCount; i++) {
+    if (files_[i] != base::kInvalidPlatformFileValue)
+      base::ClosePlatformFile(files_[i]);
+    files_[i] = base::kInvalidPlatformFileValue;
+  }
+}
+
+int64 SimpleSynchronousEntry::data_offset() const {
+  return sizeof(SimpleFileHeader) + key_.size();
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,109 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_SIMPLE_SYNCHRONOUS_ENTRY_H_
+#define NET_DISK_CACHE_SIMPLE_SYNCHRONOUS_ENTRY_H_
+#pragma once
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/file_path.h"
+#include "base/platform_file.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+
+namespace net {
+class IOBuffer;
+}
+
+namespace disk_cache {
+
+// A simple cache entry keeps each of its streams in a file of its own.
+const int kSimpleEntryFileCount = 3;
+
+// Returns the hash that names the files of the entry for |key|.
+NET_EXPORT_PRIVATE uint64 GetSimpleEntryHash(const std::string& key);
+
+// Returns the name of the file that holds stream |index| of an entry.
+NET_EXPORT_PRIVATE std::string GetSimpleEntryFilename(uint64 entry_hash,
+                                                      int index);
+
+// Reverses GetSimpleEntryFilename(). Returns false for the names of files
+// that don't belong to an entry.
+NET_EXPORT_PRIVATE bool ParseSimpleEntryFilename(const std::string& name,
+                                                 uint64* entry_hash,
+                                                 int* index);
+
+// Returns the size on disk of all the files of an entry for |key| that stores
+// |data_size| bytes, counting every stream.
+NET_EXPORT_PRIVATE int64 GetSimpleEntryFileSize(const std::string& key,
+                                                int64 data_size);
+
+// This class owns the files of a simple cache entry, and does all their IO,
+// synchronously. It is used only from the cache thread; SimpleEntryImpl is
+// its counterpart on the thread that uses the cache.
+class NET_EXPORT_PRIVATE SimpleSynchronousEntry {
+ public:
+  ~SimpleSynchronousEntry();
+
+  // Opens the entry stored in |path| with |entry_hash|. If |key| is not empty
+  // the entry must also belong to it. Returns NULL if there is no such entry;
+  // the files of an entry that can't be read are deleted.
+  static SimpleSynchronousEntry* Open(const FilePath& path, uint64 entry_hash,
+                                      const std::string& key);
+
+  // Creates a new, empty entry for |key|. Returns NULL if the entry already
+  // exists or the files can't be created.
+  static SimpleSynchronousEntry* Create(const FilePath& path,
+                                        const std::string& key);
+
+  // Deletes all the files of an entry. Returns false if some file remains.
+  static bool DeleteFiles(const FilePath& path, uint64 entry_hash);
+
+  // These methods follow the semantics of Entry::ReadData() and WriteData(),
+  // except that the work is done before returning.
+  int ReadData(int index, int offset, net::IOBuffer* buf, int buf_len);
+  int WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
+                bool truncate);
+
+  const std::string& key() const { return key_; }
+  uint64 entry_hash() const { return entry_hash_; }
+  base::Time last_modified() const { return last_modified_; }
+  int32 data_size(int index) const { return data_size_[index]; }
+
+ private:
+  SimpleSynchronousEntry(const FilePath& path, uint64 entry_hash,
+                         const std::string& key);
+
+  // Opens the files of this entry. Returns false if some file is missing or
+  // can't be read, setting |found| if any part of the entry exists.
+  bool OpenFiles(bool* found);
+
+  // Creates the files of this entry. Returns false on failure, setting
+  // |exists| if that is because the entry exists already.
+  bool CreateFiles(bool* exists);
+
+  // Reads the header of file |index|, checking that it belongs to an entry
+  // for |key_|, or to any entry if |key_| is empty.
+  bool ReadHeader(int index);
+
+  void CloseFiles();
+
+  // The offset of the stream data in each file, after the header and key.
+  int64 data_offset() const;
+
+  const FilePath path_;
+  const uint64 entry_hash_;
+  std::string key_;
+  base::PlatformFile files_[kSimpleEntryFileCount];
+  int32 data_size_[kSimpleEntryFileCount];
+  base::Time last_modified_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimpleSynchronousEntry);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SIMPLE_SYNCHRONOUS_ENTRY_H_
@@ -10,6 +10,9 @@
 // The child application has two threads: one to exercise the cache in an
 // infinite loop, and another one to asynchronously kill the process.
 
+// With --shards=n the cache is a ShardedBackend with n shards (and n cache
+// threads), and the child reports how many operations per second it does.
+
 // A regular build should never crash.
 // To test that the disk cache doesn't generate critical errors with regular
 // application level crashes, edit stress_support.h.
@@ -37,6 +40,7 @@
 #include "net/disk_cache/backend_impl.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/sharded_backend.h"
 #include "net/disk_cache/stress_support.h"
 #include "net/disk_cache/trace.h"
 
@@ -45,17 +49,22 @@
 #endif
 
 using base::Time;
+using base::TimeTicks;
 
 const int kError = -1;
 const int kExpectedCrash = 100;
 
+const char kShards[] = "shards";
+
 // Starts a new process.
-int RunSlave(int iteration) {
+int RunSlave(int iteration, int num_shards) {
   FilePath exe;
   PathService::Get(base::FILE_EXE, &exe);
 
   CommandLine cmdline(exe);
   cmdline.AppendArg(base::IntToString(iteration));
+  if (num_shards > 1)
+    cmdline.AppendSwitchASCII(kShards, base::IntToString(num_shards));
 
   base::ProcessHandle handle;
   if (!base::LaunchProcess(cmdline, base::LaunchOptions(), &handle)) {
@@ -72,9 +81,9 @@ int RunSlave(int iteration) {
 }
 
 // Main loop for the master process.
-int MasterCode() {
+int MasterCode(int num_shards) {
   for (int i = 0; i < 100000; i++) {
-    int ret = RunSlave(i);
+    int ret = RunSlave(i, num_shards);
     if (kExpectedCrash != ret)
       return ret;
   }
@@ -98,7 +107,7 @@ std::string GenerateStressKey() {
 // This thread will loop forever, adding and removing entries from the cache.
 // iteration is the current crash cycle, so the entries on the cache are marked
 // to know which instance of the application wrote them.
-void StressTheCache(int iteration) {
+void StressTheCache(int iteration, int num_shards) {
   int cache_size = 0x2000000;  // 32MB.
   uint32 mask = 0xfff;  // 4096 entries.
   FilePath path = GetCacheFilePath().InsertBeforeExtensionASCII("_stress");
@@ -108,14 +117,24 @@ void StressTheCache(int iteration) {
           base::Thread::Options(MessageLoop::TYPE_IO, 0)))
     return;
 
-  disk_cache::BackendImpl* cache =
-      new disk_cache::BackendImpl(path, mask, cache_thread.message_loop_proxy(),
-                                  NULL);
-  cache->SetMaxSize(cache_size);
-  cache->SetFlags(disk_cache::kNoLoadProtection);
-
+  disk_cache::Backend* cache;
   net::TestCompletionCallback cb;
-  int rv = cache->Init(cb.callback());
+  int rv;
+  if (num_shards > 1) {
+    // The shards bring their own threads.
+    rv = disk_cache::ShardedBackend::CreateBackend(
+        path, false, cache_size, net::DISK_CACHE,
+        disk_cache::kNoLoadProtection, num_shards, NULL, &cache,
+        cb.callback());
+  } else {
+    disk_cache::BackendImpl* cache_impl =
+        new disk_cache::BackendImpl(path, mask,
+                                    cache_thread.message_loop_proxy(), NULL);
+    cache_impl->SetMaxSize(cache_size);
+    cache_impl->SetFlags(disk_cache::kNoLoadProtection);
+    cache = cache_impl;
+    rv = cache_impl->Init(cb.callback());
+  }
 
   if (cb.GetResult(rv) != net::OK) {
     printf("Unable to initialize cache.\n");
@@ -146,6 +165,7 @@ void StressTheCache(int iteration) {
   scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
   memset(buffer->data(), 'k', kSize);
 
+  TimeTicks start = TimeTicks::Now();
   for (int i = 0;; i++) {
     int slot = rand() % kNumEntries;
     int key = rand() % kNumKeys;
@@ -175,8 +195,11 @@ void StressTheCache(int iteration) {
       cb2.GetResult(rv);
     }
 
-    if (!(i % 100))
-      printf("Entries: %d    \r", i);
+    if (!(i % 100)) {
+      double seconds = (TimeTicks::Now() - start).InSecondsF();
+      printf("Entries: %d, %d ops/s    \r", i,
+             seconds ? static_cast<int>(i / seconds) : 0);
+    }
   }
 }
 
@@ -255,8 +278,19 @@ int main(int argc, const char* argv[]) {
   // Setup an AtExitManager so Singleton objects will be destructed.
   base::AtExitManager at_exit_manager;
 
-  if (argc < 2)
-    return MasterCode();
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+  int num_shards = 1;
+  if (command_line.HasSwitch(kShards) &&
+      (!base::StringToInt(command_line.GetSwitchValueASCII(kShards),
+                          &num_shards) || num_shards < 1)) {
+    printf("Invalid number of shards\n");
+    return kError;
+  }
+
+  CommandLine::StringVector args = command_line.GetArgs();
+  if (args.empty())
+    return MasterCode(num_shards);
 
   logging::SetLogAssertHandler(CrashHandler);
   logging::SetLogMessageHandler(MessageHandler);
@@ -264,7 +298,6 @@ int main(int argc, const char* argv[]) {
 #if defined(OS_WIN)
   logging::LogEventProvider::Initialize(kStressCacheTraceProviderName);
 #else
-  CommandLine::Init(argc, argv);
   logging::InitLogging(NULL, logging::LOG_ONLY_TO_SYSTEM_DEBUG_LOG,
                        logging::LOCK_LOG_FILE, logging::DELETE_OLD_LOG_FILE,
                        logging::DISABLE_DCHECK_FOR_NON_OFFICIAL_RELEASE_BUILDS);
@@ -274,14 +307,14 @@ int main(int argc, const char* argv[]) {
   base::PlatformThread::Sleep(base::TimeDelta::FromSeconds(3));
   MessageLoop message_loop(MessageLoop::TYPE_IO);
 
-  char* end;
-  long int iteration = strtol(argv[1], &end, 0);
+  int iteration = 0;
+  base::StringToInt(args[0], &iteration);
 
   if (!StartCrashThread()) {
     printf("failed to start thread\n");
     return kError;
   }
 
-  StressTheCache(iteration);
+  StressTheCache(iteration, num_shards);
   return 0;
 }
@@ -9,7 +9,9 @@
 #include <windows.h>
 #endif
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
 #include "net/disk_cache/stress_support.h"
 
 // Change this value to 1 to enable tracing on a release build. By default,
@@ -82,7 +84,13 @@ void TraceObject::EnableTracing(bool enable) {
 
 static TraceBuffer* s_trace_buffer = NULL;
 
+// Protects |s_trace_buffer|, which the cache threads of a sharded backend use
+// at the same time.
+static base::LazyInstance<base::Lock>::Leaky s_trace_lock =
+    LAZY_INSTANCE_INITIALIZER;
+
 void InitTrace(void) {
+  base::AutoLock lock(s_trace_lock.Get());
   s_trace_enabled = true;
   if (s_trace_buffer)
     return;
@@ -92,13 +100,18 @@ void InitTrace(void) {
 }
 
 void DestroyTrace(void) {
+  base::AutoLock lock(s_trace_lock.Get());
   delete s_trace_buffer;
   s_trace_buffer = NULL;
   s_trace_object = NULL;
 }
 
 void Trace(const char* format, ...) {
-  if (!s_trace_buffer || !s_trace_enabled)
+  if (!s_trace_enabled)
+    return;
+
+  base::AutoLock lock(s_trace_lock.Get());
+  if (!s_trace_buffer)
     return;
 
   va_list ap;
@@ -285,6 +285,8 @@
         'disk_cache/errors.h',
         'disk_cache/eviction.cc',
         'disk_cache/eviction.h',
+        'disk_cache/eviction_policy.cc',
+        'disk_cache/eviction_policy.h',
         'disk_cache/experiments.h',
         'disk_cache/file.cc',
         'disk_cache/file.h',
@@ -313,6 +315,16 @@
         'disk_cache/net_log_parameters.h',
         'disk_cache/rankings.cc',
         'disk_cache/rankings.h',
+        'disk_cache/sharded_backend.cc',
+        'disk_cache/sharded_backend.h',
+        'disk_cache/simple_backend_impl.cc',
+        'disk_cache/simple_backend_impl.h',
+        'disk_cache/simple_entry_impl.cc',
+        'disk_cache/simple_entry_impl.h',
+        'disk_cache/simple_index.cc',
+        'disk_cache/simple_index.h',
+        'disk_cache/simple_synchronous_entry.cc',
+        'disk_cache/simple_synchronous_entry.h',
         'disk_cache/sparse_control.cc',
         'disk_cache/sparse_control.h',
         'disk_cache/stats.cc',
@@ -1062,7 +1074,10 @@
         'disk_cache/block_files_unittest.cc',
         'disk_cache/cache_util_unittest.cc',
         'disk_cache/entry_unittest.cc',
+        'disk_cache/eviction_policy_unittest.cc',
         'disk_cache/mapped_file_unittest.cc',
+        'disk_cache/sharded_backend_unittest.cc',
+        'disk_cache/simple_backend_unittest.cc',
         'disk_cache/storage_block_unittest.cc',
         'dns/async_host_resolver_unittest.cc',
         'dns/dns_config_service_posix_unittest.cc',
@@ -1363,6 +1378,17 @@
         'tools/crash_cache/crash_cache.cc',
       ],
     },
+    {
+      'target_name': 'simulate_cache',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/dump_cache/simulate_cache.cc',
+      ],
+    },
     {
       'target_name': 'run_testserver',
       'type': 'executable',
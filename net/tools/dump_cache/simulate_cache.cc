@@ -0,0 +1,218 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program replays a trace of cache requests against the
+// eviction policies of the disk cache, and reports the hit rate of each policy
+// for a few cache sizes. The cache is simulated the way the simple cache works:
+// an entry can't take more than an eighth of the cache, and when the cache is
+// full, entries are evicted until it is 90% full.
+//
+// The trace is a text file with one request per line: the key (usually the
+// URL) and the size of the response in bytes, separated by white space. Empty
+// lines and lines that start with '#' are ignored. A request is a hit when the
+// key is in the cache with the same size.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/flat_hash_tables.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/string_util.h"
+#include "net/disk_cache/eviction_policy.h"
+#include "net/disk_cache/simple_synchronous_entry.h"
+
+using disk_cache::EvictionPolicy;
+
+enum Errors {
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+  FILE_ACCESS_ERROR,
+};
+
+// The trace to replay.
+const char kTrace[] = "trace";
+
+// The cache sizes to simulate, in megabytes, separated by commas.
+const char kCacheSizes[] = "cache-sizes";
+const char kDefaultCacheSizes[] = "20,80,320";
+
+const int kMaxEntryRatio = 8;
+const int kEvictionTargetPercent = 90;
+
+struct Policy {
+  EvictionPolicy::Type type;
+  const char* name;
+};
+
+const Policy kPolicies[] = {
+  { EvictionPolicy::LRU, "LRU" },
+  { EvictionPolicy::SEGMENTED_LRU, "Segmented LRU" },
+};
+
+struct Request {
+  uint64 entry_hash;
+  int64 size;
+};
+
+struct Results {
+  Results() : requests(0), hits(0), bytes(0), hit_bytes(0) {}
+
+  int64 requests;
+  int64 hits;
+  int64 bytes;
+  int64 hit_bytes;
+};
+
+int Help() {
+  printf("simulate_cache --trace=path [--cache-sizes=mb1,mb2,...]\n");
+  printf("Each line of the trace is a request: a key, and a size in bytes.\n");
+  return INVALID_ARGUMENT;
+}
+
+// Reads the requests of the trace in |path|. Returns false if the file can't
+// be read.
+bool ReadTrace(const FilePath& path, std::vector<Request>* requests,
+               int* invalid_lines) {
+  std::string data;
+  if (!file_util::ReadFileToString(path, &data))
+    return false;
+
+  *invalid_lines = 0;
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t end = data.find('\n', start);
+    if (end == std::string::npos)
+      end = data.size();
+    std::string line;
+    TrimWhitespaceASCII(data.substr(start, end - start), TRIM_ALL, &line);
+    start = end + 1;
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    size_t separator = line.find_last_of(" \t");
+    Request request;
+    if (separator == std::string::npos ||
+        !base::StringToInt64(line.substr(separator + 1), &request.size) ||
+        request.size < 0) {
+      (*invalid_lines)++;
+      continue;
+    }
+    std::string key;
+    TrimWhitespaceASCII(line.substr(0, separator), TRIM_TRAILING, &key);
+    request.entry_hash = disk_cache::GetSimpleEntryHash(key);
+    requests->push_back(request);
+  }
+  return true;
+}
+
+// Replays |requests| on a cache of |max_size| bytes that uses |policy|.
+Results Simulate(const std::vector<Request>& requests, int64 max_size,
+                 EvictionPolicy* policy) {
+  policy->SetMaxSize(max_size);
+  base::flat_hash_map<uint64, int64> entries;
+  Results results;
+  std::vector<uint64> candidates;
+  for (size_t i = 0; i < requests.size(); i++) {
+    const Request& request = requests[i];
+    results.requests++;
+    results.bytes += request.size;
+
+    base::flat_hash_map<uint64, int64>::iterator it =
+        entries.find(request.entry_hash);
+    if (it != entries.end()) {
+      policy->OnEntryUsed(request.entry_hash);
+      if (it->second == request.size) {
+        results.hits++;
+        results.hit_bytes += request.size;
+        continue;
+      }
+      // The response changed, so it is fetched and stored again.
+      it->second = request.size;
+      policy->OnEntryResized(request.entry_hash, request.size);
+    } else {
+      if (request.size > max_size / kMaxEntryRatio)
+        continue;
+      entries[request.entry_hash] = request.size;
+      policy->OnEntryAdded(request.entry_hash, 0);
+      policy->OnEntryResized(request.entry_hash, request.size);
+    }
+
+    if (policy->GetSize() <= max_size)
+      continue;
+    candidates.clear();
+    policy->GetEvictionCandidates(max_size * kEvictionTargetPercent / 100,
+                                  &candidates);
+    for (size_t j = 0; j < candidates.size(); j++) {
+      policy->OnEntryRemoved(candidates[j]);
+      entries.erase(candidates[j]);
+    }
+  }
+  return results;
+}
+
+double Percent(int64 part, int64 total) {
+  return total ? 100.0 * part / total : 0.0;
+}
+
+int main(int argc, const char* argv[]) {
+  // Setup an AtExitManager so Singleton objects will be destroyed.
+  base::AtExitManager at_exit_manager;
+
+  CommandLine::Init(argc, argv);
+
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+  FilePath trace = command_line.GetSwitchValuePath(kTrace);
+  if (trace.empty())
+    return Help();
+
+  std::string sizes_switch = command_line.GetSwitchValueASCII(kCacheSizes);
+  if (sizes_switch.empty())
+    sizes_switch = kDefaultCacheSizes;
+  std::vector<std::string> size_strings;
+  base::SplitString(sizes_switch, ',', &size_strings);
+  std::vector<int> cache_sizes;
+  for (size_t i = 0; i < size_strings.size(); i++) {
+    int megabytes;
+    if (!base::StringToInt(size_strings[i], &megabytes) || megabytes <= 0)
+      return Help();
+    cache_sizes.push_back(megabytes);
+  }
+
+  std::vector<Request> requests;
+  int invalid_lines;
+  if (!ReadTrace(trace, &requests, &invalid_lines)) {
+    printf("Unable to read the trace\n");
+    return FILE_ACCESS_ERROR;
+  }
+  if (invalid_lines)
+    printf("Skipped %d invalid lines\n", invalid_lines);
+
+  base::flat_hash_set<uint64> keys;
+  for (size_t i = 0; i < requests.size(); i++)
+    keys.insert(requests[i].entry_hash);
+  printf("%d requests, %d keys\n\n", static_cast<int>(requests.size()),
+         static_cast<int>(keys.size()));
+
+  printf("%10s  %-15s %10s %15s\n", "Cache size", "Policy", "Hit rate",
+         "Byte hit rate");
+  for (size_t i = 0; i < cache_sizes.size(); i++) {
+    int64 max_size = static_cast<int64>(cache_sizes[i]) * 1024 * 1024;
+    for (size_t j = 0; j < arraysize(kPolicies); j++) {
+      scoped_ptr<EvictionPolicy> policy(
+          EvictionPolicy::Create(kPolicies[j].type));
+      Results results = Simulate(requests, max_size, policy.get());
+      printf("%7d MB  %-15s %9.2f%% %14.2f%%\n", cache_sizes[i],
+             kPolicies[j].name, Percent(results.hits, results.requests),
+             Percent(results.hit_bytes, results.bytes));
+    }
+  }
+  return ALL_GOOD;
+}
@@ -7,6 +7,8 @@
 #include <string.h>
 
 #include "base/file_path.h"
+#include "base/file_read_recorder.h"
+#include "base/file_util.h"
 #include "base/logging.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
@@ -97,10 +99,21 @@ Connection::~Connection() {
 
 bool Connection::Open(const FilePath& path) {
 #if defined(OS_WIN)
-  return OpenInternal(WideToUTF8(path.value()));
+  if (!OpenInternal(WideToUTF8(path.value())))
+    return false;
 #elif defined(OS_POSIX)
-  return OpenInternal(path.value());
+  if (!OpenInternal(path.value()))
+    return false;
 #endif
+
+  // SQLite reads pages as statements need them, which can't be traced from
+  // here, so report the whole database as read.
+  int64 size;
+  if (base::FileReadRecorder::IsRecording() &&
+      file_util::GetFileSize(path, &size)) {
+    base::FileReadRecorder::RecordRead(path, 0, size);
+  }
+  return true;
 }
 
 bool Connection::OpenInMemory() {
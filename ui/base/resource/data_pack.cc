@@ -6,10 +6,12 @@
 
 #include <errno.h>
 
+#include "base/file_read_recorder.h"
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/metrics/histogram.h"
+#include "base/platform_file.h"
 #include "base/string_piece.h"
 
 // For details of the file layout, see
@@ -68,8 +70,14 @@ DataPack::~DataPack() {
 }
 
 bool DataPack::Load(const FilePath& path) {
+  path_ = path;
   mmap_.reset(new file_util::MemoryMappedFile);
-  if (!mmap_->Initialize(path)) {
+  // Mapping a path reports the whole file to base::FileReadRecorder, but
+  // startup only uses some of the resources.  Map through a handle instead,
+  // and report the parts that are used as they are.
+  base::PlatformFile file = base::CreatePlatformFile(
+      path, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ, NULL, NULL);
+  if (file == base::kInvalidPlatformFileValue || !mmap_->Initialize(file)) {
     DLOG(ERROR) << "Failed to mmap datapack";
     UMA_HISTOGRAM_ENUMERATION("DataPack.Load", INIT_FAILED,
                               LOAD_ERRORS_COUNT);
@@ -139,6 +147,16 @@ bool DataPack::Load(const FilePath& path) {
     }
   }
 
+  // Every lookup searches the index, so have the kernel read all of it in
+  // the background.  The resources are scattered over the file and startup
+  // only uses some of them, so they are left to the prefetching of
+  // chrome/browser/startup_prefetch.h, which reads the ones that the last
+  // startup used.
+  size_t index_length =
+      kHeaderLength + (resource_count_ + 1) * sizeof(DataPackEntry);
+  mmap_->Prefetch(0, index_length);
+  base::FileReadRecorder::RecordRead(path_, 0, index_length);
+
   return true;
 }
 
@@ -165,6 +183,12 @@ bool DataPack::GetStringPiece(uint16 resource_id,
   const DataPackEntry* next_entry = target + 1;
   size_t length = next_entry->file_offset - target->file_offset;
 
+  if (base::FileReadRecorder::IsRecording()) {
+    const DataPackEntry* first_entry =
+        reinterpret_cast<const DataPackEntry*>(mmap_->data() + kHeaderLength);
+    RecordResourceRead(target - first_entry, target->file_offset, length);
+  }
+
   data->set(mmap_->data() + target->file_offset, length);
   return true;
 }
@@ -178,6 +202,21 @@ RefCountedStaticMemory* DataPack::GetStaticMemory(uint16 resource_id) const {
       reinterpret_cast<const unsigned char*>(piece.data()), piece.length());
 }
 
+void DataPack::RecordResourceRead(size_t index,
+                                  size_t offset,
+                                  size_t length) const {
+  // Strings are looked up over and over; report each resource once.
+  {
+    base::AutoLock lock(recorded_lock_);
+    if (recorded_.empty())
+      recorded_.resize(resource_count_);
+    if (recorded_[index])
+      return;
+    recorded_[index] = true;
+  }
+  base::FileReadRecorder::RecordRead(path_, offset, length);
+}
+
 // static
 bool DataPack::WritePack(const FilePath& path,
                          const std::map<uint16, base::StringPiece>& resources,
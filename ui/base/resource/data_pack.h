@@ -11,13 +11,15 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 #include "base/basictypes.h"
+#include "base/file_path.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/string_piece.h"
+#include "base/synchronization/lock.h"
 #include "ui/base/ui_export.h"
 
-class FilePath;
 class RefCountedStaticMemory;
 
 namespace file_util {
@@ -63,9 +65,21 @@ class UI_EXPORT DataPack {
   TextEncodingType GetTextEncodingType() const { return text_encoding_type_; }
 
  private:
+  // Reports the first use of the resource at |index| in the index to
+  // base::FileReadRecorder, so that the next startup prefetches it.
+  void RecordResourceRead(size_t index, size_t offset, size_t length) const;
+
   // The memory-mapped data.
   scoped_ptr<file_util::MemoryMappedFile> mmap_;
 
+  // The path of the file, for base::FileReadRecorder.
+  FilePath path_;
+
+  // The resources already reported to base::FileReadRecorder, by index.
+  // Only filled in while it records.
+  mutable base::Lock recorded_lock_;
+  mutable std::vector<bool> recorded_;
+
   // Number of resources in the data.
   size_t resource_count_;
 
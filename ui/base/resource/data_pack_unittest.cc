@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "base/file_path.h"
+#include "base/file_read_recorder.h"
 #include "base/file_util.h"
 #include "base/path_service.h"
 #include "base/scoped_temp_dir.h"
@@ -104,4 +105,42 @@ TEST_P(DataPackTest, Write) {
   EXPECT_EQ(fifteen, data);
 }
 
+// Loading reports the index to FileReadRecorder, and lookups report each
+// resource they return once, not the whole file.
+TEST(DataPackTest, RecordsUsedResources) {
+  ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  FilePath file = dir.path().Append(FILE_PATH_LITERAL("data.pak"));
+
+  std::string one("one");
+  std::string two("two");
+  std::string three("three");
+  std::map<uint16, base::StringPiece> resources;
+  resources.insert(std::make_pair(1, base::StringPiece(one)));
+  resources.insert(std::make_pair(2, base::StringPiece(two)));
+  resources.insert(std::make_pair(3, base::StringPiece(three)));
+  ASSERT_TRUE(DataPack::WritePack(file, resources, DataPack::BINARY));
+
+  base::FileReadRecorder::Start();
+  DataPack pack;
+  ASSERT_TRUE(pack.Load(file));
+  base::StringPiece data;
+  ASSERT_TRUE(pack.GetStringPiece(3, &data));
+  ASSERT_TRUE(pack.GetStringPiece(3, &data));
+  ASSERT_TRUE(pack.GetStringPiece(1, &data));
+  base::FileReadRecorder::Extents extents;
+  base::FileReadRecorder::Stop(&extents);
+
+  // A header of 9 bytes, then 4 index entries of 6 bytes.
+  const int64 kIndexLength = 9 + 4 * 6;
+  ASSERT_EQ(3u, extents.size());
+  EXPECT_EQ(file.value(), extents[0].path.value());
+  EXPECT_EQ(0, extents[0].offset);
+  EXPECT_EQ(kIndexLength, extents[0].length);
+  EXPECT_EQ(kIndexLength + 6, extents[1].offset);
+  EXPECT_EQ(5, extents[1].length);
+  EXPECT_EQ(kIndexLength, extents[2].offset);
+  EXPECT_EQ(3, extents[2].length);
+}
+
 }  // namespace ui